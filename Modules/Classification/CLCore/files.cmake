@@ -4,6 +4,7 @@ set(CPP_FILES
   mitkConfigurationHolder.cpp
   mitkAbstractClassifier.cpp
   mitkAbstractGlobalImageFeature.cpp
+  mitkGlobalImageFeatureCache.cpp
 )
 
 set( TOOL_FILES
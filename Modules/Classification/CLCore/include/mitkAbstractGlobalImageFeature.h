@@ -30,6 +30,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 // MITK includes
 #include <mitkConfigurationHolder.h>
+#include <mitkGlobalImageFeatureCache.h>
 
 namespace mitk
 {
@@ -50,6 +51,14 @@ public:
   */
   virtual FeatureNameListType GetFeatureNames() = 0;
 
+  /**
+  * \brief Sets preprocessing that is shared with other feature classes of the same image and mask.
+  * The cache has to belong to the image and mask passed to CalculateFeatures and has to outlive the calculation.
+  * Without a cache, every call of CalculateFeatures does its own preprocessing.
+  */
+  void SetCache(GlobalImageFeatureCache * cache) { m_Cache = cache; }
+  GlobalImageFeatureCache * GetCache() const { return m_Cache; }
+
 public:
 
 //#ifndef DOXYGEN_SKIP
@@ -72,6 +81,8 @@ public:
 
 //#endif // Skip Doxygen
 
+private:
+  GlobalImageFeatureCache * m_Cache = nullptr;
 };
 }
 
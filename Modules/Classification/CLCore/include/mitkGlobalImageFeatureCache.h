@@ -0,0 +1,166 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#ifndef mitkGlobalImageFeatureCache_h
+#define mitkGlobalImageFeatureCache_h
+
+#include <MitkCLCoreExports.h>
+
+#include <mitkImage.h>
+#include <mitkImageCast.h>
+
+// ITK
+#include <itkMinimumMaximumImageCalculator.h>
+#include <itkTimeProbe.h>
+
+// STD Includes
+#include <map>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+
+namespace mitk
+{
+/**
+* \brief Preprocessing of one image/mask pair that is shared by all global image feature classes of a case.
+*
+* The feature classes cast the mask to different itk image types and need the intensity range of the
+* whole image. With a cache, each of these steps is done once per case instead of once per feature class.
+* The cache can be used by several feature classes that are calculated in parallel. The time spent in each
+* preprocessing step is recorded and can be queried with GetStageTimes().
+*/
+class MITKCLCORE_EXPORT GlobalImageFeatureCache
+{
+public:
+
+  typedef std::map<std::string, double> StageTimesType;
+
+  GlobalImageFeatureCache(const Image::Pointer & image, const Image::Pointer & mask);
+
+  GlobalImageFeatureCache(const GlobalImageFeatureCache&) = delete;
+  GlobalImageFeatureCache& operator=(const GlobalImageFeatureCache&) = delete;
+
+  const Image::Pointer & GetImage() const { return m_Image; }
+  const Image::Pointer & GetMask() const { return m_Mask; }
+
+  /**
+  * \brief Returns the mask cast to TMaskImage. The cast is done by the first call for each mask type.
+  *
+  * Every call returns a new image object that shares the pixel buffer of the cached mask, so it can be
+  * used as (read only) input of filters that run in parallel.
+  */
+  template<typename TMaskImage>
+  typename TMaskImage::Pointer GetMaskAs()
+  {
+    const std::string key = typeid(TMaskImage).name();
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto entry = m_CastMasks.find(key);
+    if (entry == m_CastMasks.end())
+    {
+      itk::TimeProbe clock;
+      clock.Start();
+      typename TMaskImage::Pointer maskImage = TMaskImage::New();
+      CastToItkImage(m_Mask, maskImage);
+      clock.Stop();
+
+      entry = m_CastMasks.insert(std::make_pair(key, itk::DataObject::Pointer(maskImage.GetPointer()))).first;
+      m_StageTimes["Mask casting"] += clock.GetTotal();
+    }
+
+    typename TMaskImage::Pointer maskImage = TMaskImage::New();
+    maskImage->Graft(static_cast<TMaskImage*>(entry->second.GetPointer()));
+    return maskImage;
+  }
+
+  /**
+  * \brief Minimum and maximum of the cached image, which has to be passed as itk image. Computed by the first call.
+  */
+  template<typename TImage>
+  void GetMinimumMaximum(const TImage * image, typename TImage::PixelType & minimum, typename TImage::PixelType & maximum)
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!m_HasMinimumMaximum)
+    {
+      itk::TimeProbe clock;
+      clock.Start();
+      typename itk::MinimumMaximumImageCalculator<TImage>::Pointer minMaxComputer = itk::MinimumMaximumImageCalculator<TImage>::New();
+      minMaxComputer->SetImage(image);
+      minMaxComputer->Compute();
+      clock.Stop();
+
+      m_Minimum = minMaxComputer->GetMinimum();
+      m_Maximum = minMaxComputer->GetMaximum();
+      m_HasMinimumMaximum = true;
+      m_StageTimes["Minimum/Maximum"] += clock.GetTotal();
+    }
+    minimum = static_cast<typename TImage::PixelType>(m_Minimum);
+    maximum = static_cast<typename TImage::PixelType>(m_Maximum);
+  }
+
+  /**
+  * \brief Casts the mask to TMaskImage, using the cache if one is given.
+  */
+  template<typename TMaskImage>
+  static typename TMaskImage::Pointer CastMask(GlobalImageFeatureCache * cache, const Image::Pointer & mask)
+  {
+    if (cache != nullptr)
+      return cache->GetMaskAs<TMaskImage>();
+
+    typename TMaskImage::Pointer maskImage = TMaskImage::New();
+    CastToItkImage(mask, maskImage);
+    return maskImage;
+  }
+
+  /**
+  * \brief Computes the minimum and maximum of the image, using the cache if one is given.
+  */
+  template<typename TImage>
+  static void ComputeMinimumMaximum(GlobalImageFeatureCache * cache, const TImage * image, typename TImage::PixelType & minimum, typename TImage::PixelType & maximum)
+  {
+    if (cache != nullptr)
+    {
+      cache->GetMinimumMaximum(image, minimum, maximum);
+      return;
+    }
+
+    typename itk::MinimumMaximumImageCalculator<TImage>::Pointer minMaxComputer = itk::MinimumMaximumImageCalculator<TImage>::New();
+    minMaxComputer->SetImage(image);
+    minMaxComputer->Compute();
+    minimum = minMaxComputer->GetMinimum();
+    maximum = minMaxComputer->GetMaximum();
+  }
+
+  /**
+  * \brief Seconds spent in each preprocessing step, summed over all feature classes.
+  */
+  StageTimesType GetStageTimes() const;
+
+private:
+
+  Image::Pointer m_Image;
+  Image::Pointer m_Mask;
+
+  mutable std::mutex m_Mutex;
+  std::map<std::string, itk::DataObject::Pointer> m_CastMasks;
+  bool m_HasMinimumMaximum;
+  double m_Minimum;
+  double m_Maximum;
+  StageTimesType m_StageTimes;
+};
+}
+
+#endif //mitkGlobalImageFeatureCache_h
@@ -0,0 +1,28 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkGlobalImageFeatureCache.h>
+
+mitk::GlobalImageFeatureCache::GlobalImageFeatureCache(const Image::Pointer & image, const Image::Pointer & mask) :
+  m_Image(image), m_Mask(mask), m_HasMinimumMaximum(false), m_Minimum(0), m_Maximum(0)
+{
+}
+
+mitk::GlobalImageFeatureCache::StageTimesType mitk::GlobalImageFeatureCache::GetStageTimes() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_StageTimes;
+}
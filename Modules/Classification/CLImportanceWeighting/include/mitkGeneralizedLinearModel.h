@@ -22,6 +22,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vnl/vnl_matrix.h>
 #include <vnl/vnl_vector.h>
 
+#include <vector>
+
 namespace mitk
 {
   /**
@@ -30,6 +32,13 @@ namespace mitk
   * Generalized linear models are an extension of standard linear models that allow
   * a different apperance of the data. This is for example usefull to calculate
   * Logistic regressions.
+  *
+  * The model is fitted with iteratively reweighted least squares. Each iteration streams over
+  * the rows of the data in blocks and accumulates the weighted normal equations in parallel, so
+  * only matrices of the size of the number of columns are allocated besides the input data.
+  * Solving the normal equations squares the condition number of the weighted data matrix, so
+  * nearly collinear columns lose about twice as many digits as a QR decomposition of sqrt(W)X.
+  * Exactly dependent columns are removed by the rank estimation before the fit.
   */
   class MITKCLIMPORTANCEWEIGHTING_EXPORT GeneralizedLinearModel
   {
@@ -46,6 +55,16 @@ namespace mitk
     */
     GeneralizedLinearModel (const vnl_matrix<double> &xData, const vnl_vector<double> &yData, bool addConstantColumn=true);
 
+    /**
+    * \brief Initialization of the GLM, starting the fit from a known b-vector.
+    *
+    * Like the constructor above, but the iterations start from the given b-vector instead of
+    * a guess from the output data. Starting from the b-vector of a fit on similar data, for
+    * example another image of the same collection, usually needs less iterations. If the size
+    * of initialB does not match the data (xData.cols()+1, like the result of B()), it is ignored.
+    */
+    GeneralizedLinearModel (const vnl_matrix<double> &xData, const vnl_vector<double> &yData, const vnl_vector<double> &initialB, bool addConstantColumn=true);
+
     /**
     * \brief Predicts the value corresponding to the given vector.
     *
@@ -87,8 +106,16 @@ namespace mitk
     */
     vnl_vector<double> B();
 
+    /**
+    * \brief Returns the time in seconds needed by each iteration of the fit
+    */
+    std::vector<double> GetIterationTimes();
+
   private:
 
+    // Fits the model with iteratively reweighted least squares. Starts from initialB if it is not empty.
+    void Fit(const vnl_matrix<double> &xData, const vnl_vector<double> &yData, const vnl_vector<double> &initialB);
+
     // Estimates the rank of the matrix and creates a permutation vector so
     // that the most important columns are first. Depends on a QR-algorithm.
     void EstimatePermutation(const vnl_matrix<double> &xData);
@@ -97,6 +124,7 @@ namespace mitk
     vnl_vector<unsigned int>    m_Permutation;        // Holds a permutation matrix which is used during calculation of B
     vnl_vector<double>          m_B;                  // B-Values. Linear componentn of the model.
     bool                        m_AddConstantColumn;  // If true, a constant value is added to each row
+    std::vector<double>         m_IterationTimes;     // Time in seconds needed by each iteration of the fit
 //    int                         m_Rank;               // The estimated input rank of the matrix.
   };
 }
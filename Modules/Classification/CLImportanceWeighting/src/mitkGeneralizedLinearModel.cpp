@@ -22,12 +22,16 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <v3p_netlib.h>
 #include <vnl/algo/vnl_qr.h>
 #include <mitkLogMacros.h>
+#include <itkTimeProbe.h>
 #include <algorithm>
 #include <limits>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 static void _UpdateXMatrix(const vnl_matrix<double> &xData, bool addConstant, v3p_netlib_doublereal *x);
-static void _UpdatePermXMatrix(const vnl_matrix<double> &xData, bool addConstant, const vnl_vector<unsigned int> &permutation, vnl_matrix<double> &x);
-static void _InitMuEta(mitk::DistSimpleBinominal *dist, mitk::LogItLinking *link, const vnl_vector<double> &yData, vnl_vector<double> &mu, vnl_vector<double> &eta);
+static void _UpdatePermRow(const vnl_matrix<double> &xData, int r, bool addConstant, const vnl_vector<unsigned int> &permutation, vnl_vector<double> &row);
 static void _FinalizeBVector(vnl_vector<double> &b, vnl_vector<unsigned int> &perm, int cols);
 
 
@@ -52,8 +56,10 @@ vnl_vector<double> mitk::GeneralizedLinearModel::Predict(const vnl_matrix<double
 {
   LogItLinking link;
   vnl_vector<double> mu(x.rows());
+  int rows = x.rows();
   int cols = m_B.size();
-  for (unsigned int r = 0 ; r < mu.size(); ++r)
+#pragma omp parallel for
+  for (int r = 0 ; r < rows; ++r)
   {
     mu(r) = 0;
     for (int c = 0; c < cols; ++c)
@@ -79,8 +85,10 @@ vnl_vector<double> mitk::GeneralizedLinearModel::ExpMu(const vnl_matrix<double>
 {
   LogItLinking link;
   vnl_vector<double> mu(x.rows());
+  int rows = x.rows();
   int cols = m_B.size();
-  for (unsigned int r = 0 ; r < mu.size(); ++r)
+#pragma omp parallel for
+  for (int r = 0 ; r < rows; ++r)
   {
     mu(r) = 0;
     for (int c = 0; c < cols; ++c)
@@ -97,59 +105,151 @@ vnl_vector<double> mitk::GeneralizedLinearModel::ExpMu(const vnl_matrix<double>
   return mu;
 }
 
+std::vector<double> mitk::GeneralizedLinearModel::GetIterationTimes()
+{
+  return m_IterationTimes;
+}
+
 mitk::GeneralizedLinearModel::GeneralizedLinearModel(const vnl_matrix<double> &xData, const vnl_vector<double> &yData, bool addConstantColumn) :
   m_AddConstantColumn(addConstantColumn)
+{
+  Fit(xData, yData, vnl_vector<double>());
+}
+
+mitk::GeneralizedLinearModel::GeneralizedLinearModel(const vnl_matrix<double> &xData, const vnl_vector<double> &yData, const vnl_vector<double> &initialB, bool addConstantColumn) :
+  m_AddConstantColumn(addConstantColumn)
+{
+  if (initialB.size() == xData.cols() + 1)
+    Fit(xData, yData, initialB);
+  else
+    Fit(xData, yData, vnl_vector<double>());
+}
+
+void mitk::GeneralizedLinearModel::Fit(const vnl_matrix<double> &xData, const vnl_vector<double> &yData, const vnl_vector<double> &initialB)
 {
   EstimatePermutation(xData);
 
-  DistSimpleBinominal dist;
-  LogItLinking link;
-  vnl_matrix<double> x;
   int rows = xData.rows();
   int cols = m_Permutation.size();
-  vnl_vector<double> mu(rows);
-  vnl_vector<double> eta(rows);
-  vnl_vector<double> weightedY(rows);
-  vnl_matrix<double> weightedX(rows, cols);
   vnl_vector<double> oldB(cols);
 
-  _UpdatePermXMatrix(xData, m_AddConstantColumn, m_Permutation, x);
-  _InitMuEta(&dist, &link, yData, mu, eta);
-
   int iter = 0;
   int iterLimit = 100;
   double sqrtEps = sqrt(std::numeric_limits<double>::epsilon());
   double convertCriterion =1e-6;
 
+  // Without a start vector, mu and eta of the first iteration are guessed from y.
+  bool guessMuFromY = initialB.empty();
   m_B.set_size(m_Permutation.size());
   m_B.fill(0);
+  if (!guessMuFromY)
+  {
+    for (int c = 0; c < cols; ++c)
+    {
+      m_B(c) = initialB(m_Permutation(c));
+    }
+  }
+  m_IterationTimes.clear();
+
+  // The rows are processed in blocks, each thread sums the normal equations of its blocks.
+  // The partial sums are added in the order of the threads, so the result does not depend on the timing.
+  const int blockSize = 4096;
+  int blocks = (rows + blockSize - 1) / blockSize;
+  int numberOfThreads = 1;
+#ifdef _OPENMP
+  numberOfThreads = std::max(1, std::min(omp_get_max_threads(), blocks));
+#endif
+  std::vector<vnl_matrix<double> > partialXWX(numberOfThreads);
+  std::vector<vnl_vector<double> > partialXWZ(numberOfThreads);
 
   while (iter <= iterLimit)
   {
     ++iter;
+    itk::TimeProbe clock;
+    clock.Start();
 
     oldB = m_B;
-    // Do Row-wise operation. No Vector oepration at this point.
-    for (int r = 0; r<rows; ++r)
+    for (int thread = 0; thread < numberOfThreads; ++thread)
     {
-      double deta = link.DLink(mu(r));
-      double zBuffer = eta(r) + (yData(r) - mu(r))*deta;
-      double sqrtWeight = 1 / (std::abs(deta) * dist.SqrtVariance(mu(r)));
-
-      weightedY(r) = zBuffer * sqrtWeight;
-      for (int c=0; c<cols; ++c)
+      partialXWX[thread].set_size(cols, cols);
+      partialXWX[thread].fill(0);
+      partialXWZ[thread].set_size(cols);
+      partialXWZ[thread].fill(0);
+    }
+#pragma omp parallel num_threads(numberOfThreads)
+    {
+      int thread = 0;
+#ifdef _OPENMP
+      thread = omp_get_thread_num();
+#endif
+      DistSimpleBinominal dist;
+      LogItLinking link;
+      vnl_matrix<double> &xwx = partialXWX[thread];
+      vnl_vector<double> &xwz = partialXWZ[thread];
+      vnl_vector<double> row(cols);
+
+#pragma omp for schedule(static)
+      for (int block = 0; block < blocks; ++block)
       {
-        weightedX(r,c) = x(r,c) * sqrtWeight;
+        int blockEnd = std::min(rows, (block + 1) * blockSize);
+        for (int r = block * blockSize; r < blockEnd; ++r)
+        {
+          _UpdatePermRow(xData, r, m_AddConstantColumn, m_Permutation, row);
+          double mu, eta;
+          if (guessMuFromY)
+          {
+            mu = dist.Init(yData(r));
+            eta = link.Link(mu);
+          }
+          else
+          {
+            eta = dot_product(row, m_B);
+            mu = link.InverseLink(eta);
+          }
+
+          double deta = link.DLink(mu);
+          double zBuffer = eta + (yData(r) - mu)*deta;
+          double sqrtWeight = 1 / (std::abs(deta) * dist.SqrtVariance(mu));
+          double weight = sqrtWeight * sqrtWeight;
+
+          // Upper triangle of X^T W X and X^T W z
+          for (int c = 0; c < cols; ++c)
+          {
+            double weightedX = weight * row(c);
+            double *xwxRow = xwx[c];
+            for (int c2 = c; c2 < cols; ++c2)
+            {
+              xwxRow[c2] += weightedX * row(c2);
+            }
+            xwz(c) += weightedX * zBuffer;
+          }
+        }
       }
     }
-    vnl_qr<double> qr(weightedX);
-    m_B = qr.solve(weightedY);
-    eta = x * m_B;
-    for (int r = 0; r < rows; ++r)
+
+    vnl_matrix<double> xwx = partialXWX[0];
+    vnl_vector<double> xwz = partialXWZ[0];
+    for (int thread = 1; thread < numberOfThreads; ++thread)
+    {
+      xwx += partialXWX[thread];
+      xwz += partialXWZ[thread];
+    }
+    for (int c = 0; c < cols; ++c)
     {
-      mu(r) = link.InverseLink(eta(r));
+      for (int c2 = 0; c2 < c; ++c2)
+      {
+        xwx(c, c2) = xwx(c2, c);
+      }
     }
 
+    vnl_qr<double> qr(xwx);
+    m_B = qr.solve(xwz);
+    guessMuFromY = false;
+
+    clock.Stop();
+    m_IterationTimes.push_back(clock.GetTotal());
+    MITK_DEBUG << "GLM iteration " << iter << ": " << clock.GetTotal() << "s";
+
     bool stayInLoop = false;
     for(int c= 0; c < cols; ++c)
     {
@@ -229,46 +329,27 @@ static void _UpdateXMatrix(const vnl_matrix<double> &xData, bool addConstant, v3
   }
 }
 
-// Fills the value of the xData-matrix into the x-matrix. Adds a constant
-// column if required. Permutes the rows corresponding to the permutation vector.
-static void _UpdatePermXMatrix(const vnl_matrix<double> &xData, bool addConstant, const vnl_vector<unsigned int> &permutation, vnl_matrix<double> &x)
+// Fills row r of the xData-matrix into the row-vector. Adds a constant
+// column if required. Permutes the columns corresponding to the permutation vector.
+static void _UpdatePermRow(const vnl_matrix<double> &xData, int r, bool addConstant, const vnl_vector<unsigned int> &permutation, vnl_vector<double> &row)
 {
-  int rows = xData.rows();
   int cols = permutation.size();
-  x.set_size(rows, cols);
-  for (int r=0; r < rows; ++r)
+  for (int c=0; c<cols; ++c)
   {
-    for (int c=0; c<cols; ++c)
+    unsigned int newCol = permutation(c);
+    if (!addConstant)
     {
-      unsigned int newCol = permutation(c);
-      if (!addConstant)
-      {
-        x(r, c) = xData(r,newCol);
-      } else if (newCol == 0)
-      {
-        x(r, c) = 1.0;
-      } else
-      {
-        x(r, c) = xData(r, newCol-1);
-      }
+      row(c) = xData(r,newCol);
+    } else if (newCol == 0)
+    {
+      row(c) = 1.0;
+    } else
+    {
+      row(c) = xData(r, newCol-1);
     }
   }
 }
 
-// Initialize mu and eta by calling the corresponding
-// link and distribution functions on each row
-static void _InitMuEta(mitk::DistSimpleBinominal *dist, mitk::LogItLinking *link, const vnl_vector<double> &yData, vnl_vector<double> &mu, vnl_vector<double> &eta)
-{
-  int rows = yData.size();
-  mu.set_size(rows);
-  eta.set_size(rows);
-  for (int r = 0; r < rows; ++r)
-  {
-    mu(r) = dist->Init(yData(r));
-    eta(r) = link->Link(mu(r));
-  }
-}
-
 // Inverts the permutation on a given b-vector.
 // Necessary to get a b-vector that match the original data
 static void _FinalizeBVector(vnl_vector<double> &b, vnl_vector<unsigned int> &perm, int cols)
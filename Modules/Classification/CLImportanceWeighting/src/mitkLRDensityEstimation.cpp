@@ -97,6 +97,9 @@ void
     featureList.push_back(iter);
   }
 
+  // The fit of the previous image is the starting point for the next one
+  vnl_vector<double> previousB;
+
   // Do for each image...
   //  char buchstabe = 'A';
   while (!train.IsAtEnd())
@@ -166,8 +169,17 @@ void
       }
     }
 
-    mitk::GeneralizedLinearModel glm(feature, label);
+    mitk::GeneralizedLinearModel glm(feature, label, previousB);
     vnl_vector<double> weightVector = glm.ExpMu(trainFeature);
+    previousB = glm.B();
+
+    std::vector<double> iterationTimes = glm.GetIterationTimes();
+    double fitTime = 0;
+    for (unsigned int i = 0; i < iterationTimes.size(); ++i)
+    {
+      fitTime += iterationTimes[i];
+    }
+    MITK_INFO << "Logistic regression of " << feature.rows() << " samples: " << iterationTimes.size() << " iterations, " << fitTime << "s";
 
     itk::ImageRegionIterator<FeatureImageType> weightIter(weight.GetImage(), weight.GetImage()->GetLargestPossibleRegion() );
 
@@ -0,0 +1,164 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+
+#include <mitkGeneralizedLinearModel.h>
+#include <vnl/algo/vnl_qr.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+class mitkGeneralizedLinearModelTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkGeneralizedLinearModelTestSuite);
+  MITK_TEST(Fit_WellConditionedDesign_EqualsReference);
+  MITK_TEST(Fit_DuplicatedColumn_EqualsFullRankFit);
+  MITK_TEST(Fit_WarmStart_ConvergesToSameB);
+  MITK_TEST(Fit_OneThread_EqualsAllThreads);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  vnl_matrix<double> m_X;
+  vnl_vector<double> m_Y;
+
+  /** Logistic regression with iteratively reweighted least squares, each step solves the QR decomposition of sqrt(W)X. */
+  static vnl_vector<double> ReferenceFit(const vnl_matrix<double> &x, const vnl_vector<double> &y)
+  {
+    const unsigned int rows = x.rows();
+    const unsigned int cols = x.cols() + 1;
+    vnl_vector<double> b(cols, 0.0);
+    for (int iter = 0; iter < 100; ++iter)
+    {
+      vnl_matrix<double> weightedX(rows, cols);
+      vnl_vector<double> weightedZ(rows);
+      for (unsigned int r = 0; r < rows; ++r)
+      {
+        double eta = b(0);
+        for (unsigned int c = 1; c < cols; ++c)
+          eta += x(r, c - 1) * b(c);
+        const double mu = 1 / (1 + std::exp(-eta));
+        const double weight = mu * (1 - mu);
+        const double sqrtWeight = std::sqrt(weight);
+        weightedX(r, 0) = sqrtWeight;
+        for (unsigned int c = 1; c < cols; ++c)
+          weightedX(r, c) = sqrtWeight * x(r, c - 1);
+        weightedZ(r) = sqrtWeight * (eta + (y(r) - mu) / weight);
+      }
+      vnl_vector<double> newB = vnl_qr<double>(weightedX).solve(weightedZ);
+      const double change = (newB - b).inf_norm();
+      b = newB;
+      if (change < 1e-13 * std::max(1.0, b.inf_norm()))
+        break;
+    }
+    return b;
+  }
+
+  static void CheckEqual(const std::string &message, const vnl_vector<double> &expected, const vnl_vector<double> &actual, double tolerance)
+  {
+    CPPUNIT_ASSERT_EQUAL_MESSAGE(message + ": size", expected.size(), actual.size());
+    for (unsigned int i = 0; i < expected.size(); ++i)
+    {
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE(message, expected(i), actual(i), tolerance * std::max(1.0, std::abs(expected(i))));
+    }
+  }
+
+public:
+
+  /** Well-conditioned design with two independent features, the labels are drawn from a known logistic model. */
+  void setUp() override
+  {
+    const unsigned int rows = 20000;
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    std::normal_distribution<double> normal(0.0, 0.5);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    m_X.set_size(rows, 2);
+    m_Y.set_size(rows);
+    for (unsigned int r = 0; r < rows; ++r)
+    {
+      m_X(r, 0) = uniform(generator);
+      m_X(r, 1) = normal(generator);
+      const double probability = 1 / (1 + std::exp(-(0.3 + 1.5 * m_X(r, 0) - 1.0 * m_X(r, 1))));
+      m_Y(r) = unit(generator) < probability ? 1 : 0;
+    }
+  }
+
+  void tearDown() override
+  {
+    m_X.clear();
+    m_Y.clear();
+  }
+
+  void Fit_WellConditionedDesign_EqualsReference()
+  {
+    mitk::GeneralizedLinearModel glm(m_X, m_Y);
+    CheckEqual("B equals the QR reference fit", ReferenceFit(m_X, m_Y), glm.B(), 1e-6);
+  }
+
+  void Fit_DuplicatedColumn_EqualsFullRankFit()
+  {
+    vnl_matrix<double> x(m_X.rows(), 3);
+    x.set_columns(0, m_X);
+    x.set_column(2, m_X.get_column(0));
+
+    mitk::GeneralizedLinearModel fullRank(m_X, m_Y);
+    mitk::GeneralizedLinearModel rankDeficient(x, m_Y);
+    vnl_vector<double> expected = fullRank.B();
+    vnl_vector<double> b = rankDeficient.B();
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("One coefficient per column", 4, static_cast<int>(b.size()));
+    CPPUNIT_ASSERT_MESSAGE("One of the duplicated columns is dropped", b(1) == 0 || b(3) == 0);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Constant equals the full rank fit", expected(0), b(0), 1e-6 * std::max(1.0, std::abs(expected(0))));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Duplicated columns share the coefficient of the full rank fit", expected(1), b(1) + b(3), 1e-6 * std::max(1.0, std::abs(expected(1))));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Independent column equals the full rank fit", expected(2), b(2), 1e-6 * std::max(1.0, std::abs(expected(2))));
+  }
+
+  void Fit_WarmStart_ConvergesToSameB()
+  {
+    mitk::GeneralizedLinearModel glm(m_X, m_Y);
+    vnl_vector<double> perturbed = glm.B();
+    for (unsigned int i = 0; i < perturbed.size(); ++i)
+      perturbed(i) += (i % 2 == 0) ? 0.2 : -0.2;
+
+    mitk::GeneralizedLinearModel warmStarted(m_X, m_Y, perturbed);
+    CheckEqual("Warm start converges to the same B", glm.B(), warmStarted.B(), 1e-6);
+  }
+
+  void Fit_OneThread_EqualsAllThreads()
+  {
+#ifdef _OPENMP
+    const int maxThreads = omp_get_max_threads();
+    omp_set_num_threads(1);
+    mitk::GeneralizedLinearModel singleThreaded(m_X, m_Y);
+    omp_set_num_threads(maxThreads);
+#else
+    mitk::GeneralizedLinearModel singleThreaded(m_X, m_Y);
+#endif
+    mitk::GeneralizedLinearModel multiThreaded(m_X, m_Y);
+    CheckEqual("B does not depend on the number of threads", singleThreaded.B(), multiThreaded.B(), 1e-10);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkGeneralizedLinearModel)
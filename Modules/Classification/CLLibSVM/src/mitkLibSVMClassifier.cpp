@@ -106,7 +106,7 @@ void  mitk::LibSVMClassifier::ConvertParameter()
   if(!this->GetPropertyList()->Get("classifier.svm.gamma",this->m_Parameter->gamma))              this->m_Parameter->gamma = 0; // 1/n_features;
   if(!this->GetPropertyList()->Get("classifier.svm.coef0",this->m_Parameter->coef0))              this->m_Parameter->coef0 = 0;
   if(!this->GetPropertyList()->Get("classifier.svm.nu",this->m_Parameter->nu))                    this->m_Parameter->nu = 0.5;
-  if(!this->GetPropertyList()->Get("classifier.svm.cache-size",this->m_Parameter->cache_size))    this->m_Parameter->cache_size = 100.0;
+  if(!this->GetPropertyList()->Get("classifier.svm.cache-size",this->m_Parameter->cache_size))    this->m_Parameter->cache_size = 1024.0;
   if(!this->GetPropertyList()->Get("classifier.svm.c",this->m_Parameter->C))                      this->m_Parameter->C = 1.0;
   if(!this->GetPropertyList()->Get("classifier.svm.eps",this->m_Parameter->eps))                  this->m_Parameter->eps = 1e-3;
   if(!this->GetPropertyList()->Get("classifier.svm.p",this->m_Parameter->p))                      this->m_Parameter->p = 0.1;
@@ -132,7 +132,7 @@ void  mitk::LibSVMClassifier::ConvertParameter()
   //-c cost : set the parameter C of C-SVC, epsilon-SVR, and nu-SVR (default 1)
   //-n nu : set the parameter nu of nu-SVC, one-class SVM, and nu-SVR (default 0.5)
   //-p epsilon : set the epsilon in loss function of epsilon-SVR (default 0.1)
-  //-m cachesize : set cache memory size in MB (default 100)
+  //-m cachesize : set cache memory size in MB, shared by the one-vs-one problems trained in parallel (default 1024)
   //-e epsilon : set tolerance of termination criterion (default 0.001)
   //-h shrinking: whether to use the shrinking heuristics, 0 or 1 (default 1)
   //-b probability_estimates: whether to train a SVC or SVR model for probability estimates, 0 or 1 (default 0)
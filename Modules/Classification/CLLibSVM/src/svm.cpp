@@ -59,6 +59,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <limits.h>
 #include <locale.h>
 #include <mitkLocaleSwitch.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "svm.h"
 int libsvm_version = LIBSVM_VERSION;
 typedef float Qfloat;
@@ -89,6 +92,7 @@ static inline double powi(double base, int times)
 #define INF HUGE_VAL
 #define TAU 1e-12
 #define Malloc(type,n) (type *)malloc((n)*sizeof(type))
+#define MIN_PARALLEL_KERNEL_EVALUATIONS 1000 // shorter kernel columns are computed on one thread
 
 static void print_string_stdout(const char *s)
 {
@@ -263,6 +267,7 @@ public:
   virtual void swap_index(int i, int j) const // no so const...
   {
     swap(x[i],x[j]);
+    if(x_row) swap(x_row[i],x_row[j]);
     if(x_square) swap(x_square[i],x_square[j]);
   }
 protected:
@@ -273,6 +278,11 @@ private:
   const svm_node **x;
   double *x_square;
 
+  // dense copy of the samples (feature index 1..dim), used if it is not larger than the sparse data
+  double *x_dense;
+  const double **x_row;
+  int dim;
+
   // svm_parameter
   const int kernel_type;
   const int degree;
@@ -280,21 +290,41 @@ private:
   const double coef0;
 
   static double dot(const svm_node *px, const svm_node *py);
+  double dot(int i, int j) const
+  {
+    if(!x_row)
+      return dot(x[i],x[j]);
+
+    // four independent sums, so the loop is vectorized
+    const double *px = x_row[i], *py = x_row[j];
+    double sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+    int k = 0;
+    for(;k+4<=dim;k+=4)
+    {
+      sum0 += px[k] * py[k];
+      sum1 += px[k+1] * py[k+1];
+      sum2 += px[k+2] * py[k+2];
+      sum3 += px[k+3] * py[k+3];
+    }
+    for(;k<dim;k++)
+      sum0 += px[k] * py[k];
+    return (sum0 + sum1) + (sum2 + sum3);
+  }
   double kernel_linear(int i, int j) const
   {
-    return dot(x[i],x[j]);
+    return dot(i,j);
   }
   double kernel_poly(int i, int j) const
   {
-    return powi(gamma*dot(x[i],x[j])+coef0,degree);
+    return powi(gamma*dot(i,j)+coef0,degree);
   }
   double kernel_rbf(int i, int j) const
   {
-    return exp(-gamma*(x_square[i]+x_square[j]-2*dot(x[i],x[j])));
+    return exp(-gamma*(x_square[i]+x_square[j]-2*dot(i,j)));
   }
   double kernel_sigmoid(int i, int j) const
   {
-    return tanh(gamma*dot(x[i],x[j])+coef0);
+    return tanh(gamma*dot(i,j)+coef0);
   }
   double kernel_precomputed(int i, int j) const
   {
@@ -327,11 +357,41 @@ Kernel::Kernel(int l, svm_node * const * x_, const svm_parameter& param)
 
   clone(x,x_,l);
 
+  // The kernel columns are computed on a dense copy of the samples if it needs at most
+  // as much memory as the sparse nodes (8 bytes per value instead of 16 per node).
+  x_dense = 0;
+  x_row = 0;
+  dim = 0;
+  if(kernel_type != PRECOMPUTED)
+  {
+    double nr_nodes = 0;
+    int min_index = INT_MAX;
+    for(int i=0;i<l;i++)
+      for(const svm_node *px = x[i]; px->index != -1; ++px)
+      {
+        ++nr_nodes;
+        min_index = min(min_index, px->index);
+        dim = max(dim, px->index);
+      }
+    if(dim > 0 && min_index >= 1 && (double)l*dim <= 2*nr_nodes)
+    {
+      x_dense = new double[(size_t)l*dim]();
+      x_row = new const double*[l];
+      for(int i=0;i<l;i++)
+      {
+        double *row = x_dense + (size_t)i*dim;
+        for(const svm_node *px = x[i]; px->index != -1; ++px)
+          row[px->index-1] = px->value;
+        x_row[i] = row;
+      }
+    }
+  }
+
   if(kernel_type == RBF)
   {
     x_square = new double[l];
     for(int i=0;i<l;i++)
-      x_square[i] = dot(x[i],x[i]);
+      x_square[i] = dot(i,i);
   }
   else
     x_square = 0;
@@ -341,6 +401,8 @@ Kernel::~Kernel()
 {
   delete[] x;
   delete[] x_square;
+  delete[] x_dense;
+  delete[] x_row;
 }
 
 double Kernel::dot(const svm_node *px, const svm_node *py)
@@ -1325,6 +1387,7 @@ public:
     clone(y,y_,prob.l);
     cache = new Cache(prob.l,(long int)(param.cache_size*(1<<20)));
     QD = new double[prob.l];
+#pragma omp parallel for if(prob.l > MIN_PARALLEL_KERNEL_EVALUATIONS)
     for(int i=0;i<prob.l;i++)
       QD[i] = (this->*kernel_function)(i,i);
   }
@@ -1335,6 +1398,8 @@ public:
     int start, j;
     if((start = cache->get_data(i,&data,len)) < len)
     {
+      // the kernel functions only read the samples, so the column is filled in parallel
+#pragma omp parallel for if(len-start > MIN_PARALLEL_KERNEL_EVALUATIONS)
       for(j=start;j<len;j++)
         data[j] = (Qfloat)(y[i]*y[j]*(this->*kernel_function)(i,j));
     }
@@ -1374,6 +1439,7 @@ public:
   {
     cache = new Cache(prob.l,(long int)(param.cache_size*(1<<20)));
     QD = new double[prob.l];
+#pragma omp parallel for if(prob.l > MIN_PARALLEL_KERNEL_EVALUATIONS)
     for(int i=0;i<prob.l;i++)
       QD[i] = (this->*kernel_function)(i,i);
   }
@@ -1384,6 +1450,7 @@ public:
     int start, j;
     if((start = cache->get_data(i,&data,len)) < len)
     {
+#pragma omp parallel for if(len-start > MIN_PARALLEL_KERNEL_EVALUATIONS)
       for(j=start;j<len;j++)
         data[j] = (Qfloat)(this->*kernel_function)(i,j);
     }
@@ -1423,6 +1490,7 @@ public:
     QD = new double[2*l];
     sign = new schar[2*l];
     index = new int[2*l];
+#pragma omp parallel for if(l > MIN_PARALLEL_KERNEL_EVALUATIONS)
     for(int k=0;k<l;k++)
     {
       sign[k] = 1;
@@ -1450,6 +1518,7 @@ public:
     int j, real_i = index[i];
     if(cache->get_data(real_i,&data,l) < l)
     {
+#pragma omp parallel for if(l > MIN_PARALLEL_KERNEL_EVALUATIONS)
       for(j=0;j<l;j++)
         data[j] = (Qfloat)(this->*kernel_function)(real_i,j);
     }
@@ -2330,47 +2399,78 @@ svm_model *svm_train(const svm_problem *prob, const svm_parameter *param)
       probB=Malloc(double,nr_class*(nr_class-1)/2);
     }
 
+    int nr_pairs = nr_class*(nr_class-1)/2;
+    int *pair_i = Malloc(int,nr_pairs);
+    int *pair_j = Malloc(int,nr_pairs);
     int p = 0;
     for(i=0;i<nr_class;i++)
       for(int j=i+1;j<nr_class;j++)
       {
-        svm_problem sub_prob;
-        int si = start[i], sj = start[j];
-        int ci = count[i], cj = count[j];
-        sub_prob.l = ci+cj;
-        sub_prob.x = Malloc(svm_node *,sub_prob.l);
-        sub_prob.y = Malloc(double,sub_prob.l);
-        sub_prob.W = Malloc(double,sub_prob.l);
-        int k;
-        for(k=0;k<ci;k++)
-        {
-          sub_prob.x[k] = x[si+k];
-          sub_prob.y[k] = +1;
-          sub_prob.W[k] = W[si+k];
-        }
-        for(k=0;k<cj;k++)
-        {
-          sub_prob.x[ci+k] = x[sj+k];
-          sub_prob.y[ci+k] = -1;
-          sub_prob.W[ci+k] = W[sj+k];
-        }
-
-        if(param->probability)
-          svm_binary_svc_probability(&sub_prob,param,weighted_C[i],weighted_C[j],probA[p],probB[p]);
-
-        f[p] = svm_train_one(&sub_prob,param,weighted_C[i],weighted_C[j]);
-        for(k=0;k<ci;k++)
-          if(!nonzero[si+k] && fabs(f[p].alpha[k]) > 0)
-            nonzero[si+k] = true;
-        for(k=0;k<cj;k++)
-          if(!nonzero[sj+k] && fabs(f[p].alpha[ci+k]) > 0)
-            nonzero[sj+k] = true;
-        free(sub_prob.x);
-        free(sub_prob.y);
-        free(sub_prob.W);
+        pair_i[p] = i;
+        pair_j[p] = j;
         ++p;
       }
 
+    // The sub-problems are independent and trained in parallel. The cross validation for the
+    // probability estimates draws with rand(), so they are trained one after another in this case.
+    // The kernel cache budget is shared by the sub-problems that are trained at the same time.
+    int nr_threads = 1;
+#ifdef _OPENMP
+    if(!param->probability)
+      nr_threads = max(1, min(omp_get_max_threads(), nr_pairs));
+#endif
+    svm_parameter sub_param = *param;
+    sub_param.cache_size = param->cache_size / nr_threads;
+
+#pragma omp parallel for schedule(dynamic) num_threads(nr_threads)
+    for(p=0;p<nr_pairs;p++)
+    {
+      int class_i = pair_i[p], class_j = pair_j[p];
+      svm_problem sub_prob;
+      int si = start[class_i], sj = start[class_j];
+      int ci = count[class_i], cj = count[class_j];
+      sub_prob.l = ci+cj;
+      sub_prob.x = Malloc(svm_node *,sub_prob.l);
+      sub_prob.y = Malloc(double,sub_prob.l);
+      sub_prob.W = Malloc(double,sub_prob.l);
+      int k;
+      for(k=0;k<ci;k++)
+      {
+        sub_prob.x[k] = x[si+k];
+        sub_prob.y[k] = +1;
+        sub_prob.W[k] = W[si+k];
+      }
+      for(k=0;k<cj;k++)
+      {
+        sub_prob.x[ci+k] = x[sj+k];
+        sub_prob.y[ci+k] = -1;
+        sub_prob.W[ci+k] = W[sj+k];
+      }
+
+      if(param->probability)
+        svm_binary_svc_probability(&sub_prob,&sub_param,weighted_C[class_i],weighted_C[class_j],probA[p],probB[p]);
+
+      f[p] = svm_train_one(&sub_prob,&sub_param,weighted_C[class_i],weighted_C[class_j]);
+      free(sub_prob.x);
+      free(sub_prob.y);
+      free(sub_prob.W);
+    }
+
+    for(p=0;p<nr_pairs;p++)
+    {
+      int si = start[pair_i[p]], sj = start[pair_j[p]];
+      int ci = count[pair_i[p]], cj = count[pair_j[p]];
+      int k;
+      for(k=0;k<ci;k++)
+        if(!nonzero[si+k] && fabs(f[p].alpha[k]) > 0)
+          nonzero[si+k] = true;
+      for(k=0;k<cj;k++)
+        if(!nonzero[sj+k] && fabs(f[p].alpha[ci+k]) > 0)
+          nonzero[sj+k] = true;
+    }
+    free(pair_i);
+    free(pair_j);
+
     // build output
 
     model->nr_class = nr_class;
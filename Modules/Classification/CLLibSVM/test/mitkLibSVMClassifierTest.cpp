@@ -26,6 +26,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkCSVArray2DFileReader.h>
 #include <itkCSVArray2DDataObject.h>
 #include <itkCSVNumericObjectFileWriter.h>
+#include <random>
 
 //#include <boost/algorithm/string.hpp>
 
@@ -34,6 +35,7 @@ class mitkLibSVMClassifierTestSuite : public mitk::TestFixture
   CPPUNIT_TEST_SUITE(mitkLibSVMClassifierTestSuite);
   MITK_TEST(TrainSVMClassifier_MatlabDataSet_shouldReturnTrue);
   MITK_TEST(TrainSVMClassifier_BreastCancerDataSet_shouldReturnTrue);
+  MITK_TEST(TrainSVMClassifier_MultiClassDataSet_IndependentOfCacheSize);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -312,6 +314,45 @@ public:
     MITK_TEST_CONDITION(isIntervall<int>(m_TestYPredict,classes,75,100),"Testvalue is in range.");
   }
 
+  /*
+  Train the classifier with three gaussian distributed classes. The one-vs-one problems
+  are trained in parallel and share the kernel cache, so a small cache must not change the model.
+  */
+  void TrainSVMClassifier_MultiClassDataSet_IndependentOfCacheSize()
+  {
+    std::mt19937 randGen(1);
+    std::normal_distribution<double> value(0, 1);
+
+    const int numberOfPoints = 1500;
+    const int numberOfFeatures = 10;
+    MatrixDoubleType features(numberOfPoints, numberOfFeatures);
+    MatrixIntType labels(numberOfPoints, 1);
+    for (int point = 0; point < numberOfPoints; ++point)
+    {
+      labels(point, 0) = point % 3;
+      for (int feature = 0; feature < numberOfFeatures; ++feature)
+        features(point, feature) = value(randGen) + ((feature % 3 == labels(point, 0)) ? 2.0 : 0.0);
+    }
+
+    mitk::LibSVMClassifier::Pointer largeCacheClassifier = mitk::LibSVMClassifier::New();
+    largeCacheClassifier->SetGamma(1 / (double)numberOfFeatures);
+    largeCacheClassifier->SetSvmType(0);
+    largeCacheClassifier->SetKernelType(2);
+    largeCacheClassifier->Train(features, labels);
+    Eigen::MatrixXi largeCacheClasses = largeCacheClassifier->Predict(features);
+
+    mitk::LibSVMClassifier::Pointer smallCacheClassifier = mitk::LibSVMClassifier::New();
+    smallCacheClassifier->SetGamma(1 / (double)numberOfFeatures);
+    smallCacheClassifier->SetSvmType(0);
+    smallCacheClassifier->SetKernelType(2);
+    smallCacheClassifier->SetCacheSize(1);
+    smallCacheClassifier->Train(features, labels);
+    Eigen::MatrixXi smallCacheClasses = smallCacheClassifier->Predict(features);
+
+    MITK_TEST_CONDITION(isEqual<int>(largeCacheClasses, smallCacheClasses), "Model does not depend on the cache size.");
+    MITK_TEST_CONDITION(isIntervall<int>(labels, largeCacheClasses, 90, 100), "Training data is classified correctly.");
+  }
+
   void TestThreadedDecisionForest()
   {
   }
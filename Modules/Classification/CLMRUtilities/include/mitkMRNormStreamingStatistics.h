@@ -0,0 +1,448 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKMRNORMSTREAMINGSTATISTICS_H
+#define MITKMRNORMSTREAMINGSTATISTICS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace mitk {
+  //##Documentation
+  //## @brief Statistics of the image values inside one mask, as itk::LabelStatisticsImageFilter computes them
+  //## for the MR normalization.
+  //##
+  //## The histogram has 256 bins between the minimum and the maximum of the whole image. Statistics of
+  //## different parts of the image are combined with Merge(), so each thread can accumulate its own part.
+  class MRNormRegionStatistics
+  {
+  public:
+    enum { NumberOfBins = 256 };
+
+    MRNormRegionStatistics() :
+      m_Count(0), m_Sum(0), m_SumOfSquares(0), m_Minimum(0), m_Maximum(0), m_Interval(0), m_Histogram(NumberOfBins, 0)
+    {
+    }
+
+    void SetRange(double minimum, double maximum)
+    {
+      m_Minimum = minimum;
+      m_Maximum = maximum;
+      m_Interval = (maximum - minimum) / NumberOfBins;
+    }
+
+    /** Bin of the value. Bin i covers [min+i*interval, min+(i+1)*interval), the maximum is in the last bin. */
+    int GetBin(double value) const
+    {
+      if (!(m_Interval > 0) || value >= m_Maximum)
+        return NumberOfBins - 1;
+      int bin = std::max(0, std::min(static_cast<int>((value - m_Minimum) / m_Interval), NumberOfBins - 1));
+      while (bin > 0 && value < m_Minimum + bin * m_Interval)
+        --bin;
+      while (bin < NumberOfBins - 1 && value >= m_Minimum + (bin + 1) * m_Interval)
+        ++bin;
+      return bin;
+    }
+
+    void AddValue(double value)
+    {
+      ++m_Count;
+      m_Sum += value;
+      m_SumOfSquares += value * value;
+    }
+
+    void AddToHistogram(double value, std::size_t count)
+    {
+      m_Histogram[GetBin(value)] += count;
+    }
+
+    void Merge(const MRNormRegionStatistics &other)
+    {
+      m_Count += other.m_Count;
+      m_Sum += other.m_Sum;
+      m_SumOfSquares += other.m_SumOfSquares;
+      for (int bin = 0; bin < NumberOfBins; ++bin)
+        m_Histogram[bin] += other.m_Histogram[bin];
+    }
+
+    std::size_t GetCount() const { return m_Count; }
+
+    double GetMean() const
+    {
+      return (m_Count > 0) ? m_Sum / m_Count : 0.0;
+    }
+
+    double GetSigma() const
+    {
+      if (m_Count < 2)
+        return 0.0;
+      const double count = static_cast<double>(m_Count);
+      return std::sqrt(std::max(0.0, (m_SumOfSquares - m_Sum * m_Sum / count) / (count - 1)));
+    }
+
+    /** Center of the bin in which the cumulated frequency exceeds half of the values. */
+    double GetMedian() const
+    {
+      std::size_t total = 0;
+      int bin = 0;
+      while (total <= m_Count / 2 && bin < NumberOfBins)
+        total += m_Histogram[bin++];
+      return GetBinCenter(bin - 1);
+    }
+
+    /** Center of the first bin with the highest frequency. */
+    double GetMode() const
+    {
+      std::size_t maxFrequency = 0;
+      double mode = 0;
+      for (int bin = 0; bin < NumberOfBins; ++bin)
+      {
+        if (maxFrequency < m_Histogram[bin])
+        {
+          maxFrequency = m_Histogram[bin];
+          mode = GetBinCenter(bin);
+        }
+      }
+      return mode;
+    }
+
+  private:
+    double GetBinCenter(int bin) const
+    {
+      const double binMax = (bin == NumberOfBins - 1) ? m_Maximum : m_Minimum + (bin + 1) * m_Interval;
+      return (m_Minimum + bin * m_Interval + binMax) / 2.0;
+    }
+
+    std::size_t m_Count;
+    double m_Sum;
+    double m_SumOfSquares;
+    double m_Minimum;
+    double m_Maximum;
+    double m_Interval;
+    std::vector<std::size_t> m_Histogram;
+  };
+
+  //##Documentation
+  //## @brief Fused passes of the MR normalization over all channels of one case.
+  //##
+  //## Channels and masks are pixel buffers of the same size, a voxel belongs to a mask if the mask value is 1.
+  //## The first pass reads each chunk of the buffers once and computes the range of each channel and the
+  //## moments of each channel inside each mask. For 8 and 16 bit integer channels it also counts every masked
+  //## value, so the histograms are known after this pass. Other pixel types need a second statistics pass if
+  //## histograms (median or mode) are requested. Rescale() writes the normalized channel into an image buffer,
+  //## which may be the channel itself, and into a column of a feature matrix in the same pass.
+  //## All passes are split into chunks that are processed in parallel. Each thread accumulates its own
+  //## statistics, which are merged in the order of the threads afterwards.
+  template <typename TPixel>
+  class MRNormStreamingStatistics
+  {
+  public:
+    MRNormStreamingStatistics(const std::vector<const TPixel*> &channels, const std::vector<const int*> &masks, std::size_t numberOfPixels) :
+      m_Channels(channels),
+      m_Masks(masks),
+      m_NumberOfPixels(numberOfPixels),
+      m_Statistics(channels.size() * masks.size()),
+      m_Minimum(channels.size(), 0),
+      m_Maximum(channels.size(), 0),
+      m_FeatureMask(nullptr)
+    {
+    }
+
+    /** Computes the statistics of all channels inside all masks. Histograms are only needed for median and mode. */
+    void Compute(bool withHistograms)
+    {
+      const int numberOfChunks = GetNumberOfChunks();
+      const int numberOfThreads = GetNumberOfThreads(numberOfChunks);
+      const int numberOfChannels = static_cast<int>(m_Channels.size());
+      const int numberOfMasks = static_cast<int>(m_Masks.size());
+      const bool countValues = withHistograms && ValueTable::Size() > 0;
+
+      std::vector<std::vector<MRNormRegionStatistics> > partialStatistics(numberOfThreads, std::vector<MRNormRegionStatistics>(m_Statistics.size()));
+      std::vector<std::vector<TPixel> > partialMinimum(numberOfThreads, std::vector<TPixel>(numberOfChannels, std::numeric_limits<TPixel>::max()));
+      std::vector<std::vector<TPixel> > partialMaximum(numberOfThreads, std::vector<TPixel>(numberOfChannels, std::numeric_limits<TPixel>::lowest()));
+      std::vector<std::vector<std::vector<unsigned int> > > partialValueCounts(numberOfThreads);
+      if (countValues)
+      {
+        for (int thread = 0; thread < numberOfThreads; ++thread)
+          partialValueCounts[thread].assign(m_Statistics.size(), std::vector<unsigned int>(ValueTable::Size(), 0));
+      }
+
+#pragma omp parallel num_threads(numberOfThreads)
+      {
+        const int thread = GetThreadNumber();
+#pragma omp for schedule(static)
+        for (int chunk = 0; chunk < numberOfChunks; ++chunk)
+        {
+          const std::size_t begin = static_cast<std::size_t>(chunk) * ChunkSize;
+          const std::size_t end = std::min(begin + ChunkSize, m_NumberOfPixels);
+          for (int c = 0; c < numberOfChannels; ++c)
+          {
+            const TPixel *channel = m_Channels[c];
+            TPixel minimum = partialMinimum[thread][c];
+            TPixel maximum = partialMaximum[thread][c];
+            for (std::size_t i = begin; i < end; ++i)
+            {
+              minimum = std::min(minimum, channel[i]);
+              maximum = std::max(maximum, channel[i]);
+            }
+            partialMinimum[thread][c] = minimum;
+            partialMaximum[thread][c] = maximum;
+
+            for (int m = 0; m < numberOfMasks; ++m)
+            {
+              const int *mask = m_Masks[m];
+              const int region = c * numberOfMasks + m;
+              MRNormRegionStatistics &statistics = partialStatistics[thread][region];
+              if (countValues)
+              {
+                unsigned int *counts = partialValueCounts[thread][region].data();
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                  if (mask[i] == 1)
+                  {
+                    statistics.AddValue(channel[i]);
+                    ++counts[ValueTable::Index(channel[i])];
+                  }
+                }
+              }
+              else
+              {
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                  if (mask[i] == 1)
+                    statistics.AddValue(channel[i]);
+                }
+              }
+            }
+          }
+        }
+      }
+
+      for (int c = 0; c < numberOfChannels; ++c)
+      {
+        TPixel minimum = partialMinimum[0][c];
+        TPixel maximum = partialMaximum[0][c];
+        for (int thread = 1; thread < numberOfThreads; ++thread)
+        {
+          minimum = std::min(minimum, partialMinimum[thread][c]);
+          maximum = std::max(maximum, partialMaximum[thread][c]);
+        }
+        m_Minimum[c] = minimum;
+        m_Maximum[c] = maximum;
+        for (int m = 0; m < numberOfMasks; ++m)
+        {
+          MRNormRegionStatistics &statistics = m_Statistics[c * numberOfMasks + m];
+          statistics = MRNormRegionStatistics();
+          statistics.SetRange(minimum, maximum);
+          for (int thread = 0; thread < numberOfThreads; ++thread)
+            statistics.Merge(partialStatistics[thread][c * numberOfMasks + m]);
+        }
+      }
+
+      if (countValues)
+      {
+        for (std::size_t region = 0; region < m_Statistics.size(); ++region)
+        {
+          for (std::size_t index = 0; index < ValueTable::Size(); ++index)
+          {
+            std::size_t count = 0;
+            for (int thread = 0; thread < numberOfThreads; ++thread)
+              count += partialValueCounts[thread][region][index];
+            if (count > 0)
+              m_Statistics[region].AddToHistogram(ValueTable::Value(index), count);
+          }
+        }
+      }
+      else if (withHistograms)
+      {
+        ComputeHistograms(numberOfChunks, numberOfThreads);
+      }
+    }
+
+    const MRNormRegionStatistics &GetStatistics(unsigned int channel, unsigned int mask) const
+    {
+      return m_Statistics[channel * m_Masks.size() + mask];
+    }
+
+    /** Range of the whole channel, known after Compute(). */
+    double GetMinimum(unsigned int channel) const { return m_Minimum[channel]; }
+    double GetMaximum(unsigned int channel) const { return m_Maximum[channel]; }
+
+    /** Voxels with a mask value > 0 are written to the feature columns by Rescale(), in the order of the buffer. */
+    void SetFeatureMask(const int *mask)
+    {
+      m_FeatureMask = mask;
+      const int numberOfChunks = GetNumberOfChunks();
+      m_FeatureRowStarts.assign(numberOfChunks + 1, 0);
+#pragma omp parallel for schedule(static) num_threads(GetNumberOfThreads(numberOfChunks))
+      for (int chunk = 0; chunk < numberOfChunks; ++chunk)
+      {
+        const std::size_t begin = static_cast<std::size_t>(chunk) * ChunkSize;
+        const std::size_t end = std::min(begin + ChunkSize, m_NumberOfPixels);
+        std::size_t count = 0;
+        for (std::size_t i = begin; i < end; ++i)
+          count += (mask[i] > 0) ? 1 : 0;
+        m_FeatureRowStarts[chunk + 1] = count;
+      }
+      for (int chunk = 0; chunk < numberOfChunks; ++chunk)
+        m_FeatureRowStarts[chunk + 1] += m_FeatureRowStarts[chunk];
+    }
+
+    std::size_t GetNumberOfFeatureRows() const
+    {
+      return m_FeatureRowStarts.empty() ? 0 : m_FeatureRowStarts.back();
+    }
+
+    /**
+    * Writes (value - offset) / scaling of the channel into output and, for the voxels of the feature mask, into
+    * featureColumn. Either can be nullptr. output may be the buffer of the channel itself.
+    */
+    void Rescale(unsigned int channel, double offset, double scaling, TPixel *output, double *featureColumn) const
+    {
+      const TPixel *input = m_Channels[channel];
+      const bool writeFeatures = featureColumn != nullptr && m_FeatureMask != nullptr;
+      const int numberOfChunks = GetNumberOfChunks();
+#pragma omp parallel for schedule(static) num_threads(GetNumberOfThreads(numberOfChunks))
+      for (int chunk = 0; chunk < numberOfChunks; ++chunk)
+      {
+        const std::size_t begin = static_cast<std::size_t>(chunk) * ChunkSize;
+        const std::size_t end = std::min(begin + ChunkSize, m_NumberOfPixels);
+        // The features are written first, the output may overwrite the input
+        if (writeFeatures)
+        {
+          double *row = featureColumn + m_FeatureRowStarts[chunk];
+          for (std::size_t i = begin; i < end; ++i)
+          {
+            if (m_FeatureMask[i] > 0)
+              *row++ = (input[i] - offset) / scaling;
+          }
+        }
+        if (output != nullptr)
+        {
+          for (std::size_t i = begin; i < end; ++i)
+            output[i] = static_cast<TPixel>((input[i] - offset) / scaling);
+        }
+      }
+    }
+
+  private:
+    enum { ChunkSize = 1 << 16 };
+
+    /** Index of each value of 8 and 16 bit integer types in a table of counts. Size is 0 for other types. */
+    template <typename T, bool VCountable = std::is_integral<T>::value && (sizeof(T) <= 2)>
+    struct ValueTableType
+    {
+      static std::size_t Size() { return 0; }
+      static std::size_t Index(T) { return 0; }
+      static double Value(std::size_t) { return 0; }
+    };
+
+    template <typename T>
+    struct ValueTableType<T, true>
+    {
+      static std::size_t Size() { return std::size_t(1) << (8 * sizeof(T)); }
+      static std::size_t Index(T value) { return static_cast<std::size_t>(static_cast<int>(value) - static_cast<int>(std::numeric_limits<T>::min())); }
+      static double Value(std::size_t index) { return static_cast<double>(static_cast<int>(index) + static_cast<int>(std::numeric_limits<T>::min())); }
+    };
+
+    typedef ValueTableType<TPixel> ValueTable;
+
+    int GetNumberOfChunks() const
+    {
+      return static_cast<int>((m_NumberOfPixels + ChunkSize - 1) / ChunkSize);
+    }
+
+    static int GetNumberOfThreads(int numberOfChunks)
+    {
+#ifdef _OPENMP
+      return std::max(1, std::min(omp_get_max_threads(), numberOfChunks));
+#else
+      (void)numberOfChunks;
+      return 1;
+#endif
+    }
+
+    static int GetThreadNumber()
+    {
+#ifdef _OPENMP
+      return omp_get_thread_num();
+#else
+      return 0;
+#endif
+    }
+
+    void ComputeHistograms(int numberOfChunks, int numberOfThreads)
+    {
+      const int numberOfChannels = static_cast<int>(m_Channels.size());
+      const int numberOfMasks = static_cast<int>(m_Masks.size());
+      std::vector<std::vector<MRNormRegionStatistics> > partialHistograms(numberOfThreads, std::vector<MRNormRegionStatistics>(m_Statistics.size()));
+      for (int thread = 0; thread < numberOfThreads; ++thread)
+      {
+        for (int c = 0; c < numberOfChannels; ++c)
+          for (int m = 0; m < numberOfMasks; ++m)
+            partialHistograms[thread][c * numberOfMasks + m].SetRange(m_Minimum[c], m_Maximum[c]);
+      }
+
+#pragma omp parallel num_threads(numberOfThreads)
+      {
+        const int thread = GetThreadNumber();
+#pragma omp for schedule(static)
+        for (int chunk = 0; chunk < numberOfChunks; ++chunk)
+        {
+          const std::size_t begin = static_cast<std::size_t>(chunk) * ChunkSize;
+          const std::size_t end = std::min(begin + ChunkSize, m_NumberOfPixels);
+          for (int c = 0; c < numberOfChannels; ++c)
+          {
+            const TPixel *channel = m_Channels[c];
+            for (int m = 0; m < numberOfMasks; ++m)
+            {
+              const int *mask = m_Masks[m];
+              MRNormRegionStatistics &histogram = partialHistograms[thread][c * numberOfMasks + m];
+              for (std::size_t i = begin; i < end; ++i)
+              {
+                if (mask[i] == 1)
+                  histogram.AddToHistogram(channel[i], 1);
+              }
+            }
+          }
+        }
+      }
+
+      for (int thread = 0; thread < numberOfThreads; ++thread)
+        for (std::size_t region = 0; region < m_Statistics.size(); ++region)
+          m_Statistics[region].Merge(partialHistograms[thread][region]);
+    }
+
+    std::vector<const TPixel*> m_Channels;
+    std::vector<const int*> m_Masks;
+    std::size_t m_NumberOfPixels;
+    std::vector<MRNormRegionStatistics> m_Statistics;
+    std::vector<double> m_Minimum;
+    std::vector<double> m_Maximum;
+    const int *m_FeatureMask;
+    std::vector<std::size_t> m_FeatureRowStarts;
+  };
+} // namespace mitk
+
+#endif /* MITKMRNORMSTREAMINGSTATISTICS_H */
@@ -24,6 +24,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "itkImage.h"
 
+#include <Eigen/Dense>
+
 namespace mitk {
   //##Documentation
   //## @brief
@@ -42,6 +44,27 @@ namespace mitk {
     const mitk::Image* GetMask1() const;
     const mitk::Image* GetMask2() const;
 
+    /**
+    * \brief Adds a further channel of the same case, which is normalized with its own statistics in the same passes.
+    *
+    * The channel needs the geometry and the pixel type of the input, which is channel 0.
+    * The result of channel i is GetOutput(i).
+    */
+    void AddChannel( const mitk::Image* image );
+
+    const mitk::Image* GetChannel( unsigned int channel ) const;
+
+    unsigned int GetNumberOfChannels() const;
+
+    /**
+    * \brief Writes the normalized voxels with a non-zero mask value also into columns of a feature matrix.
+    *
+    * Channel i is written into column firstColumn+i, one row per voxel of the mask in image order, like
+    * mitk::CLUtil::Transform does. The matrix must have one row per mask voxel and has to exist until
+    * the filter is updated.
+    */
+    void SetFeatureMatrix( Eigen::MatrixXd* matrix, const mitk::Image* mask, unsigned int firstColumn = 0 );
+
     enum NormalizationBase
     {
       MEAN,
@@ -70,6 +93,11 @@ namespace mitk {
 
     NormalizationBase m_Area1;
     NormalizationBase m_Area2;
+
+    unsigned int m_NumberOfChannels;
+    Eigen::MatrixXd* m_FeatureMatrix;
+    mitk::Image::ConstPointer m_FeatureMask;
+    unsigned int m_FirstFeatureColumn;
   };
 } // namespace mitk
 
@@ -24,15 +24,21 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkITKImageImport.h>
 #include <mitkImageCast.h>
 #include <mitkImageAccessByItk.h>
-// ITK
-#include <itkLabelStatisticsImageFilter.h>
-#include <itkMinimumMaximumImageCalculator.h>
+#include <mitkExceptionMacro.h>
+#include <mitkLogMacros.h>
+#include "mitkMRNormStreamingStatistics.h"
+
+// Channel 0 is the input, the further channels follow the mask inputs
+static const unsigned int FirstChannelInput = 3;
 
 mitk::MRNormLinearStatisticBasedFilter::MRNormLinearStatisticBasedFilter() :
-  m_CenterMode(MRNormLinearStatisticBasedFilter::MEDIAN)
+  m_CenterMode(MRNormLinearStatisticBasedFilter::MEDIAN),
+  m_NumberOfChannels(1),
+  m_FeatureMatrix(nullptr),
+  m_FirstFeatureColumn(0)
 {
   this->SetNumberOfIndexedInputs(3);
-  this->SetNumberOfRequiredInputs(3);
+  this->SetNumberOfRequiredInputs(2);
 }
 
 mitk::MRNormLinearStatisticBasedFilter::~MRNormLinearStatisticBasedFilter()
@@ -51,24 +57,58 @@ const mitk::Image* mitk::MRNormLinearStatisticBasedFilter::GetMask() const
   return this->GetInput(1);
 }
 
+void mitk::MRNormLinearStatisticBasedFilter::AddChannel( const mitk::Image* image )
+{
+  // Process object is not const-correct so the const_cast is required here
+  Image* nonconstImage = const_cast< mitk::Image * >( image );
+  this->SetNthInput(FirstChannelInput + m_NumberOfChannels - 1, nonconstImage );
+  this->SetNthOutput(m_NumberOfChannels, this->MakeOutput(m_NumberOfChannels).GetPointer());
+  ++m_NumberOfChannels;
+}
+
+const mitk::Image* mitk::MRNormLinearStatisticBasedFilter::GetChannel( unsigned int channel ) const
+{
+  if (channel == 0)
+    return this->GetInput(0);
+  return this->GetInput(FirstChannelInput + channel - 1);
+}
+
+unsigned int mitk::MRNormLinearStatisticBasedFilter::GetNumberOfChannels() const
+{
+  return m_NumberOfChannels;
+}
+
+void mitk::MRNormLinearStatisticBasedFilter::SetFeatureMatrix( Eigen::MatrixXd* matrix, const mitk::Image* mask, unsigned int firstColumn )
+{
+  m_FeatureMatrix = matrix;
+  m_FeatureMask = mask;
+  m_FirstFeatureColumn = firstColumn;
+  this->Modified();
+}
+
 void mitk::MRNormLinearStatisticBasedFilter::GenerateInputRequestedRegion()
 {
   Superclass::GenerateInputRequestedRegion();
 
-  mitk::Image* input = const_cast< mitk::Image * > ( this->GetInput() );
-
-  input->SetRequestedRegionToLargestPossibleRegion();
+  for (unsigned int channel = 0; channel < m_NumberOfChannels; ++channel)
+  {
+    mitk::Image* input = const_cast< mitk::Image * > ( this->GetChannel(channel) );
+    input->SetRequestedRegionToLargestPossibleRegion();
+  }
 }
 
 void mitk::MRNormLinearStatisticBasedFilter::GenerateOutputInformation()
 {
-  mitk::Image::ConstPointer input = this->GetInput();
-  mitk::Image::Pointer output = this->GetOutput();
-
   itkDebugMacro(<<"GenerateOutputInformation()");
 
-  output->Initialize(input->GetPixelType(), *input->GetTimeGeometry());
-  output->SetPropertyList(input->GetPropertyList()->Clone());
+  for (unsigned int channel = 0; channel < m_NumberOfChannels; ++channel)
+  {
+    mitk::Image::ConstPointer input = this->GetChannel(channel);
+    mitk::Image::Pointer output = this->GetOutput(channel);
+
+    output->Initialize(input->GetPixelType(), *input->GetTimeGeometry());
+    output->SetPropertyList(input->GetPropertyList()->Clone());
+  }
 }
 
 template < typename TPixel, unsigned int VImageDimension >
@@ -77,67 +117,80 @@ void mitk::MRNormLinearStatisticBasedFilter::InternalComputeMask(itk::Image<TPix
   // Define all necessary Types
   typedef itk::Image<TPixel, VImageDimension> ImageType;
   typedef itk::Image<int, VImageDimension> MaskType;
-  typedef itk::LabelStatisticsImageFilter<ImageType, MaskType> FilterType;
-  typedef itk::MinimumMaximumImageCalculator<ImageType> MinMaxComputerType;
+
+  const std::size_t numberOfPixels = itkImage->GetLargestPossibleRegion().GetNumberOfPixels();
 
   typename MaskType::Pointer itkMask0 = MaskType::New();
   mitk::CastToItkImage(this->GetMask(), itkMask0);
-
-  typename ImageType::Pointer outImage = ImageType::New();
-  mitk::CastToItkImage(this->GetOutput(0), outImage);
-
-  typename MinMaxComputerType::Pointer minMaxComputer = MinMaxComputerType::New();
-  minMaxComputer->SetImage(itkImage);
-  minMaxComputer->Compute();
-
-  typename FilterType::Pointer labelStatisticsImageFilter = FilterType::New();
-  labelStatisticsImageFilter->SetUseHistograms(true);
-  labelStatisticsImageFilter->SetHistogramParameters(256, minMaxComputer->GetMinimum(),minMaxComputer->GetMaximum());
-  labelStatisticsImageFilter->SetInput( itkImage );
-
-  labelStatisticsImageFilter->SetLabelInput(itkMask0);
-  labelStatisticsImageFilter->Update();
-  double median0 = labelStatisticsImageFilter->GetMedian(1);
-  double mean0 = labelStatisticsImageFilter->GetMean(1);
-  double stddev = labelStatisticsImageFilter->GetSigma(1);
-  double modulo0=0;
+  if (itkMask0->GetLargestPossibleRegion().GetNumberOfPixels() != numberOfPixels)
+    mitkThrow() << "Mask and image need the same size";
+
+  // Statistics of all channels are computed in the same passes
+  std::vector<typename ImageType::Pointer> inImages(m_NumberOfChannels);
+  std::vector<typename ImageType::Pointer> outImages(m_NumberOfChannels);
+  std::vector<const TPixel*> channels(m_NumberOfChannels);
+  for (unsigned int c = 0; c < m_NumberOfChannels; ++c)
   {
-    auto histo = labelStatisticsImageFilter->GetHistogram(1);
-    double maxFrequency=0;
-    for (auto hIter=histo->Begin();hIter!=histo->End();++hIter)
+    if (c == 0)
+    {
+      inImages[c] = itkImage;
+    }
+    else
     {
-      if (maxFrequency < hIter.GetFrequency())
-      {
-        maxFrequency = hIter.GetFrequency();
-        modulo0 = (histo->GetBinMin(0,hIter.GetInstanceIdentifier()) + histo->GetBinMax(0,hIter.GetInstanceIdentifier())) / 2.0;
-      }
+      if (!(this->GetChannel(c)->GetPixelType() == this->GetInput(0)->GetPixelType()))
+        mitkThrow() << "Channel " << c << " needs the pixel type of the input";
+      inImages[c] = ImageType::New();
+      mitk::CastToItkImage(this->GetChannel(c), inImages[c]);
+      if (inImages[c]->GetLargestPossibleRegion().GetNumberOfPixels() != numberOfPixels)
+        mitkThrow() << "Channel " << c << " needs the size of the input";
     }
+    outImages[c] = ImageType::New();
+    mitk::CastToItkImage(this->GetOutput(c), outImages[c]);
+    channels[c] = inImages[c]->GetBufferPointer();
   }
 
-  double value0=0;
-  switch (m_CenterMode)
+  MRNormStreamingStatistics<TPixel> statistics(channels, std::vector<const int*>(1, itkMask0->GetBufferPointer()), numberOfPixels);
+  statistics.Compute(m_CenterMode != MRNormLinearStatisticBasedFilter::MEAN);
+
+  typename MaskType::Pointer featureMask;
+  if (m_FeatureMatrix != nullptr)
   {
-  case MRNormLinearStatisticBasedFilter::MEAN:
-    value0=mean0; break;
-  case MRNormLinearStatisticBasedFilter::MEDIAN:
-    value0=median0; break;
-  case MRNormLinearStatisticBasedFilter::MODE:
-    value0=modulo0; break;
+    featureMask = MaskType::New();
+    mitk::CastToItkImage(m_FeatureMask.GetPointer(), featureMask);
+    if (featureMask->GetLargestPossibleRegion().GetNumberOfPixels() != numberOfPixels)
+      mitkThrow() << "Feature mask and image need the same size";
+    statistics.SetFeatureMask(featureMask->GetBufferPointer());
+    if (static_cast<std::size_t>(m_FeatureMatrix->rows()) != statistics.GetNumberOfFeatureRows() ||
+        static_cast<std::size_t>(m_FeatureMatrix->cols()) < m_FirstFeatureColumn + m_NumberOfChannels)
+      mitkThrow() << "The feature matrix needs " << statistics.GetNumberOfFeatureRows() << " rows and "
+                  << m_FirstFeatureColumn + m_NumberOfChannels << " columns";
   }
 
-  double offset = value0;
-  double scaling = stddev;
-  if (scaling < 0.0001)
-    return;
-
-  itk::ImageRegionIterator<ImageType> inIter(itkImage, itkImage->GetLargestPossibleRegion());
-  itk::ImageRegionIterator<ImageType> outIter(outImage, outImage->GetLargestPossibleRegion());
-  while (! inIter.IsAtEnd())
+  for (unsigned int c = 0; c < m_NumberOfChannels; ++c)
   {
-    TPixel value = inIter.Value();
-    outIter.Set((value - offset) / scaling);
-    ++inIter;
-    ++outIter;
+    const MRNormRegionStatistics &region = statistics.GetStatistics(c, 0);
+    double value0=0;
+    switch (m_CenterMode)
+    {
+    case MRNormLinearStatisticBasedFilter::MEAN:
+      value0=region.GetMean(); break;
+    case MRNormLinearStatisticBasedFilter::MEDIAN:
+      value0=region.GetMedian(); break;
+    case MRNormLinearStatisticBasedFilter::MODE:
+      value0=region.GetMode(); break;
+    }
+
+    double offset = value0;
+    double scaling = region.GetSigma();
+    if (scaling < 0.0001)
+    {
+      MITK_WARN << "Channel " << c << " has no intensity variation inside the mask and is not normalized";
+      offset = 0;
+      scaling = 1;
+    }
+
+    double* featureColumn = (m_FeatureMatrix != nullptr) ? m_FeatureMatrix->col(m_FirstFeatureColumn + c).data() : nullptr;
+    statistics.Rescale(c, offset, scaling, outImages[c]->GetBufferPointer(), featureColumn);
   }
 }
 
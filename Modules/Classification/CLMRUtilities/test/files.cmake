@@ -1,4 +1,5 @@
 set(MODULE_TESTS
   #mitkSmoothedClassProbabilitesTest.cpp
   #mitkGlobalFeaturesTest.cpp
+  mitkMRNormalizationTest.cpp
 )
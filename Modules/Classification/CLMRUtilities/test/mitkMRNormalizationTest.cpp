@@ -0,0 +1,326 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+#include "mitkIOUtil.h"
+
+#include <mitkImageCast.h>
+#include <mitkITKImageImport.h>
+#include <mitkMRNormLinearStatisticBasedFilter.h>
+#include <mitkMRNormTwoRegionBasedFilter.h>
+#include <mitkMRNormStreamingStatistics.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIterator.h>
+#include <itkLabelStatisticsImageFilter.h>
+#include <itkMinimumMaximumImageCalculator.h>
+
+class mitkMRNormalizationTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkMRNormalizationTestSuite);
+  MITK_TEST(LinearStatistic_Mean_EqualsLabelStatistics);
+  MITK_TEST(TwoRegion_Median_EqualsLabelStatistics);
+  MITK_TEST(LinearStatistic_TwoChannels_EqualSingleChannels);
+  MITK_TEST(LinearStatistic_FeatureMatrix_EqualsMaskedOutput);
+  MITK_TEST(UnsignedCharStatistics_MedianAndMode_EqualLabelStatistics);
+  MITK_TEST(ShortStatistics_MedianAndMode_EqualLabelStatistics);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  typedef itk::Image<float,3> FloatImageType;
+  typedef itk::Image<int,3> MaskImageType;
+
+  FloatImageType::Pointer m_ItkImage;
+  mitk::Image::Pointer m_Image;
+  mitk::Image::Pointer m_SecondImage;
+  mitk::Image::Pointer m_Mask1;
+  mitk::Image::Pointer m_Mask2;
+  MaskImageType::Pointer m_ItkMask1;
+  MaskImageType::Pointer m_ItkMask2;
+
+  /** Mask of all voxels with an intensity in [lower, upper). */
+  MaskImageType::Pointer ThresholdMask(float lower, float upper)
+  {
+    MaskImageType::Pointer mask = MaskImageType::New();
+    mask->CopyInformation(m_ItkImage);
+    mask->SetRegions(m_ItkImage->GetLargestPossibleRegion());
+    mask->Allocate();
+    itk::ImageRegionConstIterator<FloatImageType> it(m_ItkImage, m_ItkImage->GetLargestPossibleRegion());
+    itk::ImageRegionIterator<MaskImageType> mit(mask, mask->GetLargestPossibleRegion());
+    for (; !it.IsAtEnd(); ++it, ++mit)
+    {
+      mit.Set((it.Get() >= lower && it.Get() < upper) ? 1 : 0);
+    }
+    return mask;
+  }
+
+  static double MaximumDifference(const mitk::Image* reference, const mitk::Image* image)
+  {
+    FloatImageType::Pointer itkReference = FloatImageType::New();
+    FloatImageType::Pointer itkImage = FloatImageType::New();
+    mitk::CastToItkImage(reference, itkReference);
+    mitk::CastToItkImage(image, itkImage);
+    itk::ImageRegionConstIterator<FloatImageType> rit(itkReference, itkReference->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<FloatImageType> it(itkImage, itkImage->GetLargestPossibleRegion());
+    double difference = 0;
+    for (; !rit.IsAtEnd(); ++rit, ++it)
+    {
+      difference = std::max(difference, std::abs(double(rit.Get()) - double(it.Get())));
+    }
+    return difference;
+  }
+
+  /** Maximum difference between the output and (image - offset) / scaling. */
+  double MaximumDifferenceToRescaled(const mitk::Image* output, double offset, double scaling)
+  {
+    FloatImageType::Pointer itkOutput = FloatImageType::New();
+    mitk::CastToItkImage(output, itkOutput);
+    itk::ImageRegionConstIterator<FloatImageType> it(m_ItkImage, m_ItkImage->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<FloatImageType> oit(itkOutput, itkOutput->GetLargestPossibleRegion());
+    double difference = 0;
+    for (; !it.IsAtEnd(); ++it, ++oit)
+    {
+      difference = std::max(difference, std::abs((it.Get() - offset) / scaling - oit.Get()));
+    }
+    return difference;
+  }
+
+  /** Integer copy of the image, value * scaling + offset. */
+  template <typename TPixel>
+  typename itk::Image<TPixel, 3>::Pointer IntegerImage(float scaling, float offset)
+  {
+    typedef itk::Image<TPixel, 3> ImageType;
+    typename ImageType::Pointer image = ImageType::New();
+    image->CopyInformation(m_ItkImage);
+    image->SetRegions(m_ItkImage->GetLargestPossibleRegion());
+    image->Allocate();
+    itk::ImageRegionConstIterator<FloatImageType> it(m_ItkImage, m_ItkImage->GetLargestPossibleRegion());
+    itk::ImageRegionIterator<ImageType> iit(image, image->GetLargestPossibleRegion());
+    for (; !it.IsAtEnd(); ++it, ++iit)
+    {
+      iit.Set(static_cast<TPixel>(std::max(0.0f, std::min(255.0f, it.Get())) * scaling + offset));
+    }
+    return image;
+  }
+
+  /** Median and mode of the counted integer values compared with the former 256 bin histograms of the image range. */
+  template <typename TPixel>
+  void CheckMedianAndMode(itk::Image<TPixel, 3> *image)
+  {
+    typedef itk::Image<TPixel, 3> ImageType;
+    typename itk::MinimumMaximumImageCalculator<ImageType>::Pointer minMaxComputer = itk::MinimumMaximumImageCalculator<ImageType>::New();
+    minMaxComputer->SetImage(image);
+    minMaxComputer->Compute();
+
+    std::vector<const TPixel*> channels(1, image->GetBufferPointer());
+    std::vector<const int*> masks;
+    masks.push_back(m_ItkMask1->GetBufferPointer());
+    masks.push_back(m_ItkMask2->GetBufferPointer());
+    mitk::MRNormStreamingStatistics<TPixel> statistics(channels, masks, image->GetLargestPossibleRegion().GetNumberOfPixels());
+    statistics.Compute(true);
+
+    MaskImageType::Pointer itkMasks[2] = { m_ItkMask1, m_ItkMask2 };
+    for (unsigned int m = 0; m < 2; ++m)
+    {
+      typedef itk::LabelStatisticsImageFilter<ImageType, MaskImageType> StatisticsType;
+      typename StatisticsType::Pointer reference = StatisticsType::New();
+      reference->SetInput(image);
+      reference->SetUseHistograms(true);
+      reference->SetHistogramParameters(256, minMaxComputer->GetMinimum(), minMaxComputer->GetMaximum());
+      reference->SetLabelInput(itkMasks[m]);
+      reference->Update();
+
+      double mode = 0;
+      double maxFrequency = 0;
+      auto histogram = reference->GetHistogram(1);
+      for (auto hIter = histogram->Begin(); hIter != histogram->End(); ++hIter)
+      {
+        if (maxFrequency < hIter.GetFrequency())
+        {
+          maxFrequency = hIter.GetFrequency();
+          mode = (histogram->GetBinMin(0, hIter.GetInstanceIdentifier()) + histogram->GetBinMax(0, hIter.GetInstanceIdentifier())) / 2.0;
+        }
+      }
+
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Number of masked voxels", static_cast<std::size_t>(reference->GetCount(1)), statistics.GetStatistics(0, m).GetCount());
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Median equals the median of the label statistics", reference->GetMedian(1), statistics.GetStatistics(0, m).GetMedian(), 1e-6);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Mode equals the mode of the label statistics histogram", mode, statistics.GetStatistics(0, m).GetMode(), 1e-6);
+    }
+  }
+
+public:
+
+  void setUp() override
+  {
+    mitk::Image::Pointer image = mitk::IOUtil::LoadImage(GetTestDataFilePath("Pic3D.nrrd"));
+    mitk::CastToItkImage(image, m_ItkImage);
+    m_Image = mitk::GrabItkImageMemory(m_ItkImage);
+
+    FloatImageType::Pointer secondImage = FloatImageType::New();
+    secondImage->CopyInformation(m_ItkImage);
+    secondImage->SetRegions(m_ItkImage->GetLargestPossibleRegion());
+    secondImage->Allocate();
+    itk::ImageRegionConstIterator<FloatImageType> it(m_ItkImage, m_ItkImage->GetLargestPossibleRegion());
+    itk::ImageRegionIterator<FloatImageType> sit(secondImage, secondImage->GetLargestPossibleRegion());
+    for (; !it.IsAtEnd(); ++it, ++sit)
+    {
+      sit.Set(3.0f * it.Get() * it.Get() / 255.0f + 7.0f);
+    }
+    m_SecondImage = mitk::GrabItkImageMemory(secondImage);
+
+    m_ItkMask1 = ThresholdMask(20, 100);
+    m_ItkMask2 = ThresholdMask(100, 256);
+    m_Mask1 = mitk::GrabItkImageMemory(m_ItkMask1);
+    m_Mask2 = mitk::GrabItkImageMemory(m_ItkMask2);
+  }
+
+  void tearDown() override
+  {
+    m_ItkImage = nullptr;
+    m_Image = nullptr;
+    m_SecondImage = nullptr;
+    m_Mask1 = nullptr;
+    m_Mask2 = nullptr;
+    m_ItkMask1 = nullptr;
+    m_ItkMask2 = nullptr;
+  }
+
+  void LinearStatistic_Mean_EqualsLabelStatistics()
+  {
+    typedef itk::LabelStatisticsImageFilter<FloatImageType, MaskImageType> StatisticsType;
+    StatisticsType::Pointer statistics = StatisticsType::New();
+    statistics->SetInput(m_ItkImage);
+    statistics->SetLabelInput(m_ItkMask1);
+    statistics->Update();
+
+    mitk::MRNormLinearStatisticBasedFilter::Pointer filter = mitk::MRNormLinearStatisticBasedFilter::New();
+    filter->SetInput(m_Image);
+    filter->SetMask(m_Mask1);
+    filter->SetCenterMode(mitk::MRNormLinearStatisticBasedFilter::MEAN);
+    filter->Update();
+
+    double difference = MaximumDifferenceToRescaled(filter->GetOutput(), statistics->GetMean(1), statistics->GetSigma(1));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Output is normalized with mean and sigma of the mask", 0, difference, 1e-4);
+  }
+
+  void TwoRegion_Median_EqualsLabelStatistics()
+  {
+    // Reference: the statistics of the former implementation, 256 bins over the range of the image
+    itk::MinimumMaximumImageCalculator<FloatImageType>::Pointer minMaxComputer = itk::MinimumMaximumImageCalculator<FloatImageType>::New();
+    minMaxComputer->SetImage(m_ItkImage);
+    minMaxComputer->Compute();
+
+    typedef itk::LabelStatisticsImageFilter<FloatImageType, MaskImageType> StatisticsType;
+    StatisticsType::Pointer statistics = StatisticsType::New();
+    statistics->SetInput(m_ItkImage);
+    statistics->SetUseHistograms(true);
+    statistics->SetHistogramParameters(256, minMaxComputer->GetMinimum(), minMaxComputer->GetMaximum());
+    statistics->SetLabelInput(m_ItkMask1);
+    statistics->Update();
+    double median1 = statistics->GetMedian(1);
+    statistics->SetLabelInput(m_ItkMask2);
+    statistics->Update();
+    double median2 = statistics->GetMedian(1);
+
+    mitk::MRNormTwoRegionsBasedFilter::Pointer filter = mitk::MRNormTwoRegionsBasedFilter::New();
+    filter->SetInput(m_Image);
+    filter->SetMask1(m_Mask1);
+    filter->SetMask2(m_Mask2);
+    filter->SetArea1(mitk::MRNormTwoRegionsBasedFilter::MEDIAN);
+    filter->SetArea2(mitk::MRNormTwoRegionsBasedFilter::MEDIAN);
+    filter->Update();
+
+    double difference = MaximumDifferenceToRescaled(filter->GetOutput(), median1, median2 - median1);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Output is normalized with the medians of both masks", 0, difference, 1e-4);
+  }
+
+  void LinearStatistic_TwoChannels_EqualSingleChannels()
+  {
+    mitk::MRNormLinearStatisticBasedFilter::Pointer filter = mitk::MRNormLinearStatisticBasedFilter::New();
+    filter->SetInput(m_Image);
+    filter->SetMask(m_Mask1);
+    filter->AddChannel(m_SecondImage);
+    filter->Update();
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("One output per channel", 2u, filter->GetNumberOfChannels());
+
+    mitk::Image::Pointer channels[2] = { m_Image, m_SecondImage };
+    for (unsigned int c = 0; c < 2; ++c)
+    {
+      mitk::MRNormLinearStatisticBasedFilter::Pointer singleFilter = mitk::MRNormLinearStatisticBasedFilter::New();
+      singleFilter->SetInput(channels[c]);
+      singleFilter->SetMask(m_Mask1);
+      singleFilter->Update();
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Channel equals single channel normalization", 0, MaximumDifference(singleFilter->GetOutput(), filter->GetOutput(c)), 1e-6);
+    }
+  }
+
+  void LinearStatistic_FeatureMatrix_EqualsMaskedOutput()
+  {
+    std::size_t numberOfRows = 0;
+    itk::ImageRegionConstIterator<MaskImageType> mit(m_ItkMask2, m_ItkMask2->GetLargestPossibleRegion());
+    for (; !mit.IsAtEnd(); ++mit)
+    {
+      numberOfRows += mit.Get() > 0 ? 1 : 0;
+    }
+
+    Eigen::MatrixXd features = Eigen::MatrixXd::Zero(numberOfRows, 3);
+    mitk::MRNormLinearStatisticBasedFilter::Pointer filter = mitk::MRNormLinearStatisticBasedFilter::New();
+    filter->SetInput(m_Image);
+    filter->SetMask(m_Mask1);
+    filter->AddChannel(m_SecondImage);
+    filter->SetFeatureMatrix(&features, m_Mask2, 1);
+    filter->Update();
+
+    CPPUNIT_ASSERT_MESSAGE("Columns before the first feature column are not written", features.col(0).isZero());
+    for (unsigned int c = 0; c < 2; ++c)
+    {
+      FloatImageType::Pointer output = FloatImageType::New();
+      mitk::CastToItkImage(filter->GetOutput(c), output);
+      itk::ImageRegionConstIterator<FloatImageType> it(output, output->GetLargestPossibleRegion());
+      double difference = 0;
+      Eigen::MatrixXd::Index row = 0;
+      for (mit.GoToBegin(); !mit.IsAtEnd(); ++mit, ++it)
+      {
+        if (mit.Get() > 0)
+        {
+          difference = std::max(difference, std::abs(features(row, c + 1) - it.Get()));
+          ++row;
+        }
+      }
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Feature column equals the masked output", 0, difference, 1e-5);
+    }
+
+    Eigen::MatrixXd tooSmall(numberOfRows - 1, 3);
+    filter->SetFeatureMatrix(&tooSmall, m_Mask2, 1);
+    CPPUNIT_ASSERT_THROW(filter->Update(), mitk::Exception);
+  }
+
+  void UnsignedCharStatistics_MedianAndMode_EqualLabelStatistics()
+  {
+    itk::Image<unsigned char, 3>::Pointer image = IntegerImage<unsigned char>(1.0f, 0.0f);
+    CheckMedianAndMode<unsigned char>(image);
+  }
+
+  void ShortStatistics_MedianAndMode_EqualLabelStatistics()
+  {
+    // a range wider than the number of bins, including negative values
+    itk::Image<short, 3>::Pointer image = IntegerImage<short>(7.0f, -300.0f);
+    CheckMedianAndMode<short>(image);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkMRNormalization)
@@ -19,6 +19,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "time.h"
 #include <sstream>
 #include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include <mitkIOUtil.h>
 #include "mitkCommandLineParser.h"
@@ -28,6 +34,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkGIFFirstOrderStatistics.h>
 #include <mitkGIFVolumetricStatistics.h>
 
+#include <itkTimeProbe.h>
+
 typedef itk::Image< double, 3 >                 FloatImageType;
 typedef itk::Image< unsigned char, 3 >          MaskImageType;
 
@@ -45,13 +53,342 @@ static std::vector<double> splitDouble(std::string str, char delimiter) {
   return internal;
 }
 
+/**
+* \brief A feature class with its parameters, which creates a new calculator for every image.
+*/
+struct FeatureClass
+{
+  std::string name;
+  std::function<mitk::AbstractGlobalImageFeature::Pointer()> create;
+};
+
+static std::vector<FeatureClass> GetFeatureClasses(std::map<std::string, us::Any> & parsedArgs)
+{
+  int direction = 0;
+  if (parsedArgs.count("direction"))
+  {
+    direction = splitDouble(parsedArgs["direction"].ToString(), ';')[0];
+  }
+
+  std::vector<FeatureClass> featureClasses;
+  if (parsedArgs.count("first-order"))
+  {
+    featureClasses.push_back({ "first order statistics", []() -> mitk::AbstractGlobalImageFeature::Pointer
+    {
+      return mitk::GIFFirstOrderStatistics::New().GetPointer();
+    } });
+  }
+  if (parsedArgs.count("volume"))
+  {
+    featureClasses.push_back({ "volumetric", []() -> mitk::AbstractGlobalImageFeature::Pointer
+    {
+      return mitk::GIFVolumetricStatistics::New().GetPointer();
+    } });
+  }
+  if (parsedArgs.count("cooccurence"))
+  {
+    auto ranges = splitDouble(parsedArgs["cooccurence"].ToString(),';');
+    for (std::size_t i = 0; i < ranges.size(); ++i)
+    {
+      double range = ranges[i];
+      std::stringstream name;
+      name << "coocurence with range " << range;
+      featureClasses.push_back({ name.str(), [range, direction]() -> mitk::AbstractGlobalImageFeature::Pointer
+      {
+        mitk::GIFCooccurenceMatrix::Pointer coocCalculator = mitk::GIFCooccurenceMatrix::New();
+        coocCalculator->SetRange(range);
+        coocCalculator->SetDirection(direction);
+        return coocCalculator.GetPointer();
+      } });
+    }
+  }
+  if (parsedArgs.count("run-length"))
+  {
+    auto ranges = splitDouble(parsedArgs["run-length"].ToString(),';');
+    for (std::size_t i = 0; i < ranges.size(); ++i)
+    {
+      double range = ranges[i];
+      std::stringstream name;
+      name << "run-length with number of bins " << range;
+      featureClasses.push_back({ name.str(), [range]() -> mitk::AbstractGlobalImageFeature::Pointer
+      {
+        mitk::GIFGrayLevelRunLength::Pointer calculator = mitk::GIFGrayLevelRunLength::New();
+        calculator->SetRange(range);
+        return calculator.GetPointer();
+      } });
+    }
+  }
+  return featureClasses;
+}
+
+/**
+* \brief Checks that image and mask share origin and spacing. If fixDifferentSpaces is set, the image is moved into the space of the mask.
+*/
+static bool MatchSpaces(mitk::Image::Pointer image, mitk::Image::Pointer mask, bool fixDifferentSpaces)
+{
+  if ( ! mitk::Equal(mask->GetGeometry(0)->GetOrigin(), image->GetGeometry(0)->GetOrigin()))
+  {
+    MITK_INFO << "Not equal Origins";
+    if (fixDifferentSpaces)
+    {
+      image->GetGeometry(0)->SetOrigin(mask->GetGeometry(0)->GetOrigin());
+    } else
+    {
+      return false;
+    }
+  }
+  if ( ! mitk::Equal(mask->GetGeometry(0)->GetSpacing(), image->GetGeometry(0)->GetSpacing()))
+  {
+    MITK_INFO << "Not equal Sapcings";
+    if (fixDifferentSpaces)
+    {
+      image->GetGeometry(0)->SetSpacing(mask->GetGeometry(0)->GetSpacing());
+    } else
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+* \brief State of one case of the batch mode. The image, mask and cache are released as soon as all feature classes are calculated.
+*/
+struct BatchCase
+{
+  std::string imagePath;
+  std::string maskPath;
+  std::string description;
+
+  std::mutex mutex;
+  bool loaded = false;
+  bool failed = false;
+  bool finished = false;
+  std::size_t remainingFeatureClasses = 0;
+  std::unique_ptr<mitk::GlobalImageFeatureCache> cache;
+
+  double loadingTime = 0;
+  mitk::GlobalImageFeatureCache::StageTimesType preprocessingTimes;
+  std::vector<mitk::AbstractGlobalImageFeature::FeatureListType> results;
+  std::vector<double> featureClassTimes;
+};
+
+/**
+* \brief Calculates the feature classes of all cases in the case list with a pool of threads.
+*
+* Each case is split into one task per feature class. The threads take the tasks in order, so the feature
+* classes of a case are calculated in parallel and only a few cases are loaded at the same time. All
+* feature classes of a case share one GlobalImageFeatureCache. The rows of the finished cases are written
+* in the order of the case list as soon as all previous cases are finished. The time of each stage is
+* written to <output>.timing.
+*/
+static int RunBatch(const std::string & caseListPath, const std::string & outputPath, const std::vector<FeatureClass> & featureClasses,
+                    bool fixDifferentSpaces, bool writeHeader, unsigned int numberOfThreads)
+{
+  std::vector<std::unique_ptr<BatchCase> > cases;
+  std::ifstream caseList(caseListPath);
+  if (!caseList.is_open())
+  {
+    MITK_ERROR << "Could not open case list " << caseListPath;
+    return EXIT_FAILURE;
+  }
+  std::string line;
+  while (std::getline(caseList, line))
+  {
+    if (line.empty() || line[0] == '#')
+      continue;
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, ';'))
+      fields.push_back(field);
+    if (fields.size() < 2)
+    {
+      MITK_ERROR << "Skipping invalid line of the case list: " << line;
+      continue;
+    }
+    std::unique_ptr<BatchCase> batchCase(new BatchCase);
+    batchCase->imagePath = fields[0];
+    batchCase->maskPath = fields[1];
+    batchCase->description = fields.size() > 2 ? fields[2] : fields[0];
+    batchCase->remainingFeatureClasses = featureClasses.size();
+    batchCase->results.resize(featureClasses.size());
+    batchCase->featureClassTimes.resize(featureClasses.size(), 0);
+    cases.push_back(std::move(batchCase));
+  }
+  if (cases.empty() || featureClasses.empty())
+  {
+    MITK_ERROR << "No cases or no feature classes given";
+    return EXIT_FAILURE;
+  }
+
+  std::ofstream output(outputPath, std::ios::app);
+  std::ofstream timing(outputPath + ".timing");
+  timing << "Description;Loading;Mask casting;Minimum/Maximum;";
+  for (std::size_t i = 0; i < featureClasses.size(); ++i)
+  {
+    timing << featureClasses[i].name << ";";
+  }
+  timing << std::endl;
+
+  // The readers are not guaranteed to be thread safe, so only one case is loaded at a time.
+  std::mutex loadMutex;
+  std::mutex outputMutex;
+  std::size_t nextRow = 0;
+  std::size_t numberOfFailedCases = 0;
+  bool headerWritten = !writeHeader;
+
+  auto writeFinishedRows = [&]()
+  {
+    while (nextRow < cases.size() && cases[nextRow]->finished)
+    {
+      BatchCase & batchCase = *cases[nextRow++];
+      if (batchCase.failed)
+      {
+        ++numberOfFailedCases;
+        continue;
+      }
+
+      if (!headerWritten)
+      {
+        output << "Description" << ";";
+        for (auto & results : batchCase.results)
+          for (auto & feature : results)
+            output << feature.first << ";";
+        output << std::endl;
+        headerWritten = true;
+      }
+      output << batchCase.description << ";";
+      for (auto & results : batchCase.results)
+        for (auto & feature : results)
+          output << feature.second << ";";
+      output << std::endl;
+
+      timing << batchCase.description << ";" << batchCase.loadingTime << ";" << batchCase.preprocessingTimes["Mask casting"] << ";" << batchCase.preprocessingTimes["Minimum/Maximum"] << ";";
+      for (double seconds : batchCase.featureClassTimes)
+        timing << seconds << ";";
+      timing << std::endl;
+
+      batchCase.results.clear();
+    }
+  };
+
+  const std::size_t numberOfTasks = cases.size() * featureClasses.size();
+  std::atomic<std::size_t> nextTask(0);
+  auto worker = [&]()
+  {
+    for (std::size_t task = nextTask++; task < numberOfTasks; task = nextTask++)
+    {
+      BatchCase & batchCase = *cases[task / featureClasses.size()];
+      const std::size_t featureClass = task % featureClasses.size();
+
+      mitk::GlobalImageFeatureCache * cache = nullptr;
+      {
+        std::lock_guard<std::mutex> lock(batchCase.mutex);
+        if (!batchCase.loaded)
+        {
+          batchCase.loaded = true;
+          try
+          {
+            itk::TimeProbe clock;
+            clock.Start();
+            mitk::Image::Pointer image, mask;
+            {
+              std::lock_guard<std::mutex> loadLock(loadMutex);
+              image = mitk::IOUtil::LoadImage(batchCase.imagePath);
+              mask = mitk::IOUtil::LoadImage(batchCase.maskPath);
+            }
+            clock.Stop();
+            batchCase.loadingTime = clock.GetTotal();
+            if (MatchSpaces(image, mask, fixDifferentSpaces))
+            {
+              batchCase.cache.reset(new mitk::GlobalImageFeatureCache(image, mask));
+            } else
+            {
+              MITK_ERROR << "Image and mask of case " << batchCase.description << " are not in the same space";
+              batchCase.failed = true;
+            }
+          }
+          catch (const std::exception & e)
+          {
+            MITK_ERROR << "Could not load case " << batchCase.description << ": " << e.what();
+            batchCase.failed = true;
+          }
+        }
+        cache = batchCase.cache.get();
+      }
+
+      if (cache != nullptr)
+      {
+        try
+        {
+          itk::TimeProbe clock;
+          clock.Start();
+          mitk::AbstractGlobalImageFeature::Pointer calculator = featureClasses[featureClass].create();
+          calculator->SetCache(cache);
+          auto localResults = calculator->CalculateFeatures(cache->GetImage(), cache->GetMask());
+          clock.Stop();
+
+          std::lock_guard<std::mutex> lock(batchCase.mutex);
+          batchCase.results[featureClass] = localResults;
+          batchCase.featureClassTimes[featureClass] = clock.GetTotal();
+        }
+        catch (const std::exception & e)
+        {
+          MITK_ERROR << "Could not calculate " << featureClasses[featureClass].name << " of case " << batchCase.description << ": " << e.what();
+          std::lock_guard<std::mutex> lock(batchCase.mutex);
+          batchCase.failed = true;
+        }
+      }
+
+      bool caseFinished = false;
+      {
+        std::lock_guard<std::mutex> lock(batchCase.mutex);
+        caseFinished = --batchCase.remainingFeatureClasses == 0;
+        if (caseFinished && batchCase.cache)
+        {
+          batchCase.preprocessingTimes = batchCase.cache->GetStageTimes();
+          batchCase.cache.reset();
+        }
+      }
+      if (caseFinished)
+      {
+        MITK_INFO << "Finished case " << batchCase.description;
+        std::lock_guard<std::mutex> lock(outputMutex);
+        batchCase.finished = true;
+        writeFinishedRows();
+      }
+    }
+  };
+
+  MITK_INFO << "Calculating " << featureClasses.size() << " feature classes of " << cases.size() << " cases with " << numberOfThreads << " threads....";
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < numberOfThreads; ++i)
+  {
+    threads.push_back(std::thread(worker));
+  }
+  for (auto & thread : threads)
+  {
+    thread.join();
+  }
+  output.close();
+  timing.close();
+
+  if (numberOfFailedCases > 0)
+  {
+    MITK_ERROR << numberOfFailedCases << " of " << cases.size() << " cases failed";
+    return EXIT_FAILURE;
+  }
+  return 0;
+}
+
 int main(int argc, char* argv[])
 {
   mitkCommandLineParser parser;
   parser.setArgumentPrefix("--", "-");
   // required params
-  parser.addArgument("image", "i", mitkCommandLineParser::InputImage, "Input Image", "Path to the input VTK polydata", us::Any(), false);
-  parser.addArgument("mask", "m", mitkCommandLineParser::InputImage, "Input Mask", "Mask Image that specifies the area over for the statistic, (Values = 1)", us::Any(), false);
+  parser.addArgument("image", "i", mitkCommandLineParser::InputImage, "Input Image", "Path to the input VTK polydata", us::Any());
+  parser.addArgument("mask", "m", mitkCommandLineParser::InputImage, "Input Mask", "Mask Image that specifies the area over for the statistic, (Values = 1)", us::Any());
   parser.addArgument("output", "o", mitkCommandLineParser::OutputFile, "Output text file", "Target file. The output statistic is appended to this file.", us::Any(), false);
 
   parser.addArgument("cooccurence","cooc",mitkCommandLineParser::String, "Use Co-occurence matrix", "calculates Co-occurence based features",us::Any());
@@ -62,6 +399,8 @@ int main(int argc, char* argv[])
   parser.addArgument("description","d",mitkCommandLineParser::String,"Text","Description that is added to the output",us::Any());
   parser.addArgument("same-space", "sp", mitkCommandLineParser::String, "Bool", "Set the spacing of all images to equal. Otherwise an error will be thrown. ", us::Any());
   parser.addArgument("direction", "dir", mitkCommandLineParser::String, "Int", "Allows to specify the direction for Cooc and RL. 0: All directions, 1: Only single direction (Test purpose), 2,3,4... Without dimension 0,1,2... ", us::Any());
+  parser.addArgument("cases", "c", mitkCommandLineParser::InputFile, "Case list", "Text file with one case per line (image;mask;description). Replaces --image and --mask, all cases are written to one table.", us::Any());
+  parser.addArgument("threads", "t", mitkCommandLineParser::Int, "Threads", "Number of threads used for the cases of the case list. Default: number of cores", us::Any());
 
   // Miniapp Infos
   parser.setCategory("Classification Tools");
@@ -82,102 +421,44 @@ int main(int argc, char* argv[])
 
   MITK_INFO << "Version: "<< 1.3;
 
-  bool useCooc = parsedArgs.count("cooccurence");
-
-  mitk::Image::Pointer image = mitk::IOUtil::LoadImage(parsedArgs["image"].ToString());
-  mitk::Image::Pointer mask = mitk::IOUtil::LoadImage(parsedArgs["mask"].ToString());
-
   bool fixDifferentSpaces = parsedArgs.count("same-space");
-  if ( ! mitk::Equal(mask->GetGeometry(0)->GetOrigin(), image->GetGeometry(0)->GetOrigin()))
-  {
-    MITK_INFO << "Not equal Origins";
-    if (fixDifferentSpaces)
-    {
-      image->GetGeometry(0)->SetOrigin(mask->GetGeometry(0)->GetOrigin());
-    } else
-    {
-      return -1;
-    }
-  }
-  if ( ! mitk::Equal(mask->GetGeometry(0)->GetSpacing(), image->GetGeometry(0)->GetSpacing()))
+  std::vector<FeatureClass> featureClasses = GetFeatureClasses(parsedArgs);
+
+  if (parsedArgs.count("cases"))
   {
-    MITK_INFO << "Not equal Sapcings";
-    if (fixDifferentSpaces)
+    unsigned int numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+    if (parsedArgs.count("threads"))
     {
-      image->GetGeometry(0)->SetSpacing(mask->GetGeometry(0)->GetSpacing());
-    } else
-    {
-      return -1;
+      numberOfThreads = std::max(1, us::any_cast<int>(parsedArgs["threads"]));
     }
+    return RunBatch(parsedArgs["cases"].ToString(), parsedArgs["output"].ToString(), featureClasses, fixDifferentSpaces, parsedArgs.count("header"), numberOfThreads);
   }
 
-  int direction = 0;
-  if (parsedArgs.count("direction"))
+  if (!parsedArgs.count("image") || !parsedArgs.count("mask"))
   {
-    direction = splitDouble(parsedArgs["direction"].ToString(), ';')[0];
-  }
-
-  mitk::AbstractGlobalImageFeature::FeatureListType stats;
-  ////////////////////////////////////////////////////////////////
-  // CAlculate First Order Features
-  ////////////////////////////////////////////////////////////////
-  if (parsedArgs.count("first-order"))
-  {
-    MITK_INFO << "Start calculating first order statistics....";
-    mitk::GIFFirstOrderStatistics::Pointer firstOrderCalculator = mitk::GIFFirstOrderStatistics::New();
-    auto localResults = firstOrderCalculator->CalculateFeatures(image, mask);
-    stats.insert(stats.end(), localResults.begin(), localResults.end());
-    MITK_INFO << "Finished calculating first order statistics....";
+    MITK_ERROR << "Either --image and --mask or --cases are required";
+    return EXIT_FAILURE;
   }
 
-  ////////////////////////////////////////////////////////////////
-  // CAlculate Volume based Features
-  ////////////////////////////////////////////////////////////////
-  if (parsedArgs.count("volume"))
-  {
-    MITK_INFO << "Start calculating volumetric ....";
-    mitk::GIFVolumetricStatistics::Pointer volCalculator = mitk::GIFVolumetricStatistics::New();
-    auto localResults = volCalculator->CalculateFeatures(image, mask);
-    stats.insert(stats.end(), localResults.begin(), localResults.end());
-    MITK_INFO << "Finished calculating volumetric....";
-  }
+  mitk::Image::Pointer image = mitk::IOUtil::LoadImage(parsedArgs["image"].ToString());
+  mitk::Image::Pointer mask = mitk::IOUtil::LoadImage(parsedArgs["mask"].ToString());
 
-  ////////////////////////////////////////////////////////////////
-  // CAlculate Co-occurence Features
-  ////////////////////////////////////////////////////////////////
-  if (parsedArgs.count("cooccurence"))
+  if (!MatchSpaces(image, mask, fixDifferentSpaces))
   {
-    auto ranges = splitDouble(parsedArgs["cooccurence"].ToString(),';');
-
-    for (int i = 0; i < ranges.size(); ++i)
-    {
-      MITK_INFO << "Start calculating coocurence with range " << ranges[i] << "....";
-      mitk::GIFCooccurenceMatrix::Pointer coocCalculator = mitk::GIFCooccurenceMatrix::New();
-      coocCalculator->SetRange(ranges[i]);
-      coocCalculator->SetDirection(direction);
-      auto localResults = coocCalculator->CalculateFeatures(image, mask);
-      stats.insert(stats.end(), localResults.begin(), localResults.end());
-      MITK_INFO << "Finished calculating coocurence with range " << ranges[i] << "....";
-    }
+    return -1;
   }
 
-  ////////////////////////////////////////////////////////////////
-  // CAlculate Run-Length Features
-  ////////////////////////////////////////////////////////////////
-  if (parsedArgs.count("run-length"))
+  // All feature classes share the mask casts and the intensity range of the image
+  mitk::GlobalImageFeatureCache cache(image, mask);
+  mitk::AbstractGlobalImageFeature::FeatureListType stats;
+  for (auto & featureClass : featureClasses)
   {
-    auto ranges = splitDouble(parsedArgs["run-length"].ToString(),';');
-
-    for (int i = 0; i < ranges.size(); ++i)
-    {
-      MITK_INFO << "Start calculating run-length with number of bins " << ranges[i] << "....";
-      mitk::GIFGrayLevelRunLength::Pointer calculator = mitk::GIFGrayLevelRunLength::New();
-      calculator->SetRange(ranges[i]);
-
-      auto localResults = calculator->CalculateFeatures(image, mask);
-      stats.insert(stats.end(), localResults.begin(), localResults.end());
-      MITK_INFO << "Finished calculating run-length with number of bins " << ranges[i] << "....";
-    }
+    MITK_INFO << "Start calculating " << featureClass.name << "....";
+    mitk::AbstractGlobalImageFeature::Pointer calculator = featureClass.create();
+    calculator->SetCache(&cache);
+    auto localResults = calculator->CalculateFeatures(image, mask);
+    stats.insert(stats.end(), localResults.begin(), localResults.end());
+    MITK_INFO << "Finished calculating " << featureClass.name << "....";
   }
   for (int i = 0; i < stats.size(); ++i)
   {
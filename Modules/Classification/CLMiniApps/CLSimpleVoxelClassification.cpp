@@ -200,21 +200,16 @@ int main(int argc, char* argv[])
   forest->Train(trainDataX, trainDataY);
 
 
-  // prepare feature matrix for test case
-  auto testDataX = mitk::DCUtilities::DC3dDToMatrixXd(testCollection,features, classMap);
-  auto testDataNewY = forest->Predict(testDataX);
-
-
-  mitk::DCUtilities::MatrixToDC3d(testDataNewY, testCollection, "RESULT", classMap);
-
-  Eigen::MatrixXd Probs = forest->GetPointWiseProbabilities();
-
-
-  Eigen::MatrixXd prob0 = Probs.col(0);
-  Eigen::MatrixXd prob1 = Probs.col(1);
-
-  mitk::DCUtilities::MatrixToDC3d(prob0, testCollection,"prob0", classMap);
-  mitk::DCUtilities::MatrixToDC3d(prob1, testCollection,"prob1", classMap);
+  // predict the test case block by block, without building the feature matrix of all voxels
+  std::vector<std::string> probabilityNames;
+  probabilityNames.push_back("prob0");
+  probabilityNames.push_back("prob1");
+  mitk::DCUtilities::ProcessBlockwise(testCollection, features, classMap, "RESULT", probabilityNames, 100000,
+    [&forest](const Eigen::MatrixXd &X, Eigen::MatrixXi &Y, Eigen::MatrixXd &P)
+  {
+    Y = forest->Predict(X);
+    P = forest->GetPointWiseProbabilities();
+  });
 
 
   std::vector<std::string> outputFilter;
@@ -17,7 +17,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #define mitkForest_cpp
 
 #include "time.h"
+#include <algorithm>
 #include <sstream>
+#include <random>
+#include <thread>
 
 #include <mitkConfigFileReader.h>
 #include <mitkDataCollection.h>
@@ -29,6 +32,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkIOUtil.h>
 
 #include <mitkDataCollectionUtilities.h>
+#include <mitkFeatureSampleStore.h>
 #include <mitkRandomForestIO.h>
 
 // ----------------------- Forest Handling ----------------------
@@ -141,6 +145,9 @@ int main(int argc, char* argv[])
     }
     int maximumTreeDepth =  allConfig.IntValue("Forest", "Maximum Tree Depth",10000);
     int randomSplit = allConfig.IntValue("Forest","Use RandomSplit",0);
+    // 0 trains on the feature matrix of all training voxels, otherwise each tree is trained on its own sample drawn from disk
+    bool trainFromDisk = allConfig.IntValue("Forest", "Train from disk", 0);
+    int maximumSamplesPerLabel = allConfig.IntValue("Forest", "Maximum Samples per Label", 0);
     //////////////////////////////////////////////////////////////////////////////
     // Read Statistic Parameter
     //////////////////////////////////////////////////////////////////////////////
@@ -185,7 +192,7 @@ int main(int argc, char* argv[])
     colReader->SetDataItemNames(usedModalities);
     //colReader->SetNames(usedModalities);
     mitk::DataCollection::Pointer trainCollection;
-    if (doTraining)
+    if (doTraining && !trainFromDisk)
     {
       trainCollection = colReader->LoadCollection(trainingCollectionPath);
     }
@@ -232,7 +239,31 @@ int main(int argc, char* argv[])
 
     // TOOD forest.UseRandomSplit(randomSplit);
 
-    if (doTraining)
+    if (doTraining && trainFromDisk)
+    {
+      // the training cases are loaded in groups, only their (sampled) voxels are kept on disk
+      mitk::FeatureSampleStore store(outputFolder + "/training_samples", modalities.size(), maximumSamplesPerLabel);
+      std::vector<std::string> caseItems(modalities);
+      caseItems.push_back(trainMask);
+      const std::size_t casesPerLoad = std::max(1u, std::thread::hardware_concurrency());
+      for (std::size_t first = 0; first < trainPatients.size(); first += casesPerLoad)
+      {
+        mitk::CollectionReader caseReader;
+        caseReader.AddDataElementIds(std::vector<std::string>(trainPatients.begin() + first, trainPatients.begin() + std::min(first + casesPerLoad, trainPatients.size())));
+        caseReader.SetDataItemNames(caseItems);
+        store.AddCollection(caseReader.LoadCollection(trainingCollectionPath), modalities, trainMask);
+      }
+
+      // one batch per tree: the store draws the bootstrap sample of each tree, which is then used completely
+      std::mt19937 generator(currentRun);
+      forest->SetSamplesPerTree(1.0);
+      forest->UseSampleWithReplacement(false);
+      forest->TrainBatchwise([&](int, Eigen::MatrixXd &X, Eigen::MatrixXi &Y)
+      {
+        store.DrawBatch(samplesPerTree, sampleWithReplacement, generator, X, Y);
+      }, numberOfTrees);
+    }
+    else if (doTraining)
     {
       // 0 = LR-Estimation
       // 1 = KNN-Estimation
@@ -338,11 +369,12 @@ int main(int argc, char* argv[])
     //////////////////////////////////////////////////////////////////////////////
     // If required do test
     //////////////////////////////////////////////////////////////////////////////
-    auto testDataX = mitk::DCUtilities::DC3dDToMatrixXd(testCollection,modalities, testMask);
-    auto testDataNewY = forest->Predict(testDataX);
-    //MITK_INFO << testDataNewY;
-
-    mitk::DCUtilities::MatrixToDC3d(testDataNewY, testCollection, resultMask, testMask);
+    // the test voxels are predicted block by block, without building the feature matrix of all voxels
+    mitk::DCUtilities::ProcessBlockwise(testCollection, modalities, testMask, resultMask, std::vector<std::string>(), 100000,
+      [&forest](const Eigen::MatrixXd &X, Eigen::MatrixXi &Y, Eigen::MatrixXd &/*P*/)
+    {
+      Y = forest->Predict(X);
+    });
     //forest.SetMaskName(testMask);
     //forest.SetCollection(testCollection);
     //forest.Test();
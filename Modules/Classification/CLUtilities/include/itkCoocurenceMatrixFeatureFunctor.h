@@ -6,6 +6,8 @@
 #include <itkHistogramToTextureFeaturesFilter.h>
 #include <itkHistogram.h>
 #include <bitset>
+#include <algorithm>
+#include <vector>
 
 /*
  * To Do:
@@ -31,6 +33,7 @@ public:
   typedef typename TNeighborhoodType::OffsetType                                          OffsetType;
   typedef typename HistogramType::SizeType                                                SizeType;
   typedef typename HistogramType::MeasurementVectorType                                   MeasurementVectorType;
+  typedef typename HistogramType::IndexType                                               HistogramIndexType;
   typedef typename itk::Statistics::HistogramToTextureFeaturesFilter<HistogramType>       HistoToFeatureFilter;
 
   static const unsigned int OutputCount = 8;
@@ -124,9 +127,22 @@ public:
     return offsetMap;
   }
 
+  /** Co-occurrence counts of the window for the incremental mode of the NeighborhoodFunctorImageFilter,
+   * one histogram per direction. */
+  struct AccumulatorType
+  {
+    std::vector<OffsetType>             offsets;
+    std::vector<HistogramType::Pointer> histograms;
+    MeasurementVectorType               cooccur;
+    HistogramIndexType                  index;
+  };
+
   int                                   m_DirectionFlags;
   std::map<OffsetDirection, OffsetType> m_offsetMap;
   unsigned int                          m_levels;
+  bool                                  m_UseFixedRange;
+  double                                m_RangeMin;
+  double                                m_RangeMax;
 
   void DirectionFlags(int flags)
   {
@@ -143,10 +159,23 @@ public:
     m_levels = lvl;
   }
 
+  /** Uses the same histogram range for all windows instead of the minimum and maximum of each window.
+   * Values outside of the range are counted in the first or last bin. The bins of a pixel are then
+   * independent of the window, which is required for the incremental mode. */
+  void SetRange(double min, double max)
+  {
+    m_UseFixedRange = true;
+    m_RangeMin = min;
+    m_RangeMax = max;
+  }
+
   NeighborhoodCooccurenceMatrix()
   {
     m_offsetMap = CreateStdOffsets();
     m_levels = 5;
+    m_UseFixedRange = false;
+    m_RangeMin = 0;
+    m_RangeMax = 0;
     m_DirectionFlags =
         DIR_x1_x0_x0; /*| DIR_x1_x1_x0 | DIR_x0_x1_x0 |
         DIR_n1_x1_x0 | DIR_x1_x0_x1 | DIR_x1_x1_x1 |
@@ -159,6 +188,15 @@ public:
 
   inline OutputVectorType operator()(const TNeighborhoodType & it) const
   {
+    if (m_UseFixedRange)
+    {
+      AccumulatorType accumulator;
+      this->Clear(accumulator);
+      for (unsigned int i = 0; i < it.Size(); ++i)
+        this->Add(accumulator, it, i);
+      return this->Compute(accumulator);
+    }
+
     double min = std::numeric_limits<double>::max();
     double max = std::numeric_limits<double>::min();
     for (unsigned int i = 0; i < it.Size(); ++i)
@@ -228,24 +266,121 @@ public:
 
       //To do Normalize GLCM N_g Number of levels
 
-      HistoToFeatureFilter::Pointer filter = HistoToFeatureFilter::New();
-      filter->SetInput(histogram);
-      filter->Update();
-
-      output_vector[ENERGY] += filter->GetEnergy();
-      output_vector[ENTROPY] += filter->GetEntropy();
-      output_vector[CORRELATION] += filter->GetCorrelation();
-      output_vector[INERTIA] += filter->GetInertia();
-      output_vector[CLUSTERSHADE] += filter->GetClusterShade();
-      output_vector[CLUSTERPROMINENCE] += filter->GetClusterProminence();
-      output_vector[HARALICKCORRELATION] += filter->GetHaralickCorrelation();
-      output_vector[INVERSEDIFFERENCEMOMENT] += filter->GetInverseDifferenceMoment();
+      AddFeatures(output_vector, histogram);
     }
 
     //std::cout << "Number of directions " << div_num_dirs << std::endl;
 //    output_vector /= div_num_dirs;
     return output_vector;
   }
+
+  bool IsIncremental() const
+  {
+    return m_UseFixedRange;
+  }
+
+  void Clear(AccumulatorType & accumulator) const
+  {
+    if (accumulator.histograms.empty())
+    {
+      SizeType size;
+      size.SetSize(2);
+      size.Fill(m_levels);
+
+      MeasurementVectorType minBorder;
+      minBorder.SetSize(2);
+      minBorder.Fill(m_RangeMin);
+
+      MeasurementVectorType maxBorder;
+      maxBorder.SetSize(2);
+      maxBorder.Fill(m_RangeMax);
+
+      for(typename std::map<OffsetDirection,OffsetType>::const_iterator dir_it = m_offsetMap.begin(),
+          end = m_offsetMap.end(); dir_it != end; dir_it ++)
+      {
+        if(! (dir_it->first & m_DirectionFlags))
+          continue;
+
+        HistogramType::Pointer histogram = HistogramType::New();
+        histogram->SetMeasurementVectorSize(2);
+        histogram->Initialize(size, minBorder, maxBorder);
+        accumulator.offsets.push_back(dir_it->second);
+        accumulator.histograms.push_back(histogram);
+      }
+      accumulator.cooccur.SetSize(2);
+    }
+    else
+    {
+      for (unsigned int d = 0; d < accumulator.histograms.size(); ++d)
+        accumulator.histograms[d]->SetToZero();
+    }
+  }
+
+  void Add(AccumulatorType & accumulator, const NeighborhoodType & it, unsigned int i) const
+  {
+    CountPairs(accumulator, it, i, true);
+  }
+
+  void Remove(AccumulatorType & accumulator, const NeighborhoodType & it, unsigned int i) const
+  {
+    CountPairs(accumulator, it, i, false);
+  }
+
+  inline OutputVectorType Compute(const AccumulatorType & accumulator) const
+  {
+    OutputVectorType output_vector;
+    output_vector.fill(0);
+    for (unsigned int d = 0; d < accumulator.histograms.size(); ++d)
+      AddFeatures(output_vector, accumulator.histograms[d]);
+
+    // windows with a single gray value have no correlation
+    for (unsigned int f = 0; f < OutputCount; ++f)
+      if (output_vector[f] != output_vector[f])
+        output_vector[f] = 0;
+    return output_vector;
+  }
+
+private:
+
+  /** Counts the pairs of pixel i and its neighbor in each direction, in both orders. */
+  void CountPairs(AccumulatorType & accumulator, const NeighborhoodType & it, unsigned int i, bool add) const
+  {
+    double value = std::max(m_RangeMin, std::min(m_RangeMax, static_cast<double>(it.GetPixel(i))));
+    for (unsigned int d = 0; d < accumulator.histograms.size(); ++d)
+    {
+      HistogramType * histogram = accumulator.histograms[d];
+      double neighbor = it.GetImagePointer()->GetPixel(it.GetIndex(i)+accumulator.offsets[d]);
+      neighbor = std::max(m_RangeMin, std::min(m_RangeMax, neighbor));
+
+      accumulator.cooccur[0] = value;
+      accumulator.cooccur[1] = neighbor;
+      for (unsigned int order = 0; order < 2; ++order)
+      {
+        histogram->GetIndex(accumulator.cooccur, accumulator.index);
+        if (add)
+          histogram->IncreaseFrequencyOfIndex(accumulator.index, 1);
+        else
+          histogram->SetFrequencyOfIndex(accumulator.index, histogram->GetFrequency(accumulator.index) - 1);
+        std::swap(accumulator.cooccur[0],accumulator.cooccur[1]);
+      }
+    }
+  }
+
+  static void AddFeatures(OutputVectorType & output_vector, HistogramType * histogram)
+  {
+    HistoToFeatureFilter::Pointer filter = HistoToFeatureFilter::New();
+    filter->SetInput(histogram);
+    filter->Update();
+
+    output_vector[ENERGY] += filter->GetEnergy();
+    output_vector[ENTROPY] += filter->GetEntropy();
+    output_vector[CORRELATION] += filter->GetCorrelation();
+    output_vector[INERTIA] += filter->GetInertia();
+    output_vector[CLUSTERSHADE] += filter->GetClusterShade();
+    output_vector[CLUSTERPROMINENCE] += filter->GetClusterProminence();
+    output_vector[HARALICKCORRELATION] += filter->GetHaralickCorrelation();
+    output_vector[INVERSEDIFFERENCEMOMENT] += filter->GetInverseDifferenceMoment();
+  }
 };
 
 }// end namespace functor
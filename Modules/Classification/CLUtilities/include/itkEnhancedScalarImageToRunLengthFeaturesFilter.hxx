@@ -149,21 +149,27 @@ namespace itk
         ++voxelCountIter;
       }
 
-      // For each offset, calculate each feature
+      // The matrices of all offsets are computed at once
+      OffsetVectorPointer offsets = OffsetVector::New();
       typename OffsetVector::ConstIterator offsetIt;
+      for( offsetIt = this->m_Offsets->Begin(); offsetIt != this->m_Offsets->End(); offsetIt++ )
+      {
+        offsets->push_back( offsetIt.Value() );
+      }
+      this->m_RunLengthMatrixGenerator->SetOffsets( offsets );
+      std::vector< typename RunLengthMatrixFilterType::HistogramPointer > matrices;
+      this->m_RunLengthMatrixGenerator->ComputeRunLengthMatrices( matrices );
+
+      // For each offset, calculate each feature
       int offsetNum, featureNum;
       typedef typename RunLengthFeaturesFilterType::RunLengthFeatureName
         InternalRunLengthFeatureName;
 
-      for( offsetIt = this->m_Offsets->Begin(), offsetNum = 0;
-        offsetIt != this->m_Offsets->End(); offsetIt++, offsetNum++ )
+      for( offsetNum = 0; offsetNum < numOffsets; offsetNum++ )
       {
-        this->m_RunLengthMatrixGenerator->SetOffset( offsetIt.Value() );
-        this->m_RunLengthMatrixGenerator->Update();
         typename RunLengthFeaturesFilterType::Pointer runLengthMatrixCalculator =
           RunLengthFeaturesFilterType::New();
-        runLengthMatrixCalculator->SetInput(
-          this->m_RunLengthMatrixGenerator->GetOutput() );
+        runLengthMatrixCalculator->SetInput( matrices[offsetNum] );
         runLengthMatrixCalculator->SetNumberOfVoxels(numberOfVoxels);
         runLengthMatrixCalculator->Update();
 
@@ -39,6 +39,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkNumericTraits.h"
 #include "itkVectorContainer.h"
 
+#include <vector>
+
 namespace itk
 {
   namespace Statistics
@@ -238,6 +240,14 @@ namespace itk
       /** method to get the Histogram */
       const HistogramType * GetOutput() const;
 
+      /**
+      * Computes one run length matrix for each of the offsets, independent of the pipeline.
+      * Runs only interact along lines in the direction of the offset, so the lines crossing the
+      * bounding box of the mask are scanned one by one and the offsets are processed in parallel.
+      * Each matrix equals the output of the filter for the single offset.
+      */
+      void ComputeRunLengthMatrices( std::vector<HistogramPointer> & matrices );
+
       /**
       * Set the pixel value of the mask that should be considered "inside" the
       * object. Defaults to 1.
@@ -37,10 +37,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkEnhancedScalarImageToRunLengthMatrixFilter.h"
 
 #include "itkConstNeighborhoodIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkNeighborhood.h"
 #include "vnl/vnl_math.h"
 #include "itkMacro.h"
 
+#include <algorithm>
+#include <map>
+
 namespace itk
 {
   namespace Statistics
@@ -329,6 +333,245 @@ namespace itk
       }
     }
 
+    template<typename TImageType, typename THistogramFrequencyContainer>
+    void
+      EnhancedScalarImageToRunLengthMatrixFilter<TImageType, THistogramFrequencyContainer>
+      ::ComputeRunLengthMatrices( std::vector<HistogramPointer> & matrices )
+    {
+      const ImageType * inputImage = this->GetInput();
+      const ImageType * maskImage = this->GetMaskImage();
+      const RegionType region = inputImage->GetRequestedRegion();
+      const unsigned int dimension = ImageType::ImageDimension;
+      const unsigned int measurementVectorSize = 2;
+
+      typename HistogramType::SizeType size( measurementVectorSize );
+      size.Fill( this->m_NumberOfBinsPerAxis );
+      this->m_LowerBound[0] = this->m_Min;
+      this->m_LowerBound[1] = this->m_MinDistance;
+      this->m_UpperBound[0] = this->m_Max;
+      this->m_UpperBound[1] = this->m_MaxDistance;
+
+      std::vector<OffsetType> offsets;
+      matrices.clear();
+      typename OffsetVector::ConstIterator offsetIt;
+      for( offsetIt = this->GetOffsets()->Begin();
+        offsetIt != this->GetOffsets()->End(); offsetIt++ )
+      {
+        OffsetType offset = offsetIt.Value();
+        this->NormalizeOffsetDirection( offset );
+        offsets.push_back( offset );
+
+        HistogramPointer matrix = HistogramType::New();
+        matrix->SetMeasurementVectorSize( measurementVectorSize );
+        matrix->Initialize( size, this->m_LowerBound, this->m_UpperBound );
+        matrices.push_back( matrix );
+      }
+
+      // Bounding box of the pixels which start a run, inside of the mask and of the intensity range
+      IndexType boxLower = region.GetUpperIndex();
+      IndexType boxUpper = region.GetIndex();
+      bool isEmpty = true;
+      ImageRegionConstIteratorWithIndex<ImageType> inputIt( inputImage, region );
+      for( ; !inputIt.IsAtEnd(); ++inputIt )
+      {
+        const IndexType index = inputIt.GetIndex();
+        if( inputIt.Get() < this->m_Min || inputIt.Get() > this->m_Max ||
+          ( maskImage && maskImage->GetPixel( index ) != this->m_InsidePixelValue ) )
+        {
+          continue;
+        }
+        for( unsigned int d = 0; d < dimension; d++ )
+        {
+          boxLower[d] = std::min( boxLower[d], index[d] );
+          boxUpper[d] = std::max( boxUpper[d], index[d] );
+        }
+        isEmpty = false;
+      }
+      if( matrices.empty() || isEmpty )
+      {
+        return;
+      }
+
+      RegionType box;
+      box.SetIndex( boxLower );
+      box.SetUpperIndex( boxUpper );
+
+      // The bin bounds of the start pixels are looked up once per pixel value instead of once per
+      // pixel and offset. binBoundsOfStart is -1 for pixels which do not start a run.
+      const HistogramType * histogram = matrices[0];
+      std::map<PixelType, int> binBoundsOfValue;
+      std::vector<MeasurementType> binMins;
+      std::vector<MeasurementType> binMaxs;
+      std::vector<int> binBoundsOfStart( box.GetNumberOfPixels(), -1 );
+      ImageRegionConstIteratorWithIndex<ImageType> boxIt( inputImage, box );
+      for( SizeValueType i = 0; !boxIt.IsAtEnd(); ++boxIt, ++i )
+      {
+        const PixelType centerPixelIntensity = boxIt.Get();
+        if( centerPixelIntensity < this->m_Min || centerPixelIntensity > this->m_Max ||
+          ( maskImage && maskImage->GetPixel( boxIt.GetIndex() ) != this->m_InsidePixelValue ) )
+        {
+          continue;
+        }
+        typename std::map<PixelType, int>::const_iterator bounds = binBoundsOfValue.find( centerPixelIntensity );
+        if( bounds == binBoundsOfValue.end() )
+        {
+          bounds = binBoundsOfValue.insert( std::make_pair( centerPixelIntensity, static_cast<int>( binMins.size() ) ) ).first;
+          binMins.push_back( histogram->GetBinMinFromValue( 0, centerPixelIntensity ) );
+          binMaxs.push_back( histogram->GetBinMaxFromValue( 0, centerPixelIntensity ) );
+        }
+        binBoundsOfStart[i] = bounds->second;
+      }
+      const MeasurementType lastBinMax = histogram->GetDimensionMaxs( 0 )[ histogram->GetSize( 0 ) - 1 ];
+
+      const PixelType * buffer = inputImage->GetBufferPointer();
+      const OffsetValueType * offsetTable = inputImage->GetOffsetTable();
+
+#pragma omp parallel for schedule(dynamic)
+      for( int offsetNum = 0; offsetNum < static_cast<int>( offsets.size() ); offsetNum++ )
+      {
+        const OffsetType offset = offsets[offsetNum];
+        HistogramType * output = matrices[offsetNum];
+        MeasurementVectorType run( measurementVectorSize );
+        typename HistogramType::IndexType hIndex;
+
+        OffsetValueType bufferOffset = 0;
+        OffsetValueType boxOffset = 0;
+        OffsetValueType boxStride = 1;
+        for( unsigned int d = 0; d < dimension; d++ )
+        {
+          bufferOffset += offset[d] * offsetTable[d];
+          boxOffset += offset[d] * boxStride;
+          boxStride *= box.GetSize( d );
+        }
+
+        // For the same offset, each run length segment can only be visited once. Visited pixels are
+        // stored per line, the line position 0 is the first pixel of the line inside of the box.
+        std::vector<char> alreadyVisited;
+
+        ImageRegionConstIteratorWithIndex<ImageType> lineIt( inputImage, box );
+        for( SizeValueType boxNum = 0; !lineIt.IsAtEnd(); ++lineIt, ++boxNum )
+        {
+          const IndexType lineStart = lineIt.GetIndex();
+          if( box.IsInside( lineStart - offset ) )
+          {
+            continue;
+          }
+
+          // number of steps from the line start to the ends of the region and of the box
+          OffsetValueType stepsBack = NumericTraits<OffsetValueType>::max();
+          OffsetValueType stepsForward = NumericTraits<OffsetValueType>::max();
+          OffsetValueType stepsInBox = NumericTraits<OffsetValueType>::max();
+          for( unsigned int d = 0; d < dimension; d++ )
+          {
+            if( offset[d] > 0 )
+            {
+              stepsBack = std::min<OffsetValueType>( stepsBack, ( lineStart[d] - region.GetIndex( d ) ) / offset[d] );
+              stepsForward = std::min<OffsetValueType>( stepsForward, ( region.GetUpperIndex()[d] - lineStart[d] ) / offset[d] );
+              stepsInBox = std::min<OffsetValueType>( stepsInBox, ( boxUpper[d] - lineStart[d] ) / offset[d] );
+            }
+            else if( offset[d] < 0 )
+            {
+              stepsBack = std::min<OffsetValueType>( stepsBack, ( region.GetUpperIndex()[d] - lineStart[d] ) / -offset[d] );
+              stepsForward = std::min<OffsetValueType>( stepsForward, ( lineStart[d] - region.GetIndex( d ) ) / -offset[d] );
+              stepsInBox = std::min<OffsetValueType>( stepsInBox, ( lineStart[d] - boxLower[d] ) / -offset[d] );
+            }
+          }
+          alreadyVisited.assign( stepsBack + stepsForward + 1, 0 );
+          char * visited = &alreadyVisited[stepsBack];
+          const OffsetValueType lineBufferStart = inputImage->ComputeOffset( lineStart );
+
+          // The pixels of the line are scanned in the order of the image iterator of GenerateData()
+          for( OffsetValueType center = 0; center <= stepsInBox; center++ )
+          {
+            const int bounds = binBoundsOfStart[static_cast<OffsetValueType>( boxNum ) + center * boxOffset];
+            if( bounds < 0 || visited[center] )
+            {
+              continue;
+            }
+            const MeasurementType centerBinMin = binMins[bounds];
+            const MeasurementType centerBinMax = binMaxs[bounds];
+
+            // Scan from the center pixel in the direction of offset, and in the opposite direction.
+            // Run length is computed as the length of continuous pixels whose pixel values are
+            // in the same bin.
+            bool runLengthSegmentAlreadyVisited = false;
+            OffsetValueType lastGood = center;
+            OffsetValueType position = center + 1;
+            for( ; position <= stepsForward; position++ )
+            {
+              if( visited[position] )
+              {
+                runLengthSegmentAlreadyVisited = true;
+                break;
+              }
+              const PixelType pixelIntensity = buffer[lineBufferStart + position * bufferOffset];
+              if ( pixelIntensity >= centerBinMin
+                && ( pixelIntensity < centerBinMax || ( pixelIntensity == centerBinMax && centerBinMax == lastBinMax ) ) )
+              {
+                visited[position] = 1;
+                lastGood = position;
+              }
+              else
+              {
+                break;
+              }
+            }
+            if( runLengthSegmentAlreadyVisited )
+            {
+              continue;
+            }
+            const OffsetValueType lastGood2 = lastGood;
+
+            lastGood = center;
+            for( position = center - 1; position >= -stepsBack; position-- )
+            {
+              if( visited[position] )
+              {
+                runLengthSegmentAlreadyVisited = true;
+                break;
+              }
+              const PixelType pixelIntensity = buffer[lineBufferStart + position * bufferOffset];
+              if ( pixelIntensity >= centerBinMin
+                && ( pixelIntensity < centerBinMax || ( pixelIntensity == centerBinMax && centerBinMax == lastBinMax ) ) )
+              {
+                visited[position] = 1;
+                lastGood = position;
+              }
+              else
+              {
+                break;
+              }
+            }
+            if( runLengthSegmentAlreadyVisited )
+            {
+              continue;
+            }
+
+            IndexType lastGoodIndex = lineStart;
+            IndexType lastGoodIndex2 = lineStart;
+            for( unsigned int d = 0; d < dimension; d++ )
+            {
+              lastGoodIndex[d] += offset[d] * lastGood;
+              lastGoodIndex2[d] += offset[d] * lastGood2;
+            }
+            PointType point;
+            inputImage->TransformIndexToPhysicalPoint( lastGoodIndex, point );
+            PointType point2;
+            inputImage->TransformIndexToPhysicalPoint( lastGoodIndex2, point2 );
+
+            run[0] = buffer[lineBufferStart + center * bufferOffset];
+            run[1] = point.EuclideanDistanceTo( point2 );
+
+            if( run[1] >= this->m_MinDistance && run[1] <= this->m_MaxDistance )
+            {
+              output->GetIndex( run, hIndex );
+              output->IncreaseFrequencyOfIndex( hIndex, 1 );
+            }
+          }
+        }
+      }
+    }
+
     template<typename TImageType, typename THistogramFrequencyContainer>
     void
       EnhancedScalarImageToRunLengthMatrixFilter<TImageType, THistogramFrequencyContainer>
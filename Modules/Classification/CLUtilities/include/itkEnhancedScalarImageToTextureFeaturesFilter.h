@@ -39,6 +39,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkEnhancedHistogramToTextureFeaturesFilter.h"
 #include "itkScalarImageToCooccurrenceMatrixFilter.h"
 
+#include <vector>
+
 namespace itk
 {
   namespace Statistics
@@ -148,6 +150,7 @@ namespace itk
         ImageType, FrequencyContainerType >               CooccurrenceMatrixFilterType;
 
       typedef typename CooccurrenceMatrixFilterType::HistogramType HistogramType;
+      typedef typename HistogramType::Pointer                      HistogramPointer;
       typedef EnhancedHistogramToTextureFeaturesFilter< HistogramType >    TextureFeaturesFilterType;
 
       typedef short                                                  TextureFeatureName;
@@ -220,6 +223,12 @@ namespace itk
 
       void FullCompute();
 
+      /** Computes the co-occurrence matrices of all offsets in one multi-threaded pass over the
+      bounding box of the mask. The image is discretized once, each thread counts the pairs of its
+      slices in dense matrices, which are summed at the end. The matrices equal the outputs of the
+      co-occurrence matrix filter for the single offsets. */
+      void ComputeCooccurrenceMatrices(std::vector< HistogramPointer > & matrices);
+
       /** This method causes the filter to generate its output. */
       virtual void GenerateData() ITK_OVERRIDE;
 
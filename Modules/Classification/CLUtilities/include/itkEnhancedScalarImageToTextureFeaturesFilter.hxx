@@ -36,8 +36,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "itkEnhancedScalarImageToTextureFeaturesFilter.h"
 #include "itkNeighborhood.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 #include "vnl/vnl_math.h"
 
+#include <algorithm>
+
 namespace itk
 {
   namespace Statistics
@@ -130,22 +133,25 @@ namespace itk
         features[i] = new double[numFeatures];
       }
 
+      // The matrices of all offsets are computed at once
+      std::vector< HistogramPointer > matrices;
+      this->ComputeCooccurrenceMatrices( matrices );
+
       // For each offset, calculate each feature
-      typename OffsetVector::ConstIterator offsetIt;
       int offsetNum, featureNum;
       typedef typename TextureFeaturesFilterType::TextureFeatureName InternalTextureFeatureName;
 
-      for ( offsetIt = m_Offsets->Begin(), offsetNum = 0;
-        offsetIt != m_Offsets->End(); offsetIt++, offsetNum++ )
+      for ( offsetNum = 0; offsetNum < numOffsets; offsetNum++ )
       {
-        this->m_GLCMGenerator->SetOffset( offsetIt.Value() );
-        this->m_GLCMCalculator->Update();
+        typename TextureFeaturesFilterType::Pointer glcmCalculator = TextureFeaturesFilterType::New();
+        glcmCalculator->SetInput( matrices[offsetNum] );
+        glcmCalculator->Update();
 
         typename FeatureNameVector::ConstIterator fnameIt;
         for ( fnameIt = m_RequestedFeatures->Begin(), featureNum = 0;
           fnameIt != m_RequestedFeatures->End(); fnameIt++, featureNum++ )
         {
-          features[offsetNum][featureNum] = this->m_GLCMCalculator->GetFeature( (InternalTextureFeatureName)fnameIt.Value() );
+          features[offsetNum][featureNum] = glcmCalculator->GetFeature( (InternalTextureFeatureName)fnameIt.Value() );
         }
       }
 
@@ -213,6 +219,204 @@ namespace itk
       delete[] features;
     }
 
+    template< typename TImage, typename THistogramFrequencyContainer >
+    void
+      EnhancedScalarImageToTextureFeaturesFilter< TImage, THistogramFrequencyContainer >::ComputeCooccurrenceMatrices(
+      std::vector< HistogramPointer > & matrices)
+    {
+      typedef typename HistogramType::AbsoluteFrequencyType FrequencyType;
+      typedef typename ImageType::RegionType                RegionType;
+      typedef typename ImageType::IndexType                 IndexType;
+      const unsigned int dimension = ImageType::ImageDimension;
+
+      const ImageType * input = this->GetInput();
+      const ImageType * mask = this->GetMaskImage();
+      const PixelType min = m_GLCMGenerator->GetMin();
+      const PixelType max = m_GLCMGenerator->GetMax();
+      const PixelType insidePixelValue = m_GLCMGenerator->GetInsidePixelValue();
+      const unsigned int numberOfBins = m_GLCMGenerator->GetNumberOfBinsPerAxis();
+      const unsigned int numberOfOffsets = m_Offsets->size();
+
+      // One matrix per offset, with the bins of the co-occurrence matrix filter,
+      // whose upper bound is max + 1 (see ScalarImageToCooccurrenceMatrixFilter::SetPixelValueMinMax)
+      typename HistogramType::SizeType size( 2 );
+      size.Fill( numberOfBins );
+      typename HistogramType::MeasurementVectorType lowerBound( 2 );
+      typename HistogramType::MeasurementVectorType upperBound( 2 );
+      lowerBound.Fill( min );
+      upperBound.Fill( max + 1 );
+
+      matrices.clear();
+      for ( unsigned int offsetNum = 0; offsetNum < numberOfOffsets; offsetNum++ )
+      {
+        HistogramPointer matrix = HistogramType::New();
+        matrix->SetMeasurementVectorSize( 2 );
+        matrix->Initialize( size, lowerBound, upperBound );
+        matrices.push_back( matrix );
+      }
+
+      // Only pixels inside of the mask and of the intensity range are part of a pair.
+      const RegionType bufferedRegion = input->GetBufferedRegion();
+      IndexType boxLower = bufferedRegion.GetUpperIndex();
+      IndexType boxUpper = bufferedRegion.GetIndex();
+      bool isEmpty = true;
+      ImageRegionConstIteratorWithIndex< ImageType > inputIt( input, bufferedRegion );
+      for ( ; !inputIt.IsAtEnd(); ++inputIt )
+      {
+        const IndexType index = inputIt.GetIndex();
+        if ( inputIt.Get() < min || inputIt.Get() > max || ( mask != ITK_NULLPTR && mask->GetPixel( index ) != insidePixelValue ) )
+        {
+          continue;
+        }
+        for ( unsigned int d = 0; d < dimension; d++ )
+        {
+          boxLower[d] = std::min( boxLower[d], index[d] );
+          boxUpper[d] = std::max( boxUpper[d], index[d] );
+        }
+        isEmpty = false;
+      }
+      if ( isEmpty )
+      {
+        return;
+      }
+
+      RegionType box;
+      box.SetIndex( boxLower );
+      box.SetUpperIndex( boxUpper );
+
+      // Discretize the bounding box once, -1 marks pixels that are not part of any pair.
+      // Pixel values inside of the range always have a bin.
+      std::vector< int > bins( box.GetNumberOfPixels(), -1 );
+      typename HistogramType::MeasurementVectorType measurement( 2 );
+      typename HistogramType::IndexType binIndex( 2 );
+      ImageRegionConstIteratorWithIndex< ImageType > boxIt( input, box );
+      for ( SizeValueType i = 0; !boxIt.IsAtEnd(); ++boxIt, ++i )
+      {
+        if ( boxIt.Get() < min || boxIt.Get() > max || ( mask != ITK_NULLPTR && mask->GetPixel( boxIt.GetIndex() ) != insidePixelValue ) )
+        {
+          continue;
+        }
+        measurement.Fill( boxIt.Get() );
+        if ( matrices[0]->GetIndex( measurement, binIndex ) )
+        {
+          bins[i] = binIndex[0];
+        }
+      }
+
+      // Offsets of the neighbors in the bins of the box
+      std::vector< OffsetType > offsets;
+      std::vector< long > binOffsets;
+      for ( typename OffsetVector::ConstIterator offsetIt = m_Offsets->Begin(); offsetIt != m_Offsets->End(); offsetIt++ )
+      {
+        long binOffset = 0;
+        long stride = 1;
+        for ( unsigned int d = 0; d < dimension; d++ )
+        {
+          binOffset += offsetIt.Value()[d] * stride;
+          stride *= box.GetSize( d );
+        }
+        offsets.push_back( offsetIt.Value() );
+        binOffsets.push_back( binOffset );
+      }
+
+      // Only the pixels of the requested region are centers of a pair
+      RegionType centerRegion = box;
+      if ( !centerRegion.Crop( input->GetRequestedRegion() ) )
+      {
+        return;
+      }
+
+      const SizeValueType matrixSize = numberOfBins * numberOfBins;
+      const int numberOfSlices = centerRegion.GetSize( dimension - 1 );
+      std::vector< FrequencyType > frequencies( numberOfOffsets * matrixSize, 0 );
+
+#pragma omp parallel if ( centerRegion.GetNumberOfPixels() > 100000 )
+      {
+        std::vector< FrequencyType > threadFrequencies( numberOfOffsets * matrixSize, 0 );
+
+#pragma omp for schedule(dynamic)
+        for ( int slice = 0; slice < numberOfSlices; slice++ )
+        {
+          RegionType sliceRegion = centerRegion;
+          sliceRegion.SetIndex( dimension - 1, centerRegion.GetIndex( dimension - 1 ) + slice );
+          sliceRegion.SetSize( dimension - 1, 1 );
+
+          ImageRegionConstIteratorWithIndex< ImageType > it( input, sliceRegion );
+          for ( ; !it.IsAtEnd(); ++it )
+          {
+            const IndexType index = it.GetIndex();
+            long binNum = 0;
+            long stride = 1;
+            for ( unsigned int d = 0; d < dimension; d++ )
+            {
+              binNum += ( index[d] - boxLower[d] ) * stride;
+              stride *= box.GetSize( d );
+            }
+            const int centerBin = bins[binNum];
+            if ( centerBin < 0 )
+            {
+              continue;
+            }
+
+            for ( unsigned int offsetNum = 0; offsetNum < numberOfOffsets; offsetNum++ )
+            {
+              // neighbors outside of the box are outside of the mask or the image
+              bool isInside = true;
+              for ( unsigned int d = 0; d < dimension && isInside; d++ )
+              {
+                const IndexValueType neighbor = index[d] + offsets[offsetNum][d];
+                isInside = neighbor >= boxLower[d] && neighbor <= boxUpper[d];
+              }
+              if ( !isInside )
+              {
+                continue;
+              }
+              const int neighborBin = bins[binNum + binOffsets[offsetNum]];
+              if ( neighborBin < 0 )
+              {
+                continue;
+              }
+
+              // both possible co-occurrence combinations, as by the co-occurrence matrix filter
+              FrequencyType *matrix = &threadFrequencies[offsetNum * matrixSize];
+              matrix[centerBin + neighborBin * numberOfBins]++;
+              matrix[neighborBin + centerBin * numberOfBins]++;
+            }
+          }
+        }
+
+#pragma omp critical
+        for ( SizeValueType i = 0; i < frequencies.size(); i++ )
+        {
+          frequencies[i] += threadFrequencies[i];
+        }
+      }
+
+      typename HistogramType::IndexType matrixIndex( 2 );
+      for ( unsigned int offsetNum = 0; offsetNum < numberOfOffsets; offsetNum++ )
+      {
+        HistogramType *matrix = matrices[offsetNum];
+        for ( SizeValueType i = 0; i < matrixSize; i++ )
+        {
+          if ( frequencies[offsetNum * matrixSize + i] != 0 )
+          {
+            matrixIndex[0] = i % numberOfBins;
+            matrixIndex[1] = i / numberOfBins;
+            matrix->SetFrequencyOfIndex( matrixIndex, frequencies[offsetNum * matrixSize + i] );
+          }
+        }
+
+        if ( m_GLCMGenerator->GetNormalize() )
+        {
+          const FrequencyType totalFrequency = matrix->GetTotalFrequency();
+          for ( typename HistogramType::Iterator hit = matrix->Begin(); hit != matrix->End(); ++hit )
+          {
+            hit.SetFrequency( hit.GetFrequency() / totalFrequency );
+          }
+        }
+      }
+    }
+
     template< typename TImage, typename THistogramFrequencyContainer >
     void
       EnhancedScalarImageToTextureFeaturesFilter< TImage, THistogramFrequencyContainer >::FastCompute(void)
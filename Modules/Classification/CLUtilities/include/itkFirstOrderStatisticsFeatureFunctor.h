@@ -3,6 +3,8 @@
 
 #include "itkConstNeighborhoodIterator.h"
 
+#include <map>
+
 namespace itk
 {
 
@@ -20,6 +22,19 @@ struct NeighborhoodFirstOrderStatistics
     MEAN, VARIANCE, SKEWNESS, KURTOSIS, MIN, MAX
   };
 
+  /** Running sums of the window for the incremental mode of the NeighborhoodFunctorImageFilter.
+   * The values are shifted by the first added value to keep the higher moments accurate. */
+  struct AccumulatorType
+  {
+    double count;
+    double shift;
+    double sum;
+    double sum2;
+    double sum3;
+    double sum4;
+    std::map<double, unsigned int> values;
+  };
+
   NeighborhoodFirstOrderStatistics(){std::cout << "NeighborhoodFirstOrderStatistics" << std::endl;}
 
   static const char * GetFeatureName(unsigned int f )
@@ -81,6 +96,92 @@ struct NeighborhoodFirstOrderStatistics
     return output_vector;
 
   }
+
+  bool IsIncremental() const
+  {
+    return true;
+  }
+
+  void Clear(AccumulatorType & accumulator) const
+  {
+    accumulator.count = 0;
+    accumulator.shift = 0;
+    accumulator.sum = 0;
+    accumulator.sum2 = 0;
+    accumulator.sum3 = 0;
+    accumulator.sum4 = 0;
+    accumulator.values.clear();
+  }
+
+  void Add(AccumulatorType & accumulator, const NeighborhoodType & it, unsigned int i) const
+  {
+    double value = it.GetPixel(i);
+    if (accumulator.count == 0)
+      accumulator.shift = value;
+    double x = value - accumulator.shift;
+    accumulator.count += 1;
+    accumulator.sum += x;
+    accumulator.sum2 += x * x;
+    accumulator.sum3 += x * x * x;
+    accumulator.sum4 += x * x * x * x;
+    ++accumulator.values[value];
+  }
+
+  void Remove(AccumulatorType & accumulator, const NeighborhoodType & it, unsigned int i) const
+  {
+    double value = it.GetPixel(i);
+    double x = value - accumulator.shift;
+    accumulator.count -= 1;
+    accumulator.sum -= x;
+    accumulator.sum2 -= x * x;
+    accumulator.sum3 -= x * x * x;
+    accumulator.sum4 -= x * x * x * x;
+    typename std::map<double, unsigned int>::iterator valueIt = accumulator.values.find(value);
+    if (--valueIt->second == 0)
+      accumulator.values.erase(valueIt);
+  }
+
+  /** Features of the accumulated window, the central moments are derived from the running sums. */
+  inline OutputVectorType Compute(const AccumulatorType & accumulator) const
+  {
+    double n = accumulator.count;
+    double m1 = accumulator.sum / n;
+    double m2 = accumulator.sum2 / n;
+    double m3 = accumulator.sum3 / n;
+    double m4 = accumulator.sum4 / n;
+
+    double min = accumulator.values.begin()->first;
+    double max = accumulator.values.rbegin()->first;
+
+    double variance = 0;
+    double skewness = 0;
+    double kurtosis = 0;
+    if (min < max)
+    {
+      variance = m2 - m1 * m1;
+      double centralM3 = m3 - 3 * m1 * m2 + 2 * m1 * m1 * m1;
+      double centralM4 = m4 - 4 * m1 * m3 + 6 * m1 * m1 * m2 - 3 * m1 * m1 * m1 * m1;
+      skewness = centralM3 / (variance * std::sqrt(variance));
+      kurtosis = centralM4 / (variance * variance);
+    }
+
+    if(skewness!=skewness){
+        skewness = 0;
+    }
+    if(kurtosis!=kurtosis){
+        kurtosis = 0;
+    }
+
+    OutputVectorType output_vector;
+    output_vector[MEAN] = m1 + accumulator.shift;
+    output_vector[VARIANCE] = variance;
+    output_vector[SKEWNESS] = skewness;
+    output_vector[KURTOSIS] = kurtosis;
+    output_vector[MIN] = min;
+    output_vector[MAX] = max;
+
+    return output_vector;
+  }
 };
 
 }// end namespace functor
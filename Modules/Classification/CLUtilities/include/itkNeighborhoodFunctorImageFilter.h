@@ -70,6 +70,13 @@ public:
 
     void SetMask(const typename MaskImageType::Pointer & ptr){m_MaskImage = ptr;}
 
+    /** If the functor supports it, the neighborhood statistics are updated incrementally while the
+     * window slides along the fastest axis: only the face entering and the face leaving the window
+     * are added to and removed from the running statistics of the functor. Off by default. */
+    itkSetMacro(Incremental, bool);
+    itkGetConstMacro(Incremental, bool);
+    itkBooleanMacro(Incremental);
+
     const FunctorType & GetFunctorReference() const
     {
       return m_Functor;
@@ -91,6 +98,7 @@ protected:
     {
         m_Size.Fill(0);
         m_MaskImage = nullptr;
+        m_Incremental = false;
         m_BoundsCondition = static_cast< ImageBoundaryConditionPointerType >( &m_DefaultBoundaryCondition );
         this->SetNumberOfIndexedOutputs(FunctorType::OutputCount);
     }
@@ -130,6 +138,8 @@ private:
 
     typename MaskImageType::Pointer m_MaskImage;
 
+    bool m_Incremental;
+
 };
 }
 
@@ -11,6 +11,9 @@
 #include <mitkITKImageImport.h>
 
 #include <itkConnectedComponentImageFilter.h>
+
+#include <functional>
+#include <vector>
 namespace mitk
 {
 
@@ -39,6 +42,41 @@ public:
   ///
   static void InterpolateCheckerboardPrediction(mitk::Image::Pointer checkerboard_prediction, mitk::Image::Pointer & checkerboard_mask, mitk::Image::Pointer & outimage);
 
+  ///
+  /// \brief Predicts the classes of the feature vectors, one row per voxel. probabilities may be left empty.
+  ///
+  typedef std::function<void(const Eigen::MatrixXd &features, Eigen::MatrixXi &labels, Eigen::MatrixXd &probabilities)> PredictionFunctionType;
+
+  ///
+  /// \brief Statistics of one level of AdaptivePrediction
+  ///
+  struct AdaptivePredictionLevel
+  {
+    unsigned int step;              ///< lattice spacing of the level in voxels
+    unsigned int predictedVoxels;   ///< voxels passed to the prediction function
+    unsigned int filledVoxels;      ///< voxels interpolated from the block corners
+    unsigned int refinedBlocks;     ///< blocks split for the next level
+    double seconds;
+  };
+
+  ///
+  /// \brief AdaptivePrediction generalizes the checkerboard prediction to a coarse-to-fine scheme
+  ///
+  /// The voxels of the mask are first predicted on a lattice with spacing coarseStep (a power of two). A block
+  /// between lattice points is filled without prediction if all of its corners inside the mask agree on the label
+  /// and the difference between the two highest probabilities of each corner is at least margin. The label is
+  /// copied and the probabilities are interpolated trilinearly. All other blocks are split and their corners are
+  /// predicted on the next finer lattice, down to single voxels. With coarseStep 1 the result equals the dense prediction.
+  ///
+  /// \param features one image per feature column
+  /// \param mask voxels with a non-zero value are classified
+  /// \param labelImage result labels, 0 outside of the mask
+  /// \param probabilityImages result probabilities, one image per column returned by function
+  /// \return statistics of each level, from coarse to fine
+  ///
+  static std::vector<AdaptivePredictionLevel> AdaptivePrediction(const std::vector<mitk::Image::Pointer> & features, const mitk::Image::Pointer & mask, const PredictionFunctionType & function,
+                                                                  mitk::Image::Pointer & labelImage, std::vector<mitk::Image::Pointer> & probabilityImages, unsigned int coarseStep = 4, double margin = 0.2);
+
   ///
   /// \brief CountVoxel
   /// \param image
@@ -36,6 +36,7 @@ namespace mitk
     {
       double range;
       unsigned int direction;
+      GlobalImageFeatureCache * cache;
     };
 
     private:
@@ -52,6 +52,7 @@ namespace mitk
     struct ParameterStruct {
       int m_HistogramSize;
       bool m_UseCtRange;
+      GlobalImageFeatureCache * m_Cache;
     };
 
   private:
@@ -40,6 +40,7 @@ namespace mitk
       bool  m_UseCtRange;
       double m_Range;
       unsigned int m_Direction;
+      GlobalImageFeatureCache * m_Cache;
     };
 
   private:
@@ -131,21 +131,83 @@ NeighborhoodFunctorImageFilter< TInputImage, TFeatureImageType, FunctorType >
     mit.GoToBegin();
     bit.GoToBegin();
 
-    while ( !bit.IsAtEnd() || !mit.IsAtEnd() )
+    if (m_Incremental && m_Functor.IsIncremental())
     {
-      if(mit.Value() != 0)
+      // Neighborhood indices of the faces leaving and entering the window
+      // when it is moved by one pixel along the fastest axis
+      std::vector<unsigned int> leavingFace;
+      std::vector<unsigned int> enteringFace;
+      for (unsigned int i = 0; i < bit.Size(); ++i)
       {
-        //bit.GetNeighborhood().Print(std::cout);
-        typename FunctorType::OutputVectorType features = ( m_Functor( bit ) );
+        if (bit.GetOffset(i)[0] == -static_cast<OffsetValueType>(m_Size[0]))
+          leavingFace.push_back(i);
+        if (bit.GetOffset(i)[0] == static_cast<OffsetValueType>(m_Size[0]))
+          enteringFace.push_back(i);
+      }
+
+      typename FunctorType::AccumulatorType accumulator;
+      bool isAccumulated = false;
+
+      while ( !bit.IsAtEnd() || !mit.IsAtEnd() )
+      {
+        if(mit.Value() != 0)
+        {
+          if (!isAccumulated)
+          {
+            m_Functor.Clear(accumulator);
+            for (unsigned int i = 0; i < bit.Size(); ++i)
+              m_Functor.Add(accumulator, bit, i);
+            isAccumulated = true;
+          }
+          typename FunctorType::OutputVectorType features = m_Functor.Compute(accumulator);
+
+          for(unsigned int i = 0 ; i < FunctorType::OutputCount; i++)
+            featureImageIterators[i].Set(features[i]);
+        }
+
+        // The window is only slid if the next pixel is in the same line and inside of the mask,
+        // otherwise it is accumulated from scratch once it is needed again.
+        typename InputImageType::IndexType nextIndex = bit.GetIndex();
+        nextIndex[0]++;
+        bool slideWindow = isAccumulated && outputRegionForThread.IsInside(nextIndex) && m_MaskImage->GetPixel(nextIndex) != 0;
+
+        if (slideWindow)
+        {
+          for (unsigned int i = 0; i < leavingFace.size(); ++i)
+            m_Functor.Remove(accumulator, bit, leavingFace[i]);
+        }
 
         for(unsigned int i = 0 ; i < FunctorType::OutputCount; i++)
-          featureImageIterators[i].Set(features[i]);
+          ++featureImageIterators[i];
+        ++bit;
+        ++mit;
+
+        if (slideWindow)
+        {
+          for (unsigned int i = 0; i < enteringFace.size(); ++i)
+            m_Functor.Add(accumulator, bit, enteringFace[i]);
+        }
+        isAccumulated = slideWindow;
       }
+    }
+    else
+    {
+      while ( !bit.IsAtEnd() || !mit.IsAtEnd() )
+      {
+        if(mit.Value() != 0)
+        {
+          //bit.GetNeighborhood().Print(std::cout);
+          typename FunctorType::OutputVectorType features = ( m_Functor( bit ) );
+
+          for(unsigned int i = 0 ; i < FunctorType::OutputCount; i++)
+            featureImageIterators[i].Set(features[i]);
+        }
 
-      for(unsigned int i = 0 ; i < FunctorType::OutputCount; i++)
-        ++featureImageIterators[i];
-      ++bit;
-      ++mit;
+        for(unsigned int i = 0 ; i < FunctorType::OutputCount; i++)
+          ++featureImageIterators[i];
+        ++bit;
+        ++mit;
+      }
     }
 //  }
 
@@ -7,7 +7,6 @@
 
 // ITK
 #include <itkEnhancedScalarImageToTextureFeaturesFilter.h>
-#include <itkMinimumMaximumImageCalculator.h>
 
 // STL
 #include <sstream>
@@ -19,11 +18,9 @@ CalculateCoocurenceFeatures(itk::Image<TPixel, VImageDimension>* itkImage, mitk:
   typedef itk::Image<TPixel, VImageDimension> ImageType;
   typedef itk::Image<TPixel, VImageDimension> MaskType;
   typedef itk::Statistics::EnhancedScalarImageToTextureFeaturesFilter<ImageType> FilterType;
-  typedef itk::MinimumMaximumImageCalculator<ImageType> MinMaxComputerType;
   typedef typename FilterType::TextureFeaturesFilterType TextureFilterType;
 
-  typename MaskType::Pointer maskImage = MaskType::New();
-  mitk::CastToItkImage(mask, maskImage);
+  typename MaskType::Pointer maskImage = mitk::GlobalImageFeatureCache::CastMask<MaskType>(config.cache, mask);
 
   typename FilterType::Pointer filter = FilterType::New();
 
@@ -88,14 +85,13 @@ CalculateCoocurenceFeatures(itk::Image<TPixel, VImageDimension>* itkImage, mitk:
   requestedFeatures->push_back(TextureFilterType::InverseDifferenceNormalized);
   requestedFeatures->push_back(TextureFilterType::InverseDifference);
 
-  typename MinMaxComputerType::Pointer minMaxComputer = MinMaxComputerType::New();
-  minMaxComputer->SetImage(itkImage);
-  minMaxComputer->Compute();
+  TPixel imageMinimum, imageMaximum;
+  mitk::GlobalImageFeatureCache::ComputeMinimumMaximum(config.cache, itkImage, imageMinimum, imageMaximum);
 
   filter->SetInput(itkImage);
   filter->SetMaskImage(maskImage);
   filter->SetRequestedFeatures(requestedFeatures);
-  filter->SetPixelValueMinMax(minMaxComputer->GetMinimum()-0.5,minMaxComputer->GetMaximum()+0.5);
+  filter->SetPixelValueMinMax(imageMinimum-0.5,imageMaximum+0.5);
   //filter->SetPixelValueMinMax(-1024,3096);
   //filter->SetNumberOfBinsPerAxis(5);
   filter->Update();
@@ -228,6 +224,7 @@ mitk::GIFCooccurenceMatrix::FeatureListType mitk::GIFCooccurenceMatrix::Calculat
   GIFCooccurenceMatrixConfiguration config;
   config.direction = m_Direction;
   config.range = m_Range;
+  config.cache = GetCache();
 
   AccessByItk_3(image, CalculateCoocurenceFeatures, mask, featureList,config);
 
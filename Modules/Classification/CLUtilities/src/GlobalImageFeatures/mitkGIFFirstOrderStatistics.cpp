@@ -23,7 +23,6 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 // ITK
 #include <itkLabelStatisticsImageFilter.h>
-#include <itkMinimumMaximumImageCalculator.h>
 
 // STL
 #include <sstream>
@@ -37,15 +36,12 @@ void
   typedef itk::LabelStatisticsImageFilter<ImageType, MaskType> FilterType;
   typedef typename FilterType::HistogramType HistogramType;
   typedef typename HistogramType::IndexType HIndexType;
-  typedef itk::MinimumMaximumImageCalculator<ImageType> MinMaxComputerType;
 
-  typename MaskType::Pointer maskImage = MaskType::New();
-  mitk::CastToItkImage(mask, maskImage);
+  typename MaskType::Pointer maskImage = mitk::GlobalImageFeatureCache::CastMask<MaskType>(params.m_Cache, mask);
 
-  typename MinMaxComputerType::Pointer minMaxComputer = MinMaxComputerType::New();
-  minMaxComputer->SetImage(itkImage);
-  minMaxComputer->Compute();
-  double imageRange = minMaxComputer->GetMaximum() -  minMaxComputer->GetMinimum();
+  TPixel imageMinimum, imageMaximum;
+  mitk::GlobalImageFeatureCache::ComputeMinimumMaximum(params.m_Cache, itkImage, imageMinimum, imageMaximum);
+  double imageRange = imageMaximum - imageMinimum;
 
   typename FilterType::Pointer labelStatisticsImageFilter = FilterType::New();
   labelStatisticsImageFilter->SetInput( itkImage );
@@ -55,7 +51,7 @@ void
   {
     labelStatisticsImageFilter->SetHistogramParameters(1024.5+3096.5, -1024.5,3096.5);
   } else {
-    labelStatisticsImageFilter->SetHistogramParameters(params.m_HistogramSize, minMaxComputer->GetMinimum(),minMaxComputer->GetMaximum());
+    labelStatisticsImageFilter->SetHistogramParameters(params.m_HistogramSize, imageMinimum, imageMaximum);
   }
   labelStatisticsImageFilter->Update();
 
@@ -144,6 +140,7 @@ mitk::GIFFirstOrderStatistics::FeatureListType mitk::GIFFirstOrderStatistics::Ca
   ParameterStruct params;
   params.m_HistogramSize = this->m_HistogramSize;
   params.m_UseCtRange = this->m_UseCtRange;
+  params.m_Cache = this->GetCache();
 
   AccessByItk_3(image, CalculateFirstOrderStatistics, mask, featureList, params);
 
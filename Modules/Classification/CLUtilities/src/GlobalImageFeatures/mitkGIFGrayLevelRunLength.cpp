@@ -23,7 +23,6 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 // ITK
 #include <itkEnhancedScalarImageToRunLengthFeaturesFilter.h>
-#include <itkMinimumMaximumImageCalculator.h>
 
 // STL
 #include <sstream>
@@ -35,11 +34,9 @@ void
   typedef itk::Image<TPixel, VImageDimension> ImageType;
   typedef itk::Image<TPixel, VImageDimension> MaskType;
   typedef itk::Statistics::EnhancedScalarImageToRunLengthFeaturesFilter<ImageType> FilterType;
-  typedef itk::MinimumMaximumImageCalculator<ImageType> MinMaxComputerType;
   typedef typename FilterType::RunLengthFeaturesFilterType TextureFilterType;
 
-  typename MaskType::Pointer maskImage = MaskType::New();
-  mitk::CastToItkImage(mask, maskImage);
+  typename MaskType::Pointer maskImage = mitk::GlobalImageFeatureCache::CastMask<MaskType>(params.m_Cache, mask);
 
   typename FilterType::Pointer filter = FilterType::New();
 
@@ -89,9 +86,8 @@ void
   requestedFeatures->push_back(TextureFilterType::RunPercentage);
   requestedFeatures->push_back(TextureFilterType::NumberOfRuns);
 
-  typename MinMaxComputerType::Pointer minMaxComputer = MinMaxComputerType::New();
-  minMaxComputer->SetImage(itkImage);
-  minMaxComputer->Compute();
+  TPixel imageMinimum, imageMaximum;
+  mitk::GlobalImageFeatureCache::ComputeMinimumMaximum(params.m_Cache, itkImage, imageMinimum, imageMaximum);
 
   filter->SetInput(itkImage);
   filter->SetMaskImage(maskImage);
@@ -106,7 +102,7 @@ void
     filter->SetNumberOfBinsPerAxis(3096.5+1024.5);
   } else
   {
-    filter->SetPixelValueMinMax(minMaxComputer->GetMinimum(),minMaxComputer->GetMaximum());
+    filter->SetPixelValueMinMax(imageMinimum,imageMaximum);
     filter->SetNumberOfBinsPerAxis(rangeOfPixels);
   }
 
@@ -191,6 +187,7 @@ mitk::GIFGrayLevelRunLength::FeatureListType mitk::GIFGrayLevelRunLength::Calcul
   params.m_UseCtRange=m_UseCtRange;
   params.m_Range = m_Range;
   params.m_Direction = m_Direction;
+  params.m_Cache = GetCache();
 
   AccessByItk_3(image, CalculateGrayLevelRunLengthFeatures, mask, featureList,params);
 
@@ -25,6 +25,283 @@
 
 // Image Filter
 #include <itkDiscreteGaussianImageFilter.h>
+#include <itkTimeProbe.h>
+
+#include <mitkExceptionMacro.h>
+
+#include <algorithm>
+
+namespace
+{
+  // blocks of the adaptive prediction span step voxels from their origin in each direction, including the far corners
+  struct AdaptivePredictionBlock
+  {
+    int origin[3];
+  };
+
+  struct AdaptivePredictionState
+  {
+    enum VoxelState { Unknown = 0, Predicted = 1, Filled = 2 };
+
+    AdaptivePredictionState(const int * dim, const unsigned short * mask, const std::vector<const double *> & features)
+      : m_Mask(mask), m_Features(features), m_NumberOfClasses(-1)
+    {
+      std::copy(dim, dim+3, m_Dim);
+      const std::size_t numberOfVoxels = static_cast<std::size_t>(dim[0])*dim[1]*dim[2];
+      m_State.assign(numberOfVoxels, Unknown);
+      m_Labels.assign(numberOfVoxels, 0);
+    }
+
+    std::size_t Index(const int * p) const
+    {
+      return p[0] + static_cast<std::size_t>(m_Dim[0])*(p[1] + static_cast<std::size_t>(m_Dim[1])*p[2]);
+    }
+
+    // far end of the block in each direction, clipped to the image
+    void End(const AdaptivePredictionBlock & block, int step, int * end) const
+    {
+      for (int d = 0; d < 3; ++d)
+        end[d] = std::min(block.origin[d]+step, m_Dim[d]-1);
+    }
+
+    void Corner(const AdaptivePredictionBlock & block, const int * end, int c, int * p) const
+    {
+      for (int d = 0; d < 3; ++d)
+        p[d] = ((c >> d) & 1) ? end[d] : block.origin[d];
+    }
+
+    bool ContainsMask(const AdaptivePredictionBlock & block, int step) const
+    {
+      int end[3];
+      this->End(block, step, end);
+      int p[3];
+      for (p[2] = block.origin[2]; p[2] <= end[2]; ++p[2])
+        for (p[1] = block.origin[1]; p[1] <= end[1]; ++p[1])
+          for (p[0] = block.origin[0]; p[0] <= end[0]; ++p[0])
+            if (m_Mask[this->Index(p)] != 0)
+              return true;
+      return false;
+    }
+
+    // predicts the corners of all blocks that are inside of the mask and not predicted yet
+    unsigned int PredictCorners(const std::vector<AdaptivePredictionBlock> & blocks, int step, const mitk::CLUtil::PredictionFunctionType & function)
+    {
+      std::vector<std::size_t> corners;
+      for (const auto & block : blocks)
+      {
+        int end[3];
+        this->End(block, step, end);
+        for (int c = 0; c < 8; ++c)
+        {
+          int p[3];
+          this->Corner(block, end, c, p);
+          const std::size_t index = this->Index(p);
+          if (m_Mask[index] != 0 && m_State[index] != Predicted)
+          {
+            m_State[index] = Predicted;
+            corners.push_back(index);
+          }
+        }
+      }
+      if (corners.empty())
+        return 0;
+
+      const int numberOfFeatures = static_cast<int>(m_Features.size());
+      Eigen::MatrixXd X(corners.size(), numberOfFeatures);
+#pragma omp parallel for
+      for (int r = 0; r < static_cast<int>(corners.size()); ++r)
+        for (int f = 0; f < numberOfFeatures; ++f)
+          X(r, f) = m_Features[f][corners[r]];
+
+      Eigen::MatrixXi Y;
+      Eigen::MatrixXd P;
+      function(X, Y, P);
+      if (Y.rows() != X.rows() || Y.cols() < 1)
+        mitkThrow() << "The prediction function returned " << Y.rows() << " labels for " << X.rows() << " voxels";
+      if (m_NumberOfClasses < 0)
+      {
+        m_NumberOfClasses = static_cast<int>(P.cols());
+        m_Probabilities.assign(m_State.size()*m_NumberOfClasses, 0.0);
+      }
+      if (P.cols() != m_NumberOfClasses || (m_NumberOfClasses > 0 && P.rows() != X.rows()))
+        mitkThrow() << "The prediction function returned a probability matrix of inconsistent size";
+
+      for (int r = 0; r < static_cast<int>(corners.size()); ++r)
+      {
+        m_Labels[corners[r]] = Y(r, 0);
+        for (int c = 0; c < m_NumberOfClasses; ++c)
+          m_Probabilities[corners[r]*m_NumberOfClasses + c] = P(r, c);
+      }
+      return static_cast<unsigned int>(corners.size());
+    }
+
+    bool IsConfident(std::size_t index, double margin) const
+    {
+      if (m_NumberOfClasses < 2)
+        return true;
+      const double * p = &m_Probabilities[index*m_NumberOfClasses];
+      double first = p[0];
+      double second = p[1];
+      if (second > first)
+        std::swap(first, second);
+      for (int c = 2; c < m_NumberOfClasses; ++c)
+      {
+        if (p[c] > first)
+        {
+          second = first;
+          first = p[c];
+        }
+        else if (p[c] > second)
+        {
+          second = p[c];
+        }
+      }
+      return first - second >= margin;
+    }
+
+    // fills the block if all corners inside of the mask agree confidently, returns false if it has to be refined
+    bool FillBlock(const AdaptivePredictionBlock & block, int step, double margin, unsigned int & filledVoxels)
+    {
+      int end[3];
+      this->End(block, step, end);
+
+      std::size_t cornerIndex[8];
+      bool cornerInMask[8];
+      bool hasCorner = false;
+      int label = 0;
+      for (int c = 0; c < 8; ++c)
+      {
+        int p[3];
+        this->Corner(block, end, c, p);
+        cornerIndex[c] = this->Index(p);
+        cornerInMask[c] = m_Mask[cornerIndex[c]] != 0;
+        if (!cornerInMask[c])
+          continue;
+        if (!hasCorner)
+          label = m_Labels[cornerIndex[c]];
+        if (m_Labels[cornerIndex[c]] != label || !this->IsConfident(cornerIndex[c], margin))
+          return false;
+        hasCorner = true;
+      }
+      if (!hasCorner)
+        return false;
+
+      int p[3];
+      for (p[2] = block.origin[2]; p[2] <= end[2]; ++p[2])
+        for (p[1] = block.origin[1]; p[1] <= end[1]; ++p[1])
+          for (p[0] = block.origin[0]; p[0] <= end[0]; ++p[0])
+          {
+            const std::size_t index = this->Index(p);
+            if (m_Mask[index] == 0 || m_State[index] != Unknown)
+              continue;
+            m_State[index] = Filled;
+            m_Labels[index] = label;
+            ++filledVoxels;
+            if (m_NumberOfClasses > 0)
+              this->InterpolateProbabilities(block, end, p, cornerIndex, cornerInMask);
+          }
+      return true;
+    }
+
+    void InterpolateProbabilities(const AdaptivePredictionBlock & block, const int * end, const int * p, const std::size_t * cornerIndex, const bool * cornerInMask)
+    {
+      double t[3];
+      for (int d = 0; d < 3; ++d)
+        t[d] = end[d] > block.origin[d] ? static_cast<double>(p[d]-block.origin[d]) / (end[d]-block.origin[d]) : 0.0;
+
+      double * out = &m_Probabilities[this->Index(p)*m_NumberOfClasses];
+      std::fill(out, out+m_NumberOfClasses, 0.0);
+      double weightSum = 0;
+      int numberOfCorners = 0;
+      for (int c = 0; c < 8; ++c)
+      {
+        if (!cornerInMask[c])
+          continue;
+        double w = 1;
+        for (int d = 0; d < 3; ++d)
+          w *= ((c >> d) & 1) ? t[d] : 1.0-t[d];
+        weightSum += w;
+        ++numberOfCorners;
+      }
+      // if only the corners on the far side are inside of the mask, their mean is used
+      for (int c = 0; c < 8; ++c)
+      {
+        if (!cornerInMask[c])
+          continue;
+        double w = 1;
+        for (int d = 0; d < 3; ++d)
+          w *= ((c >> d) & 1) ? t[d] : 1.0-t[d];
+        w = weightSum > 0 ? w / weightSum : 1.0 / numberOfCorners;
+        const double * corner = &m_Probabilities[cornerIndex[c]*m_NumberOfClasses];
+        for (int k = 0; k < m_NumberOfClasses; ++k)
+          out[k] += w*corner[k];
+      }
+    }
+
+    int m_Dim[3];
+    const unsigned short * m_Mask;
+    std::vector<const double *> m_Features;
+    int m_NumberOfClasses;
+    std::vector<unsigned char> m_State;
+    std::vector<int> m_Labels;
+    std::vector<double> m_Probabilities;
+  };
+
+  std::vector<mitk::CLUtil::AdaptivePredictionLevel> AdaptivePredictionOnBuffers(AdaptivePredictionState & state, const mitk::CLUtil::PredictionFunctionType & function,
+                                                                                 int coarseStep, double margin)
+  {
+    std::vector<AdaptivePredictionBlock> blocks;
+    AdaptivePredictionBlock block;
+    for (block.origin[2] = 0; block.origin[2] < state.m_Dim[2]; block.origin[2] += coarseStep)
+      for (block.origin[1] = 0; block.origin[1] < state.m_Dim[1]; block.origin[1] += coarseStep)
+        for (block.origin[0] = 0; block.origin[0] < state.m_Dim[0]; block.origin[0] += coarseStep)
+          if (state.ContainsMask(block, coarseStep))
+            blocks.push_back(block);
+
+    std::vector<mitk::CLUtil::AdaptivePredictionLevel> levels;
+    for (int step = coarseStep; !blocks.empty(); step /= 2)
+    {
+      itk::TimeProbe clock;
+      clock.Start();
+
+      mitk::CLUtil::AdaptivePredictionLevel level;
+      level.step = step;
+      level.filledVoxels = 0;
+      level.refinedBlocks = 0;
+      level.predictedVoxels = state.PredictCorners(blocks, step, function);
+
+      // on the finest level all voxels of the blocks are corners
+      std::vector<AdaptivePredictionBlock> refinedBlocks;
+      const int half = step / 2;
+      for (int b = 0; step > 1 && b < static_cast<int>(blocks.size()); ++b)
+      {
+        if (state.FillBlock(blocks[b], step, margin, level.filledVoxels))
+          continue;
+        ++level.refinedBlocks;
+        for (int c = 0; c < 8; ++c)
+        {
+          AdaptivePredictionBlock child;
+          bool inside = true;
+          for (int d = 0; d < 3; ++d)
+          {
+            child.origin[d] = blocks[b].origin[d] + (((c >> d) & 1) ? half : 0);
+            inside = inside && child.origin[d] < state.m_Dim[d];
+          }
+          if (inside && state.ContainsMask(child, half))
+            refinedBlocks.push_back(child);
+        }
+      }
+      blocks.swap(refinedBlocks);
+
+      clock.Stop();
+      level.seconds = clock.GetTotal();
+      levels.push_back(level);
+      MITK_INFO << "Adaptive prediction with step " << step << ": " << level.predictedVoxels << " voxels predicted, "
+                << level.filledVoxels << " voxels filled, " << level.refinedBlocks << " blocks refined in " << level.seconds << "s";
+    }
+    return levels;
+  }
+}
 
 void mitk::CLUtil::ProbabilityMap(const mitk::Image::Pointer & image , double mean, double stddev, mitk::Image::Pointer & outimage)
 {
@@ -97,6 +374,70 @@ void mitk::CLUtil::InterpolateCheckerboardPrediction(mitk::Image::Pointer checke
   AccessFixedDimensionByItk_2(checkerboard_prediction, mitk::CLUtil::itkInterpolateCheckerboardPrediction,3, checkerboard_mask, outimage);
 }
 
+std::vector<mitk::CLUtil::AdaptivePredictionLevel> mitk::CLUtil::AdaptivePrediction(const std::vector<mitk::Image::Pointer> & features, const mitk::Image::Pointer & mask, const PredictionFunctionType & function,
+                                                                                    mitk::Image::Pointer & labelImage, std::vector<mitk::Image::Pointer> & probabilityImages, unsigned int coarseStep, double margin)
+{
+  if (coarseStep == 0 || (coarseStep & (coarseStep-1)) != 0)
+    mitkThrow() << "The coarse step of the adaptive prediction has to be a power of two, but is " << coarseStep;
+  if (features.empty())
+    mitkThrow() << "The adaptive prediction needs at least one feature image";
+
+  typedef itk::Image<double, 3> FeatureImageType;
+  typedef itk::Image<unsigned short, 3> LabelImageType;
+
+  LabelImageType::Pointer itk_mask;
+  mitk::CastToItkImage(mask, itk_mask);
+  const LabelImageType::SizeType size = itk_mask->GetLargestPossibleRegion().GetSize();
+
+  std::vector<FeatureImageType::Pointer> itk_features(features.size());
+  std::vector<const double *> featureBuffers(features.size());
+  for (unsigned int i = 0; i < features.size(); ++i)
+  {
+    mitk::CastToItkImage(features[i], itk_features[i]);
+    if (itk_features[i]->GetLargestPossibleRegion().GetSize() != size)
+      mitkThrow() << "Feature image " << i << " does not match the size of the mask";
+    featureBuffers[i] = itk_features[i]->GetBufferPointer();
+  }
+
+  const int dim[3] = { static_cast<int>(size[0]), static_cast<int>(size[1]), static_cast<int>(size[2]) };
+  AdaptivePredictionState state(dim, itk_mask->GetBufferPointer(), featureBuffers);
+  std::vector<AdaptivePredictionLevel> levels = AdaptivePredictionOnBuffers(state, function, coarseStep, margin);
+
+  LabelImageType::Pointer itk_labels = LabelImageType::New();
+  itk_labels->CopyInformation(itk_mask);
+  itk_labels->SetRegions(itk_mask->GetLargestPossibleRegion());
+  itk_labels->Allocate();
+  itk_labels->FillBuffer(0);
+  LabelImageType::PixelType * labelBuffer = itk_labels->GetBufferPointer();
+
+  const int numberOfClasses = std::max(state.m_NumberOfClasses, 0);
+  std::vector<FeatureImageType::Pointer> itk_probabilities(numberOfClasses);
+  for (int c = 0; c < numberOfClasses; ++c)
+  {
+    itk_probabilities[c] = FeatureImageType::New();
+    itk_probabilities[c]->CopyInformation(itk_mask);
+    itk_probabilities[c]->SetRegions(itk_mask->GetLargestPossibleRegion());
+    itk_probabilities[c]->Allocate();
+    itk_probabilities[c]->FillBuffer(0);
+  }
+
+  const std::size_t numberOfVoxels = state.m_State.size();
+  for (std::size_t i = 0; i < numberOfVoxels; ++i)
+  {
+    if (state.m_Mask[i] == 0)
+      continue;
+    labelBuffer[i] = static_cast<LabelImageType::PixelType>(state.m_Labels[i]);
+    for (int c = 0; c < numberOfClasses; ++c)
+      itk_probabilities[c]->GetBufferPointer()[i] = state.m_Probabilities[i*numberOfClasses + c];
+  }
+
+  mitk::CastToMitkImage(itk_labels, labelImage);
+  probabilityImages.resize(numberOfClasses);
+  for (int c = 0; c < numberOfClasses; ++c)
+    mitk::CastToMitkImage(itk_probabilities[c], probabilityImages[c]);
+  return levels;
+}
+
 void mitk::CLUtil::GaussianFilter(mitk::Image::Pointer image, mitk::Image::Pointer & smoothed ,double sigma)
 {
   AccessFixedDimensionByItk_2(image, mitk::CLUtil::itkGaussianFilter,3, smoothed, sigma);
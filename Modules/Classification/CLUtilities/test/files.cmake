@@ -1,4 +1,7 @@
 set(MODULE_TESTS
   #mitkSmoothedClassProbabilitesTest.cpp
   mitkGlobalFeaturesTest.cpp
+  mitkNeighborhoodFunctorImageFilterTest.cpp
+  mitkAdaptivePredictionTest.cpp
+  mitkEnhancedTextureFeaturesFilterTest.cpp
 )
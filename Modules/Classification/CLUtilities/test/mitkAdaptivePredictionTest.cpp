@@ -0,0 +1,172 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+#include <mitkIOUtil.h>
+
+#include <mitkCLUtil.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkTimeProbe.h>
+#include <cmath>
+
+class mitkAdaptivePredictionTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkAdaptivePredictionTestSuite);
+  MITK_TEST(AdaptivePrediction_CoarseStepOne_EqualsDensePrediction);
+  MITK_TEST(AdaptivePrediction_NoConfidentBlock_EqualsDensePrediction);
+  MITK_TEST(AdaptivePrediction_Pic3D_AgreesWithDensePrediction);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  typedef itk::Image<double,3> ImageType;
+  typedef itk::Image<unsigned short,3> LabelImageType;
+
+  std::vector<mitk::Image::Pointer> m_Features;
+  mitk::Image::Pointer m_Mask;
+  mitk::CLUtil::PredictionFunctionType m_Function;
+  double m_Threshold;
+  unsigned int m_PredictedVoxels;
+
+  // labels and probabilities of all voxels of the mask
+  mitk::Image::Pointer m_DenseLabels;
+  double m_DenseSeconds;
+
+public:
+
+  void setUp() override
+  {
+    mitk::Image::Pointer image = mitk::IOUtil::LoadImage(GetTestDataFilePath("Pic3D.nrrd"));
+    mitk::Image::Pointer smoothed;
+    mitk::CLUtil::GaussianFilter(image, smoothed, 2.0);
+    m_Features.clear();
+    m_Features.push_back(smoothed);
+    m_Features.push_back(image);
+
+    ImageType::Pointer itk_smoothed;
+    mitk::CastToItkImage(smoothed, itk_smoothed);
+    double sum = 0;
+    unsigned int count = 0;
+    for (itk::ImageRegionConstIterator<ImageType> it(itk_smoothed, itk_smoothed->GetLargestPossibleRegion()); !it.IsAtEnd(); ++it, ++count)
+      sum += it.Get();
+    m_Threshold = sum / count;
+
+    LabelImageType::Pointer itk_mask = LabelImageType::New();
+    itk_mask->CopyInformation(itk_smoothed);
+    itk_mask->SetRegions(itk_smoothed->GetLargestPossibleRegion());
+    itk_mask->Allocate();
+    itk_mask->FillBuffer(1);
+    mitk::CastToMitkImage(itk_mask, m_Mask);
+
+    // two classes separated by a soft threshold on the smoothed intensity
+    m_PredictedVoxels = 0;
+    m_Function = [this](const Eigen::MatrixXd &X, Eigen::MatrixXi &Y, Eigen::MatrixXd &P)
+    {
+      m_PredictedVoxels += X.rows();
+      Y.resize(X.rows(), 1);
+      P.resize(X.rows(), 2);
+      for (int r = 0; r < X.rows(); ++r)
+      {
+        P(r, 1) = 1.0 / (1.0 + std::exp(-(X(r, 0) - m_Threshold) / 20.0));
+        P(r, 0) = 1.0 - P(r, 1);
+        Y(r, 0) = P(r, 1) > 0.5 ? 1 : 0;
+      }
+    };
+
+    itk::TimeProbe clock;
+    clock.Start();
+    Eigen::MatrixXd X = mitk::CLUtil::Transform<double>(m_Features[0], m_Mask);
+    Eigen::MatrixXi Y;
+    Eigen::MatrixXd P;
+    m_Function(X, Y, P);
+    m_DenseLabels = mitk::CLUtil::Transform<int>(Y, m_Mask);
+    clock.Stop();
+    m_DenseSeconds = clock.GetTotal();
+    m_PredictedVoxels = 0;
+  }
+
+  void tearDown() override
+  {
+    m_Features.clear();
+    m_Mask = nullptr;
+    m_DenseLabels = nullptr;
+  }
+
+  unsigned int CountDifferences(const mitk::Image::Pointer & labels)
+  {
+    LabelImageType::Pointer itk_labels;
+    LabelImageType::Pointer itk_dense;
+    mitk::CastToItkImage(labels, itk_labels);
+    mitk::CastToItkImage(m_DenseLabels, itk_dense);
+    itk::ImageRegionConstIterator<LabelImageType> it(itk_labels, itk_labels->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<LabelImageType> dit(itk_dense, itk_dense->GetLargestPossibleRegion());
+    unsigned int differences = 0;
+    for (; !it.IsAtEnd(); ++it, ++dit)
+      differences += it.Get() != dit.Get() ? 1 : 0;
+    return differences;
+  }
+
+  void AdaptivePrediction_CoarseStepOne_EqualsDensePrediction()
+  {
+    mitk::Image::Pointer labels;
+    std::vector<mitk::Image::Pointer> probabilities;
+    auto levels = mitk::CLUtil::AdaptivePrediction(m_Features, m_Mask, m_Function, labels, probabilities, 1, 0.2);
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("One level", std::size_t(1), levels.size());
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("One probability image per class", std::size_t(2), probabilities.size());
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("All voxels are predicted", m_Mask->GetDimension(0)*m_Mask->GetDimension(1)*m_Mask->GetDimension(2), m_PredictedVoxels);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Labels equal the dense prediction", 0u, CountDifferences(labels));
+  }
+
+  void AdaptivePrediction_NoConfidentBlock_EqualsDensePrediction()
+  {
+    // with a margin above one, every block is refined down to single voxels
+    mitk::Image::Pointer labels;
+    std::vector<mitk::Image::Pointer> probabilities;
+    auto levels = mitk::CLUtil::AdaptivePrediction(m_Features, m_Mask, m_Function, labels, probabilities, 4, 2.0);
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Levels with step 4, 2 and 1", std::size_t(3), levels.size());
+    for (const auto & level : levels)
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("No voxel is filled", 0u, level.filledVoxels);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Labels equal the dense prediction", 0u, CountDifferences(labels));
+  }
+
+  void AdaptivePrediction_Pic3D_AgreesWithDensePrediction()
+  {
+    mitk::Image::Pointer labels;
+    std::vector<mitk::Image::Pointer> probabilities;
+    itk::TimeProbe clock;
+    clock.Start();
+    auto levels = mitk::CLUtil::AdaptivePrediction(m_Features, m_Mask, m_Function, labels, probabilities, 8, 0.2);
+    clock.Stop();
+
+    const unsigned int numberOfVoxels = m_Mask->GetDimension(0)*m_Mask->GetDimension(1)*m_Mask->GetDimension(2);
+    const unsigned int differences = CountDifferences(labels);
+    const double agreement = 1.0 - static_cast<double>(differences) / numberOfVoxels;
+    for (const auto & level : levels)
+      MITK_INFO << "Step " << level.step << ": " << level.predictedVoxels << " predicted, " << level.filledVoxels << " filled, " << level.seconds << "s";
+    MITK_INFO << "Adaptive prediction of " << m_PredictedVoxels << " of " << numberOfVoxels << " voxels in " << clock.GetTotal()
+              << "s, dense prediction in " << m_DenseSeconds << "s, agreement " << agreement;
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Levels with step 8, 4, 2 and 1", std::size_t(4), levels.size());
+    CPPUNIT_ASSERT_MESSAGE("Fewer voxels are predicted than by the dense prediction", m_PredictedVoxels < numberOfVoxels);
+    CPPUNIT_ASSERT_MESSAGE("Labels agree with the dense prediction", agreement > 0.98);
+  }
+
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkAdaptivePrediction)
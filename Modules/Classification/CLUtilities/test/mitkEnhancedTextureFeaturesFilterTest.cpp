@@ -0,0 +1,214 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+#include "mitkIOUtil.h"
+
+#include <mitkImageCast.h>
+#include <itkEnhancedScalarImageToTextureFeaturesFilter.h>
+#include <itkEnhancedScalarImageToRunLengthMatrixFilter.h>
+#include <itkScalarImageToCooccurrenceMatrixFilter.h>
+#include <itkMinimumMaximumImageCalculator.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkNeighborhood.h>
+
+class mitkEnhancedTextureFeaturesFilterTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkEnhancedTextureFeaturesFilterTestSuite);
+  MITK_TEST(Cooccurrence_AllOffsets_EqualsSingleOffsetFilter);
+  MITK_TEST(RunLength_AllOffsets_EqualsSingleOffsetFilter);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  typedef itk::Image<double,3> ImageType;
+  typedef itk::Statistics::EnhancedScalarImageToTextureFeaturesFilter<ImageType> FilterType;
+  typedef FilterType::TextureFeaturesFilterType TextureFilterType;
+  typedef itk::Statistics::ScalarImageToCooccurrenceMatrixFilter<ImageType> CooccurrenceFilterType;
+  typedef itk::Statistics::EnhancedScalarImageToRunLengthMatrixFilter<ImageType> RunLengthFilterType;
+
+  ImageType::Pointer m_Image;
+  ImageType::Pointer m_Mask;
+
+  /** Compares the run length matrices of all offsets with one update of the filter per offset. */
+  void CheckRunLengthMatrices(ImageType *image, ImageType *mask)
+  {
+    // half of the neighbours one pixel away, as used by the run length features filter
+    itk::Neighborhood<double, 3> hood;
+    hood.SetRadius(1);
+    RunLengthFilterType::OffsetVectorPointer offsets = RunLengthFilterType::OffsetVector::New();
+    for (unsigned int d = 0; d < hood.GetCenterNeighborhoodIndex(); ++d)
+    {
+      offsets->push_back(hood.GetOffset(d));
+    }
+
+    RunLengthFilterType::Pointer filter = RunLengthFilterType::New();
+    filter->SetInput(image);
+    if (mask != nullptr)
+      filter->SetMaskImage(mask);
+    filter->SetOffsets(offsets);
+    filter->SetPixelValueMinMax(0, 4);
+    filter->SetDistanceValueMinMax(0, 16);
+    filter->SetNumberOfBinsPerAxis(5);
+    std::vector<RunLengthFilterType::HistogramPointer> matrices;
+    filter->ComputeRunLengthMatrices(matrices);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("One matrix per offset", static_cast<std::size_t>(offsets->size()), matrices.size());
+
+    for (unsigned int offsetNum = 0; offsetNum < offsets->size(); ++offsetNum)
+    {
+      RunLengthFilterType::Pointer reference = RunLengthFilterType::New();
+      reference->SetInput(image);
+      if (mask != nullptr)
+        reference->SetMaskImage(mask);
+      reference->SetOffset(offsets->GetElement(offsetNum));
+      reference->SetPixelValueMinMax(0, 4);
+      reference->SetDistanceValueMinMax(0, 16);
+      reference->SetNumberOfBinsPerAxis(5);
+      reference->Update();
+      const RunLengthFilterType::HistogramType *expected = reference->GetOutput();
+      const RunLengthFilterType::HistogramType *matrix = matrices[offsetNum];
+
+      CPPUNIT_ASSERT_MESSAGE("Runs were counted", expected->GetTotalFrequency() > 0);
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Matrix size equals the single offset filter", expected->Size(), matrix->Size());
+      for (unsigned int bin = 0; bin < expected->Size(); ++bin)
+      {
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Run length matrix equals the single offset filter", expected->GetFrequency(bin), matrix->GetFrequency(bin));
+      }
+    }
+  }
+
+public:
+
+  void setUp() override
+  {
+    mitk::Image::Pointer image = mitk::IOUtil::LoadImage(GetTestDataFilePath("Pic3D.nrrd"));
+    mitk::CastToItkImage(image, m_Image);
+
+    // Box in the center of the image, with many different gray values
+    m_Mask = ImageType::New();
+    m_Mask->CopyInformation(m_Image);
+    m_Mask->SetRegions(m_Image->GetLargestPossibleRegion());
+    m_Mask->Allocate();
+    ImageType::SizeType size = m_Image->GetLargestPossibleRegion().GetSize();
+    itk::ImageRegionIteratorWithIndex<ImageType> it(m_Mask, m_Mask->GetLargestPossibleRegion());
+    for (; !it.IsAtEnd(); ++it)
+    {
+      bool inside = true;
+      for (unsigned int d = 0; d < 3; ++d)
+      {
+        inside = inside && it.GetIndex()[d] >= static_cast<long>(size[d] / 4) && it.GetIndex()[d] < static_cast<long>(3 * size[d] / 4);
+      }
+      it.Set(inside ? 1 : 0);
+    }
+  }
+
+  void tearDown() override
+  {
+    m_Image = nullptr;
+    m_Mask = nullptr;
+  }
+
+  void Cooccurrence_AllOffsets_EqualsSingleOffsetFilter()
+  {
+    itk::MinimumMaximumImageCalculator<ImageType>::Pointer minMaxComputer = itk::MinimumMaximumImageCalculator<ImageType>::New();
+    minMaxComputer->SetImage(m_Image);
+    minMaxComputer->Compute();
+    const double minimum = minMaxComputer->GetMinimum();
+    const double maximum = minMaxComputer->GetMaximum();
+    const unsigned int numberOfBins = 32;
+
+    FilterType::FeatureNameVectorPointer requestedFeatures = FilterType::FeatureNameVector::New();
+    requestedFeatures->push_back(TextureFilterType::Energy);
+    requestedFeatures->push_back(TextureFilterType::Entropy);
+    requestedFeatures->push_back(TextureFilterType::Correlation);
+    requestedFeatures->push_back(TextureFilterType::Inertia);
+    requestedFeatures->push_back(TextureFilterType::ClusterShade);
+    requestedFeatures->push_back(TextureFilterType::SumAverage);
+
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetInput(m_Image);
+    filter->SetMaskImage(m_Mask);
+    filter->SetInsidePixelValue(1);
+    filter->SetRequestedFeatures(requestedFeatures);
+    filter->SetPixelValueMinMax(minimum, maximum);
+    filter->SetNumberOfBinsPerAxis(numberOfBins);
+    filter->Update();
+    FilterType::FeatureValueVectorPointer means = filter->GetFeatureMeans();
+
+    // Reference: one co-occurrence matrix filter update per offset
+    std::vector<double> referenceMeans(requestedFeatures->size(), 0.0);
+    FilterType::OffsetVectorConstPointer offsets = filter->GetOffsets();
+    for (FilterType::OffsetVector::ConstIterator offsetIt = offsets->Begin(); offsetIt != offsets->End(); ++offsetIt)
+    {
+      CooccurrenceFilterType::Pointer cooccurrence = CooccurrenceFilterType::New();
+      cooccurrence->SetInput(m_Image);
+      cooccurrence->SetMaskImage(m_Mask);
+      cooccurrence->SetInsidePixelValue(1);
+      cooccurrence->SetPixelValueMinMax(minimum, maximum);
+      cooccurrence->SetNumberOfBinsPerAxis(numberOfBins);
+      cooccurrence->SetOffset(offsetIt.Value());
+
+      TextureFilterType::Pointer texture = TextureFilterType::New();
+      texture->SetInput(cooccurrence->GetOutput());
+      texture->Update();
+      for (unsigned int featureNum = 0; featureNum < requestedFeatures->size(); ++featureNum)
+      {
+        referenceMeans[featureNum] += texture->GetFeature((TextureFilterType::TextureFeatureName)requestedFeatures->GetElement(featureNum)) / offsets->size();
+      }
+    }
+
+    for (unsigned int featureNum = 0; featureNum < requestedFeatures->size(); ++featureNum)
+    {
+      const double tolerance = 1e-9 * std::max(1.0, std::abs(referenceMeans[featureNum]));
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Feature mean equals the mean of the single offset filters", referenceMeans[featureNum], means->GetElement(featureNum), tolerance);
+    }
+  }
+
+  void RunLength_AllOffsets_EqualsSingleOffsetFilter()
+  {
+    // Small non-cubic image with runs of different lengths in all directions
+    ImageType::SizeType size;
+    size[0] = 13;
+    size[1] = 9;
+    size[2] = 7;
+    ImageType::Pointer image = ImageType::New();
+    image->SetRegions(ImageType::RegionType(size));
+    image->Allocate();
+    ImageType::Pointer mask = ImageType::New();
+    mask->SetRegions(ImageType::RegionType(size));
+    mask->Allocate();
+
+    itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion());
+    itk::ImageRegionIteratorWithIndex<ImageType> maskIt(mask, mask->GetLargestPossibleRegion());
+    for (; !it.IsAtEnd(); ++it, ++maskIt)
+    {
+      const ImageType::IndexType index = it.GetIndex();
+      it.Set((index[0] / 3 + index[1] / 2 + index[2]) % 5);
+      const bool inside = index[0] >= 2 && index[0] < 11 && index[1] >= 1 && index[2] >= 1 && index[2] < 6;
+      maskIt.Set(inside ? 1 : 0);
+    }
+
+    // value outside of the intensity range, which interrupts the runs
+    ImageType::IndexType outOfRange = {{6, 4, 3}};
+    image->SetPixel(outOfRange, 100);
+
+    CheckRunLengthMatrices(image, nullptr);
+    CheckRunLengthMatrices(image, mask);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkEnhancedTextureFeaturesFilter)
@@ -22,6 +22,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkGIFFirstOrderStatistics.h>
 #include <mitkGIFCooccurenceMatrix.h>
 #include <mitkGIFGrayLevelRunLength.h>
+#include <mitkGIFVolumetricStatistics.h>
 #include <math.h>
 
 #include <mitkImageGenerator.h>
@@ -120,6 +121,7 @@ class mitkGlobalFeaturesTestSuite : public mitk::TestFixture
   MITK_TEST(FirstOrder_QubicArea);
   //MITK_TEST(RunLenght_QubicArea);
   MITK_TEST(Coocurrence_QubicArea);
+  MITK_TEST(Cache_SharedByAllFeatureClasses_EqualsUncachedFeatures);
   //MITK_TEST(TestFirstOrderStatistic);
   //  MITK_TEST(TestThreadedDecisionForest);
 
@@ -312,6 +314,43 @@ public:
     CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("The mean homogenity1 value should be 1.0",1, results["co-occ. (1) Homogeneity1 Means"], mitk::eps);
     CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("The mean InverseDifferenceMoment value should be 1.0",1, results["co-occ. (1) InverseDifferenceMoment Means"], mitk::eps);
   }
+
+  void Cache_SharedByAllFeatureClasses_EqualsUncachedFeatures()
+  {
+    std::vector<mitk::AbstractGlobalImageFeature::Pointer> calculators;
+    calculators.push_back(mitk::GIFFirstOrderStatistics::New().GetPointer());
+    calculators.push_back(mitk::GIFVolumetricStatistics::New().GetPointer());
+    mitk::GIFCooccurenceMatrix::Pointer coocCalculator = mitk::GIFCooccurenceMatrix::New();
+    coocCalculator->SetDirection(1);
+    calculators.push_back(coocCalculator.GetPointer());
+    mitk::GIFGrayLevelRunLength::Pointer runLengthCalculator = mitk::GIFGrayLevelRunLength::New();
+    runLengthCalculator->SetDirection(1);
+    calculators.push_back(runLengthCalculator.GetPointer());
+
+    mitk::GlobalImageFeatureCache cache(m_Image, m_Mask1);
+    for (auto calculator : calculators)
+    {
+      auto features = calculator->CalculateFeatures(m_Image, m_Mask1);
+      calculator->SetCache(&cache);
+      auto cachedFeatures = calculator->CalculateFeatures(m_Image, m_Mask1);
+      calculator->SetCache(nullptr);
+
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("The cache does not change the number of features", features.size(), cachedFeatures.size());
+      for (std::size_t i = 0; i < features.size(); ++i)
+      {
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("The cache does not change the feature names", features[i].first, cachedFeatures[i].first);
+        // undefined features (NaN) can not be compared
+        if (features[i].second == features[i].second)
+        {
+          CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE(features[i].first, features[i].second, cachedFeatures[i].second, 0);
+        }
+      }
+    }
+
+    auto stageTimes = cache.GetStageTimes();
+    CPPUNIT_ASSERT_MESSAGE("The mask was cast by the cache", stageTimes.count("Mask casting") == 1);
+    CPPUNIT_ASSERT_MESSAGE("The intensity range was computed by the cache", stageTimes.count("Minimum/Maximum") == 1);
+  }
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkGlobalFeatures)
\ No newline at end of file
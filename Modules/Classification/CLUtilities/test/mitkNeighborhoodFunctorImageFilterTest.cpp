@@ -0,0 +1,149 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+
+#include <itkNeighborhoodFunctorImageFilter.h>
+#include <itkFirstOrderStatisticsFeatureFunctor.h>
+#include <itkCoocurenceMatrixFeatureFunctor.h>
+#include <itkImageRegionIterator.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <random>
+
+class mitkNeighborhoodFunctorImageFilterTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkNeighborhoodFunctorImageFilterTestSuite);
+  MITK_TEST(FirstOrder_Incremental_EqualsFullWindow);
+  MITK_TEST(Cooccurence_Incremental_EqualsFullWindow);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  typedef itk::Image<double,3> ImageType;
+  typedef itk::ConstNeighborhoodIterator<ImageType> NeighborhoodType;
+  typedef itk::Image<short,3> MaskType;
+
+  ImageType::Pointer m_Image;
+  MaskType::Pointer m_Mask;
+
+  template<class TFilter>
+  void CompareOutputs(TFilter* full, TFilter* incremental, double tolerance)
+  {
+    for (unsigned int i = 0; i < full->GetNumberOfOutputs(); ++i)
+    {
+      itk::ImageRegionIterator<ImageType> fullIt(full->GetOutput(i), m_Image->GetLargestPossibleRegion());
+      itk::ImageRegionIterator<ImageType> incrementalIt(incremental->GetOutput(i), m_Image->GetLargestPossibleRegion());
+      itk::ImageRegionIterator<MaskType> maskIt(m_Mask, m_Image->GetLargestPossibleRegion());
+      for (; !fullIt.IsAtEnd(); ++fullIt, ++incrementalIt, ++maskIt)
+      {
+        if (maskIt.Get() == 0)
+          continue;
+        CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Incremental window equals full window", fullIt.Get(), incrementalIt.Get(), tolerance*(1+std::abs(fullIt.Get())));
+      }
+    }
+  }
+
+public:
+
+  void setUp() override
+  {
+    ImageType::RegionType region;
+    region.SetSize(0, 23);
+    region.SetSize(1, 17);
+    region.SetSize(2, 9);
+
+    m_Image = ImageType::New();
+    m_Image->SetRegions(region);
+    m_Image->Allocate();
+
+    m_Mask = MaskType::New();
+    m_Mask->SetRegions(region);
+    m_Mask->Allocate();
+
+    // gray values from a small range and a mask with gaps in every line. The co-occurrence
+    // neighbors of the windows are read from the image, so the mask keeps a distance to the border.
+    std::mt19937 randGen(1);
+    std::uniform_int_distribution<int> value(100, 109);
+    std::uniform_int_distribution<int> inside(0, 4);
+    ImageType::RegionType maskRegion = region;
+    maskRegion.ShrinkByRadius(2);
+    itk::ImageRegionIteratorWithIndex<ImageType> imageIt(m_Image, region);
+    itk::ImageRegionIterator<MaskType> maskIt(m_Mask, region);
+    for (; !imageIt.IsAtEnd(); ++imageIt, ++maskIt)
+    {
+      imageIt.Set(value(randGen));
+      maskIt.Set(inside(randGen) != 0 && maskRegion.IsInside(imageIt.GetIndex()));
+    }
+  }
+
+  void tearDown() override
+  {
+    m_Image = nullptr;
+    m_Mask = nullptr;
+  }
+
+  void FirstOrder_Incremental_EqualsFullWindow()
+  {
+    typedef itk::Functor::NeighborhoodFirstOrderStatistics<NeighborhoodType, double> FunctorType;
+    typedef itk::NeighborhoodFunctorImageFilter<ImageType, ImageType, FunctorType> FilterType;
+
+    FilterType::Pointer full = FilterType::New();
+    full->SetNeighborhoodSize(2);
+    full->SetInput(m_Image);
+    full->SetMask(m_Mask);
+    full->Update();
+
+    FilterType::Pointer incremental = FilterType::New();
+    incremental->SetNeighborhoodSize(2);
+    incremental->SetInput(m_Image);
+    incremental->SetMask(m_Mask);
+    incremental->IncrementalOn();
+    incremental->Update();
+
+    CompareOutputs(full.GetPointer(), incremental.GetPointer(), 1e-8);
+  }
+
+  void Cooccurence_Incremental_EqualsFullWindow()
+  {
+    typedef itk::Functor::NeighborhoodCooccurenceMatrix<NeighborhoodType, double> FunctorType;
+    typedef itk::NeighborhoodFunctorImageFilter<ImageType, ImageType, FunctorType> FilterType;
+
+    FunctorType functor;
+    functor.DirectionFlags(FunctorType::DIR_x1_x0_x0 | FunctorType::DIR_x1_x1_x0 | FunctorType::DIR_x0_x0_x1);
+    functor.SetRange(100, 109);
+
+    FilterType::Pointer full = FilterType::New();
+    full->SetNeighborhoodSize(1);
+    full->SetInput(m_Image);
+    full->SetMask(m_Mask);
+    full->SetFunctor(functor);
+    full->Update();
+
+    FilterType::Pointer incremental = FilterType::New();
+    incremental->SetNeighborhoodSize(1);
+    incremental->SetInput(m_Image);
+    incremental->SetMask(m_Mask);
+    incremental->SetFunctor(functor);
+    incremental->IncrementalOn();
+    incremental->Update();
+
+    // the co-occurrence counts are integers, so the features are identical
+    CompareOutputs(full.GetPointer(), incremental.GetPointer(), 0);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkNeighborhoodFunctorImageFilter)
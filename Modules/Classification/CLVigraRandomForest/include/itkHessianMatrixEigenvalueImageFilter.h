@@ -18,6 +18,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #define ITKHESSIANMATRIXEIGENVALUEIMAGEFILTER_H
 
 #include <itkImageToImageFilter.h>
+#include <vector>
 
 namespace itk
 {
@@ -40,12 +41,22 @@ namespace itk
     itkSetMacro(Sigma,double)
       itkGetMacro(Sigma,double)
 
+    /**
+    * \brief Multi-scale mode: computes the eigenvalue images of all sigmas, which have to be increasing.
+    * Output 3*i+j is eigenvalue image j of sigma i. Each scale is smoothed from the previous one and the
+    * eigenvalues are computed in closed form. An empty list switches back to the single scale mode (Sigma).
+    */
+    void SetSigmas(const std::vector<double> & sigmas);
+    itkGetConstReferenceMacro(Sigmas, std::vector<double>);
+
   private:
 
     typename TMaskImageType::Pointer m_ImageMask;
     double m_Sigma;
+    std::vector<double> m_Sigmas;
 
     void GenerateData();
+    void GenerateMultiScaleData(const TInputImageType * input);
     void GenerateOutputInformation();
 
     HessianMatrixEigenvalueImageFilter();
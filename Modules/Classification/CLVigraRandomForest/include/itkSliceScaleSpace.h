@@ -0,0 +1,271 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef ITKSLICESCALESPACE_H
+#define ITKSLICESCALESPACE_H
+
+#include <itkMacro.h>
+#include <vigra/separableconvolution.hxx>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace itk
+{
+  /**
+  * \brief Gaussian scale space of one 2D slice for multi-scale derivative features.
+  *
+  * The slice is smoothed incrementally: going from scale s0 to s1 only needs a Gaussian of
+  * sqrt(s1^2-s0^2), so the kernels stay short and no scale starts from the original slice again.
+  * The derivatives at a scale are taken from the previous scale with derivative-of-Gaussian kernels
+  * of the residual sigma. At the first scale, this equals vigra::hessianMatrixOfGaussian and
+  * vigra::gaussianGradient, later scales differ from them only by the sampling of the kernels.
+  *
+  * All derivatives of a scale and the smoothing to the next scale are computed in one separable
+  * pass: the rows are convolved with all kernels at once, then the columns of all intermediate
+  * images. Both passes run over contiguous rows and vectorize. Borders are reflected like in vigra.
+  * Scales have to be passed in increasing order. One scale space is used per thread.
+  */
+  template< class TValue >
+  class SliceScaleSpace
+  {
+  public:
+
+    SliceScaleSpace(const TValue* slice, unsigned int width, unsigned int height)
+      : m_Width(width)
+      , m_Height(height)
+      , m_Scale(0)
+      , m_Smoothed(slice, slice + static_cast<std::size_t>(width)*height)
+    {
+    }
+
+    double GetScale() const { return m_Scale; }
+
+    /** The slice smoothed to the current scale. */
+    const std::vector<double>& GetSmoothed() const { return m_Smoothed; }
+
+    /** Hessian matrix (xx, xy, yy) at sigma. Advances the scale space to sigma. */
+    void Hessian(double sigma, double* xx, double* xy, double* yy)
+    {
+      Kernel smooth, deriv1, deriv2;
+      this->InitializeKernels(sigma, smooth, deriv1, deriv2);
+
+      const std::size_t size = static_cast<std::size_t>(m_Width)*m_Height;
+      m_RowsSmooth.resize(size);
+      m_RowsDeriv1.resize(size);
+      m_RowsDeriv2.resize(size);
+      m_Next.resize(size);
+      {
+        const Kernel* kernels[3] = { &smooth, &deriv1, &deriv2 };
+        double* outputs[3] = { m_RowsSmooth.data(), m_RowsDeriv1.data(), m_RowsDeriv2.data() };
+        this->ConvolveRows(m_Smoothed.data(), kernels, outputs, 3);
+      }
+      {
+        const double* inputs[4] = { m_RowsDeriv2.data(), m_RowsDeriv1.data(), m_RowsSmooth.data(), m_RowsSmooth.data() };
+        const Kernel* kernels[4] = { &smooth, &deriv1, &deriv2, &smooth };
+        double* outputs[4] = { xx, xy, yy, m_Next.data() };
+        this->ConvolveColumns(inputs, kernels, outputs, 4);
+      }
+      m_Smoothed.swap(m_Next);
+      m_Scale = sigma;
+    }
+
+    /** Gradient (x, y) at sigma. Advances the scale space to sigma. */
+    void Gradient(double sigma, double* gx, double* gy)
+    {
+      Kernel smooth, deriv1, deriv2;
+      this->InitializeKernels(sigma, smooth, deriv1, deriv2);
+
+      const std::size_t size = static_cast<std::size_t>(m_Width)*m_Height;
+      m_RowsSmooth.resize(size);
+      m_RowsDeriv1.resize(size);
+      m_Next.resize(size);
+      {
+        const Kernel* kernels[2] = { &smooth, &deriv1 };
+        double* outputs[2] = { m_RowsSmooth.data(), m_RowsDeriv1.data() };
+        this->ConvolveRows(m_Smoothed.data(), kernels, outputs, 2);
+      }
+      {
+        const double* inputs[3] = { m_RowsDeriv1.data(), m_RowsSmooth.data(), m_RowsSmooth.data() };
+        const Kernel* kernels[3] = { &smooth, &deriv1, &smooth };
+        double* outputs[3] = { gx, gy, m_Next.data() };
+        this->ConvolveColumns(inputs, kernels, outputs, 3);
+      }
+      m_Smoothed.swap(m_Next);
+      m_Scale = sigma;
+    }
+
+    /** Smooths the slice to sigma and returns it. */
+    const std::vector<double>& Smooth(double sigma)
+    {
+      Kernel smooth, deriv1, deriv2;
+      this->InitializeKernels(sigma, smooth, deriv1, deriv2);
+
+      const std::size_t size = static_cast<std::size_t>(m_Width)*m_Height;
+      m_RowsSmooth.resize(size);
+      m_Next.resize(size);
+      {
+        const Kernel* kernels[1] = { &smooth };
+        double* outputs[1] = { m_RowsSmooth.data() };
+        this->ConvolveRows(m_Smoothed.data(), kernels, outputs, 1);
+      }
+      {
+        const double* inputs[1] = { m_RowsSmooth.data() };
+        const Kernel* kernels[1] = { &smooth };
+        double* outputs[1] = { m_Next.data() };
+        this->ConvolveColumns(inputs, kernels, outputs, 1);
+      }
+      m_Smoothed.swap(m_Next);
+      m_Scale = sigma;
+      return m_Smoothed;
+    }
+
+    /**
+    * \brief Closed form eigenvalues of symmetric 2x2 tensors, like vigra::tensorEigenRepresentation.
+    * ev1 is the larger eigenvalue, angle the orientation of its eigenvector.
+    */
+    template< class TOutput >
+    static void TensorEigenRepresentation(const double* xx, const double* xy, const double* yy, std::size_t count,
+                                          TOutput* ev1, TOutput* ev2, TOutput* angle)
+    {
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        const double d1 = xx[i] + yy[i];
+        const double d2 = xx[i] - yy[i];
+        const double d3 = 2.0 * xy[i];
+        const double d4 = std::sqrt(d2*d2 + d3*d3);
+        ev1[i] = static_cast<TOutput>(0.5 * (d1 + d4));
+        ev2[i] = static_cast<TOutput>(0.5 * (d1 - d4));
+      }
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        const double d2 = xx[i] - yy[i];
+        const double d3 = 2.0 * xy[i];
+        angle[i] = static_cast<TOutput>((d2 == 0.0 && d3 == 0.0) ? 0.0 : 0.5 * std::atan2(d3, d2));
+      }
+    }
+
+  private:
+
+    /** Kernel values from -radius to radius. */
+    struct Kernel
+    {
+      int radius;
+      std::vector<double> values;
+    };
+
+    static void CopyKernel(const vigra::Kernel1D<double>& vigraKernel, Kernel& kernel)
+    {
+      kernel.radius = std::max(-vigraKernel.left(), vigraKernel.right());
+      kernel.values.assign(2*kernel.radius+1, 0.0);
+      for (int k = vigraKernel.left(); k <= vigraKernel.right(); ++k)
+        kernel.values[k + kernel.radius] = vigraKernel[k];
+    }
+
+    void InitializeKernels(double sigma, Kernel& smooth, Kernel& deriv1, Kernel& deriv2) const
+    {
+      if (!(sigma > m_Scale))
+        itkGenericExceptionMacro(<< "Scales of the scale space have to be increasing");
+
+      const double residual = std::sqrt(sigma*sigma - m_Scale*m_Scale);
+      vigra::Kernel1D<double> kernel;
+      kernel.initGaussian(residual);
+      CopyKernel(kernel, smooth);
+      kernel.initGaussianDerivative(residual, 1);
+      CopyKernel(kernel, deriv1);
+      kernel.initGaussianDerivative(residual, 2);
+      CopyKernel(kernel, deriv2);
+    }
+
+    /** Reflects an index at the borders without repeating the border pixel (dcb|abcd|cba). */
+    static int Reflect(int index, int size)
+    {
+      if (size == 1)
+        return 0;
+      while (index < 0 || index >= size)
+        index = index < 0 ? -index : 2*(size-1) - index;
+      return index;
+    }
+
+    /** Convolves all rows of the input with each kernel: out[x] = sum_k kernel[k]*in[x-k]. */
+    void ConvolveRows(const double* input, const Kernel* const* kernels, double* const* outputs, int numberOfKernels)
+    {
+      int radius = 0;
+      for (int n = 0; n < numberOfKernels; ++n)
+        radius = std::max(radius, kernels[n]->radius);
+
+      const int width = m_Width;
+      m_Padded.resize(width + 2*radius);
+      for (unsigned int y = 0; y < m_Height; ++y)
+      {
+        const double* row = input + static_cast<std::size_t>(y)*width;
+        for (int x = -radius; x < width + radius; ++x)
+          m_Padded[x + radius] = row[Reflect(x, width)];
+
+        for (int n = 0; n < numberOfKernels; ++n)
+        {
+          const Kernel& kernel = *kernels[n];
+          double* out = outputs[n] + static_cast<std::size_t>(y)*width;
+          std::fill(out, out + width, 0.0);
+          for (int k = -kernel.radius; k <= kernel.radius; ++k)
+          {
+            const double weight = kernel.values[k + kernel.radius];
+            const double* in = m_Padded.data() + radius - k;
+            for (int x = 0; x < width; ++x)
+              out[x] += weight * in[x];
+          }
+        }
+      }
+    }
+
+    /** Convolves the columns of each input with its kernel: out[y] = sum_k kernel[k]*in[y-k]. */
+    void ConvolveColumns(const double* const* inputs, const Kernel* const* kernels, double* const* outputs, int numberOfKernels)
+    {
+      const int width = m_Width;
+      const int height = m_Height;
+      for (int y = 0; y < height; ++y)
+      {
+        for (int n = 0; n < numberOfKernels; ++n)
+        {
+          const Kernel& kernel = *kernels[n];
+          double* out = outputs[n] + static_cast<std::size_t>(y)*width;
+          std::fill(out, out + width, 0.0);
+          for (int k = -kernel.radius; k <= kernel.radius; ++k)
+          {
+            const double weight = kernel.values[k + kernel.radius];
+            const double* in = inputs[n] + static_cast<std::size_t>(Reflect(y - k, height))*width;
+            for (int x = 0; x < width; ++x)
+              out[x] += weight * in[x];
+          }
+        }
+      }
+    }
+
+    unsigned int          m_Width;
+    unsigned int          m_Height;
+    double                m_Scale;
+    std::vector<double>   m_Smoothed;
+
+    /** Intermediate images, kept to avoid allocations between scales. */
+    std::vector<double>   m_RowsSmooth;
+    std::vector<double>   m_RowsDeriv1;
+    std::vector<double>   m_RowsDeriv2;
+    std::vector<double>   m_Next;
+    std::vector<double>   m_Padded;
+  };
+}
+
+#endif
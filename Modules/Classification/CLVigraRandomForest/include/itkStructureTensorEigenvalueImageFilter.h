@@ -18,6 +18,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #define ITKSTRUCTURETENSOREIGENVALUEIMAGEFILTER_H
 
 #include <itkImageToImageFilter.h>
+#include <vector>
 
 namespace itk
 {
@@ -45,12 +46,22 @@ namespace itk
       itkSetMacro(OuterScale,double)
       itkGetMacro(OuterScale,double)
 
+    /**
+    * \brief Multi-scale mode: computes the eigenvalue images of all outer scales, which have to be increasing.
+    * Output 3*i+j is eigenvalue image j of outer scale i. The gradient at the inner scale is computed once
+    * and each outer scale is smoothed from the previous one. An empty list switches back to OuterScale.
+    */
+    void SetOuterScales(const std::vector<double> & scales);
+    itkGetConstReferenceMacro(OuterScales, std::vector<double>);
+
   private:
 
     typename TMaskImageType::Pointer m_ImageMask;
     double m_InnerScale, m_OuterScale;
+    std::vector<double> m_OuterScales;
 
     void GenerateData();
+    void GenerateMultiScaleData();
     void GenerateOutputInformation();
 
     StructureTensorEigenvalueImageFilter();
@@ -0,0 +1,83 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkFlatRandomForest_h
+#define mitkFlatRandomForest_h
+
+#include <MitkCLVigraRandomForestExports.h>
+
+#include <vigra/random_forest.hxx>
+
+// Eigen
+#include <Eigen/Dense>
+
+// STD Includes
+#include <vector>
+
+namespace mitk
+{
+  /**
+  * \brief Compiled representation of a vigra random forest for fast prediction.
+  *
+  * The nodes of all trees are stored in one flat array of 16 byte nodes, the children of a node are
+  * stored next to each other in breadth-first order. The leaves hold the class votes of vigra's
+  * prediction, already multiplied with the leaf weight if the forest predicts weighted.
+  * Samples are predicted in blocks: each tree is evaluated for all samples of a block before the
+  * next tree is used, so the nodes of a tree stay in the cache. The votes are summed up in the
+  * order of the trees, so labels and probabilities equal those of vigra's predictLabels() and
+  * predictProbabilities().
+  *
+  * Only threshold split nodes and constant probability leaves are supported, which are created by
+  * the splitters of this module. Other node types throw an mitk::Exception.
+  */
+  class MITKCLVIGRARANDOMFOREST_EXPORT FlatRandomForest
+  {
+  public:
+
+    explicit FlatRandomForest(const vigra::RandomForest<int> & forest);
+
+    /**
+    * @brief Predicts the labels and class probabilities of all rows of X in one pass over the trees.
+    * Rows with NaN features get zero probabilities and the first class label.
+    */
+    void Predict(const Eigen::MatrixXd & X, Eigen::MatrixXi & labels, Eigen::MatrixXd & probabilities) const;
+
+    unsigned int GetNumberOfTrees() const { return m_Roots.size(); }
+    unsigned int GetNumberOfNodes() const { return m_Nodes.size(); }
+    int GetNumberOfClasses() const { return m_NumberOfClasses; }
+
+  private:
+
+    /** Inner nodes go to child if the feature is below the threshold and to child+1 otherwise.
+    * Leaves have column -1 and child is the offset of their votes. */
+    struct Node
+    {
+      double threshold;
+      int column;
+      int child;
+    };
+
+    int GetLeaf(int root, const double * sample, int stride) const;
+
+    std::vector<Node>   m_Nodes;
+    std::vector<int>    m_Roots;
+    std::vector<double> m_LeafVotes;
+    std::vector<int>    m_ClassLabels;
+    int                 m_NumberOfClasses;
+  };
+}
+
+#endif //mitkFlatRandomForest_h
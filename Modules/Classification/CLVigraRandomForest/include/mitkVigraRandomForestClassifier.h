@@ -19,12 +19,16 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <MitkCLVigraRandomForestExports.h>
 #include <mitkAbstractClassifier.h>
+#include <mitkFlatRandomForest.h>
 
 //#include <vigra/multi_array.hxx>
 #include <vigra/random_forest.hxx>
 
 #include <mitkBaseData.h>
 
+#include <functional>
+#include <memory>
+
 namespace mitk
 {
   class MITKCLVIGRARANDOMFOREST_EXPORT VigraRandomForestClassifier : public AbstractClassifier
@@ -39,7 +43,18 @@ namespace mitk
 
     ~VigraRandomForestClassifier();
 
+    /** Fills X and Y with the training samples of the given batch. */
+    typedef std::function<void(int batch, Eigen::MatrixXd &X, Eigen::MatrixXi &Y)> BatchFunctionType;
+
     void Train(const Eigen::MatrixXd &X, const Eigen::MatrixXi &Y);
+
+    /**
+    * @brief Trains the trees of the forest on numberOfBatches batches instead of one training matrix.
+    * The trees are distributed evenly over the batches and the batches are trained in parallel, so only
+    * the batches of the running threads are held in memory. The function is not called concurrently.
+    * All batches have to contain the same classes. Point based weights are not supported.
+    */
+    void TrainBatchwise(const BatchFunctionType &function, int numberOfBatches);
     void OnlineTrain(const Eigen::MatrixXd &X, const Eigen::MatrixXi &Y);
     Eigen::MatrixXi Predict(const Eigen::MatrixXd &X);
     Eigen::MatrixXi PredictWeighted(const Eigen::MatrixXd &X);
@@ -83,8 +98,10 @@ namespace mitk
     Parameter * m_Parameter;
     vigra::RandomForest<int> m_RandomForest;
 
+    /** Compiled copy of m_RandomForest used by Predict(), created on demand. */
+    std::unique_ptr<FlatRandomForest> m_FlatRandomForest;
+
     static ITK_THREAD_RETURN_TYPE TrainTreesCallback(void *);
-    static ITK_THREAD_RETURN_TYPE PredictCallback(void *);
     static ITK_THREAD_RETURN_TYPE PredictWeightedCallback(void *);
     static void VigraPredictWeighted(PredictionData *data, vigra::MultiArrayView<2, double> & X, vigra::MultiArrayView<2, int> & Y, vigra::MultiArrayView<2, double> & P);
   };
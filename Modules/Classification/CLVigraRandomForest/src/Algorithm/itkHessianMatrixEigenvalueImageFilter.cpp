@@ -19,6 +19,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <itkHessianMatrixEigenvalueImageFilter.h>
 #include <itkImageRegionIterator.h>
+#include <itkSliceScaleSpace.h>
 #include <vigra/tensorutilities.hxx>
 #include <vigra/convolution.hxx>
 #include <mitkCLUtil.h>
@@ -28,20 +29,13 @@ template< class TInputImageType, class TOutputImageType, class TMaskImageType>
 void itk::HessianMatrixEigenvalueImageFilter<TInputImageType,TOutputImageType, TMaskImageType>::GenerateOutputInformation()
 {
   Superclass::GenerateOutputInformation();
-  this->GetOutput(0)->SetDirection(this->GetInput()->GetDirection());
-  this->GetOutput(0)->SetSpacing(this->GetInput()->GetSpacing());
-  this->GetOutput(0)->SetRegions(this->GetInput()->GetLargestPossibleRegion());
-  this->GetOutput(0)->Allocate();
-
-  this->GetOutput(1)->SetDirection(this->GetInput()->GetDirection());
-  this->GetOutput(1)->SetSpacing(this->GetInput()->GetSpacing());
-  this->GetOutput(1)->SetRegions(this->GetInput()->GetLargestPossibleRegion());
-  this->GetOutput(1)->Allocate();
-
-  this->GetOutput(2)->SetDirection(this->GetInput()->GetDirection());
-  this->GetOutput(2)->SetSpacing(this->GetInput()->GetSpacing());
-  this->GetOutput(2)->SetRegions(this->GetInput()->GetLargestPossibleRegion());
-  this->GetOutput(2)->Allocate();
+  for (unsigned int i = 0; i < this->GetNumberOfIndexedOutputs(); ++i)
+  {
+    this->GetOutput(i)->SetDirection(this->GetInput()->GetDirection());
+    this->GetOutput(i)->SetSpacing(this->GetInput()->GetSpacing());
+    this->GetOutput(i)->SetRegions(this->GetInput()->GetLargestPossibleRegion());
+    this->GetOutput(i)->Allocate();
+  }
 }
 
 template< class TInputImageType, class TOutputImageType, class TMaskImageType>
@@ -77,6 +71,11 @@ void itk::HessianMatrixEigenvalueImageFilter<TInputImageType,TOutputImageType,TM
     ++iit;
   }
 
+  if (!m_Sigmas.empty())
+  {
+    this->GenerateMultiScaleData(maske_input);
+    return;
+  }
 
   vigra::Shape3 shape(xdim,ydim,zdim);
   vigra::MultiArrayView<3, InputPixelType, vigra::StridedArrayTag > input_image_view(
@@ -132,12 +131,62 @@ void itk::HessianMatrixEigenvalueImageFilter<TInputImageType,TOutputImageType,TM
 
 }
 
+template< class TInputImageType, class TOutputImageType, class TMaskImageType>
+void itk::HessianMatrixEigenvalueImageFilter<TInputImageType,TOutputImageType,TMaskImageType>::GenerateMultiScaleData(const TInputImageType * input)
+{
+  typedef typename TInputImageType::PixelType InputPixelType;
+
+  for (unsigned int s = 0; s < m_Sigmas.size(); ++s)
+  {
+    if (m_Sigmas[s] <= 0 || (s > 0 && m_Sigmas[s] <= m_Sigmas[s-1]))
+      itkExceptionMacro(<< "Sigmas have to be positive and increasing");
+  }
+
+  typename TInputImageType::RegionType region = input->GetLargestPossibleRegion();
+  unsigned int xdim = region.GetSize(0);
+  unsigned int ydim = region.GetSize(1);
+  int zdim = region.GetSize(2);
+  const std::size_t sliceSize = static_cast<std::size_t>(xdim)*ydim;
+
+  // Slices are independent, each thread keeps the scale space of its slice
+#pragma omp parallel for
+  for (int z = 0; z < zdim; ++z)
+  {
+    const std::size_t offset = static_cast<std::size_t>(z)*sliceSize;
+    itk::SliceScaleSpace<InputPixelType> scaleSpace(input->GetBufferPointer() + offset, xdim, ydim);
+    std::vector<double> xx(sliceSize), xy(sliceSize), yy(sliceSize);
+    for (unsigned int s = 0; s < m_Sigmas.size(); ++s)
+    {
+      scaleSpace.Hessian(m_Sigmas[s], xx.data(), xy.data(), yy.data());
+      itk::SliceScaleSpace<InputPixelType>::TensorEigenRepresentation(xx.data(), xy.data(), yy.data(), sliceSize,
+                                                                      this->GetOutput(3*s)->GetBufferPointer() + offset,
+                                                                      this->GetOutput(3*s+1)->GetBufferPointer() + offset,
+                                                                      this->GetOutput(3*s+2)->GetBufferPointer() + offset);
+    }
+  }
+}
+
 template< class TInputImageType, class TOutputImageType, class TMaskImageType>
 void itk::HessianMatrixEigenvalueImageFilter<TInputImageType,TOutputImageType,TMaskImageType>::SetImageMask(TMaskImageType * maskimage)
 {
   this->m_ImageMask = maskimage;
 }
 
+template< class TInputImageType, class TOutputImageType, class TMaskImageType>
+void itk::HessianMatrixEigenvalueImageFilter<TInputImageType,TOutputImageType,TMaskImageType>::SetSigmas(const std::vector<double> & sigmas)
+{
+  m_Sigmas = sigmas;
+
+  unsigned int numberOfOutputs = 3 * std::max<unsigned int>(1, static_cast<unsigned int>(sigmas.size()));
+  this->SetNumberOfIndexedOutputs(numberOfOutputs);
+  for (unsigned int i = 0; i < numberOfOutputs; ++i)
+  {
+    if (this->GetOutput(i) == nullptr)
+      this->SetNthOutput( i, this->MakeOutput(i) );
+  }
+  this->Modified();
+}
+
 template< class TInputImageType, class TOutputImageType, class TMaskImageType>
 itk::HessianMatrixEigenvalueImageFilter<TInputImageType,TOutputImageType,TMaskImageType>::HessianMatrixEigenvalueImageFilter()
 {
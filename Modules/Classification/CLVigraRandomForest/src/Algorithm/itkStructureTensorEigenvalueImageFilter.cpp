@@ -19,6 +19,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <itkStructureTensorEigenvalueImageFilter.h>
 #include <itkImageRegionIterator.h>
+#include <itkSliceScaleSpace.h>
 #include <vigra/tensorutilities.hxx>
 #include <vigra/convolution.hxx>
 
@@ -27,27 +28,23 @@ template< class TInputImageType, class TOutputImageType, class TMaskImageType>
 void itk::StructureTensorEigenvalueImageFilter<TInputImageType,TOutputImageType, TMaskImageType>::GenerateOutputInformation()
 {
   Superclass::GenerateOutputInformation();
-  this->GetOutput(0)->SetDirection(this->GetInput()->GetDirection());
-  this->GetOutput(0)->SetSpacing(this->GetInput()->GetSpacing());
-  this->GetOutput(0)->SetRegions(this->GetInput()->GetLargestPossibleRegion());
-  this->GetOutput(0)->Allocate();
-
-  this->GetOutput(1)->SetDirection(this->GetInput()->GetDirection());
-  this->GetOutput(1)->SetSpacing(this->GetInput()->GetSpacing());
-  this->GetOutput(1)->SetRegions(this->GetInput()->GetLargestPossibleRegion());
-  this->GetOutput(1)->Allocate();
-
-  this->GetOutput(2)->SetDirection(this->GetInput()->GetDirection());
-  this->GetOutput(2)->SetSpacing(this->GetInput()->GetSpacing());
-  this->GetOutput(2)->SetRegions(this->GetInput()->GetLargestPossibleRegion());
-  this->GetOutput(2)->Allocate();
+  for (unsigned int i = 0; i < this->GetNumberOfIndexedOutputs(); ++i)
+  {
+    this->GetOutput(i)->SetDirection(this->GetInput()->GetDirection());
+    this->GetOutput(i)->SetSpacing(this->GetInput()->GetSpacing());
+    this->GetOutput(i)->SetRegions(this->GetInput()->GetLargestPossibleRegion());
+    this->GetOutput(i)->Allocate();
+  }
 }
 
 template< class TInputImageType, class TOutputImageType, class TMaskImageType>
 void itk::StructureTensorEigenvalueImageFilter<TInputImageType,TOutputImageType, TMaskImageType>::GenerateData()
 {
-
-
+  if (!m_OuterScales.empty())
+  {
+    this->GenerateMultiScaleData();
+    return;
+  }
 
   typedef typename TInputImageType::PixelType InputPixelType;
 
@@ -103,12 +100,82 @@ void itk::StructureTensorEigenvalueImageFilter<TInputImageType,TOutputImageType,
 
 }
 
+template< class TInputImageType, class TOutputImageType, class TMaskImageType>
+void itk::StructureTensorEigenvalueImageFilter<TInputImageType,TOutputImageType, TMaskImageType>::GenerateMultiScaleData()
+{
+  typedef typename TInputImageType::PixelType InputPixelType;
+
+  if (m_InnerScale <= 0)
+    itkExceptionMacro(<< "The inner scale has to be positive");
+  for (unsigned int s = 0; s < m_OuterScales.size(); ++s)
+  {
+    if (m_OuterScales[s] <= 0 || (s > 0 && m_OuterScales[s] <= m_OuterScales[s-1]))
+      itkExceptionMacro(<< "Outer scales have to be positive and increasing");
+  }
+
+  const TInputImageType * input = this->GetInput();
+  typename TInputImageType::RegionType region = input->GetLargestPossibleRegion();
+  unsigned int xdim = region.GetSize(0);
+  unsigned int ydim = region.GetSize(1);
+  int zdim = region.GetSize(2);
+  const std::size_t sliceSize = static_cast<std::size_t>(xdim)*ydim;
+
+  // Slices are independent, each thread keeps the scale spaces of its slice
+#pragma omp parallel for
+  for (int z = 0; z < zdim; ++z)
+  {
+    const std::size_t offset = static_cast<std::size_t>(z)*sliceSize;
+    std::vector<double> gx(sliceSize), gy(sliceSize);
+    {
+      itk::SliceScaleSpace<InputPixelType> scaleSpace(input->GetBufferPointer() + offset, xdim, ydim);
+      scaleSpace.Gradient(m_InnerScale, gx.data(), gy.data());
+    }
+
+    // The tensor of the gradient is computed once and smoothed from one outer scale to the next
+    std::vector<double> tensor(sliceSize);
+    for (std::size_t i = 0; i < sliceSize; ++i)
+      tensor[i] = gx[i]*gx[i];
+    itk::SliceScaleSpace<double> xx(tensor.data(), xdim, ydim);
+    for (std::size_t i = 0; i < sliceSize; ++i)
+      tensor[i] = gx[i]*gy[i];
+    itk::SliceScaleSpace<double> xy(tensor.data(), xdim, ydim);
+    for (std::size_t i = 0; i < sliceSize; ++i)
+      tensor[i] = gy[i]*gy[i];
+    itk::SliceScaleSpace<double> yy(tensor.data(), xdim, ydim);
+
+    for (unsigned int s = 0; s < m_OuterScales.size(); ++s)
+    {
+      itk::SliceScaleSpace<double>::TensorEigenRepresentation(xx.Smooth(m_OuterScales[s]).data(),
+                                                              xy.Smooth(m_OuterScales[s]).data(),
+                                                              yy.Smooth(m_OuterScales[s]).data(), sliceSize,
+                                                              this->GetOutput(3*s)->GetBufferPointer() + offset,
+                                                              this->GetOutput(3*s+1)->GetBufferPointer() + offset,
+                                                              this->GetOutput(3*s+2)->GetBufferPointer() + offset);
+    }
+  }
+}
+
 template< class TInputImageType, class TOutputImageType, class TMaskImageType>
 void itk::StructureTensorEigenvalueImageFilter<TInputImageType,TOutputImageType, TMaskImageType>::SetImageMask(TMaskImageType *maskimage)
 {
   this->m_ImageMask = maskimage;
 }
 
+template< class TInputImageType, class TOutputImageType, class TMaskImageType>
+void itk::StructureTensorEigenvalueImageFilter<TInputImageType,TOutputImageType, TMaskImageType>::SetOuterScales(const std::vector<double> & scales)
+{
+  m_OuterScales = scales;
+
+  unsigned int numberOfOutputs = 3 * std::max<unsigned int>(1, static_cast<unsigned int>(scales.size()));
+  this->SetNumberOfIndexedOutputs(numberOfOutputs);
+  for (unsigned int i = 0; i < numberOfOutputs; ++i)
+  {
+    if (this->GetOutput(i) == nullptr)
+      this->SetNthOutput( i, this->MakeOutput(i) );
+  }
+  this->Modified();
+}
+
 template< class TInputImageType, class TOutputImageType, class TMaskImageType>
 itk::StructureTensorEigenvalueImageFilter<TInputImageType,TOutputImageType,TMaskImageType>::StructureTensorEigenvalueImageFilter()
 {
@@ -0,0 +1,154 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+// MITK includes
+#include <mitkFlatRandomForest.h>
+#include <mitkExceptionMacro.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <utility>
+
+mitk::FlatRandomForest::FlatRandomForest(const vigra::RandomForest<int> & forest)
+  : m_NumberOfClasses(forest.class_count())
+{
+  for (int c = 0; c < m_NumberOfClasses; ++c)
+  {
+    int label;
+    forest.ext_param_.to_classlabel(c, label);
+    m_ClassLabels.push_back(label);
+  }
+
+  const int weighted = forest.options_.predict_weighted_;
+  for (int k = 0; k < forest.options_.tree_count_; ++k)
+  {
+    const vigra::RandomForest<int>::DecisionTree_t & tree = forest.trees_[k];
+
+    m_Roots.push_back(m_Nodes.size());
+    m_Nodes.push_back(Node());
+
+    // pairs of the vigra node index and the flat node index, the root of a vigra tree is at index 2
+    std::deque< std::pair<int, int> > queue;
+    queue.push_back(std::make_pair(2, m_Roots.back()));
+    while (!queue.empty())
+    {
+      const int vigraIndex = queue.front().first;
+      const int flatIndex = queue.front().second;
+      queue.pop_front();
+
+      switch (tree.topology_[vigraIndex])
+      {
+      case vigra::i_ThresholdNode:
+      {
+        vigra::Node<vigra::i_ThresholdNode> node(tree.topology_, tree.parameters_, vigraIndex);
+        const int children = m_Nodes.size();
+        m_Nodes[flatIndex].threshold = node.threshold();
+        m_Nodes[flatIndex].column = node.column();
+        m_Nodes[flatIndex].child = children;
+        m_Nodes.push_back(Node());
+        m_Nodes.push_back(Node());
+        queue.push_back(std::make_pair(static_cast<int>(node.child(0)), children));
+        queue.push_back(std::make_pair(static_cast<int>(node.child(1)), children + 1));
+        break;
+      }
+      case vigra::e_ConstProbNode:
+      {
+        vigra::Node<vigra::e_ConstProbNode> leaf(tree.topology_, tree.parameters_, vigraIndex);
+        vigra::ArrayVector<double>::const_iterator weights = leaf.prob_begin();
+        m_Nodes[flatIndex].threshold = 0;
+        m_Nodes[flatIndex].column = -1;
+        m_Nodes[flatIndex].child = m_LeafVotes.size();
+        // same expression as in vigra::RandomForest::predictProbabilities()
+        for (int l = 0; l < m_NumberOfClasses; ++l)
+          m_LeafVotes.push_back(weights[l] * (weighted * (*(weights-1)) + (1-weighted)));
+        break;
+      }
+      default:
+        mitkThrow() << "FlatRandomForest: unsupported node type " << tree.topology_[vigraIndex] << " in tree " << k;
+      }
+    }
+  }
+}
+
+int mitk::FlatRandomForest::GetLeaf(int root, const double * sample, int stride) const
+{
+  const Node * node = &m_Nodes[root];
+  while (node->column >= 0)
+  {
+    node = &m_Nodes[node->child + (sample[node->column * stride] < node->threshold ? 0 : 1)];
+  }
+  return node->child;
+}
+
+void mitk::FlatRandomForest::Predict(const Eigen::MatrixXd & X, Eigen::MatrixXi & labels, Eigen::MatrixXd & probabilities) const
+{
+  const int numberOfRows = X.rows();
+  const int numberOfColumns = X.cols();
+  const int numberOfTrees = m_Roots.size();
+  const int blockSize = 256;
+  const int numberOfBlocks = (numberOfRows + blockSize - 1) / blockSize;
+
+  probabilities = Eigen::MatrixXd::Zero(numberOfRows, m_NumberOfClasses);
+  labels = Eigen::MatrixXi::Zero(numberOfRows, 1);
+
+#pragma omp parallel for schedule(dynamic)
+  for (int block = 0; block < numberOfBlocks; ++block)
+  {
+    const int first = block * blockSize;
+    const int count = std::min(blockSize, numberOfRows - first);
+
+    // like vigra, samples with NaN features are not classified
+    std::vector<char> isValid(count, 1);
+    for (int c = 0; c < numberOfColumns; ++c)
+      for (int r = 0; r < count; ++r)
+        if (std::isnan(X(first + r, c)))
+          isValid[r] = 0;
+
+    std::vector<double> totalWeight(count, 0.0);
+    for (int k = 0; k < numberOfTrees; ++k)
+    {
+      for (int r = 0; r < count; ++r)
+      {
+        if (!isValid[r])
+          continue;
+        const int row = first + r;
+        const double * votes = &m_LeafVotes[GetLeaf(m_Roots[k], X.data() + row, numberOfRows)];
+        for (int l = 0; l < m_NumberOfClasses; ++l)
+        {
+          probabilities(row, l) += votes[l];
+          totalWeight[r] += votes[l];
+        }
+      }
+    }
+
+    for (int r = 0; r < count; ++r)
+    {
+      const int row = first + r;
+      int maxCol = 0;
+      if (isValid[r])
+      {
+        for (int l = 0; l < m_NumberOfClasses; ++l)
+          probabilities(row, l) /= totalWeight[r];
+        for (int l = 1; l < m_NumberOfClasses; ++l)
+          if (probabilities(row, maxCol) < probabilities(row, l))
+            maxCol = l;
+      }
+      labels(row, 0) = m_ClassLabels[maxCol];
+    }
+  }
+}
@@ -20,6 +20,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkImpurityLoss.h>
 #include <mitkLinearSplitting.h>
 #include <mitkProperties.h>
+#include <mitkExceptionMacro.h>
 
 // Vigra includes
 #include <vigra/random_forest.hxx>
@@ -30,6 +31,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkMultiThreader.h>
 #include <itkCommand.h>
 
+#include <algorithm>
+
 typedef mitk::ThresholdSplit<mitk::LinearSplitting< mitk::ImpurityLoss<> >,int,vigra::ClassificationTag> DefaultSplitType;
 
 struct mitk::VigraRandomForestClassifier::Parameter
@@ -124,6 +127,7 @@ void mitk::VigraRandomForestClassifier::OnlineTrain(const Eigen::MatrixXd & X_in
   vigra::MultiArrayView<2, double> X(vigra::Shape2(X_in.rows(),X_in.cols()),X_in.data());
   vigra::MultiArrayView<2, int> Y(vigra::Shape2(Y_in.rows(),Y_in.cols()),Y_in.data());
   m_RandomForest.onlineLearn(X,Y,0,true);
+  m_FlatRandomForest.reset();
 }
 
 void mitk::VigraRandomForestClassifier::Train(const Eigen::MatrixXd & X_in, const Eigen::MatrixXi &Y_in)
@@ -168,20 +172,95 @@ void mitk::VigraRandomForestClassifier::Train(const Eigen::MatrixXd & X_in, cons
   m_RandomForest.set_options().tree_count(m_Parameter->TreeCount);
   m_RandomForest.ext_param_.class_count_ = data->m_ClassCount;
   m_RandomForest.trees_ = data->trees_;
+  m_FlatRandomForest.reset();
 
   // Set Tree Weights to default
   m_TreeWeights = Eigen::MatrixXd(m_Parameter->TreeCount,1);
   m_TreeWeights.fill(1.0);
 }
 
-Eigen::MatrixXi mitk::VigraRandomForestClassifier::Predict(const Eigen::MatrixXd &X_in)
+void mitk::VigraRandomForestClassifier::TrainBatchwise(const BatchFunctionType &function, int numberOfBatches)
 {
-  // Initialize output Eigen matrices
-  m_OutProbability = Eigen::MatrixXd(X_in.rows(),m_RandomForest.class_count());
-  m_OutProbability.fill(0);
-  m_OutLabel = Eigen::MatrixXi(X_in.rows(),1);
-  m_OutLabel.fill(0);
+  this->ConvertParameter();
+
+  if (numberOfBatches < 1 || numberOfBatches > m_Parameter->TreeCount)
+    mitkThrow() << "The number of training batches has to be between 1 and the number of trees, but is " << numberOfBatches;
+  if (m_Parameter->UsePointBasedWeights)
+    mitkThrow() << "Point based weights are not supported by the batchwise training";
+
+  const Parameter parameter = *m_Parameter;
+  vigra::ArrayVector<vigra::RandomForest<int>::DecisionTree_t> trees;
+  vigra::ProblemSpec<int> problemSpec;
+  bool hasProblemSpec = false;
+  std::string error;
+
+#pragma omp parallel for schedule(dynamic)
+  for (int batch = 0; batch < numberOfBatches; ++batch)
+  {
+    try
+    {
+      const int numberOfTrees = (batch + 1) * parameter.TreeCount / numberOfBatches - batch * parameter.TreeCount / numberOfBatches;
+
+      Eigen::MatrixXd X_in;
+      Eigen::MatrixXi Y_in;
+#pragma omp critical (VigraRandomForestBatchFunction)
+      function(batch, X_in, Y_in);
+
+      vigra::MultiArrayView<2, double> X(vigra::Shape2(X_in.rows(),X_in.cols()),X_in.data());
+      vigra::MultiArrayView<2, int> Y(vigra::Shape2(Y_in.rows(),Y_in.cols()),Y_in.data());
+
+      DefaultSplitType splitter;
+      splitter.UsePointBasedWeights(false);
+      splitter.UseRandomSplit(parameter.UseRandomSplit);
+      splitter.SetPrecision(parameter.Precision);
+      splitter.SetMaximumTreeDepth(parameter.TreeDepth);
+
+      vigra::RandomForest<int> rf;
+      rf.set_options().tree_count(numberOfTrees);
+      rf.set_options().use_stratification(parameter.Stratification);
+      rf.set_options().sample_with_replacement(parameter.SampleWithReplacement);
+      rf.set_options().samples_per_tree(parameter.SamplesPerTree);
+      rf.set_options().min_split_node_size(parameter.MinimumSplitNodeSize);
+      rf.learn(X, Y, vigra::rf::visitors::VisitorBase(), splitter);
+
+#pragma omp critical (VigraRandomForestBatchTrees)
+      {
+        if (!hasProblemSpec)
+        {
+          problemSpec = rf.ext_param_;
+          hasProblemSpec = true;
+        }
+        if (rf.ext_param_.class_count_ != problemSpec.class_count_ ||
+            !std::equal(problemSpec.classes.begin(), problemSpec.classes.end(), rf.ext_param_.classes.begin()))
+          error = "The training batches contain different classes";
+        for (const auto & tree : rf.trees_)
+          trees.push_back(tree);
+      }
+    }
+    catch (const std::exception &e)
+    {
+#pragma omp critical (VigraRandomForestBatchTrees)
+      error = e.what();
+    }
+  }
+  if (!error.empty())
+    mitkThrow() << "Batchwise training failed: " << error;
+
+  m_RandomForest.set_options().tree_count(parameter.TreeCount);
+  m_RandomForest.set_options().use_stratification(parameter.Stratification);
+  m_RandomForest.set_options().sample_with_replacement(parameter.SampleWithReplacement);
+  m_RandomForest.set_options().samples_per_tree(parameter.SamplesPerTree);
+  m_RandomForest.set_options().min_split_node_size(parameter.MinimumSplitNodeSize);
+  m_RandomForest.ext_param_ = problemSpec;
+  m_RandomForest.trees_ = trees;
+  m_FlatRandomForest.reset();
+
+  m_TreeWeights = Eigen::MatrixXd(parameter.TreeCount,1);
+  m_TreeWeights.fill(1.0);
+}
 
+Eigen::MatrixXi mitk::VigraRandomForestClassifier::Predict(const Eigen::MatrixXd &X_in)
+{
   // If no weights provided
   if(m_TreeWeights.rows() != m_RandomForest.tree_count())
   {
@@ -189,18 +268,12 @@ Eigen::MatrixXi mitk::VigraRandomForestClassifier::Predict(const Eigen::MatrixXd
     m_TreeWeights.fill(1);
   }
 
-
-  vigra::MultiArrayView<2, double> P(vigra::Shape2(m_OutProbability.rows(),m_OutProbability.cols()),m_OutProbability.data());
-  vigra::MultiArrayView<2, int> Y(vigra::Shape2(m_OutLabel.rows(),m_OutLabel.cols()),m_OutLabel.data());
-  vigra::MultiArrayView<2, double> X(vigra::Shape2(X_in.rows(),X_in.cols()),X_in.data());
-  vigra::MultiArrayView<2, double> TW(vigra::Shape2(m_RandomForest.tree_count(),1),m_TreeWeights.data());
-
-  std::unique_ptr<PredictionData> data;
-  data.reset( new PredictionData(m_RandomForest,X,Y,P,TW));
-
-  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
-  threader->SetSingleMethod(this->PredictCallback,data.get());
-  threader->SingleMethodExecute();
+  // Labels and probabilities are predicted in one pass by the compiled forest
+  if (m_FlatRandomForest == nullptr)
+  {
+    m_FlatRandomForest.reset(new FlatRandomForest(m_RandomForest));
+  }
+  m_FlatRandomForest->Predict(X_in, m_OutLabel, m_OutProbability);
 
   return m_OutLabel;
 }
@@ -296,59 +369,6 @@ ITK_THREAD_RETURN_TYPE mitk::VigraRandomForestClassifier::TrainTreesCallback(voi
 
 }
 
-ITK_THREAD_RETURN_TYPE mitk::VigraRandomForestClassifier::PredictCallback(void * arg)
-{
-  // Get the ThreadInfoStruct
-  typedef itk::MultiThreader::ThreadInfoStruct  ThreadInfoType;
-  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
-  // assigne the thread id
-  const unsigned int threadId = infoStruct->ThreadID;
-
-  // Get the user defined parameters containing all
-  // neccesary informations
-  PredictionData * data = (PredictionData *)(infoStruct->UserData);
-  unsigned int numberOfRowsToCalculate = 0;
-
-  // Get number of rows to calculate
-  numberOfRowsToCalculate = data->m_Feature.shape()[0] / infoStruct->NumberOfThreads;
-
-  unsigned int start_index = numberOfRowsToCalculate * threadId;
-  unsigned int end_index = numberOfRowsToCalculate * (threadId+1);
-
-  // the last thread takes the residuals
-  if(threadId == infoStruct->NumberOfThreads-1) {
-    end_index += data->m_Feature.shape()[0] % infoStruct->NumberOfThreads;
-  }
-
-  vigra::MultiArrayView<2, double> split_features;
-  vigra::MultiArrayView<2, int> split_labels;
-  vigra::MultiArrayView<2, double> split_probability;
-  {
-    vigra::TinyVector<vigra::MultiArrayIndex, 2> lowerBound(start_index,0);
-    vigra::TinyVector<vigra::MultiArrayIndex, 2> upperBound(end_index,data->m_Feature.shape(1));
-    split_features = data->m_Feature.subarray(lowerBound,upperBound);
-  }
-
-  {
-    vigra::TinyVector<vigra::MultiArrayIndex, 2> lowerBound(start_index,0);
-    vigra::TinyVector<vigra::MultiArrayIndex, 2> upperBound(end_index, data->m_Label.shape(1));
-    split_labels = data->m_Label.subarray(lowerBound,upperBound);
-  }
-
-  {
-    vigra::TinyVector<vigra::MultiArrayIndex, 2> lowerBound(start_index,0);
-    vigra::TinyVector<vigra::MultiArrayIndex, 2> upperBound(end_index,data->m_Probabilities.shape(1));
-    split_probability = data->m_Probabilities.subarray(lowerBound,upperBound);
-  }
-
-  data->m_RandomForest.predictLabels(split_features,split_labels);
-  data->m_RandomForest.predictProbabilities(split_features, split_probability);
-
-
-  return 0;
-
-}
-
 ITK_THREAD_RETURN_TYPE mitk::VigraRandomForestClassifier::PredictWeightedCallback(void * arg)
 {
   // Get the ThreadInfoStruct
@@ -584,6 +604,7 @@ void mitk::VigraRandomForestClassifier::SetRandomForest(const vigra::RandomFores
   this->SetSamplesPerTree(rf.options().training_set_proportion_);
   this->UseSampleWithReplacement(rf.options().sample_with_replacement_);
   this->m_RandomForest = rf;
+  this->m_FlatRandomForest.reset();
 }
 
 const vigra::RandomForest<int> & mitk::VigraRandomForestClassifier::GetRandomForest() const
@@ -1,3 +1,4 @@
 set(MODULE_TESTS
   mitkVigraRandomForestTest.cpp
+  mitkMultiScaleEigenvalueImageFilterTest.cpp
 )
@@ -0,0 +1,164 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+#include "mitkIOUtil.h"
+
+#include <mitkImageCast.h>
+#include <itkHessianMatrixEigenvalueImageFilter.h>
+#include <itkStructureTensorEigenvalueImageFilter.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkTimeProbe.h>
+
+class mitkMultiScaleEigenvalueImageFilterTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkMultiScaleEigenvalueImageFilterTestSuite);
+  MITK_TEST(Hessian_MultiScale_EqualsSingleScales);
+  MITK_TEST(StructureTensor_MultiScale_EqualsSingleScales);
+  MITK_TEST(Hessian_DecreasingSigmas_Throws);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  typedef itk::Image<double,3> DoubleImageType;
+  typedef itk::Image<short,3> MaskImageType;
+
+  DoubleImageType::Pointer m_Image;
+  MaskImageType::Pointer m_Mask;
+
+  /** Maximum absolute difference, relative to the maximum absolute value of the reference. */
+  static double RelativeDifference(DoubleImageType * reference, DoubleImageType * image)
+  {
+    itk::ImageRegionConstIterator<DoubleImageType> rit(reference, reference->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<DoubleImageType> it(image, image->GetLargestPossibleRegion());
+    double maximum = 0;
+    double difference = 0;
+    for (; !rit.IsAtEnd(); ++rit, ++it)
+    {
+      maximum = std::max(maximum, std::abs(rit.Get()));
+      difference = std::max(difference, std::abs(rit.Get() - it.Get()));
+    }
+    return maximum > 0 ? difference / maximum : difference;
+  }
+
+public:
+
+  void setUp() override
+  {
+    mitk::Image::Pointer image = mitk::IOUtil::LoadImage(GetTestDataFilePath("Pic3D.nrrd"));
+    mitk::CastToItkImage(image, m_Image);
+
+    m_Mask = MaskImageType::New();
+    m_Mask->SetRegions(m_Image->GetLargestPossibleRegion());
+    m_Mask->Allocate();
+    m_Mask->FillBuffer(1);
+  }
+
+  void tearDown() override
+  {
+    m_Image = nullptr;
+    m_Mask = nullptr;
+  }
+
+  void Hessian_MultiScale_EqualsSingleScales()
+  {
+    std::vector<double> sigmas = { 1.0, 2.0, 3.5 };
+
+    itk::TimeProbe multiScaleClock;
+    multiScaleClock.Start();
+    itk::HessianMatrixEigenvalueImageFilter<DoubleImageType>::Pointer multiScale = itk::HessianMatrixEigenvalueImageFilter<DoubleImageType>::New();
+    multiScale->SetInput(m_Image);
+    multiScale->SetImageMask(m_Mask);
+    multiScale->SetSigmas(sigmas);
+    multiScale->Update();
+    multiScaleClock.Stop();
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Three outputs per scale", 3*sigmas.size(), multiScale->GetNumberOfIndexedOutputs());
+
+    itk::TimeProbe singleScaleClock;
+    for (unsigned int s = 0; s < sigmas.size(); ++s)
+    {
+      singleScaleClock.Start();
+      itk::HessianMatrixEigenvalueImageFilter<DoubleImageType>::Pointer singleScale = itk::HessianMatrixEigenvalueImageFilter<DoubleImageType>::New();
+      singleScale->SetInput(m_Image);
+      singleScale->SetImageMask(m_Mask);
+      singleScale->SetSigma(sigmas[s]);
+      singleScale->Update();
+      singleScaleClock.Stop();
+
+      // The first scale uses the same kernels, the later ones are smoothed from the previous scale
+      double tolerance = s == 0 ? 1e-10 : 1e-2;
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Larger eigenvalue", 0, RelativeDifference(singleScale->GetOutput(0), multiScale->GetOutput(3*s)), tolerance);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Smaller eigenvalue", 0, RelativeDifference(singleScale->GetOutput(1), multiScale->GetOutput(3*s+1)), tolerance);
+      if (s == 0)
+      {
+        CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Orientation", 0, RelativeDifference(singleScale->GetOutput(2), multiScale->GetOutput(2)), tolerance);
+      }
+    }
+
+    MITK_INFO << "Hessian eigenvalues of " << sigmas.size() << " scales: " << singleScaleClock.GetTotal() << "s single scale, " << multiScaleClock.GetTotal() << "s multi-scale";
+  }
+
+  void StructureTensor_MultiScale_EqualsSingleScales()
+  {
+    std::vector<double> outerScales = { 1.5, 3.0, 5.0 };
+
+    itk::TimeProbe multiScaleClock;
+    multiScaleClock.Start();
+    itk::StructureTensorEigenvalueImageFilter<DoubleImageType>::Pointer multiScale = itk::StructureTensorEigenvalueImageFilter<DoubleImageType>::New();
+    multiScale->SetInput(m_Image);
+    multiScale->SetImageMask(m_Mask);
+    multiScale->SetInnerScale(1.0);
+    multiScale->SetOuterScales(outerScales);
+    multiScale->Update();
+    multiScaleClock.Stop();
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Three outputs per scale", 3*outerScales.size(), multiScale->GetNumberOfIndexedOutputs());
+
+    itk::TimeProbe singleScaleClock;
+    for (unsigned int s = 0; s < outerScales.size(); ++s)
+    {
+      singleScaleClock.Start();
+      itk::StructureTensorEigenvalueImageFilter<DoubleImageType>::Pointer singleScale = itk::StructureTensorEigenvalueImageFilter<DoubleImageType>::New();
+      singleScale->SetInput(m_Image);
+      singleScale->SetImageMask(m_Mask);
+      singleScale->SetInnerScale(1.0);
+      singleScale->SetOuterScale(outerScales[s]);
+      singleScale->Update();
+      singleScaleClock.Stop();
+
+      double tolerance = s == 0 ? 1e-10 : 1e-2;
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Larger eigenvalue", 0, RelativeDifference(singleScale->GetOutput(0), multiScale->GetOutput(3*s)), tolerance);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Smaller eigenvalue", 0, RelativeDifference(singleScale->GetOutput(1), multiScale->GetOutput(3*s+1)), tolerance);
+      if (s == 0)
+      {
+        CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Orientation", 0, RelativeDifference(singleScale->GetOutput(2), multiScale->GetOutput(2)), tolerance);
+      }
+    }
+
+    MITK_INFO << "Structure tensor eigenvalues of " << outerScales.size() << " scales: " << singleScaleClock.GetTotal() << "s single scale, " << multiScaleClock.GetTotal() << "s multi-scale";
+  }
+
+  void Hessian_DecreasingSigmas_Throws()
+  {
+    itk::HessianMatrixEigenvalueImageFilter<DoubleImageType>::Pointer filter = itk::HessianMatrixEigenvalueImageFilter<DoubleImageType>::New();
+    filter->SetInput(m_Image);
+    filter->SetImageMask(m_Mask);
+    filter->SetSigmas({ 2.0, 1.0 });
+    CPPUNIT_ASSERT_THROW(filter->Update(), itk::ExceptionObject);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkMultiScaleEigenvalueImageFilter)
@@ -22,10 +22,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkCSVArray2DFileReader.h>
 #include <itkCSVArray2DDataObject.h>
 #include <mitkVigraRandomForestClassifier.h>
+#include <mitkFlatRandomForest.h>
 #include <itkLabelSampler.h>
 #include <itkAddImageFilter.h>
 #include <mitkImageCast.h>
 #include <mitkStandaloneDataStorage.h>
+#include <random>
 
 class mitkVigraRandomForestTestSuite : public mitk::TestFixture
 {
@@ -39,6 +41,8 @@ class mitkVigraRandomForestTestSuite : public mitk::TestFixture
   MITK_TEST(TrainThreadedDecisionForest_MatlabDataSet_shouldReturnTrue);
   MITK_TEST(PredictWeightedDecisionForest_SetWeightsToZero_shouldReturnTrue);
   MITK_TEST(TrainThreadedDecisionForest_BreastCancerDataSet_shouldReturnTrue);
+  MITK_TEST(PredictFlatRandomForest_BreastCancerDataSet_EqualsVigraPrediction);
+  MITK_TEST(TrainBatchwise_BreastCancerDataSet_shouldReturnTrue);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -177,6 +181,88 @@ public:
     MITK_TEST_CONDITION( (count == maxrows) ,"Weighted prediction - weights applied (all weights = 0).");
   }
 
+  // ------------------------------------------------------------------------------------------------------
+  // ------------------------------------------------------------------------------------------------------
+
+  /*
+  Train the trees on random subsets of the breast cancer data set, as done when the
+  training samples are drawn from a mitk::FeatureSampleStore
+  */
+  void TrainBatchwise_BreastCancerDataSet_shouldReturnTrue()
+  {
+    auto & Features_Training = FeatureData_Cancer.first;
+    auto & Features_Testing = FeatureData_Cancer.second;
+    auto & Labels_Training = LabelData_Cancer.first;
+    auto & Labels_Testing = LabelData_Cancer.second;
+
+    std::mt19937 generator(42);
+    std::bernoulli_distribution drawSample(0.8);
+    int numberOfCalls = 0;
+    classifier->TrainBatchwise([&](int, Eigen::MatrixXd &X, Eigen::MatrixXi &Y)
+    {
+      ++numberOfCalls;
+      std::vector<int> rows;
+      for (int row = 0; row < Features_Training.rows(); ++row)
+        if (drawSample(generator))
+          rows.push_back(row);
+      X.resize(rows.size(), Features_Training.cols());
+      Y.resize(rows.size(), 1);
+      for (unsigned int i = 0; i < rows.size(); ++i)
+      {
+        X.row(i) = Features_Training.row(rows[i]);
+        Y(i,0) = Labels_Training(rows[i],0);
+      }
+    }, 5);
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("One call per batch", 5, numberOfCalls);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("All trees are trained", 100, static_cast<int>(classifier->GetRandomForest().tree_count()));
+
+    Eigen::MatrixXi classes = classifier->Predict(Features_Testing);
+    MITK_TEST_CONDITION(isIntervall<int>(Labels_Testing,classes,95,100),"Testvalue of cancer data set is in range.");
+  }
+
+  // ------------------------------------------------------------------------------------------------------
+  // ------------------------------------------------------------------------------------------------------
+
+  void PredictFlatRandomForest_BreastCancerDataSet_EqualsVigraPrediction()
+  {
+    auto & Features_Training = FeatureData_Cancer.first;
+    auto & Features_Testing = FeatureData_Cancer.second;
+    auto & Labels_Training = LabelData_Cancer.first;
+
+    classifier->Train(Features_Training,Labels_Training);
+    const vigra::RandomForest<int> & rf = classifier->GetRandomForest();
+
+    // Reference prediction walking vigra's trees sample by sample
+    Eigen::MatrixXd vigraProbabilities(Features_Testing.rows(), rf.class_count());
+    vigraProbabilities.fill(0);
+    Eigen::MatrixXi vigraLabels(Features_Testing.rows(), 1);
+    vigra::MultiArrayView<2, double> X(vigra::Shape2(Features_Testing.rows(),Features_Testing.cols()),Features_Testing.data());
+    vigra::MultiArrayView<2, double> P(vigra::Shape2(vigraProbabilities.rows(),vigraProbabilities.cols()),vigraProbabilities.data());
+    vigra::MultiArrayView<2, int> Y(vigra::Shape2(vigraLabels.rows(),vigraLabels.cols()),vigraLabels.data());
+    rf.predictLabels(X, Y);
+    rf.predictProbabilities(X, P);
+
+    mitk::FlatRandomForest flatForest(rf);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("All trees are compiled", static_cast<unsigned int>(rf.tree_count()), flatForest.GetNumberOfTrees());
+
+    Eigen::MatrixXi labels;
+    Eigen::MatrixXd probabilities;
+    flatForest.Predict(Features_Testing, labels, probabilities);
+
+    for (int row = 0; row < Features_Testing.rows(); ++row)
+    {
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Flat forest predicts the vigra label", vigraLabels(row,0), labels(row,0));
+      for (int col = 0; col < rf.class_count(); ++col)
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Flat forest predicts the vigra probability", vigraProbabilities(row,col), probabilities(row,col));
+    }
+
+    // The classifier uses the flat forest
+    Eigen::MatrixXi classes = classifier->Predict(Features_Testing);
+    CPPUNIT_ASSERT_MESSAGE("Classifier predicts the flat forest labels", classes == labels);
+    CPPUNIT_ASSERT_MESSAGE("Classifier predicts the flat forest probabilities", classifier->GetPointWiseProbabilities() == probabilities);
+  }
+
 
   // ------------------------------------------------------------------------------------------------------
   // ------------------------------------------------------------------------------------------------------
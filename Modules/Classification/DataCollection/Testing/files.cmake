@@ -1,5 +1,7 @@
 SET(MODULE_TESTS
   mitkDataCollectionImageIteratorTest.cpp
+  mitkFeatureSampleStoreTest.cpp
+  mitkDataCollectionProcessBlockwiseTest.cpp
 )
 
 SET(MODULE_CUSTOM_TESTS
@@ -0,0 +1,174 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+
+#include <mitkDataCollection.h>
+#include <mitkDataCollectionUtilities.h>
+
+#include <itkImage.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+#include <sstream>
+
+class mitkDataCollectionProcessBlockwiseTestClass
+{
+private:
+  typedef itk::Image<double, 3> FeatureImageType;
+  typedef itk::Image<unsigned char, 3> MaskImageType;
+
+  std::vector<std::string> m_FeatureNames;
+
+  // Features depend on the position, the mask leaves out every third voxel
+  static mitk::DataCollection::Pointer CreatePatient(int sizeX, int sizeY, int sizeZ, double scale)
+  {
+    MaskImageType::SizeType size;
+    size[0] = sizeX;
+    size[1] = sizeY;
+    size[2] = sizeZ;
+    MaskImageType::RegionType region(size);
+
+    FeatureImageType::Pointer feature1 = FeatureImageType::New();
+    feature1->SetRegions(region);
+    feature1->Allocate();
+    FeatureImageType::Pointer feature2 = FeatureImageType::New();
+    feature2->SetRegions(region);
+    feature2->Allocate();
+    MaskImageType::Pointer mask = MaskImageType::New();
+    mask->SetRegions(region);
+    mask->Allocate();
+
+    itk::ImageRegionIteratorWithIndex<MaskImageType> maskIt(mask, region);
+    int voxel = 0;
+    for (; !maskIt.IsAtEnd(); ++maskIt, ++voxel)
+    {
+      const MaskImageType::IndexType index = maskIt.GetIndex();
+      feature1->SetPixel(index, scale * (index[0] + 0.5 * index[1]));
+      feature2->SetPixel(index, scale * (index[2] - 0.25 * index[0]) + 1);
+      maskIt.Set(voxel % 3 == 0 ? 0 : 1);
+    }
+
+    mitk::DataCollection::Pointer patient = mitk::DataCollection::New();
+    patient->AddData(feature1.GetPointer(), "F1");
+    patient->AddData(feature2.GetPointer(), "F2");
+    patient->AddData(mask.GetPointer(), "Mask");
+    return patient;
+  }
+
+  // Row-wise function, so the result of a row does not depend on the block
+  static void Classify(const Eigen::MatrixXd &features, Eigen::MatrixXi &labels, Eigen::MatrixXd &probabilities)
+  {
+    labels.resize(features.rows(), 1);
+    probabilities.resize(features.rows(), 2);
+    for (int r = 0; r < features.rows(); ++r)
+    {
+      labels(r, 0) = features(r, 0) > features(r, 1) ? 1 : 2;
+      probabilities(r, 0) = features(r, 0) + features(r, 1);
+      probabilities(r, 1) = features(r, 0) * features(r, 1);
+    }
+  }
+
+  template <typename TImageType>
+  static typename TImageType::Pointer GetImage(mitk::DataCollection::Pointer patient, const std::string &name)
+  {
+    return dynamic_cast<TImageType *>(patient->GetData(name).GetPointer());
+  }
+
+  template <typename TImageType>
+  static bool EqualInMask(mitk::DataCollection::Pointer patient, const std::string &name, const std::string &referenceName)
+  {
+    typename TImageType::Pointer image = GetImage<TImageType>(patient, name);
+    typename TImageType::Pointer reference = GetImage<TImageType>(patient, referenceName);
+    MaskImageType::Pointer mask = GetImage<MaskImageType>(patient, "Mask");
+    if (image.IsNull() || reference.IsNull())
+      return false;
+
+    itk::ImageRegionConstIterator<TImageType> it(image, image->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<TImageType> referenceIt(reference, reference->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<MaskImageType> maskIt(mask, mask->GetLargestPossibleRegion());
+    for (; !maskIt.IsAtEnd(); ++it, ++referenceIt, ++maskIt)
+    {
+      if (maskIt.Get() > 0 && it.Get() != referenceIt.Get())
+        return false;
+    }
+    return true;
+  }
+
+public:
+  mitk::DataCollection::Pointer m_Collection;
+
+  // Two patients of different size, the number of voxels in the masks is not a multiple of the block size
+  void Init()
+  {
+    m_FeatureNames.clear();
+    m_FeatureNames.push_back("F1");
+    m_FeatureNames.push_back("F2");
+
+    m_Collection = mitk::DataCollection::New();
+    m_Collection->SetName("BlockwiseCollection");
+    m_Collection->AddData(CreatePatient(7, 5, 3, 1.0).GetPointer(), "0001");
+    m_Collection->AddData(CreatePatient(6, 4, 5, -0.5).GetPointer(), "0002");
+
+    // Reference: the function applied once to the whole volume
+    Eigen::MatrixXd features = mitk::DCUtilities::DC3dDToMatrixXd(m_Collection, m_FeatureNames, "Mask");
+    Eigen::MatrixXi labels;
+    Eigen::MatrixXd probabilities;
+    Classify(features, labels, probabilities);
+    std::vector<std::string> referenceProbabilityNames;
+    referenceProbabilityNames.push_back("ReferenceProbability0");
+    referenceProbabilityNames.push_back("ReferenceProbability1");
+    mitk::DCUtilities::MatrixToDC3d(labels, m_Collection, "ReferenceLabel", "Mask");
+    mitk::DCUtilities::MatrixToDC3d(probabilities, m_Collection, referenceProbabilityNames, "Mask");
+  }
+
+  void BlockwiseEqualsWholeVolume(int voxelsPerBlock)
+  {
+    Init();
+    MITK_TEST_CONDITION_REQUIRED(mitk::DCUtilities::VoxelInMask(m_Collection, "Mask") % voxelsPerBlock != 0,
+                                 "Number of voxels is not a multiple of the block size");
+
+    std::vector<std::string> probabilityNames;
+    probabilityNames.push_back("Probability0");
+    probabilityNames.push_back("Probability1");
+    mitk::DCUtilities::ProcessBlockwise(m_Collection, m_FeatureNames, "Mask", "Label", probabilityNames, voxelsPerBlock, &Classify);
+
+    for (std::size_t i = 0; i < m_Collection->Size(); ++i)
+    {
+      mitk::DataCollection::Pointer patient = dynamic_cast<mitk::DataCollection *>(m_Collection->GetData(i).GetPointer());
+      std::stringstream message;
+      message << "patient " << i << ", " << voxelsPerBlock << " voxels per block";
+      MITK_TEST_CONDITION_REQUIRED(EqualInMask<MaskImageType>(patient, "Label", "ReferenceLabel"),
+                                   "Blockwise labels equal the whole volume labels, " << message.str());
+      MITK_TEST_CONDITION_REQUIRED(EqualInMask<FeatureImageType>(patient, "Probability0", "ReferenceProbability0"),
+                                   "Blockwise probabilities equal the whole volume probabilities, " << message.str());
+      MITK_TEST_CONDITION_REQUIRED(EqualInMask<FeatureImageType>(patient, "Probability1", "ReferenceProbability1"),
+                                   "Blockwise probabilities equal the whole volume probabilities, " << message.str());
+    }
+  }
+};
+
+int mitkDataCollectionProcessBlockwiseTest(int, char *[])
+{
+  MITK_TEST_BEGIN("mitkDataCollectionProcessBlockwiseTest");
+
+  mitkDataCollectionProcessBlockwiseTestClass test;
+  test.BlockwiseEqualsWholeVolume(16);  // blocks span both patients
+  test.BlockwiseEqualsWholeVolume(7);
+  test.BlockwiseEqualsWholeVolume(1000); // one incomplete block
+
+  MITK_TEST_END();
+}
@@ -0,0 +1,177 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+
+#include <mitkDataCollection.h>
+#include <mitkFeatureSampleStore.h>
+#include <mitkImageCast.h>
+#include <mitkIOUtil.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+#include <set>
+
+class mitkFeatureSampleStoreTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkFeatureSampleStoreTestSuite);
+  MITK_TEST(AddCollection_AllSamplesAreStored);
+  MITK_TEST(DrawBatch_IsStratified);
+  MITK_TEST(Reservoir_LimitsSamplesPerLabel);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  typedef itk::Image<double, 3> FeatureImageType;
+  typedef itk::Image<unsigned char, 3> MaskImageType;
+
+  mitk::DataCollection::Pointer m_Collection;
+  std::vector<std::string> m_Names;
+  std::string m_FilePrefix;
+
+  // the first feature encodes the case and the voxel position, the second one is its negative
+  mitk::DataCollection::Pointer CreateCase(int caseId, int size)
+  {
+    FeatureImageType::Pointer f1 = FeatureImageType::New();
+    FeatureImageType::Pointer f2 = FeatureImageType::New();
+    MaskImageType::Pointer mask = MaskImageType::New();
+    FeatureImageType::RegionType region;
+    region.SetSize(0, size);
+    region.SetSize(1, size);
+    region.SetSize(2, size);
+    f1->SetRegions(region);
+    f1->Allocate();
+    f2->SetRegions(region);
+    f2->Allocate();
+    mask->SetRegions(region);
+    mask->Allocate();
+
+    itk::ImageRegionIteratorWithIndex<FeatureImageType> it(f1, region);
+    itk::ImageRegionIterator<FeatureImageType> it2(f2, region);
+    itk::ImageRegionIterator<MaskImageType> mit(mask, region);
+    for (; !it.IsAtEnd(); ++it, ++it2, ++mit)
+    {
+      const FeatureImageType::IndexType index = it.GetIndex();
+      const double value = caseId*1000000 + index[0] + 100*index[1] + 10000*index[2];
+      it.Set(value);
+      it2.Set(-value);
+      // label 1 for most voxels, label 2 for every fifth, background for every seventh
+      const int position = index[0] + size*(index[1] + size*index[2]);
+      mit.Set(position % 7 == 0 ? 0 : (position % 5 == 0 ? 2 : 1));
+    }
+
+    mitk::Image::Pointer image1, image2, maskImage;
+    mitk::CastToMitkImage(f1, image1);
+    mitk::CastToMitkImage(f2, image2);
+    mitk::CastToMitkImage(mask, maskImage);
+
+    mitk::DataCollection::Pointer dc = mitk::DataCollection::New();
+    dc->AddData(image1.GetPointer(), "F1");
+    dc->AddData(image2.GetPointer(), "F2");
+    dc->AddData(maskImage.GetPointer(), "Mask");
+    return dc;
+  }
+
+  std::size_t CountLabel(int label, int size, int numberOfCases)
+  {
+    std::size_t count = 0;
+    for (int position = 0; position < size*size*size; ++position)
+      if (position % 7 != 0 && (position % 5 == 0 ? 2 : 1) == label)
+        ++count;
+    return count * numberOfCases;
+  }
+
+public:
+
+  void setUp() override
+  {
+    m_Collection = mitk::DataCollection::New();
+    m_Collection->AddData(CreateCase(1, 10).GetPointer(), "0001");
+    m_Collection->AddData(CreateCase(2, 10).GetPointer(), "0002");
+    m_Collection->AddData(CreateCase(3, 10).GetPointer(), "0003");
+    m_Names.clear();
+    m_Names.push_back("F1");
+    m_Names.push_back("F2");
+    m_FilePrefix = mitk::IOUtil::GetTempPath() + "mitkFeatureSampleStoreTest";
+  }
+
+  void tearDown() override
+  {
+    m_Collection = nullptr;
+  }
+
+  void AddCollection_AllSamplesAreStored()
+  {
+    mitk::FeatureSampleStore store(m_FilePrefix, 2);
+    store.AddCollection(m_Collection, m_Names, "Mask");
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Two labels", std::size_t(2), store.GetLabels().size());
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("All voxels of label 1", CountLabel(1, 10, 3), store.GetNumberOfSamples(1));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("All voxels of label 2", CountLabel(2, 10, 3), store.GetNumberOfSamples(2));
+
+    std::mt19937 generator(1);
+    Eigen::MatrixXd X;
+    Eigen::MatrixXi Y;
+    store.DrawBatch(1.0, false, generator, X, Y);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("The batch contains all samples", static_cast<int>(CountLabel(1, 10, 3) + CountLabel(2, 10, 3)), static_cast<int>(X.rows()));
+
+    std::set<double> values;
+    for (int row = 0; row < X.rows(); ++row)
+    {
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Features of a sample stay together", X(row, 0), -X(row, 1));
+      values.insert(X(row, 0));
+    }
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Each sample is drawn once", static_cast<std::size_t>(X.rows()), values.size());
+  }
+
+  void DrawBatch_IsStratified()
+  {
+    mitk::FeatureSampleStore store(m_FilePrefix, 2);
+    store.AddCollection(m_Collection, m_Names, "Mask");
+
+    std::mt19937 generator(1);
+    Eigen::MatrixXd X;
+    Eigen::MatrixXi Y;
+    store.DrawBatch(0.5, true, generator, X, Y);
+
+    int label2 = 0;
+    for (int row = 0; row < Y.rows(); ++row)
+      label2 += Y(row, 0) == 2 ? 1 : 0;
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Half of the samples of label 2", static_cast<int>((CountLabel(2, 10, 3) + 1) / 2), label2);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Half of the samples of label 1", static_cast<int>((CountLabel(1, 10, 3) + 1) / 2), static_cast<int>(Y.rows()) - label2);
+  }
+
+  void Reservoir_LimitsSamplesPerLabel()
+  {
+    mitk::FeatureSampleStore store(m_FilePrefix, 2, 50, 3);
+    store.AddCollection(m_Collection, m_Names, "Mask");
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Reservoir of label 1", std::size_t(50), store.GetNumberOfSamples(1));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Reservoir of label 2", std::size_t(50), store.GetNumberOfSamples(2));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("All voxels of label 1 are streamed", CountLabel(1, 10, 3), store.GetNumberOfAddedSamples(1));
+
+    std::mt19937 generator(1);
+    Eigen::MatrixXd X;
+    Eigen::MatrixXi Y;
+    store.DrawBatch(1.0, false, generator, X, Y);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Balanced batch", 100, static_cast<int>(X.rows()));
+    for (int row = 0; row < X.rows(); ++row)
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Features of a sample stay together", X(row, 0), -X(row, 1));
+  }
+
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkFeatureSampleStore)
@@ -206,6 +206,92 @@ void mitk::DCUtilities::MatrixToDC3d(const Eigen::MatrixXi &matrix, mitk::DataCo
   return MatrixToDC3d(matrix, dc, names, mask);
 }
 
+void mitk::DCUtilities::ProcessBlockwise(mitk::DataCollection::Pointer dc, const std::vector<std::string> &names, std::string mask,
+                                         const std::string &labelName, const std::vector<std::string> &probabilityNames,
+                                         int voxelsPerBlock, const BlockFunctionType &function)
+{
+  typedef mitk::DataCollectionImageIterator<double, 3> DataIterType;
+  typedef mitk::DataCollectionImageIterator<unsigned char, 3> LabelIterType;
+
+  int numberOfNames = names.size();
+  int numberOfProbabilities = probabilityNames.size();
+
+  EnsureUCharImageInDC(dc, labelName, mask);
+  for (int i = 0; i < numberOfProbabilities; ++i)
+  {
+    EnsureDoubleImageInDC(dc, probabilityNames[i], mask);
+  }
+
+  // The features are read ahead of the results, which are written once a block is processed
+  mitk::DataCollectionImageIterator<unsigned char, 3> maskIter(dc, mask);
+  std::vector<DataIterType> dataIter;
+  for (int i = 0; i < numberOfNames; ++i)
+  {
+    DataIterType iter(dc, names[i]);
+    dataIter.push_back(iter);
+  }
+
+  mitk::DataCollectionImageIterator<unsigned char, 3> resultMaskIter(dc, mask);
+  LabelIterType labelIter(dc, labelName);
+  std::vector<DataIterType> probabilityIter;
+  for (int i = 0; i < numberOfProbabilities; ++i)
+  {
+    DataIterType iter(dc, probabilityNames[i]);
+    probabilityIter.push_back(iter);
+  }
+
+  Eigen::MatrixXd block(voxelsPerBlock, numberOfNames);
+  Eigen::MatrixXi labels;
+  Eigen::MatrixXd probabilities;
+  int row = 0;
+  while ( ! maskIter.IsAtEnd() || row > 0 )
+  {
+    if ( ! maskIter.IsAtEnd() )
+    {
+      if (maskIter.GetVoxel() > 0)
+      {
+        for (int col = 0; col < numberOfNames; ++col)
+        {
+          block(row,col) = dataIter[col].GetVoxel();
+        }
+        ++row;
+      }
+      for (int col = 0; col < numberOfNames; ++col)
+      {
+        ++(dataIter[col]);
+      }
+      ++maskIter;
+    }
+    if (row == 0 || (row < voxelsPerBlock && ! maskIter.IsAtEnd()))
+      continue;
+
+    if (row < voxelsPerBlock)
+      block.conservativeResize(row, numberOfNames);
+    function(block, labels, probabilities);
+
+    int resultRow = 0;
+    while (resultRow < row)
+    {
+      if (resultMaskIter.GetVoxel() > 0)
+      {
+        labelIter.SetVoxel(labels(resultRow,0));
+        for (int col = 0; col < numberOfProbabilities && col < probabilities.cols(); ++col)
+        {
+          probabilityIter[col].SetVoxel(probabilities(resultRow,col));
+        }
+        ++resultRow;
+      }
+      ++labelIter;
+      for (int col = 0; col < numberOfProbabilities; ++col)
+      {
+        ++(probabilityIter[col]);
+      }
+      ++resultMaskIter;
+    }
+    row = 0;
+  }
+}
+
 void mitk::DCUtilities::EnsureUCharImageInDC(mitk::DataCollection::Pointer dc, std::string name, std::string origin)
 {
   typedef itk::Image<unsigned char, 3> FeatureImage;
@@ -22,11 +22,16 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkDataCollection.h>
 #include <Eigen/Dense>
 
+#include <functional>
+
 namespace mitk
 {
   class MITKDATACOLLECTION_EXPORT DCUtilities
   {
   public:
+    /** Computes labels and probabilities (of shape [n_samples, n_classes]) from a feature matrix of shape [n_samples, n_features]. */
+    typedef std::function<void(const Eigen::MatrixXd &features, Eigen::MatrixXi &labels, Eigen::MatrixXd &probabilities)> BlockFunctionType;
+
     static int VoxelInMask(mitk::DataCollection::Pointer dc, std::string mask);
 
     static Eigen::MatrixXd DC3dDToMatrixXd(mitk::DataCollection::Pointer dc, std::string names, std::string mask);
@@ -39,6 +44,15 @@ namespace mitk
     static void MatrixToDC3d(const Eigen::MatrixXd &matrix, mitk::DataCollection::Pointer dc, const std::string &names, std::string mask);
     static void MatrixToDC3d(const Eigen::MatrixXi &matrix, mitk::DataCollection::Pointer dc, const std::string &names, std::string mask);
 
+    /**
+    * @brief Streams the voxels of the mask through the function in blocks of at most voxelsPerBlock rows.
+    * The labels are written to the image labelName and the columns of the probabilities to the images probabilityNames.
+    * Only the feature matrix of one block is held in memory instead of the matrix of all voxels.
+    */
+    static void ProcessBlockwise(mitk::DataCollection::Pointer dc, const std::vector<std::string> &names, std::string mask,
+                                 const std::string &labelName, const std::vector<std::string> &probabilityNames,
+                                 int voxelsPerBlock, const BlockFunctionType &function);
+
     static void EnsureUCharImageInDC(mitk::DataCollection::Pointer dc, std::string name, std::string origin);
     static void EnsureDoubleImageInDC(mitk::DataCollection::Pointer dc, std::string name, std::string origin);
   };
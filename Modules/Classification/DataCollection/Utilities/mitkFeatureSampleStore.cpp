@@ -0,0 +1,343 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkFeatureSampleStore.h>
+
+#include <mitkDataCollectionImageIterator.h>
+#include <mitkExceptionMacro.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if _MSC_VER || __MINGW32__
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+  // number of voxels of a case that are gathered before they are added to the store
+  const int SAMPLES_PER_CHUNK = 1 << 16;
+
+  void SeekFile(std::FILE * file, std::size_t offset)
+  {
+#if _MSC_VER
+    int result = _fseeki64(file, static_cast<__int64>(offset), SEEK_SET);
+#elif __MINGW32__
+    int result = fseeko64(file, static_cast<off64_t>(offset), SEEK_SET);
+#else
+    int result = fseeko(file, static_cast<off_t>(offset), SEEK_SET);
+#endif
+    if (result != 0)
+      mitkThrow() << "Could not seek in the feature sample store";
+  }
+}
+
+/** Read-only mapping of the first bytes of a file. */
+struct mitk::FeatureSampleStore::MappedFile
+{
+  const double * m_Data;
+  std::size_t m_Size;
+#if _MSC_VER || __MINGW32__
+  HANDLE m_Handle;
+  HANDLE m_Mapping;
+#else
+  int m_Handle;
+#endif
+
+  MappedFile(const std::string &filename, std::size_t size)
+    : m_Data(nullptr)
+    , m_Size(size)
+  {
+#if _MSC_VER || __MINGW32__
+    m_Mapping = nullptr;
+    m_Handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (m_Handle == INVALID_HANDLE_VALUE)
+      mitkThrow() << "Could not open " << filename;
+    const unsigned long long mappingSize = size;
+    m_Mapping = CreateFileMappingA(m_Handle, nullptr, PAGE_READONLY, static_cast<DWORD>(mappingSize >> 32), static_cast<DWORD>(mappingSize & 0xFFFFFFFF), nullptr);
+    if (m_Mapping != nullptr)
+      m_Data = static_cast<const double *>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, size));
+    if (m_Data == nullptr)
+    {
+      if (m_Mapping != nullptr)
+        CloseHandle(m_Mapping);
+      CloseHandle(m_Handle);
+      mitkThrow() << "Could not map " << filename;
+    }
+#else
+    m_Handle = open(filename.c_str(), O_RDONLY);
+    if (m_Handle < 0)
+      mitkThrow() << "Could not open " << filename;
+    void * data = mmap(nullptr, m_Size, PROT_READ, MAP_SHARED, m_Handle, 0);
+    if (data == MAP_FAILED)
+    {
+      close(m_Handle);
+      mitkThrow() << "Could not map " << filename;
+    }
+    m_Data = static_cast<const double *>(data);
+    madvise(data, m_Size, MADV_RANDOM);
+#endif
+  }
+
+  ~MappedFile()
+  {
+#if _MSC_VER || __MINGW32__
+    UnmapViewOfFile(m_Data);
+    CloseHandle(m_Mapping);
+    CloseHandle(m_Handle);
+#else
+    munmap(const_cast<double *>(m_Data), m_Size);
+    close(m_Handle);
+#endif
+  }
+};
+
+mitk::FeatureSampleStore::FeatureSampleStore(const std::string &filePrefix, unsigned int numberOfFeatures, std::size_t maximumSamplesPerLabel, unsigned int seed)
+  : m_FilePrefix(filePrefix)
+  , m_NumberOfFeatures(numberOfFeatures)
+  , m_MaximumSamplesPerLabel(maximumSamplesPerLabel)
+  , m_Generator(seed)
+{
+  if (numberOfFeatures == 0)
+    mitkThrow() << "The feature sample store needs at least one feature";
+}
+
+mitk::FeatureSampleStore::~FeatureSampleStore()
+{
+  for (auto & entry : m_LabelFiles)
+  {
+    entry.second->m_Mapping.reset();
+    std::fclose(entry.second->m_File);
+    std::remove(entry.second->m_FileName.c_str());
+  }
+}
+
+mitk::FeatureSampleStore::LabelFile & mitk::FeatureSampleStore::GetLabelFile(int label)
+{
+  std::unique_ptr<LabelFile> & labelFile = m_LabelFiles[label];
+  if (labelFile == nullptr)
+  {
+    labelFile.reset(new LabelFile);
+    labelFile->m_FileName = m_FilePrefix + "_label" + std::to_string(label) + ".bin";
+    labelFile->m_File = std::fopen(labelFile->m_FileName.c_str(), "w+b");
+    labelFile->m_NumberOfSamples = 0;
+    labelFile->m_NumberOfAddedSamples = 0;
+    labelFile->m_Position = 0;
+    if (labelFile->m_File == nullptr)
+    {
+      m_LabelFiles.erase(label);
+      mitkThrow() << "Could not create the feature sample file for label " << label;
+    }
+  }
+  return *labelFile;
+}
+
+void mitk::FeatureSampleStore::AddSamples(const Eigen::MatrixXd &X, const Eigen::MatrixXi &Y)
+{
+  if (X.cols() != static_cast<int>(m_NumberOfFeatures) || Y.rows() != X.rows() || Y.cols() < 1)
+    mitkThrow() << "Samples of shape [" << X.rows() << ", " << X.cols() << "] with " << Y.rows() << " labels do not fit the feature sample store";
+
+  const std::size_t sampleSize = m_NumberOfFeatures * sizeof(double);
+  std::vector<double> sample(m_NumberOfFeatures);
+
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  for (int r = 0; r < X.rows(); ++r)
+  {
+    LabelFile & labelFile = this->GetLabelFile(Y(r, 0));
+    labelFile.m_Mapping.reset();
+    ++labelFile.m_NumberOfAddedSamples;
+
+    // reservoir sampling, the n-th sample replaces a random one with probability maximum/n
+    std::size_t slot = labelFile.m_NumberOfSamples;
+    if (m_MaximumSamplesPerLabel > 0 && labelFile.m_NumberOfSamples >= m_MaximumSamplesPerLabel)
+    {
+      slot = std::uniform_int_distribution<std::size_t>(0, labelFile.m_NumberOfAddedSamples - 1)(m_Generator);
+      if (slot >= m_MaximumSamplesPerLabel)
+        continue;
+    }
+
+    for (unsigned int f = 0; f < m_NumberOfFeatures; ++f)
+      sample[f] = X(r, f);
+    // appended samples are written without seeking, which would flush the buffer of the file
+    if (labelFile.m_Position != slot * sampleSize)
+      SeekFile(labelFile.m_File, slot * sampleSize);
+    if (std::fwrite(sample.data(), sizeof(double), m_NumberOfFeatures, labelFile.m_File) != m_NumberOfFeatures)
+      mitkThrow() << "Could not write to the feature sample file " << labelFile.m_FileName;
+    labelFile.m_Position = (slot + 1) * sampleSize;
+    if (slot == labelFile.m_NumberOfSamples)
+      ++labelFile.m_NumberOfSamples;
+  }
+}
+
+void mitk::FeatureSampleStore::CollectCases(mitk::DataCollection::Pointer dc, const std::string &mask, std::vector<mitk::DataCollection::Pointer> &cases)
+{
+  if (dc->HasElement(mask) && dynamic_cast<mitk::DataCollection *>(dc->GetData(mask).GetPointer()) == nullptr)
+  {
+    cases.push_back(dc);
+    return;
+  }
+  for (std::size_t i = 0; i < dc->Size(); ++i)
+  {
+    mitk::DataCollection * child = dynamic_cast<mitk::DataCollection *>(dc->GetData(i).GetPointer());
+    if (child != nullptr)
+      this->CollectCases(child, mask, cases);
+  }
+}
+
+void mitk::FeatureSampleStore::AddCollection(mitk::DataCollection::Pointer dc, const std::vector<std::string> &names, const std::string &mask)
+{
+  if (names.size() != m_NumberOfFeatures)
+    mitkThrow() << names.size() << " feature images do not fit the " << m_NumberOfFeatures << " features of the store";
+
+  std::vector<mitk::DataCollection::Pointer> cases;
+  this->CollectCases(dc, mask, cases);
+
+  const int numberOfFeatures = static_cast<int>(m_NumberOfFeatures);
+  std::string error;
+#pragma omp parallel for schedule(dynamic)
+  for (int c = 0; c < static_cast<int>(cases.size()); ++c)
+  {
+    try
+    {
+      typedef mitk::DataCollectionImageIterator<double, 3> DataIterType;
+      mitk::DataCollectionImageIterator<unsigned char, 3> maskIter(cases[c], mask);
+      std::vector<DataIterType> dataIter;
+      for (int f = 0; f < numberOfFeatures; ++f)
+        dataIter.push_back(DataIterType(cases[c], names[f]));
+
+      Eigen::MatrixXd X(SAMPLES_PER_CHUNK, numberOfFeatures);
+      Eigen::MatrixXi Y(SAMPLES_PER_CHUNK, 1);
+      int rows = 0;
+      while (!maskIter.IsAtEnd())
+      {
+        if (maskIter.GetVoxel() > 0)
+        {
+          for (int f = 0; f < numberOfFeatures; ++f)
+            X(rows, f) = dataIter[f].GetVoxel();
+          Y(rows, 0) = maskIter.GetVoxel();
+          if (++rows == SAMPLES_PER_CHUNK)
+          {
+            this->AddSamples(X, Y);
+            rows = 0;
+          }
+        }
+        for (int f = 0; f < numberOfFeatures; ++f)
+          ++(dataIter[f]);
+        ++maskIter;
+      }
+      if (rows > 0)
+        this->AddSamples(X.topRows(rows), Y.topRows(rows));
+    }
+    catch (const std::exception &e)
+    {
+#pragma omp critical
+      error = e.what();
+    }
+  }
+  if (!error.empty())
+    mitkThrow() << "Could not add the cases to the feature sample store: " << error;
+}
+
+std::vector<int> mitk::FeatureSampleStore::GetLabels() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  std::vector<int> labels;
+  for (const auto & entry : m_LabelFiles)
+    labels.push_back(entry.first);
+  return labels;
+}
+
+std::size_t mitk::FeatureSampleStore::GetNumberOfSamples(int label) const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  auto entry = m_LabelFiles.find(label);
+  return entry == m_LabelFiles.end() ? 0 : entry->second->m_NumberOfSamples;
+}
+
+std::size_t mitk::FeatureSampleStore::GetNumberOfAddedSamples(int label) const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  auto entry = m_LabelFiles.find(label);
+  return entry == m_LabelFiles.end() ? 0 : entry->second->m_NumberOfAddedSamples;
+}
+
+void mitk::FeatureSampleStore::DrawBatch(double fraction, bool withReplacement, std::mt19937 &generator, Eigen::MatrixXd &X, Eigen::MatrixXi &Y)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  if (m_LabelFiles.empty())
+    mitkThrow() << "The feature sample store is empty";
+
+  std::vector<std::size_t> batchSizes;
+  std::size_t numberOfRows = 0;
+  for (const auto & entry : m_LabelFiles)
+  {
+    const std::size_t numberOfSamples = entry.second->m_NumberOfSamples;
+    std::size_t batchSize = std::max<std::size_t>(1, static_cast<std::size_t>(std::llround(fraction * numberOfSamples)));
+    if (!withReplacement)
+      batchSize = std::min(batchSize, numberOfSamples);
+    batchSizes.push_back(batchSize);
+    numberOfRows += batchSize;
+  }
+
+  X.resize(numberOfRows, m_NumberOfFeatures);
+  Y.resize(numberOfRows, 1);
+  int row = 0;
+  int labelIndex = 0;
+  std::vector<std::size_t> indices;
+  for (const auto & entry : m_LabelFiles)
+  {
+    LabelFile & labelFile = *entry.second;
+    const std::size_t numberOfSamples = labelFile.m_NumberOfSamples;
+    const std::size_t batchSize = batchSizes[labelIndex++];
+
+    indices.clear();
+    if (withReplacement)
+    {
+      std::uniform_int_distribution<std::size_t> draw(0, numberOfSamples - 1);
+      for (std::size_t i = 0; i < batchSize; ++i)
+        indices.push_back(draw(generator));
+      std::sort(indices.begin(), indices.end());
+    }
+    else
+    {
+      // selection sampling, needs no memory for the indices that are not drawn
+      std::uniform_real_distribution<double> uniform(0.0, 1.0);
+      for (std::size_t i = 0; i < numberOfSamples && indices.size() < batchSize; ++i)
+        if ((numberOfSamples - i) * uniform(generator) < batchSize - indices.size())
+          indices.push_back(i);
+    }
+
+    if (labelFile.m_Mapping == nullptr)
+    {
+      std::fflush(labelFile.m_File);
+      labelFile.m_Mapping.reset(new MappedFile(labelFile.m_FileName, numberOfSamples * m_NumberOfFeatures * sizeof(double)));
+    }
+    const double * data = labelFile.m_Mapping->m_Data;
+    for (std::size_t index : indices)
+    {
+      const double * sample = data + index * m_NumberOfFeatures;
+      for (unsigned int f = 0; f < m_NumberOfFeatures; ++f)
+        X(row, f) = sample[f];
+      Y(row, 0) = entry.first;
+      ++row;
+    }
+  }
+}
@@ -0,0 +1,105 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkFeatureSampleStore_h
+#define mitkFeatureSampleStore_h
+
+#include <MitkDataCollectionExports.h>
+
+#include <mitkDataCollection.h>
+#include <Eigen/Dense>
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace mitk
+{
+  /**
+  * @brief Disk backed store of labeled feature vectors for training classifiers on many cases.
+  *
+  * The samples of each label are written to a file of their own, so the feature matrix of all
+  * training voxels is never held in memory. If a maximum number of samples per label is given,
+  * each label keeps a uniform reservoir sample of all voxels streamed for it, which also balances
+  * the labels. Training batches are drawn stratified per label from the memory mapped files.
+  * Samples can be added from several threads. The files are removed by the destructor.
+  */
+  class MITKDATACOLLECTION_EXPORT FeatureSampleStore
+  {
+  public:
+    /**
+    * @param filePrefix prefix of the per label files, e.g. a path in a temporary directory
+    * @param maximumSamplesPerLabel size of the reservoir of each label, 0 keeps all samples
+    */
+    FeatureSampleStore(const std::string &filePrefix, unsigned int numberOfFeatures, std::size_t maximumSamplesPerLabel = 0, unsigned int seed = 0);
+    ~FeatureSampleStore();
+
+    FeatureSampleStore(const FeatureSampleStore&) = delete;
+    FeatureSampleStore& operator=(const FeatureSampleStore&) = delete;
+
+    /**
+    * @brief Adds the voxels of the mask with the features of the images names, labeled by the mask value.
+    * The cases of the collection, i.e. the collections that contain the mask, are streamed in parallel.
+    */
+    void AddCollection(mitk::DataCollection::Pointer dc, const std::vector<std::string> &names, const std::string &mask);
+
+    /** Adds samples of shape [n_samples, n_features] with labels of shape [n_samples, 1]. */
+    void AddSamples(const Eigen::MatrixXd &X, const Eigen::MatrixXi &Y);
+
+    std::vector<int> GetLabels() const;
+    unsigned int GetNumberOfFeatures() const { return m_NumberOfFeatures; }
+
+    /** Number of samples stored for the label, at most the maximum number of samples per label. */
+    std::size_t GetNumberOfSamples(int label) const;
+
+    /** Number of samples added for the label, including those not kept in the reservoir. */
+    std::size_t GetNumberOfAddedSamples(int label) const;
+
+    /**
+    * @brief Draws the given fraction of the stored samples of each label, but at least one sample per label.
+    * Each label is represented in every batch, so forests trained on different batches know the same classes.
+    */
+    void DrawBatch(double fraction, bool withReplacement, std::mt19937 &generator, Eigen::MatrixXd &X, Eigen::MatrixXi &Y);
+
+  private:
+    struct MappedFile;
+    struct LabelFile
+    {
+      std::string m_FileName;
+      std::FILE * m_File;
+      std::size_t m_NumberOfSamples;
+      std::size_t m_NumberOfAddedSamples;
+      std::size_t m_Position;
+      std::unique_ptr<MappedFile> m_Mapping;
+    };
+
+    void CollectCases(mitk::DataCollection::Pointer dc, const std::string &mask, std::vector<mitk::DataCollection::Pointer> &cases);
+    LabelFile & GetLabelFile(int label);
+
+    std::string m_FilePrefix;
+    unsigned int m_NumberOfFeatures;
+    std::size_t m_MaximumSamplesPerLabel;
+    std::mt19937 m_Generator;
+    std::map<int, std::unique_ptr<LabelFile> > m_LabelFiles;
+    mutable std::mutex m_Mutex;
+  };
+}
+
+#endif
@@ -6,6 +6,7 @@ SET(CPP_FILES
   Utilities/mitkCostingStatistic.cpp
   Utilities/mitkCollectionStatistic.cpp
   Utilities/mitkDataCollectionUtilities.cpp
+  Utilities/mitkFeatureSampleStore.cpp
   testcase.cpp
 )
 
@@ -20,5 +21,6 @@ SET(H_FILES
   Utilities/mitkCostingStatistic.h
   Utilities/mitkCollectionStatistic.h
   Utilities/mitkDataCollectionUtilities.h
+  Utilities/mitkFeatureSampleStore.h
   testcase.h
 )
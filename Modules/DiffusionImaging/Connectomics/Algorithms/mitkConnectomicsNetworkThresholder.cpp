@@ -15,8 +15,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkConnectomicsNetworkThresholder.h"
-#include <mitkConnectomicsStatisticsCalculator.h>
-#include "vnl/vnl_random.h"
+
+#include <algorithm>
+#include <numeric>
 
 mitk::ConnectomicsNetworkThresholder::ConnectomicsNetworkThresholder()
   : m_Network( nullptr )
@@ -113,137 +114,199 @@ bool mitk::ConnectomicsNetworkThresholder::CheckValidity()
   return valid;
 }
 
-mitk::ConnectomicsNetwork::Pointer mitk::ConnectomicsNetworkThresholder::ThresholdByRandomRemoval( mitk::ConnectomicsNetwork::Pointer input, double targetDensity )
+std::vector< mitk::ConnectomicsNetwork::Pointer > mitk::ConnectomicsNetworkThresholder::GetThresholdedNetworks( const std::vector< double >& targets )
 {
-  mitk::ConnectomicsNetwork::Pointer result = mitk::ConnectomicsNetwork::New();
-  result->ImportNetwort( input );
+  std::vector< mitk::ConnectomicsNetwork::Pointer > results( targets.size(), m_Network );
+  if( targets.empty() )
+  {
+    return results;
+  }
+
+  double targetDensity( m_TargetDensity );
+  double targetThreshold( m_TargetThreshold );
+  bool valid( true );
+  for( unsigned int loop( 0 ); loop < targets.size() && valid; loop++ )
+  {
+    m_TargetDensity = targets[ loop ];
+    m_TargetThreshold = targets[ loop ];
+    valid = CheckValidity();
+  }
+  m_TargetDensity = targetDensity;
+  m_TargetThreshold = targetThreshold;
+
+  if( !valid )
+  {
+    MITK_ERROR << "Aborting";
+    return results;
+  }
 
-  mitk::ConnectomicsStatisticsCalculator::Pointer calculator = mitk::ConnectomicsStatisticsCalculator::New();
+  // densities are reached in descending, thresholds in ascending order
+  std::vector< unsigned int > order( targets.size() );
+  std::iota( order.begin(), order.end(), 0 );
+  if( m_ThresholdingScheme == ThresholdBased )
+  {
+    std::stable_sort( order.begin(), order.end(), [&targets]( unsigned int a, unsigned int b ) { return targets[ a ] < targets[ b ]; } );
+  }
+  else
+  {
+    std::stable_sort( order.begin(), order.end(), [&targets]( unsigned int a, unsigned int b ) { return targets[ a ] > targets[ b ]; } );
+  }
 
-  calculator->SetNetwork( result );
-  calculator->Update();
+  mitk::ConnectomicsNetwork::Pointer working = mitk::ConnectomicsNetwork::New();
+  working->ImportNetwort( m_Network );
+  NetworkType* boostGraph = working->GetBoostGraph();
+  std::vector< EdgeDescriptorType > sortedEdges = GetEdgesSortedByWeight( boostGraph );
+  unsigned int numberOfRemovedEdges( 0 );
 
   //the random number generator
   vnl_random rng( (unsigned int) rand() );
 
-  bool notBelow( targetDensity < calculator->GetConnectionDensity() );
-
-  double minWeight( result->GetMaximumWeight() );
-  int count( 0 );
-
-  while( notBelow )
+  for( unsigned int loop( 0 ); loop < order.size(); loop++ )
   {
- //   result = Threshold( result, loop );
-    std::vector< EdgeDescriptorType > candidateVector;
-    minWeight = result->GetMaximumWeight();
-    count = 0;
-
-    // determine minimum weight and number of edges having that weight
-    NetworkType* boostGraph = result->GetBoostGraph();
-    EdgeIteratorType iterator, end;
-    // sets iterator to start end end to end
-    boost::tie(iterator, end) = boost::edges( *boostGraph );
-
-    for ( ; iterator != end; ++iterator)
+    double target( targets[ order[ loop ] ] );
+    switch(m_ThresholdingScheme)
     {
-      double tempWeight;
-
-      // the value of an iterator is a descriptor
-      tempWeight = (*boostGraph)[ *iterator ].weight;
-
-      if( mitk::Equal( tempWeight, minWeight ) )
+    case RandomRemovalOfWeakest :
       {
-        candidateVector.push_back( *iterator );
-        count++;
+        RemoveWeakestEdgesRandomly( boostGraph, sortedEdges, numberOfRemovedEdges, target, rng );
+        break;
       }
-      else if( tempWeight < minWeight )
+    case LargestLowerThanDensity :
       {
-        candidateVector.clear();
-        candidateVector.push_back( *iterator );
-        minWeight = tempWeight;
-        count = 1;
+        RemoveWeakestEdgesBelowDensity( boostGraph, sortedEdges, numberOfRemovedEdges, target );
+        break;
+      }
+    case ThresholdBased :
+      {
+        RemoveEdgesBelowThreshold( boostGraph, sortedEdges, numberOfRemovedEdges, target );
+        break;
       }
     }
 
+    mitk::ConnectomicsNetwork::Pointer result = mitk::ConnectomicsNetwork::New();
+    result->ImportNetwort( working );
+    result->UpdateIDs();
+    results[ order[ loop ] ] = result;
+  }
+
+  return results;
+}
+
+std::vector< mitk::ConnectomicsNetworkThresholder::EdgeDescriptorType > mitk::ConnectomicsNetworkThresholder::GetEdgesSortedByWeight( NetworkType* boostGraph )
+{
+  std::vector< EdgeDescriptorType > sortedEdges;
+  sortedEdges.reserve( boost::num_edges( *boostGraph ) );
+
+  EdgeIteratorType iterator, end;
+  for( boost::tie(iterator, end) = boost::edges( *boostGraph ); iterator != end; ++iterator )
+  {
+    sortedEdges.push_back( *iterator );
+  }
+
+  std::stable_sort( sortedEdges.begin(), sortedEdges.end(),
+    [boostGraph]( const EdgeDescriptorType& a, const EdgeDescriptorType& b ) { return (*boostGraph)[ a ].weight < (*boostGraph)[ b ].weight; } );
+
+  return sortedEdges;
+}
+
+double mitk::ConnectomicsNetworkThresholder::GetConnectionDensity( NetworkType* boostGraph )
+{
+  double numberOfVertices( boost::num_vertices( *boostGraph ) );
+  double numberOfPossibleEdges = numberOfVertices * ( numberOfVertices - 1 ) / 2;
+
+  return (double) boost::num_edges( *boostGraph ) / numberOfPossibleEdges;
+}
+
+void mitk::ConnectomicsNetworkThresholder::RemoveWeakestEdgesRandomly( NetworkType* boostGraph, std::vector< EdgeDescriptorType >& sortedEdges,
+  unsigned int& numberOfRemovedEdges, double targetDensity, vnl_random& rng )
+{
+  while( targetDensity < GetConnectionDensity( boostGraph ) )
+  {
+    // the candidates are the remaining edges of minimum weight
+    std::vector< EdgeDescriptorType >::iterator first = sortedEdges.begin() + numberOfRemovedEdges;
+    std::vector< EdgeDescriptorType >::iterator last = first;
+    while( last != sortedEdges.end() && (*boostGraph)[ *last ].weight == (*boostGraph)[ *first ].weight )
+    {
+      ++last;
+    }
+    int count( last - first );
+
     // Which to delete
     int deleteNumber( rng.lrand32( count - 1 ) );
 
-    boost::remove_edge( candidateVector.at( deleteNumber ), *boostGraph );
+    boost::remove_edge( *( first + deleteNumber ), *boostGraph );
 
-    calculator->SetNetwork( result );
-    calculator->Update();
-    notBelow = targetDensity < calculator->GetConnectionDensity();
+    // move the removed edge in front of the remaining candidates, which keep their order
+    std::rotate( first, first + deleteNumber, first + deleteNumber + 1 );
+    numberOfRemovedEdges++;
   }
+}
 
-  result->UpdateIDs();
-  return result;
+void mitk::ConnectomicsNetworkThresholder::RemoveWeakestEdgesBelowDensity( NetworkType* boostGraph, std::vector< EdgeDescriptorType >& sortedEdges,
+  unsigned int& numberOfRemovedEdges, double targetDensity )
+{
+  while( targetDensity < GetConnectionDensity( boostGraph ) )
+  {
+    // the smallest integer threshold that removes at least one further edge
+    double threshold( std::max( 1, (*boostGraph)[ sortedEdges[ numberOfRemovedEdges ] ].weight + 1 ) );
+    RemoveEdgesBelowThreshold( boostGraph, sortedEdges, numberOfRemovedEdges, threshold );
+  }
 }
 
-mitk::ConnectomicsNetwork::Pointer mitk::ConnectomicsNetworkThresholder::ThresholdBelowDensity( mitk::ConnectomicsNetwork::Pointer input, double targetDensity )
+void mitk::ConnectomicsNetworkThresholder::RemoveEdgesBelowThreshold( NetworkType* boostGraph, std::vector< EdgeDescriptorType >& sortedEdges,
+  unsigned int& numberOfRemovedEdges, double targetThreshold )
+{
+  while( numberOfRemovedEdges < sortedEdges.size() && (*boostGraph)[ sortedEdges[ numberOfRemovedEdges ] ].weight < targetThreshold )
+  {
+    boost::remove_edge( sortedEdges[ numberOfRemovedEdges ], *boostGraph );
+    numberOfRemovedEdges++;
+  }
+}
+
+mitk::ConnectomicsNetwork::Pointer mitk::ConnectomicsNetworkThresholder::ThresholdByRandomRemoval( mitk::ConnectomicsNetwork::Pointer input, double targetDensity )
 {
   mitk::ConnectomicsNetwork::Pointer result = mitk::ConnectomicsNetwork::New();
   result->ImportNetwort( input );
 
-  mitk::ConnectomicsStatisticsCalculator::Pointer calculator = mitk::ConnectomicsStatisticsCalculator::New();
-
-  calculator->SetNetwork( result );
-  calculator->Update();
+  NetworkType* boostGraph = result->GetBoostGraph();
+  std::vector< EdgeDescriptorType > sortedEdges = GetEdgesSortedByWeight( boostGraph );
+  unsigned int numberOfRemovedEdges( 0 );
 
-  bool notBelow( targetDensity < calculator->GetConnectionDensity() );
+  //the random number generator
+  vnl_random rng( (unsigned int) rand() );
 
-  for( int loop( 1 ); notBelow; loop++ )
-  {
-    result = Threshold( result, loop );
-    calculator->SetNetwork( result );
-    calculator->Update();
-    notBelow = targetDensity < calculator->GetConnectionDensity();
-  }
+  RemoveWeakestEdgesRandomly( boostGraph, sortedEdges, numberOfRemovedEdges, targetDensity, rng );
 
+  result->UpdateIDs();
   return result;
 }
 
-mitk::ConnectomicsNetwork::Pointer mitk::ConnectomicsNetworkThresholder::Threshold( mitk::ConnectomicsNetwork::Pointer input, double targetThreshold )
+mitk::ConnectomicsNetwork::Pointer mitk::ConnectomicsNetworkThresholder::ThresholdBelowDensity( mitk::ConnectomicsNetwork::Pointer input, double targetDensity )
 {
   mitk::ConnectomicsNetwork::Pointer result = mitk::ConnectomicsNetwork::New();
   result->ImportNetwort( input );
 
   NetworkType* boostGraph = result->GetBoostGraph();
+  std::vector< EdgeDescriptorType > sortedEdges = GetEdgesSortedByWeight( boostGraph );
+  unsigned int numberOfRemovedEdges( 0 );
 
-  EdgeIteratorType iterator, end;
+  RemoveWeakestEdgesBelowDensity( boostGraph, sortedEdges, numberOfRemovedEdges, targetDensity );
 
-  // set to true if iterators are invalidated by deleting an edge
-  bool edgeHasBeenRemoved( true );
+  result->UpdateIDs();
+  return result;
+}
 
-  // if no edge has been removed in the last loop, we are done
-  while( edgeHasBeenRemoved )
-  {
-    edgeHasBeenRemoved = false;
-    // sets iterator to start and end to end
-    boost::tie(iterator, end) = boost::edges( *boostGraph );
+mitk::ConnectomicsNetwork::Pointer mitk::ConnectomicsNetworkThresholder::Threshold( mitk::ConnectomicsNetwork::Pointer input, double targetThreshold )
+{
+  mitk::ConnectomicsNetwork::Pointer result = mitk::ConnectomicsNetwork::New();
+  result->ImportNetwort( input );
 
-    bool endReached( false );
-    while( !edgeHasBeenRemoved && !endReached )
-    {
-      if( iterator != end )
-      {
-        // If the edge is below the target threshold it is deleted
-        if( (*boostGraph)[ *iterator ].weight < targetThreshold )
-        {
-          edgeHasBeenRemoved = true;
-          // this invalidates all iterators
-          boost::remove_edge( *iterator, *boostGraph );
-        }
-        else
-        {
-          ++iterator;
-        }
-      }
-      else
-      {
-        endReached = true;
-      }
-    }
-  }
+  NetworkType* boostGraph = result->GetBoostGraph();
+
+  // removes all edges below the target threshold in a single pass
+  boost::remove_edge_if(
+    [boostGraph, targetThreshold]( const EdgeDescriptorType& edge ) { return (*boostGraph)[ edge ].weight < targetThreshold; },
+    *boostGraph );
 
   result->UpdateIDs();
 
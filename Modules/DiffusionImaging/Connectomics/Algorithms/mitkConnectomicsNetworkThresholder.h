@@ -27,6 +27,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <mitkConnectomicsNetwork.h>
 
+#include "vnl/vnl_random.h"
+
 namespace mitk
 {
   /**
@@ -81,6 +83,13 @@ namespace mitk
     /** \brief Apply thresholding scheme and get resulting network */
     mitk::ConnectomicsNetwork::Pointer GetThresholdedNetwork();
 
+    /** \brief Apply thresholding scheme for each of the targets (densities or thresholds, depending on the scheme)
+    *
+    * The edges are removed in the order of their weight from a single copy of the network, which is stored
+    * whenever a target is reached. The networks are returned in the order of the targets.
+    */
+    std::vector< mitk::ConnectomicsNetwork::Pointer > GetThresholdedNetworks( const std::vector< double >& targets );
+
   protected:
 
     //////////////////// Functions ///////////////////////
@@ -93,6 +102,18 @@ namespace mitk
     // Returns false if parameter combination is invalid
     bool CheckValidity();
 
+    // Edges of the network, sorted by ascending weight. Edges of equal weight keep the order of the edge iteration.
+    std::vector< EdgeDescriptorType > GetEdgesSortedByWeight( NetworkType* boostGraph );
+    double GetConnectionDensity( NetworkType* boostGraph );
+
+    // These remove the next edges of the sorted edges from the network, numberOfRemovedEdges is increased accordingly
+    void RemoveWeakestEdgesRandomly( NetworkType* boostGraph, std::vector< EdgeDescriptorType >& sortedEdges,
+      unsigned int& numberOfRemovedEdges, double targetDensity, vnl_random& rng );
+    void RemoveWeakestEdgesBelowDensity( NetworkType* boostGraph, std::vector< EdgeDescriptorType >& sortedEdges,
+      unsigned int& numberOfRemovedEdges, double targetDensity );
+    void RemoveEdgesBelowThreshold( NetworkType* boostGraph, std::vector< EdgeDescriptorType >& sortedEdges,
+      unsigned int& numberOfRemovedEdges, double targetThreshold );
+
     /////////////////////// Variables ////////////////////////
 
     // The connectomics network, which is used for statistics calculation
@@ -18,41 +18,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkConnectomicsNetworkConverter.h"
 
 #include <numeric>
+#include <cmath>
 
 #include <boost/graph/connected_components.hpp>
-#include <boost/graph/clustering_coefficient.hpp>
-#include <boost/graph/betweenness_centrality.hpp>
-#include <boost/graph/visitors.hpp>
 
 #include "vnl/algo/vnl_symmetric_eigensystem.h"
 
-template<typename GraphType>
-class all_pairs_shortest_recorder : public boost::default_bfs_visitor
-{
-public:
-  typedef typename boost::graph_traits<GraphType>::vertex_descriptor VertexType;
-  typedef typename boost::graph_traits<GraphType>::edge_descriptor EdgeType;
-
-  all_pairs_shortest_recorder(int* dist, int &max, unsigned int &size)
-  {
-    d = dist;
-    ecc = &max;
-    component_size = &size;
-  }
-
-  void tree_edge(EdgeType edge, const GraphType& graph) {
-    VertexType u = boost::source(edge, graph);
-    VertexType v = boost::target(edge, graph);
-    d[v] = d[u] + 1;
-    *ecc = d[v];
-    *component_size = *component_size + 1;
-  }
-private:
-  int* d;
-  int* ecc;
-  unsigned int* component_size;
-};
-
 mitk::ConnectomicsStatisticsCalculator::ConnectomicsStatisticsCalculator()
   : m_Network( nullptr )
   , m_NumberOfVertices( 0 )
@@ -122,12 +93,14 @@ void mitk::ConnectomicsStatisticsCalculator::Update()
 {
   CalculateNumberOfVertices();
   CalculateNumberOfEdges();
+  BuildAdjacencyLists();
   CalculateAverageDegree();
   CalculateConnectionDensity();
   CalculateNumberOfConnectedComponents();
   CalculateAverageComponentSize();
   CalculateLargestComponentSize();
   CalculateRatioOfNodesInLargestComponent();
+  CalculateAllPairsShortestPaths();
   CalculateHopPlotValues();
   CalculateClusteringCoefficients();
   CalculateBetweennessCentrality();
@@ -149,6 +122,41 @@ void mitk::ConnectomicsStatisticsCalculator::CalculateNumberOfEdges()
   m_NumberOfEdges = boost::num_edges(  *(m_Network->GetBoostGraph()) );
 }
 
+void mitk::ConnectomicsStatisticsCalculator::BuildAdjacencyLists()
+{
+  NetworkType* graph = m_Network->GetBoostGraph();
+  VertexIndexMapType vertexIndex = get(boost::vertex_index, *graph );
+
+  std::vector< std::pair< unsigned int, unsigned int > > endpoints;
+  endpoints.reserve( m_NumberOfEdges );
+  m_AdjacencyOffsets.assign( m_NumberOfVertices + 1, 0 );
+
+  EdgeIteratorType iterator, end;
+  for( boost::tie(iterator, end) = boost::edges( *graph ); iterator != end; ++iterator )
+  {
+    unsigned int source = vertexIndex[ boost::source( *iterator, *graph ) ];
+    unsigned int target = vertexIndex[ boost::target( *iterator, *graph ) ];
+    endpoints.push_back( std::make_pair( source, target ) );
+    m_AdjacencyOffsets[ source + 1 ]++;
+    m_AdjacencyOffsets[ target + 1 ]++;
+  }
+  for(unsigned int i=0; i < m_NumberOfVertices; i++)
+  {
+    m_AdjacencyOffsets[ i + 1 ] += m_AdjacencyOffsets[ i ];
+  }
+
+  m_AdjacentVertices.resize( m_AdjacencyOffsets.back() );
+  m_AdjacentEdges.resize( m_AdjacencyOffsets.back() );
+  std::vector< unsigned int > position( m_AdjacencyOffsets.begin(), m_AdjacencyOffsets.end() - 1 );
+  for(unsigned int i=0; i < endpoints.size(); i++)
+  {
+    m_AdjacentVertices[ position[ endpoints[i].first ] ] = endpoints[i].second;
+    m_AdjacentEdges[ position[ endpoints[i].first ]++ ] = i;
+    m_AdjacentVertices[ position[ endpoints[i].second ] ] = endpoints[i].first;
+    m_AdjacentEdges[ position[ endpoints[i].second ]++ ] = i;
+  }
+}
+
 void  mitk::ConnectomicsStatisticsCalculator::CalculateAverageDegree()
 {
   m_AverageDegree = ( ( (double) m_NumberOfEdges * 2.0 ) / (double) m_NumberOfVertices );
@@ -196,33 +204,90 @@ void mitk::ConnectomicsStatisticsCalculator::CalculateRatioOfNodesInLargestCompo
   m_RatioOfNodesInLargestComponent = (double) m_LargestComponentSize / (double) m_NumberOfVertices ;
 }
 
-void mitk::ConnectomicsStatisticsCalculator::CalculateHopPlotValues()
+void mitk::ConnectomicsStatisticsCalculator::CalculateAllPairsShortestPaths()
 {
-  std::vector<int> bins( m_NumberOfVertices );
+  const int numberOfVertices = m_NumberOfVertices;
+  m_NumberOfPairsPerPathLength.assign( m_NumberOfVertices, 0 );
+  m_VectorOfReachableVertices.assign( m_NumberOfVertices, 0 );
+  m_VectorOfEccentrities.assign( m_NumberOfVertices, 0 );
+  m_VectorOfEccentrities90.assign( m_NumberOfVertices, 0 );
+  m_VectorOfAveragePathLengths.assign( m_NumberOfVertices, 0.0 );
+
+#pragma omp parallel
+  {
+    std::vector< int > distances( numberOfVertices, -1 );
+    std::vector< unsigned int > queue( numberOfVertices );
+    std::vector< int > bucket( numberOfVertices + 1, 0 );
+    std::vector< unsigned int > numberOfPairsPerPathLength( numberOfVertices, 0 );
 
-  VertexIteratorType vi, vi_end;
-  unsigned int index( 0 );
+#pragma omp for schedule(dynamic)
+    for( int src = 0; src < numberOfVertices; src++ )
+    {
+      unsigned int head = 0;
+      unsigned int tail = 0;
+      distances[ src ] = 0;
+      queue[ tail++ ] = src;
+      while( head < tail )
+      {
+        unsigned int u = queue[ head++ ];
+        for( unsigned int i = m_AdjacencyOffsets[ u ]; i < m_AdjacencyOffsets[ u + 1 ]; i++ )
+        {
+          unsigned int v = m_AdjacentVertices[ i ];
+          if( distances[ v ] < 0 )
+          {
+            distances[ v ] = distances[ u ] + 1;
+            queue[ tail++ ] = v;
+          }
+        }
+      }
 
-  for( boost::tie( vi, vi_end ) = boost::vertices( *(m_Network->GetBoostGraph()) ); vi != vi_end; ++vi)
-  {
-    std::vector<int> distances(m_NumberOfVertices, 0);
-    int max_distance = 0;
-    VertexDescriptorType src = *vi;
-    distances[src] = 0;
-    unsigned int size = 0;
+      // the vertices are discovered in the order of their distance, so the last one gives the eccentricity.
+      // bucket[h] gives the number of nodes reachable in exactly h hops.
+      const unsigned int size = tail - 1;
+      double sumOfDistances = 0;
+      for( unsigned int i = 1; i < tail; i++ )
+      {
+        int distance = distances[ queue[ i ] ];
+        numberOfPairsPerPathLength[ distance ]++;
+        bucket[ distance ]++;
+        sumOfDistances += distance;
+      }
+      m_VectorOfEccentrities[ src ] = distances[ queue[ tail - 1 ] ];
+      m_VectorOfReachableVertices[ src ] = size;
+      if( size > 0 )
+      {
+        m_VectorOfAveragePathLengths[ src ] = sumOfDistances / size;
+      }
 
-    boost::breadth_first_search(*(m_Network->GetBoostGraph()), src,
-      visitor(all_pairs_shortest_recorder< NetworkType >
-      (&distances[0], max_distance, size)));
+      //Calculate in how many hops we can reach 90 percent of the nodes.
+      int reachable90 = std::ceil( (double)size * 0.9 );
+      int eccentricity90 = 0;
+      while( reachable90 > 0 )
+      {
+        eccentricity90 ++;
+        reachable90 = reachable90 - bucket[ eccentricity90 ];
+      }
+      m_VectorOfEccentrities90[ src ] = eccentricity90;
 
-    for(index=0; index < distances.size(); index++)
-    {
-      if(distances[index] > 0)
+      for( unsigned int i = 0; i < tail; i++ )
       {
-        bins[distances[index]]++;
+        bucket[ distances[ queue[ i ] ] ] = 0;
+        distances[ queue[ i ] ] = -1;
       }
     }
+
+#pragma omp critical
+    for( int i = 0; i < numberOfVertices; i++ )
+    {
+      m_NumberOfPairsPerPathLength[ i ] += numberOfPairsPerPathLength[ i ];
+    }
   }
+}
+
+void mitk::ConnectomicsStatisticsCalculator::CalculateHopPlotValues()
+{
+  std::vector<int> bins( m_NumberOfPairsPerPathLength.begin(), m_NumberOfPairsPerPathLength.end() );
+  unsigned int index( 0 );
 
   bins[0] = m_NumberOfVertices;
   for(index=1; index < bins.size(); index++)
@@ -261,67 +326,71 @@ void mitk::ConnectomicsStatisticsCalculator::CalculateHopPlotValues()
 
 void mitk::ConnectomicsStatisticsCalculator::CalculateClusteringCoefficients()
 {
-  VertexIteratorType vi, vi_end;
-  std::vector<double> m_VectorOfClusteringCoefficientsC;
-  std::vector<double> m_VectorOfClusteringCoefficientsD;
-  std::vector<double> m_VectorOfClusteringCoefficientsE;
-  typedef std::set<VertexDescriptorType> NeighborSetType;
-  typedef NetworkType::out_edge_iterator OutEdgeIterType;
+  const int numberOfVertices = m_NumberOfVertices;
+  m_VectorOfClusteringCoefficientsC.assign( m_NumberOfVertices, 0.0 );
+  m_VectorOfClusteringCoefficientsD.assign( m_NumberOfVertices, 0.0 );
+  std::vector< char > hasClusteringCoefficientE( m_NumberOfVertices, 0 );
 
-  for(boost::tie(vi,vi_end) = boost::vertices( *(m_Network->GetBoostGraph()) ); vi!=vi_end; ++vi)
+#pragma omp parallel
   {
-    // Get the list of vertices which are in the neighborhood of vi.
-    std::pair<AdjacencyIteratorType, AdjacencyIteratorType> adjacent =
-      boost::adjacent_vertices(*vi, *(m_Network->GetBoostGraph()) );
+    // neighborOf[u] == v marks u as neighbor of the current vertex v
+    std::vector< int > neighborOf( numberOfVertices, -1 );
+    std::vector< unsigned int > neighbors;
 
-    //Populate a set with the neighbors of vi
-    NeighborSetType neighbors;
-    for(; adjacent.first!=adjacent.second; ++adjacent.first)
+#pragma omp for schedule(dynamic)
+    for( int v = 0; v < numberOfVertices; v++ )
     {
-      neighbors.insert(*adjacent.first);
-    }
+      neighbors.clear();
+      for( unsigned int i = m_AdjacencyOffsets[ v ]; i < m_AdjacencyOffsets[ v + 1 ]; i++ )
+      {
+        unsigned int u = m_AdjacentVertices[ i ];
+        if( neighborOf[ u ] != v )
+        {
+          neighborOf[ u ] = v;
+          neighbors.push_back( u );
+        }
+      }
 
-    // Now, count the edges between vertices in the neighborhood.
-    unsigned int neighborhood_edge_count = 0;
-    if(neighbors.size() > 0)
-    {
-      NeighborSetType::iterator iter;
-      for(iter = neighbors.begin(); iter != neighbors.end(); ++iter)
+      // Now, count the edges between vertices in the neighborhood.
+      unsigned int neighborhood_edge_count = 0;
+      for( unsigned int n = 0; n < neighbors.size(); n++ )
       {
-        std::pair<OutEdgeIterType, OutEdgeIterType> oe = out_edges(*iter, *(m_Network->GetBoostGraph()) );
-        for(; oe.first != oe.second; ++oe.first)
+        for( unsigned int i = m_AdjacencyOffsets[ neighbors[n] ]; i < m_AdjacencyOffsets[ neighbors[n] + 1 ]; i++ )
         {
-          if(neighbors.find(target(*oe.first, *(m_Network->GetBoostGraph()) )) != neighbors.end())
+          if( neighborOf[ m_AdjacentVertices[ i ] ] == v )
           {
             ++neighborhood_edge_count;
           }
         }
       }
       neighborhood_edge_count /= 2;
-    }
-    //Clustering Coefficienct C,E
-    if(neighbors.size() > 1)
-    {
-      double num   = neighborhood_edge_count;
-      double denum = neighbors.size() * (neighbors.size()-1)/2;
-      m_VectorOfClusteringCoefficientsC.push_back( num / denum);
-      m_VectorOfClusteringCoefficientsE.push_back( num / denum);
-    }
-    else
-    {
-      m_VectorOfClusteringCoefficientsC.push_back(0.0);
-    }
 
-    //Clustering Coefficienct D
-    if(neighbors.size() > 0)
-    {
-      double num   = neighbors.size() + neighborhood_edge_count;
-      double denum = ( (neighbors.size()+1) * neighbors.size()) / 2;
-      m_VectorOfClusteringCoefficientsD.push_back( num / denum);
+      //Clustering Coefficienct C,E
+      if(neighbors.size() > 1)
+      {
+        double num   = neighborhood_edge_count;
+        double denum = neighbors.size() * (neighbors.size()-1)/2;
+        m_VectorOfClusteringCoefficientsC[ v ] = num / denum;
+        hasClusteringCoefficientE[ v ] = 1;
+      }
+
+      //Clustering Coefficienct D
+      if(neighbors.size() > 0)
+      {
+        double num   = neighbors.size() + neighborhood_edge_count;
+        double denum = ( (neighbors.size()+1) * neighbors.size()) / 2;
+        m_VectorOfClusteringCoefficientsD[ v ] = num / denum;
+      }
     }
-    else
+  }
+
+  // E does not count vertices with less than two neighbors
+  m_VectorOfClusteringCoefficientsE.clear();
+  for(unsigned int v=0; v < m_NumberOfVertices; v++)
+  {
+    if( hasClusteringCoefficientE[ v ] )
     {
-      m_VectorOfClusteringCoefficientsD.push_back(0.0);
+      m_VectorOfClusteringCoefficientsE.push_back( m_VectorOfClusteringCoefficientsC[ v ] );
     }
   }
 
@@ -358,18 +427,104 @@ void mitk::ConnectomicsStatisticsCalculator::CalculateBetweennessCentrality()
   }
 
   // Define EdgeCentralityMap
-  m_VectorOfEdgeBetweennessCentralities.resize( m_NumberOfEdges, 0.0);
+  m_VectorOfEdgeBetweennessCentralities.assign( m_NumberOfEdges, 0.0);
   // Create the external property map
   m_PropertyMapOfEdgeBetweennessCentralities = EdgeIteratorPropertyMapType(m_VectorOfEdgeBetweennessCentralities.begin(), edgeIndex);
 
   // Define VertexCentralityMap
   VertexIndexMapType vertexIndex = get(boost::vertex_index, *(m_Network->GetBoostGraph()) );
-  m_VectorOfVertexBetweennessCentralities.resize( m_NumberOfVertices, 0.0);
+  m_VectorOfVertexBetweennessCentralities.assign( m_NumberOfVertices, 0.0);
   // Create the external property map
   m_PropertyMapOfVertexBetweennessCentralities = VertexIteratorPropertyMapType(m_VectorOfVertexBetweennessCentralities.begin(), vertexIndex);
 
-  boost::brandes_betweenness_centrality( *(m_Network->GetBoostGraph()),
-    m_PropertyMapOfVertexBetweennessCentralities, m_PropertyMapOfEdgeBetweennessCentralities );
+  const int numberOfVertices = m_NumberOfVertices;
+
+#pragma omp parallel
+  {
+    std::vector< int > distances( numberOfVertices, -1 );
+    std::vector< double > pathCounts( numberOfVertices, 0.0 );
+    std::vector< double > dependencies( numberOfVertices, 0.0 );
+    std::vector< unsigned int > order( numberOfVertices );
+    std::vector< double > vertexCentralities( numberOfVertices, 0.0 );
+    std::vector< double > edgeCentralities( m_NumberOfEdges, 0.0 );
+
+#pragma omp for schedule(dynamic)
+    for( int src = 0; src < numberOfVertices; src++ )
+    {
+      // breadth first search counting the shortest paths from the source
+      unsigned int head = 0;
+      unsigned int tail = 0;
+      distances[ src ] = 0;
+      pathCounts[ src ] = 1;
+      order[ tail++ ] = src;
+      while( head < tail )
+      {
+        unsigned int u = order[ head++ ];
+        for( unsigned int i = m_AdjacencyOffsets[ u ]; i < m_AdjacencyOffsets[ u + 1 ]; i++ )
+        {
+          unsigned int v = m_AdjacentVertices[ i ];
+          if( distances[ v ] < 0 )
+          {
+            distances[ v ] = distances[ u ] + 1;
+            order[ tail++ ] = v;
+          }
+          if( distances[ v ] == distances[ u ] + 1 )
+          {
+            pathCounts[ v ] += pathCounts[ u ];
+          }
+        }
+      }
+
+      // accumulate the dependencies in the order of decreasing distance
+      for( unsigned int k = tail; k-- > 0; )
+      {
+        unsigned int w = order[ k ];
+        for( unsigned int i = m_AdjacencyOffsets[ w ]; i < m_AdjacencyOffsets[ w + 1 ]; i++ )
+        {
+          unsigned int v = m_AdjacentVertices[ i ];
+          if( distances[ v ] == distances[ w ] - 1 )
+          {
+            double dependency = pathCounts[ v ] / pathCounts[ w ] * ( 1.0 + dependencies[ w ] );
+            edgeCentralities[ m_AdjacentEdges[ i ] ] += dependency;
+            dependencies[ v ] += dependency;
+          }
+        }
+        if( w != (unsigned int) src )
+        {
+          vertexCentralities[ w ] += dependencies[ w ];
+        }
+      }
+
+      for( unsigned int k = 0; k < tail; k++ )
+      {
+        distances[ order[ k ] ] = -1;
+        pathCounts[ order[ k ] ] = 0.0;
+        dependencies[ order[ k ] ] = 0.0;
+      }
+    }
+
+#pragma omp critical
+    {
+      for( int i = 0; i < numberOfVertices; i++ )
+      {
+        m_VectorOfVertexBetweennessCentralities[ i ] += vertexCentralities[ i ];
+      }
+      for( unsigned int i = 0; i < m_NumberOfEdges; i++ )
+      {
+        m_VectorOfEdgeBetweennessCentralities[ i ] += edgeCentralities[ i ];
+      }
+    }
+  }
+
+  // the network is undirected, every path has been counted from both of its ends
+  for( unsigned int i = 0; i < m_NumberOfVertices; i++ )
+  {
+    m_VectorOfVertexBetweennessCentralities[ i ] /= 2.0;
+  }
+  for( unsigned int i = 0; i < m_NumberOfEdges; i++ )
+  {
+    m_VectorOfEdgeBetweennessCentralities[ i ] /= 2.0;
+  }
 
   m_AverageVertexBetweennessCentrality = std::accumulate(m_VectorOfVertexBetweennessCentralities.begin(),
     m_VectorOfVertexBetweennessCentralities.end(),
@@ -405,9 +560,9 @@ void mitk::ConnectomicsStatisticsCalculator::CalculateIsolatedAndEndPoints()
 
 
 /**
-* Calculates Shortest Path Related metrics of the graph.  The
-* function runs a BFS from each node to find out the shortest
-* distances to other nodes in the graph. The maximum of this distance
+* Calculates Shortest Path Related metrics of the graph from the
+* BFS run from each node by CalculateAllPairsShortestPaths, which
+* gives the shortest distances to other nodes in the graph. The maximum of this distance
 * is called the eccentricity of that node. The maximum eccentricity
 * in the graph is called diameter and the minimum eccentricity is
 * called the radius of the graph.  Central points are those nodes
@@ -418,11 +573,6 @@ void mitk::ConnectomicsStatisticsCalculator::CalculateShortestPathMetrics()
   //for all vertices:
   VertexIteratorType vi, vi_end;
 
-  //store the eccentricities in a vector.
-  m_VectorOfEccentrities.resize( m_NumberOfVertices );
-  m_VectorOfEccentrities90.resize( m_NumberOfVertices );
-  m_VectorOfAveragePathLengths.resize( m_NumberOfVertices );
-
   //assign diameter and radius while iterating over the ecccencirities.
   m_Diameter              = 0;
   m_Diameter90            = 0;
@@ -436,27 +586,11 @@ void mitk::ConnectomicsStatisticsCalculator::CalculateShortestPathMetrics()
   unsigned int giant_component_size = 0;
   VertexDescriptorType radius_src(0);
 
-  //Loop over the vertices
+  //Loop over the vertices, the BFS from each of them has been run
+  //by CalculateAllPairsShortestPaths.
   for( boost::tie(vi, vi_end) = boost::vertices( *(m_Network->GetBoostGraph()) ); vi!=vi_end; ++vi)
   {
-    //We are going to start a BFS, initialize the neccessary
-    //structures for that.  Store the distances of nodes from the
-    //source in distance vector. The maximum distance is stored in
-    //max. The BFS will start from the node that vi is pointing, that
-    //is the src is *vi. We also init the distance of the src node to
-    //itself to 0. size gives the number of nodes discovered during
-    //this BFS.
-    std::vector<int> distances( m_NumberOfVertices );
-    int max_distance = 0;
     VertexDescriptorType src = *vi;
-    distances[src] = 0;
-    unsigned int size = 0;
-
-    breadth_first_search(*(m_Network->GetBoostGraph()), src,
-      visitor(all_pairs_shortest_recorder<NetworkType>
-      (&distances[0], max_distance, size)));
-    // vertex vi has eccentricity equal to max_distance
-    m_VectorOfEccentrities[src] = max_distance;
 
     //check whether there is any change in the diameter or the radius.
     //note that the diameter we are calculating here is also the
@@ -473,44 +607,12 @@ void mitk::ConnectomicsStatisticsCalculator::CalculateShortestPathMetrics()
     //found we should loop over this connected component and find the
     //minimum eccentricity which is the radius. So we keep the src
     //node, so that we can find the connected component later on.
-    if(size > giant_component_size)
+    if(m_VectorOfReachableVertices[src] > giant_component_size)
     {
-      giant_component_size = size;
+      giant_component_size = m_VectorOfReachableVertices[src];
       radius_src = src;
     }
 
-    //Calculate in how many hops we can reach 90 percent of the
-    //nodes. We store the number of hops we can reach in h hops in the
-    //bucket vector. That is bucket[h] gives the number of nodes
-    //reachable in exactly h hops. sum of bucket[i<h] gives the number
-    //of nodes that are reachable in less than h hops. We also
-    //calculate sum of the distances from this node to every single
-    //other node in the graph.
-    int reachable90 = std::ceil((double)size * 0.9);
-    std::vector <int> bucket (max_distance+1);
-    int counter = 0;
-    for(unsigned int i=0; i<distances.size(); i++)
-    {
-      if(distances[i]>0)
-      {
-        bucket[distances[i]]++;
-        m_VectorOfAveragePathLengths[src] += distances[i];
-        counter ++;
-      }
-    }
-    if(counter > 0)
-    {
-      m_VectorOfAveragePathLengths[src] = m_VectorOfAveragePathLengths[src] / counter;
-    }
-
-    int eccentricity90 = 0;
-    while(reachable90 > 0)
-    {
-      eccentricity90 ++;
-      reachable90 = reachable90 - bucket[eccentricity90];
-    }
-    // vertex vi has eccentricity90 equal to eccentricity90
-    m_VectorOfEccentrities90[src] = eccentricity90;
     if(m_VectorOfEccentrities90[src] > m_Diameter90)
     {
       m_Diameter90 = m_VectorOfEccentrities90[src];
@@ -521,13 +623,11 @@ void mitk::ConnectomicsStatisticsCalculator::CalculateShortestPathMetrics()
   //that when we start a BFS gives the giant connected component, and
   //we have the eccentricities calculated. Iterate over the nodes of
   //this giant component and find the minimum eccentricity.
-  std::vector<int> component( m_NumberOfVertices );
-  boost::connected_components( *(m_Network->GetBoostGraph()), &component[0]);
-  for (unsigned int i=0; i<component.size(); i++)
+  for (unsigned int i=0; i<m_Components.size(); i++)
   {
     //If we are in the same component and the radius is not the
     //minimum so far store the eccentricity as the radius.
-    if( component[i] == component[radius_src])
+    if( m_Components[i] == m_Components[radius_src])
     {
       if(m_Radius > m_VectorOfEccentrities[i])
       {
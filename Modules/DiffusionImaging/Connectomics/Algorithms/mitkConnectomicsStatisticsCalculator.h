@@ -127,6 +127,21 @@ namespace mitk
 
     void CalculateNumberOfEdges();
 
+    /**
+    * \brief Builds compressed adjacency lists of the network, which are shared by the graph traversals.
+    *
+    * Edges are indexed in the order of boost::edges, like the edge betweenness centralities.
+    */
+    void BuildAdjacencyLists();
+
+    /**
+    * \brief Runs a breadth first search from each vertex in parallel.
+    *
+    * Collects the number of vertex pairs per path length for the hop plot and the eccentricities, path lengths and
+    * component sizes for the shortest path metrics, so the searches are run only once per update.
+    */
+    void CalculateAllPairsShortestPaths();
+
     void CalculateAverageDegree();
 
     void CalculateConnectionDensity();
@@ -153,6 +168,7 @@ namespace mitk
     */
     void CalculateClusteringCoefficients();
 
+    /** \brief Brandes' algorithm with one breadth first search per source vertex, the sources are processed in parallel */
     void CalculateBetweennessCentrality();
 
     void CalculateIsolatedAndEndPoints();
@@ -178,6 +194,16 @@ namespace mitk
     // The connectomics network, which is used for statistics calculation
     mitk::ConnectomicsNetwork::Pointer m_Network;
 
+    // Compressed adjacency lists, the neighbors of vertex v and the indices of the connecting edges
+    // are stored from m_AdjacencyOffsets[v] to m_AdjacencyOffsets[v+1]-1. As in boost, self loops are listed twice.
+    std::vector< unsigned int > m_AdjacencyOffsets;
+    std::vector< unsigned int > m_AdjacentVertices;
+    std::vector< unsigned int > m_AdjacentEdges;
+
+    // Results of the all pairs breadth first search
+    std::vector< unsigned int > m_NumberOfPairsPerPathLength;
+    std::vector< unsigned int > m_VectorOfReachableVertices;
+
     // Statistics
     unsigned int m_NumberOfVertices;
     unsigned int m_NumberOfEdges;
@@ -2,6 +2,7 @@ set(MODULE_TESTS
   mitkConnectomicsNetworkTest.cpp
   mitkConnectomicsNetworkCreationTest.cpp
   mitkConnectomicsStatisticsCalculatorTest.cpp
+  mitkConnectomicsNetworkThresholderTest.cpp
   mitkCorrelationCalculatorTest.cpp
 )
 
@@ -0,0 +1,204 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+// Testing
+#include "mitkTestingMacros.h"
+#include "mitkTestFixture.h"
+
+// std includes
+#include <string>
+#include <vector>
+
+// MITK includes
+#include <mitkIOUtil.h>
+#include <mitkConnectomicsNetworkThresholder.h>
+
+// VTK includes
+#include <vtkDebugLeaks.h>
+
+
+class mitkConnectomicsNetworkThresholderTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkConnectomicsNetworkThresholderTestSuite);
+
+  /// \todo Fix VTK memory leaks. Bug 18097.
+  vtkDebugLeaks::SetExitError(0);
+
+  MITK_TEST(ThresholdSweep_EqualsSingleThresholding);
+  MITK_TEST(DensitySweep_EqualsSingleThresholding);
+  MITK_TEST(ThresholdSweep_EqualsBaselineReference);
+  MITK_TEST(DensitySweep_EqualsBaselineReference);
+  MITK_TEST(RandomRemovalSweep_EqualsBaselineReference);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  mitk::ConnectomicsNetwork::Pointer m_Network;
+  mitk::ConnectomicsNetwork::Pointer m_SyntheticNetwork;
+  std::string m_NetworkPath;
+
+  /**
+  * Six vertices, ten of the fifteen possible edges, with the weights 1, 1, 2, 2, 3, 3, 4, 5, 6, 7.
+  * The reference values of the tests below are those of the thresholder before the sweep was introduced,
+  * which removed one edge (random removal) or thresholded at 1, 2, 3, ... (density) until the density
+  * was not above the target, and removed all edges with a weight below the target threshold.
+  */
+  static mitk::ConnectomicsNetwork::Pointer CreateSyntheticNetwork()
+  {
+    mitk::ConnectomicsNetwork::Pointer network = mitk::ConnectomicsNetwork::New();
+    std::vector< mitk::ConnectomicsNetwork::VertexDescriptorType > vertices;
+    for( int id( 0 ); id < 6; id++ )
+    {
+      vertices.push_back( network->AddVertex( id ) );
+    }
+
+    const int edges[ 10 ][ 3 ] = { { 0, 1, 1 }, { 1, 2, 1 }, { 2, 3, 2 }, { 3, 4, 2 }, { 4, 5, 3 },
+                                   { 0, 5, 3 }, { 0, 2, 4 }, { 1, 3, 5 }, { 2, 4, 6 }, { 3, 5, 7 } };
+    for( int loop( 0 ); loop < 10; loop++ )
+    {
+      network->AddEdge( vertices[ edges[ loop ][ 0 ] ], vertices[ edges[ loop ][ 1 ] ], edges[ loop ][ 0 ], edges[ loop ][ 1 ], edges[ loop ][ 2 ] );
+    }
+    network->UpdateIDs();
+    return network;
+  }
+
+  void CheckReference( mitk::ConnectomicsNetworkThresholder::ThresholdingSchemes scheme, const std::vector< double >& targets,
+                       const std::vector< int >& referenceEdges )
+  {
+    mitk::ConnectomicsNetworkThresholder::Pointer thresholder = mitk::ConnectomicsNetworkThresholder::New();
+    thresholder->SetNetwork( m_SyntheticNetwork );
+    thresholder->SetThresholdingScheme( scheme );
+    std::vector< mitk::ConnectomicsNetwork::Pointer > sweep = thresholder->GetThresholdedNetworks( targets );
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE( "One network per target", targets.size(), sweep.size() );
+    for( unsigned int loop( 0 ); loop < targets.size(); loop++ )
+    {
+      CPPUNIT_ASSERT_EQUAL_MESSAGE( "Number of vertices", 6, sweep[ loop ]->GetNumberOfVertices() );
+      CPPUNIT_ASSERT_EQUAL_MESSAGE( "Number of edges equals the baseline", referenceEdges[ loop ], sweep[ loop ]->GetNumberOfEdges() );
+    }
+  }
+
+  void CheckSweep( mitk::ConnectomicsNetworkThresholder::ThresholdingSchemes scheme, const std::vector< double >& targets )
+  {
+    mitk::ConnectomicsNetworkThresholder::Pointer thresholder = mitk::ConnectomicsNetworkThresholder::New();
+    thresholder->SetNetwork( m_Network );
+    thresholder->SetThresholdingScheme( scheme );
+    std::vector< mitk::ConnectomicsNetwork::Pointer > sweep = thresholder->GetThresholdedNetworks( targets );
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE( "One network per target", targets.size(), sweep.size() );
+    for( unsigned int loop( 0 ); loop < targets.size(); loop++ )
+    {
+      thresholder->SetTargetThreshold( targets[ loop ] );
+      thresholder->SetTargetDensity( targets[ loop ] );
+      mitk::ConnectomicsNetwork::Pointer single = thresholder->GetThresholdedNetwork();
+
+      CPPUNIT_ASSERT_EQUAL_MESSAGE( "Number of vertices", single->GetNumberOfVertices(), sweep[ loop ]->GetNumberOfVertices() );
+      CPPUNIT_ASSERT_EQUAL_MESSAGE( "Number of edges", single->GetNumberOfEdges(), sweep[ loop ]->GetNumberOfEdges() );
+
+      // random removal may pick other edges of equal weight
+      if( scheme != mitk::ConnectomicsNetworkThresholder::RandomRemovalOfWeakest )
+      {
+        CPPUNIT_ASSERT_MESSAGE( "Degrees of nodes", single->GetDegreeOfNodes() == sweep[ loop ]->GetDegreeOfNodes() );
+      }
+    }
+  }
+
+public:
+
+  void setUp() override
+  {
+    m_NetworkPath = GetTestDataFilePath("DiffusionImaging/Connectomics/reference.cnf");
+
+    std::vector<mitk::BaseData::Pointer> networkFile = mitk::IOUtil::Load( m_NetworkPath );
+    if( networkFile.empty() )
+    {
+      std::string errorMessage = "File at " + m_NetworkPath + " could not be read. Aborting.";
+      CPPUNIT_ASSERT_MESSAGE( errorMessage, !networkFile.empty() );
+      return;
+    }
+    mitk::ConnectomicsNetwork* network = dynamic_cast<mitk::ConnectomicsNetwork*>( networkFile.at(0).GetPointer() );
+
+    if( !network )
+    {
+      std::string errorMessage = "Read file at " + m_NetworkPath + " could not be recognized as network. Aborting.";
+      CPPUNIT_ASSERT_MESSAGE( errorMessage, network);
+      return;
+    }
+
+    m_Network = network;
+    m_SyntheticNetwork = CreateSyntheticNetwork();
+  }
+
+  void tearDown() override
+  {
+    m_Network = nullptr;
+    m_SyntheticNetwork = nullptr;
+    m_NetworkPath = "";
+  }
+
+  void ThresholdSweep_EqualsSingleThresholding()
+  {
+    // unsorted on purpose, the networks are returned in the order of the targets
+    std::vector< double > targets = { 3, 0, 1, 5, 2, 10, 4 };
+    CheckSweep( mitk::ConnectomicsNetworkThresholder::ThresholdBased, targets );
+  }
+
+  void DensitySweep_EqualsSingleThresholding()
+  {
+    std::vector< double > targets = { 0.5, 1.0, 0.0, 0.8, 0.2 };
+    CheckSweep( mitk::ConnectomicsNetworkThresholder::LargestLowerThanDensity, targets );
+    CheckSweep( mitk::ConnectomicsNetworkThresholder::RandomRemovalOfWeakest, targets );
+  }
+
+  void ThresholdSweep_EqualsBaselineReference()
+  {
+    std::vector< double > targets = { 3, 0, 1, 5, 2, 10, 4 };
+    std::vector< int > referenceEdges = { 6, 10, 10, 3, 8, 0, 4 };
+    CheckReference( mitk::ConnectomicsNetworkThresholder::ThresholdBased, targets, referenceEdges );
+
+    mitk::ConnectomicsNetworkThresholder::Pointer thresholder = mitk::ConnectomicsNetworkThresholder::New();
+    thresholder->SetNetwork( m_SyntheticNetwork );
+    thresholder->SetThresholdingScheme( mitk::ConnectomicsNetworkThresholder::ThresholdBased );
+    std::vector< mitk::ConnectomicsNetwork::Pointer > sweep = thresholder->GetThresholdedNetworks( { 3 } );
+    std::vector< int > referenceDegrees = { 2, 1, 2, 2, 2, 3 };
+    CPPUNIT_ASSERT_MESSAGE( "Degrees of nodes equal the baseline", referenceDegrees == sweep[ 0 ]->GetDegreeOfNodes() );
+  }
+
+  void DensitySweep_EqualsBaselineReference()
+  {
+    // densities of the synthetic network are edges / 15
+    std::vector< double > targets = { 0.5, 1.0, 0.0, 0.8, 0.25 };
+    std::vector< int > referenceEdges = { 6, 10, 0, 10, 3 };
+    CheckReference( mitk::ConnectomicsNetworkThresholder::LargestLowerThanDensity, targets, referenceEdges );
+  }
+
+  void RandomRemovalSweep_EqualsBaselineReference()
+  {
+    std::vector< double > targets = { 0.5, 1.0, 0.0, 0.8, 0.25 };
+    std::vector< int > referenceEdges = { 7, 10, 0, 10, 3 };
+    CheckReference( mitk::ConnectomicsNetworkThresholder::RandomRemovalOfWeakest, targets, referenceEdges );
+
+    // the three remaining edges are the unique heaviest ones, independent of the random choice
+    mitk::ConnectomicsNetworkThresholder::Pointer thresholder = mitk::ConnectomicsNetworkThresholder::New();
+    thresholder->SetNetwork( m_SyntheticNetwork );
+    thresholder->SetThresholdingScheme( mitk::ConnectomicsNetworkThresholder::RandomRemovalOfWeakest );
+    std::vector< mitk::ConnectomicsNetwork::Pointer > sweep = thresholder->GetThresholdedNetworks( { 0.25 } );
+    std::vector< int > referenceDegrees = { 0, 1, 1, 2, 1, 1 };
+    CPPUNIT_ASSERT_MESSAGE( "Degrees of nodes equal the baseline", referenceDegrees == sweep[ 0 ]->GetDegreeOfNodes() );
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkConnectomicsNetworkThresholder)
@@ -1,6 +1,7 @@
 set(MODULE_TESTS
   mitkNonLocalMeansDenoisingTest.cpp
   mitkDiffusionPropertySerializerTest.cpp
+  mitkVoxelBlockFitterTest.cpp
 )
 
 set(MODULE_CUSTOM_TESTS
@@ -21,6 +21,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkGradientDirectionsProperty.h"
 #include "mitkITKImageImport.h"
 #include <mitkImageCast.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <cstdlib>
 
 class mitkNonLocalMeansDenoisingTestSuite : public mitk::TestFixture
 {
@@ -30,6 +33,8 @@ class mitkNonLocalMeansDenoisingTestSuite : public mitk::TestFixture
   MITK_TEST(Denoise_NLMr_shouldReturnTrue);
   MITK_TEST(Denoise_NLMv_shouldReturnTrue);
   MITK_TEST(Denoise_NLMvr_shouldReturnTrue);
+  MITK_TEST(Denoise_FastPatchDistances_EqualsVoxelwise);
+  MITK_TEST(Denoise_FastPatchDistancesJointRician_EqualsReference);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -142,6 +147,115 @@ public:
     MITK_ASSERT_EQUAL( m_DenoisedImage, m_ReferenceImage, "NLMv should always return the same result.");
   }
 
+  // compares the box summed patch distances with the voxelwise computation, the results differ by rounding only
+  void CompareFastPatchDistances(bool rician, bool joint)
+  {
+    m_DenoisingFilter->SetUseRicianAdaption(rician);
+    m_DenoisingFilter->SetUseJointInformation(joint);
+    m_DenoisingFilter->SetUseFastPatchDistances(false);
+    m_DenoisingFilter->Update();
+    VectorImagetType::Pointer reference = m_DenoisingFilter->GetOutput();
+    reference->DisconnectPipeline();
+
+    m_DenoisingFilter->SetUseFastPatchDistances(true);
+    m_DenoisingFilter->SetNumberOfThreads(4);
+    m_DenoisingFilter->Update();
+
+    itk::ImageRegionConstIterator<VectorImagetType> rit(reference, reference->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<VectorImagetType> fit(m_DenoisingFilter->GetOutput(), reference->GetLargestPossibleRegion());
+    for (; !rit.IsAtEnd(); ++rit, ++fit)
+      for (unsigned int i=0; i<rit.Get().GetSize(); ++i)
+        CPPUNIT_ASSERT_MESSAGE("Fast patch distances equal the voxelwise computation", std::abs(rit.Get()[i] - fit.Get()[i]) <= 1);
+  }
+
+  void Denoise_FastPatchDistances_EqualsVoxelwise()
+  {
+    CompareFastPatchDistances(false, false);
+    CompareFastPatchDistances(true, false);
+    CompareFastPatchDistances(false, true);
+  }
+
+  /**
+   * Joint Rician non-local means computed straightforwardly: the weights of the joint patch distances average the
+   * squared values of the search neighbors. The voxelwise filter differs in this mode (see SetUseFastPatchDistances).
+   */
+  static VectorImagetType::Pointer JointRicianReference(VectorImagetType* input, double variance, int searchRadius, int comparisonRadius)
+  {
+    VectorImagetType::Pointer output = VectorImagetType::New();
+    output->CopyInformation(input);
+    output->SetRegions(input->GetLargestPossibleRegion());
+    output->SetVectorLength(input->GetVectorLength());
+    output->Allocate();
+
+    const VectorImagetType::RegionType region = input->GetLargestPossibleRegion();
+    const unsigned int numChannels = input->GetVectorLength();
+    itk::ImageRegionIteratorWithIndex<VectorImagetType> oit(output, region);
+    for (; !oit.IsAtEnd(); ++oit)
+    {
+      const VectorImagetType::IndexType index = oit.GetIndex();
+      double Z = 0;
+      std::vector<double> sums(numChannels, 0.0);
+      VectorImagetType::IndexType indexJ;
+      for (indexJ[0] = index[0] - searchRadius; indexJ[0] <= index[0] + searchRadius; ++indexJ[0])
+        for (indexJ[1] = index[1] - searchRadius; indexJ[1] <= index[1] + searchRadius; ++indexJ[1])
+          for (indexJ[2] = index[2] - searchRadius; indexJ[2] <= index[2] + searchRadius; ++indexJ[2])
+          {
+            if (!region.IsInside(indexJ))
+              continue;
+
+            double sumk = 0;
+            double size = 0;
+            VectorImagetType::OffsetType offset;
+            for (offset[0] = -comparisonRadius; offset[0] <= comparisonRadius; ++offset[0])
+              for (offset[1] = -comparisonRadius; offset[1] <= comparisonRadius; ++offset[1])
+                for (offset[2] = -comparisonRadius; offset[2] <= comparisonRadius; ++offset[2])
+                {
+                  if (!region.IsInside(index + offset) || !region.IsInside(indexJ + offset))
+                    continue;
+                  for (unsigned int c = 0; c < numChannels; ++c)
+                  {
+                    const double diff = (double)input->GetPixel(index + offset)[c] - (double)input->GetPixel(indexJ + offset)[c];
+                    sumk += diff * diff;
+                  }
+                  ++size;
+                }
+
+            const double w = std::exp(-(sumk / (size * (numChannels + 1))) / variance);
+            Z += w;
+            for (unsigned int c = 0; c < numChannels; ++c)
+            {
+              const double p = input->GetPixel(indexJ)[c];
+              sums[c] += w * p * p;
+            }
+          }
+
+      VectorImagetType::PixelType outpix(numChannels);
+      for (unsigned int c = 0; c < numChannels; ++c)
+        outpix[c] = (short)std::floor(std::sqrt(std::max(0.0, sums[c] / Z - 2 * variance)) + 0.5);
+      oit.Set(outpix);
+    }
+    return output;
+  }
+
+  void Denoise_FastPatchDistancesJointRician_EqualsReference()
+  {
+    VectorImagetType::Pointer vectorImage;
+    mitk::CastToItkImage(m_Image, vectorImage);
+    VectorImagetType::Pointer reference = JointRicianReference(vectorImage, 500, 1, 1);
+
+    m_DenoisingFilter->SetUseRicianAdaption(true);
+    m_DenoisingFilter->SetUseJointInformation(true);
+    m_DenoisingFilter->SetUseFastPatchDistances(true);
+    m_DenoisingFilter->SetNumberOfThreads(4);
+    m_DenoisingFilter->Update();
+
+    itk::ImageRegionConstIterator<VectorImagetType> rit(reference, reference->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<VectorImagetType> fit(m_DenoisingFilter->GetOutput(), reference->GetLargestPossibleRegion());
+    for (; !rit.IsAtEnd(); ++rit, ++fit)
+      for (unsigned int i=0; i<rit.Get().GetSize(); ++i)
+        CPPUNIT_ASSERT_MESSAGE("Fast joint Rician patch distances equal the reference", std::abs(rit.Get()[i] - fit.Get()[i]) <= 1);
+  }
+
   void Denoise_NLMvr_shouldReturnTrue()
   {
     std::string referenceImagePath = GetTestDataFilePath("DiffusionImaging/Denoising/test_multi_NLMvr.dwi");
@@ -0,0 +1,103 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include "mitkTestFixture.h"
+
+#include <itkVoxelBlockFitter.h>
+#include <itkTimeProbe.h>
+#include <random>
+
+class mitkVoxelBlockFitterTestSuite : public mitk::TestFixture
+{
+
+  CPPUNIT_TEST_SUITE(mitkVoxelBlockFitterTestSuite);
+  MITK_TEST(Fit_Blocks_EqualsPerVoxelFit);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  /** Members used inside the different (sub-)tests. All members are initialized via setUp().*/
+  vnl_matrix<double> m_FitMatrix;     // like the reconstruction matrix of a sh-order 6 q-ball fit with 64 gradients
+  vnl_matrix<double> m_Signals;       // one row per voxel
+
+public:
+
+  void setUp() override
+  {
+    std::mt19937 randGen(1);
+    std::uniform_real_distribution<double> value(-1, 1);
+
+    m_FitMatrix.set_size(28, 64);
+    for (unsigned int r=0; r<m_FitMatrix.rows(); r++)
+      for (unsigned int c=0; c<m_FitMatrix.cols(); c++)
+        m_FitMatrix(r,c) = value(randGen);
+
+    m_Signals.set_size(20000, 64);
+    for (unsigned int r=0; r<m_Signals.rows(); r++)
+      for (unsigned int c=0; c<m_Signals.cols(); c++)
+        m_Signals(r,c) = value(randGen);
+  }
+
+  void tearDown() override
+  {
+    m_FitMatrix.clear();
+    m_Signals.clear();
+  }
+
+  void Fit_Blocks_EqualsPerVoxelFit()
+  {
+    itk::TimeProbe voxelClock;
+    voxelClock.Start();
+    vnl_matrix<double> reference(m_Signals.rows(), m_FitMatrix.rows());
+    for (unsigned int v=0; v<m_Signals.rows(); v++)
+      reference.set_row(v, m_FitMatrix*m_Signals.get_row(v));
+    voxelClock.Stop();
+
+    // the number of voxels is no multiple of the block size, so the last block is partially filled
+    itk::TimeProbe blockClock;
+    blockClock.Start();
+    itk::VoxelBlockFitter<double> fitter(m_FitMatrix, 256);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Number of inputs", m_FitMatrix.cols(), fitter.GetNumberOfInputs());
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Number of outputs", m_FitMatrix.rows(), fitter.GetNumberOfOutputs());
+
+    vnl_matrix<double> result(m_Signals.rows(), m_FitMatrix.rows());
+    unsigned int first = 0;
+    for (unsigned int v=0; v<m_Signals.rows(); v++)
+    {
+      std::copy(m_Signals[v], m_Signals[v]+m_Signals.cols(), fitter.AddVoxel());
+      if (fitter.IsFull() || v+1==m_Signals.rows())
+      {
+        fitter.Fit();
+        for (unsigned int i=0; i<fitter.GetNumberOfVoxels(); i++)
+          std::copy(fitter.GetResult(i), fitter.GetResult(i)+m_FitMatrix.rows(), result[first+i]);
+        first += fitter.GetNumberOfVoxels();
+        fitter.Clear();
+      }
+    }
+    blockClock.Stop();
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("All voxels are fitted", m_Signals.rows(), first);
+    for (unsigned int v=0; v<m_Signals.rows(); v++)
+      for (unsigned int o=0; o<m_FitMatrix.rows(); o++)
+        CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Blockwise fit equals per-voxel fit", reference(v,o), result(v,o), 1e-10);
+
+    MITK_INFO << "Fit of " << m_Signals.rows() << " voxels: " << voxelClock.GetTotal() << "s voxelwise, " << blockClock.GetTotal() << "s blockwise";
+  }
+
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkVoxelBlockFitter)
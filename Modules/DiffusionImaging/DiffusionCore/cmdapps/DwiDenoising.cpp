@@ -53,6 +53,7 @@ int main(int argc, char* argv[])
   parser.addArgument("compare", "c", mitkCommandLineParser::Int, "Comparison radius:", "comparison radius", us::Any(), true);
   parser.addArgument("joint", "j", mitkCommandLineParser::Bool, "Joint information:", "use joint information");
   parser.addArgument("rician", "r", mitkCommandLineParser::Bool, "Rician adaption:", "use rician adaption");
+  parser.addArgument("fast", "f", mitkCommandLineParser::Bool, "Fast patch distances:", "compute the patch distances with box sums (faster, results differ by rounding)");
 
   parser.changeParameterGroup("Output", "Output of this miniapp");
 
@@ -81,6 +82,9 @@ int main(int argc, char* argv[])
   bool rician = false;
   if (parsedArgs.count("rician"))
     rician = true;
+  bool fast = false;
+  if (parsedArgs.count("fast"))
+    fast = true;
 
   try
   {
@@ -104,6 +108,7 @@ int main(int argc, char* argv[])
 
       filter->SetUseJointInformation(joint);
       filter->SetUseRicianAdaption(rician);
+      filter->SetUseFastPatchDistances(fast);
       filter->SetSearchRadius(search);
       filter->SetComparisonRadius(compare);
       filter->SetVariance(variance);
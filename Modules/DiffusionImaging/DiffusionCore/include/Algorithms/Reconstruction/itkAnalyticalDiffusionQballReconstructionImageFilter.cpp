@@ -22,6 +22,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkImageRegionIterator.h>
 #include <itkArray.h>
 #include <vnl/vnl_vector.h>
+#include <vnl/vnl_vector_ref.h>
 
 #include <boost/version.hpp>
 #include <stdio.h>
@@ -34,6 +35,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <boost/math/special_functions.hpp>
 
 #include "itkPointShell.h"
+#include "itkVoxelBlockFitter.h"
 
 using namespace boost::math;
 
@@ -149,11 +151,11 @@ template<
         class TOdfPixelType,
         int NOrderL,
         int NrOdfDirections>
-vnl_vector<TOdfPixelType>
+void
 itk::AnalyticalDiffusionQballReconstructionImageFilter
 <TReferenceImagePixelType, TGradientImagePixelType, TOdfPixelType,
 NOrderL, NrOdfDirections>
-::PreNormalize( vnl_vector<TOdfPixelType> vec,
+::PreNormalize( vnl_vector<TOdfPixelType>& vec,
                 typename NumericTraits<ReferencePixelType>::AccumulateType b0 )
 {
     switch( m_NormalizationMethod )
@@ -166,7 +168,6 @@ NOrderL, NrOdfDirections>
         {
             vec[i] = vec[i]/b0f;
         }
-        return vec;
         break;
     }
     case QBAR_B_ZERO_B_VALUE:
@@ -179,17 +180,14 @@ NOrderL, NrOdfDirections>
 
             vec[i] = log(vec[i]);
         }
-        return vec;
         break;
     }
     case QBAR_B_ZERO:
     {
-        return vec;
         break;
     }
     case QBAR_NONE:
     {
-        return vec;
         break;
     }
     case QBAR_ADC_ONLY:
@@ -202,12 +200,10 @@ NOrderL, NrOdfDirections>
 
             vec[i] = log(vec[i]);
         }
-        return vec;
         break;
     }
     case QBAR_RAW_SIGNAL:
     {
-        return vec;
         break;
     }
     case QBAR_SOLID_ANGLE:
@@ -230,12 +226,9 @@ NOrderL, NrOdfDirections>
 
             vec[i] = log(-log(vec[i]));
         }
-        return vec;
         break;
     }
     }
-
-    return vec;
 }
 
 template< class T, class TG, class TO, int L, int NODF>
@@ -351,74 +344,102 @@ void AnalyticalDiffusionQballReconstructionImageFilter<T,TG,TO,L,NODF>
             gradientind.push_back(gradientind[i]);
     }
 
-    while( !git.IsAtEnd() )
-    {
-        GradientVectorType b = git.Get();
+    // the voxels are fitted in blocks, the coefficients and (for all but the solid angle method) the odf values
+    // of a block are computed in one product with the stacked reconstruction matrices
+    const bool solidAngle = m_NormalizationMethod == QBAR_SOLID_ANGLE;
+    vnl_matrix<TO> fitMatrix(solidAngle ? m_NumberCoefficients : m_NumberCoefficients+NODF, m_NumberOfGradientDirections);
+    fitMatrix.update(*m_CoeffReconstructionMatrix);
+    if (!solidAngle)
+        fitMatrix.update(*m_ReconstructionMatrix, m_NumberCoefficients, 0);
 
-        typename NumericTraits<ReferencePixelType>::AccumulateType b0 = NumericTraits<ReferencePixelType>::Zero;
+    const unsigned int blockSize = 256;
+    VoxelBlockFitter<TO> fitter(fitMatrix, blockSize);
+    std::vector< typename NumericTraits<ReferencePixelType>::AccumulateType > blockB0(blockSize);
+    std::vector< int > blockFitIndex(blockSize);
+    const TO* shBasis = m_SphericalHarmonicBasisMatrix->data_block();
 
-        // Average the baseline image pixels
-        for(unsigned int i = 0; i < baselineind.size(); ++i)
+    while( !git.IsAtEnd() )
+    {
+        fitter.Clear();
+        unsigned int numVoxels = 0;
+        for (; numVoxels<blockSize && !git.IsAtEnd(); ++numVoxels, ++git)
         {
-            b0 += b[baselineind[i]];
-        }
-        b0 /= this->m_NumberOfBaselineImages;
+            GradientVectorType b = git.Get();
 
-        OdfPixelType odf(0.0);
-        typename CoefficientImageType::PixelType coeffPixel(0.0);
-        vnl_vector<TO> B(m_NumberOfGradientDirections);
+            typename NumericTraits<ReferencePixelType>::AccumulateType b0 = NumericTraits<ReferencePixelType>::Zero;
 
-        if( (b0 != 0) && (b0 >= m_Threshold) )
-        {
-            for( unsigned int i = 0; i< m_NumberOfGradientDirections; i++ )
+            // Average the baseline image pixels
+            for(unsigned int i = 0; i < baselineind.size(); ++i)
             {
-                B[i] = static_cast<TO>(b[gradientind[i]]);
+                b0 += b[baselineind[i]];
             }
+            b0 /= this->m_NumberOfBaselineImages;
+            blockB0[numVoxels] = b0;
+            blockFitIndex[numVoxels] = -1;
 
-            B = PreNormalize(B, b0);
-            if(m_NormalizationMethod == QBAR_SOLID_ANGLE)
-            {
-                vnl_vector<TO> coeffs(m_NumberCoefficients);
-                coeffs = ( (*m_CoeffReconstructionMatrix) * B );
-                coeffs[0] += 1.0/(2.0*sqrt(QBALL_ANAL_RECON_PI));
-                odf = ( (*m_SphericalHarmonicBasisMatrix) * coeffs ).data_block();
-                coeffPixel = coeffs.data_block();
-            }
-            else if(m_NormalizationMethod == QBAR_NONNEG_SOLID_ANGLE)
+            if( (b0 != 0) && (b0 >= m_Threshold) )
             {
-                /** this would be the place to implement a non-negative
-              * solver for quadratic programming problem:
-              * min .5*|| Bc-s ||^2 subject to -CLPc <= 4*pi*ones
-              * (refer to MICCAI 2009 Goh et al. "Estimating ODFs with PDF constraints")
-              * .5*|| Bc-s ||^2 == .5*c'B'Bc - x'B's + .5*s's
-              */
-
-                itkExceptionMacro( << "Nonnegative Solid Angle not yet implemented");
+                if(m_NormalizationMethod == QBAR_NONNEG_SOLID_ANGLE)
+                {
+                    /** this would be the place to implement a non-negative
+                  * solver for quadratic programming problem:
+                  * min .5*|| Bc-s ||^2 subject to -CLPc <= 4*pi*ones
+                  * (refer to MICCAI 2009 Goh et al. "Estimating ODFs with PDF constraints")
+                  * .5*|| Bc-s ||^2 == .5*c'B'Bc - x'B's + .5*s's
+                  */
+
+                    itkExceptionMacro( << "Nonnegative Solid Angle not yet implemented");
+                }
+
+                blockFitIndex[numVoxels] = fitter.GetNumberOfVoxels();
+                vnl_vector_ref<TO> B(m_NumberOfGradientDirections, fitter.AddVoxel());
+                for( unsigned int i = 0; i< m_NumberOfGradientDirections; i++ )
+                {
+                    B[i] = static_cast<TO>(b[gradientind[i]]);
+                }
+                PreNormalize(B, b0);
             }
-            else
+        }
+
+        fitter.Fit();
+
+        for (unsigned int v=0; v<numVoxels; ++v)
+        {
+            OdfPixelType odf(0.0);
+            typename CoefficientImageType::PixelType coeffPixel(0.0);
+
+            if (blockFitIndex[v]>=0)
             {
-                vnl_vector<TO> coeffs(m_NumberCoefficients);
-                coeffs = ( (*m_CoeffReconstructionMatrix) * B );
-                coeffs[0] += 1.0/(2.0*sqrt(QBALL_ANAL_RECON_PI));
-                coeffPixel = coeffs.data_block();
-                odf = ( (*m_ReconstructionMatrix) * B ).data_block();
+                TO* result = fitter.GetResult(blockFitIndex[v]);
+                result[0] += 1.0/(2.0*sqrt(QBALL_ANAL_RECON_PI));
+                coeffPixel = result;
+                if (solidAngle)
+                {
+                    for (int i=0; i<NODF; i++)
+                    {
+                        TO value = 0;
+                        for (int j=0; j<m_NumberCoefficients; j++)
+                            value += shBasis[i*m_NumberCoefficients+j]*result[j];
+                        odf[i] = value;
+                    }
+                }
+                else
+                    odf = result + m_NumberCoefficients;
+                odf = Normalize(odf, blockB0[v]);
             }
-            odf = Normalize(odf, b0);
 
+            oit.Set( odf );
+            oit2.Set( blockB0[v] );
+            float sum = 0;
+            for (unsigned int k=0; k<odf.Size(); k++)
+                sum += (float) odf[k];
+            oit3.Set( sum-1 );
+            oit4.Set(coeffPixel);
+            ++oit;  // odf image iterator
+            ++oit3; // odf sum image iterator
+            ++oit2; // b0 image iterator
+            ++oit4; // coefficient image iterator
         }
-
-        oit.Set( odf );
-        oit2.Set( b0 );
-        float sum = 0;
-        for (unsigned int k=0; k<odf.Size(); k++)
-            sum += (float) odf[k];
-        oit3.Set( sum-1 );
-        oit4.Set(coeffPixel);
-        ++oit;  // odf image iterator
-        ++oit3; // odf sum image iterator
-        ++oit2; // b0 image iterator
-        ++oit4; // coefficient image iterator
-        ++git;  // Gradient  image iterator
     }
 
     std::cout << "One Thread finished reconstruction" << std::endl;
@@ -191,7 +191,7 @@ public:
     double Legendre0(int l);
 
     OdfPixelType Normalize(OdfPixelType odf, typename NumericTraits<ReferencePixelType>::AccumulateType b0 );
-    vnl_vector<TOdfPixelType> PreNormalize( vnl_vector<TOdfPixelType> vec, typename NumericTraits<ReferencePixelType>::AccumulateType b0  );
+    void PreNormalize( vnl_vector<TOdfPixelType>& vec, typename NumericTraits<ReferencePixelType>::AccumulateType b0  );
 
     /** Threshold on the reference image data. The output ODF will be a null
    * pdf for pixels in the reference image that have a value less than this
@@ -20,6 +20,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <itkTimeProbe.h>
 #include <itkPointShell.h>
+#include <itkVoxelBlockFitter.h>
+#include <vnl/vnl_vector_ref.h>
 #include <mitkDiffusionFunctionCollection.h>
 
 namespace itk {
@@ -633,52 +635,72 @@ void DiffusionMultiShellQballReconstructionImageFilter<T,TG,TO,L,NODF>
 
   typedef typename GradientImagesType::PixelType         GradientVectorType;
 
+  // The first coefficient is fixed, so the ODF is a linear function of the signal plus a constant offset.
+  // Coefficient and ODF reconstruction are combined into one matrix, which is applied to blocks of voxels.
+  vnl_matrix<double> coeffMatrix = *m_CoeffReconstructionMatrix;
+  coeffMatrix.set_row(0, 0.0);
+  vnl_matrix<double> odfMatrix = (*m_ODFSphericalHarmonicBasisMatrix) * coeffMatrix;
+  vnl_vector<double> odfOffset = m_ODFSphericalHarmonicBasisMatrix->get_column(0) * (1.0/(2.0*sqrt(M_PI)));
+
+  const unsigned int blockSize = 256;
+  VoxelBlockFitter<double> fitter(odfMatrix, blockSize);
+  std::vector< int > blockFitIndex(blockSize);
+  const double b0size = BZeroIndicies.size();
+
   // iterate overall voxels of the gradient image region
   while( ! git.IsAtEnd() )
   {
-    GradientVectorType b = git.Get();
-    // ODF Vector
-    OdfPixelType odf(0.0);
-
-    double b0average = 0;
-    const unsigned int b0size = BZeroIndicies.size();
-    for(unsigned int i = 0; i < b0size ; ++i)
-    {
-      b0average += b[BZeroIndicies[i]];
-    }
-    b0average /= b0size;
-    bzeroIterator.Set(b0average);
-    ++bzeroIterator;
-
-    // Create the Signal Vector
-    vnl_vector<double> SignalVector(NumbersOfGradientIndicies);
-    if( (b0average != 0) && (b0average >= m_Threshold) )
+    fitter.Clear();
+    unsigned int numVoxels = 0;
+    for (; numVoxels<blockSize && !git.IsAtEnd(); ++numVoxels, ++git)
     {
+      GradientVectorType b = git.Get();
 
-      for( unsigned int i = 0; i< SignalIndicies.size(); i++ )
+      double b0average = 0;
+      for(unsigned int i = 0; i < b0size ; ++i)
       {
-        SignalVector[i] = static_cast<double>(b[SignalIndicies[i]]);
+        b0average += b[BZeroIndicies[i]];
       }
+      b0average /= b0size;
+      bzeroIterator.Set(b0average);
+      ++bzeroIterator;
 
-      // apply threashold an generate ln(-ln(E)) signal
-      // Replace SignalVector with PreNormalized SignalVector
-      S_S0Normalization(SignalVector, b0average);
-      Projection1(SignalVector);
-
-      DoubleLogarithm(SignalVector);
+      blockFitIndex[numVoxels] = -1;
+      if( (b0average != 0) && (b0average >= m_Threshold) )
+      {
+        blockFitIndex[numVoxels] = fitter.GetNumberOfVoxels();
+        vnl_vector_ref<double> SignalVector(NumbersOfGradientIndicies, fitter.AddVoxel());
+        for( unsigned int i = 0; i< SignalIndicies.size(); i++ )
+        {
+          SignalVector[i] = static_cast<double>(b[SignalIndicies[i]]);
+        }
 
-      // approximate ODF coeffs
-      vnl_vector<double>  coeffs = ( (*m_CoeffReconstructionMatrix) * SignalVector );
-      coeffs[0] = 1.0/(2.0*sqrt(M_PI));
+        // apply threashold an generate ln(-ln(E)) signal
+        // Replace SignalVector with PreNormalized SignalVector
+        S_S0Normalization(SignalVector, b0average);
+        Projection1(SignalVector);
 
-      odf = element_cast<double, TO>(( (*m_ODFSphericalHarmonicBasisMatrix) * coeffs )).data_block();
-      odf *= (M_PI*4/NODF);
+        DoubleLogarithm(SignalVector);
+      }
     }
-    // set ODF to ODF-Image
-    oit.Set( odf );
-    ++oit;
-    ++git;
 
+    // approximate ODFs of the whole block
+    fitter.Fit();
+
+    for (unsigned int v=0; v<numVoxels; ++v)
+    {
+      // ODF Vector
+      OdfPixelType odf(0.0);
+      if (blockFitIndex[v]>=0)
+      {
+        const double* result = fitter.GetResult(blockFitIndex[v]);
+        for (int i=0; i<NODF; i++)
+          odf[i] = static_cast<TO>((result[i] + odfOffset[i]) * (M_PI*4/NODF));
+      }
+      // set ODF to ODF-Image
+      oit.Set( odf );
+      ++oit;
+    }
   }
 
   MITK_INFO << "One Thread finished reconstruction";
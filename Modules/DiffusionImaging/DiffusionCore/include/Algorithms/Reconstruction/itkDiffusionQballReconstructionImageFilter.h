@@ -230,7 +230,7 @@ public:
   /** Normalization performed on diffusion signal vector according
   * to method set in m_NormalizationMethod
   */
-  vnl_vector<TOdfPixelType> PreNormalize( vnl_vector<TOdfPixelType> vec );
+  void PreNormalize( vnl_vector<TOdfPixelType>& vec );
 
   /** Threshold on the reference image data. The output ODF will be a null
    * pdf for pixels in the reference image that have a value less than this
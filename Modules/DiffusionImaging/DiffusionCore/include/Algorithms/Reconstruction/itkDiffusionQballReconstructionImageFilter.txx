@@ -22,7 +22,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkImageRegionIterator.h"
 #include "itkArray.h"
 #include "vnl/vnl_vector.h"
+#include "vnl/vnl_vector_ref.h"
 #include "itkPointShell.h"
+#include "itkVoxelBlockFitter.h"
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -174,14 +176,13 @@ namespace itk {
   class TOdfPixelType,
     int NrOdfDirections,
     int NrBasisFunctionCenters >
-    vnl_vector<TOdfPixelType> itk::DiffusionQballReconstructionImageFilter<TReferenceImagePixelType, TGradientImagePixelType, TOdfPixelType, NrOdfDirections, NrBasisFunctionCenters>::PreNormalize( vnl_vector<TOdfPixelType> vec )
+    void itk::DiffusionQballReconstructionImageFilter<TReferenceImagePixelType, TGradientImagePixelType, TOdfPixelType, NrOdfDirections, NrBasisFunctionCenters>::PreNormalize( vnl_vector<TOdfPixelType>& vec )
   {
     switch( m_NormalizationMethod )
     {
       // standard: no normalization before reconstruction
     case QBR_STANDARD:
       {
-        return vec;
         break;
       }
       // log of signal
@@ -192,24 +193,19 @@ namespace itk {
         {
           vec[i] = log(vec[i]);
         }
-        return vec;
         break;
       }
       // no normalization before reconstruction here
     case QBR_B_ZERO:
       {
-        return vec;
         break;
       }
       // no normalization before reconstruction here
     case QBR_NONE:
       {
-        return vec;
         break;
       }
     }
-
-    return vec;
   }
 
   template< class TReferenceImagePixelType,
@@ -291,7 +287,7 @@ namespace itk {
           }
 
           // pre-normalization according to m_NormalizationMethod
-          B = PreNormalize(B);
+          PreNormalize(B);
 
           // actual reconstruction
           odf = ( (*m_ReconstructionMatrix) * B ).data_block();
@@ -364,53 +360,72 @@ namespace itk {
           gradientind.push_back(gradientind[i]);
       }
 
-      // Following loop does the actual reconstruction work in each voxel
-      // (Tuch, Q-Ball Reconstruction [1])
+      // Following loop does the actual reconstruction work (Tuch, Q-Ball Reconstruction [1]).
+      // The voxels are reconstructed in blocks, one matrix product per block.
+      const unsigned int blockSize = 256;
+      VoxelBlockFitter<TOdfPixelType> fitter(*m_ReconstructionMatrix, blockSize);
+      std::vector< typename NumericTraits<ReferencePixelType>::AccumulateType > blockB0(blockSize);
+      std::vector< int > blockFitIndex(blockSize);
       while( !git.IsAtEnd() )
       {
-        // current vector of diffusion measurements
-        GradientVectorType b = git.Get();
-
-        // average of current b-zero reference values
-        typename NumericTraits<ReferencePixelType>::AccumulateType b0 = NumericTraits<ReferencePixelType>::Zero;
-        for(unsigned int i = 0; i < baselineind.size(); ++i)
+        fitter.Clear();
+        unsigned int numVoxels = 0;
+        for (; numVoxels<blockSize && !git.IsAtEnd(); ++numVoxels, ++git)
         {
-          b0 += b[baselineind[i]];
-        }
-        b0 /= this->m_NumberOfBaselineImages;
+          // current vector of diffusion measurements
+          GradientVectorType b = git.Get();
 
-        // init resulting ODF
-        OdfPixelType odf(0.0);
+          // average of current b-zero reference values
+          typename NumericTraits<ReferencePixelType>::AccumulateType b0 = NumericTraits<ReferencePixelType>::Zero;
+          for(unsigned int i = 0; i < baselineind.size(); ++i)
+          {
+            b0 += b[baselineind[i]];
+          }
+          b0 /= this->m_NumberOfBaselineImages;
+          blockB0[numVoxels] = b0;
+          blockFitIndex[numVoxels] = -1;
 
-        // threshold on reference value to suppress noisy regions
-        if( (b0 != 0) && (b0 >= m_Threshold) )
-        {
-          for( unsigned int i = 0; i< m_NumberOfGradientDirections; i++ )
+          // threshold on reference value to suppress noisy regions
+          if( (b0 != 0) && (b0 >= m_Threshold) )
           {
-            B[i] = static_cast<TOdfPixelType>(b[gradientind[i]]);
+            blockFitIndex[numVoxels] = fitter.GetNumberOfVoxels();
+            vnl_vector_ref<TOdfPixelType> signal(m_NumberOfGradientDirections, fitter.AddVoxel());
+            for( unsigned int i = 0; i< m_NumberOfGradientDirections; i++ )
+            {
+              signal[i] = static_cast<TOdfPixelType>(b[gradientind[i]]);
+            }
+
+            // pre-normalization according to m_NormalizationMethod
+            PreNormalize(signal);
           }
+        }
 
-          // pre-normalization according to m_NormalizationMethod
-          B = PreNormalize(B);
+        // actual reconstruction
+        fitter.Fit();
 
-          // actual reconstruction
-          odf = ( (*m_ReconstructionMatrix) * B ).data_block();
+        for (unsigned int v=0; v<numVoxels; ++v)
+        {
+          // init resulting ODF
+          OdfPixelType odf(0.0);
 
-          // post-normalization according to m_NormalizationMethod
-          odf = Normalize(odf, b0);
+          if (blockFitIndex[v]>=0)
+          {
+            odf = fitter.GetResult(blockFitIndex[v]);
 
-        }
+            // post-normalization according to m_NormalizationMethod
+            odf = Normalize(odf, blockB0[v]);
+          }
 
-        for (unsigned int i=0; i<odf.Size(); i++)
-            if (odf.GetElement(i)!=odf.GetElement(i))
-                odf.Fill(0.0);
+          for (unsigned int i=0; i<odf.Size(); i++)
+              if (odf.GetElement(i)!=odf.GetElement(i))
+                  odf.Fill(0.0);
 
-        // set and increment output iterators
-        oit.Set( odf );
-        ++oit;
-        oit2.Set( b0 );
-        ++oit2;
-        ++git; // Gradient  image iterator
+          // set and increment output iterators
+          oit.Set( odf );
+          ++oit;
+          oit2.Set( blockB0[v] );
+          ++oit2;
+        }
       }
     }
 
@@ -0,0 +1,117 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef __itkVoxelBlockFitter_h__
+#define __itkVoxelBlockFitter_h__
+
+#include <vnl/vnl_matrix.h>
+#include <algorithm>
+#include <vector>
+
+namespace itk
+{
+
+/**
+  * \brief Applies a linear fit matrix to blocks of voxels at once.
+  *
+  * The signals of up to blockSize voxels are gathered into one contiguous buffer and multiplied with the
+  * fit matrix in a single matrix-matrix product. The product is tiled over the outputs: each row of the
+  * transposed fit matrix is applied to all voxels of the block before the next row is read, so the fit matrix
+  * is streamed once per block instead of once per voxel, while the results of one output tile stay in cache.
+  * No memory is allocated while fitting. Each output is accumulated in the same order as by
+  * vnl_matrix*vnl_vector, so the results equal the per-voxel fit. One fitter is used per thread.
+  */
+template< class TValue >
+class VoxelBlockFitter
+{
+public:
+
+    VoxelBlockFitter(const vnl_matrix< TValue >& fitMatrix, unsigned int blockSize = 256)
+        : m_NumberOfInputs(fitMatrix.cols())
+        , m_NumberOfOutputs(fitMatrix.rows())
+        , m_BlockSize(blockSize)
+        , m_NumberOfVoxels(0)
+        , m_FitMatrix(fitMatrix.transpose())
+        , m_Signals(static_cast<std::size_t>(blockSize)*fitMatrix.cols())
+        , m_Results(static_cast<std::size_t>(blockSize)*fitMatrix.rows())
+    {
+    }
+
+    /** Reserves the next voxel of the block and returns its signal buffer with GetNumberOfInputs() values. */
+    TValue* AddVoxel()
+    {
+        return &m_Signals[static_cast<std::size_t>(m_NumberOfVoxels++)*m_NumberOfInputs];
+    }
+
+    TValue* GetSignal(unsigned int voxel)
+    {
+        return &m_Signals[static_cast<std::size_t>(voxel)*m_NumberOfInputs];
+    }
+
+    /** Fit result of the voxel, valid after Fit() until the next Clear(). */
+    TValue* GetResult(unsigned int voxel)
+    {
+        return &m_Results[static_cast<std::size_t>(voxel)*m_NumberOfOutputs];
+    }
+
+    void Fit()
+    {
+        const TValue* fit = m_FitMatrix.data_block();
+        std::fill(m_Results.begin(), m_Results.begin() + static_cast<std::size_t>(m_NumberOfVoxels)*m_NumberOfOutputs, TValue(0));
+        for (unsigned int firstOutput=0; firstOutput<m_NumberOfOutputs; firstOutput+=OutputTileSize)
+        {
+            const unsigned int lastOutput = std::min(firstOutput + OutputTileSize, m_NumberOfOutputs);
+            for (unsigned int i=0; i<m_NumberOfInputs; i++)
+            {
+                const TValue* row = fit + static_cast<std::size_t>(i)*m_NumberOfOutputs;
+                for (unsigned int v=0; v<m_NumberOfVoxels; v++)
+                {
+                    const TValue s = m_Signals[static_cast<std::size_t>(v)*m_NumberOfInputs + i];
+                    TValue* result = this->GetResult(v);
+                    // contiguous part of a row of the transposed fit matrix, vectorizes
+                    for (unsigned int o=firstOutput; o<lastOutput; o++)
+                        result[o] += row[o]*s;
+                }
+            }
+        }
+    }
+
+    void Clear() { m_NumberOfVoxels = 0; }
+
+    bool IsFull() const { return m_NumberOfVoxels>=m_BlockSize; }
+    unsigned int GetNumberOfVoxels() const { return m_NumberOfVoxels; }
+    unsigned int GetNumberOfInputs() const { return m_NumberOfInputs; }
+    unsigned int GetNumberOfOutputs() const { return m_NumberOfOutputs; }
+
+private:
+
+    /** Outputs per tile, the results of a full block of one tile fit into the L2 cache. */
+    enum { OutputTileSize = 64 };
+
+    unsigned int            m_NumberOfInputs;
+    unsigned int            m_NumberOfOutputs;
+    unsigned int            m_BlockSize;
+    unsigned int            m_NumberOfVoxels;
+
+    /** Transposed fit matrix, one row per input value. */
+    vnl_matrix< TValue >    m_FitMatrix;
+    std::vector< TValue >   m_Signals;
+    std::vector< TValue >   m_Results;
+};
+
+}
+
+#endif
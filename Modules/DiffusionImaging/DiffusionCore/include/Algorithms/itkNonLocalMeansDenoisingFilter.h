@@ -19,6 +19,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "itkImageToImageFilter.h"
 #include "itkVectorImage.h"
+#include <vector>
 
 
 namespace itk{
@@ -83,6 +84,17 @@ namespace itk{
      * If this flag is true the filter uses a method which is optimized for Rician distributed noise.
      */
     itkSetMacro(UseRicianAdaption, bool)
+    /**
+     * @brief Set flag to use the fast computation of the patch distances
+     *
+     * If this flag is true, the squared differences of all voxel pairs at one search offset are computed once and
+     * summed up over the comparison neighborhoods with running box sums. The weights equal those of the voxelwise
+     * computation, the denoised values differ by at most one due to rounding. In joint mode, the patch distances
+     * are shared by all channels. With joint information and Rician adaption, the voxelwise computation stores two
+     * values per neighbor and averages a mix of squared and plain values. The fast computation intentionally
+     * differs from it in this mode and averages the squared values of all neighbors. Default is false.
+     */
+    itkSetMacro(UseFastPatchDistances, bool)
     /**
      * @brief Get the amount of calculated Voxels
      *
@@ -124,6 +136,16 @@ namespace itk{
      */
     void ThreadedGenerateData( const OutputImageRegionType &outputRegionForThread, ThreadIdType);
 
+    /**
+     * @brief Denoising procedure with box summed patch distances
+     *
+     * Used by ThreadedGenerateData if UseFastPatchDistances is set.
+     */
+    void FastThreadedGenerateData( const OutputImageRegionType &outputRegionForThread );
+
+    /** @brief Replaces each value of the buffer by the sum over the (2 * radius + 1)³ box around it. */
+    static void BoxSum(std::vector<double>& values, const int size[3], int radius);
+
 
 
   private:
@@ -132,6 +154,7 @@ namespace itk{
     int m_ComparisonRadius;                           ///< Radius of the comparisonblock.
     bool m_UseJointInformation;                       ///< Flag to use joint information.
     bool m_UseRicianAdaption;                         ///< Flag to use rician adaption.
+    bool m_UseFastPatchDistances;                     ///< Flag to use box summed patch distances.
     unsigned int m_CurrentVoxelCount;                 ///< Amount of processed voxels.
     double m_Variance;                                ///< Estimated noise variance.
     typename MaskImageType::Pointer m_Mask;           ///< Pointer to the mask image.
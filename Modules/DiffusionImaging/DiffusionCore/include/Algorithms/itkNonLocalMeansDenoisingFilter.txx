@@ -27,6 +27,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkImageRegionIterator.h"
 #include "itkNeighborhoodIterator.h"
 #include <itkImageRegionIteratorWithIndex.h>
+#include <itkImageRegionConstIterator.h>
+#include <algorithm>
 #include <vector>
 
 namespace itk {
@@ -39,6 +41,7 @@ NonLocalMeansDenoisingFilter< TPixelType >
     m_ComparisonRadius(1),
     m_UseJointInformation(false),
     m_UseRicianAdaption(false),
+    m_UseFastPatchDistances(false),
     m_Variance(1),
     m_Mask(NULL)
 {
@@ -56,6 +59,7 @@ NonLocalMeansDenoisingFilter< TPixelType >
   MITK_INFO << "Noisevariance: " << m_Variance;
   MITK_INFO << "Use Rician Adaption: " << std::boolalpha << m_UseRicianAdaption;
   MITK_INFO << "Use Joint Information: " << std::boolalpha << m_UseJointInformation;
+  MITK_INFO << "Use Fast Patch Distances: " << std::boolalpha << m_UseFastPatchDistances;
 
 
   typename InputImageType::Pointer inputImagePointer = static_cast< InputImageType * >( this->ProcessObject::GetInput(0) );
@@ -127,7 +131,12 @@ void
 NonLocalMeansDenoisingFilter< TPixelType >
 ::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread, ThreadIdType )
 {
-
+  if (m_UseFastPatchDistances)
+  {
+    this->FastThreadedGenerateData(outputRegionForThread);
+    MITK_INFO << "One Thread finished calculation";
+    return;
+  }
 
   // initialize iterators
   typename OutputImageType::Pointer outputImage =
@@ -372,6 +381,255 @@ NonLocalMeansDenoisingFilter< TPixelType >
   MITK_INFO << "One Thread finished calculation";
 }
 
+template< class TPixelType >
+void
+NonLocalMeansDenoisingFilter< TPixelType >
+::FastThreadedGenerateData(const OutputImageRegionType& outputRegionForThread)
+{
+  typename OutputImageType::Pointer outputImage =
+          static_cast< OutputImageType * >(this->ProcessObject::GetOutput(0));
+  typename InputImageType::Pointer inputImagePointer = static_cast< InputImageType * >( this->ProcessObject::GetInput(0) );
+
+  const int numChannels = inputImagePointer->GetVectorLength();
+  const typename InputImageType::RegionType imageRegion = inputImagePointer->GetLargestPossibleRegion();
+  const typename InputImageType::OffsetValueType* offsetTable = inputImagePointer->GetOffsetTable();
+  const TPixelType* input = inputImagePointer->GetBufferPointer();
+  TPixelType* output = outputImage->GetBufferPointer();
+
+  int imageStart[3];
+  int imageEnd[3];
+  for (int d = 0; d < 3; ++d)
+  {
+    imageStart[d] = imageRegion.GetIndex(d);
+    imageEnd[d] = imageRegion.GetIndex(d) + imageRegion.GetSize(d) - 1;
+  }
+
+  // In joint mode, the weighted sums of all channels are accumulated at once, so the region is processed in slabs
+  // of slices to limit the memory. Otherwise the channels are processed one after another.
+  const int numPasses = m_UseJointInformation ? 1 : numChannels;
+  const int channelsPerPass = m_UseJointInformation ? numChannels : 1;
+  const int numSlices = outputRegionForThread.GetSize(2);
+  int slabThickness = numSlices;
+  if (m_UseJointInformation)
+  {
+    const int sliceValues = outputRegionForThread.GetSize(0) * outputRegionForThread.GetSize(1) * numChannels;
+    slabThickness = std::max(1, std::min(numSlices, (1 << 22) / std::max(1, sliceValues)));
+  }
+  // the voxelwise computation normalizes the joint distances by the number of channels plus one
+  const double normalization = m_UseJointInformation ? numChannels + 1 : 1;
+
+  std::vector<double> distances;
+  std::vector<double> weightSums;
+  std::vector<double> valueSums;
+  std::vector<int> counts[3];
+
+  for (int slabStart = 0; slabStart < numSlices; slabStart += slabThickness)
+  {
+    OutputImageRegionType slab = outputRegionForThread;
+    slab.SetIndex(2, outputRegionForThread.GetIndex(2) + slabStart);
+    slab.SetSize(2, std::min(slabThickness, numSlices - slabStart));
+
+    // all voxels covered by the comparison neighborhoods of the slab
+    typename InputImageType::RegionType patchRegion = slab;
+    patchRegion.PadByRadius(m_ComparisonRadius);
+    patchRegion.Crop(imageRegion);
+
+    int patchSize[3];
+    int slabSize[3];
+    int slabStartInPatch[3];
+    for (int d = 0; d < 3; ++d)
+    {
+      patchSize[d] = patchRegion.GetSize(d);
+      slabSize[d] = slab.GetSize(d);
+      slabStartInPatch[d] = slab.GetIndex(d) - patchRegion.GetIndex(d);
+      counts[d].resize(slabSize[d]);
+    }
+    const int numSlabVoxels = slab.GetNumberOfPixels();
+    distances.resize(patchRegion.GetNumberOfPixels());
+
+    for (int pass = 0; pass < numPasses; ++pass)
+    {
+      if (this->GetAbortGenerateData())
+        return;
+
+      const int firstChannel = m_UseJointInformation ? 0 : pass;
+      weightSums.assign(numSlabVoxels, 0.0);
+      valueSums.assign(numSlabVoxels * channelsPerPass, 0.0);
+
+      for (int x = -m_SearchRadius; x <= m_SearchRadius; ++x)
+      {
+        for (int y = -m_SearchRadius; y <= m_SearchRadius; ++y)
+        {
+          for (int z = -m_SearchRadius; z <= m_SearchRadius; ++z)
+          {
+            const int searchOffset[3] = {x, y, z};
+            const std::ptrdiff_t offsetJ = (x * offsetTable[0] + y * offsetTable[1] + z * offsetTable[2]) * numChannels;
+
+            // squared differences of all voxel pairs at the search offset, zero if the pair is not inside the image
+            double* distance = &distances[0];
+            typename InputImageType::IndexType indexI = patchRegion.GetIndex();
+            for (int zi = 0; zi < patchSize[2]; ++zi)
+            {
+              indexI[2] = patchRegion.GetIndex(2) + zi;
+              for (int yi = 0; yi < patchSize[1]; ++yi, distance += patchSize[0])
+              {
+                indexI[1] = patchRegion.GetIndex(1) + yi;
+                indexI[0] = patchRegion.GetIndex(0);
+                const bool rowInside = indexI[1] + y >= imageStart[1] && indexI[1] + y <= imageEnd[1]
+                                    && indexI[2] + z >= imageStart[2] && indexI[2] + z <= imageEnd[2];
+                std::fill(distance, distance + patchSize[0], 0.0);
+                if (!rowInside)
+                  continue;
+
+                const TPixelType* pixelI = input + inputImagePointer->ComputeOffset(indexI) * numChannels + firstChannel;
+                const int begin = std::max(0, imageStart[0] - indexI[0] - x);
+                const int end = std::min(patchSize[0], imageEnd[0] - indexI[0] - x + 1);
+                for (int xi = begin; xi < end; ++xi)
+                {
+                  const TPixelType* valueI = pixelI + xi * numChannels;
+                  const TPixelType* valueJ = valueI + offsetJ;
+                  double sum = 0;
+                  for (int c = 0; c < channelsPerPass; ++c)
+                  {
+                    const double diff = (double)valueI[c] - (double)valueJ[c];
+                    sum += diff * diff;
+                  }
+                  distance[xi] = sum;
+                }
+              }
+            }
+            BoxSum(distances, patchSize, m_ComparisonRadius);
+
+            // number of compared voxel pairs, separable since both voxels of a pair have to be inside the image;
+            // zero if the search voxel itself is outside of the image
+            for (int d = 0; d < 3; ++d)
+            {
+              for (int i = 0; i < slabSize[d]; ++i)
+              {
+                const int index = slab.GetIndex(d) + i;
+                if (index + searchOffset[d] < imageStart[d] || index + searchOffset[d] > imageEnd[d])
+                {
+                  counts[d][i] = 0;
+                  continue;
+                }
+                const int first = std::max(-m_ComparisonRadius, std::max(imageStart[d] - index, imageStart[d] - index - searchOffset[d]));
+                const int last = std::min(m_ComparisonRadius, std::min(imageEnd[d] - index, imageEnd[d] - index - searchOffset[d]));
+                counts[d][i] = last >= first ? last - first + 1 : 0;
+              }
+            }
+
+            // weight all neighborhoods
+            int v = 0;
+            typename InputImageType::IndexType index = slab.GetIndex();
+            for (int zi = 0; zi < slabSize[2]; ++zi)
+            {
+              index[2] = slab.GetIndex(2) + zi;
+              for (int yi = 0; yi < slabSize[1]; ++yi, v += slabSize[0])
+              {
+                index[1] = slab.GetIndex(1) + yi;
+                index[0] = slab.GetIndex(0);
+                if (counts[1][yi] == 0 || counts[2][zi] == 0)
+                  continue;
+
+                const double* distance = &distances[slabStartInPatch[0] + (yi + slabStartInPatch[1]) * patchSize[0]
+                                                    + (zi + slabStartInPatch[2]) * patchSize[0] * patchSize[1]];
+                const TPixelType* pixelJ = input + inputImagePointer->ComputeOffset(index) * numChannels + offsetJ + firstChannel;
+                for (int xi = 0; xi < slabSize[0]; ++xi)
+                {
+                  if (counts[0][xi] == 0)
+                    continue;
+                  const double size = (double)counts[0][xi] * counts[1][yi] * counts[2][zi] * normalization;
+                  const double w = std::exp( - (distance[xi] / size) / m_Variance);
+                  weightSums[v + xi] += w;
+
+                  const TPixelType* valueJ = pixelJ + xi * numChannels;
+                  double* valueSum = &valueSums[(v + xi) * channelsPerPass];
+                  for (int c = 0; c < channelsPerPass; ++c)
+                  {
+                    const double p = valueJ[c];
+                    valueSum[c] += m_UseRicianAdaption ? w * p * p : w * p;
+                  }
+                }
+              }
+            }
+          }
+        }
+      }
+
+      // denoised values of the pass channels, voxels outside of the mask are set to 0
+      ImageRegionConstIterator< MaskImageType > mit(m_Mask, slab);
+      ImageRegionConstIteratorWithIndex< OutputImageType > oit(outputImage, slab);
+      for (int v = 0; !oit.IsAtEnd(); ++oit, ++mit, ++v)
+      {
+        TPixelType* outpix = output + outputImage->ComputeOffset(oit.GetIndex()) * numChannels + firstChannel;
+        for (int c = 0; c < channelsPerPass; ++c)
+        {
+          double a = 0;
+          if (mit.Get() != 0)
+          {
+            a = valueSums[v * channelsPerPass + c] / weightSums[v];
+            if (m_UseRicianAdaption)
+            {
+              a -= 2 * m_Variance;
+            }
+          }
+          if (a < 0)
+          {
+            a = 0;
+          }
+          if (m_UseRicianAdaption)
+          {
+            outpix[c] = std::floor(std::sqrt(a) + 0.5);
+          }
+          else
+          {
+            outpix[c] = std::floor(a + 0.5);
+          }
+        }
+      }
+      m_CurrentVoxelCount += (pass + 1) * numSlabVoxels / numPasses - pass * numSlabVoxels / numPasses;
+    }
+  }
+}
+
+template< class TPixelType >
+void
+NonLocalMeansDenoisingFilter< TPixelType >
+::BoxSum(std::vector<double>& values, const int size[3], int radius)
+{
+  // running sums along each axis, exact as long as the values are integers
+  const int stride[3] = {1, size[0], size[0] * size[1]};
+  std::vector<double> line;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    const int axis1 = (axis + 1) % 3;
+    const int axis2 = (axis + 2) % 3;
+    const int n = size[axis];
+    line.resize(n);
+    for (int j = 0; j < size[axis2]; ++j)
+    {
+      for (int i = 0; i < size[axis1]; ++i)
+      {
+        double* start = &values[i * stride[axis1] + j * stride[axis2]];
+        for (int k = 0; k < n; ++k)
+          line[k] = start[k * stride[axis]];
+
+        double sum = 0;
+        for (int k = 0; k < std::min(radius, n); ++k)
+          sum += line[k];
+        for (int k = 0; k < n; ++k)
+        {
+          if (k + radius < n)
+            sum += line[k + radius];
+          if (k - radius - 1 >= 0)
+            sum -= line[k - radius - 1];
+          start[k * stride[axis]] = sum;
+        }
+      }
+    }
+  }
+}
+
 template< class TPixelType >
 void NonLocalMeansDenoisingFilter< TPixelType >::SetInputImage(const InputImageType* image)
 {
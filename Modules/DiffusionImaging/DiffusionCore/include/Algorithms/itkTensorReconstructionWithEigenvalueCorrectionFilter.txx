@@ -21,6 +21,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkImageFileWriter.h"
 #include "itkImage.h"
 #include "itkImageRegionIterator.h"
+#include "itkVoxelBlockFitter.h"
 
 namespace itk
 {
@@ -827,125 +828,80 @@ TensorReconstructionWithEigenvalueCorrectionFilter<TDiffusionPixelType, TTensorP
 ::GenerateTensorImage(int nof,int numberb0,itk::Size<3> size,itk::VectorImage<short, 3>::Pointer corrected_diffusion,itk::Image<short, 3>::Pointer mask,double what_mask, typename itk::Image< itk::DiffusionTensor3D<TTensorPixelType>, 3 >::Pointer tensorImg)
 {
   // in this method the whole tensor image is updated with a tensors for defined voxels ( defined by a value of mask);
+  // the slices are processed in parallel, the attenuations of the masked voxels of a slice are collected in blocks
+  // and the tensors of a block are calculated in one product with the previously calculated inverse of the design matrix
+  const unsigned int blockSize = 256;
 
-
-  itk::Index<3> ix;
-
-  itk::Index<3> idx;
-  idx.Fill(5);
-
-  vnl_vector<double> org_data(nof);
-  vnl_vector<double> atten(nof-numberb0);
-  vnl_vector<double> tensor(6);
-  itk::DiffusionTensor3D<double> ten;
-  double mask_val=0;
-
-
-  for (unsigned int x=0;x<size[0];x++)
+#pragma omp parallel for
+  for (int x=0;x<static_cast<int>(size[0]);x++)
   {
+    VoxelBlockFitter<double> fitter(m_PseudoInverse, blockSize);
+    std::vector< itk::Index<3> > blockIndices(blockSize);
+    itk::DiffusionTensor3D<double> ten;
+    itk::Index<3> ix;
+    ix[0] = x;
 
     for (unsigned int y=0;y<size[1];y++)
     {
-
       for (unsigned int z=0;z<size[2];z++)
       {
-
-
-        ix[0] = x; ix[1] = y; ix[2] = z;
-
-        mask_val= mask->GetPixel(ix);
+        ix[1] = y; ix[2] = z;
 
         //Tensors are calculated only for voxels above theshold for B0 image.
-
-        if( mask_val > 0.0 )
+        if( mask->GetPixel(ix) > 0.0 )
         {
-
           // calculation of attenuation with use of gradient image and  and mean B0 image
           GradientVectorType pt = corrected_diffusion->GetPixel(ix);
 
-          for (int i=0;i<nof;i++)
-          {
-            org_data[i]=pt[i];
-          }
-
           double mean_b=0.0;
-
           for (int i=0;i<nof;i++)
           {
             if(m_B0Mask[i]>0)
             {
-              mean_b=mean_b+org_data[i];
+              mean_b=mean_b+pt[i];
             }
-
           }
           mean_b=mean_b/numberb0;
+
+          blockIndices[fitter.GetNumberOfVoxels()] = ix;
+          double* atten = fitter.AddVoxel();
           int cnt=0;
           for (int i=0;i<nof;i++)
           {
-            if (org_data[i]<= 0)
-
-            {
-              org_data[i]=0.1;
-            }
             if(m_B0Mask[i]==0)
             {
-              atten[cnt]=org_data[i]/mean_b;
+              const double value = pt[i]<=0 ? 0.1 : pt[i];
+              atten[cnt]=log(value/mean_b);
               cnt++;
             }
           }
-
-
-
-
-          for (int i=0;i<nof-numberb0;i++)
-          {
-
-            atten[i]=log((double)atten[i]);
-          }
-
-          // Calculation of tensor with use of previously calculated inverse of design matrix and attenuation
-          tensor = m_PseudoInverse*atten;
-
-          ten(0,0) = tensor[0];
-          ten(0,1) = tensor[3];
-          ten(0,2) = tensor[5];
-          ten(1,1) = tensor[1];
-          ten(1,2) = tensor[4];
-          ten(2,2) = tensor[2];
-
-          tensorImg->SetPixel(ix, ten);
-
-
-
         }
         // for voxels with mask value 0 - tensor is simply 0 ( outside brain value)
-        else if (mask_val < 1.0)
+        else
         {
-
-          ten(0,0) = 0;
-          ten(0,1) = 0;
-          ten(0,2) = 0;
-          ten(1,1) = 0;
-          ten(1,2) = 0;
-          ten(2,2) = 0;
+          ten.Fill(0);
           tensorImg->SetPixel(ix, ten);
         }
 
-        if (ix == idx)
+        if (fitter.IsFull() || (y+1==size[1] && z+1==size[2]))
         {
-          for (int ll = 0; ll < 6 ; ll++)
-          std::cout << tensor[ll] << "," << std::endl;
+          fitter.Fit();
+          for (unsigned int v=0; v<fitter.GetNumberOfVoxels(); v++)
+          {
+            const double* tensor = fitter.GetResult(v);
+            ten(0,0) = tensor[0];
+            ten(0,1) = tensor[3];
+            ten(0,2) = tensor[5];
+            ten(1,1) = tensor[1];
+            ten(1,2) = tensor[4];
+            ten(2,2) = tensor[2];
+            tensorImg->SetPixel(blockIndices[v], ten);
+          }
+          fitter.Clear();
         }
-
-
-
-
       }
     }
   }
-
-
-
 }// end of Generate Tensor
 
 
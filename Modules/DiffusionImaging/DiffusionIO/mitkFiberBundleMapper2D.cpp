@@ -35,6 +35,43 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkIShaderRepository.h>
 #include <mitkShaderProperty.h>
 #include <mitkCoreServices.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkUnsignedCharArray.h>
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+/** Calls the function with the first and last point of each run of consecutive segments within the slab |dot(p, normal) - w| <= thickness, as in the clipping shader. */
+template< class FunctionType >
+void ForEachSlabRun(vtkPoints* points, const vtkIdType* ids, vtkIdType numPoints, const double normal[3], double w, double thickness, FunctionType function)
+{
+    if (numPoints<2)
+        return;
+
+    double p[3];
+    points->GetPoint(ids[0], p);
+    double r1 = p[0]*normal[0] + p[1]*normal[1] + p[2]*normal[2] - w;
+    vtkIdType start = -1;
+    for (vtkIdType j=1; j<numPoints; j++)
+    {
+        points->GetPoint(ids[j], p);
+        const double r2 = p[0]*normal[0] + p[1]*normal[1] + p[2]*normal[2] - w;
+        const bool inside = std::min(r1, r2)<=thickness && std::max(r1, r2)>=-thickness;
+        if (inside && start<0)
+            start = j-1;
+        else if (!inside && start>=0)
+        {
+            function(start, j-1);
+            start = -1;
+        }
+        r1 = r2;
+    }
+    if (start>=0)
+        function(start, numPoints-1);
+}
+}
 
 mitk::FiberBundleMapper2D::FiberBundleMapper2D()
     : m_LineWidth(1)
@@ -98,7 +135,7 @@ void mitk::FiberBundleMapper2D::Update(mitk::BaseRenderer * renderer)
             fiberBundle->RequestUpdate2D();
         }
 
-        if ( localStorage->m_LastUpdateTime<renderer->GetCurrentWorldPlaneGeometryUpdateTime() || localStorage->m_LastUpdateTime<fiberBundle->GetUpdateTime2D() )
+        if ( localStorage->m_LastUpdateTime<renderer->GetCurrentWorldPlaneGeometryUpdateTime() || localStorage->m_LastUpdateTime<fiberBundle->GetUpdateTime2D() || localStorage->m_SliceThickness!=thickness )
         {
             this->UpdateShaderParameter(renderer);
             this->GenerateDataForRenderer( renderer );
@@ -141,18 +178,22 @@ void mitk::FiberBundleMapper2D::GenerateDataForRenderer(mitk::BaseRenderer *rend
     if ( node == nullptr )
         return;
 
-    vtkSmartPointer<vtkPolyData> fiberPolyData = fiberBundle->GetFiberPolyData();
-    if (fiberPolyData == nullptr)
+    if (fiberBundle->GetFiberPolyData() == nullptr)
         return;
 
-    fiberPolyData->GetPointData()->AddArray(fiberBundle->GetFiberColors());
+    // only the segments close to the plane are passed to the mapper, the shader clips them to the exact slice thickness
+    float thickness = 2.0;
+    node->GetPropertyValue("Fiber2DSliceThickness",thickness);
+    localStorage->m_SlicedResult = this->GetSlabFibers(renderer, thickness);
+    localStorage->m_SliceThickness = thickness;
+
     localStorage->m_FiberMapper->ScalarVisibilityOn();
     localStorage->m_FiberMapper->SetScalarModeToUsePointFieldData();
     localStorage->m_FiberMapper->SetLookupTable(m_lut);  //apply the properties after the slice was set
     localStorage->m_PointActor->GetProperty()->SetOpacity(0.999);
     localStorage->m_FiberMapper->SelectColorArray("FIBER_COLORS");
 
-    localStorage->m_FiberMapper->SetInputData(fiberPolyData);
+    localStorage->m_FiberMapper->SetInputData(localStorage->m_SlicedResult);
     localStorage->m_PointActor->SetMapper(localStorage->m_FiberMapper);
     localStorage->m_PointActor->GetProperty()->ShadingOn();
     localStorage->m_PointActor->GetProperty()->SetLineWidth(m_LineWidth);
@@ -165,6 +206,142 @@ void mitk::FiberBundleMapper2D::GenerateDataForRenderer(mitk::BaseRenderer *rend
 }
 
 
+vtkSmartPointer<vtkPolyData> mitk::FiberBundleMapper2D::GetSlabFibers(mitk::BaseRenderer* renderer, float thickness)
+{
+    mitk::FiberBundle* fiberBundle = this->GetInput();
+    vtkSmartPointer<vtkPolyData> fiberPolyData = fiberBundle->GetFiberPolyData();
+    vtkUnsignedCharArray* fiberColors = fiberBundle->GetFiberColors();
+    vtkPoints* points = fiberPolyData->GetPoints();
+
+    vtkSmartPointer<vtkPolyData> result = vtkSmartPointer<vtkPolyData>::New();
+    if (points==nullptr || fiberPolyData->GetNumberOfCells()==0)
+        return result;
+
+    mitk::PlaneGeometry::ConstPointer planeGeo = renderer->GetSliceNavigationController()->GetCurrentPlaneGeometry();
+    if (planeGeo.IsNull())
+    {
+        fiberPolyData->GetPointData()->AddArray(fiberColors);
+        return fiberPolyData;
+    }
+    double normal[3];
+    for (int i=0; i<3; i++)
+        normal[i] = planeGeo->GetNormal()[i];
+    const double w = planeGeo->GetOrigin()[0]*normal[0] + planeGeo->GetOrigin()[1]*normal[1] + planeGeo->GetOrigin()[2]*normal[2];
+
+    // for axis aligned planes, the candidate fibers are taken from the segment grid of the bundle
+    std::vector< long > candidates;
+    int axis = -1;
+    for (int i=0; i<3; i++)
+        if (normal[i]!=0 && normal[(i+1)%3]==0 && normal[(i+2)%3]==0)
+            axis = i;
+    if (axis>=0)
+    {
+        double bounds[6];
+        fiberPolyData->GetBounds(bounds);
+        bounds[2*axis] = std::min((w-thickness)/normal[axis], (w+thickness)/normal[axis]);
+        bounds[2*axis+1] = std::max((w-thickness)/normal[axis], (w+thickness)/normal[axis]);
+        candidates = fiberBundle->GetSegmentIndex()->GetCandidateFibers(bounds);
+    }
+    else
+    {
+        candidates.resize(fiberPolyData->GetNumberOfCells());
+        std::iota(candidates.begin(), candidates.end(), 0);
+    }
+
+    // the cell links are built before the fibers are read in parallel
+    if (fiberPolyData->NeedToBuildCells())
+        fiberPolyData->BuildCells();
+
+    // count the points and runs of each candidate fiber
+    const int numCandidates = static_cast<int>(candidates.size());
+    std::vector< vtkIdType > numRunPoints(numCandidates, 0);
+    std::vector< vtkIdType > numRuns(numCandidates, 0);
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int c=0; c<numCandidates; c++)
+    {
+        vtkIdType numPoints = 0;
+        vtkIdType* ids = nullptr;
+        fiberPolyData->GetCellPoints(candidates[c], numPoints, ids);
+        ForEachSlabRun(points, ids, numPoints, normal, w, thickness, [&](vtkIdType first, vtkIdType last)
+        {
+            numRunPoints[c] += last-first+1;
+            numRuns[c]++;
+        });
+    }
+
+    // if there are too many segments, only every n-th fiber is shown
+    int maxSegments = 1000000;
+    this->GetDataNode()->GetIntProperty("Fiber2DMaxSegments", maxSegments);
+    const vtkIdType numSegments = std::accumulate(numRunPoints.begin(), numRunPoints.end(), vtkIdType(0)) - std::accumulate(numRuns.begin(), numRuns.end(), vtkIdType(0));
+    int stride = 1;
+    if (maxSegments>0 && numSegments>maxSegments)
+        stride = static_cast<int>((numSegments+maxSegments-1)/maxSegments);
+
+    // offsets of the points and cells of each shown fiber in the result
+    std::vector< vtkIdType > pointOffsets(numCandidates+1, 0);
+    std::vector< vtkIdType > cellOffsets(numCandidates+1, 0);
+    for (int c=0; c<numCandidates; c++)
+    {
+        const bool shown = c%stride==0;
+        pointOffsets[c+1] = pointOffsets[c] + (shown ? numRunPoints[c] : 0);
+        cellOffsets[c+1] = cellOffsets[c] + (shown ? numRunPoints[c]+numRuns[c] : 0);
+    }
+
+    vtkSmartPointer<vtkFloatArray> coordinates = vtkSmartPointer<vtkFloatArray>::New();
+    coordinates->SetNumberOfComponents(3);
+    coordinates->SetNumberOfTuples(pointOffsets.back());
+    const int numComponents = fiberColors!=nullptr ? fiberColors->GetNumberOfComponents() : 0;
+    const bool hasColors = fiberColors!=nullptr && fiberColors->GetNumberOfTuples()>=points->GetNumberOfPoints();
+    vtkSmartPointer<vtkUnsignedCharArray> colors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    colors->SetName("FIBER_COLORS");
+    colors->SetNumberOfComponents(numComponents);
+    if (hasColors)
+        colors->SetNumberOfTuples(pointOffsets.back());
+
+    // legacy cell array layout: number of points followed by the point ids for each cell
+    vtkSmartPointer<vtkIdTypeArray> cells = vtkSmartPointer<vtkIdTypeArray>::New();
+    cells->SetNumberOfValues(cellOffsets.back());
+
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int c=0; c<numCandidates; c+=stride)
+    {
+        vtkIdType numPoints = 0;
+        vtkIdType* ids = nullptr;
+        fiberPolyData->GetCellPoints(candidates[c], numPoints, ids);
+        vtkIdType pointId = pointOffsets[c];
+        vtkIdType* cell = cells->GetPointer(cellOffsets[c]);
+        ForEachSlabRun(points, ids, numPoints, normal, w, thickness, [&](vtkIdType first, vtkIdType last)
+        {
+            *cell++ = last-first+1;
+            for (vtkIdType j=first; j<=last; j++)
+            {
+                double p[3];
+                points->GetPoint(ids[j], p);
+                float* coordinate = coordinates->GetPointer(3*pointId);
+                coordinate[0] = p[0];
+                coordinate[1] = p[1];
+                coordinate[2] = p[2];
+                if (hasColors)
+                    std::copy(fiberColors->GetPointer(numComponents*ids[j]), fiberColors->GetPointer(numComponents*ids[j])+numComponents, colors->GetPointer(numComponents*pointId));
+                *cell++ = pointId++;
+            }
+        });
+    }
+
+    vtkSmartPointer<vtkPoints> slabPoints = vtkSmartPointer<vtkPoints>::New();
+    slabPoints->SetData(coordinates);
+    const vtkIdType numLines = cellOffsets.back()-pointOffsets.back();
+    vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+    lines->SetCells(numLines, cells);
+    result->SetPoints(slabPoints);
+    result->SetLines(lines);
+    if (hasColors)
+        result->GetPointData()->AddArray(colors);
+
+    MITK_DEBUG << "FiberBundleMapper2D: " << pointOffsets.back()-numLines << " of " << fiberPolyData->GetNumberOfPoints()-fiberPolyData->GetNumberOfCells() << " segments in slab";
+    return result;
+}
+
 vtkProp* mitk::FiberBundleMapper2D::GetVtkProp(mitk::BaseRenderer *renderer)
 {
     this->Update(renderer);
@@ -187,6 +364,7 @@ void mitk::FiberBundleMapper2D::SetDefaultProperties(mitk::DataNode* node, mitk:
     //add other parameters to propertylist
     node->AddProperty( "Fiber2DSliceThickness", mitk::FloatProperty::New(1.0f), renderer, overwrite );
     node->AddProperty( "Fiber2DfadeEFX", mitk::BoolProperty::New(true), renderer, overwrite );
+    node->AddProperty( "Fiber2DMaxSegments", mitk::IntProperty::New(1000000), renderer, overwrite );
     node->AddProperty( "color", mitk::ColorProperty::New(1.0,1.0,1.0), renderer, overwrite);
 }
 
@@ -195,4 +373,5 @@ mitk::FiberBundleMapper2D::FBXLocalStorage::FBXLocalStorage()
 {
     m_PointActor = vtkSmartPointer<vtkActor>::New();
     m_FiberMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+    m_SliceThickness = -1;
 }
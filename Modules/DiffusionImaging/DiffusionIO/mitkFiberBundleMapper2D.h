@@ -71,7 +71,10 @@ public:
         /** \brief Point Mapper of a 2D render window. */
         vtkSmartPointer<vtkPolyDataMapper> m_FiberMapper;
         vtkSmartPointer<vtkPlane> m_SlicingPlane;  //needed later when optimized 2D mapper
-        vtkSmartPointer<vtkPolyData> m_SlicedResult; //might be depricated in optimized 2D mapper
+        /** \brief Fiber segments intersecting the slab around the current plane. */
+        vtkSmartPointer<vtkPolyData> m_SlicedResult;
+        /** \brief Slab thickness used for m_SlicedResult. */
+        float m_SliceThickness;
 
         /** \brief Timestamp of last update of stored data. */
         itk::TimeStamp m_LastUpdateTime;
@@ -97,6 +100,9 @@ protected:
 
     void UpdateShaderParameter(mitk::BaseRenderer*);
 
+    /** Runs of consecutive fiber segments within the slice thickness of the current plane, at most "Fiber2DMaxSegments" segments. */
+    vtkSmartPointer<vtkPolyData> GetSlabFibers(mitk::BaseRenderer*, float thickness);
+
 private:
     vtkSmartPointer<vtkLookupTable> m_lut;
 
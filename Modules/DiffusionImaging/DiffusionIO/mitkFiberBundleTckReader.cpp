@@ -29,11 +29,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itksys/SystemTools.hxx>
 #include <tinyxml.h>
 #include <vtkCleanPolyData.h>
-#include <mitkTrackvis.h>
+#include <mitkTractogramFile.h>
 #include <mitkCustomMimeType.h>
 #include "mitkDiffusionIOMimeTypes.h"
-#include <vtkTransformPolyDataFilter.h>
-#include <boost/lexical_cast.hpp>
 
 
 mitk::FiberBundleTckReader::FiberBundleTckReader()
@@ -69,88 +67,9 @@ std::vector<itk::SmartPointer<mitk::BaseData> > mitk::FiberBundleTckReader::Read
 
         if (ext==".tck")
         {
-            std::FILE* filePointer = std::fopen(filename.c_str(),"r+b");
-            std::string header = "";
-
-            bool header_end = false;
-            int count = 0;
-            while (!header_end)
-            {
-              char c;
-              count += std::fread(&c, 1, 1, filePointer);
-              header += c;
-              if (header.size() >= 3 && header.compare(header.size() - 3, 3, "END") == 0)
-                header_end = true;
-            }
-            MITK_INFO << "TCK Header:";
-            MITK_INFO << header;
-
-            int header_size = -1;
-            try
-            {
-                std::string delimiter = "file: . ";
-                size_t pos = 0;
-                pos = header.find(delimiter);
-                header.erase(0, pos + delimiter.length());
-                pos = header.find("\n");
-                header_size = boost::lexical_cast<int>(header.substr(0, pos));
-            }
-            catch(...)
-            {
-
-            }
-
-            if (header_size==-1)
-                mitkThrow() << "Could not parse header size from " << filename;
-            std::fseek ( filePointer , header_size , SEEK_SET );
-
-            MITK_INFO << "Reading TCK file";
-
-
-            vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-            vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-            vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-
-            float tmp[3];
-            count = 1;
-            int fiber_length = 0;
-            while (std::fread((char*)tmp, 1, 12, filePointer)==12)
-            {
-              if (std::isinf(tmp[0]) || std::isinf(tmp[1]) || std::isinf(tmp[1]))
-                break;
-              else if (std::isnan(tmp[0]) || std::isnan(tmp[1]) || std::isnan(tmp[2]))
-              {
-                count++;
-                fiber_length = 0;
-                vtkNewCells->InsertNextCell(container);
-                container = vtkSmartPointer<vtkPolyLine>::New();
-              }
-              else
-              {
-                fiber_length++;
-                vtkIdType id = vtkNewPoints->InsertNextPoint(tmp);
-                container->GetPointIds()->InsertNextId(id);
-              }
-            }
-
-            vtkSmartPointer<vtkPolyData> fiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-            fiberPolyData->SetPoints(vtkNewPoints);
-            fiberPolyData->SetLines(vtkNewCells);
-
-            // transform polydata from RAS (MRtrix) to LPS (MITK)
-            mitk::Geometry3D::Pointer geometry = mitk::Geometry3D::New();
-            vtkSmartPointer< vtkMatrix4x4 > matrix = vtkSmartPointer< vtkMatrix4x4 >::New();
-            matrix->Identity();
-            matrix->SetElement(0,0,-matrix->GetElement(0,0));
-            matrix->SetElement(1,1,-matrix->GetElement(1,1));
-            geometry->SetIndexToWorldTransformByVtkMatrix(matrix);
-
-            vtkSmartPointer<vtkTransformPolyDataFilter> transformFilter = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-            transformFilter->SetInputData(fiberPolyData);
-            transformFilter->SetTransform(geometry->GetVtkTransform());
-            transformFilter->Update();
-
-            FiberBundle::Pointer fib = FiberBundle::New(transformFilter->GetOutput());
+            // memory mapped; the points are converted from RAS (MRtrix) to LPS (MITK) by the reader
+            TractogramFileReader reader(filename);
+            FiberBundle::Pointer fib = reader.ReadFiberBundle();
             result.push_back(fib.GetPointer());
         }
 
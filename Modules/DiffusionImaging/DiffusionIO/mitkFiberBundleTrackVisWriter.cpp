@@ -18,7 +18,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkSmartPointer.h>
 #include <vtkCleanPolyData.h>
 #include <itksys/SystemTools.hxx>
-#include <mitkTrackvis.h>
+#include <mitkTractogramFile.h>
 #include <itkSize.h>
 #include <vtkFloatArray.h>
 #include <vtkCellData.h>
@@ -94,10 +94,7 @@ void mitk::FiberBundleTrackVisWriter::Write()
         bool lps = us::any_cast<bool>(options["Save in LPS space (if unchecked, use RAS)"]);
 
         MITK_INFO << "Writing fiber bundle as TRK";
-        TrackVisFiberReader trk;
-        trk.create(filename, input.GetPointer(), lps);
-        trk.writeHdr();
-        trk.append(input.GetPointer());
+        TractogramFileWriter::WriteFiberBundle(input.GetPointer(), filename, lps);
 
         setlocale(LC_ALL, currLocale.c_str());
         MITK_INFO << "Fiber bundle written";
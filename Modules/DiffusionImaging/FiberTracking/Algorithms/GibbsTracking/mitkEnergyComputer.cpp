@@ -131,6 +131,32 @@ void EnergyComputer::DrawRandomPosition(vnl_vector_fixed<float, 3>& R)
     R[2] = m_Spacing[2]*((float)(m_ActiveIndices[rh-1]/(m_Size[0]*m_Size[1]))    + m_RandGen->GetVariate());
 }
 
+void EnergyComputer::DrawRandomPosition(vnl_vector_fixed<float, 3>& R, int voxel, ItkRandGenType* randGen)
+{
+    R[0] = m_Spacing[0]*((float)(voxel % m_Size[0])  + randGen->GetVariate());
+    R[1] = m_Spacing[1]*((float)((voxel/m_Size[0]) % m_Size[1])  + randGen->GetVariate());
+    R[2] = m_Spacing[2]*((float)(voxel/(m_Size[0]*m_Size[1]))    + randGen->GetVariate());
+}
+
+int EnergyComputer::GetActiveVoxel(int i)
+{
+    return m_ActiveIndices[i];
+}
+
+float EnergyComputer::GetVoxelProbability(int voxel)
+{
+    return m_Mask->GetBufferPointer()[voxel];
+}
+
+vnl_vector_fixed<float, 3> EnergyComputer::GetVoxelCenter(int voxel)
+{
+    vnl_vector_fixed<float, 3> R;
+    R[0] = m_Spacing[0]*((float)(voxel % m_Size[0])  + 0.5);
+    R[1] = m_Spacing[1]*((float)((voxel/m_Size[0]) % m_Size[1])  + 0.5);
+    R[2] = m_Spacing[2]*((float)(voxel/(m_Size[0]*m_Size[1]))    + 0.5);
+    return R;
+}
+
 // return spatial probability of position
 float EnergyComputer::SpatProb(vnl_vector_fixed<float, 3> pos)
 {
@@ -43,6 +43,8 @@ public:
 
     // get random position inside mask
     void DrawRandomPosition(vnl_vector_fixed<float, 3>& R);
+    // get random position inside the given voxel
+    void DrawRandomPosition(vnl_vector_fixed<float, 3>& R, int voxel, ItkRandGenType* randGen);
 
     // external energy calculation
     virtual float ComputeExternalEnergy(vnl_vector_fixed<float, 3>& R, vnl_vector_fixed<float, 3>& N, Particle* dp) =0;
@@ -53,6 +55,9 @@ public:
     virtual float ComputeInternalEnergy(Particle *dp) = 0;
 
     int GetNumActiveVoxels();
+    int GetActiveVoxel(int i);                              // linear index of the i-th voxel inside mask
+    float GetVoxelProbability(int voxel);                   // spatial probability (mask value) of the voxel
+    vnl_vector_fixed<float, 3> GetVoxelCenter(int voxel);
 
 protected:
 
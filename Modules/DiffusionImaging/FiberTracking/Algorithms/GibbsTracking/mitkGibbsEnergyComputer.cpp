@@ -30,8 +30,10 @@ float GibbsEnergyComputer::EvaluateOdf(vnl_vector_fixed<float, 3>& pos, vnl_vect
     // rotate particle direction according to image rotation
     dir = m_RotationMatrix*dir;
 
-    // get interpolation for rotated direction
-    m_SphereInterpolator->getInterpolation(dir);
+    // get interpolation for rotated direction (lookup only, samplers may run concurrently)
+    const int lutIndex = m_SphereInterpolator->getLutIndex(dir);
+    const int* idx = &m_SphereInterpolator->indices[lutIndex];
+    const float* interpw = &m_SphereInterpolator->barycoords[lutIndex];
 
     // sample ODF values along particle direction
     for (int i=-sampleSteps; i <= sampleSteps;i++)
@@ -46,9 +48,9 @@ float GibbsEnergyComputer::EvaluateOdf(vnl_vector_fixed<float, 3>& pos, vnl_vect
             index[2] = floor(pos[2]/m_Spacing[2]);
             if (m_Image->GetLargestPossibleRegion().IsInside(index))
             {
-                result += (m_Image->GetPixel(index)[m_SphereInterpolator->idx[0]-1]*m_SphereInterpolator->interpw[0] +
-                       m_Image->GetPixel(index)[m_SphereInterpolator->idx[1]-1]*m_SphereInterpolator->interpw[1] +
-                       m_Image->GetPixel(index)[m_SphereInterpolator->idx[2]-1]* m_SphereInterpolator->interpw[2]);
+                result += (m_Image->GetPixel(index)[idx[0]-1]*interpw[0] +
+                       m_Image->GetPixel(index)[idx[1]-1]*interpw[1] +
+                       m_Image->GetPixel(index)[idx[2]-1]* interpw[2]);
             }
         }
         else    // use trilinear interpolation
@@ -72,51 +74,51 @@ float GibbsEnergyComputer::EvaluateOdf(vnl_vector_fixed<float, 3>& pos, vnl_vect
 
                 weight = (1-xfrac)*(1-yfrac)*(1-zfrac);
                 index[0] = xint; index[1] = yint; index[2] = zint;
-                result += (m_Image->GetPixel(index)[m_SphereInterpolator->idx[0]-1]*m_SphereInterpolator->interpw[0] +
-                       m_Image->GetPixel(index)[m_SphereInterpolator->idx[1]-1]*m_SphereInterpolator->interpw[1] +
-                       m_Image->GetPixel(index)[m_SphereInterpolator->idx[2]-1]* m_SphereInterpolator->interpw[2])*weight;
+                result += (m_Image->GetPixel(index)[idx[0]-1]*interpw[0] +
+                       m_Image->GetPixel(index)[idx[1]-1]*interpw[1] +
+                       m_Image->GetPixel(index)[idx[2]-1]* interpw[2])*weight;
 
                 weight = (xfrac)*(1-yfrac)*(1-zfrac);
                 index[0] = xint+1; index[1] = yint; index[2] = zint;
-                result += (m_Image->GetPixel(index)[m_SphereInterpolator->idx[0]-1]*m_SphereInterpolator->interpw[0] +
-                       m_Image->GetPixel(index)[m_SphereInterpolator->idx[1]-1]*m_SphereInterpolator->interpw[1] +
-                       m_Image->GetPixel(index)[m_SphereInterpolator->idx[2]-1]* m_SphereInterpolator->interpw[2])*weight;
+                result += (m_Image->GetPixel(index)[idx[0]-1]*interpw[0] +
+                       m_Image->GetPixel(index)[idx[1]-1]*interpw[1] +
+                       m_Image->GetPixel(index)[idx[2]-1]* interpw[2])*weight;
 
                 weight = (1-xfrac)*(yfrac)*(1-zfrac);
                 index[0] = xint; index[1] = yint+1; index[2] = zint;
-                result += (m_Image->GetPixel(index)[m_SphereInterpolator->idx[0]-1]*m_SphereInterpolator->interpw[0] +
-                       m_Image->GetPixel(index)[m_SphereInterpolator->idx[1]-1]*m_SphereInterpolator->interpw[1] +
-                       m_Image->GetPixel(index)[m_SphereInterpolator->idx[2]-1]* m_SphereInterpolator->interpw[2])*weight;
+                result += (m_Image->GetPixel(index)[idx[0]-1]*interpw[0] +
+                       m_Image->GetPixel(index)[idx[1]-1]*interpw[1] +
+                       m_Image->GetPixel(index)[idx[2]-1]* interpw[2])*weight;
 
                 weight = (1-xfrac)*(1-yfrac)*(zfrac);
                 index[0] = xint; index[1] = yint; index[2] = zint+1;
-                result += (m_Image->GetPixel(index)[m_SphereInterpolator->idx[0]-1]*m_SphereInterpolator->interpw[0] +
-                       m_Image->GetPixel(index)[m_SphereInterpolator->idx[1]-1]*m_SphereInterpolator->interpw[1] +
-                       m_Image->GetPixel(index)[m_SphereInterpolator->idx[2]-1]* m_SphereInterpolator->interpw[2])*weight;
+                result += (m_Image->GetPixel(index)[idx[0]-1]*interpw[0] +
+                       m_Image->GetPixel(index)[idx[1]-1]*interpw[1] +
+                       m_Image->GetPixel(index)[idx[2]-1]* interpw[2])*weight;
 
                 weight = (xfrac)*(yfrac)*(1-zfrac);
                 index[0] = xint+1; index[1] = yint+1; index[2] = zint;
-                result += (m_Image->GetPixel(index)[m_SphereInterpolator->idx[0]-1]*m_SphereInterpolator->interpw[0] +
-                       m_Image->GetPixel(index)[m_SphereInterpolator->idx[1]-1]*m_SphereInterpolator->interpw[1] +
-                       m_Image->GetPixel(index)[m_SphereInterpolator->idx[2]-1]* m_SphereInterpolator->interpw[2])*weight;
+                result += (m_Image->GetPixel(index)[idx[0]-1]*interpw[0] +
+                       m_Image->GetPixel(index)[idx[1]-1]*interpw[1] +
+                       m_Image->GetPixel(index)[idx[2]-1]* interpw[2])*weight;
 
                 weight = (1-xfrac)*(yfrac)*(zfrac);
                 index[0] = xint; index[1] = yint+1; index[2] = zint+1;
-                result += (m_Image->GetPixel(index)[m_SphereInterpolator->idx[0]-1]*m_SphereInterpolator->interpw[0] +
-                       m_Image->GetPixel(index)[m_SphereInterpolator->idx[1]-1]*m_SphereInterpolator->interpw[1] +
-                       m_Image->GetPixel(index)[m_SphereInterpolator->idx[2]-1]* m_SphereInterpolator->interpw[2])*weight;
+                result += (m_Image->GetPixel(index)[idx[0]-1]*interpw[0] +
+                       m_Image->GetPixel(index)[idx[1]-1]*interpw[1] +
+                       m_Image->GetPixel(index)[idx[2]-1]* interpw[2])*weight;
 
                 weight = (xfrac)*(1-yfrac)*(zfrac);
                 index[0] = xint+1; index[1] = yint; index[2] = zint+1;
-                result += (m_Image->GetPixel(index)[m_SphereInterpolator->idx[0]-1]*m_SphereInterpolator->interpw[0] +
-                       m_Image->GetPixel(index)[m_SphereInterpolator->idx[1]-1]*m_SphereInterpolator->interpw[1] +
-                       m_Image->GetPixel(index)[m_SphereInterpolator->idx[2]-1]* m_SphereInterpolator->interpw[2])*weight;
+                result += (m_Image->GetPixel(index)[idx[0]-1]*interpw[0] +
+                       m_Image->GetPixel(index)[idx[1]-1]*interpw[1] +
+                       m_Image->GetPixel(index)[idx[2]-1]* interpw[2])*weight;
 
                 weight = (xfrac)*(yfrac)*(zfrac);
                 index[0] = xint+1; index[1] = yint+1; index[2] = zint+1;
-                result += (m_Image->GetPixel(index)[m_SphereInterpolator->idx[0]-1]*m_SphereInterpolator->interpw[0] +
-                       m_Image->GetPixel(index)[m_SphereInterpolator->idx[1]-1]*m_SphereInterpolator->interpw[1] +
-                       m_Image->GetPixel(index)[m_SphereInterpolator->idx[2]-1]* m_SphereInterpolator->interpw[2])*weight;
+                result += (m_Image->GetPixel(index)[idx[0]-1]*interpw[0] +
+                       m_Image->GetPixel(index)[idx[1]-1]*interpw[1] +
+                       m_Image->GetPixel(index)[idx[2]-1]* interpw[2])*weight;
             }
         }
     }
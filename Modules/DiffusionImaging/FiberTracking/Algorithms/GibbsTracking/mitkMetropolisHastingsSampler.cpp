@@ -15,6 +15,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkMetropolisHastingsSampler.h"
+#include <algorithm>
 
 using namespace mitk;
 
@@ -31,6 +32,8 @@ MetropolisHastingsSampler::MetropolisHastingsSampler(ParticleGrid* grid, EnergyC
     , m_AcceptedProposals(0)
 {
     m_RandGen = randGen;
+    m_GridRandGen = randGen;
+    m_Block = nullptr;
     m_ParticleGrid = grid;
     m_EnergyComputer = enComp;
 
@@ -87,6 +90,98 @@ void MetropolisHastingsSampler::SetTemperature(float val)
     m_Density = exp(-m_ChempotParticle/m_InTemp);
 }
 
+void MetropolisHastingsSampler::SetBlock(ParticleGridBlock* block)
+{
+    m_Block = block;
+    if (m_Block==nullptr)
+    {
+        m_RandGen = m_GridRandGen;
+        return;
+    }
+
+    m_RandGen = m_Block->m_RandGen;
+    m_Block->m_NumParticles = 0;
+    vnl_vector_fixed<int, 3> cell;
+    for (cell[2]=m_Block->m_Start[2]; cell[2]<m_Block->m_End[2]; cell[2]++)
+        for (cell[1]=m_Block->m_Start[1]; cell[1]<m_Block->m_End[1]; cell[1]++)
+            for (cell[0]=m_Block->m_Start[0]; cell[0]<m_Block->m_End[0]; cell[0]++)
+                m_Block->m_NumParticles += m_ParticleGrid->GetNumParticlesInCell(cell);
+}
+
+int MetropolisHastingsSampler::GetNumParticles()
+{
+    if (m_Block==nullptr)
+        return m_ParticleGrid->m_NumParticles;
+    return m_Block->m_NumParticles;
+}
+
+// particle density of the birth proposals, a block only proposes its share of the mask
+float MetropolisHastingsSampler::GetDensity()
+{
+    if (m_Block==nullptr)
+        return m_Density;
+    return m_Density*m_Block->m_DensityFraction;
+}
+
+// ID of a random particle (of the block)
+int MetropolisHastingsSampler::DrawParticle()
+{
+    int pnum = m_RandGen->GetIntegerVariate()%GetNumParticles();
+    if (m_Block==nullptr)
+        return pnum;
+
+    vnl_vector_fixed<int, 3> cell;
+    for (cell[2]=m_Block->m_Start[2]; cell[2]<m_Block->m_End[2]; cell[2]++)
+        for (cell[1]=m_Block->m_Start[1]; cell[1]<m_Block->m_End[1]; cell[1]++)
+            for (cell[0]=m_Block->m_Start[0]; cell[0]<m_Block->m_End[0]; cell[0]++)
+            {
+                int n = m_ParticleGrid->GetNumParticlesInCell(cell);
+                if (pnum < n)
+                    return m_ParticleGrid->GetParticleInCell(cell, pnum);
+                pnum -= n;
+            }
+    return -1;
+}
+
+// random position inside mask (and inside the block)
+bool MetropolisHastingsSampler::DrawRandomPosition(vnl_vector_fixed<float, 3>& R)
+{
+    if (m_Block==nullptr)
+    {
+        m_EnergyComputer->DrawRandomPosition(R);
+        return true;
+    }
+    if (m_Block->m_Voxels.empty())
+        return false;
+
+    // the voxels at the border reach into the neighbouring blocks, positions outside of the block are redrawn
+    for (int tries=0; tries<100; tries++)
+    {
+        float r = m_RandGen->GetVariate()*m_Block->m_CumulatedProbability.back();
+        int i = std::upper_bound(m_Block->m_CumulatedProbability.begin(), m_Block->m_CumulatedProbability.end(), r) - m_Block->m_CumulatedProbability.begin();
+        i = std::min(i, (int)m_Block->m_Voxels.size()-1);
+        m_EnergyComputer->DrawRandomPosition(R, m_Block->m_Voxels[i], m_RandGen);
+        if (IsInBlock(R))
+            return true;
+    }
+    return false;
+}
+
+bool MetropolisHastingsSampler::IsInBlock(Particle* p)
+{
+    if (m_Block==nullptr)
+        return true;
+    return m_Block->Contains(m_ParticleGrid->GetCell(p));
+}
+
+bool MetropolisHastingsSampler::IsInBlock(const vnl_vector_fixed<float, 3>& R)
+{
+    if (m_Block==nullptr)
+        return true;
+    vnl_vector_fixed<int, 3> cell;
+    return m_ParticleGrid->GetCell(R, cell) && m_Block->Contains(cell);
+}
+
 // add small random number drawn from gaussian to each vector element
 void MetropolisHastingsSampler::DistortVector(float sigma, vnl_vector_fixed<float, 3>& vec)
 {
@@ -116,13 +211,17 @@ void MetropolisHastingsSampler::MakeProposal()
     {
         m_BirthTime.Start();
         vnl_vector_fixed<float, 3> R;
-        m_EnergyComputer->DrawRandomPosition(R);
+        if (!DrawRandomPosition(R))
+        {
+            m_BirthTime.Stop();
+            return;
+        }
         vnl_vector_fixed<float, 3> N = GetRandomDirection();
         Particle prop;
         prop.GetPos() = R;
         prop.GetDir() = N;
 
-        float prob =  m_Density * m_DeathProb /((m_BirthProb)*(m_ParticleGrid->m_NumParticles+1));
+        float prob =  GetDensity() * m_DeathProb /((m_BirthProb)*(GetNumParticles()+1));
 
         float ex_energy = m_EnergyComputer->ComputeExternalEnergy(R,N,nullptr);
         float in_energy = m_EnergyComputer->ComputeInternalEnergy(&prop);
@@ -135,6 +234,8 @@ void MetropolisHastingsSampler::MakeProposal()
             {
                 p->GetPos() = R;
                 p->GetDir() = N;
+                if (m_Block!=nullptr)
+                    m_Block->m_NumParticles++;
                 m_AcceptedProposals++;
             }
         }
@@ -144,20 +245,28 @@ void MetropolisHastingsSampler::MakeProposal()
     else if (randnum < m_BirthProb+m_DeathProb)
     {
         m_DeathTime.Start();
-        if (m_ParticleGrid->m_NumParticles > 0)
+        if (GetNumParticles() > 0)
         {
-            int pnum = m_RandGen->GetIntegerVariate()%m_ParticleGrid->m_NumParticles;
+            int pnum = DrawParticle();
             Particle *dp = m_ParticleGrid->GetParticle(pnum);
             if (dp->pID == -1 && dp->mID == -1)
             {
                 float ex_energy = m_EnergyComputer->ComputeExternalEnergy(dp->GetPos(),dp->GetDir(),dp);
                 float in_energy = m_EnergyComputer->ComputeInternalEnergy(dp);
 
-                float prob = m_ParticleGrid->m_NumParticles * (m_BirthProb) /(m_Density*m_DeathProb); //*SpatProb(dp->R);
+                float prob = GetNumParticles() * (m_BirthProb) /(GetDensity()*m_DeathProb); //*SpatProb(dp->R);
                 prob *= exp(-(in_energy/m_InTemp+ex_energy/m_ExTemp)) ;
                 if (prob > 1 || m_RandGen->GetVariate() < prob)
                 {
-                    m_ParticleGrid->RemoveParticle(pnum);
+                    if (m_Block!=nullptr)
+                    {
+                        // IDs must not change while other blocks are sampled
+                        m_ParticleGrid->DetachParticle(pnum);
+                        m_Block->m_DetachedParticles.push_back(pnum);
+                        m_Block->m_NumParticles--;
+                    }
+                    else
+                        m_ParticleGrid->RemoveParticle(pnum);
                     m_AcceptedProposals++;
                 }
             }
@@ -167,17 +276,21 @@ void MetropolisHastingsSampler::MakeProposal()
     // Shift Proposal
     else  if (randnum < m_BirthProb+m_DeathProb+m_ShiftProb)
     {
-        if (m_ParticleGrid->m_NumParticles > 0)
+        if (GetNumParticles() > 0)
         {
             m_ShiftTime.Start();
-            int pnum = m_RandGen->GetIntegerVariate()%m_ParticleGrid->m_NumParticles;
+            int pnum = DrawParticle();
             Particle *p =  m_ParticleGrid->GetParticle(pnum);
             Particle prop_p = *p;
 
             DistortVector(m_Sigma, prop_p.GetPos());
             DistortVector(m_Sigma/(2*m_ParticleLength), prop_p.GetDir());
             prop_p.GetDir().normalize();
-
+            if (!IsInBlock(prop_p.GetPos()))
+            {
+                m_ShiftTime.Stop();
+                return;
+            }
 
             float ex_energy = m_EnergyComputer->ComputeExternalEnergy(prop_p.GetPos(),prop_p.GetDir(),p)
                     - m_EnergyComputer->ComputeExternalEnergy(p->GetPos(),p->GetDir(),p);
@@ -203,10 +316,10 @@ void MetropolisHastingsSampler::MakeProposal()
     // Optimal Shift Proposal
     else  if (randnum < m_BirthProb+m_DeathProb+m_ShiftProb+m_OptShiftProb)
     {
-        if (m_ParticleGrid->m_NumParticles > 0)
+        if (GetNumParticles() > 0)
         {
             m_OptShiftTime.Start();
-            int pnum = m_RandGen->GetIntegerVariate()%m_ParticleGrid->m_NumParticles;
+            int pnum = DrawParticle();
             Particle *p =  m_ParticleGrid->GetParticle(pnum);
 
             bool no_proposal = false;
@@ -239,7 +352,7 @@ void MetropolisHastingsSampler::MakeProposal()
             else
                 no_proposal = true;
 
-            if (!no_proposal)
+            if (!no_proposal && IsInBlock(prop_p.GetPos()))
             {
                 float cos = dot_product(prop_p.GetDir(), p->GetDir());
                 float p_rev = exp(-((prop_p.GetPos()-p->GetPos()).squared_magnitude() + (1-cos*cos))*m_Gamma)/m_Z;
@@ -270,10 +383,10 @@ void MetropolisHastingsSampler::MakeProposal()
     // Connection Proposal
     else
     {
-        if (m_ParticleGrid->m_NumParticles > 0)
+        if (GetNumParticles() > 0)
         {
             m_ConnectionTime.Start();
-            int pnum = m_RandGen->GetIntegerVariate()%m_ParticleGrid->m_NumParticles;
+            int pnum = DrawParticle();
             Particle *p = m_ParticleGrid->GetParticle(pnum);
 
             EndPoint P;
@@ -331,6 +444,8 @@ void MetropolisHastingsSampler::RemoveAndSaveTrack(EndPoint P)
             if (Current.p->pID != -1)
             {
                 Next.p = m_ParticleGrid->GetParticle(Current.p->pID);
+                if (!IsInBlock(Next.p)) // connections leaving the block are kept
+                    break;
                 Current.p->pID = -1;
                 m_ParticleGrid->m_NumConnections--;
             }
@@ -340,6 +455,8 @@ void MetropolisHastingsSampler::RemoveAndSaveTrack(EndPoint P)
             if (Current.p->mID != -1)
             {
                 Next.p = m_ParticleGrid->GetParticle(Current.p->mID);
+                if (!IsInBlock(Next.p)) // connections leaving the block are kept
+                    break;
                 Current.p->mID = -1;
                 m_ParticleGrid->m_NumConnections--;
             }
@@ -458,7 +575,7 @@ void MetropolisHastingsSampler::ComputeEndPointProposalDistribution(EndPoint P)
     {
         Particle *p2 =  m_ParticleGrid->GetNextNeighbor();
         if (p2 == nullptr) break;
-        if (p!=p2 && p2->label == 0)
+        if (p!=p2 && p2->label == 0 && IsInBlock(p2))
         {
             if (p2->mID == -1)
             {
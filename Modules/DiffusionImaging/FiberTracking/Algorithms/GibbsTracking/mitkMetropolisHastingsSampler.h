@@ -34,6 +34,35 @@ See LICENSE.txt or http://www.mitk.org for details.
 namespace mitk
 {
 
+/**
+* \brief Box of particle grid cells that is sampled independently of the other blocks of the same color.
+*
+* Blocks of the same color are separated by at least one block, which is wider than the reach of the energy
+* terms and of the connection proposals. Their proposals can therefore be made concurrently.   */
+
+struct MITKFIBERTRACKING_EXPORT ParticleGridBlock
+{
+    typedef itk::Statistics::MersenneTwisterRandomVariateGenerator ItkRandGenType;
+
+    vnl_vector_fixed< int, 3 >  m_Start;                ///< first cell of the block
+    vnl_vector_fixed< int, 3 >  m_End;                  ///< cell behind the last cell of the block
+    std::vector< int >          m_Voxels;               ///< mask voxels with their center inside of the block
+    std::vector< float >        m_CumulatedProbability; ///< cumulated spatial probability of these voxels
+    float                       m_DensityFraction;      ///< share of the spatial probability of the whole mask inside of the block
+    ItkRandGenType::Pointer     m_RandGen;              ///< random generator used for the proposals in this block
+    int                         m_NumProposals;         ///< number of proposals made in this block
+    int                         m_NumParticles;         ///< number of particles in the block, maintained by the sampler
+    std::vector< int >          m_DetachedParticles;    ///< particles that died, to be removed with ParticleGrid::CompactParticles()
+
+    bool Contains(const vnl_vector_fixed< int, 3 >& cell) const
+    {
+        for (int i=0; i<3; i++)
+            if (cell[i]<m_Start[i] || cell[i]>=m_End[i])
+                return false;
+        return true;
+    }
+};
+
 /**
 * \brief Generates ne proposals of particle configurations.   */
 
@@ -51,6 +80,7 @@ public:
     int GetNumAcceptedProposals();
     void SetProbabilities(float birth, float death, float shift, float optShift, float connect);    ///< update the probabilities of the single proposals
     void PrintProposalTimes();  ///< print the state of the proposal time probes
+    void SetBlock(ParticleGridBlock* block);    ///< restrict the proposals to the particles of the block (nullptr for the whole grid)
 
 protected:
 
@@ -60,11 +90,21 @@ protected:
     void MakeTrackProposal(EndPoint P);
     void ComputeEndPointProposalDistribution(EndPoint P);
 
+    /** particles and positions of the current block (or the whole grid) */
+    int GetNumParticles();
+    float GetDensity();
+    int DrawParticle();
+    bool DrawRandomPosition(vnl_vector_fixed<float, 3>& R);
+    bool IsInBlock(Particle* p);
+    bool IsInBlock(const vnl_vector_fixed<float, 3>& R);
+
     /** generate random vectors */
     void DistortVector(float sigma, vnl_vector_fixed<float, 3>& vec);
     vnl_vector_fixed<float, 3> GetRandomDirection();
 
     ItkRandGenType* m_RandGen;      ///< random generator
+    ItkRandGenType* m_GridRandGen;  ///< random generator used if no block is set
+    ParticleGridBlock* m_Block;     ///< block the proposals are restricted to
     Track       m_ProposalTrack;    ///< stores proposal track
     Track       m_BackupTrack;      ///< stores track removed for new proposal traCK
     SimpSamp    m_SimpSamp;         ///< neighbouring particles and their probabilities for the local tracking
@@ -18,6 +18,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkParticleGrid.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <algorithm>
+#include <functional>
+#include <omp.h>
 
 using namespace mitk;
 
@@ -46,15 +49,14 @@ ParticleGrid::ParticleGrid(ItkFloatImageType* image, float particleLength, int c
         throw std::bad_alloc();
 
     m_Particles.resize(m_ContainerCapacity);        // allocate and initialize particles
-    m_Grid.resize(gridSize, nullptr);   // allocate and initialize particle grid
+    m_Grid.resize(gridSize, -1);                    // allocate and initialize particle grid
     m_OccupationCount.resize(numCells, 0);          // allocate and initialize occupation counter array
-    m_NeighbourTracker.cellidx.resize(8, 0);        // allocate and initialize neighbour tracker
-    m_NeighbourTracker.cellidx_c.resize(8, 0);
+    m_NeighbourTrackers.resize(omp_get_max_threads());  // allocate neighbour trackers
 
     for (int i = 0;i < m_ContainerCapacity;i++)     // initialize particle IDs
         m_Particles[i].ID = i;
 
-    std::cout << "ParticleGrid: allocated " << (sizeof(Particle)*m_ContainerCapacity + sizeof(Particle*)*m_GridSize[0]*m_GridSize[1]*m_GridSize[2])/1048576 << "mb for " << m_ContainerCapacity/1000 << "k particles." << std::endl;
+    std::cout << "ParticleGrid: allocated " << (sizeof(Particle)*m_ContainerCapacity + sizeof(int)*gridSize)/1048576 << "mb for " << m_ContainerCapacity/1000 << "k particles." << std::endl;
 }
 
 ParticleGrid::~ParticleGrid()
@@ -72,45 +74,43 @@ void ParticleGrid::ResetGrid()
     m_Particles.clear();
     m_Grid.clear();
     m_OccupationCount.clear();
-    m_NeighbourTracker.cellidx.clear();
-    m_NeighbourTracker.cellidx_c.clear();
 
     int numCells = m_GridSize[0]*m_GridSize[1]*m_GridSize[2];   // number of grid cells
 
     m_Particles.resize(m_ContainerCapacity);        // allocate and initialize particles
-    m_Grid.resize(numCells*m_CellCapacity, nullptr);   // allocate and initialize particle grid
+    m_Grid.resize(numCells*m_CellCapacity, -1);     // allocate and initialize particle grid
     m_OccupationCount.resize(numCells, 0);          // allocate and initialize occupation counter array
-    m_NeighbourTracker.cellidx.resize(8, 0);        // allocate and initialize neighbour tracker
-    m_NeighbourTracker.cellidx_c.resize(8, 0);
 
     for (int i = 0;i < m_ContainerCapacity;i++)     // initialize particle IDs
         m_Particles[i].ID = i;
 }
 
-bool ParticleGrid::ReallocateGrid()
+bool ParticleGrid::ReallocateGrid(int newCapacity)
 {
-    int new_capacity = m_ContainerCapacity + 100000;    // increase container capacity by 100k particles
     try
     {
-        m_Particles.resize(new_capacity);                   // reallocate particles
+        m_Particles.resize(newCapacity);                    // reallocate particles (the grid stores IDs and stays valid)
 
-        for (int i = 0; i<m_ContainerCapacity; i++)         // update particle addresses (changed during reallocation)
-            m_Grid[m_Particles[i].gridindex] = &m_Particles[i];
-
-        for (int i = m_ContainerCapacity; i < new_capacity; i++)    // initialize IDs of ne particles
+        for (int i = m_ContainerCapacity; i < newCapacity; i++)    // initialize IDs of new particles
             m_Particles[i].ID = i;
 
-        m_ContainerCapacity = new_capacity;     // update member variable
-        //std::cout << "ParticleGrid: allocated " << (sizeof(Particle)*m_ContainerCapacity + sizeof(Particle*)*m_GridSize[0]*m_GridSize[1]*m_GridSize[2])/1048576 << "mb for " << m_ContainerCapacity/1000 << "k particles." << std::endl;
+        m_ContainerCapacity = newCapacity;      // update member variable
     }
     catch(...)
     {
-        std::cout << "ParticleGrid: allocation of " << (sizeof(Particle)*new_capacity + sizeof(Particle*)*m_GridSize[0]*m_GridSize[1]*m_GridSize[2])/1048576 << "mb for " << new_capacity/1000 << "k particles failed!" << std::endl;
+        std::cout << "ParticleGrid: allocation of " << (sizeof(Particle)*newCapacity + sizeof(int)*m_Grid.size())/1048576 << "mb for " << newCapacity/1000 << "k particles failed!" << std::endl;
         return false;
     }
     return true;
 }
 
+bool ParticleGrid::ReserveParticles(int numParticles)
+{
+    if (numParticles <= m_ContainerCapacity)
+        return true;
+    return ReallocateGrid(numParticles + 100000);
+}
+
 Particle* ParticleGrid::GetParticle(int ID)
 {
     if (ID!=-1)
@@ -118,12 +118,44 @@ Particle* ParticleGrid::GetParticle(int ID)
     return nullptr;
 }
 
+bool ParticleGrid::GetCell(const vnl_vector_fixed<float, 3>& R, vnl_vector_fixed<int, 3>& cell) const
+{
+    for (int i=0; i<3; i++)
+    {
+        if (R[i] < 0)
+            return false;
+        cell[i] = int(R[i]*m_GridScale[i]);
+        if (cell[i] >= m_GridSize[i])
+            return false;
+    }
+    return true;
+}
+
+vnl_vector_fixed<int, 3> ParticleGrid::GetCell(const Particle* p) const
+{
+    int idx = p->gridindex/m_CellCapacity;
+    vnl_vector_fixed<int, 3> cell;
+    cell[0] = idx % m_GridSize[0];
+    cell[1] = (idx / m_GridSize[0]) % m_GridSize[1];
+    cell[2] = idx / (m_GridSize[0]*m_GridSize[1]);
+    return cell;
+}
+
+int ParticleGrid::GetNumParticlesInCell(const vnl_vector_fixed<int, 3>& cell) const
+{
+    return m_OccupationCount[cell[0] + m_GridSize[0]*(cell[1] + m_GridSize[1]*cell[2])];
+}
+
+int ParticleGrid::GetParticleInCell(const vnl_vector_fixed<int, 3>& cell, int i) const
+{
+    return m_Grid[m_CellCapacity*(cell[0] + m_GridSize[0]*(cell[1] + m_GridSize[1]*cell[2])) + i];
+}
 
 Particle* ParticleGrid::NewParticle(vnl_vector_fixed<float, 3> R)
 {
     if (m_NumParticles >= m_ContainerCapacity)
     {
-        if (!ReallocateGrid())
+        if (!ReallocateGrid(m_ContainerCapacity + 100000))  // increase container capacity by 100k particles
             return nullptr;
     }
 
@@ -146,13 +178,12 @@ Particle* ParticleGrid::NewParticle(vnl_vector_fixed<float, 3> R)
     int idx = xint + m_GridSize[0]*(yint + m_GridSize[1]*zint);
     if (m_OccupationCount[idx] < m_CellCapacity)
     {
-        Particle *p = &(m_Particles[m_NumParticles]);
+        Particle *p = &(m_Particles[m_NumParticles++]);
         p->GetPos() = R;
         p->mID = -1;
         p->pID = -1;
-        m_NumParticles++;
         p->gridindex = m_CellCapacity*idx + m_OccupationCount[idx];
-        m_Grid[p->gridindex] = p;
+        m_Grid[p->gridindex] = p->ID;
         m_OccupationCount[idx]++;
         return p;
     }
@@ -193,12 +224,12 @@ bool ParticleGrid::TryUpdateGrid(int k)
             // remove from old position in grid;
             int grdindex = p->gridindex;
             m_Grid[grdindex] = m_Grid[cellidx*m_CellCapacity + m_OccupationCount[cellidx]-1];
-            m_Grid[grdindex]->gridindex = grdindex;
+            m_Particles[m_Grid[grdindex]].gridindex = grdindex;
             m_OccupationCount[cellidx]--;
 
             // insert at new position in grid
             p->gridindex = idx*m_CellCapacity + m_OccupationCount[idx];
-            m_Grid[p->gridindex] = p;
+            m_Grid[p->gridindex] = k;
             m_OccupationCount[idx]++;
             return true;
         }
@@ -214,9 +245,6 @@ bool ParticleGrid::TryUpdateGrid(int k)
 void ParticleGrid::RemoveParticle(int k)
 {
     Particle* p = &(m_Particles[k]);
-    int gridIndex = p->gridindex;
-    int cellIdx = gridIndex/m_CellCapacity;
-    int idx = gridIndex%m_CellCapacity;
 
     // remove pending connections
     if (p->mID != -1)
@@ -224,46 +252,78 @@ void ParticleGrid::RemoveParticle(int k)
     if (p->pID != -1)
         DestroyConnection(p,+1);
 
+    DetachParticle(k);
+    RemoveFromContainer(k);
+}
+
+void ParticleGrid::DetachParticle(int k)
+{
+    Particle* p = &(m_Particles[k]);
+    int gridIndex = p->gridindex;
+    int cellIdx = gridIndex/m_CellCapacity;
+    int idx = gridIndex%m_CellCapacity;
+
     // remove from grid
+    int last = cellIdx*m_CellCapacity+m_OccupationCount[cellIdx]-1;
     if (idx < m_OccupationCount[cellIdx]-1)
     {
-        m_Grid[gridIndex] = m_Grid[cellIdx*m_CellCapacity+m_OccupationCount[cellIdx]-1];
-        m_Grid[cellIdx*m_CellCapacity+m_OccupationCount[cellIdx]-1] = nullptr;
-        m_Grid[gridIndex]->gridindex = gridIndex;
+        m_Grid[gridIndex] = m_Grid[last];
+        m_Particles[m_Grid[gridIndex]].gridindex = gridIndex;
     }
+    m_Grid[last] = -1;
     m_OccupationCount[cellIdx]--;
+    p->gridindex = -1;
+}
 
-    // remove from container
+void ParticleGrid::RemoveFromContainer(int k)
+{
     if (k < m_NumParticles-1)
     {
-        Particle* last = &m_Particles[m_NumParticles-1];  // last particle
+        int lastID = m_NumParticles-1;
+        Particle* last = &m_Particles[lastID];  // last particle
 
         // update connections of last particle because its index is changing
         if (last->mID!=-1)
         {
-            if ( m_Particles[last->mID].mID == m_NumParticles-1 )
+            if ( m_Particles[last->mID].mID == lastID )
                 m_Particles[last->mID].mID = k;
-            else if ( m_Particles[last->mID].pID == m_NumParticles-1 )
+            else if ( m_Particles[last->mID].pID == lastID )
                 m_Particles[last->mID].pID = k;
         }
         if (last->pID!=-1)
         {
-            if ( m_Particles[last->pID].mID == m_NumParticles-1 )
+            if ( m_Particles[last->pID].mID == lastID )
                 m_Particles[last->pID].mID = k;
-            else if ( m_Particles[last->pID].pID == m_NumParticles-1 )
+            else if ( m_Particles[last->pID].pID == lastID )
                 m_Particles[last->pID].pID = k;
         }
 
-        m_Particles[k] = m_Particles[m_NumParticles-1];         // move very last particle to empty slot
-        m_Particles[m_NumParticles-1].ID = m_NumParticles-1;    // update ID of removed particle to match the index
-        m_Particles[k].ID = k;                                  // update ID of moved particle
-        m_Grid[m_Particles[k].gridindex] = &m_Particles[k];     // update address of moved particle
+        m_Particles[k] = m_Particles[lastID];           // move very last particle to empty slot
+        m_Particles[lastID].ID = lastID;                // update ID of removed particle to match the index
+        m_Particles[k].ID = k;                          // update ID of moved particle
+        m_Grid[m_Particles[k].gridindex] = k;           // update grid entry of moved particle
     }
     m_NumParticles--;
 }
 
+void ParticleGrid::CompactParticles(std::vector< int >& detached)
+{
+    // descending order guarantees that the last particle of the container is never a detached one
+    std::sort(detached.begin(), detached.end(), std::greater< int >());
+    for (int k : detached)
+        RemoveFromContainer(k);
+    detached.clear();
+}
+
+ParticleGrid::NeighborTracker& ParticleGrid::GetNeighborTracker()
+{
+    return m_NeighbourTrackers[omp_get_thread_num() % m_NeighbourTrackers.size()];
+}
+
 void ParticleGrid::ComputeNeighbors(vnl_vector_fixed<float, 3> &R)
 {
+    NeighborTracker& tracker = GetNeighborTracker();
+
     float xfrac = R[0]*m_GridScale[0];
     float yfrac = R[1]*m_GridScale[1];
     float zfrac = R[2]*m_GridScale[2];
@@ -290,47 +350,42 @@ void ParticleGrid::ComputeNeighbors(vnl_vector_fixed<float, 3> &R)
     if (m_GridSize[2] <= 1) { dz = 0; } // Necessary with 2d images (bug 15416)
 
 
-    m_NeighbourTracker.cellidx[0] = xint + m_GridSize[0]*(yint+zint*m_GridSize[1]);
-    m_NeighbourTracker.cellidx[1] = m_NeighbourTracker.cellidx[0] + dx;
-    m_NeighbourTracker.cellidx[2] = m_NeighbourTracker.cellidx[1] + dy*m_GridSize[0];
-    m_NeighbourTracker.cellidx[3] = m_NeighbourTracker.cellidx[2] - dx;
-    m_NeighbourTracker.cellidx[4] = m_NeighbourTracker.cellidx[0] + dz*m_GridSize[0]*m_GridSize[1];
-    m_NeighbourTracker.cellidx[5] = m_NeighbourTracker.cellidx[4] + dx;
-    m_NeighbourTracker.cellidx[6] = m_NeighbourTracker.cellidx[5] + dy*m_GridSize[0];
-    m_NeighbourTracker.cellidx[7] = m_NeighbourTracker.cellidx[6] - dx;
+    tracker.cellidx[0] = xint + m_GridSize[0]*(yint+zint*m_GridSize[1]);
+    tracker.cellidx[1] = tracker.cellidx[0] + dx;
+    tracker.cellidx[2] = tracker.cellidx[1] + dy*m_GridSize[0];
+    tracker.cellidx[3] = tracker.cellidx[2] - dx;
+    tracker.cellidx[4] = tracker.cellidx[0] + dz*m_GridSize[0]*m_GridSize[1];
+    tracker.cellidx[5] = tracker.cellidx[4] + dx;
+    tracker.cellidx[6] = tracker.cellidx[5] + dy*m_GridSize[0];
+    tracker.cellidx[7] = tracker.cellidx[6] - dx;
 
+    for (int i=0; i<8; i++)
+        tracker.cellidx_c[i] = m_CellCapacity*tracker.cellidx[i];
 
-    m_NeighbourTracker.cellidx_c[0] = m_CellCapacity*m_NeighbourTracker.cellidx[0];
-    m_NeighbourTracker.cellidx_c[1] = m_CellCapacity*m_NeighbourTracker.cellidx[1];
-    m_NeighbourTracker.cellidx_c[2] = m_CellCapacity*m_NeighbourTracker.cellidx[2];
-    m_NeighbourTracker.cellidx_c[3] = m_CellCapacity*m_NeighbourTracker.cellidx[3];
-    m_NeighbourTracker.cellidx_c[4] = m_CellCapacity*m_NeighbourTracker.cellidx[4];
-    m_NeighbourTracker.cellidx_c[5] = m_CellCapacity*m_NeighbourTracker.cellidx[5];
-    m_NeighbourTracker.cellidx_c[6] = m_CellCapacity*m_NeighbourTracker.cellidx[6];
-    m_NeighbourTracker.cellidx_c[7] = m_CellCapacity*m_NeighbourTracker.cellidx[7];
-
-    m_NeighbourTracker.cellcnt = 0;
-    m_NeighbourTracker.pcnt = 0;
+    tracker.cellcnt = 0;
+    tracker.pcnt = 0;
 }
 
 Particle* ParticleGrid::GetNextNeighbor()
 {
-    if (m_NeighbourTracker.pcnt < m_OccupationCount[m_NeighbourTracker.cellidx[m_NeighbourTracker.cellcnt]])
+    NeighborTracker& tracker = GetNeighborTracker();
+
+    if (tracker.pcnt < m_OccupationCount[tracker.cellidx[tracker.cellcnt]])
     {
-        return m_Grid[m_NeighbourTracker.cellidx_c[m_NeighbourTracker.cellcnt] + (m_NeighbourTracker.pcnt++)];
+        return &m_Particles[m_Grid[tracker.cellidx_c[tracker.cellcnt] + (tracker.pcnt++)]];
     }
     else
     {
         for(;;)
         {
-            m_NeighbourTracker.cellcnt++;
-            if (m_NeighbourTracker.cellcnt >= 8)
+            tracker.cellcnt++;
+            if (tracker.cellcnt >= 8)
                 return nullptr;
-            if (m_OccupationCount[m_NeighbourTracker.cellidx[m_NeighbourTracker.cellcnt]] > 0)
+            if (m_OccupationCount[tracker.cellidx[tracker.cellcnt]] > 0)
                 break;
         }
-        m_NeighbourTracker.pcnt = 1;
-        return m_Grid[m_NeighbourTracker.cellidx_c[m_NeighbourTracker.cellcnt]];
+        tracker.pcnt = 1;
+        return &m_Particles[m_Grid[tracker.cellidx_c[tracker.cellcnt]]];
     }
 }
 
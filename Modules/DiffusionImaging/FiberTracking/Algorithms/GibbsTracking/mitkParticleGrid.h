@@ -24,11 +24,17 @@ See LICENSE.txt or http://www.mitk.org for details.
 // ITK
 #include <itkImage.h>
 
+#include <atomic>
+
 namespace mitk
 {
 
 /**
-* \brief Contains and manages particles.   */
+* \brief Contains and manages particles.
+*
+* The grid cells store the IDs of their particles, so the particle container can be reallocated without
+* updating the grid. Neighbourhood queries use one NeighborTracker per thread, which allows several samplers
+* to work on disjoint blocks of the grid concurrently (see MetropolisHastingsSampler::SetBlock). */
 
 class MITKFIBERTRACKING_EXPORT ParticleGrid
 {
@@ -37,9 +43,17 @@ public:
 
     typedef itk::Image< float, 3 >  ItkFloatImageType;
 
-    int m_NumParticles;         // number of particles
-    int m_NumConnections;       // number of connections
-    int m_NumCellOverflows;     // number of cell overflows
+    struct NeighborTracker  // to run over the neighbors
+    {
+        int cellidx[8];
+        int cellidx_c[8];
+        int cellcnt;
+        int pcnt;
+    };
+
+    std::atomic< int > m_NumParticles;      // number of particles
+    std::atomic< int > m_NumConnections;    // number of connections
+    std::atomic< int > m_NumCellOverflows;  // number of cell overflows
     float m_ParticleLength;
 
     ParticleGrid(ItkFloatImageType* image, float particleLength, int cellCapacity);
@@ -51,9 +65,24 @@ public:
     bool TryUpdateGrid(int k);
     void RemoveParticle(int k);
 
+    /** Removes the unconnected particle from the grid but keeps it in the container until CompactParticles() is called. */
+    void DetachParticle(int k);
+    /** Removes the detached particles from the container. The IDs of other particles may change. */
+    void CompactParticles(std::vector< int >& detached);
+    /** Makes sure that the given number of particles fits into the container without reallocation. */
+    bool ReserveParticles(int numParticles);
+
     void ComputeNeighbors(vnl_vector_fixed<float, 3> &R);
     Particle* GetNextNeighbor();
 
+    /** Cell coordinates of a position, false if the position is outside of the grid. */
+    bool GetCell(const vnl_vector_fixed<float, 3>& R, vnl_vector_fixed<int, 3>& cell) const;
+    /** Cell coordinates of a particle in the grid. */
+    vnl_vector_fixed<int, 3> GetCell(const Particle* p) const;
+    int GetNumParticlesInCell(const vnl_vector_fixed<int, 3>& cell) const;
+    int GetParticleInCell(const vnl_vector_fixed<int, 3>& cell, int i) const;
+    const vnl_vector_fixed< int, 3 >& GetGridSize() const { return m_GridSize; }
+
     void CreateConnection(Particle *P1,int ep1, Particle *P2, int ep2);
     void DestroyConnection(Particle *P1,int ep1, Particle *P2, int ep2);
     void DestroyConnection(Particle *P1,int ep1);
@@ -63,9 +92,11 @@ public:
 
 protected:
 
-    bool ReallocateGrid();
+    bool ReallocateGrid(int newCapacity);
+    void RemoveFromContainer(int k);
+    NeighborTracker& GetNeighborTracker();
 
-    std::vector< Particle* >    m_Grid;             // the grid
+    std::vector< int >          m_Grid;             // the grid (particle IDs)
     std::vector< Particle >     m_Particles;        // particle container
     std::vector< int >          m_OccupationCount;  // number of particles per grid cell
 
@@ -76,13 +107,7 @@ protected:
 
     int m_CellCapacity;      // particle capacity of single cell in grid
 
-    struct NeighborTracker  // to run over the neighbors
-    {
-        std::vector< int > cellidx;
-        std::vector< int > cellidx_c;
-        int cellcnt;
-        int pcnt;
-    } m_NeighbourTracker;
+    std::vector< NeighborTracker > m_NeighbourTrackers; // one per thread
 
 };
 
@@ -56,7 +56,8 @@ public:
 
     ~SphereInterpolator();
 
-    inline void getInterpolation(const vnl_vector_fixed<float, 3>& N)
+    /** Offset of the three vertex indices and barycentric weights of the direction in the lookup tables. Does not change the interpolator, so it can be used by several threads. */
+    inline int getLutIndex(const vnl_vector_fixed<float, 3>& N) const
     {
         float nx = N[0];
         float ny = N[1];
@@ -66,82 +67,51 @@ public:
         {
             int x = float2int(nx);
             int y = float2int(ny);
-            int i = 3*6*(x+y*size);  // (:,1,x,y)
-            idx[0] = indices[i];
-            idx[1] = indices[i+1];
-            idx[2] = indices[i+2];
-            interpw[0] = barycoords[i];
-            interpw[1] = barycoords[i+1];
-            interpw[2] = barycoords[i+2];
-            return;
+            return 3*6*(x+y*size);  // (:,1,x,y)
         }
         if (nz < -0.5)
         {
             int x = float2int(nx);
             int y = float2int(ny);
-            int i = 3*(1+6*(x+y*size));  // (:,2,x,y)
-            idx[0] = indices[i];
-            idx[1] = indices[i+1];
-            idx[2] = indices[i+2];
-            interpw[0] = barycoords[i];
-            interpw[1] = barycoords[i+1];
-            interpw[2] = barycoords[i+2];
-            return;
+            return 3*(1+6*(x+y*size));  // (:,2,x,y)
         }
         if (nx > 0.5)
         {
             int z = float2int(nz);
             int y = float2int(ny);
-            int i = 3*(2+6*(z+y*size));  // (:,2,x,y)
-            idx[0] = indices[i];
-            idx[1] = indices[i+1];
-            idx[2] = indices[i+2];
-            interpw[0] = barycoords[i];
-            interpw[1] = barycoords[i+1];
-            interpw[2] = barycoords[i+2];
-            return;
+            return 3*(2+6*(z+y*size));  // (:,2,x,y)
         }
         if (nx < -0.5)
         {
             int z = float2int(nz);
             int y = float2int(ny);
-            int i = 3*(3+6*(z+y*size));  // (:,2,x,y)
-            idx[0] = indices[i];
-            idx[1] = indices[i+1];
-            idx[2] = indices[i+2];
-            interpw[0] = barycoords[i];
-            interpw[1] = barycoords[i+1];
-            interpw[2] = barycoords[i+2];
-            return;
+            return 3*(3+6*(z+y*size));  // (:,2,x,y)
         }
         if (ny > 0)
         {
             int x = float2int(nx);
             int z = float2int(nz);
-            int i = 3*(4+6*(x+z*size));  // (:,1,x,y)
-            idx[0] = indices[i];
-            idx[1] = indices[i+1];
-            idx[2] = indices[i+2];
-            interpw[0] = barycoords[i];
-            interpw[1] = barycoords[i+1];
-            interpw[2] = barycoords[i+2];
-            return;
+            return 3*(4+6*(x+z*size));  // (:,1,x,y)
         }
         else
         {
             int x = float2int(nx);
             int z = float2int(nz);
-            int i = 3*(5+6*(x+z*size));  // (:,1,x,y)
-            idx[0] = indices[i];
-            idx[1] = indices[i+1];
-            idx[2] = indices[i+2];
-            interpw[0] = barycoords[i];
-            interpw[1] = barycoords[i+1];
-            interpw[2] = barycoords[i+2];
-            return;
+            return 3*(5+6*(x+z*size));  // (:,1,x,y)
         }
     }
 
+    inline void getInterpolation(const vnl_vector_fixed<float, 3>& N)
+    {
+        int i = getLutIndex(N);
+        idx[0] = indices[i];
+        idx[1] = indices[i+1];
+        idx[2] = indices[i+2];
+        interpw[0] = barycoords[i];
+        interpw[1] = barycoords[i+1];
+        interpw[2] = barycoords[i+2];
+    }
+
 protected:
 
     bool LoadLookuptables(const string& lutPath);
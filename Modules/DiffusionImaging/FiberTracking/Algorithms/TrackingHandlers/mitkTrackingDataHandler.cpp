@@ -15,6 +15,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkTrackingDataHandler.h"
+#include <omp.h>
 
 namespace mitk
 {
@@ -25,7 +26,30 @@ namespace mitk
         , m_FlipY(false)
         , m_FlipZ(false)
         , m_Mode(MODE::DETERMINISTIC)
+        , m_RandomSeed(0)
+        , m_Rngs(1)
     {
 
     }
+
+    void TrackingDataHandler::InitRandomStreams(unsigned int seed)
+    {
+        m_RandomSeed = seed;
+        m_Rngs.assign(omp_get_max_threads(), BoostRngType(seed));
+    }
+
+    void TrackingDataHandler::SetRandomStream(unsigned long key)
+    {
+        // splitmix64 finalizer, decorrelates the streams of neighbouring keys
+        unsigned long long z = (static_cast<unsigned long long>(m_RandomSeed) << 32) + key + 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z = z ^ (z >> 31);
+        GetRng().seed(static_cast<BoostRngType::result_type>(z ^ (z >> 32)));
+    }
+
+    TrackingDataHandler::BoostRngType& TrackingDataHandler::GetRng()
+    {
+        return m_Rngs[omp_get_thread_num() % m_Rngs.size()];
+    }
 }
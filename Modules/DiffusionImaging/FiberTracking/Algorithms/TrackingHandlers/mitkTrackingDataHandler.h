@@ -21,6 +21,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkPoint.h>
 #include <itkImage.h>
 #include <deque>
+#include <vector>
 #include <MitkFiberTrackingExports.h>
 #include <boost/random/discrete_distribution.hpp>
 #include <boost/random/variate_generator.hpp>
@@ -68,6 +69,13 @@ public:
     void SetFlipY( bool f ){ m_FlipY = f; }
     void SetFlipZ( bool f ){ m_FlipZ = f; }
 
+    /** Creates one random number stream per thread. Call before tracking. */
+    void InitRandomStreams(unsigned int seed);
+    /** Restarts the random number stream of the calling thread. The stream only depends on the seed and the given key, e.g. the index of the seed point, so the tracking result does not depend on the number of threads. */
+    void SetRandomStream(unsigned long key);
+    BoostRngType& GetRng();     ///< random number generator of the calling thread
+    unsigned int GetRandomSeed() const { return m_RandomSeed; }
+
 protected:
 
     float           m_AngularThreshold;
@@ -76,23 +84,34 @@ protected:
     bool            m_FlipY;
     bool            m_FlipZ;
     MODE            m_Mode;
-    BoostRngType    m_Rng;
+    unsigned int                m_RandomSeed;
+    std::vector< BoostRngType > m_Rngs;
+
+    /** Nearest voxel, trilinear interpolation weights and buffer offsets of the eight neighbouring voxels of a position. Computed once per position and reused for all images with the same geometry. */
+    struct InterpolationStencil
+    {
+      itk::Index<3>               Index;          ///< nearest voxel
+      itk::OffsetValueType        IndexOffset;    ///< buffer offset of the nearest voxel
+      bool                        Inside;         ///< nearest voxel is inside of the image
+      bool                        Interpolate;    ///< all eight neighbours are inside of the image
+      itk::OffsetValueType        Offsets[8];
+      vnl_vector_fixed<float, 8>  Weights;
+    };
 
-    template< class TPixelType >
-    TPixelType GetImageValue(itk::Point<float, 3> itkP, itk::Image<TPixelType, 3>* image, vnl_vector_fixed<float, 8>& interpWeights){
+    template< class TImageType >
+    static void GetInterpolationStencil(const itk::Point<float, 3>& itkP, const TImageType* image, InterpolationStencil& stencil){
       // transform physical point to index coordinates
       itk::Index<3> idx;
       itk::ContinuousIndex< float, 3> cIdx;
       image->TransformPhysicalPointToIndex(itkP, idx);
       image->TransformPhysicalPointToContinuousIndex(itkP, cIdx);
 
-      TPixelType pix = 0.0;
-      if ( image->GetLargestPossibleRegion().IsInside(idx) )
-      {
-        pix = image->GetPixel(idx);
-      }
-      else
-        return pix;
+      stencil.Index = idx;
+      stencil.Inside = image->GetLargestPossibleRegion().IsInside(idx);
+      stencil.Interpolate = false;
+      if (!stencil.Inside)
+        return;
+      stencil.IndexOffset = image->ComputeOffset(idx);
 
       float frac_x = cIdx[0] - idx[0];
       float frac_y = cIdx[1] - idx[1];
@@ -117,11 +136,14 @@ protected:
       frac_z = 1-frac_z;
 
       // int coordinates inside image?
-      if (idx[0] >= 0 && idx[0] < image->GetLargestPossibleRegion().GetSize(0)-1 &&
-          idx[1] >= 0 && idx[1] < image->GetLargestPossibleRegion().GetSize(1)-1 &&
-          idx[2] >= 0 && idx[2] < image->GetLargestPossibleRegion().GetSize(2)-1)
+      if (idx[0] >= 0 && idx[0] < static_cast<itk::IndexValueType>(image->GetLargestPossibleRegion().GetSize(0) - 1) &&
+          idx[1] >= 0 && idx[1] < static_cast<itk::IndexValueType>(image->GetLargestPossibleRegion().GetSize(1) - 1) &&
+          idx[2] >= 0 && idx[2] < static_cast<itk::IndexValueType>(image->GetLargestPossibleRegion().GetSize(2) - 1))
       {
+        stencil.Interpolate = true;
+
         // trilinear interpolation
+        vnl_vector_fixed<float, 8>& interpWeights = stencil.Weights;
         interpWeights[0] = (  frac_x)*(  frac_y)*(  frac_z);
         interpWeights[1] = (1-frac_x)*(  frac_y)*(  frac_z);
         interpWeights[2] = (  frac_x)*(1-frac_y)*(  frac_z);
@@ -131,114 +153,38 @@ protected:
         interpWeights[6] = (1-frac_x)*(  frac_y)*(1-frac_z);
         interpWeights[7] = (1-frac_x)*(1-frac_y)*(1-frac_z);
 
-        pix = image->GetPixel(idx) * interpWeights[0];
-
-        typename itk::Image<TPixelType, 3>::IndexType tmpIdx = idx; tmpIdx[0]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[1];
-
-        tmpIdx = idx; tmpIdx[1]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[2];
-
-        tmpIdx = idx; tmpIdx[2]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[3];
-
-        tmpIdx = idx; tmpIdx[0]++; tmpIdx[1]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[4];
-
-        tmpIdx = idx; tmpIdx[1]++; tmpIdx[2]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[5];
-
-        tmpIdx = idx; tmpIdx[2]++; tmpIdx[0]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[6];
-
-        tmpIdx = idx; tmpIdx[0]++; tmpIdx[1]++; tmpIdx[2]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[7];
+        const itk::OffsetValueType* offsetTable = image->GetOffsetTable();
+        const itk::OffsetValueType o = image->ComputeOffset(idx);
+        const itk::OffsetValueType dx = 1;
+        const itk::OffsetValueType dy = offsetTable[1];
+        const itk::OffsetValueType dz = offsetTable[2];
+        stencil.Offsets[0] = o;
+        stencil.Offsets[1] = o + dx;
+        stencil.Offsets[2] = o + dy;
+        stencil.Offsets[3] = o + dz;
+        stencil.Offsets[4] = o + dx + dy;
+        stencil.Offsets[5] = o + dy + dz;
+        stencil.Offsets[6] = o + dz + dx;
+        stencil.Offsets[7] = o + dx + dy + dz;
       }
-
-      if (pix!=pix)
-        mitkThrow() << "nan values in image!";
-
-      return pix;
     }
 
     template< class TPixelType >
-    TPixelType GetImageValue(itk::Point<float, 3> itkP, itk::Image<TPixelType, 3>* image, bool interpolate){
-      // transform physical point to index coordinates
-      itk::Index<3> idx;
-      itk::ContinuousIndex< float, 3> cIdx;
-      image->TransformPhysicalPointToIndex(itkP, idx);
-      image->TransformPhysicalPointToContinuousIndex(itkP, cIdx);
-
+    static TPixelType GetImageValue(const InterpolationStencil& stencil, const itk::Image<TPixelType, 3>* image, bool interpolate){
       TPixelType pix = 0.0;
-      if ( image->GetLargestPossibleRegion().IsInside(idx) )
-      {
-        pix = image->GetPixel(idx);
-        if (!interpolate)
-          return pix;
-      }
-      else
+      if (!stencil.Inside)
         return pix;
 
-      float frac_x = cIdx[0] - idx[0];
-      float frac_y = cIdx[1] - idx[1];
-      float frac_z = cIdx[2] - idx[2];
-      if (frac_x<0)
-      {
-        idx[0] -= 1;
-        frac_x += 1;
-      }
-      if (frac_y<0)
-      {
-        idx[1] -= 1;
-        frac_y += 1;
-      }
-      if (frac_z<0)
-      {
-        idx[2] -= 1;
-        frac_z += 1;
-      }
-      frac_x = 1-frac_x;
-      frac_y = 1-frac_y;
-      frac_z = 1-frac_z;
+      const TPixelType* buffer = image->GetBufferPointer();
+      pix = buffer[stencil.IndexOffset];
+      if (!interpolate)
+        return pix;
 
-      // int coordinates inside image?
-      if (idx[0] >= 0 && idx[0] < static_cast<itk::IndexValueType>(image->GetLargestPossibleRegion().GetSize(0) - 1) &&
-          idx[1] >= 0 && idx[1] < static_cast<itk::IndexValueType>(image->GetLargestPossibleRegion().GetSize(1) - 1) &&
-          idx[2] >= 0 && idx[2] < static_cast<itk::IndexValueType>(image->GetLargestPossibleRegion().GetSize(2) - 1))
+      if (stencil.Interpolate)
       {
-        // trilinear interpolation
-        vnl_vector_fixed<float, 8> interpWeights;
-        interpWeights[0] = (  frac_x)*(  frac_y)*(  frac_z);
-        interpWeights[1] = (1-frac_x)*(  frac_y)*(  frac_z);
-        interpWeights[2] = (  frac_x)*(1-frac_y)*(  frac_z);
-        interpWeights[3] = (  frac_x)*(  frac_y)*(1-frac_z);
-        interpWeights[4] = (1-frac_x)*(1-frac_y)*(  frac_z);
-        interpWeights[5] = (  frac_x)*(1-frac_y)*(1-frac_z);
-        interpWeights[6] = (1-frac_x)*(  frac_y)*(1-frac_z);
-        interpWeights[7] = (1-frac_x)*(1-frac_y)*(1-frac_z);
-
-        pix = image->GetPixel(idx) * interpWeights[0];
-
-        typename itk::Image<TPixelType, 3>::IndexType tmpIdx = idx; tmpIdx[0]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[1];
-
-        tmpIdx = idx; tmpIdx[1]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[2];
-
-        tmpIdx = idx; tmpIdx[2]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[3];
-
-        tmpIdx = idx; tmpIdx[0]++; tmpIdx[1]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[4];
-
-        tmpIdx = idx; tmpIdx[1]++; tmpIdx[2]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[5];
-
-        tmpIdx = idx; tmpIdx[2]++; tmpIdx[0]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[6];
-
-        tmpIdx = idx; tmpIdx[0]++; tmpIdx[1]++; tmpIdx[2]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[7];
+        pix = buffer[stencil.Offsets[0]] * stencil.Weights[0];
+        for (int c=1; c<8; c++)
+          pix += buffer[stencil.Offsets[c]] * stencil.Weights[c];
       }
 
       if (pix!=pix)
@@ -247,84 +193,29 @@ protected:
       return pix;
     }
 
+    /** The components of the eight neighbours are accumulated in place, so the inner loop runs over contiguous memory and can be vectorized. */
     template< class TPixelType, int components >
-    itk::Vector< TPixelType, components > GetImageValue(itk::Point<float, 3> itkP, itk::Image<itk::Vector< TPixelType, components >, 3>* image, bool interpolate){
-      // transform physical point to index coordinates
-      itk::Index<3> idx;
-      itk::ContinuousIndex< float, 3> cIdx;
-      image->TransformPhysicalPointToIndex(itkP, idx);
-      image->TransformPhysicalPointToContinuousIndex(itkP, cIdx);
-
+    static itk::Vector< TPixelType, components > GetImageValue(const InterpolationStencil& stencil, const itk::Image<itk::Vector< TPixelType, components >, 3>* image, bool interpolate){
       itk::Vector< TPixelType, components > pix = 0.0;
-      if ( image->GetLargestPossibleRegion().IsInside(idx) )
-      {
-        pix = image->GetPixel(idx);
-        if (!interpolate)
-          return pix;
-      }
-      else
+      if (!stencil.Inside)
         return pix;
 
-      float frac_x = cIdx[0] - idx[0];
-      float frac_y = cIdx[1] - idx[1];
-      float frac_z = cIdx[2] - idx[2];
-      if (frac_x<0)
-      {
-        idx[0] -= 1;
-        frac_x += 1;
-      }
-      if (frac_y<0)
-      {
-        idx[1] -= 1;
-        frac_y += 1;
-      }
-      if (frac_z<0)
-      {
-        idx[2] -= 1;
-        frac_z += 1;
-      }
-      frac_x = 1-frac_x;
-      frac_y = 1-frac_y;
-      frac_z = 1-frac_z;
+      const itk::Vector< TPixelType, components >* buffer = image->GetBufferPointer();
+      pix = buffer[stencil.IndexOffset];
+      if (!interpolate)
+        return pix;
 
-      // int coordinates inside image?
-      if (idx[0] >= 0 && idx[0] < static_cast<itk::IndexValueType>(image->GetLargestPossibleRegion().GetSize(0) - 1) &&
-          idx[1] >= 0 && idx[1] < static_cast<itk::IndexValueType>(image->GetLargestPossibleRegion().GetSize(1) - 1) &&
-          idx[2] >= 0 && idx[2] < static_cast<itk::IndexValueType>(image->GetLargestPossibleRegion().GetSize(2) - 1))
+      if (stencil.Interpolate)
       {
-        // trilinear interpolation
-        vnl_vector_fixed<float, 8> interpWeights;
-        interpWeights[0] = (  frac_x)*(  frac_y)*(  frac_z);
-        interpWeights[1] = (1-frac_x)*(  frac_y)*(  frac_z);
-        interpWeights[2] = (  frac_x)*(1-frac_y)*(  frac_z);
-        interpWeights[3] = (  frac_x)*(  frac_y)*(1-frac_z);
-        interpWeights[4] = (1-frac_x)*(1-frac_y)*(  frac_z);
-        interpWeights[5] = (  frac_x)*(1-frac_y)*(1-frac_z);
-        interpWeights[6] = (1-frac_x)*(  frac_y)*(1-frac_z);
-        interpWeights[7] = (1-frac_x)*(1-frac_y)*(1-frac_z);
-
-        pix = image->GetPixel(idx) * interpWeights[0];
-
-        typename itk::Image<itk::Vector< TPixelType, components >, 3>::IndexType tmpIdx = idx; tmpIdx[0]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[1];
-
-        tmpIdx = idx; tmpIdx[1]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[2];
-
-        tmpIdx = idx; tmpIdx[2]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[3];
-
-        tmpIdx = idx; tmpIdx[0]++; tmpIdx[1]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[4];
-
-        tmpIdx = idx; tmpIdx[1]++; tmpIdx[2]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[5];
-
-        tmpIdx = idx; tmpIdx[2]++; tmpIdx[0]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[6];
-
-        tmpIdx = idx; tmpIdx[0]++; tmpIdx[1]++; tmpIdx[2]++;
-        pix +=  image->GetPixel(tmpIdx) * interpWeights[7];
+        pix.Fill(0.0);
+        TPixelType* out = pix.GetDataPointer();
+        for (int c=0; c<8; c++)
+        {
+          const TPixelType* in = buffer[stencil.Offsets[c]].GetDataPointer();
+          const TPixelType w = stencil.Weights[c];
+          for (int k=0; k<components; k++)
+            out[k] += in[k] * w;
+        }
       }
 
       if (pix!=pix)
@@ -333,6 +224,29 @@ protected:
       return pix;
     }
 
+    template< class TPixelType >
+    TPixelType GetImageValue(itk::Point<float, 3> itkP, itk::Image<TPixelType, 3>* image, vnl_vector_fixed<float, 8>& interpWeights){
+      InterpolationStencil stencil;
+      GetInterpolationStencil(itkP, image, stencil);
+      if (stencil.Interpolate)
+        interpWeights = stencil.Weights;
+      return GetImageValue<TPixelType>(stencil, image, true);
+    }
+
+    template< class TPixelType >
+    TPixelType GetImageValue(itk::Point<float, 3> itkP, itk::Image<TPixelType, 3>* image, bool interpolate){
+      InterpolationStencil stencil;
+      GetInterpolationStencil(itkP, image, stencil);
+      return GetImageValue<TPixelType>(stencil, image, interpolate);
+    }
+
+    template< class TPixelType, int components >
+    itk::Vector< TPixelType, components > GetImageValue(itk::Point<float, 3> itkP, itk::Image<itk::Vector< TPixelType, components >, 3>* image, bool interpolate){
+      InterpolationStencil stencil;
+      GetInterpolationStencil(itkP, image, stencil);
+      return GetImageValue<TPixelType, components>(stencil, image, interpolate);
+    }
+
 };
 
 }
@@ -27,6 +27,7 @@ TrackingHandlerOdf::TrackingHandlerOdf()
     , m_OdfPower(4)
     , m_SecondOrder(false)
     , m_MinMaxNormalize(true)
+    , m_GfaImageMatchesOdfImage(false)
 {
 
 }
@@ -66,6 +67,12 @@ void TrackingHandlerOdf::InitForTracking()
         m_GfaImage = gfaFilter->GetOutput();
     }
 
+    // the interpolation stencil of the ODF image can be reused for the GFA image if both share the voxel grid
+    m_GfaImageMatchesOdfImage = m_GfaImage->GetLargestPossibleRegion()==m_OdfImage->GetLargestPossibleRegion()
+            && m_GfaImage->GetSpacing()==m_OdfImage->GetSpacing()
+            && m_GfaImage->GetOrigin()==m_OdfImage->GetOrigin()
+            && m_GfaImage->GetDirection()==m_OdfImage->GetDirection();
+
     m_WorkingOdfImage = ItkOdfImageType::New();
     m_WorkingOdfImage->SetSpacing( m_OdfImage->GetSpacing() );
     m_WorkingOdfImage->SetOrigin( m_OdfImage->GetOrigin() );
@@ -188,13 +195,18 @@ vnl_vector_fixed<float,3> TrackingHandlerOdf::ProposeDirection(itk::Point<float,
 
     vnl_vector_fixed<float,3> output_direction; output_direction.fill(0);
 
-    itk::Index<3> idx;
-    m_WorkingOdfImage->TransformPhysicalPointToIndex(pos, idx);
+    InterpolationStencil stencil;
+    GetInterpolationStencil(pos, m_WorkingOdfImage.GetPointer(), stencil);
+    itk::Index<3> idx = stencil.Index;
 
-    if ( !m_WorkingOdfImage->GetLargestPossibleRegion().IsInside(idx) )
+    if ( !stencil.Inside )
         return output_direction;
 
-    float gfa = GetImageValue<float>(pos, m_GfaImage, m_Interpolate);
+    float gfa = 0;
+    if (m_GfaImageMatchesOdfImage)
+        gfa = GetImageValue<float>(stencil, m_GfaImage, m_Interpolate);
+    else
+        gfa = GetImageValue<float>(pos, m_GfaImage, m_Interpolate);
     if (gfa<m_GfaThreshold)
         return output_direction;
 
@@ -205,7 +217,7 @@ vnl_vector_fixed<float,3> TrackingHandlerOdf::ProposeDirection(itk::Point<float,
     if (!m_Interpolate && oldIndex==idx)
         return last_dir;
 
-    ItkOdfImageType::PixelType odf_values = GetImageValue<float, QBALL_ODFSIZE>(pos, m_WorkingOdfImage, m_Interpolate);
+    ItkOdfImageType::PixelType odf_values = GetImageValue<float, QBALL_ODFSIZE>(stencil, m_WorkingOdfImage, m_Interpolate);
 
     float max = 0;
     int max_idx_v = -1;
@@ -277,12 +289,8 @@ vnl_vector_fixed<float,3> TrackingHandlerOdf::ProposeDirection(itk::Point<float,
 
         boost::random::discrete_distribution<int, float> dist(probs.begin(), probs.end());
 
-        int sampled_idx = 0;
-#pragma omp critical
-        {
-            boost::random::variate_generator<boost::random::mt19937&, boost::random::discrete_distribution<int,float>> sampler(m_Rng, dist);
-            sampled_idx = sampler();
-        }
+        boost::random::variate_generator<boost::random::mt19937&, boost::random::discrete_distribution<int,float>> sampler(GetRng(), dist);
+        int sampled_idx = sampler();
         output_direction = m_OdfFloatDirs.get_row(sampled_idx);
         if (angles[sampled_idx]<0)                          // make sure we don't walk backwards
             output_direction *= -1;
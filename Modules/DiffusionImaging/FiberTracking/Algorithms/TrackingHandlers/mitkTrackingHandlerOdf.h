@@ -77,6 +77,7 @@ protected:
     int                             m_OdfPower;
     bool                            m_SecondOrder;
     bool                            m_MinMaxNormalize;
+    bool                            m_GfaImageMatchesOdfImage;
 
     std::vector< int >              m_OdfReducedIndices;
 };
@@ -22,6 +22,7 @@ namespace mitk
 TrackingHandlerPeaks::TrackingHandlerPeaks()
   : m_PeakThreshold(0.1)
   , m_ApplyDirectionMatrix(false)
+  , m_VolumeStride(0)
 {
 
 }
@@ -61,9 +62,10 @@ void TrackingHandlerPeaks::InitForTracking()
   m_DummyImage->FillBuffer(0.0);
 
   m_NumDirs = imageRegion4.GetSize(3)/3;
+  m_VolumeStride = m_PeakImage->GetOffsetTable()[3];
 }
 
-vnl_vector_fixed<float,3> TrackingHandlerPeaks::GetMatchingDirection(itk::Index<3> idx3, vnl_vector_fixed<float,3>& oldDir)
+vnl_vector_fixed<float,3> TrackingHandlerPeaks::GetMatchingDirection(itk::OffsetValueType offset, vnl_vector_fixed<float,3>& oldDir)
 {
   vnl_vector_fixed<float,3> out_dir; out_dir.fill(0);
   float angle = 0;
@@ -73,8 +75,8 @@ vnl_vector_fixed<float,3> TrackingHandlerPeaks::GetMatchingDirection(itk::Index<
     // try m_NumDirs times to get a non-zero random direction
     for (int j=0; j<m_NumDirs; j++)
     {
-      int i = std::rand()%m_NumDirs;
-      out_dir = GetDirection(idx3, i);
+      int i = GetRng()()%m_NumDirs;
+      out_dir = GetDirection(offset, i);
 
       if (out_dir.magnitude()>mitk::eps)
       {
@@ -88,7 +90,7 @@ vnl_vector_fixed<float,3> TrackingHandlerPeaks::GetMatchingDirection(itk::Index<
     // if you didn't find a non-zero random direction, take first non-zero direction you find
     for (int i=0; i<m_NumDirs; i++)
     {
-      out_dir = GetDirection(idx3, i);
+      out_dir = GetDirection(offset, i);
       if (out_dir.magnitude()>mitk::eps)
       {
         oldDir[0] = out_dir[0];
@@ -102,7 +104,7 @@ vnl_vector_fixed<float,3> TrackingHandlerPeaks::GetMatchingDirection(itk::Index<
   {
     for (int i=0; i<m_NumDirs; i++)
     {
-      vnl_vector_fixed<float,3> dir = GetDirection(idx3, i);
+      vnl_vector_fixed<float,3> dir = GetDirection(offset, i);
       mag = dir.magnitude();
       if (mag>mitk::eps)
         dir.normalize();
@@ -123,22 +125,14 @@ vnl_vector_fixed<float,3> TrackingHandlerPeaks::GetMatchingDirection(itk::Index<
   return out_dir;
 }
 
-vnl_vector_fixed<float,3> TrackingHandlerPeaks::GetDirection(itk::Index<3> idx3, int dirIdx)
+vnl_vector_fixed<float,3> TrackingHandlerPeaks::GetDirection(itk::OffsetValueType offset, int dirIdx)
 {
-  vnl_vector_fixed<float,3> dir; dir.fill(0.0);
-  if ( !m_DummyImage->GetLargestPossibleRegion().IsInside(idx3) )
-    return dir;
-
-  PeakImgType::IndexType idx4;
-  idx4.SetElement(0,idx3[0]);
-  idx4.SetElement(1,idx3[1]);
-  idx4.SetElement(2,idx3[2]);
-
-  for (int k=0; k<3; k++)
-  {
-    idx4.SetElement(3, dirIdx*3 + k);
-    dir[k] = m_PeakImage->GetPixel(idx4);
-  }
+  // the voxel offset in the 3D grid equals the offset of the first volume of the 4D peak image
+  const float* peak = m_PeakImage->GetBufferPointer() + offset + dirIdx*3*m_VolumeStride;
+  vnl_vector_fixed<float,3> dir;
+  dir[0] = peak[0];
+  dir[1] = peak[m_VolumeStride];
+  dir[2] = peak[2*m_VolumeStride];
 
   if (m_FlipX)
     dir[0] *= -1;
@@ -152,83 +146,20 @@ vnl_vector_fixed<float,3> TrackingHandlerPeaks::GetDirection(itk::Index<3> idx3,
   return dir;
 }
 
-vnl_vector_fixed<float,3> TrackingHandlerPeaks::GetDirection(itk::Point<float, 3> itkP, bool interpolate, vnl_vector_fixed<float,3> oldDir){
-  // transform physical point to index coordinates
-  itk::Index<3> idx3;
-  itk::ContinuousIndex< float, 3> cIdx;
-  m_DummyImage->TransformPhysicalPointToIndex(itkP, idx3);
-  m_DummyImage->TransformPhysicalPointToContinuousIndex(itkP, cIdx);
-
+vnl_vector_fixed<float,3> TrackingHandlerPeaks::GetDirection(const InterpolationStencil& stencil, bool interpolate, vnl_vector_fixed<float,3> oldDir){
   vnl_vector_fixed<float,3> dir; dir.fill(0.0);
-  if ( !m_DummyImage->GetLargestPossibleRegion().IsInside(idx3) )
+  if ( !stencil.Inside )
     return dir;
 
   if (interpolate)
   {
-    float frac_x = cIdx[0] - idx3[0];
-    float frac_y = cIdx[1] - idx3[1];
-    float frac_z = cIdx[2] - idx3[2];
-    if (frac_x<0)
-    {
-      idx3[0] -= 1;
-      frac_x += 1;
-    }
-    if (frac_y<0)
-    {
-      idx3[1] -= 1;
-      frac_y += 1;
-    }
-    if (frac_z<0)
-    {
-      idx3[2] -= 1;
-      frac_z += 1;
-    }
-    frac_x = 1-frac_x;
-    frac_y = 1-frac_y;
-    frac_z = 1-frac_z;
-
-    // int coordinates inside image?
-    if (idx3[0] >= 0 && idx3[0] < static_cast<itk::IndexValueType>(m_DummyImage->GetLargestPossibleRegion().GetSize(0) - 1) &&
-        idx3[1] >= 0 && idx3[1] < static_cast<itk::IndexValueType>(m_DummyImage->GetLargestPossibleRegion().GetSize(1) - 1) &&
-        idx3[2] >= 0 && idx3[2] < static_cast<itk::IndexValueType>(m_DummyImage->GetLargestPossibleRegion().GetSize(2) - 1))
-    {
-      // trilinear interpolation
-      vnl_vector_fixed<float, 8> interpWeights;
-      interpWeights[0] = (  frac_x)*(  frac_y)*(  frac_z);
-      interpWeights[1] = (1-frac_x)*(  frac_y)*(  frac_z);
-      interpWeights[2] = (  frac_x)*(1-frac_y)*(  frac_z);
-      interpWeights[3] = (  frac_x)*(  frac_y)*(1-frac_z);
-      interpWeights[4] = (1-frac_x)*(1-frac_y)*(  frac_z);
-      interpWeights[5] = (  frac_x)*(1-frac_y)*(1-frac_z);
-      interpWeights[6] = (1-frac_x)*(  frac_y)*(1-frac_z);
-      interpWeights[7] = (1-frac_x)*(1-frac_y)*(1-frac_z);
-
-      dir = GetMatchingDirection(idx3, oldDir) * interpWeights[0];
-
-      itk::Index<3> tmpIdx = idx3; tmpIdx[0]++;
-      dir +=  GetMatchingDirection(tmpIdx, oldDir) * interpWeights[1];
-
-      tmpIdx = idx3; tmpIdx[1]++;
-      dir +=  GetMatchingDirection(tmpIdx, oldDir) * interpWeights[2];
-
-      tmpIdx = idx3; tmpIdx[2]++;
-      dir +=  GetMatchingDirection(tmpIdx, oldDir) * interpWeights[3];
-
-      tmpIdx = idx3; tmpIdx[0]++; tmpIdx[1]++;
-      dir +=  GetMatchingDirection(tmpIdx, oldDir) * interpWeights[4];
-
-      tmpIdx = idx3; tmpIdx[1]++; tmpIdx[2]++;
-      dir +=  GetMatchingDirection(tmpIdx, oldDir) * interpWeights[5];
-
-      tmpIdx = idx3; tmpIdx[2]++; tmpIdx[0]++;
-      dir +=  GetMatchingDirection(tmpIdx, oldDir) * interpWeights[6];
-
-      tmpIdx = idx3; tmpIdx[0]++; tmpIdx[1]++; tmpIdx[2]++;
-      dir +=  GetMatchingDirection(tmpIdx, oldDir) * interpWeights[7];
-    }
+    // trilinear interpolation
+    if (stencil.Interpolate)
+      for (int c=0; c<8; c++)
+        dir += GetMatchingDirection(stencil.Offsets[c], oldDir) * stencil.Weights[c];
   }
   else
-      dir = GetMatchingDirection(idx3, oldDir);
+      dir = GetMatchingDirection(stencil.IndexOffset, oldDir);
 
   return dir;
 }
@@ -238,8 +169,9 @@ vnl_vector_fixed<float,3> TrackingHandlerPeaks::ProposeDirection(itk::Point<floa
     // CHECK: wann wird wo normalisiert
   vnl_vector_fixed<float,3> output_direction; output_direction.fill(0);
 
-  itk::Index<3> index;
-  m_DummyImage->TransformPhysicalPointToIndex(pos, index);
+  InterpolationStencil stencil;
+  GetInterpolationStencil(pos, m_DummyImage.GetPointer(), stencil);
+  itk::Index<3> index = stencil.Index;
 
   vnl_vector_fixed<float,3> oldDir = olddirs.back();
   float old_mag = oldDir.magnitude();
@@ -247,7 +179,7 @@ vnl_vector_fixed<float,3> TrackingHandlerPeaks::ProposeDirection(itk::Point<floa
   if (!m_Interpolate && oldIndex==index)
     return oldDir;
 
-  output_direction = GetDirection(pos, m_Interpolate, oldDir);
+  output_direction = GetDirection(stencil, m_Interpolate, oldDir);
   float mag = output_direction.magnitude();
 
   if (mag>=m_PeakThreshold)
@@ -59,13 +59,14 @@ public:
 
 protected:
 
-    vnl_vector_fixed<float,3> GetDirection(itk::Point<float, 3> itkP, bool interpolate, vnl_vector_fixed<float,3> oldDir);
-    vnl_vector_fixed<float,3> GetMatchingDirection(itk::Index<3> idx3, vnl_vector_fixed<float,3>& oldDir);
-    vnl_vector_fixed<float,3> GetDirection(itk::Index<3> idx3, int dirIdx);
+    vnl_vector_fixed<float,3> GetDirection(const InterpolationStencil& stencil, bool interpolate, vnl_vector_fixed<float,3> oldDir);
+    vnl_vector_fixed<float,3> GetMatchingDirection(itk::OffsetValueType offset, vnl_vector_fixed<float,3>& oldDir);
+    vnl_vector_fixed<float,3> GetDirection(itk::OffsetValueType offset, int dirIdx);   ///< peak of the voxel with the given buffer offset
 
     PeakImgType::Pointer m_PeakImage;
     float m_PeakThreshold;
     int m_NumDirs;
+    itk::OffsetValueType m_VolumeStride;   ///< buffer offset between the volumes of the peak image
 
     itk::Vector<double, 3> spacing3;
     itk::Point<float, 3> origin3;
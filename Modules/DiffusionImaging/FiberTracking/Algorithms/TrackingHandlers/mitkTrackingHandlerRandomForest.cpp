@@ -364,12 +364,8 @@ vnl_vector_fixed<float,3> TrackingHandlerRandomForest< ShOrder, NumberOfSignalFe
     probs2 /= probs_sum;
     boost::random::discrete_distribution<int, float> dist(probs2.begin(), probs2.end());
 
-    int sampled_idx = 0;
-#pragma omp critical
-    {
-        boost::random::variate_generator<boost::random::mt19937&, boost::random::discrete_distribution<int,float>> sampler(m_Rng, dist);
-        sampled_idx = sampler();
-    }
+    boost::random::variate_generator<boost::random::mt19937&, boost::random::discrete_distribution<int,float>> sampler(GetRng(), dist);
+    int sampled_idx = sampler();
 
     output_direction = m_DirectionContainer.at(sampled_idx);
     w = probs2[sampled_idx];
@@ -35,6 +35,8 @@ void TrackingHandlerTensor::InitForTracking()
     MITK_INFO << "Initializing tensor tracker.";
 
     m_NumberOfInputs = m_TensorImages.size();
+    m_PdImage.clear();
+    m_EmaxImage.clear();
     for (int i=0; i<m_NumberOfInputs; i++)
     {
         ItkPDImgType::Pointer pdImage = ItkPDImgType::New();
@@ -107,7 +109,7 @@ void TrackingHandlerTensor::InitForTracking()
     }
 }
 
-vnl_vector_fixed<float,3> TrackingHandlerTensor::GetMatchingDirection(itk::Index<3> idx, vnl_vector_fixed<float,3>& oldDir, int& image_num)
+vnl_vector_fixed<float,3> TrackingHandlerTensor::GetMatchingDirection(itk::OffsetValueType offset, vnl_vector_fixed<float,3>& oldDir, int& image_num)
 {
   vnl_vector_fixed<float,3> out_dir; out_dir.fill(0);
   float angle = 0;
@@ -116,7 +118,7 @@ vnl_vector_fixed<float,3> TrackingHandlerTensor::GetMatchingDirection(itk::Index
   {
     for (unsigned int i=0; i<m_PdImage.size(); i++)
     {
-      out_dir = m_PdImage.at(i)->GetPixel(idx);
+      out_dir = m_PdImage.at(i)->GetBufferPointer()[offset];
 
       if (out_dir.magnitude()>0.5)
       {
@@ -132,7 +134,7 @@ vnl_vector_fixed<float,3> TrackingHandlerTensor::GetMatchingDirection(itk::Index
   {
     for (unsigned int i=0; i<m_PdImage.size(); i++)
     {
-      vnl_vector_fixed<float,3> dir = m_PdImage.at(i)->GetPixel(idx);
+      vnl_vector_fixed<float,3> dir = m_PdImage.at(i)->GetBufferPointer()[offset];
 
       float a = dot_product(dir, oldDir);
       if (fabs(a)>angle)
@@ -151,103 +153,28 @@ vnl_vector_fixed<float,3> TrackingHandlerTensor::GetMatchingDirection(itk::Index
   return out_dir;
 }
 
-vnl_vector_fixed<float,3> TrackingHandlerTensor::GetDirection(itk::Point<float, 3> itkP, vnl_vector_fixed<float,3> oldDir, TensorType& tensor)
+vnl_vector_fixed<float,3> TrackingHandlerTensor::GetDirection(const InterpolationStencil& stencil, vnl_vector_fixed<float,3> oldDir, TensorType& tensor)
 {
-    // transform physical point to index coordinates
-    itk::Index<3> idx;
-    itk::ContinuousIndex< float, 3> cIdx;
-    m_FaImage->TransformPhysicalPointToIndex(itkP, idx);
-    m_FaImage->TransformPhysicalPointToContinuousIndex(itkP, cIdx);
-
     vnl_vector_fixed<float,3> dir; dir.fill(0.0);
-    if ( !m_FaImage->GetLargestPossibleRegion().IsInside(idx) )
+    if ( !stencil.Inside )
         return dir;
 
     int image_num = -1;
     if (!m_Interpolate)
     {
-        dir = GetMatchingDirection(idx, oldDir, image_num);
+        dir = GetMatchingDirection(stencil.IndexOffset, oldDir, image_num);
         if (image_num>=0)
-            tensor = m_TensorImages[image_num]->GetPixel(idx) * m_EmaxImage[image_num]->GetPixel(idx);
+            tensor = m_TensorImages[image_num]->GetBufferPointer()[stencil.IndexOffset] * m_EmaxImage[image_num]->GetBufferPointer()[stencil.IndexOffset];
     }
-    else
+    else if (stencil.Interpolate)
     {
-        float frac_x = cIdx[0] - idx[0];
-        float frac_y = cIdx[1] - idx[1];
-        float frac_z = cIdx[2] - idx[2];
-        if (frac_x<0)
-        {
-            idx[0] -= 1;
-            frac_x += 1;
-        }
-        if (frac_y<0)
+        // trilinear interpolation
+        for (int c=0; c<8; c++)
         {
-            idx[1] -= 1;
-            frac_y += 1;
-        }
-        if (frac_z<0)
-        {
-            idx[2] -= 1;
-            frac_z += 1;
-        }
-        frac_x = 1-frac_x;
-        frac_y = 1-frac_y;
-        frac_z = 1-frac_z;
-
-        // int coordinates inside image?
-        if (idx[0] >= 0 && idx[0] < static_cast<itk::IndexValueType>(m_FaImage->GetLargestPossibleRegion().GetSize(0) - 1) &&
-            idx[1] >= 0 && idx[1] < static_cast<itk::IndexValueType>(m_FaImage->GetLargestPossibleRegion().GetSize(1) - 1) &&
-            idx[2] >= 0 && idx[2] < static_cast<itk::IndexValueType>(m_FaImage->GetLargestPossibleRegion().GetSize(2) - 1))
-        {
-            // trilinear interpolation
-            vnl_vector_fixed<float, 8> interpWeights;
-            interpWeights[0] = (  frac_x)*(  frac_y)*(  frac_z);
-            interpWeights[1] = (1-frac_x)*(  frac_y)*(  frac_z);
-            interpWeights[2] = (  frac_x)*(1-frac_y)*(  frac_z);
-            interpWeights[3] = (  frac_x)*(  frac_y)*(1-frac_z);
-            interpWeights[4] = (1-frac_x)*(1-frac_y)*(  frac_z);
-            interpWeights[5] = (  frac_x)*(1-frac_y)*(1-frac_z);
-            interpWeights[6] = (1-frac_x)*(  frac_y)*(1-frac_z);
-            interpWeights[7] = (1-frac_x)*(1-frac_y)*(1-frac_z);
-
-            dir = GetMatchingDirection(idx, oldDir, image_num) * interpWeights[0];
-            if (image_num>=0)
-                tensor += m_TensorImages[image_num]->GetPixel(idx) * m_EmaxImage[image_num]->GetPixel(idx) * interpWeights[0];
-
-            itk::Index<3> tmpIdx = idx; tmpIdx[0]++;
-            dir +=  GetMatchingDirection(tmpIdx, oldDir, image_num) * interpWeights[1];
-            if (image_num>=0)
-                tensor += m_TensorImages[image_num]->GetPixel(tmpIdx) * m_EmaxImage[image_num]->GetPixel(tmpIdx) * interpWeights[1];
-
-            tmpIdx = idx; tmpIdx[1]++;
-            dir +=  GetMatchingDirection(tmpIdx, oldDir, image_num) * interpWeights[2];
-            if (image_num>=0)
-                tensor += m_TensorImages[image_num]->GetPixel(tmpIdx) * m_EmaxImage[image_num]->GetPixel(tmpIdx) * interpWeights[2];
-
-            tmpIdx = idx; tmpIdx[2]++;
-            dir +=  GetMatchingDirection(tmpIdx, oldDir, image_num) * interpWeights[3];
-            if (image_num>=0)
-                tensor += m_TensorImages[image_num]->GetPixel(tmpIdx) * m_EmaxImage[image_num]->GetPixel(tmpIdx) * interpWeights[3];
-
-            tmpIdx = idx; tmpIdx[0]++; tmpIdx[1]++;
-            dir +=  GetMatchingDirection(tmpIdx, oldDir, image_num) * interpWeights[4];
-            if (image_num>=0)
-                tensor += m_TensorImages[image_num]->GetPixel(tmpIdx) * m_EmaxImage[image_num]->GetPixel(tmpIdx) * interpWeights[4];
-
-            tmpIdx = idx; tmpIdx[1]++; tmpIdx[2]++;
-            dir +=  GetMatchingDirection(tmpIdx, oldDir, image_num) * interpWeights[5];
-            if (image_num>=0)
-                tensor += m_TensorImages[image_num]->GetPixel(tmpIdx) * m_EmaxImage[image_num]->GetPixel(tmpIdx) * interpWeights[5];
-
-            tmpIdx = idx; tmpIdx[2]++; tmpIdx[0]++;
-            dir +=  GetMatchingDirection(tmpIdx, oldDir, image_num) * interpWeights[6];
-            if (image_num>=0)
-                tensor += m_TensorImages[image_num]->GetPixel(tmpIdx) * m_EmaxImage[image_num]->GetPixel(tmpIdx) * interpWeights[6];
-
-            tmpIdx = idx; tmpIdx[0]++; tmpIdx[1]++; tmpIdx[2]++;
-            dir +=  GetMatchingDirection(tmpIdx, oldDir, image_num) * interpWeights[7];
+            const itk::OffsetValueType o = stencil.Offsets[c];
+            dir += GetMatchingDirection(o, oldDir, image_num) * stencil.Weights[c];
             if (image_num>=0)
-                tensor += m_TensorImages[image_num]->GetPixel(tmpIdx) * m_EmaxImage[image_num]->GetPixel(tmpIdx) * interpWeights[7];
+                tensor += m_TensorImages[image_num]->GetBufferPointer()[o] * m_EmaxImage[image_num]->GetBufferPointer()[o] * stencil.Weights[c];
         }
     }
 
@@ -276,10 +203,12 @@ vnl_vector_fixed<float,3> TrackingHandlerTensor::ProposeDirection(itk::Point<flo
 
     try
     {
-        itk::Index<3> index;
-        m_TensorImages.at(0)->TransformPhysicalPointToIndex(pos, index);
+        // the stencil is shared by the FA, tensor and principal direction images
+        InterpolationStencil stencil;
+        GetInterpolationStencil(pos, m_FaImage.GetPointer(), stencil);
+        itk::Index<3> index = stencil.Index;
 
-        float fa = GetImageValue<float>(pos, m_FaImage, m_Interpolate);
+        float fa = GetImageValue<float>(stencil, m_FaImage, m_Interpolate);
         if (fa<m_FaThreshold)
             return output_direction;
 
@@ -297,7 +226,7 @@ vnl_vector_fixed<float,3> TrackingHandlerTensor::ProposeDirection(itk::Point<flo
         if (!m_Interpolate && oldIndex==index)
           return oldDir;
 
-        output_direction = GetDirection(pos, oldDir, tensor);
+        output_direction = GetDirection(stencil, oldDir, tensor);
         float mag = output_direction.magnitude();
 
         if (mag>=mitk::eps)
@@ -66,8 +66,8 @@ public:
 
 protected:
 
-    vnl_vector_fixed<float,3> GetMatchingDirection(itk::Index<3> idx, vnl_vector_fixed<float,3>& oldDir, int& image_num);
-    vnl_vector_fixed<float,3> GetDirection(itk::Point<float, 3> itkP, vnl_vector_fixed<float,3> oldDir, TensorType& tensor);
+    vnl_vector_fixed<float,3> GetMatchingDirection(itk::OffsetValueType offset, vnl_vector_fixed<float,3>& oldDir, int& image_num);
+    vnl_vector_fixed<float,3> GetDirection(const InterpolationStencil& stencil, vnl_vector_fixed<float,3> oldDir, TensorType& tensor);
     vnl_vector_fixed<float,3> GetLargestEigenvector(TensorType& tensor);
 
     float   m_FaThreshold;
@@ -38,6 +38,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <boost/progress.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
+#include <omp.h>
 
 namespace itk{
 
@@ -63,10 +65,12 @@ GibbsTrackingFilter< ItkQBallImageType >::GibbsTrackingFilter():
   m_DuplicateImage(true),
   m_NumParticles(0),
   m_NumConnections(0),
+  m_Energy(0),
   m_RandomSeed(-1),
   m_LoadParameterFile(""),
   m_LutPath(""),
-  m_IsInValidState(true)
+  m_IsInValidState(true),
+  m_ParallelSampling(false)
 {
 
 }
@@ -163,6 +167,145 @@ GibbsTrackingFilter< ItkQBallImageType >
   MITK_INFO << "GibbsTrackingFilter: finished estimating particle weight";
 }
 
+// Run the proposals on checkerboard blocks of the particle grid. Blocks of the same color (parity of the block
+// coordinates) are separated by a block that is wider than the reach of the energy terms and the connection
+// proposals, so they are sampled in parallel. Each round shifts the partition randomly to avoid artifacts at the
+// block borders. Each block uses its own random generator, so the result does not depend on the number of threads.
+template< class ItkQBallImageType >
+bool GibbsTrackingFilter< ItkQBallImageType >::SampleInBlocks(ParticleGrid* particleGrid, EnergyComputer* encomp, Statistics::MersenneTwisterRandomVariateGenerator* randGen, float alpha)
+{
+  const int blockSize = 4;   // grid cells per block and axis
+  const double proposalsPerRound = std::max(100000.0, m_Iterations/1000);  // temperature is updated after each round
+  const vnl_vector_fixed<int, 3>& gridSize = particleGrid->GetGridSize();
+
+  std::vector< MetropolisHastingsSampler* > samplers;
+  for (int t=0; t<omp_get_max_threads(); t++)
+    samplers.push_back(new MetropolisHastingsSampler(particleGrid, encomp, randGen, m_CurvatureThreshold));
+  MITK_INFO << "GibbsTrackingFilter: sampling blocks of " << blockSize << "^3 grid cells using " << samplers.size() << " threads";
+
+  bool just_built_fibers = false;
+  boost::progress_display disp(m_Iterations);
+  while (m_CurrentIteration<m_Iterations && !m_AbortTracking)
+  {
+    just_built_fibers = false;
+
+    // partition the grid
+    vnl_vector_fixed<int, 3> offset, numBlocks;
+    for (int i=0; i<3; i++)
+    {
+      offset[i] = randGen->GetIntegerVariate()%blockSize;
+      numBlocks[i] = (gridSize[i]+offset[i]+blockSize-1)/blockSize;
+    }
+    std::vector< ParticleGridBlock > blocks(numBlocks[0]*numBlocks[1]*numBlocks[2]);
+    for (unsigned int b=0; b<blocks.size(); b++)
+    {
+      int coord[3] = {(int)(b%numBlocks[0]), (int)((b/numBlocks[0])%numBlocks[1]), (int)(b/(numBlocks[0]*numBlocks[1]))};
+      for (int i=0; i<3; i++)
+      {
+        blocks[b].m_Start[i] = std::max(0, coord[i]*blockSize-offset[i]);
+        blocks[b].m_End[i] = std::min(gridSize[i], (coord[i]+1)*blockSize-offset[i]);
+      }
+    }
+
+    // assign the mask voxels to the blocks
+    float totalProbability = 0;
+    for (int i=0; i<encomp->GetNumActiveVoxels(); i++)
+    {
+      int voxel = encomp->GetActiveVoxel(i);
+      vnl_vector_fixed<int, 3> cell;
+      if (!particleGrid->GetCell(encomp->GetVoxelCenter(voxel), cell))
+        continue;
+      ParticleGridBlock& block = blocks[(cell[0]+offset[0])/blockSize + numBlocks[0]*((cell[1]+offset[1])/blockSize + numBlocks[1]*((cell[2]+offset[2])/blockSize))];
+      float probability = encomp->GetVoxelProbability(voxel);
+      block.m_Voxels.push_back(voxel);
+      block.m_CumulatedProbability.push_back(probability + (block.m_CumulatedProbability.empty() ? 0 : block.m_CumulatedProbability.back()));
+      totalProbability += probability;
+    }
+    if (totalProbability<=0)
+      break;
+
+    // distribute the proposals of this round according to the spatial probability of the blocks
+    double roundProposals = std::min(proposalsPerRound, m_Iterations-m_CurrentIteration);
+    std::vector< std::vector< ParticleGridBlock* > > colors(8);
+    for (unsigned int b=0; b<blocks.size(); b++)
+    {
+      ParticleGridBlock& block = blocks[b];
+      block.m_DensityFraction = block.m_Voxels.empty() ? 0 : block.m_CumulatedProbability.back()/totalProbability;
+      block.m_NumProposals = (int)(roundProposals*block.m_DensityFraction + 0.5);
+      if (block.m_NumProposals==0)
+        continue;
+      block.m_RandGen = Statistics::MersenneTwisterRandomVariateGenerator::New();
+      block.m_RandGen->SetSeed(randGen->GetIntegerVariate());
+      int coord[3] = {(int)(b%numBlocks[0]), (int)((b/numBlocks[0])%numBlocks[1]), (int)(b/(numBlocks[0]*numBlocks[1]))};
+      colors[(coord[0]&1) + 2*(coord[1]&1) + 4*(coord[2]&1)].push_back(&block);
+    }
+
+    float temperature = m_StartTemperature * exp(alpha*m_CurrentIteration/m_Iterations);
+    for (auto sampler : samplers)
+      sampler->SetTemperature(temperature);
+
+    unsigned long numProposals = 0;
+    for (auto& colorBlocks : colors)
+    {
+      if (colorBlocks.empty() || m_AbortTracking)
+        continue;
+
+      // each proposal adds at most one particle, the container must not be reallocated during the phase
+      unsigned long phaseProposals = 0;
+      for (auto block : colorBlocks)
+        phaseProposals += block->m_NumProposals;
+      if (!particleGrid->ReserveParticles(particleGrid->m_NumParticles + phaseProposals))
+      {
+        MITK_ERROR << "Particle container allocation failed. Not enough memory?";
+        m_AbortTracking = true;
+        break;
+      }
+
+#pragma omp parallel for schedule(dynamic)
+      for (int b=0; b<(int)colorBlocks.size(); b++)
+      {
+        MetropolisHastingsSampler* sampler = samplers[omp_get_thread_num()];
+        sampler->SetBlock(colorBlocks[b]);
+        for (int i=0; i<colorBlocks[b]->m_NumProposals; i++)
+          sampler->MakeProposal();
+        sampler->SetBlock(nullptr);
+      }
+
+      // synchronize: particles that died in this phase are removed from the container
+      std::vector< int > detached;
+      for (auto block : colorBlocks)
+        detached.insert(detached.end(), block->m_DetachedParticles.begin(), block->m_DetachedParticles.end());
+      particleGrid->CompactParticles(detached);
+      numProposals += phaseProposals;
+    }
+    if (numProposals==0)  // remaining iterations are too few to be distributed over the blocks
+      break;
+
+    m_CurrentIteration += numProposals;
+    disp += numProposals;
+
+    unsigned long acceptedProposals = 0;
+    for (auto sampler : samplers)
+      acceptedProposals += sampler->GetNumAcceptedProposals();
+    m_ProposalAcceptance = (float)acceptedProposals/m_CurrentIteration;
+    m_NumParticles = particleGrid->m_NumParticles;
+    m_NumConnections = particleGrid->m_NumConnections;
+
+    if (m_BuildFibers && !m_AbortTracking)
+    {
+      FiberBuilder fiberBuilder(particleGrid, m_MaskImage);
+      m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
+      m_NumAcceptedFibers = m_FiberPolyData->GetNumberOfLines();
+      m_BuildFibers = false;
+      just_built_fibers = true;
+    }
+  }
+
+  for (auto sampler : samplers)
+    delete sampler;
+  return just_built_fibers;
+}
+
 // perform global tracking
 template< class ItkQBallImageType >
 void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
@@ -282,37 +425,42 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
   m_NumAcceptedFibers = 0;
   m_CurrentIteration = 0;
   bool just_built_fibers = false;
-  boost::progress_display disp(m_Iterations);
-  if (!m_AbortTracking)
-    while (m_CurrentIteration<m_Iterations)
-    {
-      just_built_fibers = false;
-      ++disp;
-      m_CurrentIteration++;
-      if (m_AbortTracking)
-        break;
-
-      // update temperatur for simulated annealing process
-      float temperature = m_StartTemperature * exp(alpha*m_CurrentIteration/m_Iterations);
-      sampler->SetTemperature(temperature);
-      sampler->MakeProposal();
-
-      m_ProposalAcceptance = (float)sampler->GetNumAcceptedProposals()/m_CurrentIteration;
-      m_NumParticles = particleGrid->m_NumParticles;
-      m_NumConnections = particleGrid->m_NumConnections;
-
-      if (m_AbortTracking)
-        break;
-
-      if (m_BuildFibers)
+  if (m_ParallelSampling && !m_AbortTracking)
+    just_built_fibers = SampleInBlocks(particleGrid, encomp, randGen, alpha);
+  else
+  {
+    boost::progress_display disp(m_Iterations);
+    if (!m_AbortTracking)
+      while (m_CurrentIteration<m_Iterations)
       {
-        FiberBuilder fiberBuilder(particleGrid, m_MaskImage);
-        m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
-        m_NumAcceptedFibers = m_FiberPolyData->GetNumberOfLines();
-        m_BuildFibers = false;
-        just_built_fibers = true;
+        just_built_fibers = false;
+        ++disp;
+        m_CurrentIteration++;
+        if (m_AbortTracking)
+          break;
+
+        // update temperatur for simulated annealing process
+        float temperature = m_StartTemperature * exp(alpha*m_CurrentIteration/m_Iterations);
+        sampler->SetTemperature(temperature);
+        sampler->MakeProposal();
+
+        m_ProposalAcceptance = (float)sampler->GetNumAcceptedProposals()/m_CurrentIteration;
+        m_NumParticles = particleGrid->m_NumParticles;
+        m_NumConnections = particleGrid->m_NumConnections;
+
+        if (m_AbortTracking)
+          break;
+
+        if (m_BuildFibers)
+        {
+          FiberBuilder fiberBuilder(particleGrid, m_MaskImage);
+          m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
+          m_NumAcceptedFibers = m_FiberPolyData->GetNumberOfLines();
+          m_BuildFibers = false;
+          just_built_fibers = true;
+        }
       }
-    }
+  }
   if (!just_built_fibers)
   {
     FiberBuilder fiberBuilder(particleGrid, m_MaskImage);
@@ -321,6 +469,14 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
   }
   clock.Stop();
 
+  // each connection contributes to the internal energy of both of its particles
+  m_Energy = 0;
+  for (int i=0; i<particleGrid->m_NumParticles; i++)
+  {
+    Particle* p = particleGrid->GetParticle(i);
+    m_Energy += encomp->ComputeExternalEnergy(p->GetPos(), p->GetDir(), p) + 0.5*encomp->ComputeInternalEnergy(p);
+  }
+
   delete sampler;
   delete encomp;
   delete interpolator;
@@ -32,6 +32,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkPoints.h>
 #include <vtkPolyLine.h>
 
+namespace mitk{
+class ParticleGrid;
+}
+class EnergyComputer;
+
 namespace itk{
 
 /**
@@ -73,6 +78,7 @@ public:
     itkSetMacro( LoadParameterFile, std::string )   ///< Parameter file.
     itkSetMacro( SaveParameterFile, std::string )
     itkSetMacro( LutPath, std::string )             ///< Path to lookuptables. Default is binary directory.
+    itkSetMacro( ParallelSampling, bool )           ///< Sample checkerboard blocks of the particle grid in parallel. Results depend on the seed but not on the number of threads.
 
     /** Getter. */
     itkGetMacro( ParticleWeight, float )
@@ -82,6 +88,7 @@ public:
     itkGetMacro( NumConnections, int )
     itkGetMacro( NumAcceptedFibers, int )
     itkGetMacro( ProposalAcceptance, float )
+    itkGetMacro( Energy, float )
     itkGetMacro( CurrentIteration, double)
     itkGetMacro( Iterations, double)
     itkGetMacro( IsInValidState, bool)
@@ -106,6 +113,7 @@ protected:
     void PrepareMaskImage();
     bool LoadParameters();
     bool SaveParameters();
+    bool SampleInBlocks(mitk::ParticleGrid* particleGrid, EnergyComputer* encomp, Statistics::MersenneTwisterRandomVariateGenerator* randGen, float alpha);
 
     // Input Images
     typename ItkQBallImageType::Pointer m_QBallImage;
@@ -133,11 +141,13 @@ protected:
     bool            m_DuplicateImage;       ///< generates a working copy of the qball image so that the original image won't be changed by the mean subtraction
     int             m_NumParticles;         ///< current number of particles in grid
     int             m_NumConnections;       ///< current number of connections between particles in grid
+    float           m_Energy;               ///< energy of the final particle configuration (external energy and internal energy of the connections)
     int             m_RandomSeed;           ///< seed value for random generator (-1 for standard seeding)
     std::string     m_LoadParameterFile;    ///< filename of parameter file (reader)
     std::string     m_SaveParameterFile;    ///< filename of parameter file (writer)
     std::string     m_LutPath;              ///< path to lookuptables used by the sphere interpolator
     bool            m_IsInValidState;       ///< Whether the filter is in a valid state, false if error occured
+    bool            m_ParallelSampling;     ///< run the proposals of independent blocks of the particle grid in parallel
 
     FiberPolyDataType m_FiberPolyData;      ///< container for reconstructed fibers
 
@@ -25,6 +25,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkImageRegionIterator.h>
 #include <itkImageFileWriter.h>
 #include "itkPointShell.h"
+#include <boost/random/uniform_real_distribution.hpp>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -67,6 +71,8 @@ StreamlineTrackingFilter
     , m_AngularThresholdDeg(-1)
     , m_MaxNumTracts(-1)
     , m_Random(true)
+    , m_RandomSeed(-1)
+    , m_StreamlinesPerSecond(0)
     , m_Verbose(true)
 {
     this->SetNumberOfRequiredInputs(0);
@@ -78,6 +84,7 @@ void StreamlineTrackingFilter::BeforeTracking()
     std::cout.setf(std::ios::boolalpha);
 
     m_TrackingHandler->InitForTracking();
+    m_TrackingHandler->InitRandomStreams(m_RandomSeed>=0 ? m_RandomSeed : std::time(0));
 
     m_FiberPolyData = PolyDataType::New();
     m_Points = vtkSmartPointer< vtkPoints >::New();
@@ -328,7 +335,8 @@ bool StreamlineTrackingFilter
 
 float StreamlineTrackingFilter::GetRandDouble(float min, float max)
 {
-    return (float)(rand()%((int)(10000*(max-min))) + 10000*min)/10000;
+    boost::random::uniform_real_distribution<float> dist(min, max);
+    return dist(m_TrackingHandler->GetRng());
 }
 
 
@@ -545,15 +553,17 @@ float StreamlineTrackingFilter::FollowStreamline(itk::Point<float, 3> pos, vnl_v
                 return tractLength;
         }
 
-#pragma omp critical
         if (m_DemoMode) // CHECK: warum sind die samplingpunkte der streamline in der visualisierung immer einen schritt voras?
         {
-            m_BuildFibersReady++;
-            m_Tractogram.push_back(*fib);
-            BuildFibers(true);
-            m_Stop = true;
+#pragma omp critical
+            {
+                m_BuildFibersReady++;
+                m_Tractogram.push_back(*fib);
+                BuildFibers(true);
+                m_Stop = true;
 
-            while (m_Stop){
+                while (m_Stop){
+                }
             }
         }
 
@@ -700,118 +710,146 @@ void StreamlineTrackingFilter::GenerateData()
     }
 
     if (m_Random)
-    {
-        std::srand(std::time(0));
-        std::random_shuffle ( seedpoints.begin(), seedpoints.end() );
-    }
+        std::shuffle( seedpoints.begin(), seedpoints.end(), m_TrackingHandler->GetRng() );
 
-    bool stop = false;
-    unsigned int current_tracts = 0;
+    std::atomic<unsigned int> current_tracts(0);
+    std::atomic<int> progress(0);
     int num_seeds = seedpoints.size();
     itk::Index<3> zeroIndex; zeroIndex.Fill(0);
-    int progress = 0;
-    int i = 0;
     int print_interval = num_seeds/100;
     if (print_interval<100)
         m_Verbose=false;
 
-#pragma omp parallel
-    while (i<num_seeds && !stop)
+    // every thread collects its streamlines together with the index of their seed point,
+    // the buffers are merged in seed order after tracking
+    typedef std::vector< std::pair< int, FiberType > > ThreadTractogramType;
+    std::vector< ThreadTractogramType > threadTractograms(omp_get_max_threads());
+    std::chrono::time_point<std::chrono::system_clock> trackingStart = std::chrono::system_clock::now();
+
+    // With a maximum number of tracts, the seeds are tracked in blocks. Tracking stops after the block that completes
+    // the maximum number and the tracts are truncated in seed order, so the result does not depend on the threads.
+    int block_size = num_seeds;
+    if (m_MaxNumTracts>0)
+        block_size = std::max(m_MaxNumTracts, 16*omp_get_max_threads());
+    bool stop = false;
+    for (int block_start=0; block_start<num_seeds && !stop; block_start+=block_size)
     {
-        int temp_i = i;
-#pragma omp critical
-            i++;
-
-        if (temp_i>=num_seeds || stop)
-            continue;
-        else if (m_Verbose && i%print_interval==0)
-#pragma omp critical
+        const int block_end = std::min(num_seeds, block_start+block_size);
+#pragma omp parallel for schedule(dynamic, 16)
+        for (int temp_i=block_start; temp_i<block_end; temp_i++)
         {
-            progress += print_interval;
-            std::cout << "                                                                                                     \r";
-            if (m_MaxNumTracts>0)
-                std::cout << "Tried: " << progress << "/" << num_seeds << " | Accepted: " << current_tracts << "/" << m_MaxNumTracts << '\r';
-            else
-                std::cout << "Tried: " << progress << "/" << num_seeds << " | Accepted: " << current_tracts << '\r';
-            cout.flush();
-        }
+            int tried = ++progress;
+            if (m_Verbose && tried%print_interval==0)
+#pragma omp critical
+            {
+                std::cout << "                                                                                                     \r";
+                if (m_MaxNumTracts>0)
+                    std::cout << "Tried: " << tried << "/" << num_seeds << " | Accepted: " << current_tracts.load() << "/" << m_MaxNumTracts << '\r';
+                else
+                    std::cout << "Tried: " << tried << "/" << num_seeds << " | Accepted: " << current_tracts.load() << '\r';
+                cout.flush();
+            }
 
-        itk::Point<float> worldPos = seedpoints.at(temp_i);
-        FiberType fib;
-        float tractLength = 0;
-        unsigned int counter = 0;
+            // the random numbers used for this streamline only depend on the seed index, not on the thread
+            m_TrackingHandler->SetRandomStream(temp_i);
 
-        // get starting direction
-        vnl_vector_fixed<float,3> dir; dir.fill(0.0);
-        std::deque< vnl_vector_fixed<float,3> > olddirs;
-        while (olddirs.size()<m_NumPreviousDirections)
-            olddirs.push_back(dir); // start without old directions (only zero directions)
+            itk::Point<float> worldPos = seedpoints.at(temp_i);
+            FiberType fib;
+            float tractLength = 0;
+            unsigned int counter = 0;
 
-        vnl_vector_fixed< float, 3 > gm_start_dir;
-        if (m_ControlGmEndings)
-        {
-            gm_start_dir[0] = m_GmStubs[temp_i][1][0] - m_GmStubs[temp_i][0][0];
-            gm_start_dir[1] = m_GmStubs[temp_i][1][1] - m_GmStubs[temp_i][0][1];
-            gm_start_dir[2] = m_GmStubs[temp_i][1][2] - m_GmStubs[temp_i][0][2];
-            gm_start_dir.normalize();
-            olddirs.pop_back();
-            olddirs.push_back(gm_start_dir);
-        }
-
-        if (IsValidPosition(worldPos))
-            dir = m_TrackingHandler->ProposeDirection(worldPos, olddirs, zeroIndex);
+            // get starting direction
+            vnl_vector_fixed<float,3> dir; dir.fill(0.0);
+            std::deque< vnl_vector_fixed<float,3> > olddirs;
+            while (olddirs.size()<m_NumPreviousDirections)
+                olddirs.push_back(dir); // start without old directions (only zero directions)
 
-        if (dir.magnitude()>0.0001)
-        {
+            vnl_vector_fixed< float, 3 > gm_start_dir;
             if (m_ControlGmEndings)
             {
-                float a = dot_product(gm_start_dir, dir);
-                if (a<0)
-                    dir = -dir;
+                gm_start_dir[0] = m_GmStubs[temp_i][1][0] - m_GmStubs[temp_i][0][0];
+                gm_start_dir[1] = m_GmStubs[temp_i][1][1] - m_GmStubs[temp_i][0][1];
+                gm_start_dir[2] = m_GmStubs[temp_i][1][2] - m_GmStubs[temp_i][0][2];
+                gm_start_dir.normalize();
+                olddirs.pop_back();
+                olddirs.push_back(gm_start_dir);
             }
 
-            // forward tracking
-            tractLength = FollowStreamline(worldPos, dir, &fib, 0, false);
-            fib.push_front(worldPos);
+            if (IsValidPosition(worldPos))
+                dir = m_TrackingHandler->ProposeDirection(worldPos, olddirs, zeroIndex);
 
-            if (m_ControlGmEndings)
-            {
-                fib.push_front(m_GmStubs[temp_i][0]);
-                CheckFiberForGmEnding(&fib);
-            }
-            else
+            if (dir.magnitude()>0.0001)
             {
-                // backward tracking (only if we don't explicitely start in the GM)
-                tractLength = FollowStreamline(worldPos, -dir, &fib, tractLength, true);
                 if (m_ControlGmEndings)
                 {
-                    CheckFiberForGmEnding(&fib);
-                    std::reverse(fib.begin(),fib.end());
-                    CheckFiberForGmEnding(&fib);
+                    float a = dot_product(gm_start_dir, dir);
+                    if (a<0)
+                        dir = -dir;
                 }
-            }
-            counter = fib.size();
 
-#pragma omp critical
-            if (tractLength>=m_MinTractLength && counter>=2)
-            {
-                if (!stop)
+                // forward tracking
+                tractLength = FollowStreamline(worldPos, dir, &fib, 0, false);
+                fib.push_front(worldPos);
+
+                if (m_ControlGmEndings)
                 {
-                    m_Tractogram.push_back(fib);
-                    current_tracts++;
+                    fib.push_front(m_GmStubs[temp_i][0]);
+                    CheckFiberForGmEnding(&fib);
                 }
-                if (m_MaxNumTracts > 0 && current_tracts>=static_cast<unsigned int>(m_MaxNumTracts))
+                else
                 {
-                    if (!stop)
+                    // backward tracking (only if we don't explicitely start in the GM)
+                    tractLength = FollowStreamline(worldPos, -dir, &fib, tractLength, true);
+                    if (m_ControlGmEndings)
                     {
-                        std::cout << "                                                                                                     \r";
-                        MITK_INFO << "Reconstructed maximum number of tracts (" << current_tracts << "). Stopping tractography.";
+                        CheckFiberForGmEnding(&fib);
+                        std::reverse(fib.begin(),fib.end());
+                        CheckFiberForGmEnding(&fib);
                     }
-                    stop = true;
+                }
+                counter = fib.size();
+
+                if (tractLength>=m_MinTractLength && counter>=2)
+                {
+                    if (m_DemoMode)
+                    {
+#pragma omp critical
+                        m_Tractogram.push_back(fib);
+                    }
+                    else
+                        threadTractograms[omp_get_thread_num()].push_back(std::make_pair(temp_i, fib));
+
+                    ++current_tracts;
                 }
             }
         }
+
+        if (m_MaxNumTracts > 0 && current_tracts>=static_cast<unsigned int>(m_MaxNumTracts))
+        {
+            stop = true;
+            std::cout << "                                                                                                     \r";
+            MITK_INFO << "Reconstructed maximum number of tracts (" << m_MaxNumTracts << "). Stopping tractography.";
+        }
+    }
+
+    std::chrono::duration<float> trackingTime = std::chrono::system_clock::now() - trackingStart;
+
+    ThreadTractogramType tractogram;
+    for (ThreadTractogramType& threadTractogram : threadTractograms)
+    {
+        std::move(threadTractogram.begin(), threadTractogram.end(), std::back_inserter(tractogram));
+        ThreadTractogramType().swap(threadTractogram);
     }
+    std::sort(tractogram.begin(), tractogram.end(), [](const std::pair< int, FiberType >& a, const std::pair< int, FiberType >& b){ return a.first<b.first; });
+    if (m_MaxNumTracts>0 && tractogram.size()>static_cast<std::size_t>(m_MaxNumTracts))
+        tractogram.resize(m_MaxNumTracts);
+    for (auto& t : tractogram)
+        m_Tractogram.push_back(std::move(t.second));
+
+    float seconds = std::max(trackingTime.count(), 0.001f);
+    m_StreamlinesPerSecond = m_Tractogram.size()/seconds;
+    std::cout << "                                                                                                     \r";
+    MITK_INFO << "Tracking throughput: " << m_StreamlinesPerSecond << " streamlines/s (" << progress.load()/seconds << " seeds/s)";
 
     this->AfterTracking();
 }
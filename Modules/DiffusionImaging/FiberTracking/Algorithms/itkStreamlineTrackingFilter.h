@@ -102,9 +102,11 @@ public:
     itkSetMacro( AvoidStop, bool )                      ///< Use additional sampling points to avoid premature streamline termination
     itkSetMacro( RandomSampling, bool )                 ///< If true, the sampling points are distributed randomly around the current position, not sphericall in the specified sampling distance.
     itkSetMacro( NumPreviousDirections, unsigned int )  ///< How many "old" steps do we want to consider in our decision where to go next?
-    itkSetMacro( MaxNumTracts, unsigned int )           ///< Tracking is stopped if the maximum number of tracts is exceeded
+    itkSetMacro( MaxNumTracts, unsigned int )           ///< Tracking is stopped if the maximum number of tracts is exceeded. The tracts of the first seeds are kept.
     itkSetMacro( Random, bool )                         ///< If true, seedpoints are shuffled randomly before tracking
     itkSetMacro( Verbose, bool )                        ///< If true, output tracking progress (might be slower)
+    itkSetMacro( RandomSeed, int )                      ///< Seed of the random number streams. If negative (default), a new seed is chosen for each run.
+    itkGetMacro( StreamlinesPerSecond, float )          ///< Number of accepted streamlines per second of the last run
 
     void SetTrackingHandler( mitk::TrackingDataHandler* h )   ///<
     {
@@ -175,6 +177,8 @@ protected:
     bool                                m_AvoidStop;
     bool                                m_DemoMode;
     bool                                m_Random;
+    int                                 m_RandomSeed;
+    float                               m_StreamlinesPerSecond;
     void BuildFibers(bool check);
     int CheckCurvature(FiberType* fib, bool front);
 
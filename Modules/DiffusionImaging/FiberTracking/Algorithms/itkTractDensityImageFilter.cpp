@@ -15,14 +15,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 #include "itkTractDensityImageFilter.h"
 
-// VTK
-#include <vtkPolyLine.h>
-#include <vtkCellArray.h>
-#include <vtkCellData.h>
-#include <vtkCell.h>
-
 // misc
 #include <math.h>
+#include <algorithm>
+#include <limits>
 #include <boost/progress.hpp>
 
 namespace itk{
@@ -39,6 +35,7 @@ TractDensityImageFilter< OutputImageType >::TractDensityImageFilter()
     , m_UseTrilinearInterpolation(false)
     , m_DoFiberResampling(true)
     , m_WorkOnFiberCopy(true)
+    , m_TractogramReader(nullptr)
     , m_MaxDensity(0)
 {
 
@@ -62,8 +59,10 @@ itk::Point<float, 3> TractDensityImageFilter< OutputImageType >::GetItkPoint(dou
 template< class OutputImageType >
 void TractDensityImageFilter< OutputImageType >::GenerateData()
 {
+    if (m_TractogramReader==nullptr && m_FiberBundle.IsNull())
+        itkExceptionMacro("No input fibers set!");
+
     // generate upsampled image
-    mitk::BaseGeometry::Pointer geometry = m_FiberBundle->GetGeometry();
     typename OutputImageType::Pointer outImage = this->GetOutput();
 
     // calculate new image parameters
@@ -87,6 +86,7 @@ void TractDensityImageFilter< OutputImageType >::GenerateData()
     else
     {
         MITK_INFO << "TractDensityImageFilter: using fiber bundle geometry";
+        mitk::BaseGeometry::Pointer geometry = m_TractogramReader!=nullptr ? m_TractogramReader->GetBoundingGeometry() : m_FiberBundle->GetGeometry();
         newSpacing = geometry->GetSpacing()/m_UpsamplingFactor;
         newOrigin = geometry->GetOrigin();
         mitk::Geometry3D::BoundsArrayType bounds = geometry->GetBounds();
@@ -123,7 +123,6 @@ void TractDensityImageFilter< OutputImageType >::GenerateData()
     // set/initialize output
     OutPixelType* outImageBufferPointer = (OutPixelType*)outImage->GetBufferPointer();
 
-    // resample fiber bundle
     float minSpacing = 1;
     if(newSpacing[0]<newSpacing[1] && newSpacing[0]<newSpacing[2])
         minSpacing = newSpacing[0];
@@ -132,108 +131,220 @@ void TractDensityImageFilter< OutputImageType >::GenerateData()
     else
         minSpacing = newSpacing[2];
 
-    if (m_DoFiberResampling)
-    {
-      MITK_INFO << "TractDensityImageFilter: resampling fibers to ensure sufficient voxel coverage";
-      if (m_WorkOnFiberCopy)
-        m_FiberBundle = m_FiberBundle->GetDeepCopy();
-      m_FiberBundle->ResampleLinear(minSpacing/10);
-    }
-
-    MITK_INFO << "TractDensityImageFilter: starting image generation";
-
-    vtkSmartPointer<vtkPolyData> fiberPolyData = m_FiberBundle->GetFiberPolyData();
+    // the fibers are processed in parallel, so the densities are summed up in a float buffer using atomic updates
+    std::vector< float > density(static_cast<std::size_t>(w)*h*d, 0);
+    float* densityBuffer = density.data();
 
-    int numFibers = m_FiberBundle->GetNumFibers();
-    boost::progress_display disp(numFibers);
-    for( int i=0; i<numFibers; i++ )
+    // adds the value to the voxel of the point (nearest neighbor) or to the eight surrounding voxels (trilinear)
+    auto addPoint = [&](const float* p, float value)
     {
-        ++disp;
-        vtkCell* cell = fiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        float weight = m_FiberBundle->GetFiberWeight(i);
-
-        // fill output image
-        for( int j=0; j<numPoints; j++)
+        itk::Point<float, 3> vertex;
+        vertex[0] = p[0];
+        vertex[1] = p[1];
+        vertex[2] = p[2];
+        itk::Index<3> index;
+        itk::ContinuousIndex<float, 3> contIndex;
+        outImage->TransformPhysicalPointToIndex(vertex, index);
+        outImage->TransformPhysicalPointToContinuousIndex(vertex, contIndex);
+
+        if (!m_UseTrilinearInterpolation)
         {
-            itk::Point<float, 3> vertex = GetItkPoint(points->GetPoint(j));
-            itk::Index<3> index;
-            itk::ContinuousIndex<float, 3> contIndex;
-            outImage->TransformPhysicalPointToIndex(vertex, index);
-            outImage->TransformPhysicalPointToContinuousIndex(vertex, contIndex);
-
-            if (!m_UseTrilinearInterpolation && outImage->GetLargestPossibleRegion().IsInside(index))
+            if (outImage->GetLargestPossibleRegion().IsInside(index))
             {
-                if (m_BinaryOutput)
-                    outImage->SetPixel(index, 1);
-                else
-                    outImage->SetPixel(index, outImage->GetPixel(index)+0.01*weight);
-                continue;
+#pragma omp atomic
+                densityBuffer[index[0] + w*(index[1] + h*index[2])] += value;
             }
+            return;
+        }
 
-            float frac_x = contIndex[0] - index[0];
-            float frac_y = contIndex[1] - index[1];
-            float frac_z = contIndex[2] - index[2];
+        float frac_x = contIndex[0] - index[0];
+        float frac_y = contIndex[1] - index[1];
+        float frac_z = contIndex[2] - index[2];
 
-            if (frac_x<0)
+        if (frac_x<0)
+        {
+            index[0] -= 1;
+            frac_x += 1;
+        }
+        if (frac_y<0)
+        {
+            index[1] -= 1;
+            frac_y += 1;
+        }
+        if (frac_z<0)
+        {
+            index[2] -= 1;
+            frac_z += 1;
+        }
+
+        frac_x = 1-frac_x;
+        frac_y = 1-frac_y;
+        frac_z = 1-frac_z;
+
+        // int coordinates inside image?
+        if (index[0] < 0 || index[0] >= w-1)
+            return;
+        if (index[1] < 0 || index[1] >= h-1)
+            return;
+        if (index[2] < 0 || index[2] >= d-1)
+            return;
+
+        const float weights[] = { (  frac_x)*(  frac_y)*(  frac_z), (  frac_x)*(1-frac_y)*(  frac_z),
+                                  (  frac_x)*(  frac_y)*(1-frac_z), (  frac_x)*(1-frac_y)*(1-frac_z),
+                                  (1-frac_x)*(  frac_y)*(  frac_z), (1-frac_x)*(  frac_y)*(1-frac_z),
+                                  (1-frac_x)*(1-frac_y)*(  frac_z), (1-frac_x)*(1-frac_y)*(1-frac_z) };
+        const std::size_t voxels[] = { index[0]   + w*(index[1]  + h*index[2]  ), index[0]   + w*(index[1]+1+ h*index[2]  ),
+                                       index[0]   + w*(index[1]  + h*index[2]+h), index[0]   + w*(index[1]+1+ h*index[2]+h),
+                                       index[0]+1 + w*(index[1]  + h*index[2]  ), index[0]+1 + w*(index[1]  + h*index[2]+h),
+                                       index[0]+1 + w*(index[1]+1+ h*index[2]  ), index[0]+1 + w*(index[1]+1+ h*index[2]+h) };
+        for (int i=0; i<8; i++)
+        {
+#pragma omp atomic
+            densityBuffer[voxels[i]] += m_BinaryOutput ? 1 : weights[i];
+        }
+    };
+
+    // exact traversal of the voxels passed by a segment (Amanatides & Woo), each voxel receives the length of the segment inside the voxel
+    auto addSegment = [&](const float* p1, const float* p2, float valuePerMm)
+    {
+        itk::Point<double, 3> start;
+        itk::Point<double, 3> end;
+        for (int i=0; i<3; i++)
+        {
+            start[i] = p1[i];
+            end[i] = p2[i];
+        }
+        const double length = start.EuclideanDistanceTo(end);
+        if (length<=0)
+            return;
+        itk::ContinuousIndex<double, 3> a;
+        itk::ContinuousIndex<double, 3> b;
+        outImage->TransformPhysicalPointToContinuousIndex(start, a);
+        outImage->TransformPhysicalPointToContinuousIndex(end, b);
+
+        // voxel i covers the continuous indices [i-0.5, i+0.5), t runs from 0 (start) to 1 (end)
+        int voxel[3];
+        int step[3];
+        double tMax[3];
+        double tDelta[3];
+        for (int i=0; i<3; i++)
+        {
+            const double dir = b[i]-a[i];
+            voxel[i] = static_cast<int>(std::floor(a[i]+0.5));
+            step[i] = dir>0 ? 1 : -1;
+            if (dir!=0)
             {
-                index[0] -= 1;
-                frac_x += 1;
+                tMax[i] = (voxel[i]+0.5*step[i]-a[i])/dir;
+                tDelta[i] = step[i]/dir;
             }
-            if (frac_y<0)
+            else
             {
-                index[1] -= 1;
-                frac_y += 1;
+                tMax[i] = std::numeric_limits<double>::max();
+                tDelta[i] = 0;
             }
-            if (frac_z<0)
+        }
+
+        double t = 0;
+        while (t<1)
+        {
+            const int axis = tMax[0]<tMax[1] ? (tMax[0]<tMax[2] ? 0 : 2) : (tMax[1]<tMax[2] ? 1 : 2);
+            const double tNext = std::min(tMax[axis], 1.0);
+            if (tNext>t && voxel[0]>=0 && voxel[0]<w && voxel[1]>=0 && voxel[1]<h && voxel[2]>=0 && voxel[2]<d)
             {
-                index[2] -= 1;
-                frac_z += 1;
+                const float value = m_BinaryOutput ? 1 : (tNext-t)*length*valuePerMm;
+#pragma omp atomic
+                densityBuffer[voxel[0] + w*(voxel[1] + static_cast<std::size_t>(h)*voxel[2])] += value;
             }
+            t = tNext;
+            voxel[axis] += step[axis];
+            tMax[axis] += tDelta[axis];
+        }
+    };
 
-            frac_x = 1-frac_x;
-            frac_y = 1-frac_y;
-            frac_z = 1-frac_z;
-
-            // int coordinates inside image?
-            if (index[0] < 0 || index[0] >= w-1)
-                continue;
-            if (index[1] < 0 || index[1] >= h-1)
-                continue;
-            if (index[2] < 0 || index[2] >= d-1)
-                continue;
+    // nearest neighbor: each point of a fiber resampled to minSpacing/10 adds 0.01*weight, which is 0.1*weight/minSpacing per mm
+    const float stepSize = minSpacing/10;
+    auto addFibers = [&](const mitk::FiberContainer& fibers, std::size_t first, std::size_t count, const float* fiberWeights)
+    {
+        const int end = static_cast<int>(first+count);
+#pragma omp parallel for schedule(dynamic, 16)
+        for( int i=static_cast<int>(first); i<end; i++ )
+        {
+            const float* points = fibers.GetPoints(i);
+            const int numPoints = static_cast<int>(fibers.GetNumberOfPoints(i));
+            const float weight = fiberWeights!=nullptr ? fiberWeights[i] : 1;
+            const float pointValue = m_BinaryOutput ? 1 : (m_UseTrilinearInterpolation ? 1 : 0.01*weight);
 
-            if (m_BinaryOutput)
+            if (!m_DoFiberResampling || numPoints==1)
+            {
+                for( int j=0; j<numPoints; j++)
+                    addPoint(points+3*j, pointValue);
+            }
+            else if (m_UseTrilinearInterpolation)
             {
-                outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]  ))] = 1;
-                outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]  ))] = 1;
-                outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]+h))] = 1;
-                outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]+h))] = 1;
-                outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]  ))] = 1;
-                outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]+h))] = 1;
-                outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]  ))] = 1;
-                outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]+h))] = 1;
+                // sample the segments with the resampling step size on the fly
+                for( int j=0; j<numPoints-1; j++)
+                {
+                    const float* p1 = points+3*j;
+                    const float* p2 = points+3*j+3;
+                    const float length = std::sqrt((p2[0]-p1[0])*(p2[0]-p1[0])+(p2[1]-p1[1])*(p2[1]-p1[1])+(p2[2]-p1[2])*(p2[2]-p1[2]));
+                    const int numSamples = std::max(1, static_cast<int>(std::ceil(length/stepSize)));
+                    for (int k=0; k<numSamples; k++)
+                    {
+                        const float f = static_cast<float>(k)/numSamples;
+                        const float p[] = { p1[0]+f*(p2[0]-p1[0]), p1[1]+f*(p2[1]-p1[1]), p1[2]+f*(p2[2]-p1[2]) };
+                        addPoint(p, pointValue);
+                    }
+                }
+                addPoint(points+3*(numPoints-1), pointValue);
             }
             else
             {
-                outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]  ))] += (  frac_x)*(  frac_y)*(  frac_z);
-                outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]  ))] += (  frac_x)*(1-frac_y)*(  frac_z);
-                outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]+h))] += (  frac_x)*(  frac_y)*(1-frac_z);
-                outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]+h))] += (  frac_x)*(1-frac_y)*(1-frac_z);
-                outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]  ))] += (1-frac_x)*(  frac_y)*(  frac_z);
-                outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]+h))] += (1-frac_x)*(  frac_y)*(1-frac_z);
-                outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]  ))] += (1-frac_x)*(1-frac_y)*(  frac_z);
-                outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]+h))] += (1-frac_x)*(1-frac_y)*(1-frac_z);
+                for( int j=0; j<numPoints-1; j++)
+                    addSegment(points+3*j, points+3*j+3, 0.1*weight/minSpacing);
             }
         }
+    };
+
+    MITK_INFO << "TractDensityImageFilter: starting image generation";
+    if (m_TractogramReader!=nullptr)
+    {
+        boost::progress_display disp(m_TractogramReader->GetNumberOfFibers());
+        m_TractogramReader->StreamFibers([&](const mitk::FiberContainer& fibers, std::size_t)
+        {
+            addFibers(fibers, 0, fibers.GetNumberOfFibers(), nullptr);
+            disp += fibers.GetNumberOfFibers();
+        });
+    }
+    else
+    {
+        const mitk::FiberContainer& fibers = m_FiberBundle->GetFiberContainer();
+        const std::size_t numFibers = fibers.GetNumberOfFibers();
+        std::vector< float > fiberWeights(numFibers);
+        for (std::size_t i=0; i<numFibers; i++)
+            fiberWeights[i] = m_FiberBundle->GetFiberWeight(i);
+
+        const std::size_t fibersPerChunk = 10000;
+        boost::progress_display disp(numFibers);
+        for (std::size_t first=0; first<numFibers; first+=fibersPerChunk)
+        {
+            const std::size_t count = std::min(fibersPerChunk, numFibers-first);
+            addFibers(fibers, first, count, fiberWeights.data());
+            disp += count;
+        }
     }
 
     m_MaxDensity = 0;
-    for (int i=0; i<w*h*d; i++)
+    for (std::size_t i=0; i<density.size(); i++)
+    {
+        if (m_BinaryOutput)
+            outImageBufferPointer[i] = density[i]>0 ? 1 : 0;
+        else
+            outImageBufferPointer[i] = density[i];
         if (m_MaxDensity < outImageBufferPointer[i])
             m_MaxDensity = outImageBufferPointer[i];
+    }
+    std::vector< float >().swap(density);
+
     if (!m_OutputAbsoluteValues && !m_BinaryOutput)
     {
         MITK_INFO << "TractDensityImageFilter: max-normalizing output image";
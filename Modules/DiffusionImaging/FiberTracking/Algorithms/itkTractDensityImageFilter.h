@@ -21,11 +21,17 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkVectorContainer.h>
 #include <itkRGBAPixel.h>
 #include <mitkFiberBundle.h>
+#include <mitkTractogramFile.h>
 
 namespace itk{
 
 /**
-* \brief Generates tract density images from input fiberbundles (Calamante 2010).   */
+* \brief Generates tract density images from input fiberbundles (Calamante 2010).
+*
+* If fiber resampling is enabled, the exact length of each fiber segment inside each voxel is accumulated instead
+* of resampling a copy of the fibers. The fibers are processed in parallel. Instead of a fiber bundle, the fibers
+* can be streamed from a .tck or .trk file, so the memory does not depend on the size of the tractogram.
+*/
 
 template< class OutputImageType >
 class TractDensityImageFilter : public ImageSource< OutputImageType >
@@ -57,7 +63,8 @@ public:
   itkSetMacro( InputImage, typename OutputImageType::Pointer)   ///< use input image geometry to initialize output image
   itkSetMacro( UseTrilinearInterpolation, bool )
   itkSetMacro( DoFiberResampling, bool )
-  itkSetMacro( WorkOnFiberCopy, bool )
+  itkSetMacro( WorkOnFiberCopy, bool )                          ///< obsolete, the input fibers are not modified anymore
+  itkSetMacro( TractogramReader, const mitk::TractogramFileReader* ) ///< stream the fibers from file instead of using the fiber bundle
   itkGetMacro( MaxDensity, OutPixelType)
 
   void GenerateData();
@@ -79,6 +86,7 @@ protected:
   bool                              m_UseTrilinearInterpolation;
   bool                              m_DoFiberResampling;
   bool                              m_WorkOnFiberCopy;
+  const mitk::TractogramFileReader* m_TractogramReader;     ///< streamed input fibers
   OutPixelType                      m_MaxDensity;
 };
 
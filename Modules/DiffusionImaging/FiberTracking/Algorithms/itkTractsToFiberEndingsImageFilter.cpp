@@ -15,10 +15,6 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 #include "itkTractsToFiberEndingsImageFilter.h"
 
-// VTK
-#include <vtkPolyLine.h>
-#include <vtkCellArray.h>
-#include <vtkCellData.h>
 #include <boost/progress.hpp>
 
 namespace itk{
@@ -30,6 +26,7 @@ namespace itk{
     , m_InputImage(nullptr)
     , m_UseImageGeometry(false)
     , m_BinaryOutput(false)
+    , m_TractogramReader(nullptr)
   {
 
   }
@@ -52,8 +49,10 @@ namespace itk{
   template< class OutputImageType >
   void TractsToFiberEndingsImageFilter< OutputImageType >::GenerateData()
   {
+    if (m_TractogramReader==nullptr && m_FiberBundle.IsNull())
+      itkExceptionMacro("No input fibers set!");
+
     // generate upsampled image
-    mitk::BaseGeometry::Pointer geometry = m_FiberBundle->GetGeometry();
     typename OutputImageType::Pointer outImage = this->GetOutput();
 
     // calculate new image parameters
@@ -75,6 +74,7 @@ namespace itk{
     }
     else
     {
+      mitk::BaseGeometry::Pointer geometry = m_TractogramReader!=nullptr ? m_TractogramReader->GetBoundingGeometry() : m_FiberBundle->GetGeometry();
       newSpacing = geometry->GetSpacing()/m_UpsamplingFactor;
       newOrigin = geometry->GetOrigin();
       mitk::Geometry3D::BoundsArrayType bounds = geometry->GetBounds();
@@ -107,50 +107,57 @@ namespace itk{
     for (int i=0; i<w*h*d; i++)
       outImageBufferPointer[i] = 0;
 
-    // resample fiber bundle
-    float minSpacing = 1;
-    if(newSpacing[0]<newSpacing[1] && newSpacing[0]<newSpacing[2])
-        minSpacing = newSpacing[0];
-    else if (newSpacing[1] < newSpacing[2])
-        minSpacing = newSpacing[1];
-    else
-        minSpacing = newSpacing[2];
-
-    vtkSmartPointer<vtkPolyData> fiberPolyData = m_FiberBundle->GetFiberPolyData();
-
-    int numFibers = m_FiberBundle->GetNumFibers();
-    boost::progress_display disp(numFibers);
-    for( int i=0; i<numFibers; i++ )
+    // the fibers are processed in parallel, so the endings are counted using atomic updates
+    std::vector< unsigned int > endings(static_cast<std::size_t>(w)*h*d, 0);
+    unsigned int* endingsBuffer = endings.data();
+    auto addPoint = [&](const float* p)
     {
-        ++disp;
-      vtkCell* cell = fiberPolyData->GetCell(i);
-      int numPoints = cell->GetNumberOfPoints();
-      vtkPoints* points = cell->GetPoints();
-
-      // fill output image
-      if (numPoints>0)
+      itk::Point<float, 3> vertex;
+      vertex[0] = p[0];
+      vertex[1] = p[1];
+      vertex[2] = p[2];
+      itk::Index<3> index;
+      outImage->TransformPhysicalPointToIndex(vertex, index);
+      if (upsampledRegion.IsInside(index))
       {
-        itk::Point<float, 3> vertex = GetItkPoint(points->GetPoint(0));
-        itk::Index<3> index;
-        outImage->TransformPhysicalPointToIndex(vertex, index);
-        if (upsampledRegion.IsInside(index))
-          if (m_BinaryOutput)
-              outImage->SetPixel(index, 1);
-          else
-              outImage->SetPixel(index, outImage->GetPixel(index)+1);
+#pragma omp atomic
+        endingsBuffer[index[0] + w*(index[1] + h*index[2])] += 1;
       }
+    };
 
-      if (numPoints>=2)
+    auto addFibers = [&](const mitk::FiberContainer& fibers)
+    {
+      const int numFibers = static_cast<int>(fibers.GetNumberOfFibers());
+#pragma omp parallel for
+      for( int i=0; i<numFibers; i++ )
       {
-        itk::Point<float, 3> vertex = GetItkPoint(points->GetPoint(numPoints-1));
-        itk::Index<3> index;
-        outImage->TransformPhysicalPointToIndex(vertex, index);
-        if (upsampledRegion.IsInside(index))
-          if (m_BinaryOutput)
-              outImage->SetPixel(index, 1);
-          else
-              outImage->SetPixel(index, outImage->GetPixel(index)+1);
+        const float* points = fibers.GetPoints(i);
+        const int numPoints = static_cast<int>(fibers.GetNumberOfPoints(i));
+        if (numPoints>0)
+          addPoint(points);
+        if (numPoints>=2)
+          addPoint(points+3*(numPoints-1));
       }
+    };
+
+    if (m_TractogramReader!=nullptr)
+    {
+      boost::progress_display disp(m_TractogramReader->GetNumberOfFibers());
+      m_TractogramReader->StreamFibers([&](const mitk::FiberContainer& fibers, std::size_t)
+      {
+        addFibers(fibers);
+        disp += fibers.GetNumberOfFibers();
+      });
+    }
+    else
+      addFibers(m_FiberBundle->GetFiberContainer());
+
+    for (std::size_t i=0; i<endings.size(); i++)
+    {
+      if (m_BinaryOutput)
+        outImageBufferPointer[i] = endings[i]>0 ? 1 : 0;
+      else
+        outImageBufferPointer[i] = endings[i];
     }
 
     if (m_InvertImage)
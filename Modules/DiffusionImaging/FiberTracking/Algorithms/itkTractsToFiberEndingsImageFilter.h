@@ -21,11 +21,15 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkVectorContainer.h>
 #include <itkRGBAPixel.h>
 #include <mitkFiberBundle.h>
+#include <mitkTractogramFile.h>
 
 namespace itk{
 
 /**
-* \brief Generates image where the pixel values are set according to the number of fibers ending in the voxel.   */
+* \brief Generates image where the pixel values are set according to the number of fibers ending in the voxel.
+*
+* The fibers are processed in parallel and can be streamed from a .tck or .trk file instead of a fiber bundle.
+*/
 
 template< class OutputImageType >
 class TractsToFiberEndingsImageFilter : public ImageSource< OutputImageType >
@@ -60,6 +64,9 @@ public:
 
   itkSetMacro( BinaryOutput, bool)
 
+  /** Stream the fibers from file instead of using the fiber bundle **/
+  itkSetMacro( TractogramReader, const mitk::TractogramFileReader* )
+
   void GenerateData();
 
 protected:
@@ -75,6 +82,7 @@ protected:
   bool                              m_UseImageGeometry;     ///< output image is given other geometry than fiberbundle (input image geometry)
   bool                              m_BinaryOutput;
   typename OutputImageType::Pointer m_InputImage;
+  const mitk::TractogramFileReader* m_TractogramReader;     ///< streamed input fibers
 };
 
 }
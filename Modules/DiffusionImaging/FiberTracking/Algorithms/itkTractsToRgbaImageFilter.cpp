@@ -15,14 +15,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 #include "itkTractsToRgbaImageFilter.h"
 
-// VTK
-#include <vtkPolyLine.h>
-#include <vtkCellArray.h>
-#include <vtkCellData.h>
-
 // misc
 #include <math.h>
-#include <boost/progress.hpp>
+#include <algorithm>
 
 namespace itk{
 
@@ -108,9 +103,8 @@ namespace itk{
 
     // set/initialize output
     unsigned char* outImageBufferPointer = (unsigned char*)outImage->GetBufferPointer();
-    float* buffer = new float[w*h*d*4];
-    for (int i=0; i<w*h*d*4; i++)
-      buffer[i] = 0;
+    std::vector< float > colors(static_cast<std::size_t>(w)*h*d*4, 0);
+    float* buffer = colors.data();
 
     // resample fiber bundle
     float minSpacing = 1;
@@ -121,135 +115,101 @@ namespace itk{
     else
         minSpacing = newSpacing[2];
 
-    m_FiberBundle = m_FiberBundle->GetDeepCopy();
-    m_FiberBundle->ResampleLinear(minSpacing);
-
-    vtkSmartPointer<vtkPolyData> fiberPolyData = m_FiberBundle->GetFiberPolyData();
-
-    int numFibers = m_FiberBundle->GetNumFibers();
-    boost::progress_display disp(numFibers);
-    for( int i=0; i<numFibers; i++ )
+    const float scale = 100 * pow((float)m_UpsamplingFactor,3);
+    auto addPoint = [&](const float* p, const float rgbweight[3], float intweight)
     {
-      ++disp;
-      vtkCell* cell = fiberPolyData->GetCell(i);
-      int numPoints = cell->GetNumberOfPoints();
-      vtkPoints* points = cell->GetPoints();
-
-      // calc directions (which are used as weights)
-      std::list< itk::Point<float, 3> > rgbweights;
-      std::list<float> intensities;
-
-      for( int j=0; j<numPoints-1; j++)
+      itk::Point<float, 3> vertex;
+      vertex[0] = p[0];
+      vertex[1] = p[1];
+      vertex[2] = p[2];
+      itk::Index<3> index;
+      itk::ContinuousIndex<float, 3> contIndex;
+      outImage->TransformPhysicalPointToIndex(vertex, index);
+      outImage->TransformPhysicalPointToContinuousIndex(vertex, contIndex);
+
+      float frac_x = contIndex[0] - index[0];
+      float frac_y = contIndex[1] - index[1];
+      float frac_z = contIndex[2] - index[2];
+
+      int px = index[0];
+      if (frac_x<0)
       {
+        px -= 1;
+        frac_x += 1;
+      }
 
-        itk::Point<float, 3> vertex = GetItkPoint(points->GetPoint(j));
-        itk::Point<float, 3> vertexPost = GetItkPoint(points->GetPoint(j+1));
-
-        itk::Point<float, 3> dir;
-        dir[0] = fabs((vertexPost[0] - vertex[0]) * outImage->GetSpacing()[0]);
-        dir[1] = fabs((vertexPost[1] - vertex[1]) * outImage->GetSpacing()[1]);
-        dir[2] = fabs((vertexPost[2] - vertex[2]) * outImage->GetSpacing()[2]);
-
-        rgbweights.push_back(dir);
-
-        float intensity = sqrt(dir[0]*dir[0]+dir[1]*dir[1]+dir[2]*dir[2]);
-        intensities.push_back(intensity);
-
-        // last point gets same as previous one
-        if(j==numPoints-2)
-        {
-          rgbweights.push_back(dir);
-          intensities.push_back(intensity);
-        }
+      int py = index[1];
+      if (frac_y<0)
+      {
+        py -= 1;
+        frac_y += 1;
       }
 
-      // fill output image
-      for( int j=0; j<numPoints; j++)
+      int pz = index[2];
+      if (frac_z<0)
       {
-        itk::Point<float, 3> vertex = GetItkPoint(points->GetPoint(j));
-        itk::Index<3> index;
-        itk::ContinuousIndex<float, 3> contIndex;
-        outImage->TransformPhysicalPointToIndex(vertex, index);
-        outImage->TransformPhysicalPointToContinuousIndex(vertex, contIndex);
-
-        float frac_x = contIndex[0] - index[0];
-        float frac_y = contIndex[1] - index[1];
-        float frac_z = contIndex[2] - index[2];
-
-        int px = index[0];
-        if (frac_x<0)
-        {
-          px -= 1;
-          frac_x += 1;
-        }
+        pz -= 1;
+        frac_z += 1;
+      }
 
-        int py = index[1];
-        if (frac_y<0)
+      // int coordinates inside image?
+      if (px < 0 || px >= w-1)
+        return;
+      if (py < 0 || py >= h-1)
+        return;
+      if (pz < 0 || pz >= d-1)
+        return;
+
+      const float weights[] = { (1-frac_x)*(1-frac_y)*(1-frac_z), (1-frac_x)*(  frac_y)*(1-frac_z),
+                                (1-frac_x)*(1-frac_y)*(  frac_z), (1-frac_x)*(  frac_y)*(  frac_z),
+                                (  frac_x)*(1-frac_y)*(1-frac_z), (  frac_x)*(1-frac_y)*(  frac_z),
+                                (  frac_x)*(  frac_y)*(1-frac_z), (  frac_x)*(  frac_y)*(  frac_z) };
+      const std::size_t voxels[] = { px   + w*(py  + h*pz  ), px   + w*(py+1+ h*pz  ),
+                                     px   + w*(py  + h*pz+h), px   + w*(py+1+ h*pz+h),
+                                     px+1 + w*(py  + h*pz  ), px+1 + w*(py  + h*pz+h),
+                                     px+1 + w*(py+1+ h*pz  ), px+1 + w*(py+1+ h*pz+h) };
+      const float values[] = { rgbweight[0]*scale, rgbweight[1]*scale, rgbweight[2]*scale, intweight*scale };
+
+      // add to r-, g-, b- and a-channel in output image
+      for (int i=0; i<8; i++)
+        for (int c=0; c<4; c++)
         {
-          py -= 1;
-          frac_y += 1;
+#pragma omp atomic
+          buffer[c+4*voxels[i]] += weights[i]*values[c];
         }
+    };
 
-        int pz = index[2];
-        if (frac_z<0)
+    // the segments are sampled with minSpacing on the fly instead of resampling a copy of the fibers
+    const mitk::FiberContainer& fibers = m_FiberBundle->GetFiberContainer();
+    int numFibers = m_FiberBundle->GetNumFibers();
+#pragma omp parallel for schedule(dynamic, 16)
+    for( int i=0; i<numFibers; i++ )
+    {
+      const float* points = fibers.GetPoints(i);
+      const int numPoints = static_cast<int>(fibers.GetNumberOfPoints(i));
+      for( int j=0; j<numPoints-1; j++)
+      {
+        const float* p1 = points+3*j;
+        const float* p2 = points+3*j+3;
+        const float length = std::sqrt((p2[0]-p1[0])*(p2[0]-p1[0])+(p2[1]-p1[1])*(p2[1]-p1[1])+(p2[2]-p1[2])*(p2[2]-p1[2]));
+        const int numSamples = std::max(1, static_cast<int>(std::ceil(length/minSpacing)));
+
+        // calc directions (which are used as weights)
+        float dir[3];
+        for (int k=0; k<3; k++)
+          dir[k] = fabs((p2[k] - p1[k])/numSamples * outImage->GetSpacing()[k]);
+        const float intensity = sqrt(dir[0]*dir[0]+dir[1]*dir[1]+dir[2]*dir[2]);
+
+        for (int k=0; k<numSamples; k++)
         {
-          pz -= 1;
-          frac_z += 1;
+          const float f = static_cast<float>(k)/numSamples;
+          const float p[] = { p1[0]+f*(p2[0]-p1[0]), p1[1]+f*(p2[1]-p1[1]), p1[2]+f*(p2[2]-p1[2]) };
+          addPoint(p, dir, intensity);
         }
 
-        // int coordinates inside image?
-        if (px < 0 || px >= w-1)
-          continue;
-        if (py < 0 || py >= h-1)
-          continue;
-        if (pz < 0 || pz >= d-1)
-          continue;
-
-        float scale = 100 * pow((float)m_UpsamplingFactor,3);
-        itk::Point<float, 3> rgbweight = rgbweights.front();
-        rgbweights.pop_front();
-        float intweight = intensities.front();
-        intensities.pop_front();
-
-        // add to r-channel in output image
-        buffer[0+4*( px   + w*(py  + h*pz  ))] += (1-frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px   + w*(py+1+ h*pz  ))] += (1-frac_x)*(  frac_y)*(1-frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px   + w*(py  + h*pz+h))] += (1-frac_x)*(1-frac_y)*(  frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px   + w*(py+1+ h*pz+h))] += (1-frac_x)*(  frac_y)*(  frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px+1 + w*(py  + h*pz  ))] += (  frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px+1 + w*(py  + h*pz+h))] += (  frac_x)*(1-frac_y)*(  frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px+1 + w*(py+1+ h*pz  ))] += (  frac_x)*(  frac_y)*(1-frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px+1 + w*(py+1+ h*pz+h))] += (  frac_x)*(  frac_y)*(  frac_z) * rgbweight[0] * scale;
-
-        // add to g-channel in output image
-        buffer[1+4*( px   + w*(py  + h*pz  ))] += (1-frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px   + w*(py+1+ h*pz  ))] += (1-frac_x)*(  frac_y)*(1-frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px   + w*(py  + h*pz+h))] += (1-frac_x)*(1-frac_y)*(  frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px   + w*(py+1+ h*pz+h))] += (1-frac_x)*(  frac_y)*(  frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px+1 + w*(py  + h*pz  ))] += (  frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px+1 + w*(py  + h*pz+h))] += (  frac_x)*(1-frac_y)*(  frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px+1 + w*(py+1+ h*pz  ))] += (  frac_x)*(  frac_y)*(1-frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px+1 + w*(py+1+ h*pz+h))] += (  frac_x)*(  frac_y)*(  frac_z) * rgbweight[1] * scale;
-
-        // add to b-channel in output image
-        buffer[2+4*( px   + w*(py  + h*pz  ))] += (1-frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px   + w*(py+1+ h*pz  ))] += (1-frac_x)*(  frac_y)*(1-frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px   + w*(py  + h*pz+h))] += (1-frac_x)*(1-frac_y)*(  frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px   + w*(py+1+ h*pz+h))] += (1-frac_x)*(  frac_y)*(  frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px+1 + w*(py  + h*pz  ))] += (  frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px+1 + w*(py  + h*pz+h))] += (  frac_x)*(1-frac_y)*(  frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px+1 + w*(py+1+ h*pz  ))] += (  frac_x)*(  frac_y)*(1-frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px+1 + w*(py+1+ h*pz+h))] += (  frac_x)*(  frac_y)*(  frac_z) * rgbweight[2] * scale;
-
-        // add to a-channel in output image
-        buffer[3+4*( px   + w*(py  + h*pz  ))] += (1-frac_x)*(1-frac_y)*(1-frac_z) * intweight * scale;
-        buffer[3+4*( px   + w*(py+1+ h*pz  ))] += (1-frac_x)*(  frac_y)*(1-frac_z) * intweight * scale;
-        buffer[3+4*( px   + w*(py  + h*pz+h))] += (1-frac_x)*(1-frac_y)*(  frac_z) * intweight * scale;
-        buffer[3+4*( px   + w*(py+1+ h*pz+h))] += (1-frac_x)*(  frac_y)*(  frac_z) * intweight * scale;
-        buffer[3+4*( px+1 + w*(py  + h*pz  ))] += (  frac_x)*(1-frac_y)*(1-frac_z) * intweight * scale;
-        buffer[3+4*( px+1 + w*(py  + h*pz+h))] += (  frac_x)*(1-frac_y)*(  frac_z) * intweight * scale;
-        buffer[3+4*( px+1 + w*(py+1+ h*pz  ))] += (  frac_x)*(  frac_y)*(1-frac_z) * intweight * scale;
-        buffer[3+4*( px+1 + w*(py+1+ h*pz+h))] += (  frac_x)*(  frac_y)*(  frac_z) * intweight * scale;
+        // last point gets same as previous one
+        if(j==numPoints-2)
+          addPoint(p2, dir, intensity);
       }
     }
     float maxRgb = 0.000000001;
@@ -40,12 +40,15 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkPolygon.h>
 #include <vtkCleanPolyData.h>
 #include <cmath>
+#include <limits>
+#include <numeric>
 #include <boost/progress.hpp>
 #include <vtkTransformPolyDataFilter.h>
 #include <mitkTransferFunction.h>
 #include <vtkLookupTable.h>
 #include <mitkLookupTable.h>
 #include <vtkCardinalSpline.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
 
 const char* mitk::FiberBundle::FIBER_ID_ARRAY = "Fiber_IDs";
 
@@ -75,7 +78,7 @@ mitk::FiberBundle::~FiberBundle()
 
 mitk::FiberBundle::Pointer mitk::FiberBundle::GetDeepCopy()
 {
-    mitk::FiberBundle::Pointer newFib = mitk::FiberBundle::New(m_FiberPolyData);
+    mitk::FiberBundle::Pointer newFib = mitk::FiberBundle::New(this->GetFiberPolyData());
     newFib->SetFiberColors(this->m_FiberColors);
     newFib->SetFiberWeights(this->m_FiberWeights);
     return newFib;
@@ -87,6 +90,9 @@ vtkSmartPointer<vtkPolyData> mitk::FiberBundle::GeneratePolyDataByIds(std::vecto
     vtkSmartPointer<vtkCellArray> newLineSet = vtkSmartPointer<vtkCellArray>::New();
     vtkSmartPointer<vtkPoints> newPointSet = vtkSmartPointer<vtkPoints>::New();
 
+    if (m_FiberIdDataSet==nullptr)
+        this->GenerateFiberIds();
+
     auto finIt = fiberIds.begin();
     while ( finIt != fiberIds.end() )
     {
@@ -134,9 +140,9 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::AddBundle(mitk::FiberBundle* fib)
     weights->SetNumberOfValues(this->GetNumFibers()+fib->GetNumFibers());
 
     unsigned int counter = 0;
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+    for (int i=0; i<GetFiberPolyData()->GetNumberOfCells(); i++)
     {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
+        vtkCell* cell = GetFiberPolyData()->GetCell(i);
         int numPoints = cell->GetNumberOfPoints();
         vtkPoints* points = cell->GetPoints();
 
@@ -194,85 +200,24 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::SubtractBundle(mitk::FiberBundle*
     vtkSmartPointer<vtkCellArray> vNewLines = vtkSmartPointer<vtkCellArray>::New();
     vtkSmartPointer<vtkPoints> vNewPoints = vtkSmartPointer<vtkPoints>::New();
 
-    std::vector< std::vector< itk::Point<float, 3> > > points1;
+    // keep the fibers without a fiber with the same endpoints (in either direction) in fib
+    const FiberSegmentIndex* index = fib->GetSegmentIndex();
+    boost::progress_display disp(m_NumFibers);
     for( int i=0; i<m_NumFibers; i++ )
     {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
+        ++disp;
+        vtkCell* cell = GetFiberPolyData()->GetCell(i);
         int numPoints = cell->GetNumberOfPoints();
         vtkPoints* points = cell->GetPoints();
 
         if (points==nullptr || numPoints<=0)
             continue;
 
-        itk::Point<float, 3> start = GetItkPoint(points->GetPoint(0));
-        itk::Point<float, 3> end = GetItkPoint(points->GetPoint(numPoints-1));
-
-        points1.push_back( {start, end} );
-    }
-
-    std::vector< std::vector< itk::Point<float, 3> > > points2;
-    for( int i=0; i<fib->GetNumFibers(); i++ )
-    {
-        vtkCell* cell = fib->GetFiberPolyData()->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        if (points==nullptr || numPoints<=0)
-            continue;
-
-        itk::Point<float, 3> start = GetItkPoint(points->GetPoint(0));
-        itk::Point<float, 3> end = GetItkPoint(points->GetPoint(numPoints-1));
-
-        points2.push_back( {start, end} );
-    }
-
-    int progress = 0;
-    std::vector< int > ids;
-#pragma omp parallel for
-    for (int i=0; i<points1.size(); i++)
-    {
-#pragma omp critical
-        {
-          progress++;
-          std::cout << (int)(100*(float)progress/points1.size()) << "%" << '\r';
-          cout.flush();
-        }
-
-        bool match = false;
-        for (int j=0; j<points2.size(); j++)
-        {
-            auto v1 = points1.at(i);
-            auto v2 = points2.at(j);
-
-            unsigned int matches = 0;
-            unsigned int reverse_matches = 0;
-            for (int c=0; c<v1.size(); c++)
-            {
-                if (v1[c].SquaredEuclideanDistanceTo(v2[c])<mitk::eps)
-                    matches++;
-                if (v1[v1.size() - c - 1].SquaredEuclideanDistanceTo(v2[c])<mitk::eps)
-                    reverse_matches++;
-            }
-
-            if (matches==v1.size() || reverse_matches==v1.size())
-            {
-                match = true;
-                j=points2.size();
-            }
-        }
-
-#pragma omp critical
-        if (!match)
-            ids.push_back(i);
-    }
-
-    for( int i : ids )
-    {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        if (points==nullptr || numPoints<=0)
+        double start[3];
+        double end[3];
+        points->GetPoint(0, start);
+        points->GetPoint(numPoints-1, end);
+        if (index->ContainsFiber(start, end, mitk::eps))
             continue;
 
         vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
@@ -307,13 +252,14 @@ itk::Point<float, 3> mitk::FiberBundle::GetItkPoint(double point[3])
  */
 void mitk::FiberBundle::SetFiberPolyData(vtkSmartPointer<vtkPolyData> fiberPD, bool updateGeometry)
 {
-    if (fiberPD == nullptr)
-        this->m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    else
-    {
-        m_FiberPolyData->DeepCopy(fiberPD);
+    vtkSmartPointer<vtkPolyData> fiberPolyData = vtkSmartPointer<vtkPolyData>::New();
+    if (fiberPD != nullptr)
+        fiberPolyData->DeepCopy(fiberPD);
+    m_FiberPolyData = fiberPolyData;
+    m_FiberContainer = nullptr;
+    m_SegmentIndex = nullptr;
+    if (fiberPD != nullptr)
         ColorFibersByOrientation();
-    }
 
     m_NumFibers = m_FiberPolyData->GetNumberOfLines();
 
@@ -327,9 +273,39 @@ void mitk::FiberBundle::SetFiberPolyData(vtkSmartPointer<vtkPolyData> fiberPD, b
  */
 vtkSmartPointer<vtkPolyData> mitk::FiberBundle::GetFiberPolyData() const
 {
+    if (m_FiberPolyData==nullptr)
+        m_FiberPolyData = m_FiberContainer->GetPolyData();
     return m_FiberPolyData;
 }
 
+const mitk::FiberContainer& mitk::FiberBundle::GetFiberContainer() const
+{
+    if (m_FiberContainer==nullptr)
+        m_FiberContainer = std::make_shared<FiberContainer>(m_FiberPolyData);
+    return *m_FiberContainer;
+}
+
+/*
+ * set the fibers of the container, the poly data is only created on request
+ */
+void mitk::FiberBundle::SetFiberContainer(std::shared_ptr< FiberContainer > container)
+{
+    m_FiberContainer = container;
+    m_FiberPolyData = nullptr;
+    m_FiberIdDataSet = nullptr;
+    m_SegmentIndex = nullptr;
+
+    ColorFibersByOrientation();
+    UpdateFiberGeometry();
+}
+
+const mitk::FiberSegmentIndex* mitk::FiberBundle::GetSegmentIndex()
+{
+    if (m_SegmentIndex==nullptr)
+        m_SegmentIndex = std::make_shared<FiberSegmentIndex>(this->GetFiberPolyData());
+    return m_SegmentIndex.get();
+}
+
 void mitk::FiberBundle::ColorFibersByOrientation()
 {
     //===== FOR WRITING A TEST ========================
@@ -340,8 +316,49 @@ void mitk::FiberBundle::ColorFibersByOrientation()
     //  + one fiber with 0 points
     //=================================================
 
+    if (m_FiberPolyData==nullptr)
+    {
+        // the points of each fiber are contiguous in the container, so the fibers are colored in parallel
+        const FiberContainer& container = *m_FiberContainer;
+        const int numFibers = static_cast<int>(container.GetNumberOfFibers());
+        m_FiberColors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+        m_FiberColors->SetNumberOfComponents(4);
+        m_FiberColors->SetNumberOfTuples(container.GetNumberOfPoints());
+        m_FiberColors->SetName("FIBER_COLORS");
+        unsigned char* colors = m_FiberColors->GetPointer(0);
+
+#pragma omp parallel for
+        for (int i=0; i<numFibers; i++)
+        {
+            const float* p = container.GetPoints(i);
+            const int numPoints = static_cast<int>(container.GetNumberOfPoints(i));
+            unsigned char* rgba = colors + 4*container.GetPointOffset(i);
+            if (numPoints<2)
+            {
+                std::fill(rgba, rgba+4*numPoints, 0);
+                continue;
+            }
+            for (int j=0; j<numPoints; j++)
+            {
+                // central difference, one-sided at the start and end point
+                const float* prev = p + 3*std::max(j-1, 0);
+                const float* next = p + 3*std::min(j+1, numPoints-1);
+                vnl_vector_fixed< double, 3 > diff(next[0]-prev[0], next[1]-prev[1], next[2]-prev[2]);
+                diff.normalize();
+
+                rgba[4*j] = (unsigned char) (255.0 * std::fabs(diff[0]));
+                rgba[4*j+1] = (unsigned char) (255.0 * std::fabs(diff[1]));
+                rgba[4*j+2] = (unsigned char) (255.0 * std::fabs(diff[2]));
+                rgba[4*j+3] = (unsigned char) (255.0);
+            }
+        }
+        m_UpdateTime3D.Modified();
+        m_UpdateTime2D.Modified();
+        return;
+    }
+
     vtkPoints* extrPoints = nullptr;
-    extrPoints = m_FiberPolyData->GetPoints();
+    extrPoints = GetFiberPolyData()->GetPoints();
     int numOfPoints = 0;
     if (extrPoints!=nullptr)
         numOfPoints = extrPoints->GetNumberOfPoints();
@@ -354,12 +371,12 @@ void mitk::FiberBundle::ColorFibersByOrientation()
     m_FiberColors->SetNumberOfComponents(componentSize);
     m_FiberColors->SetName("FIBER_COLORS");
 
-    int numOfFibers = m_FiberPolyData->GetNumberOfLines();
+    int numOfFibers = GetFiberPolyData()->GetNumberOfLines();
     if (numOfFibers < 1)
         return;
 
     /* extract single fibers of fiberBundle */
-    vtkCellArray* fiberList = m_FiberPolyData->GetLines();
+    vtkCellArray* fiberList = GetFiberPolyData()->GetLines();
     fiberList->InitTraversal();
     for (int fi=0; fi<numOfFibers; ++fi) {
 
@@ -453,7 +470,7 @@ void mitk::FiberBundle::ColorFibersByCurvature(bool minMaxNorm)
     unsigned char rgba[4] = {0,0,0,0};
     int componentSize = 4;
     m_FiberColors = vtkSmartPointer<vtkUnsignedCharArray>::New();
-    m_FiberColors->Allocate(m_FiberPolyData->GetNumberOfPoints() * componentSize);
+    m_FiberColors->Allocate(GetFiberPolyData()->GetNumberOfPoints() * componentSize);
     m_FiberColors->SetNumberOfComponents(componentSize);
     m_FiberColors->SetName("FIBER_COLORS");
 
@@ -468,11 +485,11 @@ void mitk::FiberBundle::ColorFibersByCurvature(bool minMaxNorm)
     double min = 1;
     double max = 0;
     MITK_INFO << "Coloring fibers by curvature";
-    boost::progress_display disp(m_FiberPolyData->GetNumberOfCells());
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+    boost::progress_display disp(GetFiberPolyData()->GetNumberOfCells());
+    for (int i=0; i<GetFiberPolyData()->GetNumberOfCells(); i++)
     {
         ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
+        vtkCell* cell = GetFiberPolyData()->GetCell(i);
         int numPoints = cell->GetNumberOfPoints();
         vtkPoints* points = cell->GetPoints();
 
@@ -545,9 +562,9 @@ void mitk::FiberBundle::ColorFibersByCurvature(bool minMaxNorm)
         }
     }
     unsigned int count = 0;
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+    for (int i=0; i<GetFiberPolyData()->GetNumberOfCells(); i++)
     {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
+        vtkCell* cell = GetFiberPolyData()->GetCell(i);
         int numPoints = cell->GetNumberOfPoints();
         for (int j=0; j<numPoints; j++)
         {
@@ -601,14 +618,14 @@ template <typename TPixel>
 void mitk::FiberBundle::ColorFibersByScalarMap(const mitk::PixelType, mitk::Image::Pointer image, bool opacity)
 {
     m_FiberColors = vtkSmartPointer<vtkUnsignedCharArray>::New();
-    m_FiberColors->Allocate(m_FiberPolyData->GetNumberOfPoints() * 4);
+    m_FiberColors->Allocate(GetFiberPolyData()->GetNumberOfPoints() * 4);
     m_FiberColors->SetNumberOfComponents(4);
     m_FiberColors->SetName("FIBER_COLORS");
 
     mitk::ImagePixelReadAccessor<TPixel,3> readimage(image, image->GetVolumeData(0));
 
     unsigned char rgba[4] = {0,0,0,0};
-    vtkPoints* pointSet = m_FiberPolyData->GetPoints();
+    vtkPoints* pointSet = GetFiberPolyData()->GetPoints();
 
     mitk::LookupTable::Pointer mitkLookup = mitk::LookupTable::New();
     vtkSmartPointer<vtkLookupTable> lookupTable = vtkSmartPointer<vtkLookupTable>::New();
@@ -617,7 +634,7 @@ void mitk::FiberBundle::ColorFibersByScalarMap(const mitk::PixelType, mitk::Imag
     mitkLookup->SetVtkLookupTable(lookupTable);
     mitkLookup->SetType(mitk::LookupTable::JET);
 
-    for(long i=0; i<m_FiberPolyData->GetNumberOfPoints(); ++i)
+    for(long i=0; i<GetFiberPolyData()->GetNumberOfPoints(); ++i)
     {
         Point3D px;
         px[0] = pointSet->GetPoint(i)[0];
@@ -644,12 +661,12 @@ void mitk::FiberBundle::ColorFibersByScalarMap(const mitk::PixelType, mitk::Imag
 void mitk::FiberBundle::SetFiberColors(float r, float g, float b, float alpha)
 {
     m_FiberColors = vtkSmartPointer<vtkUnsignedCharArray>::New();
-    m_FiberColors->Allocate(m_FiberPolyData->GetNumberOfPoints() * 4);
+    m_FiberColors->Allocate(GetFiberPolyData()->GetNumberOfPoints() * 4);
     m_FiberColors->SetNumberOfComponents(4);
     m_FiberColors->SetName("FIBER_COLORS");
 
     unsigned char rgba[4] = {0,0,0,0};
-    for(long i=0; i<m_FiberPolyData->GetNumberOfPoints(); ++i)
+    for(long i=0; i<GetFiberPolyData()->GetNumberOfPoints(); ++i)
     {
         rgba[0] = (unsigned char) r;
         rgba[1] = (unsigned char) g;
@@ -663,11 +680,8 @@ void mitk::FiberBundle::SetFiberColors(float r, float g, float b, float alpha)
 
 void mitk::FiberBundle::GenerateFiberIds()
 {
-    if (m_FiberPolyData == nullptr)
-        return;
-
     vtkSmartPointer<vtkIdFilter> idFiberFilter = vtkSmartPointer<vtkIdFilter>::New();
-    idFiberFilter->SetInputData(m_FiberPolyData);
+    idFiberFilter->SetInputData(this->GetFiberPolyData());
     idFiberFilter->CellIdsOn();
     //  idFiberFilter->PointIdsOn(); // point id's are not needed
     idFiberFilter->SetIdsArrayName(FIBER_ID_ARRAY);
@@ -678,12 +692,57 @@ void mitk::FiberBundle::GenerateFiberIds()
 
 }
 
+// physical bounding box of the mask voxels with value > 0, false if there are none
+static bool GetMaskForegroundBounds(mitk::FiberBundle::ItkUcharImgType* mask, double bounds[6])
+{
+    itk::Index<3> lower;
+    itk::Index<3> upper;
+    bool found = false;
+    itk::ImageRegionConstIteratorWithIndex< mitk::FiberBundle::ItkUcharImgType > it(mask, mask->GetLargestPossibleRegion());
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+        if (it.Get()<=0)
+            continue;
+
+        const itk::Index<3> idx = it.GetIndex();
+        for (int d=0; d<3; ++d)
+        {
+            lower[d] = found ? std::min(lower[d], idx[d]) : idx[d];
+            upper[d] = found ? std::max(upper[d], idx[d]) : idx[d];
+        }
+        found = true;
+    }
+    if (!found)
+        return false;
+
+    // points are assigned to the nearest voxel, so the box extends half a voxel beyond the voxel centers
+    for (int d=0; d<3; ++d)
+    {
+        bounds[2*d] = std::numeric_limits<double>::max();
+        bounds[2*d+1] = -std::numeric_limits<double>::max();
+    }
+    for (int c=0; c<8; ++c)
+    {
+        itk::ContinuousIndex<double, 3> corner;
+        for (int d=0; d<3; ++d)
+            corner[d] = (c>>d) & 1 ? upper[d]+0.5 : lower[d]-0.5;
+        itk::Point<double, 3> p;
+        mask->TransformContinuousIndexToPhysicalPoint(corner, p);
+        for (int d=0; d<3; ++d)
+        {
+            bounds[2*d] = std::min(bounds[2*d], p[d]-0.001);
+            bounds[2*d+1] = std::max(bounds[2*d+1], p[d]+0.001);
+        }
+    }
+    return true;
+}
+
 mitk::FiberBundle::Pointer mitk::FiberBundle::ExtractFiberSubset(ItkUcharImgType* mask, bool anyPoint, bool invert, bool bothEnds, float fraction)
 {
-    vtkSmartPointer<vtkPolyData> PolyData = m_FiberPolyData;
+    float minSpacing = 1;
+    std::vector< bool > isCandidate;
     if (anyPoint)
     {
-        float minSpacing = 1;
         if(mask->GetSpacing()[0]<mask->GetSpacing()[1] && mask->GetSpacing()[0]<mask->GetSpacing()[2])
             minSpacing = mask->GetSpacing()[0];
         else if (mask->GetSpacing()[1] < mask->GetSpacing()[2])
@@ -691,9 +750,17 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::ExtractFiberSubset(ItkUcharImgType
         else
             minSpacing = mask->GetSpacing()[2];
 
-        mitk::FiberBundle::Pointer fibCopy = this->GetDeepCopy();
-        fibCopy->ResampleLinear(minSpacing/5);
-        PolyData = fibCopy->GetFiberPolyData();
+        // only fibers passing the bounding box of the mask foreground can have points inside of the mask
+        isCandidate.resize(m_NumFibers, false);
+        double maskBounds[6];
+        if (GetMaskForegroundBounds(mask, maskBounds))
+        {
+            for (long id : this->GetSegmentIndex()->GetCandidateFibers(maskBounds))
+            {
+                if (id<m_NumFibers)
+                    isCandidate[id] = true;
+            }
+        }
     }
     vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
     vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
@@ -704,14 +771,27 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::ExtractFiberSubset(ItkUcharImgType
     {
         ++disp;
 
-        vtkCell* cell = PolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkCell* cellOriginal = m_FiberPolyData->GetCell(i);
+        vtkCell* cellOriginal = GetFiberPolyData()->GetCell(i);
         int numPointsOriginal = cellOriginal->GetNumberOfPoints();
         vtkPoints* pointsOriginal = cellOriginal->GetPoints();
 
+        // the points of the linearly resampled fiber are tested, fibers outside of the foreground bounding box are
+        // only resampled if they are part of the inverted result
+        std::vector< vnl_vector_fixed< double, 3 > > points;
+        if (anyPoint && numPointsOriginal>0 && (isCandidate[i] || invert))
+        {
+            std::vector< vnl_vector_fixed< double, 3 > > vertices;
+            for (int j=0; j<numPointsOriginal; j++)
+            {
+                double* p = pointsOriginal->GetPoint(j);
+                vnl_vector_fixed< double, 3 > v;
+                v[0] = p[0]; v[1] = p[1]; v[2] = p[2];
+                vertices.push_back(v);
+            }
+            points = ResampleFiberLinear(vertices, minSpacing/5);
+        }
+        int numPoints = anyPoint ? static_cast<int>(points.size()) : numPointsOriginal;
+
         vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
 
         if (numPoints>1 && numPointsOriginal)
@@ -724,7 +804,7 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::ExtractFiberSubset(ItkUcharImgType
                 {
                     for (int j=0; j<numPoints; j++)
                     {
-                        double* p = points->GetPoint(j);
+                        const vnl_vector_fixed< double, 3 >& p = points.at(j);
 
                         itk::Point<float, 3> itkP;
                         itkP[0] = p[0]; itkP[1] = p[1]; itkP[2] = p[2];
@@ -749,8 +829,7 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::ExtractFiberSubset(ItkUcharImgType
                     {
                         for (int k=0; k<numPoints; k++)
                         {
-                            double* p = points->GetPoint(k);
-                            vtkIdType id = vtkNewPoints->InsertNextPoint(p);
+                            vtkIdType id = vtkNewPoints->InsertNextPoint(points.at(k).data_block());
                             container->GetPointIds()->InsertNextId(id);
                         }
                     }
@@ -758,9 +837,9 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::ExtractFiberSubset(ItkUcharImgType
                 else
                 {
                     bool includeFiber = true;
-                    for (int j=0; j<numPoints; j++)
+                    for (int j=0; j<numPoints && isCandidate[i]; j++)
                     {
-                        double* p = points->GetPoint(j);
+                        const vnl_vector_fixed< double, 3 >& p = points.at(j);
 
                         itk::Point<float, 3> itkP;
                         itkP[0] = p[0]; itkP[1] = p[1]; itkP[2] = p[2];
@@ -781,8 +860,7 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::ExtractFiberSubset(ItkUcharImgType
 
                         for (int k=0; k<numPoints; k++)
                         {
-                            double* p = points->GetPoint(k);
-                            vtkIdType id = vtkNewPoints->InsertNextPoint(p);
+                            vtkIdType id = vtkNewPoints->InsertNextPoint(points.at(k).data_block());
                             container->GetPointIds()->InsertNextId(id);
                         }
                     }
@@ -1040,12 +1118,23 @@ std::vector<long> mitk::FiberBundle::ExtractFiberIdSubset(DataNode *roi, DataSto
                 polygonVtk->GetPointIds()->InsertNextId(id);
             }
 
+            // only fibers passing the bounding box of the polygon can intersect it
+            double tolerance = 0.001;
+            double bounds[6];
+            polygonVtk->GetPoints()->GetBounds(bounds);
+            for (int d=0; d<3; ++d)
+            {
+                bounds[2*d] -= 10*tolerance;
+                bounds[2*d+1] += 10*tolerance;
+            }
+            std::vector< long > candidates = this->GetSegmentIndex()->GetCandidateFibers(bounds);
+
             MITK_INFO << "Extracting with polygon";
-            boost::progress_display disp(m_NumFibers);
-            for (int i=0; i<m_NumFibers; i++)
+            boost::progress_display disp(candidates.size());
+            for (long i : candidates)
             {
                 ++disp ;
-                vtkCell* cell = m_FiberPolyData->GetCell(i);
+                vtkCell* cell = GetFiberPolyData()->GetCell(i);
                 int numPoints = cell->GetNumberOfPoints();
                 vtkPoints* points = cell->GetPoints();
 
@@ -1056,7 +1145,6 @@ std::vector<long> mitk::FiberBundle::ExtractFiberIdSubset(DataNode *roi, DataSto
                     points->GetPoint(j, p1);
                     double p2[3] = {0,0,0};
                     points->GetPoint(j+1, p2);
-                    double tolerance = 0.001;
 
                     // Outputs
                     double t = 0; // Parametric coordinate of intersection (0 (corresponding to p1) to 1 (corresponding to p2))
@@ -1086,12 +1174,21 @@ std::vector<long> mitk::FiberBundle::ExtractFiberIdSubset(DataNode *roi, DataSto
             double radius = V1w.EuclideanDistanceTo(V2w);
             radius *= radius;
 
+            // only fibers passing the bounding box of the circle can intersect it
+            double bounds[6];
+            for (int d=0; d<3; ++d)
+            {
+                bounds[2*d] = V1w[d]-std::sqrt(radius)-0.01;
+                bounds[2*d+1] = V1w[d]+std::sqrt(radius)+0.01;
+            }
+            std::vector< long > candidates = this->GetSegmentIndex()->GetCandidateFibers(bounds);
+
             MITK_INFO << "Extracting with circle";
-            boost::progress_display disp(m_NumFibers);
-            for (int i=0; i<m_NumFibers; i++)
+            boost::progress_display disp(candidates.size());
+            for (long i : candidates)
             {
                 ++disp ;
-                vtkCell* cell = m_FiberPolyData->GetCell(i);
+                vtkCell* cell = GetFiberPolyData()->GetCell(i);
                 int numPoints = cell->GetNumberOfPoints();
                 vtkPoints* points = cell->GetPoints();
 
@@ -1129,19 +1226,32 @@ std::vector<long> mitk::FiberBundle::ExtractFiberIdSubset(DataNode *roi, DataSto
 
 void mitk::FiberBundle::UpdateFiberGeometry()
 {
-    vtkSmartPointer<vtkCleanPolyData> cleaner = vtkSmartPointer<vtkCleanPolyData>::New();
-    cleaner->SetInputData(m_FiberPolyData);
-    cleaner->PointMergingOff();
-    cleaner->Update();
-    m_FiberPolyData = cleaner->GetOutput();
+    if (m_FiberPolyData!=nullptr)
+    {
+        vtkSmartPointer<vtkCleanPolyData> cleaner = vtkSmartPointer<vtkCleanPolyData>::New();
+        cleaner->SetInputData(m_FiberPolyData);
+        cleaner->PointMergingOff();
+        cleaner->Update();
+        m_FiberPolyData = cleaner->GetOutput();
+        m_FiberContainer = nullptr;
+    }
+    m_SegmentIndex = nullptr;
 
     m_FiberLengths.clear();
     m_MeanFiberLength = 0;
     m_MedianFiberLength = 0;
     m_LengthStDev = 0;
-    m_NumFibers = m_FiberPolyData->GetNumberOfCells();
+    if (m_FiberContainer!=nullptr)
+        m_NumFibers = m_FiberContainer->GetNumberOfFibers();
+    else
+        m_NumFibers = m_FiberPolyData->GetNumberOfCells();
 
-    if (m_FiberColors==nullptr || m_FiberColors->GetNumberOfTuples()!=m_FiberPolyData->GetNumberOfPoints())
+    vtkIdType numPoints = 0;
+    if (m_FiberContainer!=nullptr)
+        numPoints = m_FiberContainer->GetNumberOfPoints();
+    else
+        numPoints = m_FiberPolyData->GetNumberOfPoints();
+    if (m_FiberColors==nullptr || m_FiberColors->GetNumberOfTuples()!=numPoints)
         this->ColorFibersByOrientation();
 
     if (m_FiberWeights->GetSize()!=m_NumFibers)
@@ -1164,39 +1274,47 @@ void mitk::FiberBundle::UpdateFiberGeometry()
         return;
     }
     double b[6];
-    m_FiberPolyData->GetBounds(b);
-
-    // calculate statistics
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+    if (m_FiberContainer!=nullptr)
     {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int p = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-        float length = 0;
-        for (int j=0; j<p-1; j++)
+        m_FiberContainer->GetBounds(b);
+        m_FiberLengths.resize(m_NumFibers);
+#pragma omp parallel for
+        for (int i=0; i<m_NumFibers; i++)
+            m_FiberLengths[i] = m_FiberContainer->GetFiberLength(i);
+    }
+    else
+    {
+        m_FiberPolyData->GetBounds(b);
+        for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
         {
-            double p1[3];
-            points->GetPoint(j, p1);
-            double p2[3];
-            points->GetPoint(j+1, p2);
+            vtkCell* cell = m_FiberPolyData->GetCell(i);
+            int p = cell->GetNumberOfPoints();
+            vtkPoints* points = cell->GetPoints();
+            float length = 0;
+            for (int j=0; j<p-1; j++)
+            {
+                double p1[3];
+                points->GetPoint(j, p1);
+                double p2[3];
+                points->GetPoint(j+1, p2);
 
-            float dist = std::sqrt((p1[0]-p2[0])*(p1[0]-p2[0])+(p1[1]-p2[1])*(p1[1]-p2[1])+(p1[2]-p2[2])*(p1[2]-p2[2]));
-            length += dist;
+                float dist = std::sqrt((p1[0]-p2[0])*(p1[0]-p2[0])+(p1[1]-p2[1])*(p1[1]-p2[1])+(p1[2]-p2[2])*(p1[2]-p2[2]));
+                length += dist;
+            }
+            m_FiberLengths.push_back(length);
         }
-        m_FiberLengths.push_back(length);
+    }
+
+    // calculate statistics
+    m_MinFiberLength = m_FiberLengths.at(0);
+    m_MaxFiberLength = m_FiberLengths.at(0);
+    for (float length : m_FiberLengths)
+    {
         m_MeanFiberLength += length;
-        if (i==0)
-        {
+        if (length<m_MinFiberLength)
             m_MinFiberLength = length;
+        if (length>m_MaxFiberLength)
             m_MaxFiberLength = length;
-        }
-        else
-        {
-            if (length<m_MinFiberLength)
-                m_MinFiberLength = length;
-            if (length>m_MaxFiberLength)
-                m_MaxFiberLength = length;
-        }
     }
     m_MeanFiberLength /= m_NumFibers;
 
@@ -1251,7 +1369,7 @@ void mitk::FiberBundle::SetFiberWeight(unsigned int fiber, float weight)
 
 void mitk::FiberBundle::SetFiberColors(vtkSmartPointer<vtkUnsignedCharArray> fiberColors)
 {
-    for(long i=0; i<m_FiberPolyData->GetNumberOfPoints(); ++i)
+    for(long i=0; i<GetFiberPolyData()->GetNumberOfPoints(); ++i)
     {
         unsigned char source[4] = {0,0,0,0};
         fiberColors->GetTupleValue(i, source);
@@ -1367,37 +1485,23 @@ void mitk::FiberBundle::TransformFibers(double rx, double ry, double rz, double
     mitk::BaseGeometry::Pointer geom = this->GetGeometry();
     mitk::Point3D center = geom->GetCenter();
 
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
-    for (int i=0; i<m_NumFibers; i++)
+    std::shared_ptr< FiberContainer > newFibers = std::make_shared< FiberContainer >(this->GetFiberContainer().Transform(
+        [&](std::size_t, const float* points, std::size_t numPoints, std::vector< float >& newPoints)
     {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for (int j=0; j<numPoints; j++)
+        for (std::size_t j=0; j<numPoints; j++)
         {
-            double* p = points->GetPoint(j);
             vnl_vector_fixed< double, 3 > dir;
-            dir[0] = p[0]-center[0];
-            dir[1] = p[1]-center[1];
-            dir[2] = p[2]-center[2];
+            dir[0] = points[3*j]-center[0];
+            dir[1] = points[3*j+1]-center[1];
+            dir[2] = points[3*j+2]-center[2];
             dir = rot*dir;
-            dir[0] += center[0]+tx;
-            dir[1] += center[1]+ty;
-            dir[2] += center[2]+tz;
-            vtkIdType id = vtkNewPoints->InsertNextPoint(dir.data_block());
-            container->GetPointIds()->InsertNextId(id);
+            newPoints.push_back(dir[0]+center[0]+tx);
+            newPoints.push_back(dir[1]+center[1]+ty);
+            newPoints.push_back(dir[2]+center[2]+tz);
         }
-        vtkNewCells->InsertNextCell(container);
-    }
+    }));
 
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-    this->SetFiberPolyData(m_FiberPolyData, true);
+    this->SetFiberContainer(newFibers);
 }
 
 void mitk::FiberBundle::RotateAroundAxis(double x, double y, double z)
@@ -1432,7 +1536,7 @@ void mitk::FiberBundle::RotateAroundAxis(double x, double y, double z)
 
     for (int i=0; i<m_NumFibers; i++)
     {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
+        vtkCell* cell = GetFiberPolyData()->GetCell(i);
         int numPoints = cell->GetNumberOfPoints();
         vtkPoints* points = cell->GetPoints();
 
@@ -1474,7 +1578,7 @@ void mitk::FiberBundle::ScaleFibers(double x, double y, double z, bool subtractC
     for (int i=0; i<m_NumFibers; i++)
     {
         ++disp ;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
+        vtkCell* cell = GetFiberPolyData()->GetCell(i);
         int numPoints = cell->GetNumberOfPoints();
         vtkPoints* points = cell->GetPoints();
 
@@ -1512,7 +1616,7 @@ void mitk::FiberBundle::TranslateFibers(double x, double y, double z)
 
     for (int i=0; i<m_NumFibers; i++)
     {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
+        vtkCell* cell = GetFiberPolyData()->GetCell(i);
         int numPoints = cell->GetNumberOfPoints();
         vtkPoints* points = cell->GetPoints();
 
@@ -1549,7 +1653,7 @@ void mitk::FiberBundle::MirrorFibers(unsigned int axis)
     for (int i=0; i<m_NumFibers; i++)
     {
         ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
+        vtkCell* cell = GetFiberPolyData()->GetCell(i);
         int numPoints = cell->GetNumberOfPoints();
         vtkPoints* points = cell->GetPoints();
 
@@ -1576,11 +1680,11 @@ void mitk::FiberBundle::RemoveDir(vnl_vector_fixed<double,3> dir, double thresho
     vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
     vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
 
-    boost::progress_display disp(m_FiberPolyData->GetNumberOfCells());
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+    boost::progress_display disp(GetFiberPolyData()->GetNumberOfCells());
+    for (int i=0; i<GetFiberPolyData()->GetNumberOfCells(); i++)
     {
         ++disp ;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
+        vtkCell* cell = GetFiberPolyData()->GetCell(i);
         int numPoints = cell->GetNumberOfPoints();
         vtkPoints* points = cell->GetPoints();
 
@@ -1642,11 +1746,11 @@ bool mitk::FiberBundle::ApplyCurvatureThreshold(float minRadius, bool deleteFibe
     vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
 
     MITK_INFO << "Applying curvature threshold";
-    boost::progress_display disp(m_FiberPolyData->GetNumberOfCells());
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+    boost::progress_display disp(GetFiberPolyData()->GetNumberOfCells());
+    for (int i=0; i<GetFiberPolyData()->GetNumberOfCells(); i++)
     {
         ++disp ;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
+        vtkCell* cell = GetFiberPolyData()->GetCell(i);
         int numPoints = cell->GetNumberOfPoints();
         vtkPoints* points = cell->GetPoints();
 
@@ -1736,7 +1840,7 @@ bool mitk::FiberBundle::RemoveShortFibers(float lengthInMM)
     for (int i=0; i<m_NumFibers; i++)
     {
         ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
+        vtkCell* cell = GetFiberPolyData()->GetCell(i);
         int numPoints = cell->GetNumberOfPoints();
         vtkPoints* points = cell->GetPoints();
 
@@ -1781,7 +1885,7 @@ bool mitk::FiberBundle::RemoveLongFibers(float lengthInMM)
     for (int i=0; i<m_NumFibers; i++)
     {
         ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
+        vtkCell* cell = GetFiberPolyData()->GetCell(i);
         int numPoints = cell->GetNumberOfPoints();
         vtkPoints* points = cell->GetPoints();
 
@@ -1813,37 +1917,18 @@ void mitk::FiberBundle::ResampleSpline(float pointDistance, double tension, doub
     if (pointDistance<=0)
         return;
 
-    vtkSmartPointer<vtkPoints> vtkSmoothPoints = vtkSmartPointer<vtkPoints>::New(); //in smoothpoints the interpolated points representing a fiber are stored.
-
-    //in vtkcells all polylines are stored, actually all id's of them are stored
-    vtkSmartPointer<vtkCellArray> vtkSmoothCells = vtkSmartPointer<vtkCellArray>::New(); //cellcontainer for smoothed lines
-    vtkIdType pointHelperCnt = 0;
-
     MITK_INFO << "Smoothing fibers";
-    vtkSmartPointer<vtkFloatArray> newFiberWeights = vtkSmartPointer<vtkFloatArray>::New();
-    newFiberWeights->SetName("FIBER_WEIGHTS");
-    newFiberWeights->SetNumberOfValues(m_NumFibers);
-
-    boost::progress_display disp(m_NumFibers);
-#pragma omp parallel for
-    for (int i=0; i<m_NumFibers; i++)
+    std::shared_ptr< FiberContainer > newFibers = std::make_shared< FiberContainer >(this->GetFiberContainer().Transform(
+        [&](std::size_t fiber, const float* points, std::size_t numPoints, std::vector< float >& newPoints)
     {
-        vtkSmartPointer<vtkPoints> newPoints = vtkSmartPointer<vtkPoints>::New();
-        float length = 0;
-        float weight = 1;
-#pragma omp critical
-        {
-            length = m_FiberLengths.at(i);
-            weight = m_FiberWeights->GetValue(i);
-            ++disp;
-            vtkCell* cell = m_FiberPolyData->GetCell(i);
-            int numPoints = cell->GetNumberOfPoints();
-            vtkPoints* points = cell->GetPoints();
-            for (int j=0; j<numPoints; j++)
-                newPoints->InsertNextPoint(points->GetPoint(j));
-        }
+        if (numPoints==0)
+            return;
 
-        int sampling = std::ceil(length/pointDistance);
+        vtkSmartPointer<vtkPoints> fiberPoints = vtkSmartPointer<vtkPoints>::New();
+        for (std::size_t j=0; j<numPoints; j++)
+            fiberPoints->InsertNextPoint(points[3*j], points[3*j+1], points[3*j+2]);
+
+        int sampling = std::ceil(m_FiberLengths.at(fiber)/pointDistance);
 
         vtkSmartPointer<vtkKochanekSpline> xSpline = vtkSmartPointer<vtkKochanekSpline>::New();
         vtkSmartPointer<vtkKochanekSpline> ySpline = vtkSmartPointer<vtkKochanekSpline>::New();
@@ -1856,7 +1941,7 @@ void mitk::FiberBundle::ResampleSpline(float pointDistance, double tension, doub
         spline->SetXSpline(xSpline);
         spline->SetYSpline(ySpline);
         spline->SetZSpline(zSpline);
-        spline->SetPoints(newPoints);
+        spline->SetPoints(fiberPoints);
 
         vtkSmartPointer<vtkParametricFunctionSource> functionSource = vtkSmartPointer<vtkParametricFunctionSource>::New();
         functionSource->SetParametricFunction(spline);
@@ -1865,31 +1950,16 @@ void mitk::FiberBundle::ResampleSpline(float pointDistance, double tension, doub
         functionSource->SetWResolution(sampling);
         functionSource->Update();
 
-        vtkPolyData* outputFunction = functionSource->GetOutput();
-        vtkPoints* tmpSmoothPnts = outputFunction->GetPoints(); //smoothPoints of current fiber
-
-        vtkSmartPointer<vtkPolyLine> smoothLine = vtkSmartPointer<vtkPolyLine>::New();
-        smoothLine->GetPointIds()->SetNumberOfIds(tmpSmoothPnts->GetNumberOfPoints());
-
-#pragma omp critical
+        vtkPoints* smoothPoints = functionSource->GetOutput()->GetPoints();
+        for (vtkIdType j=0; j<smoothPoints->GetNumberOfPoints(); j++)
         {
-            for (int j=0; j<smoothLine->GetNumberOfPoints(); j++)
-            {
-                smoothLine->GetPointIds()->SetId(j, j+pointHelperCnt);
-                vtkSmoothPoints->InsertNextPoint(tmpSmoothPnts->GetPoint(j));
-            }
-
-            newFiberWeights->SetValue(vtkSmoothCells->GetNumberOfCells(), weight);
-            vtkSmoothCells->InsertNextCell(smoothLine);
-            pointHelperCnt += tmpSmoothPnts->GetNumberOfPoints();
+            double p[3];
+            smoothPoints->GetPoint(j, p);
+            newPoints.insert(newPoints.end(), p, p+3);
         }
-    }
+    }));
 
-    SetFiberWeights(newFiberWeights);
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkSmoothPoints);
-    m_FiberPolyData->SetLines(vtkSmoothCells);
-    this->SetFiberPolyData(m_FiberPolyData, true);
+    this->SetFiberContainer(newFibers);
 }
 
 void mitk::FiberBundle::ResampleSpline(float pointDistance)
@@ -1899,10 +1969,13 @@ void mitk::FiberBundle::ResampleSpline(float pointDistance)
 
 unsigned long mitk::FiberBundle::GetNumberOfPoints() const
 {
+    if (m_FiberContainer!=nullptr)
+        return m_FiberContainer->GetNumberOfPoints();
+
     unsigned long points = 0;
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+    for (int i=0; i<GetFiberPolyData()->GetNumberOfCells(); i++)
     {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
+        vtkCell* cell = GetFiberPolyData()->GetCell(i);
         points += cell->GetNumberOfPoints();
     }
     return points;
@@ -1910,47 +1983,26 @@ unsigned long mitk::FiberBundle::GetNumberOfPoints() const
 
 void mitk::FiberBundle::Compress(float error)
 {
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
     MITK_INFO << "Compressing fibers";
-    unsigned long numRemovedPoints = 0;
-    boost::progress_display disp(m_FiberPolyData->GetNumberOfCells());
-    vtkSmartPointer<vtkFloatArray> newFiberWeights = vtkSmartPointer<vtkFloatArray>::New();
-    newFiberWeights->SetName("FIBER_WEIGHTS");
-    newFiberWeights->SetNumberOfValues(m_NumFibers);
-
-#pragma omp parallel for
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+    std::vector< unsigned long > removedPointsPerFiber(m_NumFibers, 0);
+    std::shared_ptr< FiberContainer > newFibers = std::make_shared< FiberContainer >(this->GetFiberContainer().Transform(
+        [&](std::size_t fiber, const float* points, std::size_t numPoints, std::vector< float >& newPoints)
     {
+        if (numPoints==0)
+            return;
 
         std::vector< vnl_vector_fixed< double, 3 > > vertices;
-        float weight = 1;
-
-#pragma omp critical
+        for (std::size_t j=0; j<numPoints; j++)
         {
-            ++disp;
-            weight = m_FiberWeights->GetValue(i);
-            vtkCell* cell = m_FiberPolyData->GetCell(i);
-            int numPoints = cell->GetNumberOfPoints();
-            vtkPoints* points = cell->GetPoints();
-
-            for (int j=0; j<numPoints; j++)
-            {
-                double cand[3];
-                points->GetPoint(j, cand);
-                vnl_vector_fixed< double, 3 > candV;
-                candV[0]=cand[0]; candV[1]=cand[1]; candV[2]=cand[2];
-                vertices.push_back(candV);
-            }
+            vnl_vector_fixed< double, 3 > candV;
+            candV[0]=points[3*j]; candV[1]=points[3*j+1]; candV[2]=points[3*j+2];
+            vertices.push_back(candV);
         }
 
         // calculate curvatures
-        int numPoints = vertices.size();
         std::vector< int > removedPoints; removedPoints.resize(numPoints, 0);
         removedPoints[0]=-1; removedPoints[numPoints-1]=-1;
 
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
         int remCounter = 0;
 
         bool pointFound = true;
@@ -2010,149 +2062,96 @@ void mitk::FiberBundle::Compress(float error)
             }
         }
 
-        for (int j=0; j<numPoints; j++)
-        {
+        for (std::size_t j=0; j<numPoints; j++)
             if (removedPoints[j]<=0)
-            {
-#pragma omp critical
-                {
-                    vtkIdType id = vtkNewPoints->InsertNextPoint(vertices.at(j).data_block());
-                    container->GetPointIds()->InsertNextId(id);
-                }
-            }
-        }
-
-#pragma omp critical
-        {
-            newFiberWeights->SetValue(vtkNewCells->GetNumberOfCells(), weight);
-            numRemovedPoints += remCounter;
-            vtkNewCells->InsertNextCell(container);
-        }
-    }
+                newPoints.insert(newPoints.end(), points+3*j, points+3*j+3);
+        removedPointsPerFiber[fiber] = remCounter;
+    }));
 
-    if (vtkNewCells->GetNumberOfCells()>0)
+    if (newFibers->GetNumberOfFibers()>0)
     {
-        MITK_INFO << "Removed points: " << numRemovedPoints;
-        SetFiberWeights(newFiberWeights);
-        m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-        m_FiberPolyData->SetPoints(vtkNewPoints);
-        m_FiberPolyData->SetLines(vtkNewCells);
-        this->SetFiberPolyData(m_FiberPolyData, true);
+        MITK_INFO << "Removed points: " << std::accumulate(removedPointsPerFiber.begin(), removedPointsPerFiber.end(), 0ul);
+        this->SetFiberContainer(newFibers);
     }
 }
 
-void mitk::FiberBundle::ResampleLinear(double pointDistance)
+std::vector< vnl_vector_fixed< double, 3 > > mitk::FiberBundle::ResampleFiberLinear(const std::vector< vnl_vector_fixed< double, 3 > >& vertices, double pointDistance)
 {
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
-    MITK_INFO << "Resampling fibers (linear)";
-    boost::progress_display disp(m_FiberPolyData->GetNumberOfCells());
-    vtkSmartPointer<vtkFloatArray> newFiberWeights = vtkSmartPointer<vtkFloatArray>::New();
-    newFiberWeights->SetName("FIBER_WEIGHTS");
-    newFiberWeights->SetNumberOfValues(m_NumFibers);
+    std::vector< vnl_vector_fixed< double, 3 > > resampled;
+    vnl_vector_fixed< double, 3 > lastV = vertices.at(0);
+    resampled.push_back(lastV);
 
-#pragma omp parallel for
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+    for (unsigned int j=1; j<vertices.size(); j++)
     {
+        vnl_vector_fixed< double, 3 > vec = vertices.at(j) - lastV;
+        double new_dist = vec.magnitude();
 
-        std::vector< vnl_vector_fixed< double, 3 > > vertices;
-        float weight = 1;
-
-#pragma omp critical
+        if (new_dist >= pointDistance)
         {
-            ++disp;
-            weight = m_FiberWeights->GetValue(i);
-            vtkCell* cell = m_FiberPolyData->GetCell(i);
-            int numPoints = cell->GetNumberOfPoints();
-            vtkPoints* points = cell->GetPoints();
-
-            for (int j=0; j<numPoints; j++)
+            vnl_vector_fixed< double, 3 > newV = lastV;
+            if ( new_dist-pointDistance <= mitk::eps )
             {
-                double cand[3];
-                points->GetPoint(j, cand);
-                vnl_vector_fixed< double, 3 > candV;
-                candV[0]=cand[0]; candV[1]=cand[1]; candV[2]=cand[2];
-                vertices.push_back(candV);
+                vec.normalize();
+                newV += vec * pointDistance;
             }
-        }
+            else
+            {
+                // intersection between sphere (radius 'pointDistance', center 'lastV') and line (direction 'd' and point 'p')
+                vnl_vector_fixed< double, 3 > p = vertices.at(j-1);
+                vnl_vector_fixed< double, 3 > d = vertices.at(j) - p;
 
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        vnl_vector_fixed< double, 3 > lastV = vertices.at(0);
+                double a = d[0]*d[0] + d[1]*d[1] + d[2]*d[2];
+                double b = 2 * (d[0] * (p[0] - lastV[0]) + d[1] * (p[1] - lastV[1]) + d[2] * (p[2] - lastV[2]));
+                double c = (p[0] - lastV[0])*(p[0] - lastV[0]) + (p[1] - lastV[1])*(p[1] - lastV[1]) + (p[2] - lastV[2])*(p[2] - lastV[2]) - pointDistance*pointDistance;
 
-#pragma omp critical
-        {
-            vtkIdType id = vtkNewPoints->InsertNextPoint(lastV.data_block());
-            container->GetPointIds()->InsertNextId(id);
-        }
-        for (unsigned int j=1; j<vertices.size(); j++)
-        {
-            vnl_vector_fixed< double, 3 > vec = vertices.at(j) - lastV;
-            double new_dist = vec.magnitude();
+                double v1 =(-b + std::sqrt(b*b-4*a*c))/(2*a);
+                double v2 =(-b - std::sqrt(b*b-4*a*c))/(2*a);
 
-            if (new_dist >= pointDistance)
-            {
-                vnl_vector_fixed< double, 3 > newV = lastV;
-                if ( new_dist-pointDistance <= mitk::eps )
-                {
-                    vec.normalize();
-                    newV += vec * pointDistance;
-                }
+                if (v1>0)
+                    newV = p + d * v1;
+                else if (v2>0)
+                    newV = p + d * v2;
                 else
-                {
-                    // intersection between sphere (radius 'pointDistance', center 'lastV') and line (direction 'd' and point 'p')
-                    vnl_vector_fixed< double, 3 > p = vertices.at(j-1);
-                    vnl_vector_fixed< double, 3 > d = vertices.at(j) - p;
-
-                    double a = d[0]*d[0] + d[1]*d[1] + d[2]*d[2];
-                    double b = 2 * (d[0] * (p[0] - lastV[0]) + d[1] * (p[1] - lastV[1]) + d[2] * (p[2] - lastV[2]));
-                    double c = (p[0] - lastV[0])*(p[0] - lastV[0]) + (p[1] - lastV[1])*(p[1] - lastV[1]) + (p[2] - lastV[2])*(p[2] - lastV[2]) - pointDistance*pointDistance;
-
-                    double v1 =(-b + std::sqrt(b*b-4*a*c))/(2*a);
-                    double v2 =(-b - std::sqrt(b*b-4*a*c))/(2*a);
-
-                    if (v1>0)
-                        newV = p + d * v1;
-                    else if (v2>0)
-                        newV = p + d * v2;
-                    else
-                        MITK_INFO << "ERROR1 - linear resampling";
-                    
-                    j--;
-                }
-                
-#pragma omp critical
-                {
-                    vtkIdType id = vtkNewPoints->InsertNextPoint(newV.data_block());
-                    container->GetPointIds()->InsertNextId(id);
-                }
-                lastV = newV;
-            }
-            else if (j==vertices.size()-1 && new_dist>0.0001)
-            {
-#pragma omp critical
-                {
-                    vtkIdType id = vtkNewPoints->InsertNextPoint(vertices.at(j).data_block());
-                    container->GetPointIds()->InsertNextId(id);
-                }
+                    MITK_INFO << "ERROR1 - linear resampling";
+
+                j--;
             }
-        }
 
-#pragma omp critical
+            resampled.push_back(newV);
+            lastV = newV;
+        }
+        else if (j==vertices.size()-1 && new_dist>0.0001)
         {
-            newFiberWeights->SetValue(vtkNewCells->GetNumberOfCells(), weight);
-            vtkNewCells->InsertNextCell(container);
+            resampled.push_back(vertices.at(j));
         }
     }
 
-    if (vtkNewCells->GetNumberOfCells()>0)
+    return resampled;
+}
+
+void mitk::FiberBundle::ResampleLinear(double pointDistance)
+{
+    MITK_INFO << "Resampling fibers (linear)";
+    std::shared_ptr< FiberContainer > newFibers = std::make_shared< FiberContainer >(this->GetFiberContainer().Transform(
+        [&](std::size_t, const float* points, std::size_t numPoints, std::vector< float >& newPoints)
     {
-        SetFiberWeights(newFiberWeights);
-        m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-        m_FiberPolyData->SetPoints(vtkNewPoints);
-        m_FiberPolyData->SetLines(vtkNewCells);
-        this->SetFiberPolyData(m_FiberPolyData, true);
-    }
+        if (numPoints==0)
+            return;
+
+        std::vector< vnl_vector_fixed< double, 3 > > vertices;
+        for (std::size_t j=0; j<numPoints; j++)
+        {
+            vnl_vector_fixed< double, 3 > candV;
+            candV[0]=points[3*j]; candV[1]=points[3*j+1]; candV[2]=points[3*j+2];
+            vertices.push_back(candV);
+        }
+
+        for (const vnl_vector_fixed< double, 3 >& v : ResampleFiberLinear(vertices, pointDistance))
+            newPoints.insert(newPoints.end(), v.begin(), v.end());
+    }));
+
+    if (newFibers->GetNumberOfFibers()>0)
+        this->SetFiberContainer(newFibers);
 }
 
 // reapply selected colorcoding in case PolyData structure has changed
@@ -2173,7 +2172,7 @@ bool mitk::FiberBundle::Equals(mitk::FiberBundle* fib, double eps)
 
     for (int i=0; i<m_NumFibers; i++)
     {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
+        vtkCell* cell = GetFiberPolyData()->GetCell(i);
         int numPoints = cell->GetNumberOfPoints();
         vtkPoints* points = cell->GetPoints();
 
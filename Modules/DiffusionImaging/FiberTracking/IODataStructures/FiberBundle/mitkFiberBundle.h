@@ -26,6 +26,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkPlanarFigure.h>
 #include <mitkPixelTypeTraits.h>
 #include <mitkPlanarFigureComposite.h>
+#include <mitkFiberSegmentIndex.h>
+#include <mitkFiberContainer.h>
 
 
 //includes storing fiberdata
@@ -35,6 +37,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkDataSet.h>
 #include <vtkTransform.h>
 #include <vtkFloatArray.h>
+#include <memory>
 
 
 namespace mitk {
@@ -113,7 +116,15 @@ public:
     void SetFiberWeight(unsigned int fiber, float weight);
     void SetFiberWeights(vtkSmartPointer<vtkFloatArray> weights);
     void SetFiberPolyData(vtkSmartPointer<vtkPolyData>, bool updateGeometry = true);
+
+    /** Spatial index over the fiber segments and endpoints. Built on first use and discarded when the fibers change. */
+    const FiberSegmentIndex* GetSegmentIndex();
+    /** The fibers as poly data. If the fibers were last modified in the fiber container, the poly data is created here and cached. */
     vtkSmartPointer<vtkPolyData> GetFiberPolyData() const;
+    /** The fibers as contiguous point buffer. Built from the poly data on first use and discarded when the poly data changes. */
+    const FiberContainer& GetFiberContainer() const;
+    /** Replaces the fibers. The weights are kept if the number of fibers does not change. */
+    void SetFiberContainer(std::shared_ptr< FiberContainer > container);
     itkGetConstMacro( NumFibers, int)
     //itkGetMacro( FiberSampling, int)
     itkGetConstMacro( MinFiberLength, float )
@@ -145,13 +156,17 @@ protected:
 
     itk::Point<float, 3> GetItkPoint(double point[3]);
 
+    // resample a single fiber to equidistant points
+    static std::vector< vnl_vector_fixed< double, 3 > > ResampleFiberLinear(const std::vector< vnl_vector_fixed< double, 3 > >& vertices, double pointDistance);
+
     // calculate geometry from fiber extent
     void UpdateFiberGeometry();
 
 private:
 
-    // actual fiber container
-    vtkSmartPointer<vtkPolyData>  m_FiberPolyData;
+    // actual fiber container; at least one of the two is set, nullptr means outdated
+    mutable vtkSmartPointer<vtkPolyData>  m_FiberPolyData;
+    mutable std::shared_ptr< FiberContainer > m_FiberContainer;
 
     // contains fiber ids
     vtkSmartPointer<vtkDataSet>   m_FiberIdDataSet;
@@ -169,6 +184,7 @@ private:
     itk::TimeStamp m_UpdateTime2D;
     itk::TimeStamp m_UpdateTime3D;
     mitk::BaseGeometry::Pointer m_ReferenceGeometry;
+    std::shared_ptr< FiberSegmentIndex > m_SegmentIndex;
 };
 
 } // namespace mitk
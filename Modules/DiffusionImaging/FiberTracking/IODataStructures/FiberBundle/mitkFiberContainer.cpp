@@ -0,0 +1,197 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkFiberContainer.h"
+
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPoints.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+// number of fibers processed in one piece by Transform
+const std::size_t FIBERS_PER_CHUNK = 256;
+}
+
+mitk::FiberContainer::FiberContainer()
+    : m_Offsets(1, 0)
+{
+}
+
+mitk::FiberContainer::FiberContainer(vtkPolyData* polyData)
+    : m_Offsets(1, 0)
+{
+    if (polyData==nullptr || polyData->GetPoints()==nullptr)
+        return;
+
+    const vtkIdType numFibers = polyData->GetNumberOfCells();
+    m_Offsets.resize(numFibers+1);
+    for (vtkIdType i=0; i<numFibers; i++)
+    {
+        vtkIdType numPoints = 0;
+        vtkIdType* pointIds = nullptr;
+        polyData->GetCellPoints(i, numPoints, pointIds);
+        m_Offsets[i+1] = m_Offsets[i]+numPoints;
+    }
+    m_Points.resize(3*m_Offsets.back());
+
+    vtkPoints* points = polyData->GetPoints();
+    vtkFloatArray* floatPoints = vtkFloatArray::SafeDownCast(points->GetData());
+#pragma omp parallel for
+    for (vtkIdType i=0; i<numFibers; i++)
+    {
+        vtkIdType numPoints = 0;
+        vtkIdType* pointIds = nullptr;
+        polyData->GetCellPoints(i, numPoints, pointIds);
+
+        float* fiberPoints = this->GetPoints(i);
+        for (vtkIdType j=0; j<numPoints; j++)
+        {
+            if (floatPoints!=nullptr)
+                std::copy(floatPoints->GetPointer(3*pointIds[j]), floatPoints->GetPointer(3*pointIds[j])+3, fiberPoints+3*j);
+            else
+            {
+                double p[3];
+                points->GetPoint(pointIds[j], p);
+                std::copy(p, p+3, fiberPoints+3*j);
+            }
+        }
+    }
+}
+
+void mitk::FiberContainer::AddFiber(const float* points, std::size_t numPoints)
+{
+    m_Points.insert(m_Points.end(), points, points+3*numPoints);
+    m_Offsets.push_back(m_Offsets.back()+numPoints);
+}
+
+void mitk::FiberContainer::Allocate(const std::vector< std::size_t >& numPoints)
+{
+    m_Offsets.resize(numPoints.size()+1);
+    m_Offsets[0] = 0;
+    for (std::size_t i=0; i<numPoints.size(); i++)
+        m_Offsets[i+1] = m_Offsets[i]+numPoints[i];
+    m_Points.resize(3*m_Offsets.back());
+}
+
+float mitk::FiberContainer::GetFiberLength(std::size_t fiber) const
+{
+    const float* p = this->GetPoints(fiber);
+    const std::size_t numPoints = this->GetNumberOfPoints(fiber);
+    float length = 0;
+    for (std::size_t j=0; j+1<numPoints; j++)
+    {
+        const double dx = p[3*j]-p[3*j+3];
+        const double dy = p[3*j+1]-p[3*j+4];
+        const double dz = p[3*j+2]-p[3*j+5];
+        length += std::sqrt(dx*dx+dy*dy+dz*dz);
+    }
+    return length;
+}
+
+void mitk::FiberContainer::GetBounds(double bounds[6]) const
+{
+    for (int d=0; d<3; d++)
+    {
+        bounds[2*d] = std::numeric_limits<double>::max();
+        bounds[2*d+1] = -std::numeric_limits<double>::max();
+    }
+    for (std::size_t i=0; i<m_Points.size(); i+=3)
+    {
+        for (int d=0; d<3; d++)
+        {
+            bounds[2*d] = std::min(bounds[2*d], static_cast<double>(m_Points[i+d]));
+            bounds[2*d+1] = std::max(bounds[2*d+1], static_cast<double>(m_Points[i+d]));
+        }
+    }
+}
+
+mitk::FiberContainer mitk::FiberContainer::Transform(const FiberFunctionType& function) const
+{
+    const std::size_t numFibers = this->GetNumberOfFibers();
+    const int numChunks = static_cast<int>((numFibers+FIBERS_PER_CHUNK-1)/FIBERS_PER_CHUNK);
+
+    // the fibers are processed in chunks, each chunk collects its points and the number of points of its fibers
+    std::vector< std::vector< float > > chunkPoints(numChunks);
+    std::vector< std::vector< std::size_t > > chunkSizes(numChunks);
+#pragma omp parallel for schedule(dynamic)
+    for (int c=0; c<numChunks; c++)
+    {
+        std::vector< float >& newPoints = chunkPoints[c];
+        const std::size_t end = std::min(numFibers, (c+1)*FIBERS_PER_CHUNK);
+        for (std::size_t i=c*FIBERS_PER_CHUNK; i<end; i++)
+        {
+            const std::size_t size = newPoints.size();
+            function(i, this->GetPoints(i), this->GetNumberOfPoints(i), newPoints);
+            chunkSizes[c].push_back((newPoints.size()-size)/3);
+        }
+    }
+
+    FiberContainer result;
+    std::size_t numPoints = 0;
+    for (int c=0; c<numChunks; c++)
+        numPoints += chunkPoints[c].size()/3;
+    result.m_Points.reserve(3*numPoints);
+    result.m_Offsets.reserve(numFibers+1);
+    for (int c=0; c<numChunks; c++)
+    {
+        result.m_Points.insert(result.m_Points.end(), chunkPoints[c].begin(), chunkPoints[c].end());
+        for (std::size_t size : chunkSizes[c])
+            result.m_Offsets.push_back(result.m_Offsets.back()+size);
+        std::vector< float >().swap(chunkPoints[c]);
+    }
+    return result;
+}
+
+vtkSmartPointer<vtkPolyData> mitk::FiberContainer::GetPolyData() const
+{
+    const std::size_t numFibers = this->GetNumberOfFibers();
+    const std::size_t numPoints = this->GetNumberOfPoints();
+
+    vtkSmartPointer<vtkFloatArray> coordinates = vtkSmartPointer<vtkFloatArray>::New();
+    coordinates->SetNumberOfComponents(3);
+    coordinates->SetNumberOfTuples(numPoints);
+    std::copy(m_Points.begin(), m_Points.end(), coordinates->GetPointer(0));
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData(coordinates);
+
+    // legacy cell array layout: number of points followed by the point ids for each cell
+    vtkSmartPointer<vtkIdTypeArray> cells = vtkSmartPointer<vtkIdTypeArray>::New();
+    cells->SetNumberOfValues(numFibers+numPoints);
+    vtkIdType* cell = cells->GetPointer(0);
+    for (std::size_t i=0; i<numFibers; i++)
+    {
+        *cell++ = this->GetNumberOfPoints(i);
+        for (std::size_t j=m_Offsets[i]; j<m_Offsets[i+1]; j++)
+            *cell++ = j;
+    }
+    vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+    lines->SetCells(numFibers, cells);
+
+    vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+    polyData->SetPoints(points);
+    polyData->SetLines(lines);
+    return polyData;
+}
+
+std::size_t mitk::FiberContainer::GetMemorySize() const
+{
+    return m_Points.capacity()*sizeof(float) + m_Offsets.capacity()*sizeof(std::size_t);
+}
@@ -0,0 +1,86 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef _MITK_FiberContainer_H
+#define _MITK_FiberContainer_H
+
+#include <MitkFiberTrackingExports.h>
+
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+#include <functional>
+#include <vector>
+
+namespace mitk {
+
+/**
+  * \brief Compact storage of the points of a set of fibers.
+  *
+  * The xyz coordinates of all points are stored in one contiguous float buffer, fiber after fiber. The points of
+  * fiber i are the points m_Offsets[i] to m_Offsets[i+1]-1. Compared to a vtkPolyData there is no point id
+  * indirection and no per cell object, so the fibers can be processed in parallel without virtual calls.
+  */
+class MITKFIBERTRACKING_EXPORT FiberContainer
+{
+public:
+
+    /** Processes one fiber and appends the xyz coordinates of the new fiber to newPoints. */
+    typedef std::function< void(std::size_t fiber, const float* points, std::size_t numPoints, std::vector< float >& newPoints) > FiberFunctionType;
+
+    FiberContainer();
+
+    /** Copies the points of all cells of the poly data, the cell ids become the fiber ids. */
+    explicit FiberContainer(vtkPolyData* polyData);
+
+    std::size_t GetNumberOfFibers() const { return m_Offsets.size()-1; }
+    std::size_t GetNumberOfPoints() const { return m_Offsets.back(); }
+    std::size_t GetNumberOfPoints(std::size_t fiber) const { return m_Offsets[fiber+1]-m_Offsets[fiber]; }
+
+    /** Index of the first point of the fiber in the point buffer. */
+    std::size_t GetPointOffset(std::size_t fiber) const { return m_Offsets[fiber]; }
+
+    /** The xyz coordinates of the points of the fiber. */
+    const float* GetPoints(std::size_t fiber) const { return m_Points.data()+3*m_Offsets[fiber]; }
+    float* GetPoints(std::size_t fiber) { return m_Points.data()+3*m_Offsets[fiber]; }
+
+    void AddFiber(const float* points, std::size_t numPoints);
+
+    /** Replaces the fibers by fibers with the given numbers of points. The points are not initialized. */
+    void Allocate(const std::vector< std::size_t >& numPoints);
+
+    float GetFiberLength(std::size_t fiber) const;
+
+    /** Bounds (xmin, xmax, ymin, ymax, zmin, zmax) of all points. */
+    void GetBounds(double bounds[6]) const;
+
+    /** Applies the function to all fibers in parallel. The new fibers are in the order of the input fibers. */
+    FiberContainer Transform(const FiberFunctionType& function) const;
+
+    /** Creates a poly data with one polyline per fiber. The point ids are the indices in the point buffer. */
+    vtkSmartPointer<vtkPolyData> GetPolyData() const;
+
+    /** Number of bytes used by the points and offsets. */
+    std::size_t GetMemorySize() const;
+
+private:
+
+    std::vector< float >        m_Points;
+    std::vector< std::size_t >  m_Offsets;
+};
+
+}
+
+#endif
@@ -0,0 +1,249 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkFiberSegmentIndex.h"
+
+#include <vtkPoints.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace
+{
+// grid spacing of the endpoint hash in mm, endpoints closer than this are found in the neighboring hash cells
+const double ENDPOINT_QUANTUM = 0.01;
+
+// the grid gets about one cell per this number of fiber points
+const double POINTS_PER_CELL = 4;
+const double MAX_NUMBER_OF_CELLS = 1<<22;
+}
+
+mitk::FiberSegmentIndex::FiberSegmentIndex(vtkPolyData* fiberPolyData)
+    : m_CellSize(1)
+{
+    std::fill(m_Origin, m_Origin+3, 0.0);
+    std::fill(m_GridSize, m_GridSize+3, 1);
+
+    vtkPoints* points = fiberPolyData!=nullptr ? fiberPolyData->GetPoints() : nullptr;
+    if (points==nullptr || points->GetNumberOfPoints()==0)
+    {
+        m_CellOffsets.assign(2, 0);
+        return;
+    }
+
+    // grid covering all points with cubic cells
+    double bounds[6];
+    points->GetBounds(bounds);
+    double extent[3];
+    double maxExtent = 0;
+    for (int d=0; d<3; ++d)
+    {
+        m_Origin[d] = bounds[2*d];
+        extent[d] = bounds[2*d+1]-bounds[2*d];
+        maxExtent = std::max(maxExtent, extent[d]);
+    }
+    const double minExtent = std::max(maxExtent*0.001, 0.001);
+    double volume = 1;
+    for (int d=0; d<3; ++d)
+    {
+        extent[d] = std::max(extent[d], minExtent);
+        volume *= extent[d];
+    }
+    const double numberOfCells = std::min(std::max(points->GetNumberOfPoints()/POINTS_PER_CELL, 1.0), MAX_NUMBER_OF_CELLS);
+    m_CellSize = std::cbrt(volume/numberOfCells);
+    for (int d=0; d<3; ++d)
+        m_GridSize[d] = std::max(1, static_cast<int>(std::ceil(extent[d]/m_CellSize)));
+
+    const std::size_t gridCells = static_cast<std::size_t>(m_GridSize[0])*m_GridSize[1]*m_GridSize[2];
+    m_CellOffsets.assign(gridCells+1, 0);
+    const vtkIdType numFibers = fiberPolyData->GetNumberOfCells();
+    m_Endpoints.assign(6*numFibers, 0.0);
+
+    // calls the function for each fiber and each cell overlapped by one of its segments, once per fiber and cell
+    std::vector< int > lastFiber(gridCells, -1);
+    auto forEachSegmentCell = [&](const std::function<void(int, std::size_t)>& function)
+    {
+        std::fill(lastFiber.begin(), lastFiber.end(), -1);
+        for (int fiber=0; fiber<numFibers; ++fiber)
+        {
+            vtkIdType numPoints = 0;
+            vtkIdType* pointIds = nullptr;
+            fiberPolyData->GetCellPoints(fiber, numPoints, pointIds);
+            if (numPoints<=0)
+                continue;
+
+            // a fiber with a single point is treated as one degenerated segment
+            double p1[3];
+            double p2[3];
+            points->GetPoint(pointIds[0], p2);
+            for (vtkIdType j=0; j<std::max< vtkIdType >(numPoints-1, 1); ++j)
+            {
+                std::copy(p2, p2+3, p1);
+                if (j+1<numPoints)
+                    points->GetPoint(pointIds[j+1], p2);
+
+                const double lower[3] = { std::min(p1[0], p2[0]), std::min(p1[1], p2[1]), std::min(p1[2], p2[2]) };
+                const double upper[3] = { std::max(p1[0], p2[0]), std::max(p1[1], p2[1]), std::max(p1[2], p2[2]) };
+                int c1[3];
+                int c2[3];
+                GetCell(lower, c1);
+                GetCell(upper, c2);
+
+                int cell[3];
+                for (cell[2]=c1[2]; cell[2]<=c2[2]; ++cell[2])
+                    for (cell[1]=c1[1]; cell[1]<=c2[1]; ++cell[1])
+                        for (cell[0]=c1[0]; cell[0]<=c2[0]; ++cell[0])
+                        {
+                            const std::size_t offset = GetCellOffset(cell);
+                            if (lastFiber[offset]!=fiber)
+                            {
+                                lastFiber[offset] = fiber;
+                                function(fiber, offset);
+                            }
+                        }
+            }
+        }
+    };
+
+    forEachSegmentCell([&](int, std::size_t offset) { ++m_CellOffsets[offset+1]; });
+    for (std::size_t c=0; c<gridCells; ++c)
+        m_CellOffsets[c+1] += m_CellOffsets[c];
+
+    // fibers are visited in ascending order, so the list of each cell is sorted
+    m_CellFibers.resize(m_CellOffsets.back());
+    std::vector< std::size_t > cursor(m_CellOffsets.begin(), m_CellOffsets.end()-1);
+    forEachSegmentCell([&](int fiber, std::size_t offset) { m_CellFibers[cursor[offset]++] = fiber; });
+
+    // endpoint hash
+    m_EndpointHash.reserve(numFibers);
+    for (int fiber=0; fiber<numFibers; ++fiber)
+    {
+        vtkIdType numPoints = 0;
+        vtkIdType* pointIds = nullptr;
+        fiberPolyData->GetCellPoints(fiber, numPoints, pointIds);
+        if (numPoints<=0)
+            continue;
+
+        double start[3];
+        double end[3];
+        points->GetPoint(pointIds[0], start);
+        points->GetPoint(pointIds[numPoints-1], end);
+
+        long long cell[3];
+        for (int d=0; d<3; ++d)
+        {
+            m_Endpoints[6*fiber+d] = start[d];
+            m_Endpoints[6*fiber+3+d] = end[d];
+            cell[d] = static_cast<long long>(std::floor(m_Endpoints[6*fiber+d]/ENDPOINT_QUANTUM));
+        }
+        m_EndpointHash.push_back(std::make_pair(GetEndpointKey(cell), fiber));
+    }
+    std::sort(m_EndpointHash.begin(), m_EndpointHash.end());
+}
+
+void mitk::FiberSegmentIndex::GetCell(const double point[3], int cell[3]) const
+{
+    for (int d=0; d<3; ++d)
+        cell[d] = std::max(0, std::min(m_GridSize[d]-1, static_cast<int>(std::floor((point[d]-m_Origin[d])/m_CellSize))));
+}
+
+std::vector< long > mitk::FiberSegmentIndex::GetCandidateFibers(const double bounds[6]) const
+{
+    std::vector< long > fibers;
+    for (int d=0; d<3; ++d)
+    {
+        if (bounds[2*d+1]<m_Origin[d] || bounds[2*d]>m_Origin[d]+m_GridSize[d]*m_CellSize)
+            return fibers;
+    }
+
+    const double lower[3] = { bounds[0], bounds[2], bounds[4] };
+    const double upper[3] = { bounds[1], bounds[3], bounds[5] };
+    int c1[3];
+    int c2[3];
+    GetCell(lower, c1);
+    GetCell(upper, c2);
+
+    int cell[3];
+    for (cell[2]=c1[2]; cell[2]<=c2[2]; ++cell[2])
+        for (cell[1]=c1[1]; cell[1]<=c2[1]; ++cell[1])
+            for (cell[0]=c1[0]; cell[0]<=c2[0]; ++cell[0])
+            {
+                const std::size_t offset = GetCellOffset(cell);
+                fibers.insert(fibers.end(), m_CellFibers.begin()+m_CellOffsets[offset], m_CellFibers.begin()+m_CellOffsets[offset+1]);
+            }
+
+    std::sort(fibers.begin(), fibers.end());
+    fibers.erase(std::unique(fibers.begin(), fibers.end()), fibers.end());
+    return fibers;
+}
+
+std::uint64_t mitk::FiberSegmentIndex::GetEndpointKey(const long long cell[3])
+{
+    // 21 bits per coordinate, wrapping around only produces additional candidates
+    const std::uint64_t mask = (static_cast<std::uint64_t>(1)<<21)-1;
+    return ((static_cast<std::uint64_t>(cell[0]) & mask) << 42) | ((static_cast<std::uint64_t>(cell[1]) & mask) << 21) | (static_cast<std::uint64_t>(cell[2]) & mask);
+}
+
+void mitk::FiberSegmentIndex::GetFibersStartingAt(const double point[3], double distance, std::vector< long >& fibers) const
+{
+    long long c1[3];
+    long long c2[3];
+    for (int d=0; d<3; ++d)
+    {
+        c1[d] = static_cast<long long>(std::floor((point[d]-distance)/ENDPOINT_QUANTUM));
+        c2[d] = static_cast<long long>(std::floor((point[d]+distance)/ENDPOINT_QUANTUM));
+    }
+
+    long long cell[3];
+    for (cell[0]=c1[0]; cell[0]<=c2[0]; ++cell[0])
+        for (cell[1]=c1[1]; cell[1]<=c2[1]; ++cell[1])
+            for (cell[2]=c1[2]; cell[2]<=c2[2]; ++cell[2])
+            {
+                const std::uint64_t key = GetEndpointKey(cell);
+                auto it = std::lower_bound(m_EndpointHash.begin(), m_EndpointHash.end(), std::make_pair(key, -1));
+                for (; it!=m_EndpointHash.end() && it->first==key; ++it)
+                    fibers.push_back(it->second);
+            }
+}
+
+bool mitk::FiberSegmentIndex::ContainsFiber(const double start[3], const double end[3], double squaredDistance) const
+{
+    auto isClose = [squaredDistance](const double* a, const double* b)
+    {
+        double dist = 0;
+        for (int d=0; d<3; ++d)
+            dist += (a[d]-b[d])*(a[d]-b[d]);
+        return dist<squaredDistance;
+    };
+
+    const double distance = std::sqrt(squaredDistance);
+    std::vector< long > fibers;
+    GetFibersStartingAt(start, distance, fibers);
+    for (long f : fibers)
+    {
+        if (isClose(&m_Endpoints[6*f], start) && isClose(&m_Endpoints[6*f+3], end))
+            return true;
+    }
+
+    fibers.clear();
+    GetFibersStartingAt(end, distance, fibers);
+    for (long f : fibers)
+    {
+        if (isClose(&m_Endpoints[6*f], end) && isClose(&m_Endpoints[6*f+3], start))
+            return true;
+    }
+    return false;
+}
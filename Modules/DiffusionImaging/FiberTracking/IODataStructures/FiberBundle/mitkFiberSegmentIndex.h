@@ -0,0 +1,77 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef _MITK_FiberSegmentIndex_H
+#define _MITK_FiberSegmentIndex_H
+
+#include <MitkFiberTrackingExports.h>
+
+#include <vtkPolyData.h>
+#include <vector>
+#include <cstdint>
+
+namespace mitk {
+
+/**
+  * \brief Spatial index over the segments and endpoints of the fibers of a fiber bundle.
+  *
+  * The segments are sorted into a uniform grid. Each grid cell stores the ids of all fibers with a segment whose
+  * bounding box overlaps the cell, so box queries return candidate fibers that still need the exact test of the
+  * caller. The start points of the fibers are hashed on a fine grid to find fibers with given endpoints without
+  * comparing against all fibers. Fiber ids are the cell ids of the indexed vtkPolyData.
+  */
+class MITKFIBERTRACKING_EXPORT FiberSegmentIndex
+{
+public:
+
+    explicit FiberSegmentIndex(vtkPolyData* fiberPolyData);
+
+    /** Ids of all fibers with a segment in the grid cells overlapping the box (xmin, xmax, ymin, ymax, zmin, zmax), sorted ascending. */
+    std::vector< long > GetCandidateFibers(const double bounds[6]) const;
+
+    /** True if a fiber starts and ends at the given points (in either direction) within the squared distance. */
+    bool ContainsFiber(const double start[3], const double end[3], double squaredDistance) const;
+
+    unsigned long GetNumberOfFibers() const { return static_cast<unsigned long>(m_Endpoints.size()/6); }
+
+private:
+
+    void GetCell(const double point[3], int cell[3]) const;
+    std::size_t GetCellOffset(const int cell[3]) const { return (static_cast<std::size_t>(cell[2])*m_GridSize[1] + cell[1])*m_GridSize[0] + cell[0]; }
+
+    static std::uint64_t GetEndpointKey(const long long cell[3]);
+
+    /** Ids of the fibers starting within the distance of the point, not sorted. */
+    void GetFibersStartingAt(const double point[3], double distance, std::vector< long >& fibers) const;
+
+    double  m_Origin[3];
+    double  m_CellSize;
+    int     m_GridSize[3];
+
+    /** The fibers in cell c are m_CellFibers[m_CellOffsets[c]] to m_CellFibers[m_CellOffsets[c+1]-1]. */
+    std::vector< std::size_t >  m_CellOffsets;
+    std::vector< int >          m_CellFibers;
+
+    /** Start and end point of each fiber, in double precision like the queries. */
+    std::vector< double >       m_Endpoints;
+
+    /** Hash keys of the quantized start points and the fiber ids, sorted by key. */
+    std::vector< std::pair< std::uint64_t, int > > m_EndpointHash;
+};
+
+}
+
+#endif
@@ -0,0 +1,575 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTractogramFile.h"
+
+#include <mitkTrackvis.h>
+#include <mitkExceptionMacro.h>
+#include <mitkGeometry3D.h>
+#include <vtkMatrix4x4.h>
+#include <itksys/SystemTools.hxx>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+#if _MSC_VER || __MINGW32__
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+// number of points that are scanned in one piece when indexing a .tck file
+const std::size_t TCK_POINTS_PER_BLOCK = 1<<20;
+
+// position of n_count in the TrackVis header
+const long TRK_COUNT_POSITION = 988;
+
+// the buffer of the writer is flushed when it exceeds this size
+const std::size_t WRITE_BUFFER_SIZE = 1<<23;
+
+inline float ReadValue(const char* data, std::size_t valueSize)
+{
+    if (valueSize==8)
+    {
+        double value;
+        std::memcpy(&value, data, 8);
+        return static_cast<float>(value);
+    }
+    float value;
+    std::memcpy(&value, data, 4);
+    return value;
+}
+
+std::string GetExtension(const std::string& filename)
+{
+    return itksys::SystemTools::LowerCase(itksys::SystemTools::GetFilenameLastExtension(filename));
+}
+}
+
+/** Read-only mapping of a whole file. */
+struct mitk::TractogramFileReader::MappedFile
+{
+    const char* m_Data;
+    std::size_t m_Size;
+#if _MSC_VER || __MINGW32__
+    HANDLE      m_Handle;
+    HANDLE      m_Mapping;
+#else
+    int         m_Handle;
+#endif
+
+    explicit MappedFile(const std::string& filename)
+        : m_Data(nullptr)
+        , m_Size(0)
+    {
+#if _MSC_VER || __MINGW32__
+        m_Mapping = nullptr;
+        m_Handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_Handle==INVALID_HANDLE_VALUE)
+            mitkThrow() << "Could not open " << filename;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_Handle, &size) || size.QuadPart==0)
+        {
+            CloseHandle(m_Handle);
+            mitkThrow() << "Could not map " << filename;
+        }
+        m_Size = static_cast<std::size_t>(size.QuadPart);
+        m_Mapping = CreateFileMappingA(m_Handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_Mapping!=nullptr)
+            m_Data = static_cast<const char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+        if (m_Data==nullptr)
+        {
+            if (m_Mapping!=nullptr)
+                CloseHandle(m_Mapping);
+            CloseHandle(m_Handle);
+            mitkThrow() << "Could not map " << filename;
+        }
+#else
+        m_Handle = open(filename.c_str(), O_RDONLY);
+        if (m_Handle<0)
+            mitkThrow() << "Could not open " << filename;
+        struct stat status;
+        if (fstat(m_Handle, &status)!=0 || status.st_size==0)
+        {
+            close(m_Handle);
+            mitkThrow() << "Could not map " << filename;
+        }
+        m_Size = static_cast<std::size_t>(status.st_size);
+        void* data = mmap(nullptr, m_Size, PROT_READ, MAP_SHARED, m_Handle, 0);
+        if (data==MAP_FAILED)
+        {
+            close(m_Handle);
+            mitkThrow() << "Could not map " << filename;
+        }
+        m_Data = static_cast<const char*>(data);
+        madvise(data, m_Size, MADV_SEQUENTIAL);
+#endif
+    }
+
+    ~MappedFile()
+    {
+#if _MSC_VER || __MINGW32__
+        UnmapViewOfFile(m_Data);
+        CloseHandle(m_Mapping);
+        CloseHandle(m_Handle);
+#else
+        munmap(const_cast<char*>(m_Data), m_Size);
+        close(m_Handle);
+#endif
+    }
+
+    /** Tells the system that the given bytes are not needed any more, so their pages do not stay resident. */
+    void Release(std::size_t begin, std::size_t end) const
+    {
+#if _MSC_VER || __MINGW32__
+        // unmodified pages of a read-only view are dropped from the working set by the system
+        (void)begin;
+        (void)end;
+#else
+        const std::size_t pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        begin -= begin%pageSize;
+        end = std::min(end, m_Size);
+        if (end>begin)
+            madvise(const_cast<char*>(m_Data)+begin, end-begin, MADV_DONTNEED);
+#endif
+    }
+};
+
+mitk::TractogramFileReader::TractogramFileReader(const std::string& filename)
+    : m_IsTrk(false)
+    , m_ValueSize(4)
+    , m_PointStride(12)
+{
+    std::string ext = GetExtension(filename);
+    if (ext!=".tck" && ext!=".trk")
+        mitkThrow() << "Unknown tractogram format " << ext;
+
+    m_File.reset(new MappedFile(filename));
+    m_IsTrk = ext==".trk";
+    if (m_IsTrk)
+        IndexTrk();
+    else
+        IndexTck();
+
+    // the index pass touched every page
+    m_File->Release(0, m_File->m_Size);
+}
+
+mitk::TractogramFileReader::~TractogramFileReader()
+{
+}
+
+void mitk::TractogramFileReader::IndexTck()
+{
+    const char* data = m_File->m_Data;
+    const std::size_t size = m_File->m_Size;
+
+    const std::string endTag = "\nEND\n";
+    const char* headerEnd = std::search(data, data+size, endTag.begin(), endTag.end());
+    if (headerEnd==data+size || std::strncmp(data, "mrtrix tracks", 13)!=0)
+        mitkThrow() << "Not a valid .tck file";
+
+    std::size_t dataOffset = 0;
+    std::string dataType = "Float32LE";
+    std::istringstream header(std::string(data, headerEnd));
+    std::string line;
+    while (std::getline(header, line))
+    {
+        std::size_t pos = line.find(':');
+        if (pos==std::string::npos)
+            continue;
+        std::string key = line.substr(0, pos);
+        std::istringstream value(line.substr(pos+1));
+        if (key=="datatype")
+            value >> dataType;
+        else if (key=="file")
+        {
+            std::string dot;
+            value >> dot >> dataOffset;
+        }
+    }
+
+    if (dataType=="Float32LE" || dataType=="Float32")
+        m_ValueSize = 4;
+    else if (dataType=="Float64LE" || dataType=="Float64")
+        m_ValueSize = 8;
+    else
+        mitkThrow() << "Unsupported .tck data type " << dataType;
+    if (dataOffset==0 || dataOffset>size)
+        mitkThrow() << "Could not parse data offset of .tck file";
+
+    m_PointStride = 3*m_ValueSize;
+    m_Flip[0] = -1; m_Flip[1] = -1; m_Flip[2] = 1; // RAS (MRtrix) to LPS (MITK)
+
+    // find the NaN points separating the fibers and the infinite point terminating the file, block by block in parallel
+    const std::size_t numPoints = (size-dataOffset)/m_PointStride;
+    const int numBlocks = static_cast<int>((numPoints+TCK_POINTS_PER_BLOCK-1)/TCK_POINTS_PER_BLOCK);
+    std::vector< std::vector< std::size_t > > separators(numBlocks);
+    std::vector< std::size_t > terminators(numBlocks, numPoints);
+#pragma omp parallel for schedule(dynamic)
+    for (int b=0; b<numBlocks; b++)
+    {
+        const std::size_t end = std::min(numPoints, (b+1)*TCK_POINTS_PER_BLOCK);
+        for (std::size_t i=b*TCK_POINTS_PER_BLOCK; i<end; i++)
+        {
+            float x = ReadValue(data+dataOffset+i*m_PointStride, m_ValueSize);
+            if (std::isnan(x))
+                separators[b].push_back(i);
+            else if (std::isinf(x))
+            {
+                terminators[b] = i;
+                break;
+            }
+        }
+    }
+
+    // header without points
+    if (numBlocks==0)
+        return;
+
+    // points after the last separator are an incomplete fiber and ignored
+    const std::size_t terminator = *std::min_element(terminators.begin(), terminators.end());
+    std::size_t start = 0;
+    for (int b=0; b<numBlocks; b++)
+        for (std::size_t s : separators[b])
+        {
+            if (s>terminator)
+                break;
+            if (s>start)
+            {
+                m_FiberOffsets.push_back(dataOffset+start*m_PointStride);
+                m_NumPoints.push_back(s-start);
+            }
+            start = s+1;
+        }
+}
+
+void mitk::TractogramFileReader::IndexTrk()
+{
+    const char* data = m_File->m_Data;
+    const std::size_t size = m_File->m_Size;
+
+    TrackVis_header header;
+    if (size<sizeof(header))
+        mitkThrow() << "Not a valid .trk file";
+    std::memcpy(&header, data, sizeof(header));
+    if (std::strncmp(header.id_string, "TRACK", 5)!=0 || header.hdr_size!=1000)
+        mitkThrow() << "Not a valid .trk file (or big endian, which is not supported)";
+
+    MITK_INFO << "Coordinate convention: " << std::string(header.voxel_order, 3);
+    m_ValueSize = 4;
+    m_PointStride = (3+header.n_scalars)*4;
+    m_Flip[0] = header.voxel_order[0]=='R' ? -1 : 1;
+    m_Flip[1] = header.voxel_order[1]=='A' ? -1 : 1;
+    m_Flip[2] = header.voxel_order[2]=='I' ? -1 : 1;
+
+    mitk::Geometry3D::Pointer geometry = mitk::Geometry3D::New();
+    vtkSmartPointer< vtkMatrix4x4 > matrix = vtkSmartPointer< vtkMatrix4x4 >::New();
+    matrix->Identity();
+    for (int d=0; d<3; d++)
+        matrix->SetElement(d, d, m_Flip[d]);
+    geometry->SetIndexToWorldTransformByVtkMatrix(matrix);
+
+    mitk::Point3D origin;
+    mitk::Vector3D spacing;
+    for (int d=0; d<3; d++)
+    {
+        origin[d] = header.origin[d];
+        spacing[d] = header.voxel_size[d];
+    }
+    geometry->SetOrigin(origin);
+    geometry->SetSpacing(spacing);
+    for (int d=0; d<3; d++)
+        geometry->SetExtentInMM(d, header.voxel_size[d]*header.dim[d]);
+    m_ReferenceGeometry = geometry.GetPointer();
+
+    // each fiber is stored as number of points, the points and the fiber properties
+    if (header.n_count>0)
+    {
+        m_FiberOffsets.reserve(header.n_count);
+        m_NumPoints.reserve(header.n_count);
+    }
+    const std::size_t propertySize = header.n_properties*4;
+    std::size_t pos = sizeof(header);
+    while (pos+4<=size)
+    {
+        std::int32_t numPoints;
+        std::memcpy(&numPoints, data+pos, 4);
+        if (numPoints<=0)
+            mitkThrow() << "Trying to read a fiber with " << numPoints << " points!";
+
+        const std::size_t next = pos + 4 + numPoints*m_PointStride + propertySize;
+        if (next>size)
+        {
+            MITK_WARN << "Last fiber of .trk file is incomplete and ignored";
+            break;
+        }
+        m_FiberOffsets.push_back(pos+4);
+        m_NumPoints.push_back(numPoints);
+        pos = next;
+    }
+}
+
+std::size_t mitk::TractogramFileReader::GetNumberOfPoints() const
+{
+    std::size_t numPoints = 0;
+    for (std::size_t n : m_NumPoints)
+        numPoints += n;
+    return numPoints;
+}
+
+mitk::FiberContainer mitk::TractogramFileReader::ReadFibers(std::size_t first, std::size_t count) const
+{
+    first = std::min(first, this->GetNumberOfFibers());
+    count = std::min(count, this->GetNumberOfFibers()-first);
+
+    FiberContainer fibers;
+    fibers.Allocate(std::vector< std::size_t >(m_NumPoints.begin()+first, m_NumPoints.begin()+first+count));
+
+    const char* data = m_File->m_Data;
+#pragma omp parallel for schedule(dynamic, 256)
+    for (long i=0; i<static_cast<long>(count); i++)
+    {
+        const char* fiberData = data + m_FiberOffsets[first+i];
+        float* points = fibers.GetPoints(i);
+        for (std::size_t j=0; j<fibers.GetNumberOfPoints(i); j++)
+            for (int d=0; d<3; d++)
+                points[3*j+d] = m_Flip[d]*ReadValue(fiberData + j*m_PointStride + d*m_ValueSize, m_ValueSize);
+    }
+    return fibers;
+}
+
+mitk::FiberBundle::Pointer mitk::TractogramFileReader::ReadFiberBundle() const
+{
+    MITK_INFO << "Reading " << this->GetNumberOfFibers() << " fibers";
+    FiberBundle::Pointer fib = FiberBundle::New();
+    fib->SetFiberContainer(std::make_shared< FiberContainer >(this->ReadFibers(0, this->GetNumberOfFibers())));
+    if (m_IsTrk)
+        fib->SetReferenceGeometry(m_ReferenceGeometry);
+    return fib;
+}
+
+void mitk::TractogramFileReader::StreamFibers(const ChunkFunctionType& function, std::size_t fibersPerChunk) const
+{
+    fibersPerChunk = std::max< std::size_t >(fibersPerChunk, 1);
+    for (std::size_t first=0; first<this->GetNumberOfFibers(); first+=fibersPerChunk)
+    {
+        const std::size_t count = std::min(fibersPerChunk, this->GetNumberOfFibers()-first);
+        function(this->ReadFibers(first, count), first);
+
+        const std::size_t last = first+count-1;
+        m_File->Release(m_FiberOffsets[first], m_FiberOffsets[last] + m_NumPoints[last]*m_PointStride);
+    }
+}
+
+mitk::BaseGeometry::Pointer mitk::TractogramFileReader::GetBoundingGeometry() const
+{
+    // same default geometry as an empty fiber bundle
+    double bounds[] = {0, 1, 0, 1, 0, 1};
+    if (this->GetNumberOfPoints()>0)
+    {
+        for (int i=0; i<3; i++)
+        {
+            bounds[2*i] = std::numeric_limits<double>::max();
+            bounds[2*i+1] = -std::numeric_limits<double>::max();
+        }
+        this->StreamFibers([&](const FiberContainer& fibers, std::size_t)
+        {
+            double chunkBounds[6];
+            fibers.GetBounds(chunkBounds);
+            for (int i=0; i<3; i++)
+            {
+                bounds[2*i] = std::min(bounds[2*i], chunkBounds[2*i]);
+                bounds[2*i+1] = std::max(bounds[2*i+1], chunkBounds[2*i+1]);
+            }
+        });
+    }
+    Geometry3D::Pointer geometry = Geometry3D::New();
+    geometry->SetFloatBounds(bounds);
+    return geometry.GetPointer();
+}
+
+mitk::TractogramFileWriter::TractogramFileWriter(const std::string& filename, const BaseGeometry* referenceGeometry, bool lps)
+    : m_File(nullptr)
+    , m_IsTrk(false)
+    , m_NumFibers(0)
+    , m_CountPosition(0)
+{
+    std::string ext = GetExtension(filename);
+    if (ext!=".tck" && ext!=".trk")
+        mitkThrow() << "Unknown tractogram format " << ext;
+    m_IsTrk = ext==".trk";
+
+    m_File = std::fopen(filename.c_str(), "wb");
+    if (m_File==nullptr)
+        mitkThrow() << "Could not create " << filename;
+
+    bool headerWritten = false;
+    if (m_IsTrk)
+    {
+        TrackVis_header header;
+        std::memset(&header, 0, sizeof(header));
+        std::strcpy(header.id_string, "TRACK");
+        if (referenceGeometry!=nullptr)
+        {
+            for (int d=0; d<3; d++)
+            {
+                header.dim[d] = referenceGeometry->GetExtent(d);
+                header.voxel_size[d] = referenceGeometry->GetSpacing()[d];
+                header.origin[d] = referenceGeometry->GetOrigin()[d];
+            }
+        }
+        std::memcpy(header.voxel_order, lps ? "LPS" : "RAS", 4);
+        header.image_orientation_patient[0] = 1.0;
+        header.image_orientation_patient[4] = 1.0;
+        header.version = 1;
+        header.hdr_size = 1000;
+        headerWritten = std::fwrite(&header, 1, sizeof(header), m_File)==sizeof(header);
+
+        m_CountPosition = TRK_COUNT_POSITION;
+        m_Flip[0] = lps ? 1 : -1; m_Flip[1] = lps ? 1 : -1; m_Flip[2] = 1;
+    }
+    else
+    {
+        // the count is written with fixed width, so it can be replaced by Close(); the data starts 16 byte aligned
+        std::string header = "mrtrix tracks\ndatatype: Float32LE\ncount: ";
+        m_CountPosition = header.size();
+        header += "0000000000\nfile: . ";
+        const std::string end = "\nEND\n";
+        std::size_t dataOffset = header.size()+end.size()+4;
+        dataOffset += (16-dataOffset%16)%16;
+        header += std::to_string(dataOffset) + end;
+        header.resize(dataOffset, '\0');
+        headerWritten = std::fwrite(header.data(), 1, header.size(), m_File)==header.size();
+
+        m_Flip[0] = -1; m_Flip[1] = -1; m_Flip[2] = 1; // LPS (MITK) to RAS (MRtrix)
+    }
+
+    // the destructor is not called if the constructor throws, so the incomplete file is closed and removed here
+    if (!headerWritten)
+    {
+        std::fclose(m_File);
+        m_File = nullptr;
+        std::remove(filename.c_str());
+        mitkThrow() << "Could not write header of " << filename;
+    }
+}
+
+mitk::TractogramFileWriter::~TractogramFileWriter()
+{
+    try
+    {
+        this->Close();
+    }
+    catch(const std::exception& e)
+    {
+        MITK_ERROR << e.what();
+    }
+}
+
+void mitk::TractogramFileWriter::Write(const float* points, std::size_t numPoints)
+{
+    if (m_File==nullptr)
+        mitkThrow() << "Tractogram file is closed";
+    if (numPoints==0)
+        return;
+
+    const std::size_t size = m_Buffer.size();
+    if (m_IsTrk)
+    {
+        std::int32_t n = static_cast<std::int32_t>(numPoints);
+        m_Buffer.resize(size + 4 + 12*numPoints);
+        std::memcpy(&m_Buffer[size], &n, 4);
+    }
+    else
+        m_Buffer.resize(size + 12*(numPoints+1));
+
+    float* out = reinterpret_cast<float*>(&m_Buffer[m_IsTrk ? size+4 : size]);
+    for (std::size_t j=0; j<numPoints; j++)
+        for (int d=0; d<3; d++)
+            out[3*j+d] = m_Flip[d]*points[3*j+d];
+    if (!m_IsTrk)
+        std::fill(out+3*numPoints, out+3*numPoints+3, std::numeric_limits<float>::quiet_NaN());
+    m_NumFibers++;
+
+    if (m_Buffer.size()>WRITE_BUFFER_SIZE)
+    {
+        if (std::fwrite(m_Buffer.data(), 1, m_Buffer.size(), m_File)!=m_Buffer.size())
+            mitkThrow() << "Could not write fibers";
+        m_Buffer.clear();
+    }
+}
+
+void mitk::TractogramFileWriter::Write(const FiberContainer& fibers)
+{
+    for (std::size_t i=0; i<fibers.GetNumberOfFibers(); i++)
+        this->Write(fibers.GetPoints(i), fibers.GetNumberOfPoints(i));
+}
+
+void mitk::TractogramFileWriter::Write(const FiberBundle* fib)
+{
+    this->Write(fib->GetFiberContainer());
+}
+
+void mitk::TractogramFileWriter::Close()
+{
+    if (m_File==nullptr)
+        return;
+
+    std::FILE* file = m_File;
+    m_File = nullptr;
+    if (!m_IsTrk)
+    {
+        const float terminator[3] = { std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity() };
+        const char* bytes = reinterpret_cast<const char*>(terminator);
+        m_Buffer.insert(m_Buffer.end(), bytes, bytes+sizeof(terminator));
+    }
+    bool ok = std::fwrite(m_Buffer.data(), 1, m_Buffer.size(), file)==m_Buffer.size();
+    m_Buffer.clear();
+
+    ok = ok && std::fseek(file, m_CountPosition, SEEK_SET)==0;
+    if (m_IsTrk)
+    {
+        std::int32_t count = static_cast<std::int32_t>(m_NumFibers);
+        ok = ok && std::fwrite(&count, 1, 4, file)==4;
+    }
+    else
+    {
+        char count[11];
+        std::snprintf(count, sizeof(count), "%010lu", static_cast<unsigned long>(m_NumFibers));
+        ok = ok && std::fwrite(count, 1, 10, file)==10;
+    }
+    ok = std::fclose(file)==0 && ok;
+    if (!ok)
+        mitkThrow() << "Could not write fibers";
+}
+
+void mitk::TractogramFileWriter::WriteFiberBundle(const FiberBundle* fib, const std::string& filename, bool lps)
+{
+    const BaseGeometry* geometry = fib->GetReferenceGeometry().IsNotNull() ? fib->GetReferenceGeometry().GetPointer() : fib->GetGeometry();
+    TractogramFileWriter writer(filename, geometry, lps);
+    writer.Write(fib);
+    writer.Close();
+}
@@ -0,0 +1,136 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef _MITK_TractogramFile_H
+#define _MITK_TractogramFile_H
+
+#include <MitkFiberTrackingExports.h>
+
+#include <mitkFiberBundle.h>
+#include <mitkFiberContainer.h>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mitk {
+
+/**
+  * \brief Reads MRtrix (.tck) and TrackVis (.trk) tractograms via memory mapping.
+  *
+  * The constructor maps the file, parses the header and indexes the fibers. The points are only read when fibers
+  * are requested, either all at once as fiber bundle or chunk by chunk. Pages of chunks that were streamed are
+  * released again, so files larger than the main memory can be processed. Points are returned in LPS.
+  */
+class MITKFIBERTRACKING_EXPORT TractogramFileReader
+{
+public:
+
+    /** Called with consecutive chunks of fibers; firstFiber is the index of the first fiber of the chunk in the file. */
+    typedef std::function< void(const FiberContainer& fibers, std::size_t firstFiber) > ChunkFunctionType;
+
+    /** Throws an mitk::Exception if the file can not be mapped or is not a valid .tck or .trk file. */
+    explicit TractogramFileReader(const std::string& filename);
+    ~TractogramFileReader();
+
+    TractogramFileReader(const TractogramFileReader&) = delete;
+    TractogramFileReader& operator=(const TractogramFileReader&) = delete;
+
+    std::size_t GetNumberOfFibers() const { return m_NumPoints.size(); }
+    std::size_t GetNumberOfPoints() const;
+
+    /** Reads the fibers first to first+count-1. */
+    FiberContainer ReadFibers(std::size_t first, std::size_t count) const;
+
+    /** Reads all fibers. For .trk files, the reference geometry is set from the header. */
+    FiberBundle::Pointer ReadFiberBundle() const;
+
+    /** Passes all fibers to the function in chunks of the given size. */
+    void StreamFibers(const ChunkFunctionType& function, std::size_t fibersPerChunk = 100000) const;
+
+    /** Geometry with the bounds of all fibers, like the geometry of a fiber bundle. Needs one pass over the file. */
+    BaseGeometry::Pointer GetBoundingGeometry() const;
+
+private:
+
+    struct MappedFile;
+
+    void IndexTck();
+    void IndexTrk();
+
+    std::unique_ptr< MappedFile > m_File;
+    bool                        m_IsTrk;
+
+    /** Size in bytes of one coordinate (4 or 8) and of the data of one point. */
+    std::size_t                 m_ValueSize;
+    std::size_t                 m_PointStride;
+
+    /** Sign of the coordinates to convert them to LPS. */
+    float                       m_Flip[3];
+    BaseGeometry::Pointer       m_ReferenceGeometry;
+
+    /** Byte offset of the first point and number of points of each fiber. */
+    std::vector< std::size_t >  m_FiberOffsets;
+    std::vector< std::size_t >  m_NumPoints;
+};
+
+/**
+  * \brief Writes MRtrix (.tck) and TrackVis (.trk) tractograms fiber by fiber.
+  *
+  * The format is chosen by the file extension. Fibers can be written in any number of calls, so tracking results
+  * can be written without collecting them in one fiber bundle first. The fiber count in the header is written
+  * by Close(), which is also called by the destructor. Points are expected in LPS.
+  */
+class MITKFIBERTRACKING_EXPORT TractogramFileWriter
+{
+public:
+
+    /**
+      * The reference geometry defines the dimensions, spacing and origin of the .trk header. The .tck format is
+      * always RAS, for .trk the points are stored in LPS or RAS. Throws an mitk::Exception if the file can not be created.
+      */
+    TractogramFileWriter(const std::string& filename, const BaseGeometry* referenceGeometry = nullptr, bool lps = true);
+    ~TractogramFileWriter();
+
+    TractogramFileWriter(const TractogramFileWriter&) = delete;
+    TractogramFileWriter& operator=(const TractogramFileWriter&) = delete;
+
+    void Write(const float* points, std::size_t numPoints);
+    void Write(const FiberContainer& fibers);
+    void Write(const FiberBundle* fib);
+
+    /** Terminates the file and writes the fiber count to the header. */
+    void Close();
+
+    std::size_t GetNumberOfFibers() const { return m_NumFibers; }
+
+    /** Writes the bundle to a .tck or .trk file, the reference geometry of the bundle (or its geometry) is used for the header. */
+    static void WriteFiberBundle(const FiberBundle* fib, const std::string& filename, bool lps = true);
+
+private:
+
+    std::FILE*          m_File;
+    bool                m_IsTrk;
+    float               m_Flip[3];
+    std::size_t         m_NumFibers;
+    long                m_CountPosition;
+    std::vector< char > m_Buffer;
+};
+
+}
+
+#endif
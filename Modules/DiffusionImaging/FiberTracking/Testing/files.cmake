@@ -1,6 +1,7 @@
 SET(MODULE_CUSTOM_TESTS
   mitkFiberBundleReaderWriterTest.cpp
   mitkGibbsTrackingTest.cpp
+  mitkGibbsTrackingParallelSamplingTest.cpp
   mitkStreamlineTrackingTest.cpp
   mitkPeakExtractionTest.cpp
   mitkLocalFiberPlausibilityTest.cpp
@@ -10,6 +11,10 @@ SET(MODULE_CUSTOM_TESTS
   mitkFiberfoxSignalGenerationTest.cpp
   mitkMachineLearningTrackingTest.cpp
   mitkFiberProcessingTest.cpp
+  mitkFiberSegmentIndexTest.cpp
+  mitkFiberContainerTest.cpp
+  mitkTractogramFileTest.cpp
+  mitkTractDensityImageFilterTest.cpp
 )
 
 
@@ -0,0 +1,106 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include <mitkFiberBundle.h>
+#include <mitkFiberContainer.h>
+#include <itkTimeProbe.h>
+#include "mitkTestFixture.h"
+#include "mitkRandomWalkFibersTestHelper.h"
+
+class mitkFiberContainerTestSuite : public mitk::TestFixture
+{
+
+    CPPUNIT_TEST_SUITE(mitkFiberContainerTestSuite);
+    MITK_TEST(TestPolyDataRoundTrip);
+    MITK_TEST(TestResampleLinear);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+
+    /** Members used inside the different (sub-)tests. All members are initialized via setUp().*/
+    mitk::FiberBundle::Pointer  m_Fibers;
+
+public:
+
+    void setUp() override
+    {
+        m_Fibers = mitk::FiberBundle::New(mitk::CreateRandomWalkFibers(1, 5000));
+        for (int i=0; i<m_Fibers->GetNumFibers(); ++i)
+            m_Fibers->SetFiberWeight(i, i);
+    }
+
+    void tearDown() override
+    {
+        m_Fibers = nullptr;
+    }
+
+    void TestPolyDataRoundTrip()
+    {
+        const mitk::FiberContainer& container = m_Fibers->GetFiberContainer();
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Number of fibers", static_cast<std::size_t>(m_Fibers->GetNumFibers()), container.GetNumberOfFibers());
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Number of points", static_cast<std::size_t>(m_Fibers->GetNumberOfPoints()), container.GetNumberOfPoints());
+
+        mitk::FiberBundle::Pointer copy = mitk::FiberBundle::New(container.GetPolyData());
+        CPPUNIT_ASSERT_MESSAGE("Poly data of the container equals the original fibers", m_Fibers->Equals(copy, 0.0001));
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Fiber length", m_Fibers->GetMeanFiberLength(), copy->GetMeanFiberLength());
+
+        MITK_INFO << "Memory of " << m_Fibers->GetNumFibers() << " fibers: " << container.GetMemorySize()/1024 << " KB fiber container, "
+                  << m_Fibers->GetFiberPolyData()->GetActualMemorySize() << " KB vtkPolyData";
+    }
+
+    void TestResampleLinear()
+    {
+        mitk::FiberBundle::Pointer reference = m_Fibers->GetDeepCopy();
+        vtkSmartPointer<vtkPolyData> polyData = reference->GetFiberPolyData();
+
+        itk::TimeProbe clock;
+        clock.Start();
+        m_Fibers->ResampleLinear(0.5);
+        clock.Stop();
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Number of fibers after resampling", reference->GetNumFibers(), m_Fibers->GetNumFibers());
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Number of colors after resampling", static_cast<vtkIdType>(m_Fibers->GetNumberOfPoints()), m_Fibers->GetFiberColors()->GetNumberOfTuples());
+        for (int i=0; i<m_Fibers->GetNumFibers(); ++i)
+        {
+            CPPUNIT_ASSERT_EQUAL_MESSAGE("Fiber order and weights are kept", static_cast<float>(i), m_Fibers->GetFiberWeight(i));
+
+            // the resampled fiber keeps the endpoints and cuts corners
+            vtkCell* cell = polyData->GetCell(i);
+            double start[3];
+            double end[3];
+            cell->GetPoints()->GetPoint(0, start);
+            cell->GetPoints()->GetPoint(cell->GetNumberOfPoints()-1, end);
+            const mitk::FiberContainer& resampled = m_Fibers->GetFiberContainer();
+            const float* points = resampled.GetPoints(i);
+            const std::size_t last = 3*(resampled.GetNumberOfPoints(i)-1);
+            for (int d=0; d<3; ++d)
+            {
+                CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Start point", start[d], points[d], 0.001);
+                CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("End point", end[d], points[last+d], 0.001);
+            }
+            CPPUNIT_ASSERT_MESSAGE("Fiber length", resampled.GetFiberLength(i) <= reference->GetFiberContainer().GetFiberLength(i) + 0.001);
+        }
+
+        // the poly data view is created on request and holds the same fibers
+        mitk::FiberBundle::Pointer copy = mitk::FiberBundle::New(m_Fibers->GetFiberPolyData());
+        CPPUNIT_ASSERT_MESSAGE("Poly data view equals the resampled fibers", m_Fibers->Equals(copy, 0.0001));
+
+        MITK_INFO << "Linear resampling of " << m_Fibers->GetNumFibers() << " fibers: " << clock.GetTotal() << "s";
+    }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkFiberContainer)
@@ -0,0 +1,223 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include <mitkFiberBundle.h>
+#include <mitkFiberSegmentIndex.h>
+#include <vtkCellArray.h>
+#include <vtkPolyLine.h>
+#include <vtkMath.h>
+#include <itkTimeProbe.h>
+#include <random>
+#include <algorithm>
+#include "mitkTestFixture.h"
+#include "mitkRandomWalkFibersTestHelper.h"
+
+class mitkFiberSegmentIndexTestSuite : public mitk::TestFixture
+{
+
+    CPPUNIT_TEST_SUITE(mitkFiberSegmentIndexTestSuite);
+    MITK_TEST(TestCandidateFibers);
+    MITK_TEST(TestSubtractBundle);
+    MITK_TEST(TestContainsFiberDoublePrecision);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+
+    /** Members used inside the different (sub-)tests. All members are initialized via setUp().*/
+    mitk::FiberBundle::Pointer  m_Fibers;
+
+    static std::vector< double > GetEndpoints(mitk::FiberBundle* fibers)
+    {
+        std::vector< double > endpoints;
+        for (int i=0; i<fibers->GetNumFibers(); ++i)
+        {
+            vtkCell* cell = fibers->GetFiberPolyData()->GetCell(i);
+            double p[3];
+            cell->GetPoints()->GetPoint(0, p);
+            endpoints.insert(endpoints.end(), p, p+3);
+            cell->GetPoints()->GetPoint(cell->GetNumberOfPoints()-1, p);
+            endpoints.insert(endpoints.end(), p, p+3);
+        }
+        return endpoints;
+    }
+
+    static bool SegmentOverlapsBox(const double p1[3], const double p2[3], const double bounds[6])
+    {
+        for (int d=0; d<3; ++d)
+        {
+            if (std::max(p1[d], p2[d])<bounds[2*d] || std::min(p1[d], p2[d])>bounds[2*d+1])
+                return false;
+        }
+        return true;
+    }
+
+public:
+
+    void setUp() override
+    {
+        // random walks, some with very long segments
+        m_Fibers = mitk::FiberBundle::New(mitk::CreateRandomWalkFibers(1, 20000, 60, 31));
+    }
+
+    void tearDown() override
+    {
+        m_Fibers = nullptr;
+    }
+
+    void TestCandidateFibers()
+    {
+        const mitk::FiberSegmentIndex* index = m_Fibers->GetSegmentIndex();
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Number of indexed fibers", static_cast<unsigned long>(m_Fibers->GetNumFibers()), index->GetNumberOfFibers());
+
+        vtkPolyData* polyData = m_Fibers->GetFiberPolyData();
+        std::mt19937 randGen(2);
+        std::uniform_real_distribution<double> position(-80, 80);
+        std::uniform_real_distribution<double> size(0, 15);
+        for (int q=0; q<20; ++q)
+        {
+            double bounds[6];
+            for (int d=0; d<3; ++d)
+            {
+                bounds[2*d] = position(randGen);
+                bounds[2*d+1] = bounds[2*d] + (q%5==0 ? 0 : size(randGen));
+            }
+
+            std::vector< long > candidates = index->GetCandidateFibers(bounds);
+            CPPUNIT_ASSERT_MESSAGE("Candidates are sorted", std::is_sorted(candidates.begin(), candidates.end()));
+            CPPUNIT_ASSERT_MESSAGE("Candidates are unique", std::adjacent_find(candidates.begin(), candidates.end())==candidates.end());
+
+            for (long i=0; i<m_Fibers->GetNumFibers(); ++i)
+            {
+                vtkCell* cell = polyData->GetCell(i);
+                int numPoints = cell->GetNumberOfPoints();
+                vtkPoints* points = cell->GetPoints();
+
+                bool overlaps = false;
+                for (int j=0; j<numPoints-1 && !overlaps; ++j)
+                {
+                    double p1[3];
+                    double p2[3];
+                    points->GetPoint(j, p1);
+                    points->GetPoint(j+1, p2);
+                    overlaps = SegmentOverlapsBox(p1, p2, bounds);
+                }
+
+                if (overlaps)
+                    CPPUNIT_ASSERT_MESSAGE("Fiber passing the box is a candidate", std::binary_search(candidates.begin(), candidates.end(), i));
+            }
+        }
+    }
+
+    void TestSubtractBundle()
+    {
+        // every third fiber, every second of them reversed, and some fibers that are not part of the bundle
+        vtkPolyData* polyData = m_Fibers->GetFiberPolyData();
+        vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+        vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+        int numSubtracted = 0;
+        for (int i=0; i<m_Fibers->GetNumFibers(); i+=3)
+        {
+            vtkCell* cell = polyData->GetCell(i);
+            int numPoints = cell->GetNumberOfPoints();
+            vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+            for (int j=0; j<numPoints; ++j)
+            {
+                int k = i%2==0 ? j : numPoints-1-j;
+                container->GetPointIds()->InsertNextId(points->InsertNextPoint(cell->GetPoints()->GetPoint(k)));
+            }
+            lines->InsertNextCell(container);
+            ++numSubtracted;
+        }
+        vtkSmartPointer<vtkPolyData> other = mitk::CreateRandomWalkFibers(3, 100, 60, 31);
+        for (int i=0; i<other->GetNumberOfCells(); ++i)
+        {
+            vtkCell* cell = other->GetCell(i);
+            vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+            for (int j=0; j<cell->GetNumberOfPoints(); ++j)
+                container->GetPointIds()->InsertNextId(points->InsertNextPoint(cell->GetPoints()->GetPoint(j)));
+            lines->InsertNextCell(container);
+        }
+        vtkSmartPointer<vtkPolyData> subset = vtkSmartPointer<vtkPolyData>::New();
+        subset->SetPoints(points);
+        subset->SetLines(lines);
+        mitk::FiberBundle::Pointer subtrahend = mitk::FiberBundle::New(subset);
+
+        itk::TimeProbe indexTime;
+        indexTime.Start();
+        mitk::FiberBundle::Pointer result = m_Fibers->SubtractBundle(subtrahend);
+        indexTime.Stop();
+
+        CPPUNIT_ASSERT_MESSAGE("Subtraction result exists", result.IsNotNull());
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Number of remaining fibers", m_Fibers->GetNumFibers()-numSubtracted, result->GetNumFibers());
+        CPPUNIT_ASSERT_MESSAGE("Subtracting the bundle from itself leaves nothing", m_Fibers->SubtractBundle(m_Fibers).IsNull());
+
+        // the pairwise endpoint comparison replaced by the index
+        itk::TimeProbe bruteForceTime;
+        bruteForceTime.Start();
+        std::vector< double > endpoints1 = GetEndpoints(m_Fibers);
+        std::vector< double > endpoints2 = GetEndpoints(subtrahend);
+        int numMatches = 0;
+        for (std::size_t i=0; i<endpoints1.size(); i+=6)
+        {
+            const double* s1 = &endpoints1[i];
+            const double* e1 = &endpoints1[i+3];
+            for (std::size_t j=0; j<endpoints2.size(); j+=6)
+            {
+                const double* s2 = &endpoints2[j];
+                const double* e2 = &endpoints2[j+3];
+                if ((vtkMath::Distance2BetweenPoints(s1, s2)<mitk::eps && vtkMath::Distance2BetweenPoints(e1, e2)<mitk::eps) ||
+                    (vtkMath::Distance2BetweenPoints(s1, e2)<mitk::eps && vtkMath::Distance2BetweenPoints(e1, s2)<mitk::eps))
+                {
+                    ++numMatches;
+                    break;
+                }
+            }
+        }
+        bruteForceTime.Stop();
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Brute force finds the same fibers", numSubtracted, numMatches);
+        MITK_INFO << "Subtracting " << subtrahend->GetNumFibers() << " from " << m_Fibers->GetNumFibers() << " fibers: "
+                  << indexTime.GetTotal() << "s with index, " << bruteForceTime.GetTotal() << "s pairwise endpoint comparison";
+    }
+
+    void TestContainsFiberDoublePrecision()
+    {
+        // endpoints that are not representable in single precision
+        const double start[3] = { 0.1, 1.0/3.0, -12.345678901234 };
+        const double end[3] = { 20.0/7.0, -0.7, 5.000000123456789 };
+        vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+        points->SetDataTypeToDouble();
+        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+        container->GetPointIds()->InsertNextId(points->InsertNextPoint(start));
+        container->GetPointIds()->InsertNextId(points->InsertNextPoint(1.0, 0.5, -3.0));
+        container->GetPointIds()->InsertNextId(points->InsertNextPoint(end));
+        vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+        lines->InsertNextCell(container);
+        vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+        polyData->SetPoints(points);
+        polyData->SetLines(lines);
+
+        mitk::FiberSegmentIndex index(polyData);
+        CPPUNIT_ASSERT_MESSAGE("Fiber with double precision endpoints is found", index.ContainsFiber(start, end, mitk::eps));
+        CPPUNIT_ASSERT_MESSAGE("Reversed fiber with double precision endpoints is found", index.ContainsFiber(end, start, mitk::eps));
+
+        double shifted[3] = { start[0]+1e-5, start[1], start[2] };
+        CPPUNIT_ASSERT_MESSAGE("Fiber with a different start point is not found", !index.ContainsFiber(shifted, end, mitk::eps));
+    }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkFiberSegmentIndex)
@@ -0,0 +1,113 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkQBallImage.h>
+#include <itkGibbsTrackingFilter.h>
+#include <itkOrientationDistributionFunction.h>
+#include <omp.h>
+#include <algorithm>
+#include <cmath>
+
+typedef itk::Vector<float, QBALL_ODFSIZE> OdfVectorType;
+typedef itk::Image<OdfVectorType,3> OdfVectorImgType;
+typedef itk::GibbsTrackingFilter<OdfVectorImgType> GibbsTrackingFilterType;
+
+/** Small volume in which every ODF has a sharp peak along the x axis. */
+static OdfVectorImgType::Pointer CreateOdfImage()
+{
+  OdfVectorImgType::RegionType region;
+  region.SetSize(0, 16);
+  region.SetSize(1, 8);
+  region.SetSize(2, 8);
+  OdfVectorImgType::SpacingType spacing;
+  spacing.Fill(2.0);
+
+  OdfVectorType odf;
+  for (int i=0; i<QBALL_ODFSIZE; i++)
+  {
+    double x = itk::OrientationDistributionFunction<float, QBALL_ODFSIZE>::GetDirection(i)[0];
+    odf[i] = std::pow(x*x, 4);
+  }
+
+  OdfVectorImgType::Pointer image = OdfVectorImgType::New();
+  image->SetSpacing(spacing);
+  image->SetRegions(region);
+  image->Allocate();
+  image->FillBuffer(odf);
+  return image;
+}
+
+static GibbsTrackingFilterType::Pointer Track(OdfVectorImgType* image, int numberOfThreads, bool parallelSampling=true)
+{
+  omp_set_num_threads(numberOfThreads);
+
+  GibbsTrackingFilterType::Pointer gibbsTracker = GibbsTrackingFilterType::New();
+  gibbsTracker->SetQBallImage(image);
+  gibbsTracker->SetDuplicateImage(true);
+  gibbsTracker->SetRandomSeed(1);
+  gibbsTracker->SetIterations(500000);
+  gibbsTracker->SetMinFiberLength(0);
+  gibbsTracker->SetParallelSampling(parallelSampling);
+  gibbsTracker->Update();
+  return gibbsTracker;
+}
+
+/**Documentation
+ *  Test for the parallel block sampling of the gibbs tracking filter on synthetic data.
+ *  With a fixed seed, the sampling must not depend on the number of threads. The block sampler has to reach
+ *  the same equilibrium as the serial sampler of the whole grid, up to statistical fluctuations.
+ */
+int mitkGibbsTrackingParallelSamplingTest(int, char*[])
+{
+  MITK_TEST_BEGIN("mitkGibbsTrackingParallelSamplingTest");
+
+  OdfVectorImgType::Pointer image = CreateOdfImage();
+  int maxThreads = std::max(2, omp_get_num_procs());
+
+  GibbsTrackingFilterType::Pointer serial = Track(image, 1);
+  GibbsTrackingFilterType::Pointer parallel = Track(image, maxThreads);
+  omp_set_num_threads(omp_get_num_procs());
+
+  MITK_INFO << "1 thread: " << serial->GetNumParticles() << " particles, " << serial->GetNumConnections() << " connections, acceptance " << serial->GetProposalAcceptance();
+  MITK_INFO << maxThreads << " threads: " << parallel->GetNumParticles() << " particles, " << parallel->GetNumConnections() << " connections, acceptance " << parallel->GetProposalAcceptance();
+
+  MITK_TEST_CONDITION_REQUIRED(serial->GetIsInValidState(), "check if tracking is in valid state");
+  MITK_TEST_CONDITION_REQUIRED(serial->GetCurrentIteration()>0, "check if proposals were made");
+  MITK_TEST_CONDITION_REQUIRED(serial->GetProposalAcceptance()>0 && serial->GetProposalAcceptance()<1, "check proposal acceptance");
+  MITK_TEST_CONDITION_REQUIRED(serial->GetNumParticles()>0, "check if particles were created");
+  MITK_TEST_CONDITION_REQUIRED(serial->GetNumConnections()>0, "check if particles were connected");
+
+  MITK_TEST_CONDITION_REQUIRED(serial->GetCurrentIteration()==parallel->GetCurrentIteration(), "check if number of proposals is independent of the number of threads");
+  MITK_TEST_CONDITION_REQUIRED(serial->GetProposalAcceptance()==parallel->GetProposalAcceptance(), "check if proposal acceptance is independent of the number of threads");
+  MITK_TEST_CONDITION_REQUIRED(serial->GetNumParticles()==parallel->GetNumParticles(), "check if number of particles is independent of the number of threads");
+  MITK_TEST_CONDITION_REQUIRED(serial->GetNumConnections()==parallel->GetNumConnections(), "check if number of connections is independent of the number of threads");
+  MITK_TEST_CONDITION_REQUIRED(serial->GetNumAcceptedFibers()==parallel->GetNumAcceptedFibers(), "check if number of fibers is independent of the number of threads");
+
+  // different chains, compare the final particle configurations within a tolerance
+  const double tolerance = 0.2;
+  GibbsTrackingFilterType::Pointer wholeGrid = Track(image, 1, false);
+  omp_set_num_threads(omp_get_num_procs());
+  MITK_INFO << "Serial sampler: " << wholeGrid->GetNumParticles() << " particles, energy " << wholeGrid->GetEnergy();
+  MITK_INFO << "Block sampler: " << serial->GetNumParticles() << " particles, energy " << serial->GetEnergy();
+
+  MITK_TEST_CONDITION_REQUIRED(wholeGrid->GetIsInValidState(), "check if serial tracking is in valid state");
+  MITK_TEST_CONDITION_REQUIRED(wholeGrid->GetNumParticles()>0, "check if serial sampler created particles");
+  MITK_TEST_CONDITION_REQUIRED(std::fabs(serial->GetNumParticles()-wholeGrid->GetNumParticles()) <= tolerance*wholeGrid->GetNumParticles(), "check if block sampler creates as many particles as the serial sampler");
+  MITK_TEST_CONDITION_REQUIRED(std::fabs(serial->GetEnergy()-wholeGrid->GetEnergy()) <= tolerance*std::fabs(wholeGrid->GetEnergy()), "check if block sampler reaches the energy of the serial sampler");
+
+  MITK_TEST_END();
+}
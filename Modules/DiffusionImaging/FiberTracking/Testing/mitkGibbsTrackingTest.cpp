@@ -20,6 +20,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkGibbsTrackingFilter.h>
 #include <mitkFiberBundle.h>
 #include <mitkIOUtil.h>
+#include <omp.h>
 
 using namespace mitk;
 
@@ -81,6 +82,20 @@ int mitkGibbsTrackingTest(int argc, char* argv[])
     gibbsTracker->Update();
     fib2 = mitk::FiberBundle::New(gibbsTracker->GetFiberBundle());
     MITK_TEST_CONDITION_REQUIRED(!fib1->Equals(fib2), "check if gibbs tracking has changed after wrong seed");
+
+    // block parallel sampling only depends on the seed, the order of the fibers may differ
+    gibbsTracker->SetRandomSeed(1);
+    gibbsTracker->SetParallelSampling(true);
+    omp_set_num_threads(1);
+    gibbsTracker->SetAbortTracking(false);
+    gibbsTracker->Update();
+    fib2 = mitk::FiberBundle::New(gibbsTracker->GetFiberBundle());
+    omp_set_num_threads(omp_get_num_procs());
+    gibbsTracker->SetAbortTracking(false);
+    gibbsTracker->Update();
+    mitk::FiberBundle::Pointer fib3 = mitk::FiberBundle::New(gibbsTracker->GetFiberBundle());
+    MITK_TEST_CONDITION_REQUIRED(fib2->GetNumFibers()>0, "check if parallel gibbs tracking produces fibers");
+    MITK_TEST_CONDITION_REQUIRED(fib2->GetNumFibers()==fib3->GetNumFibers() && fabs(fib2->GetMeanFiberLength()-fib3->GetMeanFiberLength())<0.001, "check if parallel gibbs tracking is independent of the number of threads");
   }
   catch(...)
   {
@@ -0,0 +1,67 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkRandomWalkFibersTestHelper_h
+#define mitkRandomWalkFibersTestHelper_h
+
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkPolyLine.h>
+#include <random>
+
+namespace mitk
+{
+
+/**
+ * Creates reproducible random walk fibers with 2 to 41 points and normally distributed steps.
+ * The fibers start uniformly inside of the cube [-extent, extent]^3. If longSegmentPeriod is set,
+ * the steps of every longSegmentPeriod-th fiber are scaled by 20.
+ */
+inline vtkSmartPointer<vtkPolyData> CreateRandomWalkFibers(unsigned int seed, unsigned int numFibers, double extent = 60, unsigned int longSegmentPeriod = 0)
+{
+  std::mt19937 randGen(seed);
+  std::uniform_real_distribution<double> position(-extent, extent);
+  std::normal_distribution<double> step(0, 1.5);
+
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+  for (unsigned int i=0; i<numFibers; ++i)
+  {
+    double p[3] = { position(randGen), position(randGen), position(randGen) };
+    const int numPoints = 2 + randGen()%40;
+    const double stepScale = longSegmentPeriod>0 && i%longSegmentPeriod==0 ? 20 : 1;
+
+    vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+    for (int j=0; j<numPoints; ++j)
+    {
+      container->GetPointIds()->InsertNextId(points->InsertNextPoint(p));
+      for (int d=0; d<3; ++d)
+        p[d] += stepScale*step(randGen);
+    }
+    lines->InsertNextCell(container);
+  }
+
+  vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+  polyData->SetPoints(points);
+  polyData->SetLines(lines);
+  return polyData;
+}
+
+}
+
+#endif
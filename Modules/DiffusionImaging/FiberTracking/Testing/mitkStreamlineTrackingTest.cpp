@@ -76,34 +76,40 @@ int mitkStreamlineTrackingTest(int argc, char* argv[])
 
         // tracker
         typedef itk::StreamlineTrackingFilter TrackerType;
-        TrackerType::Pointer tracker = TrackerType::New();
-        tracker->SetSeedsPerVoxel(numSeeds);
-        tracker->SetNumberOfSamples(0);
-        tracker->SetStepSize(stepSize);
-        tracker->SetAposterioriCurvCheck(false);
-        tracker->SetSeedOnlyGm(false);
-        tracker->SetTrackingHandler(handler);
-        tracker->SetMinTractLength(minLength);
-        tracker->SetRandom(false);
-
-        if (mitkSeedImage.IsNotNull())
+        auto track = [&](int maxNumTracts)
         {
-            ItkUCharImageType::Pointer mask = ItkUCharImageType::New();
-            mitk::CastToItkImage(mitkSeedImage, mask);
-            tracker->SetSeedImage(mask);
-        }
-
-        if (mitkMaskImage.IsNotNull())
-        {
-            ItkUCharImageType::Pointer mask = ItkUCharImageType::New();
-            mitk::CastToItkImage(mitkMaskImage, mask);
-            tracker->SetMaskImage(mask);
-        }
-
-        tracker->Update();
-
-        vtkSmartPointer<vtkPolyData> fiberBundle = tracker->GetFiberPolyData();
-        mitk::FiberBundle::Pointer fib1 = mitk::FiberBundle::New(fiberBundle);
+            TrackerType::Pointer tracker = TrackerType::New();
+            tracker->SetSeedsPerVoxel(numSeeds);
+            tracker->SetNumberOfSamples(0);
+            tracker->SetStepSize(stepSize);
+            tracker->SetAposterioriCurvCheck(false);
+            tracker->SetSeedOnlyGm(false);
+            tracker->SetTrackingHandler(handler);
+            tracker->SetMinTractLength(minLength);
+            tracker->SetRandom(false);
+            if (maxNumTracts>0)
+                tracker->SetMaxNumTracts(maxNumTracts);
+
+            if (mitkSeedImage.IsNotNull())
+            {
+                ItkUCharImageType::Pointer mask = ItkUCharImageType::New();
+                mitk::CastToItkImage(mitkSeedImage, mask);
+                tracker->SetSeedImage(mask);
+            }
+
+            if (mitkMaskImage.IsNotNull())
+            {
+                ItkUCharImageType::Pointer mask = ItkUCharImageType::New();
+                mitk::CastToItkImage(mitkMaskImage, mask);
+                tracker->SetMaskImage(mask);
+            }
+
+            tracker->Update();
+            MITK_INFO << "Streamlines per second using " << omp_get_max_threads() << " threads: " << tracker->GetStreamlinesPerSecond();
+            return mitk::FiberBundle::New(tracker->GetFiberPolyData());
+        };
+
+        mitk::FiberBundle::Pointer fib1 = track(-1);
 
         mitk::FiberBundle::Pointer fib2 = dynamic_cast<mitk::FiberBundle*>(mitk::IOUtil::LoadDataNode(referenceFileName)->GetData());
         MITK_TEST_CONDITION_REQUIRED(fib2.IsNotNull(), "Check if reference tractogram is not null.");
@@ -116,6 +122,20 @@ int mitkStreamlineTrackingTest(int argc, char* argv[])
         }
         MITK_TEST_CONDITION_REQUIRED(ok, "Check if tractograms are equal.");
 
+        // the streamlines are collected per thread and merged in seed order, so the result does not depend on the number of threads
+        omp_set_num_threads(omp_get_num_procs());
+        mitk::FiberBundle::Pointer fib3 = track(-1);
+        MITK_TEST_CONDITION_REQUIRED(fib1->Equals(fib3), "Check if multi-threaded tractogram equals single-threaded tractogram.");
+
+        // with a maximum number of tracts, the tracts of the first seeds are kept independent of the number of threads
+        int maxNumTracts = fib1->GetNumFibers()/2;
+        omp_set_num_threads(1);
+        mitk::FiberBundle::Pointer fib4 = track(maxNumTracts);
+        omp_set_num_threads(omp_get_num_procs());
+        mitk::FiberBundle::Pointer fib5 = track(maxNumTracts);
+        MITK_TEST_CONDITION_REQUIRED(fib4->GetNumFibers()==maxNumTracts, "Check if tracking stops at the maximum number of tracts.");
+        MITK_TEST_CONDITION_REQUIRED(fib4->Equals(fib5), "Check if multi-threaded tractogram with maximum number of tracts equals single-threaded tractogram.");
+
         delete handler;
     }
     catch (itk::ExceptionObject e)
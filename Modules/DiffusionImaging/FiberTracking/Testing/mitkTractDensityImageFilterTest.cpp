@@ -0,0 +1,133 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include <mitkFiberBundle.h>
+#include <mitkTractogramFile.h>
+#include <mitkIOUtil.h>
+#include <itkTractDensityImageFilter.h>
+#include <itkTractsToFiberEndingsImageFilter.h>
+#include <itksys/SystemTools.hxx>
+#include "mitkTestFixture.h"
+#include "mitkRandomWalkFibersTestHelper.h"
+
+class mitkTractDensityImageFilterTestSuite : public mitk::TestFixture
+{
+
+    CPPUNIT_TEST_SUITE(mitkTractDensityImageFilterTestSuite);
+    MITK_TEST(TestVoxelTraversal);
+    MITK_TEST(TestStreaming);
+    CPPUNIT_TEST_SUITE_END();
+
+    typedef itk::Image<float, 3> FloatImageType;
+    typedef itk::Image<unsigned int, 3> UIntImageType;
+
+private:
+
+    /** Members used inside the different (sub-)tests. All members are initialized via setUp().*/
+    mitk::FiberBundle::Pointer  m_Fibers;
+
+    FloatImageType::Pointer GetDensity(mitk::FiberBundle* fib, const mitk::TractogramFileReader* reader)
+    {
+        itk::TractDensityImageFilter< FloatImageType >::Pointer generator = itk::TractDensityImageFilter< FloatImageType >::New();
+        generator->SetFiberBundle(fib);
+        generator->SetTractogramReader(reader);
+        generator->SetOutputAbsoluteValues(true);
+        generator->Update();
+        return generator->GetOutput();
+    }
+
+    UIntImageType::Pointer GetEndings(mitk::FiberBundle* fib, const mitk::TractogramFileReader* reader)
+    {
+        itk::TractsToFiberEndingsImageFilter< UIntImageType >::Pointer generator = itk::TractsToFiberEndingsImageFilter< UIntImageType >::New();
+        generator->SetFiberBundle(fib);
+        generator->SetTractogramReader(reader);
+        generator->Update();
+        return generator->GetOutput();
+    }
+
+public:
+
+    void setUp() override
+    {
+        m_Fibers = mitk::FiberBundle::New(mitk::CreateRandomWalkFibers(1, 500, 30));
+    }
+
+    void tearDown() override
+    {
+        m_Fibers = nullptr;
+    }
+
+    void TestVoxelTraversal()
+    {
+        FloatImageType::Pointer density = GetDensity(m_Fibers, nullptr);
+
+        // each voxel receives 0.1 per mm fiber length inside the voxel (1 mm spacing)
+        double sum = 0;
+        const float* buffer = density->GetBufferPointer();
+        for (std::size_t i=0; i<density->GetLargestPossibleRegion().GetNumberOfPixels(); ++i)
+            sum += buffer[i];
+        double length = 0;
+        for (int i=0; i<m_Fibers->GetNumFibers(); ++i)
+            length += m_Fibers->GetFiberContainer().GetFiberLength(i);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Accumulated fiber length", 0.1*length, sum, 0.001*sum);
+
+        // point based density of the fibers resampled to a tenth of the voxel size
+        mitk::FiberBundle::Pointer resampled = m_Fibers->GetDeepCopy();
+        resampled->ResampleLinear(0.1);
+        itk::TractDensityImageFilter< FloatImageType >::Pointer generator = itk::TractDensityImageFilter< FloatImageType >::New();
+        generator->SetFiberBundle(resampled);
+        generator->SetInputImage(density);
+        generator->SetUseImageGeometry(true);
+        generator->SetDoFiberResampling(false);
+        generator->SetOutputAbsoluteValues(true);
+        generator->Update();
+        FloatImageType::Pointer reference = generator->GetOutput();
+
+        double resampledSum = 0;
+        for (std::size_t i=0; i<reference->GetLargestPossibleRegion().GetNumberOfPixels(); ++i)
+            resampledSum += reference->GetBufferPointer()[i];
+        CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Density equals density of resampled fibers", resampledSum, sum, 0.02*sum);
+    }
+
+    void TestStreaming()
+    {
+        std::string filename = mitk::IOUtil::GetTempPath()+"tract_density_test.tck";
+        mitk::TractogramFileWriter::WriteFiberBundle(m_Fibers, filename);
+        {
+            mitk::TractogramFileReader reader(filename);
+
+            FloatImageType::Pointer density = GetDensity(m_Fibers, nullptr);
+            FloatImageType::Pointer streamedDensity = GetDensity(nullptr, &reader);
+            CPPUNIT_ASSERT_MESSAGE("Image size", density->GetLargestPossibleRegion()==streamedDensity->GetLargestPossibleRegion());
+            for (std::size_t i=0; i<density->GetLargestPossibleRegion().GetNumberOfPixels(); ++i)
+                CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Streamed density", density->GetBufferPointer()[i], streamedDensity->GetBufferPointer()[i], 0.0001);
+
+            UIntImageType::Pointer endings = GetEndings(m_Fibers, nullptr);
+            UIntImageType::Pointer streamedEndings = GetEndings(nullptr, &reader);
+            unsigned int numEndings = 0;
+            for (std::size_t i=0; i<endings->GetLargestPossibleRegion().GetNumberOfPixels(); ++i)
+            {
+                CPPUNIT_ASSERT_EQUAL_MESSAGE("Streamed endings", endings->GetBufferPointer()[i], streamedEndings->GetBufferPointer()[i]);
+                numEndings += endings->GetBufferPointer()[i];
+            }
+            CPPUNIT_ASSERT_MESSAGE("Number of endings", numEndings<=2*500 && numEndings>0);
+        }
+        itksys::SystemTools::RemoveFile(filename);
+    }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkTractDensityImageFilter)
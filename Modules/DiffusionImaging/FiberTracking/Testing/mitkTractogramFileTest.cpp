@@ -0,0 +1,128 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include <mitkTractogramFile.h>
+#include <mitkIOUtil.h>
+#include <itksys/SystemTools.hxx>
+#include <random>
+#include <fstream>
+#include <iomanip>
+#include "mitkTestFixture.h"
+
+class mitkTractogramFileTestSuite : public mitk::TestFixture
+{
+
+    CPPUNIT_TEST_SUITE(mitkTractogramFileTestSuite);
+    MITK_TEST(TestTck);
+    MITK_TEST(TestTrk);
+    MITK_TEST(TestEmptyTck);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+
+    /** Members used inside the different (sub-)tests. All members are initialized via setUp().*/
+    mitk::FiberContainer m_Fibers;
+
+    void TestRoundTrip(const std::string& filename, bool lps)
+    {
+        {
+            mitk::TractogramFileWriter writer(filename, nullptr, lps);
+            // written fiber by fiber, as by a tracking filter
+            for (std::size_t i=0; i<m_Fibers.GetNumberOfFibers(); ++i)
+                writer.Write(m_Fibers.GetPoints(i), m_Fibers.GetNumberOfPoints(i));
+            CPPUNIT_ASSERT_EQUAL_MESSAGE("Number of written fibers", m_Fibers.GetNumberOfFibers(), writer.GetNumberOfFibers());
+        }
+
+        mitk::TractogramFileReader reader(filename);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Number of fibers", m_Fibers.GetNumberOfFibers(), reader.GetNumberOfFibers());
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Number of points", m_Fibers.GetNumberOfPoints(), reader.GetNumberOfPoints());
+
+        mitk::FiberBundle::Pointer fib = reader.ReadFiberBundle();
+        const mitk::FiberContainer& fibers = fib->GetFiberContainer();
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Number of fibers in bundle", static_cast<int>(m_Fibers.GetNumberOfFibers()), fib->GetNumFibers());
+        for (std::size_t i=0; i<3*m_Fibers.GetNumberOfPoints(); ++i)
+            CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Points are read in LPS", m_Fibers.GetPoints(0)[i], fibers.GetPoints(0)[i], 0.0001);
+
+        std::size_t numStreamedFibers = 0;
+        reader.StreamFibers([&](const mitk::FiberContainer& chunk, std::size_t firstFiber)
+        {
+            CPPUNIT_ASSERT_EQUAL_MESSAGE("Chunks are consecutive", numStreamedFibers, firstFiber);
+            for (std::size_t i=0; i<chunk.GetNumberOfFibers(); ++i)
+                CPPUNIT_ASSERT_EQUAL_MESSAGE("Streamed fiber", m_Fibers.GetNumberOfPoints(firstFiber+i), chunk.GetNumberOfPoints(i));
+            numStreamedFibers += chunk.GetNumberOfFibers();
+        }, 333);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("All fibers are streamed", m_Fibers.GetNumberOfFibers(), numStreamedFibers);
+
+        itksys::SystemTools::RemoveFile(filename);
+    }
+
+public:
+
+    void setUp() override
+    {
+        std::mt19937 randGen(1);
+        std::uniform_real_distribution<float> position(-60, 60);
+        m_Fibers = mitk::FiberContainer();
+        for (int i=0; i<2000; ++i)
+        {
+            std::vector< float > points(3*(1 + randGen()%50));
+            for (float& p : points)
+                p = position(randGen);
+            m_Fibers.AddFiber(points.data(), points.size()/3);
+        }
+    }
+
+    void tearDown() override
+    {
+        m_Fibers = mitk::FiberContainer();
+    }
+
+    void TestTck()
+    {
+        TestRoundTrip(mitk::IOUtil::GetTempPath()+"tractogram_test.tck", true);
+    }
+
+    void TestTrk()
+    {
+        TestRoundTrip(mitk::IOUtil::GetTempPath()+"tractogram_test.trk", true);
+        TestRoundTrip(mitk::IOUtil::GetTempPath()+"tractogram_test.trk", false);
+    }
+
+    void TestEmptyTck()
+    {
+        // header only, the data offset points to the end of the file
+        std::string filename = mitk::IOUtil::GetTempPath()+"tractogram_test_empty.tck";
+        std::string header = "mrtrix tracks\ndatatype: Float32LE\ncount: 0\nfile: . ";
+        std::string end = "\nEND\n";
+        {
+            std::ofstream file(filename.c_str(), std::ios::binary);
+            file << header << std::setw(10) << std::setfill('0') << header.size()+10+end.size() << end;
+        }
+        {
+            mitk::TractogramFileReader reader(filename);
+            CPPUNIT_ASSERT_EQUAL_MESSAGE("Number of fibers of header without points", static_cast<std::size_t>(0), reader.GetNumberOfFibers());
+            CPPUNIT_ASSERT_EQUAL_MESSAGE("Number of points of header without points", static_cast<std::size_t>(0), reader.GetNumberOfPoints());
+        }
+        itksys::SystemTools::RemoveFile(filename);
+
+        // tractogram written without fibers
+        m_Fibers = mitk::FiberContainer();
+        TestRoundTrip(mitk::IOUtil::GetTempPath()+"tractogram_test_empty.tck", true);
+    }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkTractogramFile)
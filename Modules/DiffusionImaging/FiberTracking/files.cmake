@@ -4,6 +4,9 @@ set(CPP_FILES
 
   ## IO datastructures
   IODataStructures/FiberBundle/mitkFiberBundle.cpp
+  IODataStructures/FiberBundle/mitkFiberSegmentIndex.cpp
+  IODataStructures/FiberBundle/mitkFiberContainer.cpp
+  IODataStructures/FiberBundle/mitkTractogramFile.cpp
   IODataStructures/FiberBundle/mitkTrackvis.cpp
   IODataStructures/PlanarFigureComposite/mitkPlanarFigureComposite.cpp
 
@@ -27,6 +30,9 @@ set(CPP_FILES
 set(H_FILES
   # DataStructures -> FiberBundle
   IODataStructures/FiberBundle/mitkFiberBundle.h
+  IODataStructures/FiberBundle/mitkFiberSegmentIndex.h
+  IODataStructures/FiberBundle/mitkFiberContainer.h
+  IODataStructures/FiberBundle/mitkTractogramFile.h
   IODataStructures/FiberBundle/mitkTrackvis.h
   IODataStructures/mitkFiberfoxParameters.h
 
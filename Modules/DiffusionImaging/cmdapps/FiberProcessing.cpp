@@ -26,11 +26,13 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <mitkBaseData.h>
 #include <mitkFiberBundle.h>
+#include <mitkTractogramFile.h>
 #include "mitkCommandLineParser.h"
 #include <boost/lexical_cast.hpp>
 #include <mitkCoreObjectFactory.h>
 #include <mitkIOUtil.h>
 #include <itkFiberCurvatureFilter.h>
+#include <itksys/SystemTools.hxx>
 
 
 mitk::FiberBundle::Pointer LoadFib(std::string filename)
@@ -56,7 +58,7 @@ int main(int argc, char* argv[])
 
     parser.setArgumentPrefix("--", "-");
     parser.addArgument("input", "i", mitkCommandLineParser::InputFile, "Input:", "input fiber bundle (.fib, .trk, .tck)", us::Any(), false);
-    parser.addArgument("outFile", "o", mitkCommandLineParser::OutputFile, "Output:", "output fiber bundle (.fib, .trk)", us::Any(), false);
+    parser.addArgument("outFile", "o", mitkCommandLineParser::OutputFile, "Output:", "output fiber bundle (.fib, .trk, .tck)", us::Any(), false);
 
     parser.addArgument("smooth", "s", mitkCommandLineParser::Float, "Spline resampling:", "Resample fiber using splines with the given point distance (in mm)");
     parser.addArgument("compress", "c", mitkCommandLineParser::Float, "Compress:", "Compress fiber using the given error threshold (in mm)");
@@ -198,7 +200,11 @@ int main(int argc, char* argv[])
         if (scaleX > 0 || scaleY > 0 || scaleZ > 0)
             fib->ScaleFibers(scaleX, scaleY, scaleZ);
 
-        mitk::IOUtil::SaveBaseData(fib.GetPointer(), outFileName );
+        std::string ext = itksys::SystemTools::LowerCase(itksys::SystemTools::GetFilenameLastExtension(outFileName));
+        if (ext==".tck" || ext==".trk")
+            mitk::TractogramFileWriter::WriteFiberBundle(fib, outFileName);
+        else
+            mitk::IOUtil::SaveBaseData(fib.GetPointer(), outFileName );
 
     }
     catch (itk::ExceptionObject e)
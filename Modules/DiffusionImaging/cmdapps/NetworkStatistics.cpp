@@ -222,33 +222,39 @@ int main(int argc, char* argv[])
       // 1 - Largest density below threshold
       // 2 - Threshold based
 
-      // iterate over possible targets
+      // possible targets
+      std::vector< double > targetValues( granularity, 0.0 );
       for( unsigned int step( 0 ); step < granularity; step++ )
       {
-        double targetValue( 0.0 );
-        bool newStep( true );
-
         switch ( method )
         {
         case mitk::ConnectomicsNetworkThresholder::RandomRemovalOfWeakest :
         case mitk::ConnectomicsNetworkThresholder::LargestLowerThanDensity :
-          targetValue = startDensity * (1 - static_cast<double>( step ) / ( granularity + 0.5 ) );
+          targetValues[ step ] = startDensity * (1 - static_cast<double>( step ) / ( granularity + 0.5 ) );
           break;
         case mitk::ConnectomicsNetworkThresholder::ThresholdBased :
-          targetValue = static_cast<double>( thresholdStepSize * step );
+          targetValues[ step ] = static_cast<double>( thresholdStepSize * step );
           break;
         default:
           MITK_ERROR << "Invalid thresholding method called, aborting.";
           return EXIT_FAILURE;
           break;
         }
+      }
+
+      // the edges are removed once for all targets of the method
+      mitk::ConnectomicsNetworkThresholder::Pointer thresholder = mitk::ConnectomicsNetworkThresholder::New();
+      thresholder->SetNetwork( network );
+      thresholder->SetThresholdingScheme( static_cast<mitk::ConnectomicsNetworkThresholder::ThresholdingSchemes>(method) );
+      std::vector< mitk::ConnectomicsNetwork::Pointer > thresholdedNetworks = thresholder->GetThresholdedNetworks( targetValues );
+
+      // iterate over possible targets
+      for( unsigned int step( 0 ); step < granularity; step++ )
+      {
+        double targetValue( targetValues[ step ] );
+        bool newStep( true );
 
-        mitk::ConnectomicsNetworkThresholder::Pointer thresholder = mitk::ConnectomicsNetworkThresholder::New();
-        thresholder->SetNetwork( network );
-        thresholder->SetTargetThreshold( targetValue );
-        thresholder->SetTargetDensity( targetValue );
-        thresholder->SetThresholdingScheme( static_cast<mitk::ConnectomicsNetworkThresholder::ThresholdingSchemes>(method) );
-        mitk::ConnectomicsNetwork::Pointer thresholdedNetwork = thresholder->GetThresholdedNetwork();
+        mitk::ConnectomicsNetwork::Pointer thresholdedNetwork = thresholdedNetworks[ step ];
 
         mitk::ConnectomicsStatisticsCalculator::Pointer statisticsCalculator = mitk::ConnectomicsStatisticsCalculator::New();
         statisticsCalculator->SetNetwork( thresholdedNetwork );
@@ -30,6 +30,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <omp.h>
 
 #include <mitkFiberBundle.h>
+#include <mitkTractogramFile.h>
 #include <itkStreamlineTrackingFilter.h>
 #include <Algorithms/TrackingHandlers/mitkTrackingDataHandler.h>
 #include <Algorithms/TrackingHandlers/mitkTrackingHandlerRandomForest.h>
@@ -61,7 +62,7 @@ int main(int argc, char* argv[])
     parser.setArgumentPrefix("--", "-");
     parser.addArgument("input", "i", mitkCommandLineParser::StringList, "Input:", "input image (multiple possible for 'Tensor' algorithm)", us::Any(), false);
     parser.addArgument("algorithm", "a", mitkCommandLineParser::String, "Algorithm:", "which algorithm to use (Peaks, Tensor, DetODF, ProbODF, DetRF, ProbRF)", us::Any(), false);
-    parser.addArgument("out", "o", mitkCommandLineParser::OutputDirectory, "Output:", "output fiberbundle", us::Any(), false);
+    parser.addArgument("out", "o", mitkCommandLineParser::OutputDirectory, "Output:", "output fiberbundle (.fib, .trk, .tck)", us::Any(), false);
 
     parser.addArgument("stop_mask", "", mitkCommandLineParser::String, "Stop image:", "streamlines entering the binary mask will stop immediately", us::Any());
     parser.addArgument("tracking_mask", "", mitkCommandLineParser::String, "Mask image:", "restrict tractography with a binary mask image", us::Any());
@@ -396,7 +397,11 @@ int main(int argc, char* argv[])
     if (compress>0)
         outFib->Compress(compress);
 
-    mitk::IOUtil::Save(outFib, outFile);
+    std::string ext = itksys::SystemTools::LowerCase(itksys::SystemTools::GetFilenameLastExtension(outFile));
+    if (ext==".tck" || ext==".trk")
+        mitk::TractogramFileWriter::WriteFiberBundle(outFib, outFile);
+    else
+        mitk::IOUtil::Save(outFib, outFile);
 
     delete handler;
 
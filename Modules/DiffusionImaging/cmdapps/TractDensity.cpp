@@ -19,6 +19,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <fstream>
 #include <algorithm>
 #include <string>
+#include <memory>
 
 #include <itkImageFileWriter.h>
 #include <itkMetaDataObject.h>
@@ -33,6 +34,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkIOUtil.h>
 #include <itkTractDensityImageFilter.h>
 #include <itkTractsToFiberEndingsImageFilter.h>
+#include <mitkTractogramFile.h>
+#include <itksys/SystemTools.hxx>
 
 
 mitk::FiberBundle::Pointer LoadFib(std::string filename)
@@ -57,7 +60,7 @@ int main(int argc, char* argv[])
     parser.setContributor("MBI");
 
     parser.setArgumentPrefix("--", "-");
-    parser.addArgument("input", "i", mitkCommandLineParser::String, "Input:", "input fiber bundle (.fib)", us::Any(), false);
+    parser.addArgument("input", "i", mitkCommandLineParser::String, "Input:", "input fiber bundle (.fib, .tck, .trk)", us::Any(), false);
     parser.addArgument("output", "o", mitkCommandLineParser::String, "Output:", "output image", us::Any(), false);
     parser.addArgument("binary", "", mitkCommandLineParser::Bool, "Binary output:", "calculate binary tract envelope", us::Any());
     parser.addArgument("endpoints", "", mitkCommandLineParser::Bool, "Output endpoints image:", "calculate image of fiber endpoints instead of mask", us::Any());
@@ -85,7 +88,14 @@ int main(int argc, char* argv[])
 
     try
     {
-        mitk::FiberBundle::Pointer fib = LoadFib(inFileName);
+        // .tck and .trk files are streamed, so the tractogram does not need to fit into memory
+        std::unique_ptr< mitk::TractogramFileReader > reader;
+        mitk::FiberBundle::Pointer fib;
+        std::string ext = itksys::SystemTools::LowerCase(itksys::SystemTools::GetFilenameLastExtension(inFileName));
+        if (ext==".tck" || ext==".trk")
+            reader.reset(new mitk::TractogramFileReader(inFileName));
+        else
+            fib = LoadFib(inFileName);
 
         mitk::Image::Pointer ref_img;
         MITK_INFO << reference_image;
@@ -100,6 +110,7 @@ int main(int argc, char* argv[])
             typedef itk::TractsToFiberEndingsImageFilter< OutImageType > ImageGeneratorType;
             ImageGeneratorType::Pointer generator = ImageGeneratorType::New();
             generator->SetFiberBundle(fib);
+            generator->SetTractogramReader(reader.get());
 
             if (ref_img.IsNotNull())
             {
@@ -127,6 +138,7 @@ int main(int argc, char* argv[])
 
             itk::TractDensityImageFilter< OutImageType >::Pointer generator = itk::TractDensityImageFilter< OutImageType >::New();
             generator->SetFiberBundle(fib);
+            generator->SetTractogramReader(reader.get());
             generator->SetBinaryOutput(binary);
             generator->SetOutputAbsoluteValues(false);
             generator->SetWorkOnFiberCopy(false);
@@ -157,6 +169,7 @@ int main(int argc, char* argv[])
 
             itk::TractDensityImageFilter< OutImageType >::Pointer generator = itk::TractDensityImageFilter< OutImageType >::New();
             generator->SetFiberBundle(fib);
+            generator->SetTractogramReader(reader.get());
             generator->SetBinaryOutput(binary);
             generator->SetOutputAbsoluteValues(false);
             generator->SetWorkOnFiberCopy(false);
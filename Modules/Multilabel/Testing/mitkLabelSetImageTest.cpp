@@ -15,6 +15,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include <mitkIOUtil.h>
+#include <mitkImageReadAccessor.h>
 #include <mitkImageStatisticsHolder.h>
 #include <mitkLabelSetImage.h>
 #include <mitkTestFixture.h>
@@ -38,6 +39,8 @@ class mitkLabelSetImageTestSuite : public mitk::TestFixture
   MITK_TEST(TestRemoveLayer);
   MITK_TEST(TestRemoveLabels);
   MITK_TEST(TestMergeLabel);
+  MITK_TEST(TestLayerCompression);
+  MITK_TEST(TestInactiveLayerOperations);
   // TODO check it these functionalities can be moved into a process object
   //  MITK_TEST(TestMergeLabels);
   //  MITK_TEST(TestConcatenate);
@@ -443,6 +446,125 @@ public:
     // Check if merge label has 507 + 823 = 1330 pixels
     CPPUNIT_ASSERT_MESSAGE("Label with value 7 was not remove from the image", m_LabelSetImage->GetStatistics()->GetCountOfMaxValuedVoxels() == 1330);
   }
+
+  void TestLayerCompression()
+  {
+    mitk::Image::Pointer image =
+      mitk::IOUtil::LoadImage(GetTestDataFilePath("Multilabel/LabelSetTestInitializeImage.nrrd"));
+    m_LabelSetImage = mitk::LabelSetImage::New();
+    m_LabelSetImage->InitializeByLabeledImage(image);
+    m_LabelSetImage->AddLayer();
+
+    // the reference performs all operations on its dense active layer
+    mitk::LabelSetImage::Pointer reference = m_LabelSetImage->Clone();
+    reference->SetActiveLayer(0);
+
+    m_LabelSetImage->SetLayerCompression(true);
+    CPPUNIT_ASSERT_MESSAGE("Inactive layer is not compressed", m_LabelSetImage->IsLayerCompressed(0));
+    CPPUNIT_ASSERT_MESSAGE("Active layer is compressed", !m_LabelSetImage->IsLayerCompressed(1));
+    CPPUNIT_ASSERT_MESSAGE("Layer compression does not save memory", m_LabelSetImage->GetSavedLayerMemory() > 0);
+    CPPUNIT_ASSERT_MESSAGE("Compressed layer differs from the dense layer",
+                           mitk::Equal(*m_LabelSetImage->GetLayerImage(0), *reference, mitk::eps, true));
+
+    m_LabelSetImage->MergeLabel(6, 7, 0);
+    reference->MergeLabel(6, 7, 0);
+    m_LabelSetImage->EraseLabel(5, 0);
+    reference->EraseLabel(5, 0);
+    m_LabelSetImage->UpdateCenterOfMass(6, 0);
+    reference->UpdateCenterOfMass(6, 0);
+
+    CPPUNIT_ASSERT_MESSAGE("Label operations on the compressed layer differ from the dense layer",
+                           mitk::Equal(*m_LabelSetImage->GetLayerImage(0), *reference, mitk::eps, true));
+    CPPUNIT_ASSERT_MESSAGE("Center of mass of the compressed layer differs from the dense layer",
+                           mitk::Equal(m_LabelSetImage->GetLabel(6, 0)->GetCenterOfMassIndex(),
+                                       reference->GetLabel(6, 0)->GetCenterOfMassIndex(),
+                                       mitk::eps,
+                                       true));
+
+    // a region of the compressed layer contains the voxels of the same region of the dense layer
+    const unsigned int *dimensions = reference->GetDimensions();
+    mitk::LabelSetImage::LayerRegionType region;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      region.SetIndex(i, dimensions[i] / 4);
+      region.SetSize(i, dimensions[i] / 2 + 1);
+    }
+    mitk::Image::Pointer regionImage = m_LabelSetImage->ExtractLayerRegion(0, region);
+
+    mitk::ImageReadAccessor regionAccessor(regionImage);
+    mitk::ImageReadAccessor referenceAccessor(reference.GetPointer());
+    auto regionBuffer = static_cast<const mitk::Label::PixelType *>(regionAccessor.GetData());
+    auto referenceBuffer = static_cast<const mitk::Label::PixelType *>(referenceAccessor.GetData());
+    unsigned int differences = 0;
+    for (unsigned int z = dimensions[2] / 4; z <= dimensions[2] / 4 + dimensions[2] / 2; ++z)
+    {
+      for (unsigned int y = dimensions[1] / 4; y <= dimensions[1] / 4 + dimensions[1] / 2; ++y)
+      {
+        for (unsigned int x = dimensions[0] / 4; x <= dimensions[0] / 4 + dimensions[0] / 2; ++x)
+        {
+          if (*regionBuffer++ != referenceBuffer[(z * dimensions[1] + y) * dimensions[0] + x])
+            ++differences;
+        }
+      }
+    }
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Region of the compressed layer differs from the dense layer", 0u, differences);
+
+    // activating the compressed layer decodes it into the image
+    m_LabelSetImage->SetActiveLayer(0);
+    CPPUNIT_ASSERT_MESSAGE("Previously active layer is not compressed", m_LabelSetImage->IsLayerCompressed(1));
+    CPPUNIT_ASSERT_MESSAGE(
+      "Activated layer differs from the dense layer",
+      mitk::Equal(*static_cast<mitk::Image *>(m_LabelSetImage), *static_cast<mitk::Image *>(reference), mitk::eps, true));
+
+    m_LabelSetImage->SetLayerCompression(false);
+    CPPUNIT_ASSERT_MESSAGE("Layer is still compressed", !m_LabelSetImage->IsLayerCompressed(1));
+    CPPUNIT_ASSERT_MESSAGE("Memory is saved without layer compression", m_LabelSetImage->GetSavedLayerMemory() == 0);
+  }
+
+  void TestInactiveLayerOperations()
+  {
+    mitk::Image::Pointer image =
+      mitk::IOUtil::LoadImage(GetTestDataFilePath("Multilabel/LabelSetTestInitializeImage.nrrd"));
+
+    for (bool compression : {false, true})
+    {
+      m_LabelSetImage = mitk::LabelSetImage::New();
+      m_LabelSetImage->InitializeByLabeledImage(image);
+      m_LabelSetImage->AddLayer();
+      m_LabelSetImage->SetLayerCompression(compression);
+
+      // the reference performs all operations on its active layer
+      mitk::LabelSetImage::Pointer reference = m_LabelSetImage->Clone();
+      reference->SetActiveLayer(0);
+
+      m_LabelSetImage->MergeLabel(6, 7, 0);
+      reference->MergeLabel(6, 7, 0);
+      std::vector<mitk::Label::PixelType> labels;
+      labels.push_back(3);
+      labels.push_back(5);
+      m_LabelSetImage->MergeLabels(1, labels, 0);
+      reference->MergeLabels(1, labels, 0);
+      m_LabelSetImage->EraseLabel(6, 0);
+      reference->EraseLabel(6, 0);
+      m_LabelSetImage->UpdateCenterOfMass(1, 0);
+      reference->UpdateCenterOfMass(1, 0);
+
+      CPPUNIT_ASSERT_MESSAGE("Active layer is modified by operations on an inactive layer",
+                             m_LabelSetImage->GetActiveLayer() == 1 &&
+                               m_LabelSetImage->GetStatistics()->GetScalarValueMax() == 0);
+      CPPUNIT_ASSERT_MESSAGE("Operations on the inactive layer differ from those on the active layer",
+                             mitk::Equal(*m_LabelSetImage->GetLayerImage(0), *reference, mitk::eps, true));
+      CPPUNIT_ASSERT_MESSAGE("Center of mass of the inactive layer differs from the active layer",
+                             mitk::Equal(m_LabelSetImage->GetLabel(1, 0)->GetCenterOfMassIndex(),
+                                         reference->GetLabel(1, 0)->GetCenterOfMassIndex(),
+                                         mitk::eps,
+                                         true));
+
+      // the active layer itself is returned as layer image
+      CPPUNIT_ASSERT_MESSAGE("Layer image of the active layer is not the image itself",
+                             m_LabelSetImage->GetLayerImage(1) == m_LabelSetImage.GetPointer());
+    }
+  }
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkLabelSetImage)
@@ -0,0 +1,218 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkCompressedLabelLayer.h"
+
+#include <algorithm>
+
+mitk::CompressedLabelLayer::CompressedLabelLayer()
+{
+  std::fill(m_Size, m_Size + 4, 0);
+}
+
+std::size_t mitk::CompressedLabelLayer::GetNumberOfRows() const
+{
+  return static_cast<std::size_t>(m_Size[1]) * m_Size[2] * m_Size[3];
+}
+
+void mitk::CompressedLabelLayer::AppendRun(
+  std::vector<Run> &runs, std::size_t rowBegin, unsigned int begin, unsigned int end, PixelType value)
+{
+  if (value == 0 || begin == end)
+    return;
+
+  if (runs.size() > rowBegin && runs.back().End == begin && runs.back().Value == value)
+  {
+    runs.back().End = end;
+    return;
+  }
+
+  Run run;
+  run.Begin = begin;
+  run.End = end;
+  run.Value = value;
+  runs.push_back(run);
+}
+
+void mitk::CompressedLabelLayer::Encode(const PixelType *buffer, const unsigned int size[4])
+{
+  std::copy(size, size + 4, m_Size);
+  const std::size_t numberOfRows = this->GetNumberOfRows();
+
+  std::vector<Run> runs;
+  std::vector<std::size_t> rowOffsets;
+  rowOffsets.reserve(numberOfRows + 1);
+  rowOffsets.push_back(0);
+
+  for (std::size_t row = 0; row < numberOfRows; ++row)
+  {
+    const PixelType *rowBuffer = buffer + row * m_Size[0];
+    const std::size_t rowBegin = runs.size();
+
+    for (unsigned int x = 0; x < m_Size[0];)
+    {
+      const unsigned int begin = x;
+      const PixelType value = rowBuffer[x];
+      while (x < m_Size[0] && rowBuffer[x] == value)
+        ++x;
+      AppendRun(runs, rowBegin, begin, x, value);
+    }
+    rowOffsets.push_back(runs.size());
+  }
+
+  runs.shrink_to_fit();
+  m_Runs.swap(runs);
+  m_RowOffsets.swap(rowOffsets);
+}
+
+void mitk::CompressedLabelLayer::Decode(PixelType *buffer) const
+{
+  const std::size_t numberOfRows = this->GetNumberOfRows();
+  for (std::size_t row = 0; row < numberOfRows; ++row)
+  {
+    PixelType *rowBuffer = buffer + row * m_Size[0];
+    std::fill(rowBuffer, rowBuffer + m_Size[0], 0);
+    for (std::size_t i = m_RowOffsets[row]; i < m_RowOffsets[row + 1]; ++i)
+      std::fill(rowBuffer + m_Runs[i].Begin, rowBuffer + m_Runs[i].End, m_Runs[i].Value);
+  }
+}
+
+void mitk::CompressedLabelLayer::DecodeRegion(const unsigned int begin[3],
+                                              const unsigned int end[3],
+                                              unsigned int timeStep,
+                                              PixelType *buffer) const
+{
+  const unsigned int width = end[0] - begin[0];
+  for (unsigned int z = begin[2]; z < end[2]; ++z)
+  {
+    for (unsigned int y = begin[1]; y < end[1]; ++y)
+    {
+      const std::size_t row = (static_cast<std::size_t>(timeStep) * m_Size[2] + z) * m_Size[1] + y;
+      std::fill(buffer, buffer + width, 0);
+
+      // skip the runs left of the region
+      auto run = std::upper_bound(m_Runs.begin() + m_RowOffsets[row],
+                                  m_Runs.begin() + m_RowOffsets[row + 1],
+                                  begin[0],
+                                  [](unsigned int x, const Run &r) { return x < r.End; });
+      for (; run != m_Runs.begin() + m_RowOffsets[row + 1] && run->Begin < end[0]; ++run)
+      {
+        const unsigned int runBegin = std::max(run->Begin, begin[0]);
+        const unsigned int runEnd = std::min(run->End, end[0]);
+        std::fill(buffer + (runBegin - begin[0]), buffer + (runEnd - begin[0]), run->Value);
+      }
+      buffer += width;
+    }
+  }
+}
+
+void mitk::CompressedLabelLayer::ReplaceValue(PixelType oldValue, PixelType newValue)
+{
+  if (oldValue == newValue || !this->IsInitialized())
+    return;
+
+  const std::size_t numberOfRows = this->GetNumberOfRows();
+
+  std::vector<Run> runs;
+  runs.reserve(m_Runs.size());
+  std::vector<std::size_t> rowOffsets;
+  rowOffsets.reserve(numberOfRows + 1);
+  rowOffsets.push_back(0);
+
+  const PixelType exteriorValue = oldValue == 0 ? newValue : 0;
+  for (std::size_t row = 0; row < numberOfRows; ++row)
+  {
+    const std::size_t rowBegin = runs.size();
+    unsigned int x = 0;
+    for (std::size_t i = m_RowOffsets[row]; i < m_RowOffsets[row + 1]; ++i)
+    {
+      const Run &run = m_Runs[i];
+      AppendRun(runs, rowBegin, x, run.Begin, exteriorValue);
+      AppendRun(runs, rowBegin, run.Begin, run.End, run.Value == oldValue ? newValue : run.Value);
+      x = run.End;
+    }
+    AppendRun(runs, rowBegin, x, m_Size[0], exteriorValue);
+    rowOffsets.push_back(runs.size());
+  }
+
+  runs.shrink_to_fit();
+  m_Runs.swap(runs);
+  m_RowOffsets.swap(rowOffsets);
+}
+
+std::size_t mitk::CompressedLabelLayer::GetNumberOfVoxels(PixelType value) const
+{
+  if (value == 0)
+  {
+    std::size_t numberOfLabeledVoxels = 0;
+    for (const Run &run : m_Runs)
+      numberOfLabeledVoxels += run.End - run.Begin;
+    return this->GetNumberOfRows() * m_Size[0] - numberOfLabeledVoxels;
+  }
+
+  std::size_t numberOfVoxels = 0;
+  for (const Run &run : m_Runs)
+  {
+    if (run.Value == value)
+      numberOfVoxels += run.End - run.Begin;
+  }
+  return numberOfVoxels;
+}
+
+bool mitk::CompressedLabelLayer::GetVoxelIndex(PixelType value, std::size_t n, unsigned int index[4]) const
+{
+  const std::size_t numberOfRows = this->GetNumberOfRows();
+  for (std::size_t row = 0; row < numberOfRows; ++row)
+  {
+    const std::size_t rowEnd = m_RowOffsets[row + 1];
+    unsigned int x = 0;
+    for (std::size_t i = m_RowOffsets[row]; i <= rowEnd; ++i)
+    {
+      // the exterior label is not stored, it fills the gap in front of each run and the end of the row
+      unsigned int begin = x;
+      unsigned int end = i < rowEnd ? m_Runs[i].Begin : m_Size[0];
+      if (value != 0)
+      {
+        const bool isMatchingRun = i < rowEnd && m_Runs[i].Value == value;
+        begin = isMatchingRun ? m_Runs[i].Begin : 0;
+        end = isMatchingRun ? m_Runs[i].End : 0;
+      }
+      if (i < rowEnd)
+        x = m_Runs[i].End;
+
+      if (n < end - begin)
+      {
+        index[0] = begin + static_cast<unsigned int>(n);
+        index[1] = static_cast<unsigned int>(row % m_Size[1]);
+        index[2] = static_cast<unsigned int>((row / m_Size[1]) % m_Size[2]);
+        index[3] = static_cast<unsigned int>(row / (static_cast<std::size_t>(m_Size[1]) * m_Size[2]));
+        return true;
+      }
+      n -= end - begin;
+    }
+  }
+  return false;
+}
+
+std::size_t mitk::CompressedLabelLayer::GetMemorySize() const
+{
+  return sizeof(*this) + m_Runs.capacity() * sizeof(Run) + m_RowOffsets.capacity() * sizeof(std::size_t);
+}
+
+std::size_t mitk::CompressedLabelLayer::GetDenseMemorySize() const
+{
+  return this->GetNumberOfRows() * m_Size[0] * sizeof(PixelType);
+}
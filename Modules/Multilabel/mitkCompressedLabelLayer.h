@@ -0,0 +1,119 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef __mitkCompressedLabelLayer_H_
+#define __mitkCompressedLabelLayer_H_
+
+#include "MitkMultilabelExports.h"
+#include <mitkLabel.h>
+
+#include <vector>
+
+namespace mitk
+{
+  //##Documentation
+  //## @brief Run-length encoded image data of one layer of a LabelSetImage.
+  //##
+  //## Every row (first dimension) is stored as a sorted list of runs of equal label values. Runs of the
+  //## exterior label (0) are not stored, so the memory needed is proportional to the number of label
+  //## boundaries instead of the number of voxels. The rows of all slices and time steps are stored one
+  //## after another, which is the memory layout of mitk::Image.
+  //##
+  //## Labels can be replaced and erased, and regions can be decoded, without decoding the whole layer.
+  //## @ingroup Data
+  class MITKMULTILABEL_EXPORT CompressedLabelLayer
+  {
+  public:
+    typedef Label::PixelType PixelType;
+
+    /** \brief Voxels [Begin, End) of a row with the same label value. */
+    struct Run
+    {
+      unsigned int Begin;
+      unsigned int End;
+      PixelType Value;
+    };
+
+    CompressedLabelLayer();
+
+    /**
+     * @brief Encodes a buffer of the given size (x, y, z, t), replacing the current content
+     */
+    void Encode(const PixelType *buffer, const unsigned int size[4]);
+
+    /**
+     * @brief Decodes the whole layer into a buffer of the encoded size
+     */
+    void Decode(PixelType *buffer) const;
+
+    /**
+     * @brief Decodes the region [begin, end) of one time step into a buffer of the size of the region
+     */
+    void DecodeRegion(const unsigned int begin[3],
+                      const unsigned int end[3],
+                      unsigned int timeStep,
+                      PixelType *buffer) const;
+
+    /**
+     * @brief Replaces all voxels of a label value. Replacing by 0 erases the label.
+     */
+    void ReplaceValue(PixelType oldValue, PixelType newValue);
+
+    /**
+     * @brief Returns the number of voxels with the given label value
+     */
+    std::size_t GetNumberOfVoxels(PixelType value) const;
+
+    /**
+     * @brief Gets the index (x, y, z, t) of the n-th voxel with the given value in memory order
+     * @return false if there are not more than n voxels with that value
+     */
+    bool GetVoxelIndex(PixelType value, std::size_t n, unsigned int index[4]) const;
+
+    const unsigned int *GetSize() const { return m_Size; }
+
+    /**
+     * @brief Returns true if the layer has been encoded
+     */
+    bool IsInitialized() const { return !m_RowOffsets.empty(); }
+
+    /**
+     * @brief Returns the number of bytes used by the encoded layer
+     */
+    std::size_t GetMemorySize() const;
+
+    /**
+     * @brief Returns the number of bytes the layer would need as a dense image
+     */
+    std::size_t GetDenseMemorySize() const;
+
+  private:
+    std::size_t GetNumberOfRows() const;
+
+    /** Appends a run to the row that is currently built, merging it with the last run if possible. */
+    static void AppendRun(
+      std::vector<Run> &runs, std::size_t rowBegin, unsigned int begin, unsigned int end, PixelType value);
+
+    unsigned int m_Size[4];
+
+    std::vector<Run> m_Runs;
+
+    /** The runs of row r are m_Runs[m_RowOffsets[r]] to m_Runs[m_RowOffsets[r + 1] - 1]. */
+    std::vector<std::size_t> m_RowOffsets;
+  };
+}
+
+#endif
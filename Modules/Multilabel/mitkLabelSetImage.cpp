@@ -16,9 +16,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkLabelSetImage.h"
 
+#include "mitkGeometry3D.h"
 #include "mitkImageAccessByItk.h"
 #include "mitkImageCast.h"
 #include "mitkImageReadAccessor.h"
+#include "mitkImageWriteAccessor.h"
 #include "mitkInteractionConst.h"
 #include "mitkLookupTableProperty.h"
 #include "mitkPadImageFilter.h"
@@ -41,8 +43,24 @@ void SetToZero(itk::Image<TPixel, VDimensions> *source)
   source->FillBuffer(0);
 }
 
+namespace
+{
+  void GetLayerSize(const mitk::Image *image, unsigned int size[4])
+  {
+    for (unsigned int i = 0; i < 4; ++i)
+      size[i] = i < image->GetDimension() ? image->GetDimension(i) : 1;
+  }
+
+  std::size_t GetDenseLayerMemorySize(const mitk::Image *image)
+  {
+    unsigned int size[4];
+    GetLayerSize(image, size);
+    return static_cast<std::size_t>(size[0]) * size[1] * size[2] * size[3] * sizeof(mitk::LabelSetImage::PixelType);
+  }
+}
+
 mitk::LabelSetImage::LabelSetImage()
-  : mitk::Image(), m_ActiveLayer(0), m_activeLayerInvalid(false), m_ExteriorLabel(nullptr)
+  : mitk::Image(), m_LayerCompression(false), m_ActiveLayer(0), m_activeLayerInvalid(false), m_ExteriorLabel(nullptr)
 {
   // Iniitlaize Background Label
   mitk::Color color;
@@ -57,6 +75,8 @@ mitk::LabelSetImage::LabelSetImage()
 
 mitk::LabelSetImage::LabelSetImage(const mitk::LabelSetImage &other)
   : Image(other),
+    m_CompressedLayerContainer(other.m_CompressedLayerContainer),
+    m_LayerCompression(other.GetLayerCompression()),
     m_ActiveLayer(other.GetActiveLayer()),
     m_activeLayerInvalid(false),
     m_ExteriorLabel(other.GetExteriorLabel()->Clone())
@@ -71,8 +91,10 @@ mitk::LabelSetImage::LabelSetImage(const mitk::LabelSetImage &other)
     lsClone->AddObserver(itk::ModifiedEvent(), command);
     m_LabelSetContainer.push_back(lsClone);
 
-    // clone layer Image data
-    mitk::Image::Pointer liClone = other.GetLayerImage(i)->Clone();
+    // clone layer Image data, compressed layers have already been copied
+    mitk::Image::Pointer liClone;
+    if (other.m_LayerContainer[i].IsNotNull())
+      liClone = other.m_LayerContainer[i]->Clone();
     m_LayerContainer.push_back(liClone);
   }
 }
@@ -134,12 +156,173 @@ mitk::LabelSetImage::~LabelSetImage()
 
 mitk::Image *mitk::LabelSetImage::GetLayerImage(unsigned int layer)
 {
-  return m_LayerContainer[layer];
+  return const_cast<mitk::Image *>(static_cast<const Self *>(this)->GetLayerImage(layer));
 }
 
 const mitk::Image *mitk::LabelSetImage::GetLayerImage(unsigned int layer) const
 {
-  return m_LayerContainer[layer];
+  // the container only holds a copy of the active layer, which is refreshed when the active layer changes
+  if (layer == this->GetActiveLayer())
+    return this;
+
+  if (m_LayerContainer[layer].IsNotNull())
+    return m_LayerContainer[layer];
+
+  m_DecompressedLayerCache.resize(m_LayerContainer.size());
+  if (m_DecompressedLayerCache[layer].IsNull())
+    m_DecompressedLayerCache[layer] = this->DecompressLayer(layer);
+  return m_DecompressedLayerCache[layer];
+}
+
+mitk::Image::Pointer mitk::LabelSetImage::ExtractLayerRegion(unsigned int layer,
+                                                             const LayerRegionType &region,
+                                                             unsigned int timeStep) const
+{
+  unsigned int begin[3];
+  unsigned int end[3];
+  mitk::Point3D beginIndex;
+  mitk::BaseGeometry::BoundsArrayType bounds;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    begin[i] = static_cast<unsigned int>(region.GetIndex(i));
+    end[i] = begin[i] + static_cast<unsigned int>(region.GetSize(i));
+    beginIndex[i] = begin[i];
+    bounds[2 * i] = 0.0;
+    bounds[2 * i + 1] = region.GetSize(i);
+  }
+
+  // the region image has the orientation and spacing of the layer, its origin is the first voxel of the region
+  const mitk::BaseGeometry *layerGeometry = this->GetGeometry(timeStep);
+  mitk::Point3D origin;
+  layerGeometry->IndexToWorld(beginIndex, origin);
+
+  mitk::AffineTransform3D::Pointer transform = mitk::AffineTransform3D::New();
+  transform->SetMatrix(layerGeometry->GetIndexToWorldTransform()->GetMatrix());
+  transform->SetOffset(origin.GetVectorFromOrigin());
+
+  mitk::Geometry3D::Pointer geometry = mitk::Geometry3D::New();
+  geometry->SetIndexToWorldTransform(transform);
+  geometry->SetBounds(bounds);
+  geometry->ImageGeometryOn();
+
+  mitk::Image::Pointer regionImage = mitk::Image::New();
+  regionImage->Initialize(this->GetPixelType(), *geometry);
+
+  mitk::ImageWriteAccessor regionAccessor(regionImage);
+  auto *buffer = static_cast<PixelType *>(regionAccessor.GetData());
+
+  if (this->IsLayerCompressed(layer))
+  {
+    m_CompressedLayerContainer[layer].DecodeRegion(begin, end, timeStep, buffer);
+  }
+  else
+  {
+    const mitk::Image *layerImage = layer == this->GetActiveLayer() ? this : m_LayerContainer[layer].GetPointer();
+    unsigned int size[4];
+    GetLayerSize(layerImage, size);
+
+    mitk::ImageReadAccessor layerAccessor(layerImage);
+    const auto *layerBuffer = static_cast<const PixelType *>(layerAccessor.GetData());
+    const unsigned int width = end[0] - begin[0];
+    for (unsigned int z = begin[2]; z < end[2]; ++z)
+    {
+      for (unsigned int y = begin[1]; y < end[1]; ++y)
+      {
+        const std::size_t row = (static_cast<std::size_t>(timeStep) * size[2] + z) * size[1] + y;
+        std::copy(layerBuffer + row * size[0] + begin[0], layerBuffer + row * size[0] + end[0], buffer);
+        buffer += width;
+      }
+    }
+  }
+
+  return regionImage;
+}
+
+void mitk::LabelSetImage::SetLayerCompression(bool compression)
+{
+  if (compression == m_LayerCompression)
+    return;
+
+  m_LayerCompression = compression;
+  for (unsigned int layer = 0; layer < m_LayerContainer.size(); ++layer)
+  {
+    if (compression)
+    {
+      // the compressed copy of the active layer is refreshed whenever the active layer changes
+      this->CompressLayer(layer == this->GetActiveLayer() ? this : m_LayerContainer[layer].GetPointer(), layer);
+    }
+    else
+    {
+      m_LayerContainer[layer] = this->DecompressLayer(layer);
+      m_CompressedLayerContainer[layer] = CompressedLabelLayer();
+    }
+  }
+  m_DecompressedLayerCache.clear();
+}
+
+bool mitk::LabelSetImage::GetLayerCompression() const
+{
+  return m_LayerCompression;
+}
+
+bool mitk::LabelSetImage::IsLayerCompressed(unsigned int layer) const
+{
+  return layer < m_LayerContainer.size() && layer != this->GetActiveLayer() && m_LayerContainer[layer].IsNull();
+}
+
+std::size_t mitk::LabelSetImage::GetLayerMemorySize(unsigned int layer) const
+{
+  if (m_LayerContainer[layer].IsNotNull())
+    return GetDenseLayerMemorySize(m_LayerContainer[layer]);
+
+  return m_CompressedLayerContainer[layer].GetMemorySize();
+}
+
+std::size_t mitk::LabelSetImage::GetSavedLayerMemory() const
+{
+  const std::size_t denseMemorySize = m_LayerContainer.size() * GetDenseLayerMemorySize(this);
+
+  std::size_t memorySize = 0;
+  for (unsigned int layer = 0; layer < m_LayerContainer.size(); ++layer)
+    memorySize += this->GetLayerMemorySize(layer);
+
+  return denseMemorySize > memorySize ? denseMemorySize - memorySize : 0;
+}
+
+void mitk::LabelSetImage::CompressLayer(const mitk::Image *image, unsigned int layer)
+{
+  unsigned int size[4];
+  GetLayerSize(image, size);
+  {
+    mitk::ImageReadAccessor accessor(image);
+    m_CompressedLayerContainer[layer].Encode(static_cast<const PixelType *>(accessor.GetData()), size);
+  }
+  m_LayerContainer[layer] = nullptr;
+
+  if (layer < m_DecompressedLayerCache.size())
+    m_DecompressedLayerCache[layer] = nullptr;
+}
+
+mitk::Image::Pointer mitk::LabelSetImage::DecompressLayer(unsigned int layer) const
+{
+  mitk::Image::Pointer layerImage = mitk::Image::New();
+  layerImage->Initialize(this->GetPixelType(),
+                         this->GetDimension(),
+                         this->GetDimensions(),
+                         this->GetImageDescriptor()->GetNumberOfChannels());
+  layerImage->SetTimeGeometry(this->GetTimeGeometry()->Clone());
+
+  mitk::ImageWriteAccessor accessor(layerImage);
+  m_CompressedLayerContainer[layer].Decode(static_cast<PixelType *>(accessor.GetData()));
+  return layerImage;
+}
+
+void mitk::LabelSetImage::ReplaceCompressedLayerValue(unsigned int layer, PixelType oldValue, PixelType newValue)
+{
+  m_CompressedLayerContainer[layer].ReplaceValue(oldValue, newValue);
+
+  if (layer < m_DecompressedLayerCache.size())
+    m_DecompressedLayerCache[layer] = nullptr;
 }
 
 unsigned int mitk::LabelSetImage::GetActiveLayer() const
@@ -172,6 +355,8 @@ void mitk::LabelSetImage::RemoveLayer()
   // remove labelset and image data
   m_LabelSetContainer.erase(m_LabelSetContainer.begin() + layerToDelete);
   m_LayerContainer.erase(m_LayerContainer.begin() + layerToDelete);
+  m_CompressedLayerContainer.erase(m_CompressedLayerContainer.begin() + layerToDelete);
+  m_DecompressedLayerCache.clear();
 
   if (layerToDelete == 0)
   {
@@ -225,8 +410,9 @@ unsigned int mitk::LabelSetImage::AddLayer(mitk::Image::Pointer layerImage, mitk
   // Add exterior Label to label set
   // mitk::Label::Pointer exteriorLabel = CreateExteriorLabel();
 
-  // push a new working image for the new layer
+  // push a new working image for the new layer, it is compressed when the layer becomes inactive
   m_LayerContainer.push_back(layerImage);
+  m_CompressedLayerContainer.push_back(CompressedLabelLayer());
 
   // push a new labelset for the new layer
   m_LabelSetContainer.push_back(ls);
@@ -271,47 +457,53 @@ void mitk::LabelSetImage::SetActiveLayer(unsigned int layer)
 {
   try
   {
-    if (4 == this->GetDimension())
+    if ((layer != GetActiveLayer() || m_activeLayerInvalid) && (layer < this->GetNumberOfLayers()))
     {
-      if ((layer != GetActiveLayer() || m_activeLayerInvalid) && (layer < this->GetNumberOfLayers()))
+      BeforeChangeLayerEvent.Send();
+
+      if (m_activeLayerInvalid)
+      {
+        // We should not write the invalid layer back to the vector
+        m_activeLayerInvalid = false;
+      }
+      else if (m_LayerCompression)
+      {
+        this->CompressLayer(this, GetActiveLayer());
+      }
+      else if (4 == this->GetDimension())
+      {
+        AccessFixedDimensionByItk_n(this, ImageToLayerContainerProcessing, 4, (GetActiveLayer()));
+      }
+      else
       {
-        BeforeChangeLayerEvent.Send();
+        AccessByItk_1(this, ImageToLayerContainerProcessing, GetActiveLayer());
+      }
 
-        if (m_activeLayerInvalid)
-        {
-          // We should not write the invalid layer back to the vector
-          m_activeLayerInvalid = false;
-        }
-        else
-        {
-          AccessFixedDimensionByItk_n(this, ImageToLayerContainerProcessing, 4, (GetActiveLayer()));
-        }
-        m_ActiveLayer = layer; // only at this place m_ActiveLayer should be manipulated!!! Use Getter and Setter
-        AccessFixedDimensionByItk_n(this, LayerContainerToImageProcessing, 4, (GetActiveLayer()));
+      m_ActiveLayer = layer; // only at this place m_ActiveLayer should be manipulated!!! Use Getter and Setter
 
-        AfterChangeLayerEvent.Send();
+      if (m_LayerContainer[layer].IsNull())
+      {
+        mitk::ImageWriteAccessor accessor(this);
+        m_CompressedLayerContainer[layer].Decode(static_cast<PixelType *>(accessor.GetData()));
       }
-    }
-    else
-    {
-      if ((layer != GetActiveLayer() || m_activeLayerInvalid) && (layer < this->GetNumberOfLayers()))
+      else
       {
-        BeforeChangeLayerEvent.Send();
-
-        if (m_activeLayerInvalid)
+        if (4 == this->GetDimension())
         {
-          // We should not write the invalid layer back to the vector
-          m_activeLayerInvalid = false;
+          AccessFixedDimensionByItk_n(this, LayerContainerToImageProcessing, 4, (GetActiveLayer()));
         }
         else
         {
-          AccessByItk_1(this, ImageToLayerContainerProcessing, GetActiveLayer());
+          AccessByItk_1(this, LayerContainerToImageProcessing, GetActiveLayer());
         }
-        m_ActiveLayer = layer; // only at this place m_ActiveLayer should be manipulated!!! Use Getter and Setter
-        AccessByItk_1(this, LayerContainerToImageProcessing, GetActiveLayer());
 
-        AfterChangeLayerEvent.Send();
+        // new layers are passed as dense images
+        if (m_LayerCompression)
+          this->CompressLayer(m_LayerContainer[layer], layer);
       }
+      m_DecompressedLayerCache.clear();
+
+      AfterChangeLayerEvent.Send();
     }
   }
   catch (itk::ExceptionObject &e)
@@ -390,7 +582,14 @@ void mitk::LabelSetImage::MergeLabel(PixelType pixelValue, PixelType sourcePixel
 {
   try
   {
-    AccessByItk_2(this, MergeLabelProcessing, pixelValue, sourcePixelValue);
+    if (this->IsLayerCompressed(layer))
+    {
+      this->ReplaceCompressedLayerValue(layer, sourcePixelValue, pixelValue);
+    }
+    else
+    {
+      AccessByItk_2(this->GetLayerImage(layer), MergeLabelProcessing, pixelValue, sourcePixelValue);
+    }
   }
   catch (itk::ExceptionObject &e)
   {
@@ -406,7 +605,14 @@ void mitk::LabelSetImage::MergeLabels(PixelType pixelValue, std::vector<PixelTyp
   {
     for (unsigned int idx = 0; idx < vectorOfSourcePixelValues.size(); idx++)
     {
-      AccessByItk_2(this, MergeLabelProcessing, pixelValue, vectorOfSourcePixelValues[idx]);
+      if (this->IsLayerCompressed(layer))
+      {
+        this->ReplaceCompressedLayerValue(layer, vectorOfSourcePixelValues[idx], pixelValue);
+      }
+      else
+      {
+        AccessByItk_2(this->GetLayerImage(layer), MergeLabelProcessing, pixelValue, vectorOfSourcePixelValues[idx]);
+      }
     }
   }
   catch (itk::ExceptionObject &e)
@@ -438,7 +644,14 @@ void mitk::LabelSetImage::EraseLabel(PixelType pixelValue, unsigned int layer)
 {
   try
   {
-    AccessByItk_2(this, EraseLabelProcessing, pixelValue, layer);
+    if (this->IsLayerCompressed(layer))
+    {
+      this->ReplaceCompressedLayerValue(layer, pixelValue, 0);
+    }
+    else
+    {
+      AccessByItk_2(this->GetLayerImage(layer), EraseLabelProcessing, pixelValue, layer);
+    }
   }
   catch (itk::ExceptionObject &e)
   {
@@ -489,7 +702,32 @@ mitk::LabelSet *mitk::LabelSetImage::GetActiveLabelSet()
 
 void mitk::LabelSetImage::UpdateCenterOfMass(PixelType pixelValue, unsigned int layer)
 {
-  AccessByItk_2(this, CalculateCenterOfMassProcessing, pixelValue, layer);
+  if (!this->IsLayerCompressed(layer))
+  {
+    AccessByItk_2(this->GetLayerImage(layer), CalculateCenterOfMassProcessing, pixelValue, layer);
+    return;
+  }
+
+  // for now, we just retrieve the voxel in the middle, like CalculateCenterOfMassProcessing()
+  const CompressedLabelLayer &compressedLayer = m_CompressedLayerContainer[layer];
+  unsigned int centerIndex[4];
+
+  mitk::Point3D pos;
+  pos.Fill(0.0);
+
+  if (compressedLayer.GetVoxelIndex(pixelValue, compressedLayer.GetNumberOfVoxels(pixelValue) / 2, centerIndex))
+  {
+    if (3 != this->GetDimension())
+      return;
+
+    pos[0] = centerIndex[0];
+    pos[1] = centerIndex[1];
+    pos[2] = centerIndex[2];
+  }
+
+  GetLabelSet(layer)->GetLabel(pixelValue)->SetCenterOfMassIndex(pos);
+  this->GetSlicedGeometry()->IndexToWorld(pos, pos); // TODO: TimeGeometry?
+  GetLabelSet(layer)->GetLabel(pixelValue)->SetCenterOfMassCoordinates(pos);
 }
 
 unsigned int mitk::LabelSetImage::GetNumberOfLabels(unsigned int layer) const
@@ -17,11 +17,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 #ifndef __mitkLabelSetImage_H_
 #define __mitkLabelSetImage_H_
 
+#include <mitkCompressedLabelLayer.h>
 #include <mitkImage.h>
 #include <mitkLabelSet.h>
 
 #include <MitkMultilabelExports.h>
 
+#include <itkImageRegion.h>
+
 namespace mitk
 {
   //##Documentation
@@ -245,11 +248,49 @@ namespace mitk
     void RemoveLayer();
 
     /**
-      * \brief  */
+     * @brief Returns the image data of a layer.
+     *        For the active layer, this is the LabelSetImage itself. If layer compression is enabled, other
+     *        layers are decoded on demand and the returned image is valid until the active layer changes.
+     */
     mitk::Image *GetLayerImage(unsigned int layer);
 
     const mitk::Image *GetLayerImage(unsigned int layer) const;
 
+    typedef itk::ImageRegion<3> LayerRegionType;
+
+    /**
+     * @brief Creates an image of a region of one time step of a layer.
+     *        Only the requested region of a compressed layer is decoded. The geometry of the returned image is
+     *        placed at the position of the region.
+     */
+    mitk::Image::Pointer ExtractLayerRegion(unsigned int layer,
+                                            const LayerRegionType &region,
+                                            unsigned int timeStep = 0) const;
+
+    /**
+     * @brief Enables the run-length encoded storage of the layers.
+     *        The active layer is always stored in the LabelSetImage itself, all other layers are compressed
+     *        when this option is enabled. Label operations on inactive layers are applied to the compressed data.
+     */
+    void SetLayerCompression(bool compression);
+
+    bool GetLayerCompression() const;
+
+    /**
+     * @brief Returns true if the layer is an inactive layer that is stored compressed
+     */
+    bool IsLayerCompressed(unsigned int layer) const;
+
+    /**
+     * @brief Returns the number of bytes used for storing the data of a layer besides the LabelSetImage itself
+     */
+    std::size_t GetLayerMemorySize(unsigned int layer) const;
+
+    /**
+     * @brief Returns the number of bytes saved by the layer compression compared to dense layer images
+     */
+    std::size_t GetSavedLayerMemory() const;
+
     void OnLabelSetModified();
 
     /**
@@ -309,9 +350,24 @@ namespace mitk
     template <typename LabelSetImageType, typename ImageType>
     void InitializeByLabeledImageProcessing(LabelSetImageType *input, ImageType *other);
 
+    void CompressLayer(const mitk::Image *image, unsigned int layer);
+
+    mitk::Image::Pointer DecompressLayer(unsigned int layer) const;
+
+    void ReplaceCompressedLayerValue(unsigned int layer, PixelType oldValue, PixelType newValue);
+
     std::vector<LabelSet::Pointer> m_LabelSetContainer;
+
+    /** Dense layer images, nullptr for compressed layers. */
     std::vector<Image::Pointer> m_LayerContainer;
 
+    std::vector<CompressedLabelLayer> m_CompressedLayerContainer;
+
+    /** Compressed layers decoded by GetLayerImage(). */
+    mutable std::vector<Image::Pointer> m_DecompressedLayerCache;
+
+    bool m_LayerCompression;
+
     int m_ActiveLayer;
 
     bool m_activeLayerInvalid;
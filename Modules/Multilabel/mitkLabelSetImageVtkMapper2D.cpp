@@ -56,6 +56,50 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkRGBAPixel.h>
 #include <mitkRenderingModeProperty.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+  /** Returns the voxels of the image that are needed to reslice it along the plane with nearest interpolation. */
+  mitk::LabelSetImage::LayerRegionType GetRegionTouchedByPlane(const mitk::PlaneGeometry *plane,
+                                                               const mitk::Image *image,
+                                                               unsigned int timeStep)
+  {
+    const mitk::BaseGeometry *imageGeometry = image->GetGeometry(timeStep);
+
+    double lower[3] = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+                       std::numeric_limits<double>::max()};
+    double upper[3] = {std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(),
+                       std::numeric_limits<double>::lowest()};
+
+    // corners 0, 2, 4 and 6 span the plane itself
+    for (int id = 0; id < 8; id += 2)
+    {
+      mitk::Point3D index;
+      imageGeometry->WorldToIndex(plane->GetCornerPoint(id), index);
+      for (unsigned int i = 0; i < 3; ++i)
+      {
+        lower[i] = std::min(lower[i], index[i]);
+        upper[i] = std::max(upper[i], index[i]);
+      }
+    }
+
+    mitk::LabelSetImage::LayerRegionType region;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      // one additional voxel on each side covers the rounding of the nearest neighbor interpolation
+      const double maximum = image->GetDimension(i) - 1.0;
+      const double begin = std::max(0.0, std::min(maximum, std::floor(lower[i]) - 1.0));
+      const double end = std::max(0.0, std::min(maximum, std::ceil(upper[i]) + 1.0));
+      region.SetIndex(i, static_cast<itk::IndexValueType>(begin));
+      region.SetSize(i, static_cast<itk::SizeValueType>(end - begin) + 1);
+    }
+    return region;
+  }
+}
+
 mitk::LabelSetImageVtkMapper2D::LabelSetImageVtkMapper2D()
 {
 }
@@ -149,21 +193,32 @@ void mitk::LabelSetImageVtkMapper2D::GenerateDataForRenderer(mitk::BaseRenderer
 
   for (int lidx = 0; lidx < numberOfLayers; ++lidx)
   {
-    mitk::Image *layerImage = nullptr;
+    mitk::Image::Pointer layerImage;
+    int timeStep = this->GetTimestep();
 
     // set main input for ExtractSliceFilter
     if (lidx == activeLayer)
+    {
       layerImage = image;
+    }
+    else if (image->IsLayerCompressed(lidx))
+    {
+      // only decode the part of a compressed layer that is touched by the plane
+      layerImage = image->ExtractLayerRegion(lidx, GetRegionTouchedByPlane(worldGeometry, image, timeStep), timeStep);
+      timeStep = 0;
+    }
     else
+    {
       layerImage = image->GetLayerImage(lidx);
+    }
 
     localStorage->m_ReslicerVector[lidx]->SetInput(layerImage);
     localStorage->m_ReslicerVector[lidx]->SetWorldGeometry(worldGeometry);
-    localStorage->m_ReslicerVector[lidx]->SetTimeStep(this->GetTimestep());
+    localStorage->m_ReslicerVector[lidx]->SetTimeStep(timeStep);
 
     // set the transformation of the image to adapt reslice axis
     localStorage->m_ReslicerVector[lidx]->SetResliceTransformByGeometry(
-      layerImage->GetTimeGeometry()->GetGeometryForTimeStep(this->GetTimestep()));
+      layerImage->GetTimeGeometry()->GetGeometryForTimeStep(timeStep));
 
     // is the geometry of the slice based on the image image or the worldgeometry?
     bool inPlaneResampleExtentByGeometry = false;
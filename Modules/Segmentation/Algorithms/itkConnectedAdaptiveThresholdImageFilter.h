@@ -100,6 +100,12 @@ namespace itk
 
     void GenerateData();
 
+    /* Raw segmentation mode computed level by level with the multi-threaded itk::ScanlineFloodFill engine. Yields the
+    * same labels and leakage point as the itkAdaptiveThresholdIterator: at level n, all voxels are filled that are
+    * connected to the already segmented region and lie within n gray values of the seed in growing direction.
+    */
+    void GenerateRawSegmentation(TOutputImage *outputImage);
+
     TOutputImage *m_IteratorMaskForFineSegmentation;
 
   private:
@@ -21,8 +21,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkBinaryThresholdImageFunction.h"
 #include "itkConnectedAdaptiveThresholdImageFilter.h"
 #include "itkMinimumMaximumImageFilter.h"
+#include "itkScanlineFloodFill.h"
 #include "itkThresholdImageFilter.h"
 
+#include <algorithm>
+
 namespace itk
 {
   /**
@@ -49,8 +52,6 @@ namespace itk
     typedef BinaryThresholdImageFunction<InputImageType> FunctionType;
     typedef AdaptiveThresholdIterator<OutputImageType, FunctionType> IteratorType;
 
-    int initValue = IteratorType::CalculateInitializeValue((int)(this->GetLower()), (int)(this->GetUpper()));
-
     // Initialize the output according to the segmentation (fine or raw)
     if (m_FineDetectionMode)
     {
@@ -61,8 +62,9 @@ namespace itk
     outputImage->SetBufferedRegion(region);
     outputImage->Allocate();
     if (!m_FineDetectionMode)
-    { // only initalize the output image if we are using the raw segmentation mode
-      outputImage->FillBuffer((typename ConnectedAdaptiveThresholdImageFilter::OutputImagePixelType)initValue);
+    { // the raw segmentation does not depend on a previous result and is computed by the flood fill engine
+      this->GenerateRawSegmentation(outputImage);
+      return;
     }
 
     typename FunctionType::Pointer function = FunctionType::New();
@@ -98,6 +100,113 @@ namespace itk
     this->m_SegmentationCancelled = false;
   }
 
+  template <class TInputImage, class TOutputImage>
+  void ConnectedAdaptiveThresholdImageFilter<TInputImage, TOutputImage>::GenerateRawSegmentation(
+    TOutputImage *outputImage)
+  {
+    typedef typename ConnectedAdaptiveThresholdImageFilter::OutputImagePixelType OutputPixelType;
+
+    typename ConnectedAdaptiveThresholdImageFilter::InputImageConstPointer inputImage = this->GetInput();
+    const typename TInputImage::RegionType region = inputImage->GetBufferedRegion();
+
+    outputImage->FillBuffer(0);
+    this->m_DetectedLeakagePoint = 0;
+
+    const typename Superclass::SeedContainerType &seeds = this->GetSeeds();
+    if (seeds.empty() || !region.IsInside(seeds[0]))
+    {
+      this->m_SegmentationCancelled = true;
+      return;
+    }
+
+    const IndexType seedIndex = seeds[0];
+    const int minTH = (int)(this->GetLower());
+    const int maxTH = (int)(this->GetUpper());
+    const int seedValue = (int)inputImage->GetPixel(seedIndex);
+    this->m_SeedpointValue = seedValue;
+
+    if ((this->GetLower()) > this->m_SeedpointValue || this->m_SeedpointValue > (this->GetUpper()))
+    {
+      this->m_SegmentationCancelled = true;
+      return;
+    }
+    this->m_SegmentationCancelled = false;
+
+    // as in the iterator, a seed lying exactly on one of the thresholds does not grow at all
+    if (seedValue <= minTH || seedValue >= maxTH)
+      return;
+
+    const bool upwards = m_GrowingDirectionIsUpwards;
+    const int maxLevel = upwards ? (maxTH - seedValue) : (seedValue - minTH);
+    const int initValue = maxLevel + 1;
+    mitk::ProgressBar::GetInstance()->AddStepsToDo(maxLevel);
+
+    typedef ScanlineFloodFill<TInputImage::ImageDimension> FloodFillType;
+    FloodFillType floodFill(region.GetSize());
+    floodFill.SetNumberOfThreads(this->GetNumberOfThreads());
+
+    // voxels that were reached, but need a wider threshold interval, sorted per thread by the level including them
+    const ThreadIdType numberOfThreads = std::max<ThreadIdType>(floodFill.GetNumberOfThreads(), 1);
+    std::vector<std::vector<std::vector<OffsetValueType>>> pendingVoxels(
+      numberOfThreads, std::vector<std::vector<OffsetValueType>>(maxLevel + 1));
+
+    const PixelType *inputBuffer = inputImage->GetBufferPointer();
+    OutputPixelType *outputBuffer = outputImage->GetBufferPointer();
+    const PixelType minPixel = PixelType(minTH);
+    const PixelType maxPixel = PixelType(maxTH);
+    int level = 1;
+
+    auto distance = [upwards, seedValue](PixelType value) {
+      return upwards ? (int)(value - seedValue) : (int)(seedValue - value);
+    };
+    auto inclusion = [&](OffsetValueType offset) {
+      const PixelType value = inputBuffer[offset];
+      return !(value > maxPixel || value < minPixel) && distance(value) <= level;
+    };
+    auto rejection = [&](OffsetValueType offset, ThreadIdType threadId) {
+      const PixelType value = inputBuffer[offset];
+      if (value > maxPixel || value < minPixel)
+        return;
+      const int voxelLevel = distance(value);
+      if (voxelLevel > level && voxelLevel <= maxLevel)
+        pendingVoxels[threadId][voxelLevel].push_back(offset);
+    };
+    auto span = [&](OffsetValueType first, OffsetValueType last, ThreadIdType) {
+      std::fill(outputBuffer + first, outputBuffer + last + 1, (OutputPixelType)(initValue - level));
+    };
+
+    int lastVoxelNumber = 0;
+    int currentLeakageRatio = 0;
+    std::vector<OffsetValueType> levelSeeds(1, inputImage->ComputeOffset(seedIndex));
+
+    for (level = 1; level <= maxLevel; ++level)
+    {
+      if (level > 1)
+      {
+        levelSeeds.clear();
+        for (auto &threadPendingVoxels : pendingVoxels)
+        {
+          levelSeeds.insert(levelSeeds.end(), threadPendingVoxels[level].begin(), threadPendingVoxels[level].end());
+          std::vector<OffsetValueType>().swap(threadPendingVoxels[level]);
+        }
+      }
+
+      const int voxelCounter = (int)floodFill.Fill(levelSeeds, inclusion, rejection, span);
+
+      // make the progressbar go one step further
+      mitk::ProgressBar::GetInstance()->Progress();
+
+      // leakage-detection: the level with the largest increase of segmented voxels
+      const int diff = voxelCounter - lastVoxelNumber;
+      if (diff > currentLeakageRatio)
+      {
+        currentLeakageRatio = diff;
+        this->m_DetectedLeakagePoint = level;
+      }
+      lastVoxelNumber = voxelCounter;
+    }
+  }
+
   template <class TInputImage, class TOutputImage>
   TOutputImage *itk::ConnectedAdaptiveThresholdImageFilter<TInputImage, TOutputImage>::GetResultImage()
   {
@@ -0,0 +1,129 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef __itkIncrementalFastMarching_h
+#define __itkIncrementalFastMarching_h
+
+#include "itkImage.h"
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace itk
+{
+  /** \class IncrementalFastMarching
+  * \brief Fast marching solver that keeps its arrival-time map between updates.
+  *
+  * Solves the same discrete Eikonal equation as FastMarchingImageFilter (first order upwind scheme on the speed
+  * image), but the state of the march is retained:
+  * - March() only proceeds up to the given limit and can be resumed later with a larger limit,
+  * - AddSeed() lowers the arrival times around a new seed without recomputing the rest of the map; only the voxels
+  *   that are reached earlier from the new seed are propagated.
+  *
+  * All arrival times less than or equal to GetMarchedLimit() are final. Voxels that were not reached contain
+  * GetLargeValue(). Seeds cannot be removed; call Reset() and add the remaining seeds again instead.
+  *
+  * \ingroup RegionGrowingSegmentation
+  */
+  template <class TImage>
+  class IncrementalFastMarching : public Object
+  {
+  public:
+    /** Standard class typedefs. */
+    typedef IncrementalFastMarching Self;
+    typedef Object Superclass;
+    typedef SmartPointer<Self> Pointer;
+    typedef SmartPointer<const Self> ConstPointer;
+
+    /** Method for creation through the object factory. */
+    itkNewMacro(Self);
+
+    /** Run-time type information (and related methods). */
+    itkTypeMacro(IncrementalFastMarching, Object);
+
+    typedef TImage ImageType;
+    typedef typename ImageType::PixelType PixelType;
+    typedef typename ImageType::IndexType IndexType;
+
+    itkStaticConstMacro(ImageDimension, unsigned int, ImageType::ImageDimension);
+
+    /** The speed image. Setting a new speed image resets the arrival-time map. */
+    void SetSpeedImage(const ImageType *speedImage);
+    itkGetConstObjectMacro(SpeedImage, ImageType);
+
+    /** The arrival-time map, valid up to GetMarchedLimit(). */
+    itkGetObjectMacro(ArrivalTimeImage, ImageType);
+
+    itkGetConstMacro(MarchedLimit, double);
+
+    static PixelType GetLargeValue() { return NumericTraits<PixelType>::max() / 2; }
+
+    /** Clears all seeds and the arrival-time map. */
+    void Reset();
+
+    /** Adds a seed with the given arrival time. Seeds outside of the image are ignored. */
+    void AddSeed(const IndexType &index, double value = 0.0);
+
+    /** Marches until all arrival times up to the limit are final. */
+    void March(double limit);
+
+  protected:
+    IncrementalFastMarching();
+    virtual ~IncrementalFastMarching() {}
+
+  private:
+    IncrementalFastMarching(const Self &); // purposely not implemented
+    void operator=(const Self &);          // purposely not implemented
+
+    struct HeapNode
+    {
+      PixelType Value;
+      OffsetValueType Offset;
+
+      bool operator>(const HeapNode &other) const { return Value > other.Value; }
+    };
+
+    typedef std::priority_queue<HeapNode, std::vector<HeapNode>, std::greater<HeapNode>> HeapType;
+
+    /** Solves the upwind quadratic at the given voxel from its alive neighbors. */
+    double ComputeArrivalTime(OffsetValueType offset) const;
+
+    bool IsInside(OffsetValueType offset, unsigned int dim, int direction) const;
+
+    typename ImageType::ConstPointer m_SpeedImage;
+    typename ImageType::Pointer m_ArrivalTimeImage;
+
+    std::vector<unsigned char> m_Alive;
+    HeapType m_TrialHeap;
+
+    OffsetValueType m_Strides[ImageDimension];
+    OffsetValueType m_Sizes[ImageDimension];
+    double m_InverseSquaredSpacing[ImageDimension];
+
+    double m_MarchedLimit;
+  };
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkIncrementalFastMarching.txx"
+#endif
+
+#endif
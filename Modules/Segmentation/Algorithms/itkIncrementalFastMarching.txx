@@ -0,0 +1,208 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef _itkIncrementalFastMarching_txx
+#define _itkIncrementalFastMarching_txx
+
+#include "itkIncrementalFastMarching.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+  template <class TImage>
+  IncrementalFastMarching<TImage>::IncrementalFastMarching() : m_MarchedLimit(0.0)
+  {
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      m_Strides[i] = 0;
+      m_Sizes[i] = 0;
+      m_InverseSquaredSpacing[i] = 1.0;
+    }
+  }
+
+  template <class TImage>
+  void IncrementalFastMarching<TImage>::SetSpeedImage(const ImageType *speedImage)
+  {
+    m_SpeedImage = speedImage;
+    m_ArrivalTimeImage = nullptr;
+
+    if (speedImage != nullptr)
+    {
+      m_ArrivalTimeImage = ImageType::New();
+      m_ArrivalTimeImage->CopyInformation(speedImage);
+      m_ArrivalTimeImage->SetRegions(speedImage->GetBufferedRegion());
+      m_ArrivalTimeImage->Allocate();
+
+      const typename ImageType::SizeType size = speedImage->GetBufferedRegion().GetSize();
+      OffsetValueType stride = 1;
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        m_Strides[i] = stride;
+        m_Sizes[i] = static_cast<OffsetValueType>(size[i]);
+        m_InverseSquaredSpacing[i] = 1.0 / (speedImage->GetSpacing()[i] * speedImage->GetSpacing()[i]);
+        stride *= m_Sizes[i];
+      }
+    }
+
+    this->Reset();
+    this->Modified();
+  }
+
+  template <class TImage>
+  void IncrementalFastMarching<TImage>::Reset()
+  {
+    m_TrialHeap = HeapType();
+    m_MarchedLimit = 0.0;
+
+    if (m_ArrivalTimeImage.IsNull())
+    {
+      m_Alive.clear();
+      return;
+    }
+
+    m_ArrivalTimeImage->FillBuffer(GetLargeValue());
+    m_Alive.assign(m_ArrivalTimeImage->GetBufferedRegion().GetNumberOfPixels(), 0);
+    m_ArrivalTimeImage->Modified();
+  }
+
+  template <class TImage>
+  void IncrementalFastMarching<TImage>::AddSeed(const IndexType &index, double value)
+  {
+    if (m_ArrivalTimeImage.IsNull() || !m_ArrivalTimeImage->GetBufferedRegion().IsInside(index))
+      return;
+
+    const OffsetValueType offset = m_ArrivalTimeImage->ComputeOffset(index);
+    PixelType *arrivalTimes = m_ArrivalTimeImage->GetBufferPointer();
+
+    if (value < arrivalTimes[offset])
+    {
+      arrivalTimes[offset] = static_cast<PixelType>(value);
+      m_Alive[offset] = 0;
+      HeapNode node = {arrivalTimes[offset], offset};
+      m_TrialHeap.push(node);
+    }
+
+    // the map is only final below the new seed until the next march
+    m_MarchedLimit = std::min(m_MarchedLimit, value);
+  }
+
+  template <class TImage>
+  bool IncrementalFastMarching<TImage>::IsInside(OffsetValueType offset, unsigned int dim, int direction) const
+  {
+    const OffsetValueType coordinate = (offset / m_Strides[dim]) % m_Sizes[dim];
+    return direction < 0 ? coordinate > 0 : coordinate + 1 < m_Sizes[dim];
+  }
+
+  template <class TImage>
+  double IncrementalFastMarching<TImage>::ComputeArrivalTime(OffsetValueType offset) const
+  {
+    const double speed = m_SpeedImage->GetBufferPointer()[offset];
+    if (speed <= 0.0)
+      return GetLargeValue();
+
+    const PixelType *arrivalTimes = m_ArrivalTimeImage->GetBufferPointer();
+
+    // smallest alive neighbor along each axis
+    std::pair<double, double> neighbors[ImageDimension];
+    unsigned int numberOfNeighbors = 0;
+    for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+    {
+      double value = GetLargeValue();
+      for (int direction = -1; direction <= 1; direction += 2)
+      {
+        if (!this->IsInside(offset, dim, direction))
+          continue;
+
+        const OffsetValueType neighbor = offset + direction * m_Strides[dim];
+        if (m_Alive[neighbor])
+          value = std::min<double>(value, arrivalTimes[neighbor]);
+      }
+      if (value < GetLargeValue())
+        neighbors[numberOfNeighbors++] = std::make_pair(value, m_InverseSquaredSpacing[dim]);
+    }
+    std::sort(neighbors, neighbors + numberOfNeighbors);
+
+    // solve the quadratic with increasing number of axes, see FastMarchingImageFilter::UpdateValue()
+    double a = 0.0;
+    double b = 0.0;
+    double c = -1.0 / (speed * speed);
+    double solution = GetLargeValue();
+    for (unsigned int i = 0; i < numberOfNeighbors && solution > neighbors[i].first; ++i)
+    {
+      const double value = neighbors[i].first;
+      const double weight = neighbors[i].second;
+      a += weight;
+      b += value * weight;
+      c += value * value * weight;
+
+      const double discriminant = b * b - a * c;
+      if (discriminant < 0.0)
+        break;
+
+      solution = (std::sqrt(discriminant) + b) / a;
+    }
+    return solution;
+  }
+
+  template <class TImage>
+  void IncrementalFastMarching<TImage>::March(double limit)
+  {
+    if (m_ArrivalTimeImage.IsNull())
+      return;
+
+    PixelType *arrivalTimes = m_ArrivalTimeImage->GetBufferPointer();
+
+    while (!m_TrialHeap.empty() && m_TrialHeap.top().Value <= limit)
+    {
+      const HeapNode node = m_TrialHeap.top();
+      m_TrialHeap.pop();
+
+      // skip outdated heap entries of voxels that were lowered or accepted meanwhile
+      if (m_Alive[node.Offset] || node.Value != arrivalTimes[node.Offset])
+        continue;
+
+      m_Alive[node.Offset] = 1;
+
+      for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+      {
+        for (int direction = -1; direction <= 1; direction += 2)
+        {
+          if (!this->IsInside(node.Offset, dim, direction))
+            continue;
+
+          // alive neighbors are updated as well, they may be reached earlier from a seed added later
+          const OffsetValueType neighbor = node.Offset + direction * m_Strides[dim];
+          const PixelType value = static_cast<PixelType>(this->ComputeArrivalTime(neighbor));
+          if (value < arrivalTimes[neighbor])
+          {
+            arrivalTimes[neighbor] = value;
+            m_Alive[neighbor] = 0;
+            HeapNode trial = {value, neighbor};
+            m_TrialHeap.push(trial);
+          }
+        }
+      }
+    }
+
+    m_MarchedLimit = std::max(m_MarchedLimit, limit);
+    m_ArrivalTimeImage->Modified();
+  }
+
+} // end namespace itk
+
+#endif
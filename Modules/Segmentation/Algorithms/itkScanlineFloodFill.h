@@ -0,0 +1,178 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef __itkScanlineFloodFill_h
+#define __itkScanlineFloodFill_h
+
+#include "itkIndex.h"
+#include "itkIntTypes.h"
+#include "itkMultiThreader.h"
+#include "itkSize.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace itk
+{
+  /** \class ScanlineFloodFill
+  * \brief Multi-threaded scan-line flood fill engine working on a visited bit set.
+  *
+  * Pixels are addressed by their offset into a buffer of the given size (first dimension running fastest).
+  * Starting at the seeds, the engine grows spans along the first dimension and scans the rows adjacent to each span
+  * (face connectivity) for the starts of new spans. Pending spans are kept in per-thread work queues, idle threads
+  * steal work from the queues of the others. Filled pixels are only recorded in an atomic bit set, so the caller
+  * decides what to write for a filled span.
+  *
+  * The predicates passed to Fill() are called concurrently and must be thread-safe:
+  * - inclusion(offset) decides whether a pixel belongs to the region,
+  * - rejection(offset, threadId) is called for unfilled neighbors that failed the inclusion test; it may be called
+  *   several times for the same pixel,
+  * - span(firstOffset, lastOffset, threadId) is called once for every newly filled span.
+  *
+  * Subsequent calls to Fill() continue on the same bit set, which allows level-by-level growing. If a maximum number
+  * of pixels is set, filling stops early as soon as the budget is exceeded (spans that were already claimed are
+  * completed, so the result may exceed the budget by a few spans).
+  *
+  * \ingroup RegionGrowingSegmentation
+  */
+  template <unsigned int VDimension>
+  class ScanlineFloodFill
+  {
+  public:
+    typedef ScanlineFloodFill Self;
+
+    typedef Size<VDimension> SizeType;
+    typedef Index<VDimension> IndexType;
+
+    itkStaticConstMacro(Dimension, unsigned int, VDimension);
+
+    explicit ScanlineFloodFill(const SizeType &size);
+
+    /** Number of threads used by Fill(). Small buffers are processed with fewer threads. */
+    void SetNumberOfThreads(ThreadIdType numberOfThreads) { m_NumberOfThreads = numberOfThreads; }
+    ThreadIdType GetNumberOfThreads() const { return m_NumberOfThreads; }
+
+    /** Maximum number of filled pixels before filling is terminated, 0 means unlimited. */
+    void SetMaximumNumberOfPixels(SizeValueType maximum) { m_MaximumNumberOfPixels = maximum; }
+    SizeValueType GetMaximumNumberOfPixels() const { return m_MaximumNumberOfPixels; }
+
+    /** Clears the bit set and the statistics. */
+    void Reset();
+
+    bool IsInside(const IndexType &index) const;
+    OffsetValueType ComputeOffset(const IndexType &index) const;
+
+    bool IsFilled(OffsetValueType offset) const
+    {
+      return (m_Visited[offset >> 6].load(std::memory_order_relaxed) & (uint64_t(1) << (offset & 63))) != 0;
+    }
+
+    /** Total number of filled pixels since the last Reset(). */
+    SizeValueType GetNumberOfFilledPixels() const { return m_NumberOfFilledPixels.load(); }
+
+    /** True if the last Fill() was terminated because the pixel budget was exceeded. */
+    bool GetBudgetExceeded() const { return m_BudgetExceeded.load(); }
+
+    /** Fills from the given seed offsets and returns the number of pixels filled by this call. */
+    template <class TInclusionFunction, class TRejectionFunction, class TSpanFunction>
+    SizeValueType Fill(const std::vector<OffsetValueType> &seeds,
+                       TInclusionFunction inclusion,
+                       TRejectionFunction rejection,
+                       TSpanFunction span);
+
+    template <class TInclusionFunction, class TSpanFunction>
+    SizeValueType Fill(const std::vector<OffsetValueType> &seeds, TInclusionFunction inclusion, TSpanFunction span)
+    {
+      return this->Fill(seeds, inclusion, [](OffsetValueType, ThreadIdType) {}, span);
+    }
+
+  private:
+    struct Span
+    {
+      OffsetValueType RowOffset;
+      OffsetValueType X;
+    };
+
+    /**
+    * Per-thread work. The owner pushes and pops its private stack without locking and publishes part of it to the
+    * shared queue whenever that runs dry, so that idle threads can steal from the front of the shared queue.
+    */
+    struct WorkQueue
+    {
+      std::vector<Span> Private;
+      std::mutex Mutex;
+      std::deque<Span> Shared;
+      std::atomic<SizeValueType> SharedSize;
+      char Padding[64]; // keeps the queues of different threads off the same cache line
+    };
+
+    template <class TInclusionFunction, class TRejectionFunction, class TSpanFunction>
+    struct FillData
+    {
+      Self *Engine;
+      TInclusionFunction *Inclusion;
+      TRejectionFunction *Rejection;
+      TSpanFunction *Span;
+    };
+
+    template <class TInclusionFunction, class TRejectionFunction, class TSpanFunction>
+    static ITK_THREAD_RETURN_TYPE FillThreadCallback(void *arg);
+
+    template <class TInclusionFunction, class TRejectionFunction, class TSpanFunction>
+    void ProcessSpan(const Span &span,
+                     ThreadIdType threadId,
+                     TInclusionFunction &inclusion,
+                     TRejectionFunction &rejection,
+                     TSpanFunction &spanFunction);
+
+    bool Claim(OffsetValueType offset)
+    {
+      const uint64_t mask = uint64_t(1) << (offset & 63);
+      return (m_Visited[offset >> 6].fetch_or(mask, std::memory_order_relaxed) & mask) == 0;
+    }
+
+    void Push(ThreadIdType threadId, const Span &span);
+    void PushShared(ThreadIdType threadId, const Span &span);
+    bool Pop(ThreadIdType threadId, Span &span);
+    bool Steal(ThreadIdType threadId, Span &span);
+
+    SizeType m_Size;
+    OffsetValueType m_Strides[VDimension];
+    SizeValueType m_NumberOfPixels;
+
+    std::unique_ptr<std::atomic<uint64_t>[]> m_Visited;
+    SizeValueType m_NumberOfWords;
+
+    std::unique_ptr<WorkQueue[]> m_Queues;
+    ThreadIdType m_NumberOfActiveThreads;
+    std::atomic<SizeValueType> m_PendingSpans;
+
+    ThreadIdType m_NumberOfThreads;
+    SizeValueType m_MaximumNumberOfPixels;
+    std::atomic<SizeValueType> m_NumberOfFilledPixels;
+    std::atomic<bool> m_BudgetExceeded;
+  };
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkScanlineFloodFill.txx"
+#endif
+
+#endif
@@ -0,0 +1,350 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef _itkScanlineFloodFill_txx
+#define _itkScanlineFloodFill_txx
+
+#include "itkScanlineFloodFill.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace itk
+{
+  template <unsigned int VDimension>
+  ScanlineFloodFill<VDimension>::ScanlineFloodFill(const SizeType &size)
+    : m_Size(size),
+      m_NumberOfActiveThreads(0),
+      m_PendingSpans(0),
+      m_NumberOfThreads(MultiThreader::GetGlobalDefaultNumberOfThreads()),
+      m_MaximumNumberOfPixels(0),
+      m_NumberOfFilledPixels(0),
+      m_BudgetExceeded(false)
+  {
+    m_NumberOfPixels = 1;
+    for (unsigned int i = 0; i < VDimension; ++i)
+    {
+      m_Strides[i] = static_cast<OffsetValueType>(m_NumberOfPixels);
+      m_NumberOfPixels *= m_Size[i];
+    }
+
+    m_NumberOfWords = (m_NumberOfPixels + 63) / 64;
+    m_Visited.reset(new std::atomic<uint64_t>[m_NumberOfWords]);
+    this->Reset();
+  }
+
+  template <unsigned int VDimension>
+  void ScanlineFloodFill<VDimension>::Reset()
+  {
+    for (SizeValueType i = 0; i < m_NumberOfWords; ++i)
+    {
+      m_Visited[i].store(0, std::memory_order_relaxed);
+    }
+    m_NumberOfFilledPixels = 0;
+    m_BudgetExceeded = false;
+  }
+
+  template <unsigned int VDimension>
+  bool ScanlineFloodFill<VDimension>::IsInside(const IndexType &index) const
+  {
+    for (unsigned int i = 0; i < VDimension; ++i)
+    {
+      if (index[i] < 0 || index[i] >= static_cast<IndexValueType>(m_Size[i]))
+        return false;
+    }
+    return true;
+  }
+
+  template <unsigned int VDimension>
+  OffsetValueType ScanlineFloodFill<VDimension>::ComputeOffset(const IndexType &index) const
+  {
+    OffsetValueType offset = 0;
+    for (unsigned int i = 0; i < VDimension; ++i)
+    {
+      offset += index[i] * m_Strides[i];
+    }
+    return offset;
+  }
+
+  template <unsigned int VDimension>
+  void ScanlineFloodFill<VDimension>::Push(ThreadIdType threadId, const Span &span)
+  {
+    ++m_PendingSpans;
+    m_Queues[threadId].Private.push_back(span);
+  }
+
+  template <unsigned int VDimension>
+  void ScanlineFloodFill<VDimension>::PushShared(ThreadIdType threadId, const Span &span)
+  {
+    ++m_PendingSpans;
+    WorkQueue &queue = m_Queues[threadId];
+    std::lock_guard<std::mutex> lock(queue.Mutex);
+    queue.Shared.push_back(span);
+    ++queue.SharedSize;
+  }
+
+  template <unsigned int VDimension>
+  bool ScanlineFloodFill<VDimension>::Pop(ThreadIdType threadId, Span &span)
+  {
+    WorkQueue &queue = m_Queues[threadId];
+
+    if (!queue.Private.empty())
+    {
+      span = queue.Private.back();
+      queue.Private.pop_back();
+
+      // hand the oldest half of the private work over to thieves once the shared queue is exhausted
+      if (queue.Private.size() > 1 && queue.SharedSize.load(std::memory_order_relaxed) == 0)
+      {
+        const std::size_t numberOfPublishedSpans = queue.Private.size() / 2;
+        std::lock_guard<std::mutex> lock(queue.Mutex);
+        queue.Shared.insert(
+          queue.Shared.end(), queue.Private.begin(), queue.Private.begin() + numberOfPublishedSpans);
+        queue.SharedSize += numberOfPublishedSpans;
+        queue.Private.erase(queue.Private.begin(), queue.Private.begin() + numberOfPublishedSpans);
+      }
+      return true;
+    }
+
+    if (queue.SharedSize.load(std::memory_order_relaxed) == 0)
+      return false;
+
+    std::lock_guard<std::mutex> lock(queue.Mutex);
+    if (queue.Shared.empty())
+      return false;
+
+    span = queue.Shared.back();
+    queue.Shared.pop_back();
+    --queue.SharedSize;
+    return true;
+  }
+
+  template <unsigned int VDimension>
+  bool ScanlineFloodFill<VDimension>::Steal(ThreadIdType threadId, Span &span)
+  {
+    for (ThreadIdType i = 1; i < m_NumberOfActiveThreads; ++i)
+    {
+      WorkQueue &queue = m_Queues[(threadId + i) % m_NumberOfActiveThreads];
+      if (queue.SharedSize.load(std::memory_order_relaxed) == 0)
+        continue;
+
+      std::lock_guard<std::mutex> lock(queue.Mutex);
+      if (!queue.Shared.empty())
+      {
+        span = queue.Shared.front();
+        queue.Shared.pop_front();
+        --queue.SharedSize;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  template <unsigned int VDimension>
+  template <class TInclusionFunction, class TRejectionFunction, class TSpanFunction>
+  void ScanlineFloodFill<VDimension>::ProcessSpan(const Span &span,
+                                                  ThreadIdType threadId,
+                                                  TInclusionFunction &inclusion,
+                                                  TRejectionFunction &rejection,
+                                                  TSpanFunction &spanFunction)
+  {
+    const OffsetValueType row = span.RowOffset;
+    const OffsetValueType seed = row + span.X;
+
+    if (this->IsFilled(seed) || !inclusion(seed) || !this->Claim(seed))
+      return;
+
+    // grow the span along the first dimension
+    OffsetValueType first = span.X;
+    OffsetValueType last = span.X;
+    const OffsetValueType width = static_cast<OffsetValueType>(m_Size[0]);
+
+    while (first > 0)
+    {
+      const OffsetValueType candidate = row + first - 1;
+      if (this->IsFilled(candidate))
+        break;
+      if (!inclusion(candidate))
+      {
+        rejection(candidate, threadId);
+        break;
+      }
+      if (!this->Claim(candidate))
+        break;
+      --first;
+    }
+
+    while (last < width - 1)
+    {
+      const OffsetValueType candidate = row + last + 1;
+      if (this->IsFilled(candidate))
+        break;
+      if (!inclusion(candidate))
+      {
+        rejection(candidate, threadId);
+        break;
+      }
+      if (!this->Claim(candidate))
+        break;
+      ++last;
+    }
+
+    spanFunction(row + first, row + last, threadId);
+
+    const SizeValueType spanLength = static_cast<SizeValueType>(last - first + 1);
+    const SizeValueType numberOfFilledPixels = m_NumberOfFilledPixels.fetch_add(spanLength) + spanLength;
+    if (m_MaximumNumberOfPixels > 0 && numberOfFilledPixels > m_MaximumNumberOfPixels)
+    {
+      m_BudgetExceeded = true;
+      return;
+    }
+
+    // scan the adjacent rows and queue one span per run of unfilled pixels inside the region
+    for (unsigned int dim = 1; dim < VDimension; ++dim)
+    {
+      const OffsetValueType coordinate = (row / m_Strides[dim]) % static_cast<OffsetValueType>(m_Size[dim]);
+
+      for (int direction = -1; direction <= 1; direction += 2)
+      {
+        if ((direction < 0 && coordinate == 0) ||
+            (direction > 0 && coordinate + 1 >= static_cast<OffsetValueType>(m_Size[dim])))
+          continue;
+
+        const OffsetValueType neighborRow = row + direction * m_Strides[dim];
+        bool inRun = false;
+
+        for (OffsetValueType x = first; x <= last; ++x)
+        {
+          const OffsetValueType candidate = neighborRow + x;
+          if (this->IsFilled(candidate))
+          {
+            inRun = false;
+          }
+          else if (inclusion(candidate))
+          {
+            if (!inRun)
+            {
+              Span neighborSpan = {neighborRow, x};
+              this->Push(threadId, neighborSpan);
+              inRun = true;
+            }
+          }
+          else
+          {
+            rejection(candidate, threadId);
+            inRun = false;
+          }
+        }
+      }
+    }
+  }
+
+  template <unsigned int VDimension>
+  template <class TInclusionFunction, class TRejectionFunction, class TSpanFunction>
+  ITK_THREAD_RETURN_TYPE ScanlineFloodFill<VDimension>::FillThreadCallback(void *arg)
+  {
+    typedef MultiThreader::ThreadInfoStruct ThreadInfoType;
+    ThreadInfoType *infoStruct = static_cast<ThreadInfoType *>(arg);
+    FillData<TInclusionFunction, TRejectionFunction, TSpanFunction> *data =
+      static_cast<FillData<TInclusionFunction, TRejectionFunction, TSpanFunction> *>(infoStruct->UserData);
+
+    Self *engine = data->Engine;
+    const ThreadIdType threadId = infoStruct->ThreadID;
+
+    Span span;
+    while (!engine->m_BudgetExceeded.load(std::memory_order_relaxed))
+    {
+      if (engine->Pop(threadId, span) || engine->Steal(threadId, span))
+      {
+        engine->ProcessSpan(span, threadId, *data->Inclusion, *data->Rejection, *data->Span);
+        --engine->m_PendingSpans;
+      }
+      else if (engine->m_PendingSpans.load() == 0)
+      {
+        break;
+      }
+      else
+      {
+        std::this_thread::yield();
+      }
+    }
+
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  template <unsigned int VDimension>
+  template <class TInclusionFunction, class TRejectionFunction, class TSpanFunction>
+  SizeValueType ScanlineFloodFill<VDimension>::Fill(const std::vector<OffsetValueType> &seeds,
+                                                    TInclusionFunction inclusion,
+                                                    TRejectionFunction rejection,
+                                                    TSpanFunction span)
+  {
+    const SizeValueType numberOfFilledPixelsBefore = m_NumberOfFilledPixels;
+    m_BudgetExceeded = m_MaximumNumberOfPixels > 0 && numberOfFilledPixelsBefore >= m_MaximumNumberOfPixels;
+    if (m_BudgetExceeded || seeds.empty())
+      return 0;
+
+    // spawning threads does not pay off for small buffers such as single slices
+    const SizeValueType minimumNumberOfPixelsPerThread = 1 << 16;
+    m_NumberOfActiveThreads = static_cast<ThreadIdType>(std::max<SizeValueType>(
+      1, std::min<SizeValueType>(std::max<ThreadIdType>(m_NumberOfThreads, 1),
+                                 m_NumberOfPixels / minimumNumberOfPixelsPerThread)));
+    m_Queues.reset(new WorkQueue[m_NumberOfActiveThreads]);
+    for (ThreadIdType i = 0; i < m_NumberOfActiveThreads; ++i)
+    {
+      m_Queues[i].SharedSize = 0;
+    }
+    m_PendingSpans = 0;
+
+    const OffsetValueType width = static_cast<OffsetValueType>(m_Size[0]);
+    ThreadIdType queueId = 0;
+    for (auto seed : seeds)
+    {
+      if (seed < 0 || seed >= static_cast<OffsetValueType>(m_NumberOfPixels))
+        continue;
+
+      Span seedSpan = {seed - seed % width, seed % width};
+      this->PushShared(queueId, seedSpan);
+      queueId = (queueId + 1) % m_NumberOfActiveThreads;
+    }
+
+    FillData<TInclusionFunction, TRejectionFunction, TSpanFunction> data = {this, &inclusion, &rejection, &span};
+
+    if (m_NumberOfActiveThreads == 1)
+    {
+      MultiThreader::ThreadInfoStruct infoStruct;
+      infoStruct.ThreadID = 0;
+      infoStruct.NumberOfThreads = 1;
+      infoStruct.UserData = &data;
+      FillThreadCallback<TInclusionFunction, TRejectionFunction, TSpanFunction>(&infoStruct);
+    }
+    else
+    {
+      MultiThreader::Pointer threader = MultiThreader::New();
+      threader->SetNumberOfThreads(m_NumberOfActiveThreads);
+      threader->SetSingleMethod(FillThreadCallback<TInclusionFunction, TRejectionFunction, TSpanFunction>, &data);
+      threader->SingleMethodExecute();
+    }
+
+    m_Queues.reset();
+    m_NumberOfActiveThreads = 0;
+
+    return m_NumberOfFilledPixels - numberOfFilledPixelsBefore;
+  }
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,106 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef __itkScanlineFloodFillImageFilter_h
+#define __itkScanlineFloodFillImageFilter_h
+
+#include "itkImage.h"
+#include "itkImageToImageFilter.h"
+
+#include <vector>
+
+namespace itk
+{
+  /** \class ScanlineFloodFillImageFilter
+  * \brief Connected threshold region growing based on the multi-threaded itk::ScanlineFloodFill engine.
+  *
+  * Drop-in replacement for itk::ConnectedThresholdImageFilter (face connectivity): all pixels connected to one of the
+  * seeds and lying in [Lower, Upper] are set to ReplaceValue, all other pixels to zero. Optionally, growing stops
+  * early once MaximumNumberOfPixels pixels have been filled.
+  *
+  * \ingroup RegionGrowingSegmentation
+  */
+  template <class TInputImage, class TOutputImage>
+  class ITK_EXPORT ScanlineFloodFillImageFilter : public ImageToImageFilter<TInputImage, TOutputImage>
+  {
+  public:
+    /** Standard class typedefs. */
+    typedef ScanlineFloodFillImageFilter Self;
+    typedef ImageToImageFilter<TInputImage, TOutputImage> Superclass;
+    typedef SmartPointer<Self> Pointer;
+    typedef SmartPointer<const Self> ConstPointer;
+
+    /** Method for creation through the object factory. */
+    itkFactorylessNewMacro(Self) itkCloneMacro(Self)
+
+      /** Run-time type information (and related methods).  */
+      itkTypeMacro(ScanlineFloodFillImageFilter, ImageToImageFilter);
+
+    typedef TInputImage InputImageType;
+    typedef typename InputImageType::PixelType InputImagePixelType;
+    typedef typename InputImageType::IndexType IndexType;
+
+    typedef TOutputImage OutputImageType;
+    typedef typename OutputImageType::PixelType OutputImagePixelType;
+
+    itkStaticConstMacro(ImageDimension, unsigned int, TInputImage::ImageDimension);
+
+    void SetSeed(const IndexType &seed);
+    void AddSeed(const IndexType &seed);
+    void ClearSeeds();
+    const std::vector<IndexType> &GetSeeds() const { return m_Seeds; }
+
+    itkSetMacro(Lower, InputImagePixelType);
+    itkGetConstMacro(Lower, InputImagePixelType);
+    itkSetMacro(Upper, InputImagePixelType);
+    itkGetConstMacro(Upper, InputImagePixelType);
+
+    itkSetMacro(ReplaceValue, OutputImagePixelType);
+    itkGetConstMacro(ReplaceValue, OutputImagePixelType);
+
+    /** Early termination budget, 0 (default) means unlimited. */
+    itkSetMacro(MaximumNumberOfPixels, SizeValueType);
+    itkGetConstMacro(MaximumNumberOfPixels, SizeValueType);
+
+    /** Results of the last update. */
+    itkGetConstMacro(NumberOfFilledPixels, SizeValueType);
+    itkGetConstMacro(BudgetExceeded, bool);
+
+  protected:
+    ScanlineFloodFillImageFilter();
+    ~ScanlineFloodFillImageFilter() {}
+
+    void GenerateInputRequestedRegion() override;
+    void EnlargeOutputRequestedRegion(DataObject *output) override;
+    void GenerateData() override;
+
+  private:
+    std::vector<IndexType> m_Seeds;
+    InputImagePixelType m_Lower;
+    InputImagePixelType m_Upper;
+    OutputImagePixelType m_ReplaceValue;
+    SizeValueType m_MaximumNumberOfPixels;
+    SizeValueType m_NumberOfFilledPixels;
+    bool m_BudgetExceeded;
+  };
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkScanlineFloodFillImageFilter.txx"
+#endif
+
+#endif
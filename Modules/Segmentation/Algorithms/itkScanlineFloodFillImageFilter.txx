@@ -0,0 +1,127 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef _itkScanlineFloodFillImageFilter_txx
+#define _itkScanlineFloodFillImageFilter_txx
+
+#include "itkScanlineFloodFill.h"
+#include "itkScanlineFloodFillImageFilter.h"
+
+#include <algorithm>
+
+namespace itk
+{
+  template <class TInputImage, class TOutputImage>
+  ScanlineFloodFillImageFilter<TInputImage, TOutputImage>::ScanlineFloodFillImageFilter()
+    : m_Lower(NumericTraits<InputImagePixelType>::NonpositiveMin()),
+      m_Upper(NumericTraits<InputImagePixelType>::max()),
+      m_ReplaceValue(NumericTraits<OutputImagePixelType>::OneValue()),
+      m_MaximumNumberOfPixels(0),
+      m_NumberOfFilledPixels(0),
+      m_BudgetExceeded(false)
+  {
+  }
+
+  template <class TInputImage, class TOutputImage>
+  void ScanlineFloodFillImageFilter<TInputImage, TOutputImage>::SetSeed(const IndexType &seed)
+  {
+    m_Seeds.clear();
+    this->AddSeed(seed);
+  }
+
+  template <class TInputImage, class TOutputImage>
+  void ScanlineFloodFillImageFilter<TInputImage, TOutputImage>::AddSeed(const IndexType &seed)
+  {
+    m_Seeds.push_back(seed);
+    this->Modified();
+  }
+
+  template <class TInputImage, class TOutputImage>
+  void ScanlineFloodFillImageFilter<TInputImage, TOutputImage>::ClearSeeds()
+  {
+    if (!m_Seeds.empty())
+    {
+      m_Seeds.clear();
+      this->Modified();
+    }
+  }
+
+  template <class TInputImage, class TOutputImage>
+  void ScanlineFloodFillImageFilter<TInputImage, TOutputImage>::GenerateInputRequestedRegion()
+  {
+    Superclass::GenerateInputRequestedRegion();
+    if (this->GetInput())
+    {
+      InputImageType *input = const_cast<InputImageType *>(this->GetInput());
+      input->SetRequestedRegionToLargestPossibleRegion();
+    }
+  }
+
+  template <class TInputImage, class TOutputImage>
+  void ScanlineFloodFillImageFilter<TInputImage, TOutputImage>::EnlargeOutputRequestedRegion(DataObject *output)
+  {
+    Superclass::EnlargeOutputRequestedRegion(output);
+    output->SetRequestedRegionToLargestPossibleRegion();
+  }
+
+  template <class TInputImage, class TOutputImage>
+  void ScanlineFloodFillImageFilter<TInputImage, TOutputImage>::GenerateData()
+  {
+    const InputImageType *inputImage = this->GetInput();
+    OutputImageType *outputImage = this->GetOutput();
+
+    const typename InputImageType::RegionType region = inputImage->GetBufferedRegion();
+    outputImage->SetBufferedRegion(region);
+    outputImage->Allocate();
+    outputImage->FillBuffer(NumericTraits<OutputImagePixelType>::ZeroValue());
+
+    typedef ScanlineFloodFill<ImageDimension> FloodFillType;
+    FloodFillType floodFill(region.GetSize());
+    floodFill.SetNumberOfThreads(this->GetNumberOfThreads());
+    floodFill.SetMaximumNumberOfPixels(m_MaximumNumberOfPixels);
+
+    std::vector<OffsetValueType> seeds;
+    for (const auto &seed : m_Seeds)
+    {
+      if (region.IsInside(seed))
+      {
+        seeds.push_back(inputImage->ComputeOffset(seed));
+      }
+    }
+
+    const InputImagePixelType *inputBuffer = inputImage->GetBufferPointer();
+    OutputImagePixelType *outputBuffer = outputImage->GetBufferPointer();
+    const InputImagePixelType lower = m_Lower;
+    const InputImagePixelType upper = m_Upper;
+    const OutputImagePixelType replaceValue = m_ReplaceValue;
+
+    // spans are disjoint, so threads can write their spans without synchronization
+    floodFill.Fill(seeds,
+                   [inputBuffer, lower, upper](OffsetValueType offset) {
+                     const InputImagePixelType value = inputBuffer[offset];
+                     return lower <= value && value <= upper;
+                   },
+                   [outputBuffer, replaceValue](OffsetValueType first, OffsetValueType last, ThreadIdType) {
+                     std::fill(outputBuffer + first, outputBuffer + last + 1, replaceValue);
+                   });
+
+    m_NumberOfFilledPixels = floodFill.GetNumberOfFilledPixels();
+    m_BudgetExceeded = floodFill.GetBudgetExceeded();
+  }
+
+} // end namespace itk
+
+#endif
@@ -60,6 +60,16 @@ namespace mitk
     virtual void AcceptCurrentThresholdValue();
     virtual void CancelThresholding();
 
+    /**
+      \brief Switches between an eagerly computed and a lazily rendered preview.
+
+      In lazy preview mode the feedback node shows the reference image through a threshold transfer function, so the
+      threshold is only evaluated on the slices that are resliced for the render windows. The whole volume is
+      thresholded once when the current threshold is accepted.
+    */
+    void SetLazyPreview(bool lazyPreview);
+    bool GetLazyPreview() const;
+
   protected:
     BinaryThresholdTool(); // purposely hidden
     virtual ~BinaryThresholdTool();
@@ -71,6 +81,8 @@ namespace mitk
     void OnRoiDataChanged();
     void UpdatePreview();
 
+    void ThresholdImage(Image *inputImage, Image *segmentation, bool isOldBinary);
+
     template <typename TPixel, unsigned int VImageDimension>
     void ITKThresholding(itk::Image<TPixel, VImageDimension> *originalImage,
                          mitk::Image *segmentation,
@@ -92,6 +104,7 @@ namespace mitk
     bool m_IsFloatImage;
 
     bool m_IsOldBinary = false;
+    bool m_LazyPreview = false;
   };
 
 } // namespace
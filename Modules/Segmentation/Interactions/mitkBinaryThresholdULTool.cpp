@@ -24,6 +24,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkDataStorage.h"
 #include "mitkRenderingManager.h"
+#include "mitkRenderingModeProperty.h"
+#include "mitkTransferFunctionProperty.h"
 #include <mitkSliceNavigationController.h>
 
 #include "mitkImageAccessByItk.h"
@@ -36,6 +38,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkBinaryThresholdImageFilter.h>
 #include <itkImageRegionIterator.h>
 
+#include <cmath>
+
 // us
 #include "usGetModuleContext.h"
 #include "usModule.h"
@@ -148,6 +152,30 @@ void mitk::BinaryThresholdULTool::CancelThresholding()
   m_ToolManager->ActivateTool(-1);
 }
 
+void mitk::BinaryThresholdULTool::SetLazyPreview(bool lazyPreview)
+{
+  if (m_LazyPreview == lazyPreview)
+    return;
+
+  m_LazyPreview = lazyPreview;
+
+  if (m_NodeForThresholding.IsNotNull())
+  {
+    mitk::ScalarType currentLowerThresholdValue = m_CurrentLowerThresholdValue;
+    mitk::ScalarType currentUpperThresholdValue = m_CurrentUpperThresholdValue;
+    this->SetupPreviewNode();
+    m_CurrentLowerThresholdValue = currentLowerThresholdValue;
+    m_CurrentUpperThresholdValue = currentUpperThresholdValue;
+    ThresholdingValuesChanged.Send(m_CurrentLowerThresholdValue, m_CurrentUpperThresholdValue);
+    this->UpdatePreview();
+  }
+}
+
+bool mitk::BinaryThresholdULTool::GetLazyPreview() const
+{
+  return m_LazyPreview;
+}
+
 void mitk::BinaryThresholdULTool::SetupPreviewNode()
 {
   itk::RGBPixel<float> pixel;
@@ -165,8 +193,19 @@ void mitk::BinaryThresholdULTool::SetupPreviewNode()
       mitk::LabelSetImage::Pointer workingImage =
         dynamic_cast<mitk::LabelSetImage *>(m_ToolManager->GetWorkingData(0)->GetData());
 
-      if (workingImage.IsNotNull())
+      if (m_LazyPreview)
       {
+        // The feedback node renders the image to be thresholded itself. The transfer function set in UpdatePreview()
+        // is applied by the mapper to the resliced planes only, so no volume has to be processed per threshold change.
+        m_IsOldBinary = workingImage.IsNull();
+        m_ThresholdFeedbackNode->SetData(image);
+        m_ThresholdFeedbackNode->SetProperty("binary", BoolProperty::New(false));
+        m_ThresholdFeedbackNode->SetProperty(
+          "Image Rendering.Mode", RenderingModeProperty::New(RenderingModeProperty::COLORTRANSFERFUNCTION_COLOR));
+      }
+      else if (workingImage.IsNotNull())
+      {
+        m_ThresholdFeedbackNode->SetProperty("binary", BoolProperty::New(true));
         m_ThresholdFeedbackNode->SetData(workingImage->Clone());
         m_IsOldBinary = false;
 
@@ -185,6 +224,7 @@ void mitk::BinaryThresholdULTool::SetupPreviewNode()
       }
       else
       {
+        m_ThresholdFeedbackNode->SetProperty("binary", BoolProperty::New(true));
         mitk::Image::Pointer workingImageBin = dynamic_cast<mitk::Image *>(m_ToolManager->GetWorkingData(0)->GetData());
         if (workingImageBin)
         {
@@ -251,7 +291,22 @@ void mitk::BinaryThresholdULTool::CreateNewSegmentationFromThreshold(DataNode *n
       // create a new image of the same dimensions and smallest possible pixel type
       DataNode::Pointer emptySegmentation = GetTargetSegmentationNode();
 
-      if (emptySegmentation)
+      if (emptySegmentation && m_LazyPreview)
+      {
+        // the preview was only evaluated while rendering, so the volume is thresholded exactly once, here
+        Image *segmentation = dynamic_cast<Image *>(emptySegmentation->GetData());
+        try
+        {
+          this->ThresholdImage(feedBackImage,
+                               segmentation,
+                               segmentation->GetPixelType().GetComponentType() == itk::ImageIOBase::UCHAR);
+        }
+        catch (...)
+        {
+          Tool::ErrorMessage("Error thresholding the original image. Cannot create segmentation.");
+        }
+      }
+      else if (emptySegmentation)
       {
         // actually perform a thresholding and ask for an organ type
         for (unsigned int timeStep = 0; timeStep < feedBackImage->GetTimeSteps(); ++timeStep)
@@ -280,7 +335,10 @@ void mitk::BinaryThresholdULTool::CreateNewSegmentationFromThreshold(DataNode *n
             Tool::ErrorMessage("Error accessing single time steps of the original image. Cannot create segmentation.");
           }
         }
+      }
 
+      if (emptySegmentation)
+      {
         // since we are maybe working on a smaller image, pad it to the size of the original image
         if (m_OriginalImageNode.GetPointer() != m_NodeForThresholding.GetPointer())
         {
@@ -378,32 +436,65 @@ static void ITKThresholdingOldBinary(itk::Image<TPixel, VImageDimension> *origin
   segmentation->SetVolume((void *)(filter->GetOutput()->GetPixelContainer()->GetBufferPointer()), timeStep);
 }
 
+void mitk::BinaryThresholdULTool::ThresholdImage(Image *inputImage, Image *segmentation, bool isOldBinary)
+{
+  for (unsigned int timeStep = 0; timeStep < inputImage->GetTimeSteps(); ++timeStep)
+  {
+    ImageTimeSelector::Pointer timeSelector = ImageTimeSelector::New();
+    timeSelector->SetInput(inputImage);
+    timeSelector->SetTimeNr(timeStep);
+    timeSelector->UpdateLargestPossibleRegion();
+    Image::Pointer inputImage3D = timeSelector->GetOutput();
+
+    if (isOldBinary)
+    {
+      AccessByItk_n(inputImage3D,
+                    ITKThresholdingOldBinary,
+                    (segmentation, m_CurrentLowerThresholdValue, m_CurrentUpperThresholdValue, timeStep));
+    }
+    else
+    {
+      AccessByItk_n(inputImage3D,
+                    ITKThresholding,
+                    (segmentation, m_CurrentLowerThresholdValue, m_CurrentUpperThresholdValue, timeStep));
+    }
+  }
+}
+
+static mitk::TransferFunction::Pointer CreateThresholdTransferFunction(double lower, double upper)
+{
+  // the ramps are kept as narrow as possible to mimic the hard, inclusive borders of itk::BinaryThresholdImageFilter
+  const double ramp = std::max(std::abs(upper - lower) * 1e-6, 1e-6);
+
+  mitk::TransferFunction::Pointer transferFunction = mitk::TransferFunction::New();
+  transferFunction->GetColorTransferFunction()->AddRGBPoint(lower, 0.0, 1.0, 0.0);
+
+  vtkPiecewiseFunction *opacityFunction = transferFunction->GetScalarOpacityFunction();
+  opacityFunction->RemoveAllPoints();
+  opacityFunction->AddPoint(lower - ramp, 0.0);
+  opacityFunction->AddPoint(lower, 1.0);
+  opacityFunction->AddPoint(upper, 1.0);
+  opacityFunction->AddPoint(upper + ramp, 0.0);
+
+  return transferFunction;
+}
+
 void mitk::BinaryThresholdULTool::UpdatePreview()
 {
   mitk::Image::Pointer thresholdImage = dynamic_cast<mitk::Image *>(m_NodeForThresholding->GetData());
   mitk::Image::Pointer previewImage = dynamic_cast<mitk::Image *>(m_ThresholdFeedbackNode->GetData());
   if (thresholdImage && previewImage)
   {
-    for (unsigned int timeStep = 0; timeStep < thresholdImage->GetTimeSteps(); ++timeStep)
+    if (m_LazyPreview)
     {
-      ImageTimeSelector::Pointer timeSelector = ImageTimeSelector::New();
-      timeSelector->SetInput(thresholdImage);
-      timeSelector->SetTimeNr(timeStep);
-      timeSelector->UpdateLargestPossibleRegion();
-      Image::Pointer feedBackImage3D = timeSelector->GetOutput();
-
-      if (m_IsOldBinary)
-      {
-        AccessByItk_n(feedBackImage3D,
-                      ITKThresholdingOldBinary,
-                      (previewImage, m_CurrentLowerThresholdValue, m_CurrentUpperThresholdValue, timeStep));
-      }
-      else
-      {
-        AccessByItk_n(feedBackImage3D,
-                      ITKThresholding,
-                      (previewImage, m_CurrentLowerThresholdValue, m_CurrentUpperThresholdValue, timeStep));
-      }
+      m_ThresholdFeedbackNode->SetProperty(
+        "Image Rendering.Transfer Function",
+        TransferFunctionProperty::New(
+          CreateThresholdTransferFunction(m_CurrentLowerThresholdValue, m_CurrentUpperThresholdValue)));
+    }
+    else
+    {
+      this->ThresholdImage(thresholdImage, previewImage, m_IsOldBinary);
     }
     RenderingManager::GetInstance()->RequestUpdateAll();
   }
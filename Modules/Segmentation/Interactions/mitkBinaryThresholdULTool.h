@@ -61,6 +61,16 @@ namespace mitk
     virtual void AcceptCurrentThresholdValue();
     virtual void CancelThresholding();
 
+    /**
+      \brief Switches between an eagerly computed and a lazily rendered preview.
+
+      In lazy preview mode the feedback node shows the reference image through a threshold transfer function, so the
+      thresholds are only evaluated on the slices that are resliced for the render windows. The whole volume is
+      thresholded once when the current thresholds are accepted.
+    */
+    void SetLazyPreview(bool lazyPreview);
+    bool GetLazyPreview() const;
+
   protected:
     BinaryThresholdULTool(); // purposely hidden
     virtual ~BinaryThresholdULTool();
@@ -72,6 +82,8 @@ namespace mitk
     void OnRoiDataChanged();
     void UpdatePreview();
 
+    void ThresholdImage(Image *inputImage, Image *segmentation, bool isOldBinary);
+
     DataNode::Pointer m_ThresholdFeedbackNode;
     DataNode::Pointer m_OriginalImageNode;
     DataNode::Pointer m_NodeForThresholding;
@@ -82,6 +94,7 @@ namespace mitk
     mitk::ScalarType m_CurrentUpperThresholdValue;
 
     bool m_IsOldBinary = false;
+    bool m_LazyPreview = false;
 
     typedef itk::Image<int, 3> ImageType;
     typedef itk::Image<Tool::DefaultSegmentationDataType, 3> SegmentationType; // this is sure for new segmentations
@@ -25,6 +25,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkImageCast.h"
 #include "mitkImageTimeSelector.h"
 
+#include <algorithm>
+
 // us
 #include <usGetModuleContext.h>
 #include <usModule.h>
@@ -39,6 +41,9 @@ namespace mitk
 mitk::FastMarchingTool3D::FastMarchingTool3D()
   : /*FeedbackContourTool*/ AutoSegmentationTool(),
     m_NeedUpdate(true),
+    m_NeedSpeedUpdate(true),
+    m_NeedRestart(true),
+    m_NumberOfMarchedSeeds(0),
     m_CurrentTimeStep(0),
     m_LowerThreshold(0),
     m_UpperThreshold(200),
@@ -89,14 +94,12 @@ const char *mitk::FastMarchingTool3D::GetName() const
 void mitk::FastMarchingTool3D::SetUpperThreshold(double value)
 {
   m_UpperThreshold = value / 10.0;
-  m_ThresholdFilter->SetUpperThreshold(m_UpperThreshold);
   m_NeedUpdate = true;
 }
 
 void mitk::FastMarchingTool3D::SetLowerThreshold(double value)
 {
   m_LowerThreshold = value / 10.0;
-  m_ThresholdFilter->SetLowerThreshold(m_LowerThreshold);
   m_NeedUpdate = true;
 }
 
@@ -106,6 +109,7 @@ void mitk::FastMarchingTool3D::SetBeta(double value)
   {
     m_Beta = value;
     m_SigmoidFilter->SetBeta(m_Beta);
+    m_NeedSpeedUpdate = true;
     m_NeedUpdate = true;
   }
 }
@@ -118,6 +122,7 @@ void mitk::FastMarchingTool3D::SetSigma(double value)
     {
       m_Sigma = value;
       m_GradientMagnitudeFilter->SetSigma(m_Sigma);
+      m_NeedSpeedUpdate = true;
       m_NeedUpdate = true;
     }
   }
@@ -129,6 +134,7 @@ void mitk::FastMarchingTool3D::SetAlpha(double value)
   {
     m_Alpha = value;
     m_SigmoidFilter->SetAlpha(m_Alpha);
+    m_NeedSpeedUpdate = true;
     m_NeedUpdate = true;
   }
 }
@@ -138,7 +144,6 @@ void mitk::FastMarchingTool3D::SetStoppingValue(double value)
   if (m_StoppingValue != value)
   {
     m_StoppingValue = value;
-    m_FastMarchingFilter->SetStoppingValue(m_StoppingValue);
     m_NeedUpdate = true;
   }
 }
@@ -198,20 +203,15 @@ void mitk::FastMarchingTool3D::Activated()
   m_SigmoidFilter->SetOutputMinimum(0.0);
   m_SigmoidFilter->SetOutputMaximum(1.0);
 
-  m_FastMarchingFilter = FastMarchingFilterType::New();
-  m_FastMarchingFilter->AddObserver(itk::ProgressEvent(), m_ProgressCommand);
-  m_FastMarchingFilter->SetStoppingValue(m_StoppingValue);
+  m_FastMarching = IncrementalFastMarchingType::New();
 
   m_SeedContainer = NodeContainer::New();
   m_SeedContainer->Initialize();
-  m_FastMarchingFilter->SetTrialPoints(m_SeedContainer);
 
-  // set up pipeline
+  // set up pipeline, the fast marching step is connected in Update() once the speed image is available
   m_SmoothFilter->SetInput(m_ReferenceImageAsITK);
   m_GradientMagnitudeFilter->SetInput(m_SmoothFilter->GetOutput());
   m_SigmoidFilter->SetInput(m_GradientMagnitudeFilter->GetOutput());
-  m_FastMarchingFilter->SetInput(m_SigmoidFilter->GetOutput());
-  m_ThresholdFilter->SetInput(m_FastMarchingFilter->GetOutput());
 
   m_ToolManager->GetDataStorage()->Add(m_SeedsAsPointSetNode, m_ToolManager->GetWorkingData(0));
 
@@ -236,7 +236,6 @@ void mitk::FastMarchingTool3D::Deactivated()
   this->m_SmoothFilter->RemoveAllObservers();
   this->m_SigmoidFilter->RemoveAllObservers();
   this->m_GradientMagnitudeFilter->RemoveAllObservers();
-  this->m_FastMarchingFilter->RemoveAllObservers();
   m_ResultImageNode = nullptr;
   mitk::RenderingManager::GetInstance()->RequestUpdateAll();
 
@@ -270,6 +269,7 @@ void mitk::FastMarchingTool3D::Initialize()
   }
   CastToItkImage(m_ReferenceImage, m_ReferenceImageAsITK);
   m_SmoothFilter->SetInput(m_ReferenceImageAsITK);
+  m_NeedSpeedUpdate = true;
   m_NeedUpdate = true;
 }
 
@@ -331,7 +331,6 @@ void mitk::FastMarchingTool3D::OnAddPoint()
   node.SetValue(seedValue);
   node.SetIndex(seedPosition);
   this->m_SeedContainer->InsertElement(this->m_SeedContainer->Size(), node);
-  m_FastMarchingFilter->Modified();
 
   mitk::RenderingManager::GetInstance()->RequestUpdateAll();
 
@@ -349,7 +348,9 @@ void mitk::FastMarchingTool3D::OnDelete()
   {
     // delete last element of seeds container
     this->m_SeedContainer->pop_back();
-    m_FastMarchingFilter->Modified();
+
+    // arrival times cannot be raised again, so the map is recomputed from the remaining seeds
+    m_NeedRestart = true;
 
     mitk::RenderingManager::GetInstance()->RequestUpdateAll();
 
@@ -372,6 +373,36 @@ void mitk::FastMarchingTool3D::Update()
     CurrentlyBusy.Send(true);
     try
     {
+      if (m_NeedSpeedUpdate)
+      {
+        m_SigmoidFilter->Update();
+        m_FastMarching->SetSpeedImage(m_SigmoidFilter->GetOutput());
+        m_ThresholdFilter->SetInput(m_FastMarching->GetArrivalTimeImage());
+        m_NeedSpeedUpdate = false;
+        m_NeedRestart = false;
+        m_NumberOfMarchedSeeds = 0;
+      }
+      else if (m_NeedRestart)
+      {
+        m_FastMarching->Reset();
+        m_NeedRestart = false;
+        m_NumberOfMarchedSeeds = 0;
+      }
+
+      // only seeds added since the last update have to be propagated
+      for (; m_NumberOfMarchedSeeds < m_SeedContainer->Size(); ++m_NumberOfMarchedSeeds)
+      {
+        const NodeType &node = m_SeedContainer->ElementAt(m_NumberOfMarchedSeeds);
+        m_FastMarching->AddSeed(node.GetIndex(), node.GetValue());
+      }
+
+      // arrival times beyond the upper threshold never end up in the segmentation, so there is no need to march
+      // further; the map is resumed from here if the threshold or the stopping value is raised later on
+      const double upperLimit = std::min(m_UpperThreshold, m_StoppingValue);
+      m_FastMarching->March(upperLimit);
+
+      m_ThresholdFilter->SetLowerThreshold(m_LowerThreshold);
+      m_ThresholdFilter->SetUpperThreshold(upperLimit);
       m_ThresholdFilter->Update();
     }
     catch (itk::ExceptionObject &excep)
@@ -400,6 +431,8 @@ void mitk::FastMarchingTool3D::Update()
 
     // add interaction with poinset again
     m_SeedPointInteractor->SetDataNode(m_SeedsAsPointSetNode);
+
+    m_NeedUpdate = false;
   }
 }
 
@@ -435,9 +468,7 @@ void mitk::FastMarchingTool3D::ClearSeeds()
     m_PointSetRemoveObserverTag = m_SeedsAsPointSet->AddObserver(mitk::PointSetRemoveEvent(), pointRemovedCommand);
   }
 
-  if (this->m_FastMarchingFilter.IsNotNull())
-    m_FastMarchingFilter->Modified();
-
+  this->m_NeedRestart = true;
   this->m_NeedUpdate = true;
 }
 
@@ -36,6 +36,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkGradientMagnitudeRecursiveGaussianImageFilter.h"
 #include "itkSigmoidImageFilter.h"
 
+#include "itkIncrementalFastMarching.h"
+
 namespace us
 {
   class ModuleResource;
@@ -51,6 +53,11 @@ namespace mitk
       Smoothing->GradientMagnitude->SigmoidFunction->FastMarching->Threshold
     The resulting binary image is seen as a segmentation of an object.
 
+    The speed image and the arrival-time map are kept between updates. Changing the
+    thresholds or the stopping value only resumes the march (if at all) and thresholds
+    the map again, adding a seed only propagates the arrival times of the new seed.
+    The march never proceeds beyond the upper threshold.
+
     For detailed documentation see ITK Software Guide section 9.3.1 Fast Marching Segmentation.
   */
   class MITKSEGMENTATION_EXPORT FastMarchingTool3D : public AutoSegmentationTool
@@ -73,6 +80,7 @@ namespace mitk
     typedef itk::FastMarchingImageFilter<InternalImageType, InternalImageType> FastMarchingFilterType;
     typedef FastMarchingFilterType::NodeContainer NodeContainer;
     typedef FastMarchingFilterType::NodeType NodeType;
+    typedef itk::IncrementalFastMarching<InternalImageType> IncrementalFastMarchingType;
 
     bool CanHandle(BaseData *referenceData) const override;
 
@@ -133,6 +141,9 @@ namespace mitk
     Image::Pointer m_ReferenceImage;
 
     bool m_NeedUpdate;
+    bool m_NeedSpeedUpdate; // the speed image has to be recomputed, which invalidates the arrival-time map
+    bool m_NeedRestart;     // the arrival-time map has to be recomputed from all seeds
+    unsigned int m_NumberOfMarchedSeeds;
 
     int m_CurrentTimeStep;
 
@@ -159,7 +170,7 @@ namespace mitk
     SmoothingFilterType::Pointer m_SmoothFilter;
     GradientFilterType::Pointer m_GradientMagnitudeFilter;
     SigmoidFilterType::Pointer m_SigmoidFilter;
-    FastMarchingFilterType::Pointer m_FastMarchingFilter;
+    IncrementalFastMarchingType::Pointer m_FastMarching;
   };
 
 } // namespace
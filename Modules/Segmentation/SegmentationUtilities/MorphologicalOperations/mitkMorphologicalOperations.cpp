@@ -15,13 +15,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkMorphologicalOperations.h"
-#include <itkBinaryBallStructuringElement.h>
-#include <itkBinaryCrossStructuringElement.h>
-#include <itkBinaryDilateImageFilter.h>
-#include <itkBinaryErodeImageFilter.h>
-#include <itkBinaryFillholeImageFilter.h>
-#include <itkBinaryMorphologicalClosingImageFilter.h>
-#include <itkBinaryMorphologicalOpeningImageFilter.h>
+#include "mitkRunLengthBinaryMorphology.h"
 #include <mitkImageAccessByItk.h>
 #include <mitkImageCast.h>
 #include <mitkImageReadAccessor.h>
@@ -210,82 +204,127 @@ void mitk::MorphologicalOperations::FillHoles(mitk::Image::Pointer &image)
   MITK_INFO << "Finished FillHole";
 }
 
-template <typename TPixel, unsigned int VDimension>
-void mitk::MorphologicalOperations::itkClosing(
-  itk::Image<TPixel, VDimension> *sourceImage,
-  mitk::Image::Pointer &resultImage,
-  int factor,
-  mitk::MorphologicalOperations::StructuralElementType structuralElementFlags)
+namespace
 {
-  typedef itk::Image<TPixel, VDimension> ImageType;
-  typedef itk::BinaryBallStructuringElement<TPixel, VDimension> BallType;
-  typedef itk::BinaryCrossStructuringElement<TPixel, VDimension> CrossType;
-  typedef typename itk::BinaryMorphologicalClosingImageFilter<ImageType, ImageType, BallType> BallClosingFilterType;
-  typedef typename itk::BinaryMorphologicalClosingImageFilter<ImageType, ImageType, CrossType> CrossClosingFilterType;
+  template <typename TPixel, unsigned int VDimension>
+  void GetMaskSize(const itk::Image<TPixel, VDimension> *image, int size[3])
+  {
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      size[i] = i < VDimension ? static_cast<int>(image->GetLargestPossibleRegion().GetSize(i)) : 1;
+    }
+  }
 
-  if (structuralElementFlags & (Ball_Axial | Ball_Coronal | Ball_Sagital))
+  /** Writes the mask into a new image with the geometry of the source image, see RunLengthBinaryMorphology::Decode().
+   */
+  template <typename TPixel, unsigned int VDimension>
+  void WriteMask(const mitk::RunLengthBinaryMorphology::Mask &mask,
+                 const itk::Image<TPixel, VDimension> *sourceImage,
+                 mitk::Image::Pointer &resultImage)
   {
-    BallType ball = CreateStructuringElement<BallType>(structuralElementFlags, factor);
+    typedef itk::Image<TPixel, VDimension> ImageType;
+
+    typename ImageType::Pointer outputImage = ImageType::New();
+    outputImage->CopyInformation(sourceImage);
+    outputImage->SetRegions(sourceImage->GetLargestPossibleRegion());
+    outputImage->Allocate();
 
-    typename BallClosingFilterType::Pointer closingFilter = BallClosingFilterType::New();
-    closingFilter->SetKernel(ball);
-    closingFilter->SetInput(sourceImage);
-    closingFilter->SetForegroundValue(1);
-    closingFilter->UpdateLargestPossibleRegion();
+    mitk::RunLengthBinaryMorphology::Decode<TPixel>(
+      mask, sourceImage->GetBufferPointer(), outputImage->GetBufferPointer(), 1, 0);
 
-    mitk::CastToMitkImage(closingFilter->GetOutput(), resultImage);
+    mitk::CastToMitkImage(outputImage, resultImage);
   }
-  else
-  {
-    CrossType cross = CreateStructuringElement<CrossType>(structuralElementFlags, factor);
+}
 
-    typename CrossClosingFilterType::Pointer closingFilter = CrossClosingFilterType::New();
-    closingFilter->SetKernel(cross);
-    closingFilter->SetInput(sourceImage);
-    closingFilter->SetForegroundValue(1);
-    closingFilter->UpdateLargestPossibleRegion();
+void mitk::MorphologicalOperations::GetStructuringElementRadius(StructuralElementType structuralElementFlags,
+                                                                int factor,
+                                                                unsigned int dimension,
+                                                                int radius[3])
+{
+  radius[0] = radius[1] = radius[2] = 0;
+  switch (structuralElementFlags)
+  {
+    case Ball_Axial:
+    case Cross_Axial:
+      radius[0] = factor;
+      radius[1] = factor;
+      break;
+    case Ball_Coronal:
+    case Cross_Coronal:
+      radius[0] = factor;
+      radius[2] = factor;
+      break;
+    case Ball_Sagital:
+    case Cross_Sagital:
+      radius[1] = factor;
+      radius[2] = factor;
+      break;
+    case Ball:
+    case Cross:
+      radius[0] = radius[1] = radius[2] = factor;
+      break;
+  }
 
-    mitk::CastToMitkImage(closingFilter->GetOutput(), resultImage);
+  for (unsigned int i = dimension; i < 3; ++i)
+  {
+    radius[i] = 0;
   }
 }
 
+mitk::RunLengthBinaryMorphology::StructuringElementType mitk::MorphologicalOperations::CreateStructuringElement(
+  StructuralElementType structuralElementFlags, const int radius[3])
+{
+  if (structuralElementFlags & (Ball_Axial | Ball_Coronal | Ball_Sagital))
+    return RunLengthBinaryMorphology::CreateBall(radius);
+
+  return RunLengthBinaryMorphology::CreateCross(radius);
+}
+
 template <typename TPixel, unsigned int VDimension>
-void mitk::MorphologicalOperations::itkErode(
+void mitk::MorphologicalOperations::itkClosing(
   itk::Image<TPixel, VDimension> *sourceImage,
   mitk::Image::Pointer &resultImage,
   int factor,
   mitk::MorphologicalOperations::StructuralElementType structuralElementFlags)
 {
-  typedef itk::Image<TPixel, VDimension> ImageType;
-  typedef itk::BinaryBallStructuringElement<TPixel, VDimension> BallType;
-  typedef itk::BinaryCrossStructuringElement<TPixel, VDimension> CrossType;
-  typedef typename itk::BinaryErodeImageFilter<ImageType, ImageType, BallType> BallErodeFilterType;
-  typedef typename itk::BinaryErodeImageFilter<ImageType, ImageType, CrossType> CrossErodeFilterType;
-
-  if (structuralElementFlags & (Ball_Axial | Ball_Coronal | Ball_Sagital))
-  {
-    BallType ball = CreateStructuringElement<BallType>(structuralElementFlags, factor);
+  int size[3];
+  GetMaskSize(sourceImage, size);
+
+  int radius[3];
+  GetStructuringElementRadius(structuralElementFlags, factor, VDimension, radius);
+  RunLengthBinaryMorphology::StructuringElementType structuringElement =
+    CreateStructuringElement(structuralElementFlags, radius);
+
+  // pad by the radius so that objects at the image border are closed as well (like the safe border of
+  // itk::BinaryMorphologicalClosingImageFilter)
+  RunLengthBinaryMorphology::Mask mask =
+    RunLengthBinaryMorphology::Encode<TPixel>(sourceImage->GetBufferPointer(), size, 1);
+  mask = RunLengthBinaryMorphology::Pad(mask, radius);
+  mask = RunLengthBinaryMorphology::Dilate(mask, structuringElement);
+  mask = RunLengthBinaryMorphology::Erode(mask, structuringElement);
+  mask = RunLengthBinaryMorphology::Crop(mask, radius);
+
+  WriteMask(mask, sourceImage, resultImage);
+}
 
-    typename BallErodeFilterType::Pointer erodeFilter = BallErodeFilterType::New();
-    erodeFilter->SetKernel(ball);
-    erodeFilter->SetInput(sourceImage);
-    erodeFilter->SetErodeValue(1);
-    erodeFilter->UpdateLargestPossibleRegion();
+template <typename TPixel, unsigned int VDimension>
+void mitk::MorphologicalOperations::itkErode(
+  itk::Image<TPixel, VDimension> *sourceImage,
+  mitk::Image::Pointer &resultImage,
+  int factor,
+  mitk::MorphologicalOperations::StructuralElementType structuralElementFlags)
+{
+  int size[3];
+  GetMaskSize(sourceImage, size);
 
-    mitk::CastToMitkImage(erodeFilter->GetOutput(), resultImage);
-  }
-  else
-  {
-    CrossType cross = CreateStructuringElement<CrossType>(structuralElementFlags, factor);
+  int radius[3];
+  GetStructuringElementRadius(structuralElementFlags, factor, VDimension, radius);
 
-    typename CrossErodeFilterType::Pointer erodeFilter = CrossErodeFilterType::New();
-    erodeFilter->SetKernel(cross);
-    erodeFilter->SetInput(sourceImage);
-    erodeFilter->SetErodeValue(1);
-    erodeFilter->UpdateLargestPossibleRegion();
+  RunLengthBinaryMorphology::Mask mask =
+    RunLengthBinaryMorphology::Encode<TPixel>(sourceImage->GetBufferPointer(), size, 1);
+  mask = RunLengthBinaryMorphology::Erode(mask, CreateStructuringElement(structuralElementFlags, radius));
 
-    mitk::CastToMitkImage(erodeFilter->GetOutput(), resultImage);
-  }
+  WriteMask(mask, sourceImage, resultImage);
 }
 
 template <typename TPixel, unsigned int VDimension>
@@ -295,36 +334,17 @@ void mitk::MorphologicalOperations::itkDilate(
   int factor,
   mitk::MorphologicalOperations::StructuralElementType structuralElementFlags)
 {
-  typedef itk::Image<TPixel, VDimension> ImageType;
-  typedef itk::BinaryBallStructuringElement<TPixel, VDimension> BallType;
-  typedef itk::BinaryCrossStructuringElement<TPixel, VDimension> CrossType;
-  typedef typename itk::BinaryDilateImageFilter<ImageType, ImageType, BallType> BallDilateFilterType;
-  typedef typename itk::BinaryDilateImageFilter<ImageType, ImageType, CrossType> CrossDilateFilterType;
-
-  if (structuralElementFlags & (Ball_Axial | Ball_Coronal | Ball_Sagital))
-  {
-    BallType ball = CreateStructuringElement<BallType>(structuralElementFlags, factor);
+  int size[3];
+  GetMaskSize(sourceImage, size);
 
-    typename BallDilateFilterType::Pointer dilateFilter = BallDilateFilterType::New();
-    dilateFilter->SetKernel(ball);
-    dilateFilter->SetInput(sourceImage);
-    dilateFilter->SetDilateValue(1);
-    dilateFilter->UpdateLargestPossibleRegion();
+  int radius[3];
+  GetStructuringElementRadius(structuralElementFlags, factor, VDimension, radius);
 
-    mitk::CastToMitkImage(dilateFilter->GetOutput(), resultImage);
-  }
-  else
-  {
-    CrossType cross = CreateStructuringElement<CrossType>(structuralElementFlags, factor);
+  RunLengthBinaryMorphology::Mask mask =
+    RunLengthBinaryMorphology::Encode<TPixel>(sourceImage->GetBufferPointer(), size, 1);
+  mask = RunLengthBinaryMorphology::Dilate(mask, CreateStructuringElement(structuralElementFlags, radius));
 
-    typename CrossDilateFilterType::Pointer dilateFilter = CrossDilateFilterType::New();
-    dilateFilter->SetKernel(cross);
-    dilateFilter->SetInput(sourceImage);
-    dilateFilter->SetDilateValue(1);
-    dilateFilter->UpdateLargestPossibleRegion();
-
-    mitk::CastToMitkImage(dilateFilter->GetOutput(), resultImage);
-  }
+  WriteMask(mask, sourceImage, resultImage);
 }
 
 template <typename TPixel, unsigned int VDimension>
@@ -334,51 +354,32 @@ void mitk::MorphologicalOperations::itkOpening(
   int factor,
   mitk::MorphologicalOperations::StructuralElementType structuralElementFlags)
 {
-  typedef itk::Image<TPixel, VDimension> ImageType;
-  typedef itk::BinaryBallStructuringElement<TPixel, VDimension> BallType;
-  typedef itk::BinaryCrossStructuringElement<TPixel, VDimension> CrossType;
-  typedef typename itk::BinaryMorphologicalOpeningImageFilter<ImageType, ImageType, BallType> BallOpeningFiltertype;
-  typedef typename itk::BinaryMorphologicalOpeningImageFilter<ImageType, ImageType, CrossType> CrossOpeningFiltertype;
-
-  if (structuralElementFlags & (Ball_Axial | Ball_Coronal | Ball_Sagital))
-  {
-    BallType ball = CreateStructuringElement<BallType>(structuralElementFlags, factor);
+  int size[3];
+  GetMaskSize(sourceImage, size);
 
-    typename BallOpeningFiltertype::Pointer openingFilter = BallOpeningFiltertype::New();
-    openingFilter->SetKernel(ball);
-    openingFilter->SetInput(sourceImage);
-    openingFilter->SetForegroundValue(1);
-    openingFilter->SetBackgroundValue(0);
-    openingFilter->UpdateLargestPossibleRegion();
+  int radius[3];
+  GetStructuringElementRadius(structuralElementFlags, factor, VDimension, radius);
+  RunLengthBinaryMorphology::StructuringElementType structuringElement =
+    CreateStructuringElement(structuralElementFlags, radius);
 
-    mitk::CastToMitkImage(openingFilter->GetOutput(), resultImage);
-  }
-  else
-  {
-    CrossType cross = CreateStructuringElement<CrossType>(structuralElementFlags, factor);
-
-    typename CrossOpeningFiltertype::Pointer openingFilter = CrossOpeningFiltertype::New();
-    openingFilter->SetKernel(cross);
-    openingFilter->SetInput(sourceImage);
-    openingFilter->SetForegroundValue(1);
-    openingFilter->SetBackgroundValue(0);
-    openingFilter->UpdateLargestPossibleRegion();
+  RunLengthBinaryMorphology::Mask mask =
+    RunLengthBinaryMorphology::Encode<TPixel>(sourceImage->GetBufferPointer(), size, 1);
+  mask = RunLengthBinaryMorphology::Erode(mask, structuringElement);
+  mask = RunLengthBinaryMorphology::Dilate(mask, structuringElement);
 
-    mitk::CastToMitkImage(openingFilter->GetOutput(), resultImage);
-  }
+  WriteMask(mask, sourceImage, resultImage);
 }
 
 template <typename TPixel, unsigned int VDimension>
 void mitk::MorphologicalOperations::itkFillHoles(itk::Image<TPixel, VDimension> *sourceImage,
                                                  mitk::Image::Pointer &resultImage)
 {
-  typedef itk::Image<TPixel, VDimension> ImageType;
-  typedef typename itk::BinaryFillholeImageFilter<ImageType> FillHoleFilterType;
+  int size[3];
+  GetMaskSize(sourceImage, size);
 
-  typename FillHoleFilterType::Pointer fillHoleFilter = FillHoleFilterType::New();
-  fillHoleFilter->SetInput(sourceImage);
-  fillHoleFilter->SetForegroundValue(1);
-  fillHoleFilter->UpdateLargestPossibleRegion();
+  RunLengthBinaryMorphology::Mask mask =
+    RunLengthBinaryMorphology::Encode<TPixel>(sourceImage->GetBufferPointer(), size, 1);
+  mask = RunLengthBinaryMorphology::FillHoles(mask, VDimension);
 
-  mitk::CastToMitkImage(fillHoleFilter->GetOutput(), resultImage);
+  WriteMask(mask, sourceImage, resultImage);
 }
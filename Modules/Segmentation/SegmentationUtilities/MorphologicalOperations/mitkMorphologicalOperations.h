@@ -19,10 +19,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <MitkSegmentationExports.h>
 #include <mitkImage.h>
+#include <mitkRunLengthBinaryMorphology.h>
 
 namespace mitk
 {
   /** \brief Encapsulates several morphological operations that can be performed on segmentations.
+
+      Pixels with value 1 are foreground. The operations are computed by mitk::RunLengthBinaryMorphology and give the
+      same results as the ITK binary morphology filters with ball or cross structuring elements.
     */
   class MITKSEGMENTATION_EXPORT MorphologicalOperations
   {
@@ -54,42 +58,18 @@ namespace mitk
   private:
     MorphologicalOperations();
 
-    template <class TStructuringElement>
-    static TStructuringElement CreateStructuringElement(StructuralElementType structuralElementFlag, int factor)
-    {
-      TStructuringElement strElem;
-      typename TStructuringElement::SizeType size;
-      size.Fill(0);
-      switch (structuralElementFlag)
-      {
-        case Ball_Axial:
-        case Cross_Axial:
-          size.SetElement(0, factor);
-          size.SetElement(1, factor);
-          break;
-        case Ball_Coronal:
-        case Cross_Coronal:
-          size.SetElement(0, factor);
-          size.SetElement(2, factor);
-          break;
-        case Ball_Sagital:
-        case Cross_Sagital:
-          size.SetElement(1, factor);
-          size.SetElement(2, factor);
-          break;
-        case Ball:
-        case Cross:
-          size.Fill(factor);
-          break;
-      }
-
-      strElem.SetRadius(size);
-      strElem.CreateStructuringElement();
-      return strElem;
-    }
+    /** \brief Radius of the structuring element in each dimension, dimensions beyond the image dimension are 0.
+     */
+    static void GetStructuringElementRadius(StructuralElementType structuralElementFlags,
+                                            int factor,
+                                            unsigned int dimension,
+                                            int radius[3]);
+
+    static RunLengthBinaryMorphology::StructuringElementType CreateStructuringElement(
+      StructuralElementType structuralElementFlags, const int radius[3]);
 
     ///@{
-    /** \brief Perform morphological operation by using corresponding ITK filter.
+    /** \brief Perform morphological operation on the run-length encoded mask of the image.
      */
     template <typename TPixel, unsigned int VDimension>
     void static itkClosing(itk::Image<TPixel, VDimension> *sourceImage,
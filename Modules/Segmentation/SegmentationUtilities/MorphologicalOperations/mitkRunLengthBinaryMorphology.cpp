@@ -0,0 +1,400 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkRunLengthBinaryMorphology.h"
+
+#include <itkMultiThreader.h>
+
+#include <algorithm>
+#include <atomic>
+
+namespace
+{
+  struct ParallelForData
+  {
+    const std::function<void(int)> *Function;
+    int NumberOfSlices;
+    std::atomic<int> NextSlice;
+  };
+
+  ITK_THREAD_RETURN_TYPE ParallelForThreadCallback(void *arg)
+  {
+    typedef itk::MultiThreader::ThreadInfoStruct ThreadInfoType;
+    ParallelForData *data = static_cast<ParallelForData *>(static_cast<ThreadInfoType *>(arg)->UserData);
+
+    for (int z = data->NextSlice++; z < data->NumberOfSlices; z = data->NextSlice++)
+    {
+      (*data->Function)(z);
+    }
+
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  // union-find on run indices, the root of a set is its smallest index
+  std::size_t FindRoot(std::vector<std::size_t> &parents, std::size_t index)
+  {
+    while (parents[index] != index)
+    {
+      parents[index] = parents[parents[index]];
+      index = parents[index];
+    }
+    return index;
+  }
+
+  void Unite(std::vector<std::size_t> &parents, std::size_t a, std::size_t b)
+  {
+    a = FindRoot(parents, a);
+    b = FindRoot(parents, b);
+    if (a < b)
+      parents[b] = a;
+    else if (b < a)
+      parents[a] = b;
+  }
+
+  /** Unites all runs of two adjacent rows that share at least one column. */
+  void UniteOverlappingRuns(std::vector<std::size_t> &parents,
+                            const mitk::RunLengthBinaryMorphology::RowType &rowA,
+                            std::size_t firstIndexA,
+                            const mitk::RunLengthBinaryMorphology::RowType &rowB,
+                            std::size_t firstIndexB)
+  {
+    std::size_t a = 0;
+    std::size_t b = 0;
+    while (a < rowA.size() && b < rowB.size())
+    {
+      if (rowA[a].Begin < rowB[b].End && rowB[b].Begin < rowA[a].End)
+        Unite(parents, firstIndexA + a, firstIndexB + b);
+
+      if (rowA[a].End < rowB[b].End)
+        ++a;
+      else
+        ++b;
+    }
+  }
+}
+
+mitk::RunLengthBinaryMorphology::Mask::Mask(int sizeX, int sizeY, int sizeZ)
+  : m_Rows(static_cast<std::size_t>(sizeY) * sizeZ)
+{
+  m_Size[0] = sizeX;
+  m_Size[1] = sizeY;
+  m_Size[2] = sizeZ;
+}
+
+void mitk::RunLengthBinaryMorphology::ParallelForSlices(int numberOfSlices, const std::function<void(int)> &function)
+{
+  ParallelForData data;
+  data.Function = &function;
+  data.NumberOfSlices = numberOfSlices;
+  data.NextSlice = 0;
+
+  const int numberOfThreads =
+    std::min(numberOfSlices, static_cast<int>(itk::MultiThreader::GetGlobalDefaultNumberOfThreads()));
+  if (numberOfThreads <= 1)
+  {
+    for (int z = 0; z < numberOfSlices; ++z)
+      function(z);
+    return;
+  }
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(ParallelForThreadCallback, &data);
+  threader->SingleMethodExecute();
+}
+
+void mitk::RunLengthBinaryMorphology::MergeRuns(RowType &runs)
+{
+  if (runs.size() < 2)
+    return;
+
+  std::sort(runs.begin(), runs.end(), [](const Run &a, const Run &b) { return a.Begin < b.Begin; });
+
+  std::size_t last = 0;
+  for (std::size_t i = 1; i < runs.size(); ++i)
+  {
+    if (runs[i].Begin <= runs[last].End)
+    {
+      runs[last].End = std::max(runs[last].End, runs[i].End);
+    }
+    else
+    {
+      runs[++last] = runs[i];
+    }
+  }
+  runs.resize(last + 1);
+}
+
+mitk::RunLengthBinaryMorphology::StructuringElementType mitk::RunLengthBinaryMorphology::CreateBall(
+  const int radius[3])
+{
+  // same ellipsoid as itk::BinaryBallStructuringElement: pixel centers within the axes of length 2 * radius + 1
+  StructuringElementType structuringElement;
+  for (int dz = -radius[2]; dz <= radius[2]; ++dz)
+  {
+    for (int dy = -radius[1]; dy <= radius[1]; ++dy)
+    {
+      Line line;
+      line.DY = dy;
+      line.DZ = dz;
+      line.HalfWidth = -1;
+
+      for (int dx = 0; dx <= radius[0]; ++dx)
+      {
+        const double x = dx / (radius[0] + 0.5);
+        const double y = dy / (radius[1] + 0.5);
+        const double z = dz / (radius[2] + 0.5);
+        if (x * x + y * y + z * z <= 1.0)
+          line.HalfWidth = dx;
+      }
+
+      if (line.HalfWidth >= 0)
+        structuringElement.push_back(line);
+    }
+  }
+  return structuringElement;
+}
+
+mitk::RunLengthBinaryMorphology::StructuringElementType mitk::RunLengthBinaryMorphology::CreateCross(
+  const int radius[3])
+{
+  StructuringElementType structuringElement;
+
+  Line line = {0, 0, radius[0]};
+  structuringElement.push_back(line);
+
+  line.HalfWidth = 0;
+  for (int dy = -radius[1]; dy <= radius[1]; ++dy)
+  {
+    line.DY = dy;
+    if (dy != 0)
+      structuringElement.push_back(line);
+  }
+
+  line.DY = 0;
+  for (int dz = -radius[2]; dz <= radius[2]; ++dz)
+  {
+    line.DZ = dz;
+    if (dz != 0)
+      structuringElement.push_back(line);
+  }
+  return structuringElement;
+}
+
+mitk::RunLengthBinaryMorphology::Mask mitk::RunLengthBinaryMorphology::Dilate(
+  const Mask &mask, const StructuringElementType &structuringElement)
+{
+  const int sizeX = mask.GetSize(0);
+  const int sizeY = mask.GetSize(1);
+  const int sizeZ = mask.GetSize(2);
+  Mask result(sizeX, sizeY, sizeZ);
+
+  ParallelForSlices(sizeZ, [&](int z) {
+    for (int y = 0; y < sizeY; ++y)
+    {
+      RowType &resultRow = result.GetRow(y, z);
+
+      for (const Line &line : structuringElement)
+      {
+        const int sourceY = y - line.DY;
+        const int sourceZ = z - line.DZ;
+        if (sourceY < 0 || sourceY >= sizeY || sourceZ < 0 || sourceZ >= sizeZ)
+          continue;
+
+        for (const Run &run : mask.GetRow(sourceY, sourceZ))
+        {
+          Run dilatedRun;
+          dilatedRun.Begin = std::max(0, run.Begin - line.HalfWidth);
+          dilatedRun.End = std::min(sizeX, run.End + line.HalfWidth);
+          resultRow.push_back(dilatedRun);
+        }
+      }
+
+      MergeRuns(resultRow);
+    }
+  });
+
+  return result;
+}
+
+mitk::RunLengthBinaryMorphology::Mask mitk::RunLengthBinaryMorphology::Erode(
+  const Mask &mask, const StructuringElementType &structuringElement)
+{
+  // pixels outside of the mask are background in the complement, so they do not erode the mask
+  return Complement(Dilate(Complement(mask), structuringElement));
+}
+
+mitk::RunLengthBinaryMorphology::Mask mitk::RunLengthBinaryMorphology::Complement(const Mask &mask)
+{
+  const int sizeX = mask.GetSize(0);
+  const int sizeY = mask.GetSize(1);
+  Mask result(sizeX, sizeY, mask.GetSize(2));
+
+  ParallelForSlices(mask.GetSize(2), [&](int z) {
+    for (int y = 0; y < sizeY; ++y)
+    {
+      RowType &resultRow = result.GetRow(y, z);
+
+      Run gap;
+      gap.Begin = 0;
+      for (const Run &run : mask.GetRow(y, z))
+      {
+        if (run.Begin > gap.Begin)
+        {
+          gap.End = run.Begin;
+          resultRow.push_back(gap);
+        }
+        gap.Begin = run.End;
+      }
+      if (gap.Begin < sizeX)
+      {
+        gap.End = sizeX;
+        resultRow.push_back(gap);
+      }
+    }
+  });
+
+  return result;
+}
+
+mitk::RunLengthBinaryMorphology::Mask mitk::RunLengthBinaryMorphology::Pad(const Mask &mask, const int padding[3])
+{
+  Mask result(
+    mask.GetSize(0) + 2 * padding[0], mask.GetSize(1) + 2 * padding[1], mask.GetSize(2) + 2 * padding[2]);
+
+  ParallelForSlices(mask.GetSize(2), [&](int z) {
+    for (int y = 0; y < mask.GetSize(1); ++y)
+    {
+      RowType &resultRow = result.GetRow(y + padding[1], z + padding[2]);
+      resultRow = mask.GetRow(y, z);
+      for (Run &run : resultRow)
+      {
+        run.Begin += padding[0];
+        run.End += padding[0];
+      }
+    }
+  });
+
+  return result;
+}
+
+mitk::RunLengthBinaryMorphology::Mask mitk::RunLengthBinaryMorphology::Crop(const Mask &mask, const int padding[3])
+{
+  const int sizeX = mask.GetSize(0) - 2 * padding[0];
+  Mask result(sizeX, mask.GetSize(1) - 2 * padding[1], mask.GetSize(2) - 2 * padding[2]);
+
+  ParallelForSlices(result.GetSize(2), [&](int z) {
+    for (int y = 0; y < result.GetSize(1); ++y)
+    {
+      RowType &resultRow = result.GetRow(y, z);
+      for (const Run &run : mask.GetRow(y + padding[1], z + padding[2]))
+      {
+        Run croppedRun;
+        croppedRun.Begin = std::max(0, run.Begin - padding[0]);
+        croppedRun.End = std::min(sizeX, run.End - padding[0]);
+        if (croppedRun.Begin < croppedRun.End)
+          resultRow.push_back(croppedRun);
+      }
+    }
+  });
+
+  return result;
+}
+
+mitk::RunLengthBinaryMorphology::Mask mitk::RunLengthBinaryMorphology::FillHoles(const Mask &mask,
+                                                                                 unsigned int dimension)
+{
+  const int sizeX = mask.GetSize(0);
+  const int sizeY = mask.GetSize(1);
+  const int sizeZ = mask.GetSize(2);
+
+  // every background run is a node of the union-find, numbered row by row
+  const Mask background = Complement(mask);
+
+  std::vector<std::size_t> firstRunIndices(static_cast<std::size_t>(sizeY) * sizeZ + 1, 0);
+  for (int z = 0; z < sizeZ; ++z)
+  {
+    for (int y = 0; y < sizeY; ++y)
+    {
+      const std::size_t row = static_cast<std::size_t>(z) * sizeY + y;
+      firstRunIndices[row + 1] = firstRunIndices[row] + background.GetRow(y, z).size();
+    }
+  }
+
+  std::vector<std::size_t> parents(firstRunIndices.back());
+  for (std::size_t i = 0; i < parents.size(); ++i)
+    parents[i] = i;
+
+  auto firstRunIndex = [&](int y, int z) { return firstRunIndices[static_cast<std::size_t>(z) * sizeY + y]; };
+
+  // connect the runs within each slice in parallel, the slices use disjoint parts of the union-find
+  ParallelForSlices(sizeZ, [&](int z) {
+    for (int y = 1; y < sizeY; ++y)
+    {
+      UniteOverlappingRuns(
+        parents, background.GetRow(y, z), firstRunIndex(y, z), background.GetRow(y - 1, z), firstRunIndex(y - 1, z));
+    }
+  });
+
+  for (int z = 1; z < sizeZ; ++z)
+  {
+    for (int y = 0; y < sizeY; ++y)
+    {
+      UniteOverlappingRuns(
+        parents, background.GetRow(y, z), firstRunIndex(y, z), background.GetRow(y, z - 1), firstRunIndex(y, z - 1));
+    }
+  }
+
+  // flatten the union-find so that it can be read concurrently and mark all regions touching the border
+  std::vector<char> touchesBorder(parents.size(), 0);
+  for (int z = 0; z < sizeZ; ++z)
+  {
+    const bool borderSlice = dimension > 2 && (z == 0 || z == sizeZ - 1);
+    for (int y = 0; y < sizeY; ++y)
+    {
+      const RowType &row = background.GetRow(y, z);
+      const std::size_t firstIndex = firstRunIndex(y, z);
+      for (std::size_t i = 0; i < row.size(); ++i)
+      {
+        const std::size_t root = FindRoot(parents, firstIndex + i);
+        parents[firstIndex + i] = root;
+        if (borderSlice || y == 0 || y == sizeY - 1 || row[i].Begin == 0 || row[i].End == sizeX)
+          touchesBorder[root] = 1;
+      }
+    }
+  }
+
+  Mask result(sizeX, sizeY, sizeZ);
+  ParallelForSlices(sizeZ, [&](int z) {
+    for (int y = 0; y < sizeY; ++y)
+    {
+      RowType &resultRow = result.GetRow(y, z);
+      resultRow = mask.GetRow(y, z);
+
+      const RowType &row = background.GetRow(y, z);
+      const std::size_t firstIndex = firstRunIndex(y, z);
+      for (std::size_t i = 0; i < row.size(); ++i)
+      {
+        if (!touchesBorder[parents[firstIndex + i]])
+          resultRow.push_back(row[i]);
+      }
+
+      MergeRuns(resultRow);
+    }
+  });
+
+  return result;
+}
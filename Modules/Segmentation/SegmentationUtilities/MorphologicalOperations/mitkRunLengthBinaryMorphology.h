@@ -0,0 +1,164 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkRunLengthBinaryMorphology_h
+#define mitkRunLengthBinaryMorphology_h
+
+#include <MitkSegmentationExports.h>
+
+#include <functional>
+#include <vector>
+
+namespace mitk
+{
+  /** \brief Binary morphology on run-length encoded masks.
+
+    Masks are stored as one sorted list of foreground runs per row (first dimension). Structuring elements are
+    decomposed into lines along the rows, so dilating a row is a matter of widening and merging runs of the rows
+    covered by the element. Erosion is computed as the complement of the dilated complement. All operations run in
+    parallel over the slices (third dimension).
+
+    The semantics follow the ITK binary morphology filters: pixels outside of the mask are background for dilation
+    and foreground for erosion. Balls and crosses created by CreateBall() and CreateCross() are identical to
+    itk::BinaryBallStructuringElement and itk::BinaryCrossStructuringElement.
+  */
+  class MITKSEGMENTATION_EXPORT RunLengthBinaryMorphology
+  {
+  public:
+    /** \brief Foreground pixels [Begin, End) of a row. */
+    struct Run
+    {
+      int Begin;
+      int End;
+    };
+
+    typedef std::vector<Run> RowType;
+
+    /** \brief Binary mask of up to three dimensions. */
+    class MITKSEGMENTATION_EXPORT Mask
+    {
+    public:
+      Mask(int sizeX = 0, int sizeY = 1, int sizeZ = 1);
+
+      int GetSize(unsigned int i) const { return m_Size[i]; }
+
+      RowType &GetRow(int y, int z) { return m_Rows[static_cast<std::size_t>(z) * m_Size[1] + y]; }
+      const RowType &GetRow(int y, int z) const { return m_Rows[static_cast<std::size_t>(z) * m_Size[1] + y]; }
+
+    private:
+      int m_Size[3];
+      std::vector<RowType> m_Rows;
+    };
+
+    /** \brief Line of pixels [-HalfWidth, HalfWidth] along the rows, displaced by DY rows and DZ slices. */
+    struct Line
+    {
+      int DY;
+      int DZ;
+      int HalfWidth;
+    };
+
+    typedef std::vector<Line> StructuringElementType;
+
+    static StructuringElementType CreateBall(const int radius[3]);
+    static StructuringElementType CreateCross(const int radius[3]);
+
+    static Mask Dilate(const Mask &mask, const StructuringElementType &structuringElement);
+    static Mask Erode(const Mask &mask, const StructuringElementType &structuringElement);
+    static Mask Complement(const Mask &mask);
+
+    /** \brief Adds the given number of background pixels on both sides of each dimension. */
+    static Mask Pad(const Mask &mask, const int padding[3]);
+    static Mask Crop(const Mask &mask, const int padding[3]);
+
+    /** \brief Fills background regions that are not face connected to the border of the mask.
+
+      For two-dimensional masks the first and last slice are not treated as border.
+    */
+    static Mask FillHoles(const Mask &mask, unsigned int dimension);
+
+    /** \brief Encodes all pixels equal to the foreground value. */
+    template <typename TPixel>
+    static Mask Encode(const TPixel *buffer, const int size[3], TPixel foregroundValue)
+    {
+      Mask mask(size[0], size[1], size[2]);
+      ParallelForSlices(size[2], [&](int z) {
+        for (int y = 0; y < size[1]; ++y)
+        {
+          const TPixel *row = buffer + (static_cast<std::size_t>(z) * size[1] + y) * size[0];
+          RowType &runs = mask.GetRow(y, z);
+          for (int x = 0; x < size[0];)
+          {
+            if (row[x] != foregroundValue)
+            {
+              ++x;
+              continue;
+            }
+
+            Run run;
+            run.Begin = x;
+            while (x < size[0] && row[x] == foregroundValue)
+              ++x;
+            run.End = x;
+            runs.push_back(run);
+          }
+        }
+      });
+      return mask;
+    }
+
+    /** \brief Writes the foreground value for mask pixels. Other pixels keep their input value, unless they were
+      foreground in the input, then they are set to the background value.
+    */
+    template <typename TPixel>
+    static void Decode(
+      const Mask &mask, const TPixel *input, TPixel *output, TPixel foregroundValue, TPixel backgroundValue)
+    {
+      const int sizeX = mask.GetSize(0);
+      const int sizeY = mask.GetSize(1);
+      ParallelForSlices(mask.GetSize(2), [&](int z) {
+        for (int y = 0; y < sizeY; ++y)
+        {
+          const std::size_t rowOffset = (static_cast<std::size_t>(z) * sizeY + y) * sizeX;
+          const TPixel *inputRow = input + rowOffset;
+          TPixel *outputRow = output + rowOffset;
+
+          int x = 0;
+          for (const Run &run : mask.GetRow(y, z))
+          {
+            for (; x < run.Begin; ++x)
+              outputRow[x] = inputRow[x] == foregroundValue ? backgroundValue : inputRow[x];
+            for (; x < run.End; ++x)
+              outputRow[x] = foregroundValue;
+          }
+          for (; x < sizeX; ++x)
+            outputRow[x] = inputRow[x] == foregroundValue ? backgroundValue : inputRow[x];
+        }
+      });
+    }
+
+  private:
+    RunLengthBinaryMorphology();
+
+    /** \brief Calls the function for each slice, distributing the slices over all threads. */
+    static void ParallelForSlices(int numberOfSlices, const std::function<void(int)> &function);
+
+    /** \brief Sorts the runs and merges overlapping or touching ones. */
+    static void MergeRuns(RowType &runs);
+  };
+}
+
+#endif
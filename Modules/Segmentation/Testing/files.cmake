@@ -4,10 +4,14 @@ set(MODULE_TESTS
   mitkContourModelSetToImageFilterTest.cpp
   mitkDataNodeSegmentationTest.cpp
   mitkFeatureBasedEdgeDetectionFilterTest.cpp
+  mitkIncrementalFastMarchingTest.cpp
+  mitkMorphologicalOperationsTest.cpp
   mitkImageToContourFilterTest.cpp
   mitkSegmentationInterpolationTest.cpp
   mitkOverwriteSliceFilterTest.cpp
   mitkOverwriteSliceFilterObliquePlaneTest.cpp
+  mitkScanlineFloodFillImageFilterTest.cpp
+  mitkConnectedAdaptiveThresholdImageFilterTest.cpp
 #  mitkToolManagerTest.cpp
   mitkToolManagerProviderTest.cpp
   mitkManualSegmentationToSurfaceFilterTest.cpp #new cpp unit style
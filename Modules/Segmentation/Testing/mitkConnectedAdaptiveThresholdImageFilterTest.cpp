@@ -0,0 +1,179 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include <mitkTestFixture.h>
+
+#include <itkAdaptiveThresholdIterator.h>
+#include <itkBinaryThresholdImageFunction.h>
+#include <itkConnectedAdaptiveThresholdImageFilter.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+class mitkConnectedAdaptiveThresholdImageFilterTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkConnectedAdaptiveThresholdImageFilterTestSuite);
+  MITK_TEST(testRawSegmentationUpwardsSameResultAsIterator);
+  MITK_TEST(testRawSegmentationDownwardsSameResultAsIterator);
+  MITK_TEST(testRawSegmentationSingleThreaded);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  typedef itk::Image<short, 3> ImageType;
+  typedef itk::ConnectedAdaptiveThresholdImageFilter<ImageType, ImageType> FilterType;
+  typedef itk::BinaryThresholdImageFunction<ImageType> FunctionType;
+  typedef itk::AdaptiveThresholdIterator<ImageType, FunctionType> IteratorType;
+
+  /** Members used inside the different test methods. All members are initialized via setUp().*/
+  ImageType::Pointer m_Image;
+  ImageType::IndexType m_Seed;
+  int m_Lower;
+  int m_Upper;
+
+  /** Counts differing pixels, the labels of both segmentations must match voxel by voxel. */
+  static unsigned int CountDifferences(ImageType *a, ImageType *b)
+  {
+    itk::ImageRegionConstIterator<ImageType> itA(a, a->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<ImageType> itB(b, b->GetLargestPossibleRegion());
+    unsigned int differences = 0;
+    for (itA.GoToBegin(), itB.GoToBegin(); !itA.IsAtEnd(); ++itA, ++itB)
+    {
+      if (itA.Get() != itB.Get())
+        ++differences;
+    }
+    return differences;
+  }
+
+  static unsigned int CountSegmentedVoxels(ImageType *image)
+  {
+    itk::ImageRegionConstIterator<ImageType> it(image, image->GetLargestPossibleRegion());
+    unsigned int count = 0;
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+      if (it.Get() != 0)
+        ++count;
+    }
+    return count;
+  }
+
+  /** The raw segmentation as computed by the former implementation, level by level with the adaptive iterator. */
+  ImageType::Pointer SegmentWithIterator(bool upwards, int &leakagePoint)
+  {
+    ImageType::Pointer output = ImageType::New();
+    output->SetRegions(m_Image->GetLargestPossibleRegion());
+    output->Allocate();
+
+    FunctionType::Pointer function = FunctionType::New();
+    function->SetInputImage(m_Image);
+
+    std::vector<ImageType::IndexType> seeds(1, m_Seed);
+    IteratorType it(output, function, seeds);
+    it.SetFineDetectionMode(false);
+    it.SetExpansionDirection(upwards);
+    it.SetMinTH(m_Lower);
+    it.SetMaxTH(m_Upper);
+    it.GoToBegin();
+    while (!it.IsAtEnd())
+    {
+      ++it;
+    }
+    leakagePoint = it.GetLeakagePoint();
+    return output;
+  }
+
+  FilterType::Pointer SegmentWithFilter(bool upwards, unsigned int numberOfThreads = 0)
+  {
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetInput(m_Image);
+    filter->AddSeed(m_Seed);
+    filter->SetLower(m_Lower);
+    filter->SetUpper(m_Upper);
+    filter->SetGrowingDirectionIsUpwards(upwards);
+    filter->SetFineDetectionMode(false);
+    if (numberOfThreads > 0)
+      filter->SetNumberOfThreads(numberOfThreads);
+    filter->Update();
+    return filter;
+  }
+
+  void CheckSameResultAsIterator(bool upwards, unsigned int numberOfThreads = 0)
+  {
+    int leakagePoint = 0;
+    ImageType::Pointer reference = SegmentWithIterator(upwards, leakagePoint);
+    FilterType::Pointer filter = SegmentWithFilter(upwards, numberOfThreads);
+
+    CPPUNIT_ASSERT_MESSAGE("Segmentation was cancelled", !filter->m_SegmentationCancelled);
+    CPPUNIT_ASSERT_MESSAGE("Reference segmentation does not grow beyond the seed",
+                           CountSegmentedVoxels(reference) > 1);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Labels differ from the adaptive threshold iterator",
+                                 0u,
+                                 CountDifferences(filter->GetOutput(), reference));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Leakage point differs from the adaptive threshold iterator",
+                                 leakagePoint,
+                                 (int)filter->GetLeakagePoint());
+  }
+
+public:
+  /**
+   * @brief Creates a test volume with a tube of varying intensity in a noisy background. A brighter tube branches off,
+   * so that the region grows faster at some levels than at others.
+   */
+  void setUp()
+  {
+    ImageType::SizeType size;
+    size.Fill(64);
+    ImageType::RegionType region(size);
+
+    m_Image = ImageType::New();
+    m_Image->SetRegions(region);
+    m_Image->Allocate();
+
+    const double radius = 5.0;
+    itk::ImageRegionIteratorWithIndex<ImageType> it(m_Image, region);
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+      const ImageType::IndexType index = it.GetIndex();
+      short value = static_cast<short>((index[0] * 7 + index[1] * 13 + index[2] * 17) % 50);
+
+      const double dx = index[0] - 32.0;
+      const double dy = index[1] - 32.0;
+      if (dx * dx + dy * dy <= radius * radius)
+        value = static_cast<short>(200 + (index[0] * 3 + index[1] * 5 + index[2] * 11) % 60);
+
+      // branch along x starting in the middle of the tube
+      const double dz = index[2] - 32.0;
+      if (index[0] > 32 && dy * dy + dz * dz <= radius * radius)
+        value = static_cast<short>(280 + (index[0] * 11 + index[1] * 3 + index[2] * 5) % 40);
+
+      it.Set(value);
+    }
+
+    m_Seed.Fill(32);
+    m_Seed[2] = 5;
+    m_Lower = 150;
+    m_Upper = 400;
+  }
+
+  void tearDown() { m_Image = nullptr; }
+
+  void testRawSegmentationUpwardsSameResultAsIterator() { CheckSameResultAsIterator(true); }
+
+  void testRawSegmentationDownwardsSameResultAsIterator() { CheckSameResultAsIterator(false); }
+
+  void testRawSegmentationSingleThreaded() { CheckSameResultAsIterator(true, 1); }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkConnectedAdaptiveThresholdImageFilter)
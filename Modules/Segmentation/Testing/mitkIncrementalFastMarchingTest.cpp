@@ -0,0 +1,155 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include <mitkTestFixture.h>
+
+#include <itkFastMarchingImageFilter.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkIncrementalFastMarching.h>
+
+class mitkIncrementalFastMarchingTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkIncrementalFastMarchingTestSuite);
+  MITK_TEST(testSameResultAsFastMarchingImageFilter);
+  MITK_TEST(testResumedMarch);
+  MITK_TEST(testAddSeed);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  typedef itk::Image<float, 3> ImageType;
+  typedef itk::FastMarchingImageFilter<ImageType, ImageType> FastMarchingFilterType;
+  typedef itk::IncrementalFastMarching<ImageType> IncrementalFastMarchingType;
+
+  /** Members used inside the different test methods. All members are initialized via setUp().*/
+  ImageType::Pointer m_SpeedImage;
+  ImageType::IndexType m_FirstSeed;
+  ImageType::IndexType m_SecondSeed;
+  double m_StoppingValue;
+
+  ImageType::Pointer ComputeReference(bool withSecondSeed)
+  {
+    FastMarchingFilterType::NodeContainer::Pointer seeds = FastMarchingFilterType::NodeContainer::New();
+    seeds->Initialize();
+
+    FastMarchingFilterType::NodeType node;
+    node.SetValue(0.0);
+    node.SetIndex(m_FirstSeed);
+    seeds->InsertElement(0, node);
+    if (withSecondSeed)
+    {
+      node.SetIndex(m_SecondSeed);
+      seeds->InsertElement(1, node);
+    }
+
+    FastMarchingFilterType::Pointer filter = FastMarchingFilterType::New();
+    filter->SetInput(m_SpeedImage);
+    filter->SetTrialPoints(seeds);
+    filter->SetStoppingValue(m_StoppingValue);
+    filter->Update();
+    return filter->GetOutput();
+  }
+
+  /** Compares all arrival times up to the stopping value. */
+  void CompareArrivalTimes(ImageType *result, ImageType *reference)
+  {
+    itk::ImageRegionConstIterator<ImageType> itResult(result, result->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<ImageType> itReference(reference, reference->GetLargestPossibleRegion());
+    unsigned int numberOfReachedPixels = 0;
+    for (itResult.GoToBegin(), itReference.GoToBegin(); !itResult.IsAtEnd(); ++itResult, ++itReference)
+    {
+      if (itReference.Get() > m_StoppingValue && itResult.Get() > m_StoppingValue)
+        continue;
+
+      ++numberOfReachedPixels;
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(itReference.Get(), itResult.Get(), 1e-3);
+    }
+    CPPUNIT_ASSERT_MESSAGE("Front has been propagated", numberOfReachedPixels > 1);
+  }
+
+public:
+  /**
+   * @brief Creates a speed image with varying speed and anisotropic spacing.
+   */
+  void setUp()
+  {
+    ImageType::SizeType size;
+    size.Fill(40);
+    ImageType::SpacingType spacing;
+    spacing[0] = 1.0;
+    spacing[1] = 0.8;
+    spacing[2] = 2.0;
+
+    m_SpeedImage = ImageType::New();
+    m_SpeedImage->SetRegions(ImageType::RegionType(size));
+    m_SpeedImage->SetSpacing(spacing);
+    m_SpeedImage->Allocate();
+
+    itk::ImageRegionIteratorWithIndex<ImageType> it(m_SpeedImage, m_SpeedImage->GetLargestPossibleRegion());
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+      const ImageType::IndexType index = it.GetIndex();
+      it.Set(0.2f + 0.8f * ((index[0] * 7 + index[1] * 3 + index[2] * 5) % 11) / 10.0f);
+    }
+
+    m_FirstSeed.Fill(10);
+    m_SecondSeed.Fill(28);
+    m_StoppingValue = 20.0;
+  }
+
+  void tearDown() { m_SpeedImage = nullptr; }
+
+  void testSameResultAsFastMarchingImageFilter()
+  {
+    IncrementalFastMarchingType::Pointer fastMarching = IncrementalFastMarchingType::New();
+    fastMarching->SetSpeedImage(m_SpeedImage);
+    fastMarching->AddSeed(m_FirstSeed);
+    fastMarching->AddSeed(m_SecondSeed);
+    fastMarching->March(m_StoppingValue);
+
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(m_StoppingValue, fastMarching->GetMarchedLimit(), 1e-12);
+    this->CompareArrivalTimes(fastMarching->GetArrivalTimeImage(), this->ComputeReference(true));
+  }
+
+  void testResumedMarch()
+  {
+    IncrementalFastMarchingType::Pointer fastMarching = IncrementalFastMarchingType::New();
+    fastMarching->SetSpeedImage(m_SpeedImage);
+    fastMarching->AddSeed(m_FirstSeed);
+    fastMarching->March(m_StoppingValue / 4);
+    fastMarching->March(m_StoppingValue / 2);
+    fastMarching->March(m_StoppingValue);
+
+    this->CompareArrivalTimes(fastMarching->GetArrivalTimeImage(), this->ComputeReference(false));
+  }
+
+  void testAddSeed()
+  {
+    IncrementalFastMarchingType::Pointer fastMarching = IncrementalFastMarchingType::New();
+    fastMarching->SetSpeedImage(m_SpeedImage);
+    fastMarching->AddSeed(m_FirstSeed);
+    fastMarching->March(m_StoppingValue);
+
+    fastMarching->AddSeed(m_SecondSeed);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, fastMarching->GetMarchedLimit(), 1e-12);
+    fastMarching->March(m_StoppingValue);
+
+    this->CompareArrivalTimes(fastMarching->GetArrivalTimeImage(), this->ComputeReference(true));
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkIncrementalFastMarching)
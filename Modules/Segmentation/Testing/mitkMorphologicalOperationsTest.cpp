@@ -0,0 +1,226 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include <mitkTestFixture.h>
+
+#include <mitkImageCast.h>
+#include <mitkMorphologicalOperations.h>
+
+#include <itkBinaryBallStructuringElement.h>
+#include <itkBinaryCrossStructuringElement.h>
+#include <itkBinaryDilateImageFilter.h>
+#include <itkBinaryErodeImageFilter.h>
+#include <itkBinaryFillholeImageFilter.h>
+#include <itkBinaryMorphologicalClosingImageFilter.h>
+#include <itkBinaryMorphologicalOpeningImageFilter.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+class mitkMorphologicalOperationsTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkMorphologicalOperationsTestSuite);
+  MITK_TEST(testDilate);
+  MITK_TEST(testErode);
+  MITK_TEST(testClosing);
+  MITK_TEST(testOpening);
+  MITK_TEST(testAxialElements);
+  MITK_TEST(testFillHoles);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  typedef itk::Image<unsigned char, 3> ImageType;
+  typedef itk::BinaryBallStructuringElement<unsigned char, 3> BallType;
+  typedef itk::BinaryCrossStructuringElement<unsigned char, 3> CrossType;
+
+  /** Members used inside the different test methods. All members are initialized via setUp().*/
+  ImageType::Pointer m_Mask;
+
+  template <class TStructuringElement>
+  static TStructuringElement CreateStructuringElement(unsigned int rx, unsigned int ry, unsigned int rz)
+  {
+    typename TStructuringElement::SizeType radius;
+    radius[0] = rx;
+    radius[1] = ry;
+    radius[2] = rz;
+
+    TStructuringElement structuringElement;
+    structuringElement.SetRadius(radius);
+    structuringElement.CreateStructuringElement();
+    return structuringElement;
+  }
+
+  mitk::Image::Pointer GetMitkMask()
+  {
+    mitk::Image::Pointer image;
+    mitk::CastToMitkImage(m_Mask, image);
+    return image;
+  }
+
+  /** Checks that the result of MorphologicalOperations equals the reference computed with the ITK filter. */
+  void CompareWithReference(mitk::Image *result, ImageType *reference, const std::string &message)
+  {
+    ImageType::Pointer resultAsITK;
+    mitk::CastToItkImage(result, resultAsITK);
+
+    itk::ImageRegionConstIterator<ImageType> itResult(resultAsITK, resultAsITK->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<ImageType> itReference(reference, reference->GetLargestPossibleRegion());
+    unsigned int differences = 0;
+    for (itResult.GoToBegin(), itReference.GoToBegin(); !itResult.IsAtEnd(); ++itResult, ++itReference)
+    {
+      if (itResult.Get() != itReference.Get())
+        ++differences;
+    }
+    CPPUNIT_ASSERT_EQUAL_MESSAGE(message, 0u, differences);
+  }
+
+  template <class TStructuringElement>
+  ImageType::Pointer ITKDilate(const TStructuringElement &structuringElement)
+  {
+    typedef itk::BinaryDilateImageFilter<ImageType, ImageType, TStructuringElement> FilterType;
+    typename FilterType::Pointer filter = FilterType::New();
+    filter->SetKernel(structuringElement);
+    filter->SetInput(m_Mask);
+    filter->SetDilateValue(1);
+    filter->Update();
+    return filter->GetOutput();
+  }
+
+  template <class TStructuringElement>
+  ImageType::Pointer ITKErode(const TStructuringElement &structuringElement)
+  {
+    typedef itk::BinaryErodeImageFilter<ImageType, ImageType, TStructuringElement> FilterType;
+    typename FilterType::Pointer filter = FilterType::New();
+    filter->SetKernel(structuringElement);
+    filter->SetInput(m_Mask);
+    filter->SetErodeValue(1);
+    filter->Update();
+    return filter->GetOutput();
+  }
+
+public:
+  /**
+   * @brief Creates a mask touching the image border with a cavity, small holes and noise.
+   */
+  void setUp()
+  {
+    ImageType::SizeType size;
+    size[0] = 40;
+    size[1] = 36;
+    size[2] = 24;
+
+    m_Mask = ImageType::New();
+    m_Mask->SetRegions(ImageType::RegionType(size));
+    m_Mask->Allocate();
+
+    itk::ImageRegionIteratorWithIndex<ImageType> it(m_Mask, m_Mask->GetLargestPossibleRegion());
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+      const ImageType::IndexType index = it.GetIndex();
+      const double dx = index[0] - 24.0;
+      const double dy = index[1] - 18.0;
+      const double dz = index[2] - 12.0;
+      const double distance = dx * dx + dy * dy + dz * dz;
+
+      bool foreground = distance < 17.0 * 17.0 && distance > 4.0 * 4.0;
+      if ((index[0] * 7 + index[1] * 13 + index[2] * 29) % 23 == 0)
+        foreground = !foreground;
+
+      it.Set(foreground ? 1 : 0);
+    }
+  }
+
+  void tearDown() { m_Mask = nullptr; }
+
+  void testDilate()
+  {
+    mitk::Image::Pointer ball = this->GetMitkMask();
+    mitk::MorphologicalOperations::Dilate(ball, 3, mitk::MorphologicalOperations::Ball);
+    this->CompareWithReference(ball, this->ITKDilate(CreateStructuringElement<BallType>(3, 3, 3)), "Dilate ball");
+
+    mitk::Image::Pointer cross = this->GetMitkMask();
+    mitk::MorphologicalOperations::Dilate(cross, 2, mitk::MorphologicalOperations::Cross);
+    this->CompareWithReference(cross, this->ITKDilate(CreateStructuringElement<CrossType>(2, 2, 2)), "Dilate cross");
+  }
+
+  void testErode()
+  {
+    mitk::Image::Pointer ball = this->GetMitkMask();
+    mitk::MorphologicalOperations::Erode(ball, 2, mitk::MorphologicalOperations::Ball);
+    this->CompareWithReference(ball, this->ITKErode(CreateStructuringElement<BallType>(2, 2, 2)), "Erode ball");
+
+    mitk::Image::Pointer cross = this->GetMitkMask();
+    mitk::MorphologicalOperations::Erode(cross, 3, mitk::MorphologicalOperations::Cross);
+    this->CompareWithReference(cross, this->ITKErode(CreateStructuringElement<CrossType>(3, 3, 3)), "Erode cross");
+  }
+
+  void testClosing()
+  {
+    typedef itk::BinaryMorphologicalClosingImageFilter<ImageType, ImageType, BallType> FilterType;
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetKernel(CreateStructuringElement<BallType>(4, 4, 4));
+    filter->SetInput(m_Mask);
+    filter->SetForegroundValue(1);
+    filter->Update();
+
+    mitk::Image::Pointer image = this->GetMitkMask();
+    mitk::MorphologicalOperations::Closing(image, 4, mitk::MorphologicalOperations::Ball);
+    this->CompareWithReference(image, filter->GetOutput(), "Closing ball");
+  }
+
+  void testOpening()
+  {
+    typedef itk::BinaryMorphologicalOpeningImageFilter<ImageType, ImageType, CrossType> FilterType;
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetKernel(CreateStructuringElement<CrossType>(2, 2, 2));
+    filter->SetInput(m_Mask);
+    filter->SetForegroundValue(1);
+    filter->SetBackgroundValue(0);
+    filter->Update();
+
+    mitk::Image::Pointer image = this->GetMitkMask();
+    mitk::MorphologicalOperations::Opening(image, 2, mitk::MorphologicalOperations::Cross);
+    this->CompareWithReference(image, filter->GetOutput(), "Opening cross");
+  }
+
+  void testAxialElements()
+  {
+    mitk::Image::Pointer ball = this->GetMitkMask();
+    mitk::MorphologicalOperations::Dilate(ball, 3, mitk::MorphologicalOperations::Ball_Sagital);
+    this->CompareWithReference(
+      ball, this->ITKDilate(CreateStructuringElement<BallType>(0, 3, 3)), "Dilate sagittal ball");
+
+    mitk::Image::Pointer cross = this->GetMitkMask();
+    mitk::MorphologicalOperations::Erode(cross, 2, mitk::MorphologicalOperations::Cross_Coronal);
+    this->CompareWithReference(
+      cross, this->ITKErode(CreateStructuringElement<CrossType>(2, 0, 2)), "Erode coronal cross");
+  }
+
+  void testFillHoles()
+  {
+    typedef itk::BinaryFillholeImageFilter<ImageType> FilterType;
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetInput(m_Mask);
+    filter->SetForegroundValue(1);
+    filter->Update();
+
+    mitk::Image::Pointer image = this->GetMitkMask();
+    mitk::MorphologicalOperations::FillHoles(image);
+    this->CompareWithReference(image, filter->GetOutput(), "Fill holes");
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkMorphologicalOperations)
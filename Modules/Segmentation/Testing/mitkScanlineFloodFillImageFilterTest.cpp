@@ -0,0 +1,185 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include <mitkTestFixture.h>
+
+#include <itkConnectedThresholdImageFilter.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkScanlineFloodFillImageFilter.h>
+#include <itkTimeProbe.h>
+
+class mitkScanlineFloodFillImageFilterTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkScanlineFloodFillImageFilterTestSuite);
+  MITK_TEST(testSameResultAsConnectedThreshold);
+  MITK_TEST(testSingleThreaded);
+  MITK_TEST(testPixelBudget);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  typedef itk::Image<short, 3> ImageType;
+  typedef itk::Image<unsigned char, 3> MaskImageType;
+  typedef itk::ScanlineFloodFillImageFilter<ImageType, MaskImageType> FloodFillFilterType;
+  typedef itk::ConnectedThresholdImageFilter<ImageType, MaskImageType> ConnectedThresholdFilterType;
+
+  /** Members used inside the different test methods. All members are initialized via setUp().*/
+  ImageType::Pointer m_Image;
+  ImageType::IndexType m_Seed;
+
+  /** Counts differing pixels, the output of the flood fill must match the reference voxel by voxel. */
+  static unsigned int CountDifferences(MaskImageType *a, MaskImageType *b)
+  {
+    itk::ImageRegionConstIterator<MaskImageType> itA(a, a->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<MaskImageType> itB(b, b->GetLargestPossibleRegion());
+    unsigned int differences = 0;
+    for (itA.GoToBegin(), itB.GoToBegin(); !itA.IsAtEnd(); ++itA, ++itB)
+    {
+      if ((itA.Get() != 0) != (itB.Get() != 0))
+        ++differences;
+    }
+    return differences;
+  }
+
+public:
+  /**
+   * @brief Creates a vessel-like test volume: a noisy background with a tree of bright tubes that branch along the
+   * z-axis, so that the region has many spans and a long, thin shape.
+   */
+  void setUp()
+  {
+    ImageType::SizeType size;
+    size.Fill(160);
+    ImageType::RegionType region(size);
+
+    m_Image = ImageType::New();
+    m_Image->SetRegions(region);
+    m_Image->Allocate();
+
+    const double radius = 4.0;
+    itk::ImageRegionIteratorWithIndex<ImageType> it(m_Image, region);
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+      const ImageType::IndexType index = it.GetIndex();
+      const double z = index[2];
+      short value = static_cast<short>((index[0] * 7 + index[1] * 13 + index[2] * 17) % 50);
+
+      // trunk along z with two levels of branches whose centers drift apart with increasing z
+      for (int branch = 0; branch < 4; ++branch)
+      {
+        const double spread = z < 40 ? 0.0 : (z - 40) * 0.25;
+        const double cx = 80 + ((branch & 1) ? spread : -spread);
+        const double cy = 80 + (z < 90 ? 0.0 : (z - 90) * 0.3) * ((branch & 2) ? 1 : -1);
+        const double dx = index[0] - cx;
+        const double dy = index[1] - cy;
+        if (dx * dx + dy * dy <= radius * radius)
+          value = 300;
+      }
+      it.Set(value);
+    }
+
+    m_Seed.Fill(80);
+    m_Seed[2] = 5;
+  }
+
+  void tearDown() { m_Image = nullptr; }
+
+  void testSameResultAsConnectedThreshold()
+  {
+    itk::TimeProbe referenceProbe;
+    ConnectedThresholdFilterType::Pointer reference = ConnectedThresholdFilterType::New();
+    reference->SetInput(m_Image);
+    reference->SetSeed(m_Seed);
+    reference->SetLower(200);
+    reference->SetUpper(400);
+    reference->SetReplaceValue(1);
+    referenceProbe.Start();
+    reference->Update();
+    referenceProbe.Stop();
+
+    itk::TimeProbe floodFillProbe;
+    FloodFillFilterType::Pointer floodFill = FloodFillFilterType::New();
+    floodFill->SetInput(m_Image);
+    floodFill->SetSeed(m_Seed);
+    floodFill->SetLower(200);
+    floodFill->SetUpper(400);
+    floodFill->SetReplaceValue(1);
+    floodFillProbe.Start();
+    floodFill->Update();
+    floodFillProbe.Stop();
+
+    MITK_INFO << "ConnectedThresholdImageFilter: " << referenceProbe.GetTotal() << " s, ScanlineFloodFillImageFilter ("
+              << floodFill->GetNumberOfThreads() << " threads): " << floodFillProbe.GetTotal() << " s";
+
+    CPPUNIT_ASSERT_MESSAGE("Region is not empty", floodFill->GetNumberOfFilledPixels() > 0);
+    CPPUNIT_ASSERT_MESSAGE("Budget is not exceeded without a budget", !floodFill->GetBudgetExceeded());
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Flood fill matches ConnectedThresholdImageFilter",
+                                 0u,
+                                 CountDifferences(floodFill->GetOutput(), reference->GetOutput()));
+  }
+
+  void testSingleThreaded()
+  {
+    FloodFillFilterType::Pointer multiThreaded = FloodFillFilterType::New();
+    multiThreaded->SetInput(m_Image);
+    multiThreaded->SetSeed(m_Seed);
+    multiThreaded->SetLower(200);
+    multiThreaded->SetUpper(400);
+    multiThreaded->Update();
+
+    FloodFillFilterType::Pointer singleThreaded = FloodFillFilterType::New();
+    singleThreaded->SetInput(m_Image);
+    singleThreaded->SetSeed(m_Seed);
+    singleThreaded->SetLower(200);
+    singleThreaded->SetUpper(400);
+    singleThreaded->SetNumberOfThreads(1);
+    singleThreaded->Update();
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Thread count does not change the number of filled pixels",
+                                 multiThreaded->GetNumberOfFilledPixels(),
+                                 singleThreaded->GetNumberOfFilledPixels());
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Thread count does not change the result",
+                                 0u,
+                                 CountDifferences(multiThreaded->GetOutput(), singleThreaded->GetOutput()));
+  }
+
+  void testPixelBudget()
+  {
+    FloodFillFilterType::Pointer unlimited = FloodFillFilterType::New();
+    unlimited->SetInput(m_Image);
+    unlimited->SetSeed(m_Seed);
+    unlimited->SetLower(200);
+    unlimited->SetUpper(400);
+    unlimited->Update();
+
+    const itk::SizeValueType budget = unlimited->GetNumberOfFilledPixels() / 10;
+
+    FloodFillFilterType::Pointer limited = FloodFillFilterType::New();
+    limited->SetInput(m_Image);
+    limited->SetSeed(m_Seed);
+    limited->SetLower(200);
+    limited->SetUpper(400);
+    limited->SetMaximumNumberOfPixels(budget);
+    limited->Update();
+
+    CPPUNIT_ASSERT_MESSAGE("Budget is reported as exceeded", limited->GetBudgetExceeded());
+    CPPUNIT_ASSERT_MESSAGE("Filling stops early",
+                           limited->GetNumberOfFilledPixels() < unlimited->GetNumberOfFilledPixels());
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkScanlineFloodFillImageFilter)
@@ -29,6 +29,7 @@ QmitkBinaryThresholdToolGUI::QmitkBinaryThresholdToolGUI()
   : QmitkToolGUI(),
     m_Slider(nullptr),
     m_Spinner(nullptr),
+    m_LazyPreviewCheckBox(nullptr),
     m_isFloat(false),
     m_RangeMin(0),
     m_RangeMax(0),
@@ -65,6 +66,13 @@ QmitkBinaryThresholdToolGUI::QmitkBinaryThresholdToolGUI()
 
   mainLayout->addLayout(layout);
 
+  m_LazyPreviewCheckBox = new QCheckBox("Preview visible slices only", this);
+  m_LazyPreviewCheckBox->setToolTip("Evaluate the threshold only for the displayed slices. The whole image is "
+                                    "thresholded once the segmentation is confirmed.");
+  m_LazyPreviewCheckBox->setFont(f);
+  connect(m_LazyPreviewCheckBox, SIGNAL(toggled(bool)), this, SLOT(OnLazyPreviewToggled(bool)));
+  mainLayout->addWidget(m_LazyPreviewCheckBox);
+
   QPushButton *okButton = new QPushButton("Confirm Segmentation", this);
   connect(okButton, SIGNAL(clicked()), this, SLOT(OnAcceptThresholdPreview()));
   okButton->setFont(f);
@@ -106,6 +114,7 @@ void QmitkBinaryThresholdToolGUI::OnNewToolAssociated(mitk::Tool *tool)
         this, &QmitkBinaryThresholdToolGUI::OnThresholdingIntervalBordersChanged);
     m_BinaryThresholdTool->ThresholdingValueChanged += mitk::MessageDelegate1<QmitkBinaryThresholdToolGUI, double>(
       this, &QmitkBinaryThresholdToolGUI::OnThresholdingValueChanged);
+    m_BinaryThresholdTool->SetLazyPreview(m_LazyPreviewCheckBox->isChecked());
   }
 }
 
@@ -214,3 +223,11 @@ int QmitkBinaryThresholdToolGUI::DoubleToSliderInt(double val)
     return intVal;
   }
 }
+
+void QmitkBinaryThresholdToolGUI::OnLazyPreviewToggled(bool lazyPreview)
+{
+  if (m_BinaryThresholdTool.IsNotNull())
+  {
+    m_BinaryThresholdTool->SetLazyPreview(lazyPreview);
+  }
+}
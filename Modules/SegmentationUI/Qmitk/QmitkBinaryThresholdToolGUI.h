@@ -21,6 +21,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkBinaryThresholdTool.h"
 #include <MitkSegmentationUIExports.h>
 
+#include <QCheckBox>
 #include <QDoubleSpinBox>
 
 class QSlider;
@@ -69,6 +70,9 @@ protected slots:
   /// \brief Called when Slider value has changed. Consider: Slider contains INT values
   void OnSliderValueChanged(int value);
 
+  /// \brief Called when the lazy preview check box has been toggled
+  void OnLazyPreviewToggled(bool lazyPreview);
+
 protected:
   QmitkBinaryThresholdToolGUI();
   virtual ~QmitkBinaryThresholdToolGUI();
@@ -81,6 +85,7 @@ protected:
 
   QSlider *m_Slider;
   QDoubleSpinBox *m_Spinner;
+  QCheckBox *m_LazyPreviewCheckBox;
 
   /// \brief is image float or int?
   bool m_isFloat;
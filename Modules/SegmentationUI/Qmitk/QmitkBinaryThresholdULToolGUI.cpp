@@ -44,6 +44,13 @@ QmitkBinaryThresholdULToolGUI::QmitkBinaryThresholdULToolGUI() : QmitkToolGUI()
   mainLayout->addLayout(layout);
   m_DoubleThresholdSlider->setSingleStep(0.01);
 
+  m_LazyPreviewCheckBox = new QCheckBox("Preview visible slices only", this);
+  m_LazyPreviewCheckBox->setToolTip("Evaluate the thresholds only for the displayed slices. The whole image is "
+                                    "thresholded once the segmentation is confirmed.");
+  m_LazyPreviewCheckBox->setFont(f);
+  connect(m_LazyPreviewCheckBox, SIGNAL(toggled(bool)), this, SLOT(OnLazyPreviewToggled(bool)));
+  mainLayout->addWidget(m_LazyPreviewCheckBox);
+
   QPushButton *okButton = new QPushButton("Confirm Segmentation", this);
   connect(okButton, SIGNAL(clicked()), this, SLOT(OnAcceptThresholdPreview()));
   okButton->setFont(f);
@@ -88,6 +95,7 @@ void QmitkBinaryThresholdULToolGUI::OnNewToolAssociated(mitk::Tool *tool)
     m_BinaryThresholdULTool->ThresholdingValuesChanged +=
       mitk::MessageDelegate2<QmitkBinaryThresholdULToolGUI, mitk::ScalarType, mitk::ScalarType>(
         this, &QmitkBinaryThresholdULToolGUI::OnThresholdingValuesChanged);
+    m_BinaryThresholdULTool->SetLazyPreview(m_LazyPreviewCheckBox->isChecked());
   }
 }
 
@@ -140,3 +148,11 @@ void QmitkBinaryThresholdULToolGUI::OnThresholdsChanged(double min, double max)
 {
   m_BinaryThresholdULTool->SetThresholdValues(min, max);
 }
+
+void QmitkBinaryThresholdULToolGUI::OnLazyPreviewToggled(bool lazyPreview)
+{
+  if (m_BinaryThresholdULTool.IsNotNull())
+  {
+    m_BinaryThresholdULTool->SetLazyPreview(lazyPreview);
+  }
+}
@@ -22,6 +22,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkBinaryThresholdULTool.h"
 #include <MitkSegmentationUIExports.h>
 
+#include <QCheckBox>
+
 /**
   \ingroup org_mitk_gui_qt_interactivesegmentation_internal
   \brief GUI for mitk::BinaryThresholdTool.
@@ -53,11 +55,14 @@ protected slots:
 
   void OnThresholdsChanged(double min, double max);
 
+  void OnLazyPreviewToggled(bool lazyPreview);
+
 protected:
   QmitkBinaryThresholdULToolGUI();
   virtual ~QmitkBinaryThresholdULToolGUI();
 
   ctkRangeWidget *m_DoubleThresholdSlider;
+  QCheckBox *m_LazyPreviewCheckBox;
 
   mitk::BinaryThresholdULTool::Pointer m_BinaryThresholdULTool;
 };
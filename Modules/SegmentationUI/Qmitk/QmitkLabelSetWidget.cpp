@@ -324,7 +324,7 @@ void QmitkLabelSetWidget::OnEraseLabel(bool /*value*/)
   if (answerButton == QMessageBox::Yes)
   {
     this->WaitCursorOn();
-    GetWorkingImage()->EraseLabel(pixelValue);
+    GetWorkingImage()->EraseLabel(pixelValue, GetWorkingImage()->GetActiveLayer());
     this->WaitCursorOff();
     mitk::RenderingManager::GetInstance()->RequestUpdateAll();
   }
@@ -344,7 +344,7 @@ void QmitkLabelSetWidget::OnRemoveLabel(bool /*value*/)
   {
     this->WaitCursorOn();
     GetWorkingImage()->GetActiveLabelSet()->RemoveLabel(pixelValue);
-    GetWorkingImage()->EraseLabel(pixelValue);
+    GetWorkingImage()->EraseLabel(pixelValue, GetWorkingImage()->GetActiveLayer());
     this->WaitCursorOff();
   }
 